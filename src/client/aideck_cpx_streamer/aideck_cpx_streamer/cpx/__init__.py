@@ -22,9 +22,11 @@
 # We kindly ask for a citation if you use in academic work.
 #
 
-from .streamer import StreamerClient, StreamerMetadata
+from .streamer import StreamerClient, StreamerDvfs, StreamerMetadata, StreamerProfile
 
 __all__ = [
     'StreamerClient',
-    'StreamerMetadata'
+    'StreamerDvfs',
+    'StreamerMetadata',
+    'StreamerProfile'
 ]
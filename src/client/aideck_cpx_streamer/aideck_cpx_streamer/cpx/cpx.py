@@ -42,6 +42,7 @@ class CPXFunction(IntEnum):
     APP        = 0x05
 
     STREAMER   = 0x06
+    TRACE      = 0x07
 
     TEST       = 0x0E
     BOOTLOADER = 0x0F
@@ -76,10 +77,12 @@ class CPXPacket:
         self.payload = bytes(payload)
 
 class CPXClient:
-    def __init__(self, host: str = None, port: int = 5000, udp_send: bool = True, log_fn=print) -> None:
+    def __init__(self, host: str = None, port: int = 5000, udp_send: bool = True, log_fn=print, transport=None) -> None:
         self.log = log_fn
 
-        if host is not None:
+        if transport is not None:
+            self.transport = transport
+        elif host is not None:
             from .transport import MultiClientTransport
             self.transport = MultiClientTransport(host, port, log_fn=self.log, udp_send=udp_send)
         else:
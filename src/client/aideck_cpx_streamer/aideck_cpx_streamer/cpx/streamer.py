@@ -77,7 +77,8 @@ class TOFMessage(ctypes.LittleEndianStructure):
     _pack_ = 1
     _fields_ = [
         ("resolution", ctypes.c_uint8),
-        ("_padding", ctypes.c_uint8 * 3),
+        ("sequence", ctypes.c_uint8),
+        ("_padding", ctypes.c_uint8 * 2),
         
         ("data", ctypes.c_uint8 * 64),
     ]
@@ -90,10 +91,67 @@ class InferenceStampedMessage(ctypes.LittleEndianStructure):
         ("y", ctypes.c_float),
         ("z", ctypes.c_float),
         ("phi", ctypes.c_float),
+        ("flags", ctypes.c_uint8),
+        ("confidence", ctypes.c_uint8),
+    ]
+
+class StreamerProfile(ctypes.LittleEndianStructure):
+    """Profile of one layer of the onboard network, see network_profile.py"""
+
+    LAYER_NONE = 0xFF
+    N_EVENTS = 8
+
+    _pack_ = 1
+    _fields_ = [
+        # Layer of this record, LAYER_NONE if the network is not profiled
+        ("layer_id", ctypes.c_uint8),
+        ("n_layers", ctypes.c_uint8),
+        ("n_cores", ctypes.c_uint8),
+        ("_padding", ctypes.c_uint8),
+
+        # Inferences profiled so far
+        ("n_runs", ctypes.c_uint32),
+
+        # Static properties of the layer
+        ("macs", ctypes.c_uint32),
+        ("l2_bytes", ctypes.c_uint32),
+        ("l3_bytes", ctypes.c_uint32),
+
+        # Core 0 performance counters [cycles, events]
+        ("cycles", ctypes.c_uint32),
+        ("dma_wait_cycles", ctypes.c_uint32),
+        ("l3_cycles", ctypes.c_uint32),
+        ("events", ctypes.c_uint32 * N_EVENTS),
+        ("events_valid", ctypes.c_uint32),
+    ]
+
+class StreamerDvfs(ctypes.LittleEndianStructure):
+    """Cluster operating point chosen by the DVFS governor, see energy_model.py"""
+
+    MODE_NONE = 0xFF
+    MODE_NAMES = {0: "fixed", 1: "slack", 2: "deadline"}
+
+    _pack_ = 1
+    _fields_ = [
+        # Mode of the governor, MODE_NONE if there is no governor
+        ("mode", ctypes.c_uint8),
+        ("level", ctypes.c_uint8),
+
+        # Operating point [mV, MHz]
+        ("voltage", ctypes.c_uint16),
+        ("freq_fc", ctypes.c_uint16),
+        ("freq_cl", ctypes.c_uint16),
+
+        # Frame period and cluster time of the latest inference [us]
+        ("period", ctypes.c_uint32),
+        ("busy", ctypes.c_uint32),
+
+        # Inferences longer than the period so far
+        ("n_misses", ctypes.c_uint32),
     ]
 
 class StreamerMetadata(ctypes.LittleEndianStructure):
-    METADATA_VERSION = 10
+    METADATA_VERSION = 13
 
     _pack_ = 1
     _fields_ = [
@@ -130,6 +188,12 @@ class StreamerMetadata(ctypes.LittleEndianStructure):
 
         # Latest inference computed onboard by GAP
         ("inference", InferenceStampedMessage),
+
+        # Profile of the onboard network
+        ("profile", StreamerProfile),
+
+        # Cluster operating point
+        ("dvfs", StreamerDvfs),
     ]
 
 class StreamerStats(ctypes.LittleEndianStructure):
@@ -190,15 +254,30 @@ class StreamerClient:
         self.cpx_header = CPXHeader(destination=CPXTarget.GAP, function=CPXFunction.STREAMER)
 
     def receive(self):
+        for buffer_type, buffer in self.receive_buffers():
+            result = self.process_buffer(buffer_type, buffer)
+
+            if result is not None:
+                yield result
+
+    def receive_buffers(self):
+        """Reassemble streamer buffers from CPX packets, yielding (buffer_type, buffer) tuples.
+
+        Each buffer is a freshly allocated bytearray that is filled in place as segments
+        arrive, so that frames can later be decoded from it without further copies.
+        """
         expected_cmd = StreamerCommand.BUFFER_BEGIN
         rx_buffer = None
+        rx_length = None
         buffer_type = None
         remaining_length = None
         expected_checksum = None
 
         for cpx_packet in self.cpx.receive():
             if cpx_packet.header.function != CPXFunction.STREAMER:
-                self.log(f"Function 0x{cpx_packet.header.function:02x}, not a streamer packet ignoring")
+                # Trace packets are handled by a TraceDecoder registered as CPX callback
+                if cpx_packet.header.function != CPXFunction.TRACE:
+                    self.log(f"Function 0x{cpx_packet.header.function:02x}, not a streamer packet ignoring")
                 continue
 
             header = StreamerHeader.from_buffer_copy(cpx_packet.payload)
@@ -211,6 +290,7 @@ class StreamerClient:
                 # self.log(f"Received command 0x{header.command:02x} while expecting 0x{expected_cmd:02x}, resetting")
                 expected_cmd = StreamerCommand.BUFFER_BEGIN
                 rx_buffer = None
+                rx_length = None
                 buffer_type = None
                 remaining_length = None
                 expected_checksum = None
@@ -224,7 +304,8 @@ class StreamerClient:
                 packet_offset += ctypes.sizeof(begin)
 
                 expected_cmd = StreamerCommand.BUFFER_DATA
-                rx_buffer = b''
+                rx_buffer = bytearray(begin.size)
+                rx_length = 0
                 buffer_type = begin.type
                 remaining_length = begin.size
                 expected_checksum = begin.checksum
@@ -237,12 +318,13 @@ class StreamerClient:
                 # Process the payload of both BUFFER_BEGIN and BUFFER_DATA packets
                 # (expected_cmd is changed to BUFFER_DATA above, when processing BUFFER_BEGIN)
                 payload_length = min(packet_length - packet_offset, remaining_length)
-                rx_chunk = cpx_packet.payload[packet_offset:packet_offset + payload_length]
+                rx_chunk = memoryview(cpx_packet.payload)[packet_offset:packet_offset + payload_length]
 
-                rx_buffer += rx_chunk
+                rx_buffer[rx_length:rx_length + payload_length] = rx_chunk
+                rx_length += payload_length
                 remaining_length -= payload_length
                 
-                # self.log(packet_length, packet_offset, len(rx_buffer), remaining_length)
+                # self.log(packet_length, packet_offset, rx_length, remaining_length)
 
                 if remaining_length == 0:
                     if expected_checksum != 0:
@@ -252,10 +334,11 @@ class StreamerClient:
                             expected_cmd = StreamerCommand.BUFFER_BEGIN
                             continue
 
-                    yield self.process_buffer(buffer_type, rx_buffer)
+                    yield buffer_type, rx_buffer
 
                     expected_cmd = StreamerCommand.BUFFER_BEGIN
                     rx_buffer = None
+                    rx_length = None
                     buffer_type = None
                     remaining_length = None
                 else:
@@ -270,15 +353,18 @@ class StreamerClient:
             return frame, tof_frame, metadata
 
     def decode_frame(self, buffer):
+        # The frame is a view on the reassembly buffer, no pixels are copied. The metadata is copied,
+        # since it outlives the frame (e.g. in ros_viewer's metadata_queue) and a view would keep
+        # the whole buffer alive.
         metadata_size = ctypes.sizeof(StreamerMetadata)
         metadata = StreamerMetadata.from_buffer_copy(buffer)
-        buffer = buffer[metadata_size:]
 
         assert metadata.metadata_version == StreamerMetadata.METADATA_VERSION, \
                f"Client supports StreamerMetadata v{StreamerMetadata.METADATA_VERSION} but received v{metadata.metadata_version}"
 
+        frame_size = metadata.frame_height * metadata.frame_width * metadata.frame_bpp
         frame = np \
-            .frombuffer(buffer, dtype=f'<u{metadata.frame_bpp}') \
+            .frombuffer(buffer, dtype=f'<u{metadata.frame_bpp}', count=frame_size // metadata.frame_bpp, offset=metadata_size) \
             .reshape((metadata.frame_height, metadata.frame_width))
 
         tof_resolution = metadata.tof.resolution
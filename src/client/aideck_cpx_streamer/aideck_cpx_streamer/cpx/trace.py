@@ -0,0 +1,198 @@
+#
+# trace.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import ctypes
+from collections import namedtuple
+from enum import IntEnum
+
+from .cpx import CPXFunction, CPXPacket, CPXTarget
+
+# Nominal frequency of the performance counters used to timestamp events [Hz]
+TRACE_COUNTER_FREQ = {
+    CPXTarget.GAP:   246e6,
+    CPXTarget.ESP32: 240e6,
+}
+
+class TraceEventId(IntEnum):
+    SYNC = 0x00
+
+    CPX_TCP_CONNECTION = 0x10
+    CPX_TCP_SEND       = 0x11
+    CPX_TCP_RECEIVE    = 0x12
+    CPX_UDP_SEND       = 0x13
+    CPX_UDP_RECEIVE    = 0x14
+
+    CPX_SPI_IDLE       = 0x20
+    CPX_SPI_TRANSFER   = 0x21
+    CPX_SPI_GAP_RTT    = 0x22
+
+    CLOCK_SYNC_STM32   = 0x30
+    CLOCK_REMOTE_STM32 = 0x31
+    CLOCK_SYNC_NINA    = 0x32
+    CLOCK_REMOTE_NINA  = 0x33
+
+class TraceState(IntEnum):
+    MARKER = 0
+    BEGIN  = 1
+    END    = 2
+
+class TraceEvent(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("event", ctypes.c_uint8),
+        ("state", ctypes.c_uint8),
+        ("context", ctypes.c_uint16),
+        ("perf_counter", ctypes.c_uint32),
+    ]
+
+class TraceStreamHeader(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("core_id", ctypes.c_uint8),
+        ("_padding", ctypes.c_uint8),
+        ("n_events", ctypes.c_uint16),
+        ("sequence", ctypes.c_uint32),
+        ("dropped", ctypes.c_uint32),
+    ]
+
+# An event placed on the host timeline, timestamp is in seconds of the source's SoC clock
+TimelineEvent = namedtuple('TimelineEvent', ['timestamp', 'source', 'core_id', 'event', 'state', 'context'])
+
+# A matched pair of BEGIN/END events
+TimelineInterval = namedtuple('TimelineInterval', ['source', 'event', 'context', 'begin', 'end'])
+
+def event_name(event):
+    try:
+        return TraceEventId(event).name
+    except ValueError:
+        return f"0x{event:02x}"
+
+class _CoreTimeline:
+    def __init__(self, counter_freq):
+        self.counter_freq = counter_freq
+        self.next_sequence = None
+        self.dropped = 0
+
+        self.sync_lo = None
+        self.sync_time = None
+        self.counter_base = 0
+        self.last_counter = 0
+
+    def timestamp(self, event):
+        if event.event == TraceEventId.SYNC:
+            if event.state == TraceState.BEGIN:
+                self.sync_lo = event.context
+            elif event.state == TraceState.END and self.sync_lo is not None:
+                # The performance counter is reset between SYNC BEGIN and END, which carry
+                # the low and high halves of the global timestamp [us]
+                self.sync_time = ((event.context << 16) + self.sync_lo) / 1e6
+                self.sync_lo = None
+                self.counter_base = 0
+                self.last_counter = event.perf_counter
+
+        if self.sync_time is None:
+            return None
+
+        # Unwrap the 32-bit counter, which overflows after ~17s. Events are not strictly ordered
+        # within a core (e.g., when recorded from ISRs), only large backward jumps are overflows.
+        if self.last_counter - event.perf_counter > (1 << 31):
+            self.counter_base += 1 << 32
+        self.last_counter = event.perf_counter
+
+        return self.sync_time + (self.counter_base + event.perf_counter) / self.counter_freq
+
+class TraceDecoder:
+    """Rebuilds timelines from the binary CPX_F_TRACE packets streamed by GAP8 and NINA.
+
+    Events are placed on the timeline of their source chip using the SYNC events recorded
+    periodically by each core. Events recorded before the first SYNC of a core are discarded.
+    BEGIN/END pairs of the same event from the same source are matched into intervals.
+    """
+
+    def __init__(self, counter_freq=None):
+        self.counter_freq = dict(TRACE_COUNTER_FREQ)
+        if counter_freq is not None:
+            self.counter_freq.update(counter_freq)
+
+        self.timelines = {}
+        self.pending = {}
+
+        self.n_events = 0
+        self.n_lost_packets = 0
+        self.n_dropped = 0
+
+    def feed(self, packet: CPXPacket):
+        """Decode a CPX packet, returning the list of new events and the list of completed intervals."""
+        if packet.header.function != CPXFunction.TRACE:
+            return [], []
+
+        source = CPXTarget(packet.header.source)
+        header = TraceStreamHeader.from_buffer_copy(packet.payload)
+        events = (TraceEvent * header.n_events).from_buffer_copy(packet.payload, ctypes.sizeof(header))
+
+        key = (source, header.core_id)
+        timeline = self.timelines.get(key)
+        if timeline is None:
+            timeline = self.timelines[key] = _CoreTimeline(self.counter_freq[source])
+
+        if timeline.next_sequence is not None and header.sequence != timeline.next_sequence:
+            self.n_lost_packets += (header.sequence - timeline.next_sequence) % (1 << 32)
+        timeline.next_sequence = (header.sequence + 1) % (1 << 32)
+
+        self.n_dropped += header.dropped - timeline.dropped
+        timeline.dropped = header.dropped
+
+        new_events = []
+        new_intervals = []
+        for event in events:
+            timestamp = timeline.timestamp(event)
+            if timestamp is None:
+                continue
+
+            new_event = TimelineEvent(timestamp, source, header.core_id, event.event, event.state, event.context)
+            new_events.append(new_event)
+
+            interval = self._match(new_event)
+            if interval is not None:
+                new_intervals.append(interval)
+
+        self.n_events += len(new_events)
+        return new_events, new_intervals
+
+    def _match(self, event):
+        # Events can begin and end on different cores, so intervals are matched only by event
+        key = (event.source, event.event)
+
+        if event.event == TraceEventId.SYNC or event.state == TraceState.MARKER:
+            return None
+
+        if event.state == TraceState.BEGIN:
+            self.pending[key] = event
+            return None
+
+        begin = self.pending.pop(key, None)
+        if begin is None:
+            return None
+
+        return TimelineInterval(event.source, event.event, begin.context, begin.timestamp, event.timestamp)
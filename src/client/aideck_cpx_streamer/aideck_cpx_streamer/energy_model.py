@@ -0,0 +1,249 @@
+#
+# energy_model.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import argparse
+import ctypes
+import sys
+import time
+
+from .cpx.streamer import StreamerDvfs
+
+# Energy estimate of the GAP8 operating points chosen by the DVFS governor, from the operating
+# point, frame period and cluster time that GAP8 streams with each frame when built with DVFS (see
+# dvfs.h). Each domain draws a dynamic power C V^2 f while clocked and a leakage power I V while
+# powered on: the FC is always clocked, the cluster only during the inference, the cores are clock
+# gated while they wait for the next one. The energy of each frame is compared with the same
+# cycles run at the reference operating point, i.e. without governor.
+
+# Nominal GAP8 power at the reference operating point, replace them with measurements of the board
+REFERENCE_VOLTAGE = 1200  # [mV]
+REFERENCE_FREQ_CL = 175  # [MHz]
+REFERENCE_FREQ_FC = 246  # [MHz]
+CLUSTER_DYNAMIC_POWER = 60.0  # 8 cores running the network [mW]
+CLUSTER_LEAKAGE_POWER = 4.0  # [mW]
+FC_DYNAMIC_POWER = 15.0  # [mW]
+FC_LEAKAGE_POWER = 2.0  # SoC domain, L2 included [mW]
+
+TABLE_COLUMNS = [
+    # (key, header, format)
+    ("point", "point", "{}"),
+    ("frames", "frames", "{:d}"),
+    ("share", "% frames", "{:.0%}"),
+    ("busy", "busy us", "{:.0f}"),
+    ("utilization", "% period", "{:.0%}"),
+    ("misses", "misses", "{:d}"),
+    ("energy", "mJ/frame", "{:.3f}"),
+    ("reference", "ref mJ", "{:.3f}"),
+    ("saving", "saving", "{:.0%}"),
+    ("power", "mW", "{:.1f}"),
+]
+
+
+class EnergyModel:
+    def __init__(self, reference_voltage=REFERENCE_VOLTAGE, reference_freq_cl=REFERENCE_FREQ_CL,
+                 reference_freq_fc=REFERENCE_FREQ_FC, cluster_dynamic=CLUSTER_DYNAMIC_POWER,
+                 cluster_leakage=CLUSTER_LEAKAGE_POWER, fc_dynamic=FC_DYNAMIC_POWER,
+                 fc_leakage=FC_LEAKAGE_POWER) -> None:
+        self.reference_voltage = reference_voltage
+        self.reference_freq_cl = reference_freq_cl
+
+        # Switched capacitance [mW / (V^2 MHz)] and leakage current [mA] of each domain
+        v = reference_voltage / 1000
+        self.cluster_capacitance = cluster_dynamic / (v * v * reference_freq_cl)
+        self.cluster_current = cluster_leakage / v
+        self.fc_capacitance = fc_dynamic / (v * v * reference_freq_fc)
+        self.fc_current = fc_leakage / v
+
+    def cluster_power(self, voltage, freq_cl):
+        """Dynamic power of the cluster while it runs an inference [mW]."""
+        v = voltage / 1000
+        return self.cluster_capacitance * v * v * freq_cl
+
+    def idle_power(self, voltage, freq_fc):
+        """Power of the FC and of the clock-gated cluster [mW]."""
+        v = voltage / 1000
+        return self.fc_capacitance * v * v * freq_fc + (self.fc_current + self.cluster_current) * v
+
+    def frame_energy(self, record: StreamerDvfs):
+        """Energy of one frame period at the operating point of the record [mJ]."""
+        return self._energy(record, record.voltage, record.freq_cl, record.busy)
+
+    def reference_energy(self, record: StreamerDvfs):
+        """Energy of the same cycles at the reference operating point [mJ]."""
+        busy = record.busy * record.freq_cl / self.reference_freq_cl
+        return self._energy(record, self.reference_voltage, self.reference_freq_cl, busy)
+
+    def _energy(self, record, voltage, freq_cl, busy):
+        # An inference longer than the period delays the next frame
+        period = max(record.period, busy)
+        return (self.idle_power(voltage, record.freq_fc) * period + self.cluster_power(voltage, freq_cl) * busy) / 1e6
+
+
+def valid(record: StreamerDvfs) -> bool:
+    return record.mode != StreamerDvfs.MODE_NONE and record.period > 0 and record.freq_cl > 0
+
+
+def summarize(records, model: EnergyModel):
+    """One row per operating point, from the slowest, and a total."""
+    points = {}
+    for record in records:
+        if not valid(record):
+            continue
+        points.setdefault((record.freq_cl, record.voltage), []).append(record)
+
+    n_frames = sum(len(group) for group in points.values())
+    rows = []
+    for (freq_cl, voltage), group in sorted(points.items()):
+        rows.append(summary_row(f"{freq_cl}MHz {voltage}mV", group, n_frames, model))
+
+    if rows:
+        rows.append(summary_row("total", [r for group in points.values() for r in group], n_frames, model))
+
+    return rows
+
+
+def summary_row(name, records, n_frames, model: EnergyModel):
+    n = len(records)
+    busy = sum(r.busy for r in records) / n
+    period = sum(r.period for r in records) / n
+    energy = sum(model.frame_energy(r) for r in records) / n
+    reference = sum(model.reference_energy(r) for r in records) / n
+
+    return {
+        "point": name,
+        "frames": n,
+        "share": n / n_frames,
+        "busy": busy,
+        "utilization": busy / period,
+        "misses": sum(1 for r in records if r.busy > r.period),
+        "energy": energy,
+        "reference": reference,
+        "saving": 1 - energy / reference,
+        "power": energy / period * 1e6,
+    }
+
+
+def format_table(rows) -> str:
+    cells = [[header for _, header, _ in TABLE_COLUMNS]]
+    for row in rows:
+        cells.append([fmt.format(row[key]) if row[key] is not None else "-" for key, _, fmt in TABLE_COLUMNS])
+
+    widths = [max(len(line[i]) for line in cells) for i in range(len(TABLE_COLUMNS))]
+    lines = []
+    for line in cells:
+        first = line[0].ljust(widths[0])
+        lines.append("  ".join([first] + [cell.rjust(width) for cell, width in zip(line[1:], widths[1:])]))
+    return "\n".join(lines)
+
+
+def read_records(file):
+    """Read records saved with write_record, stored back to back."""
+    size = ctypes.sizeof(StreamerDvfs)
+    while True:
+        data = file.read(size)
+        if not data:
+            return
+        if len(data) < size:
+            raise ValueError("Truncated DVFS file")
+
+        yield StreamerDvfs.from_buffer_copy(data)
+
+
+def write_record(file, record: StreamerDvfs):
+    file.write(bytes(record))
+
+
+class EnergyEstimator:
+    def __init__(self) -> None:
+        parser = argparse.ArgumentParser(description='Energy estimate of the DVFS operating points streamed by the AI-deck')
+        parser.add_argument("-host", default="aideck.local", metavar="host", help="AI-deck host")
+        parser.add_argument("-port", type=int, default='5000', metavar="port", help="AI-deck port")
+        parser.add_argument("-period", type=float, default=5.0, metavar="period", help="Print the table every period seconds")
+        parser.add_argument("-raw", type=str, default=None, metavar="raw", help="Save the received records to binary file")
+        parser.add_argument("-replay", type=str, default=None, metavar="replay", help="Read the records from binary file instead of connecting")
+        parser.add_argument("-voltage", type=int, default=REFERENCE_VOLTAGE, metavar="voltage", help="Reference voltage [mV]")
+        parser.add_argument("-freq-cl", type=int, default=REFERENCE_FREQ_CL, metavar="freq", help="Reference cluster frequency [MHz]")
+        parser.add_argument("-freq-fc", type=int, default=REFERENCE_FREQ_FC, metavar="freq", help="Reference FC frequency [MHz]")
+        parser.add_argument("-cl-power", type=float, default=CLUSTER_DYNAMIC_POWER, metavar="power", help="Cluster dynamic power at the reference point [mW]")
+        parser.add_argument("-cl-leakage", type=float, default=CLUSTER_LEAKAGE_POWER, metavar="power", help="Cluster leakage power at the reference voltage [mW]")
+        parser.add_argument("-fc-power", type=float, default=FC_DYNAMIC_POWER, metavar="power", help="FC dynamic power at the reference point [mW]")
+        parser.add_argument("-fc-leakage", type=float, default=FC_LEAKAGE_POWER, metavar="power", help="SoC leakage power at the reference voltage [mW]")
+        self.args = parser.parse_args()
+
+        self.model = EnergyModel(
+            self.args.voltage, self.args.freq_cl, self.args.freq_fc,
+            self.args.cl_power, self.args.cl_leakage, self.args.fc_power, self.args.fc_leakage
+        )
+        self.records = []
+
+    def print_table(self):
+        if not self.records:
+            print("No DVFS records received", file=sys.stderr)
+            return
+
+        mode = StreamerDvfs.MODE_NAMES.get(self.records[-1].mode, "unknown")
+        print(f"\n{len(self.records)} frames, {mode} governor, {self.records[-1].n_misses} misses so far")
+        print(format_table(summarize(self.records, self.model)))
+
+    def main(self):
+        if self.args.replay:
+            with open(self.args.replay, "rb") as f:
+                self.records = [record for record in read_records(f) if valid(record)]
+        else:
+            self.receive()
+
+        self.print_table()
+
+    def receive(self):
+        from .cpx import StreamerClient
+
+        client = StreamerClient(host=self.args.host, port=self.args.port, udp_send=False)
+        raw = open(self.args.raw, "wb") if self.args.raw else None
+        last_print = time.time()
+
+        try:
+            for _frame, _tof_frame, metadata in client.receive():
+                if not valid(metadata.dvfs):
+                    continue
+
+                record = StreamerDvfs.from_buffer_copy(metadata.dvfs)
+                self.records.append(record)
+                if raw:
+                    write_record(raw, record)
+
+                if time.time() - last_print > self.args.period:
+                    self.print_table()
+                    last_print = time.time()
+        finally:
+            if raw:
+                raw.close()
+
+
+def main():
+    estimator = EnergyEstimator()
+    estimator.main()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,231 @@
+#
+# frontnet_msg.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import ctypes
+from collections import namedtuple
+from enum import IntEnum
+
+# Messages exchanged with the STM32 Frontnet app over the CRTP app channel, see frontnet_msg.h in
+# the STM32 firmware. Each message fits in a single packet.
+
+APPCHANNEL_MTU = 31
+
+# Set in the type byte to request an acknowledgement
+ACK_REQUEST = 0x80
+TYPE_MASK = 0x7f
+
+# Fixed-point scale of batched inferences [mm, mrad]
+FIXED_SCALE = 1000.0
+
+BATCH_MAX_COUNT = 2
+
+# Flags of an inference, set by the GAP8 inference filter
+INFERENCE_FLAG_FILTERED = 1 << 0  # confidence is valid
+INFERENCE_FLAG_OUTLIER = 1 << 1   # Skipped by the STM32
+
+class MsgType(IntEnum):
+    INFERENCE_STAMPED = 0
+    INFERENCE = 1
+    INFERENCE_BATCH = 2
+    TARGET_CONFIG = 3
+    ACK = 16
+
+class AckStatus(IntEnum):
+    ACCEPTED = 0
+    REJECTED = 1
+
+class AltitudeReference(IntEnum):
+    GROUND = 0
+    SUBJECT = 1
+
+class MsgHeader(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("type", ctypes.c_uint8),
+        ("source", ctypes.c_uint8),
+        ("sequence", ctypes.c_uint16),
+        ("tx_timestamp", ctypes.c_uint32),
+    ]
+
+class InferenceStamped(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("stm32_timestamp", ctypes.c_uint32),
+        ("x", ctypes.c_float),
+        ("y", ctypes.c_float),
+        ("z", ctypes.c_float),
+        ("phi", ctypes.c_float),
+        ("flags", ctypes.c_uint8),
+        ("confidence", ctypes.c_uint8),
+    ]
+
+class BatchEntry(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("dt", ctypes.c_uint8),
+        ("x", ctypes.c_int16),
+        ("y", ctypes.c_int16),
+        ("z", ctypes.c_int16),
+        ("phi", ctypes.c_int16),
+    ]
+
+class BatchHeader(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("count", ctypes.c_uint8),
+        ("base_timestamp", ctypes.c_uint32),
+    ]
+
+class TargetConfigPayload(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("horizontal_distance", ctypes.c_float),
+        ("altitude", ctypes.c_float),
+        ("altitude_reference", ctypes.c_uint8),
+    ]
+
+class AckPayload(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("acked_type", ctypes.c_uint8),
+        ("acked_tx_timestamp", ctypes.c_uint32),
+        ("rx_timestamp", ctypes.c_uint32),
+        ("status", ctypes.c_uint8),
+    ]
+
+# stm32_timestamp [ticks], x, y, z [m], phi [rad], flags (INFERENCE_FLAG_*), confidence (0 to 255). Batches
+# do not carry flags and confidence, which are decoded as 0.
+Inference = namedtuple('Inference', ['stm32_timestamp', 'x', 'y', 'z', 'phi', 'flags', 'confidence'], defaults=[0, 0])
+
+TargetConfig = namedtuple('TargetConfig', ['horizontal_distance', 'altitude', 'altitude_reference'])
+
+# acked_tx_timestamp is the sender's clock [us], rx_timestamp the STM32 clock [ticks]
+Ack = namedtuple('Ack', ['acked_type', 'acked_tx_timestamp', 'rx_timestamp', 'status'])
+
+# payload is a list of Inference, a TargetConfig or an Ack depending on the type. Legacy messages
+# have no header, their source, sequence and tx_timestamp are None.
+Message = namedtuple('Message', ['type', 'ack_request', 'source', 'sequence', 'tx_timestamp', 'payload'])
+
+def _to_fixed16(value):
+    return max(-32768, min(32767, round(value * FIXED_SCALE)))
+
+def _header(type, source, sequence, tx_timestamp, ack_request):
+    return bytes(MsgHeader(type | (ACK_REQUEST if ack_request else 0), source, sequence % (1 << 16), tx_timestamp % (1 << 32)))
+
+def encode_legacy_inference(inference):
+    return bytes([MsgType.INFERENCE_STAMPED]) + bytes(InferenceStamped(*inference))
+
+def encode_inference(source, sequence, tx_timestamp, inference, ack_request=False):
+    return _header(MsgType.INFERENCE, source, sequence, tx_timestamp, ack_request) + bytes(InferenceStamped(*inference))
+
+def encode_inference_batch(source, sequence, tx_timestamp, inferences, ack_request=False):
+    """Encode up to BATCH_MAX_COUNT consecutive inferences, sorted by timestamp and at most 255 ticks apart."""
+    if not 1 <= len(inferences) <= BATCH_MAX_COUNT:
+        raise ValueError(f"Batches must contain between 1 and {BATCH_MAX_COUNT} inferences")
+
+    base = inferences[0].stm32_timestamp
+    entries = []
+    for inference in inferences:
+        dt = (inference.stm32_timestamp - base) % (1 << 32)
+        if not 0 <= dt <= 255:
+            raise ValueError("Batched inferences must be sorted and at most 255 ticks apart")
+        fixed = [_to_fixed16(v) for v in (inference.x, inference.y, inference.z, inference.phi)]
+        entries.append(bytes(BatchEntry(dt, *fixed)))
+
+    return _header(MsgType.INFERENCE_BATCH, source, sequence, tx_timestamp, ack_request) + \
+        bytes(BatchHeader(len(inferences), base)) + b''.join(entries)
+
+def encode_target_config(source, sequence, tx_timestamp, target, ack_request=False):
+    return _header(MsgType.TARGET_CONFIG, source, sequence, tx_timestamp, ack_request) + bytes(TargetConfigPayload(*target))
+
+def encode_ack(source, sequence, tx_timestamp, ack):
+    return _header(MsgType.ACK, source, sequence, tx_timestamp, False) + bytes(AckPayload(*ack))
+
+def _payload_size(type, payload):
+    if type == MsgType.INFERENCE:
+        return ctypes.sizeof(InferenceStamped)
+    elif type == MsgType.INFERENCE_BATCH:
+        count = payload[0] if len(payload) > 0 else 0
+        if not 1 <= count <= BATCH_MAX_COUNT:
+            return None
+        return ctypes.sizeof(BatchHeader) + count * ctypes.sizeof(BatchEntry)
+    elif type == MsgType.TARGET_CONFIG:
+        return ctypes.sizeof(TargetConfigPayload)
+    elif type == MsgType.ACK:
+        return ctypes.sizeof(AckPayload)
+    else:
+        return None
+
+def decode(packet: bytes):
+    """Decode a message, raising ValueError if it is malformed. Same checks as frontnetMsgValidate."""
+    if len(packet) == 0:
+        raise ValueError("Empty message")
+
+    if packet[0] == MsgType.INFERENCE_STAMPED:
+        if len(packet) != 1 + ctypes.sizeof(InferenceStamped):
+            raise ValueError("Invalid legacy inference size")
+        inference = InferenceStamped.from_buffer_copy(packet, 1)
+        return Message(MsgType.INFERENCE_STAMPED, False, None, None, None, [_inference(inference)])
+
+    header_size = ctypes.sizeof(MsgHeader)
+    if len(packet) < header_size:
+        raise ValueError("Truncated header")
+
+    header = MsgHeader.from_buffer_copy(packet)
+    payload = packet[header_size:]
+
+    try:
+        type = MsgType(header.type & TYPE_MASK)
+    except ValueError:
+        raise ValueError(f"Unknown message type {header.type & TYPE_MASK}")
+
+    if _payload_size(type, payload) != len(payload):
+        raise ValueError(f"Invalid {type.name} size")
+
+    if type == MsgType.INFERENCE:
+        decoded = [_inference(InferenceStamped.from_buffer_copy(payload))]
+    elif type == MsgType.INFERENCE_BATCH:
+        batch = BatchHeader.from_buffer_copy(payload)
+        entries = (BatchEntry * batch.count).from_buffer_copy(payload, ctypes.sizeof(batch))
+        decoded = [
+            Inference((batch.base_timestamp + e.dt) % (1 << 32), e.x / FIXED_SCALE, e.y / FIXED_SCALE, e.z / FIXED_SCALE, e.phi / FIXED_SCALE)
+            for e in entries
+        ]
+    elif type == MsgType.TARGET_CONFIG:
+        target = TargetConfigPayload.from_buffer_copy(payload)
+        decoded = TargetConfig(target.horizontal_distance, target.altitude, target.altitude_reference)
+    else:
+        ack = AckPayload.from_buffer_copy(payload)
+        decoded = Ack(ack.acked_type, ack.acked_tx_timestamp, ack.rx_timestamp, ack.status)
+
+    return Message(type, bool(header.type & ACK_REQUEST), header.source, header.sequence, header.tx_timestamp, decoded)
+
+def _inference(inference):
+    return Inference(inference.stm32_timestamp, inference.x, inference.y, inference.z, inference.phi, inference.flags, inference.confidence)
+
+def round_trip_time(message, rx_timestamp, tick_period=1e-3):
+    """Round-trip time [us] of an acknowledged message, given the host time when the ack was received [us].
+    The time spent on the STM32 between receiving the message and sending the ack is subtracted."""
+    stm32_time = ((message.tx_timestamp - message.payload.rx_timestamp) % (1 << 32)) * tick_period * 1e6
+    return ((rx_timestamp - message.payload.acked_tx_timestamp) % (1 << 32)) - stm32_time
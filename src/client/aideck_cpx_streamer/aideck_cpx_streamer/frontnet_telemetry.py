@@ -0,0 +1,191 @@
+#
+# frontnet_telemetry.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import argparse
+import ctypes
+import struct
+import sys
+import time
+from enum import IntEnum
+
+from .frontnet_msg import MsgType
+
+# Decoder for the binary telemetry records sent by the STM32 Frontnet app over the CRTP
+# app channel, see frontnet_telemetry.h in the STM32 firmware.
+
+class TelemetryType(IntEnum):
+    INFERENCE = 0
+
+class TelemetryInference(ctypes.LittleEndianStructure):
+    _pack_ = 1
+    _fields_ = [
+        ("state_timestamp", ctypes.c_uint32),
+        ("inference_timestamp", ctypes.c_uint32),
+        ("x", ctypes.c_int16),
+        ("y", ctypes.c_int16),
+        ("z", ctypes.c_int16),
+        ("phi", ctypes.c_int16),
+        ("vx", ctypes.c_int16),
+        ("vy", ctypes.c_int16),
+        ("vz", ctypes.c_int16),
+        ("vphi", ctypes.c_int16),
+        ("control_enabled", ctypes.c_uint8),
+        ("control_mode", ctypes.c_uint8),
+        ("setpoint_priority", ctypes.c_uint8),
+    ]
+
+# Fixed-point scale of the pose and velocity fields [mm, mrad, mm/s, mrad/s]
+FIXED_SCALE = 1000.0
+
+# Same columns as the CSV lines printed on the console by older firmware versions
+INFERENCE_CSV_COLUMNS = [
+    "state_stm32_timestamp", "inference_stm32_timestamp",
+    "kf_x", "kf_y", "kf_z", "kf_phi", "kf_vx", "kf_vy", "kf_vz", "kf_vphi",
+    "ctrl_enabled", "ctrl_mode", "setpoint_priority",
+]
+
+_FIXED_FIELDS = ["x", "y", "z", "phi", "vx", "vy", "vz", "vphi"]
+
+def decode_inference(record: TelemetryInference):
+    """Convert an inference record to a row with the columns in INFERENCE_CSV_COLUMNS."""
+    return [record.state_timestamp, record.inference_timestamp] + \
+        [getattr(record, f) / FIXED_SCALE for f in _FIXED_FIELDS] + \
+        [record.control_enabled, record.control_mode, record.setpoint_priority]
+
+def encode_inference(row):
+    """Inverse of decode_inference, returns a complete packet. Used for tests and replays."""
+    fixed = [max(-32768, min(32767, round(v * FIXED_SCALE))) for v in row[2:10]]
+    record = TelemetryInference(row[0], row[1], *fixed, *row[10:13])
+    return bytes([TelemetryType.INFERENCE]) + bytes(record)
+
+class TelemetryDecoder:
+    """Decode telemetry packets, counting the malformed or unknown ones."""
+
+    def __init__(self) -> None:
+        self.n_records = 0
+        self.n_invalid = 0
+
+    def decode(self, packet: bytes):
+        """Return (type, row) for a valid packet, None otherwise."""
+        if len(packet) >= 1 and packet[0] == TelemetryType.INFERENCE and len(packet) == 1 + ctypes.sizeof(TelemetryInference):
+            record = TelemetryInference.from_buffer_copy(packet, 1)
+            self.n_records += 1
+            return TelemetryType.INFERENCE, decode_inference(record)
+
+        self.n_invalid += 1
+        return None
+
+def read_packets(file):
+    """Read packets saved with write_packet, each prefixed by its length in one byte."""
+    while True:
+        header = file.read(1)
+        if not header:
+            return
+
+        packet = file.read(header[0])
+        if len(packet) < header[0]:
+            raise ValueError("Truncated telemetry file")
+
+        yield packet
+
+def write_packet(file, packet: bytes):
+    file.write(struct.pack("<B", len(packet)) + packet)
+
+def format_row(row):
+    values = [str(row[0]), str(row[1])]
+    values += [f"{v:.3f}" for v in row[2:10]]
+    values += [str(v) for v in row[10:]]
+    return ",".join(values)
+
+class TelemetryLogger:
+    def __init__(self) -> None:
+        parser = argparse.ArgumentParser(description='Receive the binary telemetry of the STM32 Frontnet app')
+        parser.add_argument("-uri", default="radio://0/80/2M/E7E7E7E7E7", metavar="uri", help="Crazyflie URI")
+        parser.add_argument("-save", type=str, default=None, metavar="save", help="Save decoded records to CSV file (default: stdout)")
+        parser.add_argument("-raw", type=str, default=None, metavar="raw", help="Save raw packets to binary file")
+        parser.add_argument("-replay", type=str, default=None, metavar="replay", help="Decode raw packets from binary file instead of connecting")
+        self.args = parser.parse_args()
+
+        self.decoder = TelemetryDecoder()
+        self.output = None
+        self.raw = None
+
+    def write_header(self):
+        self.output.write(",".join(INFERENCE_CSV_COLUMNS) + "\n")
+
+    def on_packet(self, packet):
+        # Acks to the messages sent by other clients are received on the same channel
+        if len(packet) > 0 and packet[0] == MsgType.ACK:
+            return
+
+        if self.raw:
+            write_packet(self.raw, bytes(packet))
+
+        decoded = self.decoder.decode(bytes(packet))
+        if decoded is not None:
+            self.output.write(format_row(decoded[1]) + "\n")
+
+    def main(self):
+        self.output = open(self.args.save, "w") if self.args.save else sys.stdout
+        self.write_header()
+
+        try:
+            if self.args.replay:
+                with open(self.args.replay, "rb") as f:
+                    for packet in read_packets(f):
+                        self.on_packet(packet)
+            else:
+                self.receive()
+        finally:
+            if self.args.save:
+                self.output.close()
+            print(f"records: {self.decoder.n_records}, invalid packets: {self.decoder.n_invalid}", file=sys.stderr)
+
+    def receive(self):
+        # cflib is only required when connecting to a Crazyflie
+        import cflib.crtp
+        from cflib.crazyflie import Crazyflie
+        from cflib.crazyflie.syncCrazyflie import SyncCrazyflie
+
+        self.raw = open(self.args.raw, "wb") if self.args.raw else None
+
+        cflib.crtp.init_drivers()
+        cf = Crazyflie(rw_cache="./cache")
+        try:
+            with SyncCrazyflie(self.args.uri, cf=cf) as scf:
+                scf.cf.appchannel.packet_received.add_callback(self.on_packet)
+                while True:
+                    time.sleep(1.0)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            if self.raw:
+                self.raw.close()
+
+def main():
+    logger = TelemetryLogger()
+    logger.main()
+
+if __name__ == "__main__":
+    main()
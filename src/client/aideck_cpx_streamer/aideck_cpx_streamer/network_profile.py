@@ -0,0 +1,249 @@
+#
+# network_profile.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import argparse
+import ctypes
+import sys
+import time
+
+from .cpx.streamer import StreamerProfile
+
+# Roofline tables of the onboard network, from the per-layer profile that GAP8 streams with each
+# frame when built with NETWORK_PROFILE (see network.h in the network directory). Each frame
+# carries one layer, the layers are collected in turn.
+
+# Same order as network_profile_event_e
+EVENT_NAMES = [
+    "active_cycles", "instr", "ld_stall", "jr_stall", "imiss", "ld_ext_cyc", "st_ext_cyc", "tcdm_cont",
+]
+EVENT = {name: i for i, name in enumerate(EVENT_NAMES)}
+
+# GAP8 cluster: each core computes 4 8-bit MACs per cycle with the SIMD dot product, the cluster
+# DMA moves 8 bytes per cycle between L2 and L1
+PEAK_MACS_PER_CORE = 4.0  # [MAC/cycle]
+L2_BANDWIDTH = 8.0  # [B/cycle]
+
+TABLE_COLUMNS = [
+    # (key, header, format)
+    ("layer", "layer", "{}"),
+    ("macs", "MACs", "{:d}"),
+    ("cycles", "cycles", "{:d}"),
+    ("mac_per_cycle", "MAC/cyc", "{:.2f}"),
+    ("intensity", "MAC/B", "{:.1f}"),
+    ("attainable", "roof", "{:.2f}"),
+    ("efficiency", "% roof", "{:.0%}"),
+    ("bound", "bound", "{}"),
+    ("dma_wait", "DMA wait", "{:.0%}"),
+    ("l3_cycles", "L3 cyc", "{:d}"),
+    ("l3_bandwidth", "L3 B/cyc", "{:.2f}"),
+    ("ipc", "IPC", "{:.2f}"),
+    ("ld_stall", "ld stall", "{:.0%}"),
+    ("imiss", "imiss", "{:.0%}"),
+    ("tcdm_cont", "TCDM cont", "{:.0%}"),
+]
+
+
+def event(record: StreamerProfile, name: str):
+    """Value of an event, None if it has not been sampled yet."""
+    index = EVENT[name]
+    if record.events_valid & (1 << index):
+        return record.events[index]
+    return None
+
+
+def ratio(num, den):
+    if num is None or den is None or den == 0:
+        return None
+    return num / den
+
+
+class ProfileCollector:
+    """Keep the latest record of each layer received with the frame metadata."""
+
+    def __init__(self) -> None:
+        self.layers = {}
+        self.n_layers = 0
+        self.n_runs = 0
+        self.n_records = 0
+
+    def feed(self, profile: StreamerProfile) -> bool:
+        """Store a record, returns False if the network is not profiled."""
+        if profile.layer_id == StreamerProfile.LAYER_NONE or profile.layer_id >= profile.n_layers:
+            return False
+
+        # The network changed, e.g. after a firmware update
+        if profile.n_layers != self.n_layers:
+            self.layers = {}
+            self.n_layers = profile.n_layers
+
+        self.layers[profile.layer_id] = StreamerProfile.from_buffer_copy(profile)
+        self.n_runs = max(self.n_runs, profile.n_runs)
+        self.n_records += 1
+        return True
+
+    def complete(self) -> bool:
+        return self.n_layers > 0 and len(self.layers) == self.n_layers
+
+    def records(self):
+        return [self.layers[i] for i in sorted(self.layers)]
+
+
+def roofline(records, peak_macs_per_core=PEAK_MACS_PER_CORE, l2_bandwidth=L2_BANDWIDTH):
+    """One row per layer and a total, the roofline uses the L2-L1 traffic of each layer."""
+    rows = []
+    for record in records:
+        rows.append(roofline_row(f"layer{record.layer_id}", record, peak_macs_per_core, l2_bandwidth))
+
+    if rows:
+        total = StreamerProfile(n_cores=records[0].n_cores, events_valid=(1 << len(EVENT_NAMES)) - 1)
+        for record in records:
+            for field in ["macs", "l2_bytes", "l3_bytes", "cycles", "dma_wait_cycles", "l3_cycles"]:
+                setattr(total, field, getattr(total, field) + getattr(record, field))
+            for i in range(len(EVENT_NAMES)):
+                total.events[i] += record.events[i]
+            total.events_valid &= record.events_valid
+        rows.append(roofline_row("total", total, peak_macs_per_core, l2_bandwidth))
+
+    return rows
+
+
+def roofline_row(name, record: StreamerProfile, peak_macs_per_core, l2_bandwidth):
+    peak = peak_macs_per_core * max(record.n_cores, 1)
+    intensity = ratio(record.macs, record.l2_bytes)
+    memory_roof = intensity * l2_bandwidth if intensity is not None else None
+    attainable = min(peak, memory_roof) if memory_roof is not None else peak
+    mac_per_cycle = ratio(record.macs, record.cycles)
+    active_cycles = event(record, "active_cycles")
+
+    return {
+        "layer": name,
+        "macs": record.macs,
+        "cycles": record.cycles,
+        "mac_per_cycle": mac_per_cycle,
+        "intensity": intensity,
+        "attainable": attainable,
+        "efficiency": ratio(mac_per_cycle, attainable) if record.macs > 0 else None,
+        "bound": ("memory" if memory_roof < peak else "compute") if memory_roof is not None and record.macs > 0 else "-",
+        "dma_wait": ratio(record.dma_wait_cycles, record.cycles),
+        "l3_cycles": record.l3_cycles,
+        "l3_bandwidth": ratio(record.l3_bytes, record.l3_cycles),
+        "ipc": ratio(event(record, "instr"), active_cycles),
+        "ld_stall": ratio(event(record, "ld_stall"), active_cycles),
+        "imiss": ratio(event(record, "imiss"), active_cycles),
+        "tcdm_cont": ratio(event(record, "tcdm_cont"), active_cycles),
+    }
+
+
+def format_table(rows) -> str:
+    cells = [[header for _, header, _ in TABLE_COLUMNS]]
+    for row in rows:
+        cells.append([fmt.format(row[key]) if row[key] is not None else "-" for key, _, fmt in TABLE_COLUMNS])
+
+    widths = [max(len(line[i]) for line in cells) for i in range(len(TABLE_COLUMNS))]
+    lines = []
+    for line in cells:
+        first = line[0].ljust(widths[0])
+        lines.append("  ".join([first] + [cell.rjust(width) for cell, width in zip(line[1:], widths[1:])]))
+    return "\n".join(lines)
+
+
+def read_records(file):
+    """Read records saved with write_record, stored back to back."""
+    size = ctypes.sizeof(StreamerProfile)
+    while True:
+        data = file.read(size)
+        if not data:
+            return
+        if len(data) < size:
+            raise ValueError("Truncated profile file")
+
+        yield StreamerProfile.from_buffer_copy(data)
+
+
+def write_record(file, record: StreamerProfile):
+    file.write(bytes(record))
+
+
+class NetworkProfiler:
+    def __init__(self) -> None:
+        parser = argparse.ArgumentParser(description='Roofline tables of the network profile streamed by the AI-deck')
+        parser.add_argument("-host", default="aideck.local", metavar="host", help="AI-deck host")
+        parser.add_argument("-port", type=int, default='5000', metavar="port", help="AI-deck port")
+        parser.add_argument("-period", type=float, default=5.0, metavar="period", help="Print the table every period seconds")
+        parser.add_argument("-raw", type=str, default=None, metavar="raw", help="Save the received records to binary file")
+        parser.add_argument("-replay", type=str, default=None, metavar="replay", help="Read the records from binary file instead of connecting")
+        parser.add_argument("-peak", type=float, default=PEAK_MACS_PER_CORE, metavar="peak", help="Peak MAC/cycle of each core")
+        parser.add_argument("-bandwidth", type=float, default=L2_BANDWIDTH, metavar="bandwidth", help="L2-L1 bandwidth [B/cycle]")
+        self.args = parser.parse_args()
+
+        self.collector = ProfileCollector()
+
+    def print_table(self):
+        if not self.collector.complete():
+            print(f"{len(self.collector.layers)}/{self.collector.n_layers} layers received", file=sys.stderr)
+            return
+
+        print(f"\n{self.collector.n_runs} runs profiled")
+        print(format_table(roofline(self.collector.records(), self.args.peak, self.args.bandwidth)))
+
+    def main(self):
+        if self.args.replay:
+            with open(self.args.replay, "rb") as f:
+                for record in read_records(f):
+                    self.collector.feed(record)
+        else:
+            self.receive()
+
+        self.print_table()
+
+    def receive(self):
+        from .cpx import StreamerClient
+
+        client = StreamerClient(host=self.args.host, port=self.args.port, udp_send=False)
+        raw = open(self.args.raw, "wb") if self.args.raw else None
+        last_print = time.time()
+
+        try:
+            for _frame, _tof_frame, metadata in client.receive():
+                if not self.collector.feed(metadata.profile):
+                    continue
+
+                if raw:
+                    write_record(raw, metadata.profile)
+
+                if time.time() - last_print > self.args.period:
+                    self.print_table()
+                    last_print = time.time()
+        finally:
+            if raw:
+                raw.close()
+
+
+def main():
+    profiler = NetworkProfiler()
+    profiler.main()
+
+
+if __name__ == "__main__":
+    main()
@@ -30,6 +30,7 @@ import numpy as np
 import cv2
 
 from .cpx import StreamerClient, StreamerMetadata
+from .trace_viewer import TraceWriter
 from .utils import create_dataset_dir, FrameSaver
 
 class PltViewer:
@@ -40,10 +41,16 @@ class PltViewer:
         parser.add_argument("-port", type=int, default='5000', metavar="port", help="AI-deck port")
         parser.add_argument("--no-udp-send", action='store_false', dest='udp_send', help="Do not send replies over UDP")
         parser.add_argument("-save", type=str, default=None, metavar="save", help="Save images to output directory")
+        parser.add_argument("-trace", type=str, default=None, metavar="trace", help="Save streamed event traces to CSV file")
         args = parser.parse_args()
 
         self.client = StreamerClient(host=args.host, port=args.port, udp_send=args.udp_send)
 
+        self.trace_writer = None
+        if args.trace is not None:
+            self.trace_writer = TraceWriter(args.trace)
+            self.client.cpx.add_callback(self.trace_writer.feed)
+
         save_dir = args.save
         self.frame_saver = None
         if save_dir is not None:
@@ -78,6 +85,8 @@ class PltViewer:
         finally:
             if self.frame_saver:
                 self.frame_saver.close()
+            if self.trace_writer:
+                self.trace_writer.close()
     
     def display(self, frame: np.ndarray, tof_frame: np.ndarray, metadata: StreamerMetadata):
         frame = cv2.cvtColor(frame, cv2.COLOR_GRAY2RGB) / 255
@@ -24,42 +24,48 @@
 # We kindly ask for a citation if you use in academic work.
 #
 
-# Workaround: import cv2 before cv_bridge to fix exception on arm64
-# Source: https://github.com/ros-perception/vision_opencv/issues/339#issuecomment-831763376
-import cv2
-
+import numpy as np
 import rclpy
 from rclpy.node import Node
 from rclpy.time import Time
 from collections import deque
-from cv_bridge import CvBridge
+from diagnostic_msgs.msg import DiagnosticArray, DiagnosticStatus, KeyValue
 from geometry_msgs.msg import AccelWithCovarianceStamped
 from nav_msgs.msg import Odometry
 from sensor_msgs.msg import Image
-from threading import Thread
+from threading import Lock, Thread
 
 from .cpx import StreamerClient
 from .utils import create_dataset_dir, FrameSaver, InferenceSaver
+from .utils.frame_clock import FrameClock
+from .utils.pipeline import PipelineStage
 from .utils.quatcompress import quatdecompress
 from .utils.ros import msg_to_array, array_to_msg
 from .utils.thread_pool import ThreadPool
 
 from aideck_cpx_msgs.msg import CPXPacket, ImageMetadata, Inference
 
+IMAGE_ENCODINGS = {
+    1: 'mono8',
+    2: 'mono16',
+}
+
 class ROSViewer(Node):
-    def __init__(self) -> None:
+    def __init__(self, client=None) -> None:
         super().__init__('ros_viewer')
 
         host = self.declare_parameter('host', rclpy.Parameter.Type.STRING).value
         port = self.declare_parameter('port', 5000).value
         save_dir = self.declare_parameter('save_dir', '').value
+        queue_size = self.declare_parameter('queue_size', 2).value
 
-        self.client = StreamerClient(host=host, port=port, udp_send=False, log_fn=self.log)
+        if client is None:
+            client = StreamerClient(host=host, port=port, udp_send=False, log_fn=self.log)
+        self.client = client
         # self.client.cpx.add_callback(self.cpx_callback)
 
         self.cpx_pub = self.create_publisher(CPXPacket, "cpx", 100)
 
-        self.bridge = CvBridge()
         self.image_pub = self.create_publisher(Image, "image_raw", 1)
         self.metadata_pub = self.create_publisher(ImageMetadata, "image_metadata", 1)
         self.odom_pub = self.create_publisher(Odometry, "image_odom", 1)
@@ -70,16 +76,38 @@ class ROSViewer(Node):
         self.inference_pub = self.create_publisher(Inference, "inference_onboard", 1)
         self.inference_sub = self.create_subscription(Inference, "inference", self.inference_callback, 1)
 
+        self.diagnostics_pub = self.create_publisher(DiagnosticArray, "diagnostics", 1)
+        self.diagnostics_timer = self.create_timer(1.0, self.publish_diagnostics)
+
+        # Accessed both by the match stage and by inference_callback on the executor thread
+        self.metadata_lock = Lock()
         self.metadata_queue = deque(maxlen=1000)
 
+        # Maps the frame timestamps to the host clock, used only by the decode stage
+        self.frame_clock = FrameClock()
+        self.latency_lock = Lock()
+        self.latencies = []
+
         self.pool = ThreadPool(n_workers=1)
 
-        self.save = save_dir is not None
+        self.save = bool(save_dir)
         if self.save:
             dataset_dir = create_dataset_dir(save_dir)
             self.frame_saver = FrameSaver(dataset_dir)
             self.inference_saver = InferenceSaver(dataset_dir)
 
+        # Frames flow through a pipeline of stages, each running on its own thread and connected 
+        # by bounded queues: receive (self.thread) -> decode -> match -> publish [-> save].
+        # When a stage falls behind, the oldest queued frames are dropped instead of letting 
+        # the publication latency grow.
+        self.save_stage = None
+        if self.save:
+            self.save_stage = PipelineStage(self.save_frame, queue_size=30, name='save')
+        self.publish_stage = PipelineStage(self.publish_frame, queue_size=queue_size, name='publish')
+        self.match_stage = PipelineStage(self.match_frame, next_stage=self.publish_stage, queue_size=queue_size, name='match')
+        self.decode_stage = PipelineStage(self.decode_frame, next_stage=self.match_stage, queue_size=queue_size, name='decode')
+        self.stages = [stage for stage in [self.decode_stage, self.match_stage, self.publish_stage, self.save_stage] if stage]
+
         self.thread = Thread(target=self.main, daemon=True)
         self.thread.start()
 
@@ -90,49 +118,120 @@ class ROSViewer(Node):
             self.frame_saver.open()
             self.inference_saver.open()
 
-        for seq, (frame, tof_frame, metadata) in enumerate(self.client.receive()):
-            now = self.get_clock().now().to_msg()
+        for stage in self.stages:
+            stage.start()
+
+        for buffer_type, buffer in self.client.receive_buffers():
+            now = self.get_clock().now()
+            self.decode_stage.put((now, buffer_type, buffer))
+
+        for stage in self.stages:
+            stage.shutdown()
+
+        if self.save:
+            self.frame_saver.close()
+            self.inference_saver.close()
+
+    def decode_frame(self, item):
+        now, buffer_type, buffer = item
+
+        result = self.client.process_buffer(buffer_type, buffer)
+        if result is None:
+            return None
 
-            self.push_metadata(now, metadata)
+        frame, tof_frame, metadata = result
+        frame_time = self.frame_clock.update(metadata.frame_timestamp, now.nanoseconds / 10**9)
+        return now, frame_time, frame, tof_frame, metadata
 
-            msg = self.bridge.cv2_to_imgmsg(frame)
-            msg.header.stamp = now
-            self.image_pub.publish(msg)
+    def match_frame(self, item):
+        now, frame_time, frame, tof_frame, metadata = item
+        stamp = now.to_msg()
 
-            if tof_frame is not None:
-                msg = self.bridge.cv2_to_imgmsg(tof_frame)
-                msg.header.stamp = now
-                self.tof_pub.publish(msg)
-            
-            msg = self.metadata_to_msg(metadata)
-            msg.header.stamp = now
-            self.metadata_pub.publish(msg)
+        self.push_metadata(stamp, metadata)
 
-            msg = self.state_to_odom(metadata.state)
-            msg.header.stamp = now
-            self.odom_pub.publish(msg)
+        inference_stamp = None
+        inference_timestamp = metadata.inference.stm32_timestamp
+        if inference_timestamp != 0:
+            self.pool.try_run(self.send_reply, metadata, None)
 
-            msg = self.state_to_accel(metadata.state)
-            msg.header.stamp = now
-            self.accel_pub.publish(msg)
+            inference_stamp, _ = self.pop_metadata(stm32_timestamp=inference_timestamp)
 
-            inference_timestamp = metadata.inference.stm32_timestamp
-            if inference_timestamp != 0:
-                self.pool.try_run(self.send_reply, metadata, None)
+        return now, frame_time, frame, tof_frame, metadata, inference_stamp
 
-                stamp, _ = self.pop_metadata(stm32_timestamp=inference_timestamp)
+    def publish_frame(self, item):
+        now, frame_time, frame, tof_frame, metadata, inference_stamp = item
+        stamp = now.to_msg()
 
-                if stamp is not None:
-                    msg = self.onboard_inference_to_msg(metadata.inference)
-                    msg.header.stamp = stamp
-                    self.inference_pub.publish(msg)
+        msg = self.frame_to_msg(frame)
+        msg.header.stamp = stamp
+        self.image_pub.publish(msg)
 
-            if self.save:
-                self.frame_saver.save(frame, tof_frame, metadata)
+        if tof_frame is not None:
+            msg = self.frame_to_msg(tof_frame)
+            msg.header.stamp = stamp
+            self.tof_pub.publish(msg)
         
-        if self.save:
-            self.frame_saver.close()
-            self.inference_saver.close()
+        msg = self.metadata_to_msg(metadata)
+        msg.header.stamp = stamp
+        self.metadata_pub.publish(msg)
+
+        msg = self.state_to_odom(metadata.state)
+        msg.header.stamp = stamp
+        self.odom_pub.publish(msg)
+
+        msg = self.state_to_accel(metadata.state)
+        msg.header.stamp = stamp
+        self.accel_pub.publish(msg)
+
+        if inference_stamp is not None:
+            msg = self.onboard_inference_to_msg(metadata.inference)
+            msg.header.stamp = Time(nanoseconds=inference_stamp).to_msg()
+            self.inference_pub.publish(msg)
+
+        # Publication latency, from the frame timestamp on GAP8 to the end of publishing [ms]
+        latency = (self.get_clock().now().nanoseconds / 10**9 - frame_time) * 10**3
+        with self.latency_lock:
+            self.latencies.append(latency)
+
+        if self.save_stage:
+            self.save_stage.put((frame, tof_frame, metadata))
+
+    def save_frame(self, item):
+        frame, tof_frame, metadata = item
+        self.frame_saver.save(frame, tof_frame, metadata)
+
+    def publish_diagnostics(self):
+        with self.latency_lock:
+            latencies = self.latencies
+            self.latencies = []
+
+        status = DiagnosticStatus()
+        status.name = f'{self.get_name()}: publication'
+        status.hardware_id = 'aideck'
+        status.level = DiagnosticStatus.OK
+        status.message = 'OK'
+
+        values = [('publish_rate', len(latencies))]
+        if len(latencies) > 0:
+            values += [
+                ('latency_mean_ms', np.mean(latencies)),
+                ('latency_max_ms', np.max(latencies)),
+            ]
+
+        for stage in self.stages:
+            n_processed, n_dropped = stage.pop_stats()
+            values += [(f'{stage.name}_dropped', n_dropped)]
+
+            if n_dropped > 0:
+                status.level = DiagnosticStatus.WARN
+                status.message = 'Dropping frames'
+
+        status.values = [KeyValue(key=key, value=f'{value:.3f}' if isinstance(value, float) else str(value)) for key, value in values]
+
+        msg = DiagnosticArray()
+        msg.header.stamp = self.get_clock().now().to_msg()
+        msg.status = [status]
+        self.diagnostics_pub.publish(msg)
 
     def log(self, message='', end='\n'):
         self.get_logger().info(f'{message}{end}')
@@ -189,6 +288,19 @@ class ROSViewer(Node):
 
         return msg
 
+    def frame_to_msg(self, frame):
+        # Fill the message directly from the reassembly buffer, without going through cv_bridge
+        frame = np.ascontiguousarray(frame)
+
+        msg = Image()
+        msg.height, msg.width = frame.shape
+        msg.encoding = IMAGE_ENCODINGS[frame.dtype.itemsize]
+        msg.is_bigendian = False
+        msg.step = frame.strides[0]
+        msg.data.frombytes(frame.data)
+
+        return msg
+
     def onboard_inference_to_msg(self, inference):
         msg = Inference()
         array_to_msg([inference.x, inference.y, inference.z, inference.phi], msg.output)
@@ -228,7 +340,8 @@ class ROSViewer(Node):
 
     def push_metadata(self, stamp, metadata):
         stamp = Time.from_msg(stamp).nanoseconds
-        self.metadata_queue.append((stamp, metadata))
+        with self.metadata_lock:
+            self.metadata_queue.append((stamp, metadata))
 
     def pop_metadata(self, stamp=None, stm32_timestamp=None):
         assert (stamp is None) != (stm32_timestamp is None), "Exactly one of stamp or stm32_timestamp must be supplied"
@@ -236,6 +349,10 @@ class ROSViewer(Node):
         if stamp is not None:
             stamp = Time.from_msg(stamp).nanoseconds
 
+        with self.metadata_lock:
+            return self._pop_metadata_locked(stamp, stm32_timestamp)
+
+    def _pop_metadata_locked(self, stamp, stm32_timestamp):
         # If stamp or stm32_timestamp are zero, just return the most recent metadata
         if len(self.metadata_queue) > 0 and \
            (stamp == 0 or stm32_timestamp == 0):
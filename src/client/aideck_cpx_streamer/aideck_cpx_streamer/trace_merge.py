@@ -0,0 +1,246 @@
+#
+# trace_merge.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+
+import argparse
+import csv
+import json
+import sys
+from collections import namedtuple
+
+import numpy as np
+
+from .cpx.cpx import CPXTarget
+from .cpx.trace import TimelineEvent, TraceEventId, TraceState, event_name
+
+# Trace events recorded by GAP8 for each clock sync link (see clock_sync.h in the GAP8 lib)
+CLOCK_SYNC_EVENTS = {
+    CPXTarget.STM32: (TraceEventId.CLOCK_SYNC_STM32, TraceEventId.CLOCK_REMOTE_STM32),
+    CPXTarget.ESP32: (TraceEventId.CLOCK_SYNC_NINA, TraceEventId.CLOCK_REMOTE_NINA),
+}
+
+# Internal events that are not exported to the merged timeline
+HIDDEN_EVENTS = {TraceEventId.SYNC, TraceEventId.CLOCK_REMOTE_STM32, TraceEventId.CLOCK_REMOTE_NINA}
+
+# A ping/pong exchange: GAP8 midpoint between ping and pong [s], remote midpoint [s], round-trip time [s]
+ClockSample = namedtuple('ClockSample', ['local', 'remote', 'rtt'])
+
+class ClockFit(namedtuple('ClockFit', ['slope', 'offset', 'local_ref', 'residual', 'n_samples', 'n_inliers'])):
+    """Linear relation remote = slope * (local - local_ref) + offset between a remote clock and the GAP8 clock."""
+
+    @property
+    def drift_ppm(self):
+        return (self.slope - 1) * 1e6
+
+    def to_remote(self, local):
+        return self.slope * (local - self.local_ref) + self.offset
+
+    def to_local(self, remote):
+        return (remote - self.offset) / self.slope + self.local_ref
+
+def read_trace_csv(path):
+    """Read the events saved by TraceWriter (trace_viewer -save, plt_viewer -trace)."""
+    def parse_event(name):
+        try:
+            return TraceEventId[name]
+        except KeyError:
+            return int(name, 16)
+
+    with open(path, newline='') as f:
+        return [
+            TimelineEvent(
+                float(row['timestamp']), CPXTarget[row['source']], int(row['core_id']),
+                parse_event(row['event']), TraceState[row['state']], int(row['context'])
+            )
+            for row in csv.DictReader(f)
+        ]
+
+def clock_samples(events, remote):
+    """Extract the ping/pong exchanges with the given remote chip from the GAP8 events."""
+    sync_event, remote_event = CLOCK_SYNC_EVENTS[remote]
+
+    pings = {}
+    exchange = None
+    remote_lo = None
+    remote_base = 0
+    last_remote = None
+    samples = []
+
+    for e in sorted(events, key=lambda e: e.timestamp):
+        if e.source != CPXTarget.GAP:
+            continue
+
+        if e.event == sync_event and e.state == TraceState.BEGIN:
+            pings[e.context] = e.timestamp
+        elif e.event == sync_event and e.state == TraceState.END:
+            # Pongs are matched to pings by sequence number, late or duplicate pongs are discarded
+            ping = pings.pop(e.context, None)
+            exchange = (ping, e.timestamp) if ping is not None else None
+            remote_lo = None
+        elif e.event == remote_event and e.state == TraceState.BEGIN and exchange is not None:
+            remote_lo = e.context
+        elif e.event == remote_event and e.state == TraceState.END and remote_lo is not None:
+            # Remote timestamps are 32-bit microsecond counters, which overflow after ~71 minutes
+            remote_us = (e.context << 16) | remote_lo
+            if last_remote is not None and remote_us < last_remote - (1 << 31):
+                remote_base += 1 << 32
+            last_remote = remote_us
+
+            ping, pong = exchange
+            samples.append(ClockSample((ping + pong) / 2, (remote_base + remote_us) / 1e6, pong - ping))
+            exchange = None
+            remote_lo = None
+
+    return samples
+
+def fit_clock(samples, threshold=None, n_iterations=500, seed=0):
+    """Robustly fit remote = slope * local + offset with RANSAC.
+
+    Samples whose round-trip time is more than twice the median were delayed by queueing and
+    are discarded upfront. The inlier threshold defaults to half the median round-trip time,
+    which bounds the error of the midpoint estimate when the link delay is symmetric.
+    """
+    if len(samples) < 2:
+        raise ValueError(f"At least 2 clock samples are needed, got {len(samples)}")
+
+    local = np.array([s.local for s in samples])
+    remote = np.array([s.remote for s in samples])
+    rtt = np.array([s.rtt for s in samples])
+
+    keep = rtt <= 2 * np.median(rtt)
+    local, remote = local[keep], remote[keep]
+
+    if threshold is None:
+        threshold = max(np.median(rtt) / 2, 1e-6)
+
+    # Center the local clock to keep the fit well conditioned
+    local_ref = local[0]
+    x = local - local_ref
+
+    rng = np.random.default_rng(seed)
+    best_inliers = np.ones_like(x, dtype=bool)
+    best_count = 0
+
+    for _ in range(n_iterations if len(x) > 2 else 0):
+        i, j = rng.choice(len(x), 2, replace=False)
+        if x[i] == x[j]:
+            continue
+
+        slope = (remote[j] - remote[i]) / (x[j] - x[i])
+        offset = remote[i] - slope * x[i]
+        inliers = np.abs(remote - (slope * x + offset)) < threshold
+
+        if inliers.sum() > best_count:
+            best_inliers = inliers
+            best_count = inliers.sum()
+
+    slope, offset = np.polyfit(x[best_inliers], remote[best_inliers], 1)
+    residual = np.std(remote[best_inliers] - (slope * x[best_inliers] + offset))
+
+    return ClockFit(slope, offset, local_ref, residual, len(samples), int(best_inliers.sum()))
+
+def fit_clocks(events):
+    """Fit the clock of every remote chip for which clock samples are available."""
+    fits = {}
+    for remote in CLOCK_SYNC_EVENTS:
+        samples = clock_samples(events, remote)
+        if len(samples) >= 2:
+            fits[remote] = fit_clock(samples)
+    return fits
+
+def chrome_trace(events, fits):
+    """Convert events to the Chrome/Perfetto JSON trace format, on the GAP8 timeline.
+
+    BEGIN/END pairs become complete events ("X"), markers become instant events ("i").
+    Each chip is shown as a process and each of its cores as a thread.
+    """
+    trace_events = []
+    pending = {}
+
+    for source in sorted({e.source for e in events}):
+        trace_events.append({"name": "process_name", "ph": "M", "pid": int(source), "args": {"name": source.name}})
+
+    def local_us(e):
+        if e.source == CPXTarget.GAP:
+            return e.timestamp * 1e6
+        return fits[e.source].to_local(e.timestamp) * 1e6
+
+    for e in sorted(events, key=lambda e: e.timestamp):
+        if e.event in HIDDEN_EVENTS:
+            continue
+        if e.source != CPXTarget.GAP and e.source not in fits:
+            continue
+
+        common = {"name": event_name(e.event), "cat": e.source.name, "pid": int(e.source), "tid": e.core_id}
+
+        if e.state == TraceState.MARKER:
+            trace_events.append({**common, "ph": "i", "s": "t", "ts": local_us(e), "args": {"context": e.context}})
+        elif e.state == TraceState.BEGIN:
+            # Like TraceDecoder, intervals can begin and end on different cores
+            pending[(e.source, e.event)] = e
+        else:
+            begin = pending.pop((e.source, e.event), None)
+            if begin is None:
+                continue
+
+            begin_us = local_us(begin)
+            trace_events.append({
+                **common, "tid": begin.core_id, "ph": "X",
+                "ts": begin_us, "dur": local_us(e) - begin_us,
+                "args": {"context": begin.context},
+            })
+
+    return {"traceEvents": trace_events, "displayTimeUnit": "ms"}
+
+class TraceMerge:
+    def __init__(self) -> None:
+        parser = argparse.ArgumentParser(description='Merge GAP8, NINA and STM32 event traces on a single timeline')
+        parser.add_argument("traces", nargs='+', metavar="trace", help="CSV traces saved by trace_viewer or plt_viewer")
+        parser.add_argument("-o", "--output", default="trace.json", metavar="output", help="Chrome/Perfetto JSON trace")
+        self.args = parser.parse_args()
+
+    def main(self):
+        events = []
+        for path in self.args.traces:
+            events += read_trace_csv(path)
+
+        fits = fit_clocks(events)
+        for remote, fit in fits.items():
+            print(
+                f"{remote.name:6} offset={fit.offset - fit.local_ref:.6f}s drift={fit.drift_ppm:+.2f}ppm "
+                f"residual={1e6 * fit.residual:.1f}us inliers={fit.n_inliers}/{fit.n_samples}"
+            )
+
+        for source in sorted({e.source for e in events} - {CPXTarget.GAP} - set(fits)):
+            print(f"{source.name:6} no clock sync samples, events discarded", file=sys.stderr)
+
+        with open(self.args.output, "w") as f:
+            json.dump(chrome_trace(events, fits), f)
+
+def main():
+    merge = TraceMerge()
+    merge.main()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#
+# trace_viewer.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import argparse
+import time
+from collections import defaultdict
+
+from .cpx.cpx import CPXClient
+from .cpx.trace import TraceDecoder, TraceState, event_name
+
+class TraceWriter:
+    """Write decoded trace events to a CSV file, can be registered as a CPXClient callback."""
+
+    def __init__(self, path, decoder=None) -> None:
+        self.decoder = decoder or TraceDecoder()
+        self.file = open(path, "w")
+        self.file.write("timestamp,source,core_id,event,state,context\n")
+
+    def feed(self, packet):
+        events, intervals = self.decoder.feed(packet)
+        for e in events:
+            self.file.write(f"{e.timestamp:.9f},{e.source.name},{e.core_id},{event_name(e.event)},{TraceState(e.state).name},{e.context}\n")
+        return events, intervals
+
+    def close(self):
+        self.file.close()
+
+class TraceViewer:
+    def __init__(self) -> None:
+        parser = argparse.ArgumentParser(description='Receive event traces streamed by the AI-deck')
+        parser.add_argument("-host", default="aideck.local", metavar="host", help="AI-deck host")
+        parser.add_argument("-port", type=int, default='5000', metavar="port", help="AI-deck port")
+        parser.add_argument("-save", type=str, default=None, metavar="save", help="Save decoded events to CSV file")
+        parser.add_argument("-period", type=float, default=1.0, metavar="period", help="Summary period [s]")
+        args = parser.parse_args()
+
+        self.client = CPXClient(host=args.host, port=args.port)
+        self.decoder = TraceDecoder()
+        self.writer = TraceWriter(args.save, self.decoder) if args.save else None
+        self.period = args.period
+
+    def main(self):
+        durations = defaultdict(list)
+        last_summary = time.monotonic()
+
+        try:
+            for packet in self.client.receive():
+                if self.writer:
+                    _, intervals = self.writer.feed(packet)
+                else:
+                    _, intervals = self.decoder.feed(packet)
+
+                for interval in intervals:
+                    durations[(interval.source.name, event_name(interval.event))].append(interval.end - interval.begin)
+
+                now = time.monotonic()
+                if now - last_summary >= self.period:
+                    self.print_summary(durations)
+                    durations.clear()
+                    last_summary = now
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.client.shutdown()
+            if self.writer:
+                self.writer.close()
+
+    def print_summary(self, durations):
+        print(
+            f"events: {self.decoder.n_events}, "
+            f"lost packets: {self.decoder.n_lost_packets}, "
+            f"dropped events: {self.decoder.n_dropped}"
+        )
+        for (source, event), values in sorted(durations.items()):
+            mean_ms = 1e3 * sum(values) / len(values)
+            max_ms = 1e3 * max(values)
+            print(f"  {source:6} {event:20} n={len(values):5d} mean={mean_ms:8.3f}ms max={max_ms:8.3f}ms")
+
+def main():
+    viewer = TraceViewer()
+    viewer.main()
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+#
+# frame_clock.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+# 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# 
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import queue
+
+from collections import deque
+
+
+class FrameClock:
+    """Maps the GAP8 frame timestamps to the host clock.
+
+    GAP8 and the host do not share a clock, so the offset between them is estimated from the
+    frames themselves: it is the minimum of receive time minus frame timestamp over the latest
+    `window` frames, i.e. the frame that reached the host with the shortest transport delay.
+    Host times mapped from frame timestamps are therefore early by that shortest delay, while
+    the window follows the drift between the two clocks. The 32-bit [usec] frame timestamps
+    are unwrapped, so that the mapping survives their overflow every ~71 minutes.
+    """
+
+    TIMESTAMP_WRAP = 2**32
+
+    def __init__(self, window=300) -> None:
+        self.offsets = deque(maxlen=window)
+        self.last_timestamp = None
+        self.wraps = 0
+
+    def update(self, frame_timestamp, receive_time):
+        """Add a frame received at `receive_time` [s, host clock], return its host time [s]."""
+        if self.last_timestamp is not None and frame_timestamp < self.last_timestamp:
+            self.wraps += 1
+        self.last_timestamp = frame_timestamp
+
+        frame_time = (self.wraps * self.TIMESTAMP_WRAP + frame_timestamp) / 10**6
+        self.offsets.append(receive_time - frame_time)
+
+        return frame_time + min(self.offsets)
@@ -0,0 +1,111 @@
+#
+# pipeline.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+# 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# 
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import queue
+from threading import Lock, Thread
+
+
+class PipelineStage:
+    """A processing stage with a bounded input queue, served by a pool of worker threads.
+
+    Each item put into the stage is processed by `fn`. If the stage has a `next_stage`, the
+    value returned by `fn` is forwarded to it, unless it is None. When the input queue is full,
+    the oldest queued item is dropped to make room for the new one (or the new one is dropped
+    if `drop_oldest` is False), so that a slow stage never makes latency grow without bounds.
+    """
+
+    def __init__(self, fn, next_stage=None, n_workers=1, queue_size=1, drop_oldest=True, name=None) -> None:
+        self.fn = fn
+        self.next_stage = next_stage
+        self.drop_oldest = drop_oldest
+        self.name = name or getattr(fn, '__name__', 'stage')
+
+        self.queue = queue.Queue(maxsize=queue_size)
+        self.pool = [Thread(target=self.worker_main, name=self.name, daemon=True) for _ in range(n_workers)]
+        self.ok = True
+
+        self.stats_lock = Lock()
+        self.n_processed = 0
+        self.n_dropped = 0
+
+    def start(self):
+        for thread in self.pool:
+            thread.start()
+
+    def shutdown(self):
+        self.ok = False
+
+        # Wake up the workers waiting on an empty queue
+        for _ in self.pool:
+            try:
+                self.queue.put_nowait(None)
+            except queue.Full:
+                pass
+
+    def put(self, item):
+        """Enqueue an item without blocking. Return False if an item had to be dropped."""
+        while True:
+            try:
+                self.queue.put_nowait(item)
+                return True
+            except queue.Full:
+                pass
+
+            if not self.drop_oldest:
+                self._count_drop()
+                return False
+
+            try:
+                self.queue.get_nowait()
+                self._count_drop()
+            except queue.Empty:
+                pass
+
+    def pop_stats(self):
+        """Return the number of processed and dropped items since the last call and reset the counters."""
+        with self.stats_lock:
+            stats = (self.n_processed, self.n_dropped)
+            self.n_processed = 0
+            self.n_dropped = 0
+        return stats
+
+    def _count_drop(self):
+        with self.stats_lock:
+            self.n_dropped += 1
+
+    def worker_main(self):
+        while self.ok:
+            item = self.queue.get()
+
+            # Fake item used to break out of waiting on shutdown
+            if item is None:
+                continue
+
+            result = self.fn(item)
+
+            with self.stats_lock:
+                self.n_processed += 1
+
+            if self.next_stage is not None and result is not None:
+                self.next_stage.put(result)
@@ -21,11 +21,19 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 # SOFTWARE.
 
+import math
 from typing import Sequence
 import numpy as np
 
-_1_2F = np.float32(1/2)
-_SQRT1_2F = np.sqrt(_1_2F)
+# Bit-exact with quatcompress.h in the Crazyflie firmware, both are checked against the test
+# vectors in test/data/quatcompress_vectors.txt. All arithmetic is in single precision, with
+# a single rounding per value.
+
+_MAG_MAX = (1 << 9) - 1
+_SCALE_X2 = np.float32(2 * _MAG_MAX * math.sqrt(2))
+_DECOMPRESS_SCALE = np.float32(math.sqrt(0.5) / _MAG_MAX)
+_ONE = 2 * _MAG_MAX * _MAG_MAX
+_ONE_INV = np.float32(1.0 / _ONE)
 
 # assumes input quaternion is normalized. will fail if not.
 def quatcompress(q: Sequence[np.float32]) -> np.uint32:
@@ -44,24 +52,27 @@ def quatcompress(q: Sequence[np.float32]) -> np.uint32:
     # of the second-largest element in a unit quaternion.
 
     # do compression using sign bit and 9-bit precision per element.
-    comp = np.uint32(i_largest)
+    # mag = floor(x + 0.5) is computed as (floor(2 * x) + 1) / 2, to round in integer arithmetic.
+    comp = int(i_largest)
 
     for i in range(4):
         if i != i_largest:
-            negbit = np.uint32((q[i] < 0) ^ negate)
-            mag = np.uint32(((1 << 9) - 1) * (np.abs(q[i]) / _SQRT1_2F) + _1_2F)
-            comp = (comp << 10) | (negbit << 9) | mag
+            negbit = int((q[i] < 0) ^ negate)
+            mag = (int(np.abs(q[i]) * _SCALE_X2) + 1) >> 1
+            comp = ((comp << 10) | (negbit << 9) | mag) & 0xffffffff
 
-    return comp
+    return np.uint32(comp)
 
 def quatdecompress(comp: np.uint32) -> Sequence[np.float32]:
-    comp = np.uint32(comp)
+    comp = int(comp) & 0xffffffff
     q = np.empty(4, dtype=np.float32)
 
-    mask = np.uint32((1 << 9) - 1)
+    mask = (1 << 9) - 1
 
     i_largest = comp >> 30
-    sum_squares = np.float32(0)
+
+    # the sum of squares is exact in integer arithmetic
+    sum_squares = 0
 
     for i in reversed(range(4)):
         if i != i_largest:
@@ -69,13 +80,44 @@ def quatdecompress(comp: np.uint32) -> Sequence[np.float32]:
             negbit = (comp >> 9) & 0x1
             comp = comp >> 10
 
-            q[i] = _SQRT1_2F * np.float32(mag) / mask
+            q[i] = _DECOMPRESS_SCALE * np.float32(mag)
 
             if negbit == 1:
                 q[i] = -q[i]
 
-            sum_squares += q[i] * q[i]
+            sum_squares += mag * mag
 
-    q[i_largest] = np.sqrt(1 - sum_squares)
+    with np.errstate(invalid='ignore'):
+        q[i_largest] = np.sqrt(np.float32(_ONE - sum_squares) * _ONE_INV)
 
     return q
+
+# Elements other than the largest, in the order in which they are packed from the least significant bits
+_PACKED_INDICES = np.array([[i for i in reversed(range(4)) if i != i_largest] for i_largest in range(4)])
+
+def quatdecompress_batch(comps) -> np.ndarray:
+    """Vectorized quatdecompress, returns an array of shape (..., 4) with the same results.
+
+    Also accepts codes stored as signed integers, like the state_quat column of the metadata
+    saved by frame_saver.py.
+    """
+    comps = np.asarray(comps).astype(np.uint32)
+    shape = comps.shape
+    comps = comps.reshape(-1)
+
+    i_largest = (comps >> 30).astype(np.intp)
+    fields = (comps[:, None] >> np.array([0, 10, 20], dtype=np.uint32)) & 0x3ff
+
+    mags = (fields & 0x1ff).astype(np.int32)
+    values = _DECOMPRESS_SCALE * mags.astype(np.float32)
+    values = np.where((fields >> 9) != 0, -values, values)
+
+    q = np.empty((len(comps), 4), dtype=np.float32)
+    np.put_along_axis(q, _PACKED_INDICES[i_largest], values, axis=1)
+
+    sum_squares = (mags * mags).sum(axis=1)
+    with np.errstate(invalid='ignore'):
+        largest = np.sqrt((_ONE - sum_squares).astype(np.float32) * _ONE_INV)
+    np.put_along_axis(q, i_largest[:, None], largest[:, None], axis=1)
+
+    return q.reshape(shape + (4,))
@@ -54,7 +54,12 @@ setup(
     entry_points={
         'console_scripts': [
             'plt_viewer = aideck_cpx_streamer.plt_viewer:main',
-            'ros_viewer = aideck_cpx_streamer.ros_viewer:main'
+            'ros_viewer = aideck_cpx_streamer.ros_viewer:main',
+            'trace_viewer = aideck_cpx_streamer.trace_viewer:main',
+            'trace_merge = aideck_cpx_streamer.trace_merge:main',
+            'frontnet_telemetry = aideck_cpx_streamer.frontnet_telemetry:main',
+            'network_profile = aideck_cpx_streamer.network_profile:main',
+            'energy_model = aideck_cpx_streamer.energy_model:main'
         ],
     },
 )
@@ -0,0 +1,97 @@
+#
+# test_energy_model.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import ctypes
+import io
+
+import pytest
+
+from aideck_cpx_streamer.cpx import StreamerDvfs
+from aideck_cpx_streamer.energy_model import EnergyModel, format_table, read_records, summarize, write_record
+
+
+def make_record(freq_cl=175, voltage=1200, busy=10000, period=33333, mode=1):
+    return StreamerDvfs(mode=mode, voltage=voltage, freq_fc=246, freq_cl=freq_cl, period=period, busy=busy)
+
+
+def test_record_size():
+    # Must match sizeof(streamer_dvfs_t) on GAP8
+    assert ctypes.sizeof(StreamerDvfs) == 20
+
+
+def test_reference_point():
+    model = EnergyModel(cluster_dynamic=60.0, cluster_leakage=4.0, fc_dynamic=15.0, fc_leakage=2.0)
+    record = make_record(busy=10000, period=20000)
+
+    assert model.cluster_power(1200, 175) == pytest.approx(60.0)
+    assert model.idle_power(1200, 246) == pytest.approx(21.0)
+    # 21 mW for 20 ms, plus 60 mW for 10 ms
+    assert model.frame_energy(record) == pytest.approx(0.42 + 0.6)
+    assert model.reference_energy(record) == pytest.approx(model.frame_energy(record))
+
+
+def test_frequency_scaling():
+    model = EnergyModel()
+
+    # Same cycles at a lower frequency: the cluster dynamic energy does not change, only lowering
+    # the voltage saves energy
+    slow = make_record(freq_cl=70, busy=20000)
+    assert model.reference_energy(slow) == pytest.approx(model.frame_energy(make_record(busy=8000)))
+    assert model.frame_energy(slow) == pytest.approx(model.reference_energy(slow))
+
+    low_voltage = make_record(freq_cl=70, voltage=1000, busy=20000)
+    assert model.frame_energy(low_voltage) < 0.8 * model.reference_energy(low_voltage)
+
+    # A missed period stretches the frame
+    miss = make_record(busy=40000, period=33333)
+    assert model.frame_energy(miss) > model.frame_energy(make_record(busy=33333))
+
+
+def test_summarize():
+    model = EnergyModel()
+    records = [make_record(), make_record(), make_record(freq_cl=90, voltage=1000, busy=19000),
+               make_record(mode=StreamerDvfs.MODE_NONE)]
+
+    rows = summarize(records, model)
+
+    assert [row["point"] for row in rows] == ["90MHz 1000mV", "175MHz 1200mV", "total"]
+    assert [row["frames"] for row in rows] == [1, 2, 3]
+    assert rows[0]["share"] == pytest.approx(1 / 3)
+    assert rows[1]["saving"] == pytest.approx(0.0)
+    assert rows[0]["saving"] > 0.0
+    assert rows[2]["energy"] == pytest.approx((2 * rows[1]["energy"] + rows[0]["energy"]) / 3)
+
+    lines = format_table(rows).split("\n")
+    assert len(lines) == 4
+    assert len(set(len(line) for line in lines)) == 1
+
+
+def test_record_file():
+    records = [make_record(busy=i * 1000) for i in range(3)]
+    file = io.BytesIO()
+    for record in records:
+        write_record(file, record)
+    file.seek(0)
+
+    assert [bytes(r) for r in read_records(file)] == [bytes(r) for r in records]
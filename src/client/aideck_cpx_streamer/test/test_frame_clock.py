@@ -0,0 +1,64 @@
+#
+# test_frame_clock.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import os
+
+import pytest
+
+from aideck_cpx_streamer.utils.frame_clock import FrameClock
+
+PERIOD = 1 / 30
+HOST_START = 1000.0
+
+
+def test_offset_from_fastest_frame():
+    clock = FrameClock()
+    delays = [0.020, 0.005, 0.030, 0.012]
+
+    for i, delay in enumerate(delays):
+        timestamp = int(i * PERIOD * 10**6)
+        receive_time = HOST_START + timestamp / 10**6 + delay
+
+        # Mapped to the host clock as if it had the shortest delay seen so far
+        host_time = clock.update(timestamp, receive_time)
+        assert host_time == pytest.approx(HOST_START + timestamp / 10**6 + min(delays[:i + 1]), abs=1e-6)
+
+
+def test_timestamp_wrap():
+    clock = FrameClock()
+    timestamps = [FrameClock.TIMESTAMP_WRAP - 20000, FrameClock.TIMESTAMP_WRAP - 5000, 10000, 25000]
+
+    host_times = [clock.update(timestamp, HOST_START + i * 0.015) for i, timestamp in enumerate(timestamps)]
+    assert host_times == pytest.approx([HOST_START + i * 0.015 for i in range(len(timestamps))], abs=1e-6)
+
+
+def test_window_follows_drift():
+    clock = FrameClock(window=10)
+
+    # The host clock runs 1000 ppm faster, the offset follows it within the window
+    for i in range(100):
+        timestamp = int(i * PERIOD * 10**6)
+        host_time = clock.update(timestamp, HOST_START + timestamp / 10**6 * 1.001)
+
+    assert HOST_START + timestamp / 10**6 * 1.001 - host_time < 10 * PERIOD * 0.001 + 1e-6
@@ -0,0 +1,142 @@
+#
+# test_frontnet_msg.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import os
+
+import pytest
+
+from aideck_cpx_streamer.frontnet_msg import (
+    APPCHANNEL_MTU, INFERENCE_FLAG_FILTERED, INFERENCE_FLAG_OUTLIER, Ack, AckStatus, AltitudeReference, Inference, MsgType, TargetConfig,
+    decode, encode_ack, encode_inference, encode_inference_batch, encode_legacy_inference,
+    encode_target_config, round_trip_time
+)
+
+# Test vectors shared with the C implementation, checked by `make test` in src/stm32/app/sim.
+# Regenerate with `python3 test/test_frontnet_msg.py` after changing the vectors below.
+VECTORS_PATH = os.path.join(os.path.dirname(__file__), "data", "frontnet_msg_vectors.txt")
+
+VECTORS = [
+    ("legacy", encode_legacy_inference(Inference(123456, 1.5, -0.25, 0.125, -3.0))),
+    ("inference", encode_inference(0, 0, 1000, Inference(4000, 1.234, -0.5, 0.1, 0.785))),
+    ("inference", encode_inference(1, 65535, 0xffffffff, Inference(0, 0.0, 0.0, 0.0, 0.0), ack_request=True)),
+    ("inference", encode_inference(0, 1, 1033, Inference(4033, 0.6, 0.8, 0.0, 0.1, INFERENCE_FLAG_FILTERED | INFERENCE_FLAG_OUTLIER, 0))),
+    ("legacy", encode_legacy_inference(Inference(123490, 1.5, -0.25, 0.125, -3.0, INFERENCE_FLAG_FILTERED, 217))),
+    ("batch", encode_inference_batch(0, 17, 2000, [Inference(5000, 1.5, 0.25, -0.125, 3.141)])),
+    ("batch", encode_inference_batch(1, 18, 3000, [
+        Inference(0xfffffff0, 1.5, 0.25, -0.125, 3.141), Inference(0x00000010, 40.0, -40.0, 0.0005, -3.141)
+    ], ack_request=True)),
+    ("target", encode_target_config(0, 5, 4000, TargetConfig(1.5, 1.4, AltitudeReference.GROUND), ack_request=True)),
+    ("target", encode_target_config(1, 6, 5000, TargetConfig(0.8, -0.2, AltitudeReference.SUBJECT))),
+    ("ack", encode_ack(1, 6, 7000, Ack(MsgType.TARGET_CONFIG, 5000, 6990, AckStatus.ACCEPTED))),
+    ("ack", encode_ack(0, 7, 7001, Ack(MsgType.INFERENCE_BATCH, 6000, 7001, AckStatus.REJECTED))),
+    ("invalid", b''),
+    ("invalid", b'\x01\x00\x00'),
+    ("invalid", encode_inference(0, 0, 0, Inference(0, 0.0, 0.0, 0.0, 0.0))[:-1]),
+    ("invalid", encode_legacy_inference(Inference(0, 0.0, 0.0, 0.0, 0.0)) + b'\x00'),
+    ("invalid", b'\x7f' + bytes(7)),
+    ("invalid", encode_inference_batch(0, 0, 0, [Inference(0, 0.0, 0.0, 0.0, 0.0)])[:8] + b'\x03' + bytes(4 + 2 * 9)),
+    ("invalid", encode_inference_batch(0, 0, 0, [Inference(0, 0.0, 0.0, 0.0, 0.0)])[:8] + b'\x00' + bytes(4)),
+]
+
+
+def format_vector(kind, packet):
+    """One line per vector: kind, hex bytes, then the decoded fields in the order used by msg_test.c"""
+    fields = [kind, packet.hex() or "-"]
+
+    if kind != "invalid":
+        message = decode(packet)
+        if kind != "legacy":
+            fields += [int(message.ack_request), message.source, message.sequence, message.tx_timestamp]
+
+        if kind in ("legacy", "inference", "batch"):
+            if kind == "batch":
+                fields.append(len(message.payload))
+            for inference in message.payload:
+                fields += [inference.stm32_timestamp] + [f"{v:.9g}" for v in inference[1:5]] + [inference.flags, inference.confidence]
+        elif kind == "target":
+            target = message.payload
+            fields += [f"{target.horizontal_distance:.9g}", f"{target.altitude:.9g}", target.altitude_reference]
+        elif kind == "ack":
+            fields += list(message.payload)
+
+    return " ".join(str(f) for f in fields)
+
+
+def format_vectors():
+    return "".join(format_vector(kind, packet) + "\n" for kind, packet in VECTORS)
+
+
+def test_vectors_up_to_date():
+    with open(VECTORS_PATH) as f:
+        assert f.read() == format_vectors()
+
+
+@pytest.mark.parametrize("kind,packet", VECTORS)
+def test_packet_size(kind, packet):
+    assert len(packet) <= APPCHANNEL_MTU
+
+
+@pytest.mark.parametrize("kind,packet", [v for v in VECTORS if v[0] == "invalid"])
+def test_invalid(kind, packet):
+    with pytest.raises(ValueError):
+        decode(packet)
+
+
+def test_inference():
+    message = decode(encode_inference(1, 42, 1000, Inference(4000, 1.25, -0.5, 0.0, 0.5), ack_request=True))
+
+    assert message.type == MsgType.INFERENCE
+    assert message.ack_request
+    assert (message.source, message.sequence, message.tx_timestamp) == (1, 42, 1000)
+    assert message.payload == [Inference(4000, 1.25, -0.5, 0.0, 0.5)]
+
+    message = decode(encode_inference(1, 43, 1033, Inference(4033, 0.6, 0.8, 0.0, 0.5, INFERENCE_FLAG_OUTLIER, 0)))
+    assert message.payload[0].flags == INFERENCE_FLAG_OUTLIER
+
+
+def test_batch_fixed_point():
+    inferences = [Inference(1000, 1.2345, -0.5, 100.0, 3.14159), Inference(1033, 0.0, 0.0, 0.0, -3.14159)]
+    message = decode(encode_inference_batch(0, 1, 0, inferences))
+
+    assert [i.stm32_timestamp for i in message.payload] == [1000, 1033]
+    assert message.payload[0][1:5] == pytest.approx([1.2345, -0.5, 32.767, 3.14159], abs=0.0005)
+    assert message.payload[1].phi == pytest.approx(-3.14159, abs=0.0005)
+
+
+def test_batch_limits():
+    with pytest.raises(ValueError):
+        encode_inference_batch(0, 0, 0, [Inference(0, 0, 0, 0, 0)] * 3)
+    with pytest.raises(ValueError):
+        encode_inference_batch(0, 0, 0, [Inference(1000, 0, 0, 0, 0), Inference(1300, 0, 0, 0, 0)])
+
+
+def test_round_trip_time():
+    # Sent at 1000us, received by the STM32 at tick 50 and acked at tick 52, ack received at 9000us
+    ack = decode(encode_ack(0, 1, 52, Ack(MsgType.INFERENCE, 1000, 50, AckStatus.ACCEPTED)))
+    assert round_trip_time(ack, 9000) == pytest.approx(6000)
+
+
+if __name__ == "__main__":
+    with open(VECTORS_PATH, "w") as f:
+        f.write(format_vectors())
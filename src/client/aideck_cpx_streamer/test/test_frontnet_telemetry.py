@@ -0,0 +1,103 @@
+#
+# test_frontnet_telemetry.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import csv
+import ctypes
+import io
+import os
+
+import pytest
+
+from aideck_cpx_streamer.frontnet_telemetry import (
+    INFERENCE_CSV_COLUMNS, TelemetryDecoder, TelemetryInference, TelemetryType,
+    encode_inference, read_packets, write_packet
+)
+
+DATA_DIR = os.path.join(os.path.dirname(__file__), "data")
+
+
+def test_record_size():
+    # Must match sizeof(frontnet_telemetry_inference_t) in the STM32 firmware
+    assert ctypes.sizeof(TelemetryInference) == 27
+
+
+def test_round_trip():
+    row = [1234, 5678, 1.2345, -0.5, 2.0, 3.1416, 0.01, -0.02, 0.0, -1.5, 1, 2, 3]
+    decoder = TelemetryDecoder()
+    type, decoded = decoder.decode(encode_inference(row))
+
+    assert type == TelemetryType.INFERENCE
+    assert decoded[:2] == row[:2]
+    assert decoded[2:10] == pytest.approx(row[2:10], abs=0.0005)
+    assert decoded[10:] == row[10:]
+
+
+def test_saturation():
+    row = [0, 0, 100.0, -100.0, 0, 0, 0, 0, 0, 0, 0, 0, 0]
+    _, decoded = TelemetryDecoder().decode(encode_inference(row))
+
+    assert decoded[2] == pytest.approx(32.767)
+    assert decoded[3] == pytest.approx(-32.768)
+
+
+def test_invalid_packets():
+    decoder = TelemetryDecoder()
+    packet = encode_inference([0] * 13)
+
+    assert decoder.decode(b'') is None
+    assert decoder.decode(packet[:-1]) is None
+    assert decoder.decode(b'\xff' + packet[1:]) is None
+    assert decoder.decode(packet) is not None
+    assert decoder.n_invalid == 3
+    assert decoder.n_records == 1
+
+
+def test_packet_file():
+    packets = [encode_inference([i] * 2 + [0.0] * 8 + [0] * 3) for i in range(3)]
+    file = io.BytesIO()
+    for packet in packets:
+        write_packet(file, packet)
+    file.seek(0)
+
+    assert list(read_packets(file)) == packets
+
+
+def test_matches_firmware_encoder():
+    # Generated by the closed-loop simulator with the firmware encoder:
+    #   src/stm32/app/sim/bin/frontnet_sim -n 1 -duration 2 -telemetry test/data/frontnet_telemetry
+    with open(os.path.join(DATA_DIR, "frontnet_telemetry.csv")) as f:
+        reader = csv.reader(f)
+        assert next(reader) == INFERENCE_CSV_COLUMNS
+        expected = [[float(v) for v in row] for row in reader]
+
+    decoder = TelemetryDecoder()
+    with open(os.path.join(DATA_DIR, "frontnet_telemetry.bin"), "rb") as f:
+        decoded = [decoder.decode(packet)[1] for packet in read_packets(f)]
+
+    assert decoder.n_invalid == 0
+    assert len(decoded) == len(expected) > 0
+    for row, expected_row in zip(decoded, expected):
+        assert row[:2] == expected_row[:2]
+        assert row[2:10] == pytest.approx(expected_row[2:10], abs=0.0011)
+        assert row[10:] == expected_row[10:]
@@ -0,0 +1,127 @@
+#
+# test_network_profile.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import ctypes
+import io
+
+import pytest
+
+from aideck_cpx_streamer.cpx import StreamerMetadata, StreamerProfile
+from aideck_cpx_streamer.network_profile import (
+    EVENT, EVENT_NAMES, ProfileCollector, format_table, read_records, roofline, write_record
+)
+
+
+def make_record(layer_id, n_layers=2, **fields):
+    record = StreamerProfile(layer_id=layer_id, n_layers=n_layers, n_cores=8, n_runs=8)
+    for name, value in fields.items():
+        if name in EVENT:
+            record.events[EVENT[name]] = value
+            record.events_valid |= 1 << EVENT[name]
+        else:
+            setattr(record, name, value)
+    return record
+
+
+def test_record_size():
+    # Must match sizeof(streamer_profile_t) and the events of network_profile_event_e on GAP8
+    assert ctypes.sizeof(StreamerProfile) == 68
+    assert len(EVENT_NAMES) == StreamerProfile.N_EVENTS
+    assert StreamerMetadata.METADATA_VERSION == 13
+
+
+def test_collector():
+    collector = ProfileCollector()
+
+    assert not collector.feed(StreamerProfile(layer_id=StreamerProfile.LAYER_NONE))
+    assert not collector.complete()
+
+    assert collector.feed(make_record(1, cycles=10))
+    assert not collector.complete()
+    assert collector.feed(make_record(0, cycles=20))
+    assert collector.feed(make_record(1, cycles=30))
+    assert collector.complete()
+
+    assert [r.cycles for r in collector.records()] == [20, 30]
+    assert collector.n_records == 3
+
+
+def test_collector_network_changed():
+    collector = ProfileCollector()
+    collector.feed(make_record(0, n_layers=2))
+    collector.feed(make_record(1, n_layers=2))
+    collector.feed(make_record(0, n_layers=3))
+
+    assert collector.n_layers == 3
+    assert not collector.complete()
+
+
+def test_roofline_bounds():
+    # 8 cores at 4 MAC/cycle and 8 B/cycle: the ridge point is at 4 MAC/B
+    compute = make_record(0, macs=3200000, l2_bytes=40000, cycles=200000, dma_wait_cycles=20000,
+                          active_cycles=190000, instr=95000, ld_stall=19000)
+    memory = make_record(1, macs=7680, l2_bytes=9616, cycles=3000, l3_bytes=7696, l3_cycles=3848)
+
+    rows = roofline([compute, memory])
+
+    assert [row["layer"] for row in rows] == ["layer0", "layer1", "total"]
+    assert rows[0]["bound"] == "compute"
+    assert rows[0]["mac_per_cycle"] == pytest.approx(16.0)
+    assert rows[0]["attainable"] == pytest.approx(32.0)
+    assert rows[0]["efficiency"] == pytest.approx(0.5)
+    assert rows[0]["dma_wait"] == pytest.approx(0.1)
+    assert rows[0]["ipc"] == pytest.approx(0.5)
+    assert rows[0]["ld_stall"] == pytest.approx(0.1)
+    assert rows[0]["imiss"] is None
+
+    assert rows[1]["bound"] == "memory"
+    assert rows[1]["attainable"] == pytest.approx(7680 / 9616 * 8)
+    assert rows[1]["l3_bandwidth"] == pytest.approx(2.0)
+    assert rows[1]["ipc"] is None
+
+    assert rows[2]["macs"] == 3200000 + 7680
+    assert rows[2]["cycles"] == 203000
+    # Events are only totalled when every layer has sampled them
+    assert rows[2]["ipc"] is None
+
+
+def test_format_table():
+    rows = roofline([make_record(0, macs=100, l2_bytes=10, cycles=10), make_record(1, cycles=5)])
+    lines = format_table(rows).split("\n")
+
+    assert len(lines) == 4
+    assert lines[0].split()[:3] == ["layer", "MACs", "cycles"]
+    assert len(set(len(line) for line in lines)) == 1
+    # A layer without MACs (e.g. pooling) has no roofline
+    assert lines[2].split()[4:8] == ["-", "32.00", "-", "-"]
+
+
+def test_record_file():
+    records = [make_record(i, cycles=i * 100, instr=i) for i in range(2)]
+    file = io.BytesIO()
+    for record in records:
+        write_record(file, record)
+    file.seek(0)
+
+    assert [bytes(r) for r in read_records(file)] == [bytes(r) for r in records]
@@ -0,0 +1,249 @@
+#
+# test_quatcompress.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import os
+import shutil
+import subprocess
+
+import numpy as np
+import pytest
+
+from aideck_cpx_streamer.utils.quatcompress import quatcompress, quatdecompress, quatdecompress_batch
+
+# Test vectors shared with quatcompress.h in the Crazyflie firmware, checked by `make test` in
+# src/stm32/app/sim. Regenerate with `python3 test/test_quatcompress.py` after changing the
+# implementation, which must be changed in both languages.
+VECTORS_PATH = os.path.join(os.path.dirname(__file__), "data", "quatcompress_vectors.txt")
+
+# C implementation, built from the STM32 host simulator and driven through stdin/stdout
+SIM_DIR = os.path.join(os.path.dirname(__file__), "..", "..", "..", "stm32", "app", "sim")
+QUAT_TEST = os.path.join(SIM_DIR, "bin", "frontnet_quat_test")
+
+MAG_MAX = (1 << 9) - 1
+
+
+def random_quaternions(rng, count):
+    q = rng.standard_normal((count, 4)).astype(np.float32)
+    return q / np.linalg.norm(q, axis=1, keepdims=True).astype(np.float32)
+
+
+def boundary_quaternions():
+    """Quaternions whose elements round to either side of each quantization step, in every position."""
+    scale = 2 * MAG_MAX * np.sqrt(2)
+    quaternions = []
+
+    for mag in range(MAG_MAX):
+        # Boundary between mag and mag + 1, and the closest floats around it
+        boundary = np.float32((2 * mag + 1) / scale)
+        for value in (np.nextafter(boundary, np.float32(0)), boundary, np.nextafter(boundary, np.float32(1))):
+            for i_largest in range(4):
+                q = np.full(4, np.float32(0.1), dtype=np.float32)
+                q[(i_largest + 1 + mag % 3) % 4] = -value if mag % 2 else value
+                q[i_largest] = 0
+                q[i_largest] = np.sqrt(np.float32(1) - np.sum(q * q, dtype=np.float32))
+                quaternions.append(q)
+
+    return np.array(quaternions, dtype=np.float32)
+
+
+def special_quaternions():
+    s = np.float32(np.sqrt(0.5))
+    h = np.float32(0.5)
+    return np.array([
+        [0, 0, 0, 1], [0, 0, 0, -1], [1, 0, 0, 0], [-1, 0, 0, 0], [0, -1, 0, 0], [0, 0, 1, 0],
+        [-0.0, 0.0, -0.0, 1], [0.0, -0.0, 0.0, -1],
+        # Ties between the largest elements, the first one is used
+        [s, s, 0, 0], [-s, s, 0, 0], [0, s, -s, 0], [h, h, h, h], [-h, h, -h, h], [h, -h, -h, -h],
+    ], dtype=np.float32)
+
+
+def sum_witness_codes(rng):
+    """One code for each sum of squared magnitudes reachable by valid codes, with random i_largest and signs."""
+    squares = np.arange(MAG_MAX + 1) ** 2
+    pair_sums, pair_index = np.unique(squares[:, None] + squares[None, :], return_index=True)
+
+    witness = np.full(3 * MAG_MAX * MAG_MAX + 1, -1, dtype=np.int64)
+    for c in range(MAG_MAX + 1):
+        witness[pair_sums + c * c] = pair_index * (MAG_MAX + 1) + c
+
+    sums = np.nonzero(witness >= 0)[0]
+    ab, c = np.divmod(witness[sums], MAG_MAX + 1)
+    a, b = np.divmod(ab, MAG_MAX + 1)
+
+    signs = rng.integers(0, 8, len(sums))
+    i_largest = rng.integers(0, 4, len(sums))
+    codes = (i_largest << 30) | (((signs >> 2) & 1) << 29) | (a << 20) | (((signs >> 1) & 1) << 19) | (b << 10) | ((signs & 1) << 9) | c
+    return codes.astype(np.uint32)
+
+
+def slot_codes():
+    """Each magnitude and sign in each slot, for each i_largest."""
+    fields = np.arange(1 << 10, dtype=np.uint32)
+    return np.concatenate([
+        (np.uint32(i_largest) << np.uint32(30)) | (fields << np.uint32(10 * slot))
+        for i_largest in range(4) for slot in range(3)
+    ])
+
+
+def vector_inputs():
+    rng = np.random.default_rng(1234)
+    quaternions = np.concatenate([special_quaternions(), random_quaternions(rng, 100), boundary_quaternions()[::25]])
+    codes = np.concatenate([
+        np.array([0, 0x3fffffff, 0xffffffff, 0x40000000, 0x8007fdff, 0xc01ff1ff], dtype=np.uint32),
+        rng.integers(0, 1 << 32, 100, dtype=np.uint32),
+        slot_codes()[::97],
+    ])
+    return quaternions, codes
+
+
+def float_bits(values):
+    return np.asarray(values, dtype=np.float32).view(np.uint32)
+
+
+def format_vectors():
+    quaternions, codes = vector_inputs()
+    lines = ["# compress q[0] q[1] q[2] q[3] code, decompress code q[0] q[1] q[2] q[3] (float bit patterns)"]
+
+    for q in quaternions:
+        lines.append("compress " + " ".join(f"{b:08x}" for b in float_bits(q)) + f" {int(quatcompress(q)):08x}")
+
+    for code in codes:
+        lines.append(f"decompress {int(code):08x} " + " ".join(f"{b:08x}" for b in float_bits(quatdecompress(code))))
+
+    return "".join(line + "\n" for line in lines)
+
+
+def assert_bit_exact(actual, expected):
+    actual = np.asarray(actual, dtype=np.float32)
+    expected = np.asarray(expected, dtype=np.float32)
+
+    # NaN sign and payload depend on the FPU
+    both_nan = np.isnan(actual) & np.isnan(expected)
+    mismatch = ~both_nan & (float_bits(actual) != float_bits(expected))
+    assert not mismatch.any(), f"{mismatch.sum()} mismatches, first at {np.argwhere(mismatch)[0]}"
+
+
+def read_vectors(kind):
+    with open(VECTORS_PATH) as f:
+        lines = [line.split() for line in f if line.startswith(kind + " ")]
+    return np.array([[int(field, 16) for field in line[1:]] for line in lines], dtype=np.uint32)
+
+
+def test_vectors_compress():
+    vectors = read_vectors("compress")
+    assert len(vectors) > 0
+
+    for vector in vectors:
+        assert quatcompress(vector[:4].view(np.float32)) == vector[4]
+
+
+def test_vectors_decompress():
+    vectors = read_vectors("decompress")
+    assert len(vectors) > 0
+
+    assert_bit_exact(np.array([quatdecompress(code) for code in vectors[:, 0]]), vectors[:, 1:].view(np.float32))
+    assert_bit_exact(quatdecompress_batch(vectors[:, 0]), vectors[:, 1:].view(np.float32))
+
+
+def test_round_trip():
+    q = random_quaternions(np.random.default_rng(0), 1000)
+    decoded = np.array([quatdecompress(quatcompress(v)) for v in q])
+
+    # Same rotation: q and -q are equivalent
+    dot = np.abs(np.sum(q * decoded, axis=1))
+    assert dot == pytest.approx(1.0, abs=2e-5)
+
+
+def test_batch_matches_scalar():
+    rng = np.random.default_rng(1)
+    codes = np.concatenate([
+        rng.integers(0, 1 << 32, 2000, dtype=np.uint32),
+        sum_witness_codes(rng)[::200],
+        slot_codes()[::7],
+    ])
+
+    assert_bit_exact(quatdecompress_batch(codes), np.array([quatdecompress(c) for c in codes]))
+
+
+def test_batch_shape():
+    codes = np.array([[quatcompress([0, 0, 0, 1]), quatcompress([1, 0, 0, 0])]] * 3)
+    q = quatdecompress_batch(codes)
+
+    assert q.shape == (3, 2, 4)
+    assert q[2, 1] == pytest.approx([1, 0, 0, 0])
+    assert quatdecompress_batch(codes[0, 0]).shape == (4,)
+
+    # Signed codes, as saved in the metadata
+    signed = codes.view(np.int32)
+    assert (signed < 0).any()
+    assert_bit_exact(quatdecompress_batch(signed), q)
+
+
+@pytest.fixture(scope="module")
+def quat_test():
+    if shutil.which("make") is None:
+        pytest.skip("make not available")
+
+    result = subprocess.run(["make", "-C", SIM_DIR, "bin/frontnet_quat_test"], capture_output=True)
+    if result.returncode != 0:
+        pytest.skip("cannot build the C implementation: " + result.stderr.decode(errors="replace"))
+
+    return QUAT_TEST
+
+
+def run_c(quat_test, mode, data):
+    result = subprocess.run([quat_test, mode], input=data.tobytes(), capture_output=True, check=True)
+    return result.stdout
+
+
+def test_c_vectors(quat_test):
+    subprocess.run([quat_test, VECTORS_PATH], check=True, capture_output=True)
+
+
+def test_c_compress(quat_test):
+    rng = np.random.default_rng(2)
+    quaternions = np.concatenate([special_quaternions(), boundary_quaternions(), random_quaternions(rng, 1000000)])
+
+    c_codes = np.frombuffer(run_c(quat_test, "-compress", quaternions.astype("<f4")), dtype="<u4")
+
+    # The scalar implementation is too slow for all inputs, compare it on a subset and the round trip on all
+    subset = np.concatenate([np.arange(len(special_quaternions()) + len(boundary_quaternions())), rng.integers(0, len(quaternions), 20000)])
+    codes = np.array([quatcompress(quaternions[i]) for i in subset], dtype=np.uint32)
+    np.testing.assert_array_equal(c_codes[subset], codes)
+
+    dot = np.abs(np.sum(quaternions * quatdecompress_batch(c_codes), axis=1))
+    assert dot.min() > 1 - 2e-5
+
+
+def test_c_decompress(quat_test):
+    rng = np.random.default_rng(3)
+    codes = np.concatenate([slot_codes(), sum_witness_codes(rng), rng.integers(0, 1 << 32, 1000000, dtype=np.uint32)])
+
+    c_quaternions = np.frombuffer(run_c(quat_test, "-decompress", codes.astype("<u4")), dtype="<f4").reshape(-1, 4)
+    assert_bit_exact(c_quaternions, quatdecompress_batch(codes))
+
+
+if __name__ == "__main__":
+    with open(VECTORS_PATH, "w") as f:
+        f.write(format_vectors())
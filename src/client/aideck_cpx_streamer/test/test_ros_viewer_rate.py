@@ -0,0 +1,141 @@
+#
+# test_ros_viewer_rate.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+# 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# 
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import ctypes
+import time
+
+import pytest
+
+rclpy = pytest.importorskip('rclpy')
+
+from sensor_msgs.msg import Image  # noqa: E402
+
+from aideck_cpx_streamer.cpx import StreamerClient, StreamerMetadata  # noqa: E402
+from aideck_cpx_streamer.cpx.cpx import CPXFunction, CPXHeader, CPXPacket, CPXTarget  # noqa: E402
+from aideck_cpx_streamer.cpx.streamer import (  # noqa: E402
+    StreamerBegin, StreamerCommand, StreamerData, StreamerHeader, StreamerType
+)
+from aideck_cpx_streamer.cpx.transport import Transport  # noqa: E402
+from aideck_cpx_streamer.ros_viewer import ROSViewer  # noqa: E402
+
+FRAME_WIDTH = 160
+FRAME_HEIGHT = 160
+FRAME_RATE = 30.0
+TEST_DURATION = 5.0
+
+
+class FakeTransport(Transport):
+    """Transport that generates streamer frames at a fixed rate, as GAP8 would."""
+
+    MAX_FRAME_LENGTH = 4088
+
+    def __init__(self, fps):
+        super().__init__()
+        self.period = 1.0 / fps
+        self.n_sent = 0
+
+    @property
+    def max_frame_length(self) -> int:
+        return self.MAX_FRAME_LENGTH
+
+    def send(self, data: CPXPacket):
+        pass
+
+    def frame_buffer(self, frame_id):
+        metadata = StreamerMetadata()
+        metadata.metadata_version = StreamerMetadata.METADATA_VERSION
+        metadata.frame_width = FRAME_WIDTH
+        metadata.frame_height = FRAME_HEIGHT
+        metadata.frame_bpp = 1
+        metadata.frame_id = frame_id % 256
+        metadata.frame_timestamp = int(frame_id * self.period * 10**6)
+
+        pixels = bytes((frame_id + i) % 256 for i in range(FRAME_WIDTH)) * FRAME_HEIGHT
+        return bytes(metadata) + pixels
+
+    def frame_packets(self, buffer):
+        header = CPXHeader(destination=CPXTarget.WIFI_HOST, function=CPXFunction.STREAMER, source=CPXTarget.GAP)
+        max_payload = self.max_frame_length - ctypes.sizeof(CPXHeader)
+
+        offset = 0
+        while offset < len(buffer):
+            if offset == 0:
+                head = bytes(StreamerHeader(command=StreamerCommand.BUFFER_BEGIN)) + \
+                       bytes(StreamerBegin(type=StreamerType.IMAGE, size=len(buffer), checksum=0))
+            else:
+                head = bytes(StreamerHeader(command=StreamerCommand.BUFFER_DATA)) + bytes(StreamerData())
+
+            segment = buffer[offset:offset + max_payload - len(head)]
+            offset += len(segment)
+
+            yield CPXPacket(header, head + segment)
+
+    def receive(self):
+        next_frame = time.monotonic()
+
+        while self.ok:
+            for packet in self.frame_packets(self.frame_buffer(self.n_sent)):
+                yield packet
+            self.n_sent += 1
+
+            next_frame += self.period
+            time.sleep(max(0.0, next_frame - time.monotonic()))
+
+
+def test_sustained_publish_rate():
+    rclpy.init()
+
+    transport = FakeTransport(FRAME_RATE)
+    client = StreamerClient(transport=transport, log_fn=lambda *args, **kwargs: None)
+
+    viewer = None
+    listener = rclpy.create_node('ros_viewer_rate_listener')
+    received = []
+    listener.create_subscription(Image, 'image_raw', lambda msg: received.append(time.monotonic()), 10)
+
+    try:
+        viewer = ROSViewer(client=client)
+
+        executor = rclpy.executors.MultiThreadedExecutor()
+        executor.add_node(viewer)
+        executor.add_node(listener)
+
+        end = time.monotonic() + TEST_DURATION
+        while time.monotonic() < end:
+            executor.spin_once(timeout_sec=0.1)
+
+        # Skip the first second to measure the sustained rate after start-up
+        steady = [t for t in received if t >= received[0] + 1.0] if received else []
+        assert len(steady) >= 2, 'No images published'
+
+        publish_rate = (len(steady) - 1) / (steady[-1] - steady[0])
+        print(f'Sustained publish rate: {publish_rate:.1f} fps ({transport.n_sent} frames sent)')
+
+        assert publish_rate >= 0.9 * FRAME_RATE
+    finally:
+        client.shutdown()
+        if viewer is not None:
+            viewer.destroy_node()
+        listener.destroy_node()
+        rclpy.shutdown()
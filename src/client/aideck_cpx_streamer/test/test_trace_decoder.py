@@ -0,0 +1,94 @@
+#
+# test_trace_decoder.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+import pytest
+
+from aideck_cpx_streamer.cpx.cpx import CPXFunction, CPXHeader, CPXPacket, CPXTarget
+from aideck_cpx_streamer.cpx.trace import (
+    TraceDecoder, TraceEvent, TraceEventId, TraceState, TraceStreamHeader
+)
+
+COUNTER_FREQ = 100e6
+
+
+def trace_packet(core_id, sequence, events, dropped=0, source=CPXTarget.ESP32):
+    header = CPXHeader(destination=CPXTarget.WIFI_HOST, function=CPXFunction.TRACE, source=source)
+    trace_header = TraceStreamHeader(core_id=core_id, n_events=len(events), sequence=sequence, dropped=dropped)
+    payload = bytes(trace_header) + b''.join(bytes(TraceEvent(*e)) for e in events)
+    return CPXPacket(header, payload)
+
+
+def sync_events(time_us):
+    return [
+        (TraceEventId.SYNC, TraceState.BEGIN, time_us & 0xffff, 12345),
+        (TraceEventId.SYNC, TraceState.END, time_us >> 16, 0),
+    ]
+
+
+def test_timeline_and_intervals():
+    decoder = TraceDecoder(counter_freq={CPXTarget.ESP32: COUNTER_FREQ})
+
+    # Events before the first SYNC cannot be placed on the timeline
+    events = [(TraceEventId.CPX_TCP_SEND, TraceState.BEGIN, 1, 10)]
+    events += sync_events(3_000_000)
+    events += [
+        (TraceEventId.CPX_TCP_SEND, TraceState.BEGIN, 7, 1000),
+        (TraceEventId.CPX_TCP_SEND, TraceState.END, 0, 51000),
+    ]
+    new_events, intervals = decoder.feed(trace_packet(0, 0, events))
+
+    assert len(new_events) == 3
+    assert len(intervals) == 1
+    assert intervals[0].context == 7
+    assert intervals[0].begin == pytest.approx(3.0 + 1000 / COUNTER_FREQ)
+    assert intervals[0].end - intervals[0].begin == pytest.approx(50000 / COUNTER_FREQ)
+
+
+def test_counter_wraparound():
+    decoder = TraceDecoder(counter_freq={CPXTarget.ESP32: COUNTER_FREQ})
+
+    events = sync_events(0) + [
+        (TraceEventId.CPX_SPI_TRANSFER, TraceState.BEGIN, 0, 0xffffff00),
+        (TraceEventId.CPX_SPI_TRANSFER, TraceState.END, 0, 0x00000100),
+    ]
+    _, intervals = decoder.feed(trace_packet(1, 0, events))
+
+    assert intervals[0].end - intervals[0].begin == pytest.approx(0x200 / COUNTER_FREQ)
+
+
+def test_lost_packets_and_dropped_events():
+    decoder = TraceDecoder(counter_freq={CPXTarget.GAP: COUNTER_FREQ})
+
+    decoder.feed(trace_packet(0, 0, sync_events(0), source=CPXTarget.GAP))
+    decoder.feed(trace_packet(0, 3, [], dropped=5, source=CPXTarget.GAP))
+    decoder.feed(trace_packet(0, 4, [], dropped=9, source=CPXTarget.GAP))
+
+    assert decoder.n_lost_packets == 2
+    assert decoder.n_dropped == 9
+
+
+def test_ignores_other_functions():
+    decoder = TraceDecoder()
+    header = CPXHeader(destination=CPXTarget.WIFI_HOST, function=CPXFunction.STREAMER, source=CPXTarget.GAP)
+    assert decoder.feed(CPXPacket(header, b'\x00' * 16)) == ([], [])
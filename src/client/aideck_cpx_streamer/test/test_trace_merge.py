@@ -0,0 +1,131 @@
+#
+# test_trace_merge.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# This software is based on the following publication:
+#    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+#    Application Framework for AI-based Autonomous Nanorobotics"
+# We kindly ask for a citation if you use in academic work.
+#
+
+
+import json
+
+import numpy as np
+import pytest
+
+from aideck_cpx_streamer.cpx.cpx import CPXTarget
+from aideck_cpx_streamer.cpx.trace import TimelineEvent, TraceEventId, TraceState
+from aideck_cpx_streamer.trace_merge import (
+    chrome_trace, clock_samples, fit_clocks, read_trace_csv
+)
+
+# NINA clock runs 80ppm fast and is 12.345s ahead of GAP8
+DRIFT = 80e-6
+OFFSET = 12.345
+
+
+def nina_clock(local):
+    return (1 + DRIFT) * local + OFFSET
+
+
+def gap_event(t, event, state, context):
+    return TimelineEvent(t, CPXTarget.GAP, 0, event, state, context)
+
+
+def synthetic_pings(n=200, period=0.1, delay=50e-6, remote_clock=nina_clock, remote_base_us=0, seed=1):
+    rng = np.random.default_rng(seed)
+    events = []
+
+    for seq in range(n):
+        t0 = 1.0 + seq * period
+        t_rx = t0 + delay + rng.uniform(0, 10e-6)
+        t_tx = t_rx + rng.uniform(20e-6, 200e-6)
+        t3 = t_tx + delay + rng.uniform(0, 10e-6)
+
+        # Some pongs are delayed by queueing on the way back
+        if seq % 10 == 3:
+            t3 += rng.uniform(1e-3, 5e-3)
+
+        rx_us = int(round(remote_clock(t_rx) * 1e6)) + remote_base_us
+        tx_us = int(round(remote_clock(t_tx) * 1e6)) + remote_base_us
+        remote_us = (rx_us + (tx_us - rx_us) // 2) & 0xffffffff
+
+        events += [
+            gap_event(t0, TraceEventId.CLOCK_SYNC_NINA, TraceState.BEGIN, seq & 0xffff),
+            gap_event(t3, TraceEventId.CLOCK_SYNC_NINA, TraceState.END, seq & 0xffff),
+            gap_event(t3, TraceEventId.CLOCK_REMOTE_NINA, TraceState.BEGIN, remote_us & 0xffff),
+            gap_event(t3, TraceEventId.CLOCK_REMOTE_NINA, TraceState.END, remote_us >> 16),
+        ]
+
+    return events
+
+
+def write_csv(path, events):
+    with open(path, "w") as f:
+        f.write("timestamp,source,core_id,event,state,context\n")
+        for e in events:
+            f.write(f"{e.timestamp:.9f},{e.source.name},{e.core_id},{TraceEventId(e.event).name},{TraceState(e.state).name},{e.context}\n")
+
+
+def test_fit_recovers_offset_and_drift(tmp_path):
+    path = tmp_path / "trace.csv"
+    write_csv(path, synthetic_pings())
+
+    fits = fit_clocks(read_trace_csv(path))
+
+    assert CPXTarget.STM32 not in fits
+    fit = fits[CPXTarget.ESP32]
+    assert fit.drift_ppm == pytest.approx(DRIFT * 1e6, abs=1)
+    assert fit.n_inliers >= 150
+
+    for local in [1.0, 10.0, 20.0]:
+        assert fit.to_remote(local) == pytest.approx(nina_clock(local), abs=20e-6)
+
+
+def test_remote_timestamp_wraparound():
+    # Start the remote microsecond counter right before its 32-bit overflow
+    base_us = (1 << 32) - int(round(nina_clock(5.0) * 1e6))
+    samples = clock_samples(synthetic_pings(remote_base_us=base_us), CPXTarget.ESP32)
+
+    remote = np.array([s.remote for s in samples])
+    assert np.all(np.diff(remote) > 0)
+
+
+def test_chrome_trace_on_gap_timeline():
+    events = synthetic_pings()
+    events += [
+        TimelineEvent(nina_clock(5.0), CPXTarget.ESP32, 1, TraceEventId.CPX_TCP_SEND, TraceState.BEGIN, 7),
+        TimelineEvent(nina_clock(5.002), CPXTarget.ESP32, 1, TraceEventId.CPX_TCP_SEND, TraceState.END, 0),
+        TimelineEvent(6.0, CPXTarget.GAP, 0, 0x01, TraceState.MARKER, 3),
+    ]
+
+    trace = json.loads(json.dumps(chrome_trace(events, fit_clocks(events))))
+    by_name = {e["name"]: e for e in trace["traceEvents"] if e["ph"] != "M"}
+
+    tcp = by_name["CPX_TCP_SEND"]
+    assert tcp["ph"] == "X"
+    assert tcp["pid"] == CPXTarget.ESP32 and tcp["tid"] == 1
+    assert tcp["ts"] == pytest.approx(5.0e6, abs=20)
+    assert tcp["dur"] == pytest.approx(2e3, abs=1)
+
+    assert by_name["0x01"]["ph"] == "i"
+    assert by_name["0x01"]["ts"] == pytest.approx(6.0e6)
+
+    # Clock sync exchanges are kept, the raw remote timestamps are not
+    assert "CLOCK_SYNC_NINA" in by_name
+    assert "CLOCK_REMOTE_NINA" not in by_name
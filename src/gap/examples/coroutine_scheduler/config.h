@@ -0,0 +1,44 @@
+/*
+ * config.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+// Enable debug prints in coroutine.h
+// #define CO_VERBOSE
+
+// Record run time and latency of each coroutine
+#define CO_STATS
+
+// Simulated frame processing: coroutines, rows per frame and pixels per row. Each worker
+// yields after every row, like camera_crop_task
+#define SCHED_WORKERS       (6)
+#define SCHED_ROWS          (244)
+#define SCHED_COLS          (324)
+
+// Simulated UART messages: period [us] and messages measured with each priority
+#define SCHED_RX_PERIOD_US  (1000)
+#define SCHED_RX_MESSAGES   (500)
+
+#endif /* __CONFIG_H__ */
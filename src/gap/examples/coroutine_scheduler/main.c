@@ -0,0 +1,205 @@
+/*
+ * main.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Priority scheduling of coroutines (see coroutine.h). SCHED_WORKERS coroutines process frames
+ * row by row and yield after each row, like camera_crop_task, while a handler coroutine waits for
+ * messages that arrive every SCHED_RX_PERIOD_US, like uart_protocol_task. A timer task stands in
+ * for the UART driver, so that the example runs on GVSOC without anything connected to the UART.
+ *
+ * The handler runs first at CO_PRIORITY_NORMAL, then at CO_PRIORITY_HIGH. At the same priority,
+ * it is resumed after every worker that yielded before it; at a higher priority it is resumed
+ * first in the next batch of the scheduler, so its latency does not depend on the number of
+ * workers.
+ */
+
+#include "config.h"
+#include "coroutine.h"
+
+#include <pmsis.h>
+
+typedef struct worker_s {
+    co_fn_ctx_t ctx;
+    int id;
+    int row;
+    uint32_t frames;
+    uint32_t checksum;
+} worker_t;
+
+typedef struct rx_s {
+    co_fn_ctx_t ctx;
+    co_event_t event;
+    pi_task_t timer_task;
+
+    uint32_t arrival;           // Timestamp of the last message [cycles]
+    uint32_t n_messages;
+    uint64_t latency;           // From arrival to handling [cycles]
+    uint32_t max_latency;
+} rx_t;
+
+static PI_L2 uint8_t frame[SCHED_ROWS][SCHED_COLS];
+static PI_L2 uint8_t output[SCHED_WORKERS][SCHED_COLS];
+
+static worker_t workers[SCHED_WORKERS];
+static rx_t rx;
+
+// 3x3 box filter of a row
+static void worker_process_row(worker_t *worker) {
+    int row = worker->row;
+    const uint8_t *above = frame[row > 0 ? row - 1 : row];
+    const uint8_t *center = frame[row];
+    const uint8_t *below = frame[row < SCHED_ROWS - 1 ? row + 1 : row];
+    uint8_t *out = output[worker->id];
+
+    for (int col = 1; col < SCHED_COLS - 1; col++) {
+        uint32_t sum = 0;
+        for (int k = -1; k <= 1; k++) {
+            sum += above[col + k] + center[col + k] + below[col + k];
+        }
+
+        out[col] = sum / 9;
+        worker->checksum += out[col];
+    }
+}
+
+CO_FN_BEGIN(worker_task, worker_t *, worker)
+{
+    while (true) {
+        for (worker->row = 0; worker->row < SCHED_ROWS; worker->row++) {
+            worker_process_row(worker);
+            CO_YIELD();
+        }
+
+        worker->frames++;
+    }
+}
+CO_FN_END()
+
+// Stands in for the UART driver completing a read
+static void rx_timer_callback(void *arg) {
+    rx_t *rx = (rx_t *)arg;
+
+    rx->arrival = pi_perf_read(PI_PERF_CYCLES);
+    co_event_push(&rx->event);
+}
+
+CO_FN_BEGIN(rx_task, rx_t *, rx)
+{
+    while (rx->n_messages < SCHED_RX_MESSAGES) {
+        co_event_init(&rx->event);
+        pi_task_push_delayed_us(pi_task_callback(&rx->timer_task, rx_timer_callback, rx), SCHED_RX_PERIOD_US);
+        CO_WAIT(&rx->event);
+
+        uint32_t latency = pi_perf_read(PI_PERF_CYCLES) - rx->arrival;
+        rx->latency += latency;
+        if (latency > rx->max_latency) {
+            rx->max_latency = latency;
+        }
+
+        rx->n_messages++;
+    }
+}
+CO_FN_END()
+
+static void run_phase(co_priority_t priority, const char *name) {
+    uint32_t freq = pi_freq_get(PI_FREQ_DOMAIN_FC) / 1000000;
+
+    rx = (rx_t){0};
+    co_fn_set_priority(&rx.ctx, priority);
+
+    for (int i = 0; i < SCHED_WORKERS; i++) {
+        co_fn_stats_reset(&workers[i].ctx);
+        workers[i].frames = 0;
+    }
+    co_sched_stats_reset();
+
+    pi_task_t done;
+    co_fn_push_start(&rx.ctx, rx_task, &rx, pi_task_block(&done));
+    pi_task_wait_on(&done);
+
+    uint32_t frames = 0, worker_max_run = 0, worker_max_latency = 0;
+    for (int i = 0; i < SCHED_WORKERS; i++) {
+        const co_fn_stats_t *stats = &workers[i].ctx.stats;
+        frames += workers[i].frames;
+
+        if (stats->max_run_cycles > worker_max_run) {
+            worker_max_run = stats->max_run_cycles;
+        }
+        if (stats->max_latency_cycles > worker_max_latency) {
+            worker_max_latency = stats->max_latency_cycles;
+        }
+    }
+
+    const co_fn_stats_t *rx_stats = &rx.ctx.stats;
+    const co_sched_stats_t *sched_stats = co_sched_get_stats();
+
+    printf("rx %s priority, %lu messages:\n", name, rx.n_messages);
+    printf(
+        "  arrival to handling: %lu us avg, %lu us max\n",
+        (uint32_t)(rx.latency / rx.n_messages / freq), rx.max_latency / freq
+    );
+    printf(
+        "  ready to resume:     %lu us avg, %lu us max\n",
+        (uint32_t)(rx_stats->latency_cycles / rx_stats->n_resumes / freq), rx_stats->max_latency_cycles / freq
+    );
+    printf(
+        "workers: %lu frames, %lu us max per row, %lu us max ready to resume\n",
+        frames, worker_max_run / freq, worker_max_latency / freq
+    );
+    printf(
+        "scheduler: %lu batches, %lu resumes and %lu us max per batch\n",
+        sched_stats->n_batches, sched_stats->max_batch_resumes, sched_stats->max_batch_cycles / freq
+    );
+
+    // At a higher priority than the workers, the handler is resumed before any of them
+    if (priority > CO_PRIORITY_NORMAL && rx_stats->max_latency_cycles > worker_max_run) {
+        printf("rx handler waited for a worker\n");
+        pmsis_exit(1);
+    }
+}
+
+void main_task() {
+    for (int row = 0; row < SCHED_ROWS; row++) {
+        for (int col = 0; col < SCHED_COLS; col++) {
+            frame[row][col] = row + col;
+        }
+    }
+
+    co_stats_start();
+
+    for (int i = 0; i < SCHED_WORKERS; i++) {
+        workers[i].id = i;
+        co_fn_push_start(&workers[i].ctx, worker_task, &workers[i], NULL);
+    }
+
+    run_phase(CO_PRIORITY_NORMAL, "normal");
+    run_phase(CO_PRIORITY_HIGH, "high");
+
+    pmsis_exit(0);
+}
+
+int main(void) {
+    printf("\n\n\t *** PMSIS Kickoff ***\n\n");
+    return pmsis_kickoff((void *)main_task);
+}
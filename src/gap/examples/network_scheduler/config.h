@@ -0,0 +1,59 @@
+/*
+ * config.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+/************************** GENERAL SETTINGS **************************/
+#define VERBOSE
+
+/*********************** NETWORK SETTINGS ****************************/
+
+// Disable network debug prints
+#define NETWORK_VERBOSE (0)
+
+/******************* NETWORK SCHEDULER SETTINGS **********************/
+
+// Input frames, submitted at a fixed rate as if coming from the camera
+#define SCHEDULER_BENCH_FRAMES       (24)
+#define SCHEDULER_BENCH_FRAME_PERIOD (50000) // [us]
+
+// L2 available to the networks' intermediate buffers
+#define SCHEDULER_BENCH_L2_BUDGET    (360000) // [bytes]
+
+// Fast model: every frame, high priority
+#define SCHEDULER_BENCH_FAST_PERIOD   (1)
+#define SCHEDULER_BENCH_FAST_PRIORITY (1)
+
+// Slow model: every 4 frames, low priority
+#define SCHEDULER_BENCH_SLOW_PERIOD   (4)
+#define SCHEDULER_BENCH_SLOW_PHASE    (1)
+#define SCHEDULER_BENCH_SLOW_PRIORITY (0)
+
+/**************************** SOC SETTINGS ****************************/
+#define SOC_VOLTAGE                 (1200)
+#define SOC_FREQ_FC                 (246000000)
+#define SOC_FREQ_CL                 (175000000)
+
+#endif /* __CONFIG_H__ */
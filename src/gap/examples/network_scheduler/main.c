@@ -0,0 +1,161 @@
+/*
+ * main.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "config.h"
+#include "cluster.h"
+#include "coroutine.h"
+#include "network_scheduler.h"
+#include "soc.h"
+#include "time.h"
+
+#include "mem.h"
+#include "network.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+// Runs two instances of Frontnet on the same frames at different rates and priorities, as the
+// network scheduler would run e.g. a detector and a pose regressor, and reports the latency of
+// each model. Each output is checked against a standalone run of the network on the same input,
+// to verify that the models do not corrupt each other through the shared L2 arena. Run on GVSOC
+// for cycle-accurate, repeatable results.
+
+#define N_FRAME_BUFFERS (2)
+
+static pi_device_t cluster;
+static network_scheduler_t scheduler;
+
+static network_model_t fast_model;
+static network_model_t slow_model;
+
+static uint8_t *frame_buffers[N_FRAME_BUFFERS];
+static pi_task_t frame_done[N_FRAME_BUFFERS];
+
+static float reference_output[NETWORK_OUTPUT_COUNT];
+static int mismatches = 0;
+
+CO_FN_BEGIN(model_callback, network_model_t *, model)
+{
+    if (memcmp(model->output, reference_output, sizeof(reference_output)) != 0) {
+        printf("[%s] frame %d: output mismatch\n", model->config.name, model->frame_id);
+        mismatches++;
+    }
+}
+CO_FN_END()
+
+static void load_input(void *input) {
+    void *ram_input = ram_malloc(NETWORK_INPUT_SIZE);
+    load_file_to_ram(ram_input, "inputs.hex");
+    ram_read(input, ram_input, NETWORK_INPUT_SIZE);
+    ram_free(ram_input, NETWORK_INPUT_SIZE);
+}
+
+static void run_reference(void *l2_buffer, size_t l2_buffer_size) {
+    pi_task_t network_done;
+
+    // l2_buffer is the arena of the scheduler, which is idle
+    uint32_t start = time_get_us();
+    network_run_async(&network_frontnet, frame_buffers[0], l2_buffer, l2_buffer, l2_buffer_size, &cluster, NULL, pi_task_block(&network_done));
+    pi_task_wait_on(&network_done);
+    uint32_t latency = time_get_us() - start;
+
+    network_dequantize_output(&network_frontnet, l2_buffer, reference_output);
+    printf("Standalone %s:\t%d us, %d cycles\n\n", network_frontnet.name, latency, network_frontnet.state->cycles);
+}
+
+void main_task() {
+    soc_init();
+    cluster_init(&cluster);
+    mem_init();
+
+    network_scheduler_init(&scheduler, &cluster, SCHEDULER_BENCH_L2_BUDGET);
+
+    int status = network_scheduler_add_model(&scheduler, &fast_model, &(network_model_config_t){
+        .name = "frontnet-fast",
+        .network = &network_frontnet,
+        .priority = SCHEDULER_BENCH_FAST_PRIORITY,
+        .period = SCHEDULER_BENCH_FAST_PERIOD,
+        .phase = 0,
+        .callback = model_callback,
+    });
+    status = status || network_scheduler_add_model(&scheduler, &slow_model, &(network_model_config_t){
+        .name = "frontnet-slow",
+        .network = &network_frontnet,
+        .priority = SCHEDULER_BENCH_SLOW_PRIORITY,
+        .period = SCHEDULER_BENCH_SLOW_PERIOD,
+        .phase = SCHEDULER_BENCH_SLOW_PHASE,
+        .callback = model_callback,
+    });
+    status = status || network_scheduler_start(&scheduler);
+    if (status) {
+        pmsis_exit(-1);
+    }
+
+    for (int i = 0; i < N_FRAME_BUFFERS; i++) {
+        frame_buffers[i] = pi_l2_malloc(NETWORK_INPUT_SIZE);
+        if (!frame_buffers[i]) {
+            printf("Frame buffer allocation failed\n");
+            pmsis_exit(-1);
+        }
+
+        load_input(frame_buffers[i]);
+        pi_task_block(&frame_done[i]);
+        pi_task_push(&frame_done[i]);
+    }
+
+    run_reference(scheduler.l2_arena, scheduler.l2_arena_size);
+
+    uint32_t next_frame = time_get_us();
+    for (int frame = 0; frame < SCHEDULER_BENCH_FRAMES; frame++) {
+        int buffer = frame % N_FRAME_BUFFERS;
+
+        // Like the camera, a buffer can be reused only after all models have consumed it
+        pi_task_wait_on(&frame_done[buffer]);
+
+        int32_t wait = next_frame - time_get_us();
+        if (wait > 0) {
+            pi_time_wait_us(wait);
+        }
+        next_frame += SCHEDULER_BENCH_FRAME_PERIOD;
+
+        network_scheduler_submit(&scheduler, frame_buffers[buffer], pi_task_block(&frame_done[buffer]));
+    }
+
+    while (!network_scheduler_is_idle(&scheduler)) {
+        pi_yield();
+    }
+
+    printf("\n%d frames every %d us\n", SCHEDULER_BENCH_FRAMES, SCHEDULER_BENCH_FRAME_PERIOD);
+    network_scheduler_print_stats(&scheduler);
+    printf("\n%s\n", mismatches ? "MISMATCH" : "OK");
+
+    pmsis_exit(mismatches ? 1 : 0);
+}
+
+int main(void) {
+    printf("\n\n\t *** PMSIS Kickoff ***\n\n");
+    return pmsis_kickoff((void *)main_task);
+}
@@ -0,0 +1,260 @@
+/*
+ * test_preprocess.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "preprocess_kernels.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Host-side bit-exactness test of the preprocessing kernels. Each operation is checked
+// against a straightforward per-pixel implementation of the same fixed-point formulas,
+// while reproducing the band-wise in-place processing performed by the cluster.
+
+#define BAND_ROWS (4)
+
+static int n_failures = 0;
+
+static void fill_test_image(uint8_t *buffer, int width, int height, uint32_t seed) {
+    uint32_t state = seed;
+
+    for (int i = 0; i < width * height; i++) {
+        state = state * 1664525 + 1013904223;
+        buffer[i] = (i % width + 2 * (i / width) + (state >> 28)) & 0xff;
+    }
+}
+
+// Source pixel and Q8 weight of output pixel i, following the documented formulas
+static void reference_coord(int src_size, int dst_size, int i, preprocess_resize_e resize, int *index, int *weight) {
+    int64_t scale = ((int64_t)src_size << 16) / dst_size;
+    int64_t center = i * scale + scale / 2;
+
+    if (resize == PREPROCESS_RESIZE_NEAREST) {
+        *index = center >> 16;
+        *weight = 0;
+        return;
+    }
+
+    int64_t position = center - 32768 < 0 ? 0 : center - 32768;
+    *index = position >> 16;
+    *weight = (position >> 8) & 0xff;
+}
+
+static uint8_t reference_pixel(const preprocess_config_t *config, const uint8_t *src, int x, int y) {
+    int sx, wx, sy, wy;
+    reference_coord(config->crop_width, config->dst_width, x, config->resize, &sx, &wx);
+    reference_coord(config->crop_height, config->dst_height, y, config->resize, &sy, &wy);
+
+    int sx1 = sx + 1 < config->crop_width ? sx + 1 : sx;
+    int sy1 = sy + 1 < config->crop_height ? sy + 1 : sy;
+
+    #define P(x, y) src[(config->crop_top + (y)) * config->src_width + config->crop_left + (x)]
+    uint32_t top = P(sx, sy) * (256 - wx) + P(sx1, sy) * wx;
+    uint32_t bottom = P(sx, sy1) * (256 - wx) + P(sx1, sy1) * wx;
+    #undef P
+
+    uint8_t value = (top * (256 - wy) + bottom * wy + 32768) >> 16;
+    return config->lut ? config->lut[value] : value;
+}
+
+static void reference_preprocess(const preprocess_config_t *config, const uint8_t *src, uint8_t *dst) {
+    for (int y = 0; y < config->dst_height; y++) {
+        for (int x = 0; x < config->dst_width; x++) {
+            dst[y * config->dst_width + x] = reference_pixel(config, src, x, y);
+        }
+    }
+}
+
+// Same schedule as preprocess_run_core in preprocess.c, with cores executed one after the other
+static void banded_preprocess(const preprocess_config_t *config, uint8_t *buffer, int n_cores) {
+    preprocess_coord_t *x_coords = malloc(config->dst_width * sizeof(preprocess_coord_t));
+    uint8_t *bands = malloc(n_cores * BAND_ROWS * config->dst_width);
+
+    int cols_per_core = (config->dst_width + n_cores - 1) / n_cores;
+    for (int core_id = 0; core_id < n_cores; core_id++) {
+        int col_start = core_id * cols_per_core < config->dst_width ? core_id * cols_per_core : config->dst_width;
+        int col_end = col_start + cols_per_core < config->dst_width ? col_start + cols_per_core : config->dst_width;
+        preprocess_kernel_coords(config, x_coords, col_start, col_end);
+    }
+
+    for (int band_start = 0; band_start < config->dst_height; band_start += n_cores * BAND_ROWS) {
+        for (int core_id = 0; core_id < n_cores; core_id++) {
+            int row_start = band_start + core_id * BAND_ROWS;
+            int row_end = row_start + BAND_ROWS;
+            row_start = row_start < config->dst_height ? row_start : config->dst_height;
+            row_end = row_end < config->dst_height ? row_end : config->dst_height;
+
+            preprocess_kernel_rows(config, x_coords, buffer, bands + core_id * BAND_ROWS * config->dst_width, row_start, row_end);
+        }
+
+        for (int core_id = 0; core_id < n_cores; core_id++) {
+            int row_start = band_start + core_id * BAND_ROWS;
+            if (row_start >= config->dst_height) {
+                break;
+            }
+
+            int n_rows = config->dst_height - row_start < BAND_ROWS ? config->dst_height - row_start : BAND_ROWS;
+            memcpy(buffer + row_start * config->dst_width, bands + core_id * BAND_ROWS * config->dst_width, n_rows * config->dst_width);
+        }
+    }
+
+    free(bands);
+    free(x_coords);
+}
+
+static void check(const char *name, const preprocess_config_t *config) {
+    size_t src_size = config->src_width * config->src_height;
+    size_t dst_size = config->dst_width * config->dst_height;
+
+    uint8_t *src = malloc(src_size);
+    uint8_t *expected = malloc(dst_size);
+    uint8_t *buffer = malloc(src_size);
+
+    fill_test_image(src, config->src_width, config->src_height, config->src_width * 31 + config->dst_width);
+    reference_preprocess(config, src, expected);
+
+    static const int core_counts[] = {1, 3, 8};
+    for (size_t i = 0; i < sizeof(core_counts) / sizeof(core_counts[0]); i++) {
+        memcpy(buffer, src, src_size);
+        banded_preprocess(config, buffer, core_counts[i]);
+
+        if (memcmp(buffer, expected, dst_size) != 0) {
+            printf("FAIL %-14s %3dx%-3d -> %3dx%-3d on %d cores\n",
+                name, config->crop_width, config->crop_height, config->dst_width, config->dst_height, core_counts[i]);
+            n_failures++;
+            goto cleanup;
+        }
+    }
+
+    printf("PASS %-14s %3dx%-3d -> %3dx%-3d\n", name, config->crop_width, config->crop_height, config->dst_width, config->dst_height);
+
+cleanup:
+    free(buffer);
+    free(expected);
+    free(src);
+}
+
+static preprocess_config_t make_config(int dst_width, int dst_height, preprocess_resize_e resize, const uint8_t *lut) {
+    // QVGA capture with the default crop, as in camera_task
+    return (preprocess_config_t){
+        .src_width = 324, .src_height = 242,
+        .crop_left = 2, .crop_top = 2, .crop_width = 320, .crop_height = 240,
+        .dst_width = dst_width, .dst_height = dst_height,
+        .resize = resize,
+        .lut = lut,
+    };
+}
+
+// The fixed-point formulas against their exact definitions, where they can be compared
+static void check_semantics(const uint8_t *lut) {
+    preprocess_config_t config = make_config(160, 96, PREPROCESS_RESIZE_NEAREST, NULL);
+    bool ok = true;
+
+    // Nearest: source pixel containing the output pixel center, exact for these ratios
+    for (int x = 0; x < config.dst_width; x++) {
+        preprocess_coord_t c = preprocess_coord(config.crop_width, config.dst_width, x, config.resize);
+        ok = ok && c.index == (2 * x + 1) * config.crop_width / (2 * config.dst_width);
+    }
+
+    // Bilinear: within one LSB of floating-point interpolation
+    config.resize = PREPROCESS_RESIZE_BILINEAR;
+    size_t src_size = config.src_width * config.src_height;
+    uint8_t *src = malloc(src_size);
+    fill_test_image(src, config.src_width, config.src_height, 1);
+
+    uint8_t *buffer = malloc(src_size);
+    memcpy(buffer, src, src_size);
+    banded_preprocess(&config, buffer, 8);
+
+    for (int y = 0; y < config.dst_height && ok; y++) {
+        for (int x = 0; x < config.dst_width && ok; x++) {
+            double fx = fmax((x + 0.5) * config.crop_width / config.dst_width - 0.5, 0.0);
+            double fy = fmax((y + 0.5) * config.crop_height / config.dst_height - 0.5, 0.0);
+            int x0 = (int)fx, y0 = (int)fy;
+            int x1 = x0 + 1 < config.crop_width ? x0 + 1 : x0;
+            int y1 = y0 + 1 < config.crop_height ? y0 + 1 : y0;
+            double ax = fx - x0, ay = fy - y0;
+
+            #define P(x, y) src[(config.crop_top + (y)) * config.src_width + config.crop_left + (x)]
+            double value = (P(x0, y0) * (1 - ax) + P(x1, y0) * ax) * (1 - ay) + (P(x0, y1) * (1 - ax) + P(x1, y1) * ax) * ay;
+            #undef P
+
+            ok = ok && fabs(buffer[y * config.dst_width + x] - value) <= 1.0;
+        }
+    }
+
+    // LUT: gamma curve endpoints and identity
+    uint8_t identity[256];
+    preprocess_lut_gamma(identity, 1.0f);
+    for (int i = 0; i < 256; i++) {
+        ok = ok && identity[i] == i;
+    }
+    ok = ok && lut[0] == 0 && lut[255] == 255;
+
+    printf("%s semantics\n", ok ? "PASS" : "FAIL");
+    n_failures += !ok;
+
+    free(buffer);
+    free(src);
+}
+
+int main(void) {
+    uint8_t lut[256];
+    preprocess_lut_gamma(lut, 0.5f);
+
+    preprocess_config_t crop = make_config(320, 240, PREPROCESS_RESIZE_NEAREST, NULL);
+    check("crop", &crop);
+
+    preprocess_config_t nearest = make_config(160, 96, PREPROCESS_RESIZE_NEAREST, NULL);
+    check("nearest", &nearest);
+
+    preprocess_config_t bilinear = make_config(160, 96, PREPROCESS_RESIZE_BILINEAR, NULL);
+    check("bilinear", &bilinear);
+
+    preprocess_config_t crop_lut = make_config(320, 240, PREPROCESS_RESIZE_NEAREST, lut);
+    check("crop+lut", &crop_lut);
+
+    preprocess_config_t bilinear_lut = make_config(160, 96, PREPROCESS_RESIZE_BILINEAR, lut);
+    check("bilinear+lut", &bilinear_lut);
+
+    // Non-integer ratios, odd sizes and the FULL format
+    preprocess_config_t odd = make_config(107, 61, PREPROCESS_RESIZE_BILINEAR, NULL);
+    check("bilinear", &odd);
+    odd.resize = PREPROCESS_RESIZE_NEAREST;
+    check("nearest", &odd);
+
+    preprocess_config_t full = {
+        .src_width = 324, .src_height = 322,
+        .crop_left = 2, .crop_top = 2, .crop_width = 320, .crop_height = 320,
+        .dst_width = 160, .dst_height = 96,
+        .resize = PREPROCESS_RESIZE_BILINEAR,
+    };
+    check("bilinear", &full);
+
+    check_semantics(lut);
+
+    return n_failures ? 1 : 0;
+}
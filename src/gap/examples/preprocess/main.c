@@ -0,0 +1,163 @@
+/*
+ * main.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "config.h"
+#include "cluster.h"
+#include "preprocess.h"
+#include "soc.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+// Runs each preprocessing operation on the cluster, in-place as in camera_task, and checks
+// that the output is bit-exact with a serial run of the same kernels on the FC. Run on
+// GVSOC for cycle-accurate, repeatable results.
+
+#define SRC_SIZE (PREPROCESS_BENCH_SRC_WIDTH * PREPROCESS_BENCH_SRC_HEIGHT)
+
+typedef struct preprocess_bench_s {
+    const char *name;
+    uint16_t dst_width;
+    uint16_t dst_height;
+    preprocess_resize_e resize;
+    bool lut;
+} preprocess_bench_t;
+
+static const preprocess_bench_t benchmarks[] = {
+    {"crop",         PREPROCESS_BENCH_CROP_WIDTH, PREPROCESS_BENCH_CROP_HEIGHT, PREPROCESS_RESIZE_NEAREST,  false},
+    {"nearest",      PREPROCESS_BENCH_DST_WIDTH,  PREPROCESS_BENCH_DST_HEIGHT,  PREPROCESS_RESIZE_NEAREST,  false},
+    {"bilinear",     PREPROCESS_BENCH_DST_WIDTH,  PREPROCESS_BENCH_DST_HEIGHT,  PREPROCESS_RESIZE_BILINEAR, false},
+    {"crop+lut",     PREPROCESS_BENCH_CROP_WIDTH, PREPROCESS_BENCH_CROP_HEIGHT, PREPROCESS_RESIZE_NEAREST,  true},
+    {"bilinear+lut", PREPROCESS_BENCH_DST_WIDTH,  PREPROCESS_BENCH_DST_HEIGHT,  PREPROCESS_RESIZE_BILINEAR, true},
+};
+
+static pi_device_t cluster;
+static preprocess_t preprocess;
+
+static uint8_t lut[256];
+static preprocess_coord_t x_coords[PREPROCESS_BENCH_SRC_WIDTH];
+
+static uint8_t *src_buffer;
+static uint8_t *work_buffer;
+static uint8_t *ref_buffer;
+
+static void fill_test_image(uint8_t *buffer) {
+    uint32_t state = 0x12345678;
+
+    for (int y = 0; y < PREPROCESS_BENCH_SRC_HEIGHT; y++) {
+        for (int x = 0; x < PREPROCESS_BENCH_SRC_WIDTH; x++) {
+            // Gradient with noise, to exercise both smooth areas and sharp edges
+            state = state * 1664525 + 1013904223;
+            buffer[y * PREPROCESS_BENCH_SRC_WIDTH + x] = (x + 2 * y + (state >> 28)) & 0xff;
+        }
+    }
+}
+
+static uint32_t run_reference(const preprocess_config_t *config) {
+    pi_perf_conf(1 << PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+
+    preprocess_kernel_coords(config, x_coords, 0, config->dst_width);
+    preprocess_kernel_rows(config, x_coords, src_buffer, ref_buffer, 0, config->dst_height);
+
+    pi_perf_stop();
+    return pi_perf_read(PI_PERF_CYCLES);
+}
+
+static bool run_bench(const preprocess_bench_t *bench) {
+    preprocess_config_t config = {
+        .src_width = PREPROCESS_BENCH_SRC_WIDTH,
+        .src_height = PREPROCESS_BENCH_SRC_HEIGHT,
+        .crop_left = PREPROCESS_BENCH_CROP_LEFT,
+        .crop_top = PREPROCESS_BENCH_CROP_TOP,
+        .crop_width = PREPROCESS_BENCH_CROP_WIDTH,
+        .crop_height = PREPROCESS_BENCH_CROP_HEIGHT,
+        .dst_width = bench->dst_width,
+        .dst_height = bench->dst_height,
+        .resize = bench->resize,
+        .lut = bench->lut ? lut : NULL,
+    };
+
+    preprocess_init(&preprocess, &cluster, &config);
+    size_t dst_size = preprocess_get_output_size(&preprocess);
+
+    uint32_t fc_cycles = run_reference(&config);
+    uint32_t cl_cycles = 0;
+    bool exact = true;
+
+    for (int round = 0; round < PREPROCESS_BENCH_ROUNDS; round++) {
+        pi_task_t done_task;
+
+        memcpy(work_buffer, src_buffer, SRC_SIZE);
+        preprocess_run_async(&preprocess, work_buffer, work_buffer, pi_task_block(&done_task));
+        pi_task_wait_on(&done_task);
+
+        cl_cycles += preprocess.cycles;
+        exact = exact && (memcmp(work_buffer, ref_buffer, dst_size) == 0);
+    }
+
+    cl_cycles /= PREPROCESS_BENCH_ROUNDS;
+
+    printf(
+        "%-14s %3dx%-3d  FC serial %8d cycles (%5d.%02d cycles/px)  CL %8d cycles (%5d.%02d cycles/px)  %s\n",
+        bench->name, bench->dst_width, bench->dst_height,
+        fc_cycles, fc_cycles / dst_size, (100 * fc_cycles / dst_size) % 100,
+        cl_cycles, cl_cycles / dst_size, (100 * cl_cycles / dst_size) % 100,
+        exact ? "OK" : "MISMATCH"
+    );
+
+    return exact;
+}
+
+void main_task() {
+    soc_init();
+    cluster_init(&cluster);
+
+    src_buffer = pi_l2_malloc(SRC_SIZE);
+    work_buffer = pi_l2_malloc(SRC_SIZE);
+    ref_buffer = pi_l2_malloc(SRC_SIZE);
+
+    if (!src_buffer || !work_buffer || !ref_buffer) {
+        printf("Buffer allocation failed\n");
+        pmsis_exit(-1);
+    }
+
+    fill_test_image(src_buffer);
+    preprocess_lut_gamma(lut, 0.5f);
+
+    bool exact = true;
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        exact = run_bench(&benchmarks[i]) && exact;
+    }
+
+    pmsis_exit(exact ? 0 : 1);
+}
+
+int main(void) {
+    printf("\n\n\t *** PMSIS Kickoff ***\n\n");
+    return pmsis_kickoff((void *)main_task);
+}
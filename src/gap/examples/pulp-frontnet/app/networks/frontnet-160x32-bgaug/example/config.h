@@ -19,3 +19,6 @@
 
 // Enable or disable verbose network output (default: enabled)
 // #define NETWORK_VERBOSE 1
+
+// Record the per-layer profile, compare the cycles with a build without it to check the overhead
+// #define NETWORK_PROFILE
@@ -18,11 +18,16 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+#include "config.h"
+
 #include "mem.h"
 #include "network.h"
 
 #include "pmsis.h"
 
+#include <string.h>
+
 #define VERBOSE 1
 
 
@@ -59,9 +64,18 @@ int main () {
     Opening of Filesystem and Ram
 */
   mem_init();
-  network_init();
+
+  // Boot time is dominated by loading the weights from the flash
+  uint32_t load_start = pi_time_get_us();
+  network_init(&network_frontnet);
+  uint32_t load_time = pi_time_get_us() - load_start;
+  printf("Weights loaded:\t\t\t%dB in %d us (%d KB/s)\n", network_frontnet.L3_weights_size, load_time, network_frontnet.L3_weights_size * 1000 / (load_time ? load_time : 1));
+
+  network_init(&network_frontnet_unfused);
     
-  size_t l2_buffer_size = NETWORK_L2_BUFFER_SIZE;
+  // The unfused network needs a larger buffer for the output of its first layer
+  size_t l2_buffer_size = network_frontnet_unfused.L2_buffer_size > network_frontnet.L2_buffer_size
+    ? network_frontnet_unfused.L2_buffer_size : network_frontnet.L2_buffer_size;
   void *l2_buffer = pi_l2_malloc(l2_buffer_size);
   printf("Network:\t\t\t%s, %dB @ L2, 0x%08x\n", l2_buffer?"OK":"Failed", l2_buffer_size, l2_buffer);
   if (!l2_buffer) {
@@ -80,10 +94,45 @@ int main () {
   void *ram_input = ram_malloc(input_size);
       load_file_to_ram(ram_input, "inputs.hex");
       ram_read(l2_input, ram_input, NETWORK_INPUT_SIZE);
-      network_run_async(l2_input, l2_input, l2_buffer, l2_buffer_size, 0, &cluster, /* input_done */ NULL, pi_task_block(&network_done));
+
+  // The fused first layer must be bit-exact with the layers generated by DORY
+  NETWORK_OUTPUT_TYPE output_unfused[NETWORK_OUTPUT_COUNT];
+  NETWORK_OUTPUT_TYPE output_fused[NETWORK_OUTPUT_COUNT];
+
+  // Cycles only count the layers, latency also includes the weights copied from L3
+      uint32_t start_unfused = pi_time_get_us();
+      network_run_async(&network_frontnet_unfused, l2_input, output_unfused, l2_buffer, l2_buffer_size, &cluster, /* input_done */ NULL, pi_task_block(&network_done));
       pi_task_wait_on(&network_done);
+      uint32_t latency_unfused = pi_time_get_us() - start_unfused;
+      uint32_t cycles_unfused = network_frontnet_unfused.state->cycles;
+
+      uint32_t start_fused = pi_time_get_us();
+      network_run_async(&network_frontnet, l2_input, output_fused, l2_buffer, l2_buffer_size, &cluster, /* input_done */ NULL, pi_task_block(&network_done));
+      pi_task_wait_on(&network_done);
+      uint32_t latency_fused = pi_time_get_us() - start_fused;
+      uint32_t cycles_fused = network_frontnet.state->cycles;
+      printf("First inference:\t\t%d us after boot\n", pi_time_get_us());
+
+  int bit_exact = memcmp(output_unfused, output_fused, sizeof(output_fused)) == 0;
+  printf("\n%s:\t%d cycles, %d us\n", network_frontnet_unfused.name, cycles_unfused, latency_unfused);
+  printf("%s:\t\t%d cycles (%d%%), %d us\n", network_frontnet.name, cycles_fused, 100 * (int)(cycles_fused - cycles_unfused) / (int)cycles_unfused, latency_fused);
+  printf("Fused output:\t\t\t%s\n", bit_exact ? "bit-exact" : "MISMATCH");
+
+#ifdef NETWORK_PROFILE
+  // Each run samples a different event, the first one was run above
+  for (int i = 1; i < NETWORK_PROFILE_N_EVENTS; i++) {
+    network_run_async(&network_frontnet, l2_input, output_fused, l2_buffer, l2_buffer_size, &cluster, /* input_done */ NULL, pi_task_block(&network_done));
+    pi_task_wait_on(&network_done);
+  }
+
+  printf("\n");
+  network_profile_print(&network_frontnet);
+#endif
 
   ram_free(ram_input, input_size);
   pi_l2_free(l2_input, NETWORK_INPUT_SIZE);
-  network_terminate();
+  network_terminate(&network_frontnet_unfused);
+  network_terminate(&network_frontnet);
+
+  pmsis_exit(bit_exact ? 0 : -1);
 }
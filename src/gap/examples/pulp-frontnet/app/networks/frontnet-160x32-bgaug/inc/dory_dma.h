@@ -22,6 +22,8 @@
 #ifndef _DORY_DMA_H
 #define _DORY_DMA_H
 
+#include <stdint.h>
+
 typedef struct
 {
   void *ext;
@@ -50,5 +52,8 @@ void dory_dma_free(DMA_copy *copy);
 
 void dory_dma_barrier(DMA_copy *copy);
 
+// Cycles spent by core 0 waiting in dory_dma_barrier, only counted with NETWORK_PROFILE
+extern uint32_t dory_dma_wait_cycles;
+
 int dory_dma_allocate();
 #endif
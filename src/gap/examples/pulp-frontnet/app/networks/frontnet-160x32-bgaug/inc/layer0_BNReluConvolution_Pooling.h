@@ -0,0 +1,29 @@
+/*
+ * layer0_BNReluConvolution_Pooling.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ * Alessio Burrello <alessio.burrello@unibo.it>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *               2019-2020 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LAYER0_BNRELUCONVOLUTION_POOLING_H__
+#define __LAYER0_BNRELUCONVOLUTION_POOLING_H__
+
+void  layer0_BNReluConvolution_Pooling(
+  void *args
+);
+
+#endif
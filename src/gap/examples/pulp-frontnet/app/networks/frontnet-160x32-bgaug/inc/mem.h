@@ -23,6 +23,38 @@
 #define __MEM_H__
 
 #include <stddef.h>
+#include <stdint.h>
+
+// Size of the two L2 buffers used to stream data from the flash to L3, the flash read of a chunk
+// overlaps the L3 write of the previous one. Larger chunks amortize the per-transfer overhead,
+// 4-16KB are enough to reach the bus bandwidth.
+#ifndef MEM_LOAD_CHUNK_SIZE
+#define MEM_LOAD_CHUNK_SIZE (8192) // [bytes]
+#endif
+
+/*
+ * FLASH BLOBS
+ *
+ * Several files packed in a single flash file by pack_weights.py, with an index table at its
+ * beginning. Loading the weights of a network from a single blob saves opening a file per layer
+ * and, since the files are stored contiguously, the whole network is loaded with one transfer.
+ */
+
+#define MEM_BLOB_NAME_LEN    (48)
+#define MEM_BLOB_MAX_ENTRIES (16)
+
+typedef struct mem_blob_entry_s {
+  char name[MEM_BLOB_NAME_LEN];
+  uint32_t offset; // [bytes] from the beginning of the data
+  uint32_t size; // [bytes]
+} mem_blob_entry_t;
+
+typedef struct mem_blob_s {
+  void *fd;
+  uint32_t n_entries;
+  uint32_t data_offset; // [bytes] from the beginning of the file
+  mem_blob_entry_t entries[MEM_BLOB_MAX_ENTRIES];
+} mem_blob_t;
 
 void  mem_init();
 struct pi_device *get_ram_ptr();
@@ -36,4 +68,13 @@ void  cl_ram_read(void *dest, void *src, size_t size);
 void  cl_ram_write(void *dest, void *src, size_t size);
 size_t load_file_to_ram(const void *dest, const char *filename);
 
+// Returns 0 on success, -1 if the file cannot be opened or is not a valid blob
+int   mem_blob_open(mem_blob_t *blob, const char *filename);
+void  mem_blob_close(mem_blob_t *blob);
+const mem_blob_entry_t *mem_blob_find(const mem_blob_t *blob, const char *name);
+// Loads size bytes from offset, relative to the beginning of the data, so that contiguous entries
+// can be loaded with a single call
+void  mem_blob_load_to_ram(mem_blob_t *blob, const void *dest, uint32_t offset, size_t size);
+void  mem_blob_load_to_l2(mem_blob_t *blob, void *dest, uint32_t offset, size_t size);
+
 #endif  // __MEM_H__
@@ -22,12 +22,159 @@
 #ifndef __NETWORK_H__
 #define __NETWORK_H__
 
+#include "network_frontnet_plan.h"
+
 #include <pmsis.h>
 
 #include <stddef.h>
+#include <stdint.h>
+
+/*
+ * NETWORK DESCRIPTOR
+ *
+ * The network generated by DORY is described by a constant network_t: the layer table, the
+ * weights files, the L1, L2 and L3 memory requirements and the output quantization. network.c
+ * executes any descriptor, so that an application can run several networks (or several
+ * instances of the same network) on the cluster, one at a time (see network_scheduler.h).
+ * The weights are loaded to L3 once per descriptor and shared by all its instances.
+ */
+
+// Runs that can be sent to the cluster before the previous ones have completed
+#define NETWORK_MAX_QUEUED (2)
+
+typedef struct network_layer_s {
+  const char *name;
+  void (*run)(void *layer_args); // Forked on all cluster cores with a layer_args_t
+  const char *weights_file; // Entry in the network's weights blob, NULL if the layer has no weights
+  void *L2_weights; // Resident in L2 and loaded at network_init, NULL if copied from L3 at each inference
+
+  int weights_size; // [bytes]
+  int activations_size; // [bytes]
+  int activations_out_size; // [bytes]
+  int out_mult;
+  int out_shift;
+  int macs; // Multiply-accumulate operations, for the profile
+
+  uint8_t allocate; // Weights are copied from L3 to L2 before running the layer
+  uint8_t L3_input;
+  uint8_t L3_output;
+  uint8_t branch_input;
+  uint8_t branch_output;
+  uint8_t branch_change;
+  int L3_activations_size; // [bytes]
+  int L3_activations_out_size; // [bytes]
+
+  // Expected checksums, verified with NETWORK_VERBOSE
+  int weights_checksum;
+  int activations_checksum;
+  int activations_out_checksum;
+} network_layer_t;
+
+/*
+ * NETWORK PROFILE
+ *
+ * With NETWORK_PROFILE, network_run_cluster records the performance counters of each layer in
+ * state->profile. Cycles, DMA wait and L3 cycles are measured at every run. The cores count a
+ * single pi_perf event at a time besides the cycles, so the events are multiplexed over
+ * consecutive runs: each event is sampled once every NETWORK_PROFILE_N_EVENTS runs. All counters
+ * refer to core 0, which also drives the DMA.
+ */
+
+typedef enum {
+  NETWORK_PROFILE_ACTIVE_CYCLES,    // PI_PERF_ACTIVE_CYCLES
+  NETWORK_PROFILE_INSTR,            // PI_PERF_INSTR
+  NETWORK_PROFILE_LD_STALL,         // PI_PERF_LD_STALL
+  NETWORK_PROFILE_JR_STALL,         // PI_PERF_JR_STALL
+  NETWORK_PROFILE_IMISS,            // PI_PERF_IMISS
+  NETWORK_PROFILE_LD_EXT_CYC,       // PI_PERF_LD_EXT_CYC
+  NETWORK_PROFILE_ST_EXT_CYC,       // PI_PERF_ST_EXT_CYC
+  NETWORK_PROFILE_TCDM_CONT,        // PI_PERF_TCDM_CONT
+  NETWORK_PROFILE_N_EVENTS
+} network_profile_event_e;
+
+typedef struct network_profile_layer_s {
+  uint32_t cycles; // Execution of the layer on the cluster
+  uint32_t dma_wait_cycles; // Waiting for the L2-L1 transfers of the tiles
+  uint32_t l3_cycles; // Copying the weights from L3 to L2 before the layer
+  uint32_t events[NETWORK_PROFILE_N_EVENTS]; // Last sample of each event
+  uint32_t events_valid; // Bitmask of the events sampled at least once
+} network_profile_layer_t;
+
+// Mutable state of a network, shared by all its instances
+typedef struct network_state_s {
+  int init_count;
+  void *L3_weights;
+  void *L3_input;
+  void *L3_output;
+  void **layers_pointers; // L3 activations of the residual branches, one per layer
+
+  uint32_t cycles; // Cluster cycles spent in the last run
+
+  network_profile_layer_t *profile; // One per layer, only recorded with NETWORK_PROFILE
+  uint32_t profile_runs;
+} network_state_t;
+
+typedef struct network_s {
+  const char *name;
 
-// Expected size of the L2 buffer used for intermediate computation
-#define NETWORK_L2_BUFFER_SIZE (352000) // [bytes]
+  const network_layer_t *layers;
+  int n_layers;
+  const char *weights_blob; // Flash file with the weights of all layers, see pack_weights.py
+
+  size_t L3_weights_size; // [bytes], all the weights in the blob, including the ones resident in L2
+  size_t L3_input_size; // [bytes]
+  size_t L3_output_size; // [bytes]
+  size_t L2_buffer_size; // [bytes], intermediate activations and the weights that are not resident
+  size_t L1_buffer_size; // [bytes], tiles of each layer
+
+  size_t input_size; // [bytes]
+  int output_count; // [elements], NETWORK_OUTPUT_TYPE
+  const float *output_eps; // Dequantization scale of each output
+
+  int macs; // Multiply-accumulate operations per inference
+  int stack_size; // Cluster stacks [bytes]
+  int slave_stack_size;
+
+  network_state_t *state;
+} network_t;
+
+// Loads the weights from the flash to L3 at the first call for each network
+void network_init(const network_t *network);
+void network_terminate(const network_t *network);
+
+// Runs the network on the cluster. Only one network can run at a time on a cluster. l2_buffer
+// must be at least network->L2_buffer_size bytes, l2_input can be at its beginning and l2_output
+// anywhere inside it. input_done, if not NULL, is pushed once the input has been consumed.
+//
+// Up to NETWORK_MAX_QUEUED runs can be in flight: a run sent while the previous one is still
+// executing is queued by the cluster driver and starts as soon as it ends, without a round trip
+// through the FC. Queued runs share l2_buffer, so each needs its own l2_output outside of it.
+// Sending a run while NETWORK_MAX_QUEUED are in flight is an assertion failure: wait for
+// network_done of the oldest one first.
+void network_run_async(const network_t *network, const void *l2_input, void *l2_output, void *l2_buffer, size_t l2_buffer_size, pi_device_t *cluster, pi_task_t *input_done, pi_task_t *network_done);
+
+#define NETWORK_OUTPUT_TYPE int32_t
+
+void network_dequantize_output(const network_t *network, const NETWORK_OUTPUT_TYPE *l2_output, float *l2_output_f32);
+
+// Prints the profile of each layer, see NETWORK PROFILE
+void network_profile_print(const network_t *network);
+
+/*
+ * FRONTNET
+ *
+ * Network generated in this directory, with static sizes for the application buffers
+ */
+
+extern const network_t network_frontnet;
+
+// Same network with layer0_BNReluConvolution and layer1_Pooling as separate layers, as generated
+// by DORY. Bit-exact with network_frontnet, kept as reference.
+extern const network_t network_frontnet_unfused;
+
+// Expected size of the L2 buffer used for intermediate computation, depends on which weights are
+// resident in L2 (see network_frontnet_plan.h)
+#define NETWORK_L2_BUFFER_SIZE NETWORK_FRONTNET_L2_BUFFER_SIZE // [bytes]
 
 // Properties of the network input tensor
 #define NETWORK_INPUT_TYPE uint8_t
@@ -35,61 +182,7 @@
 #define NETWORK_INPUT_SIZE (NETWORK_INPUT_COUNT * sizeof(NETWORK_INPUT_TYPE)) // [bytes]
 
 // Properties of the network output tensor
-#define NETWORK_OUTPUT_TYPE int32_t
 #define NETWORK_OUTPUT_COUNT (4) // [elements]
 #define NETWORK_OUTPUT_SIZE (NETWORK_OUTPUT_COUNT * sizeof(NETWORK_OUTPUT_TYPE)) // [bytes]
 
-void network_init();
-void network_terminate();
-void network_run_async(const void *l2_input, void *l2_output, void *l2_buffer, size_t l2_buffer_size, int exec, pi_device_t *cluster, pi_task_t *input_done, pi_task_t *network_done);
-
-void network_dequantize_output(const NETWORK_OUTPUT_TYPE *l2_output, float *l2_output_f32);
-
-#ifdef DEFINE_CONSTANTS
-// allocation of buffers with parameters needed by the network execution
-static const char * L3_weights_files[] = {
-  "layer0_BNReluConvolution_weights.hex", "layer2_BNReluConvolution_weights.hex", "layer3_BNReluConvolution_weights.hex", "layer4_BNReluConvolution_weights.hex", "layer5_BNReluConvolution_weights.hex", "layer6_BNReluConvolution_weights.hex", "layer7_BNReluConvolution_weights.hex", "layer8_FullyConnected_weights.hex"
-};
-static int L3_weights_size[8];
-static int layers_pointers[9];
-static char * Layers_name[9] = {"layer0_BNReluConvolution", "layer1_Pooling", "layer2_BNReluConvolution", "layer3_BNReluConvolution", "layer4_BNReluConvolution", "layer5_BNReluConvolution", "layer6_BNReluConvolution", "layer7_BNReluConvolution", "layer8_FullyConnected"};
-static int L3_input_layers[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int L3_output_layers[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int allocate_layer[9] = {1, 0, 1, 1, 1, 1, 1, 1, 1};
-static int branch_input[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int branch_output[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int branch_change[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int weights_checksum[9] = {129408, 0, 1217408, 1240539, 2517541, 5044551, 9495994, 20668135, 914121};
-static int weights_size[9] = {1312, 0, 9728, 9728, 19456, 37888, 75776, 149504, 7696};
-static int activations_checksum[9][1] = {
-  {  810934  },
-  {  141585  },
-  {  51732  },
-  {  20816  },
-  {  19410  },
-  {  5783  },
-  {  7242  },
-  {  1511  },
-  {  12249  }
-};
-static int activations_size[9] = {15360, 122880, 30720, 7680, 7680, 3840, 3840, 1920, 1920};
-static int out_mult_vector[9] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
-static int out_shift_vector[9] = {24, 0, 24, 24, 24, 24, 24, 24, 0};
-static int activations_out_checksum[9][1] = {
-  {  141585  },
-  {  51732  },
-  {  20816  },
-  {  19410  },
-  {  5783  },
-  {  7242  },
-  {  1511  },
-  {  12249  },
-  {  1322  }
-};
-static int activations_out_size[9] = {122880, 30720, 7680, 7680, 3840, 3840, 1920, 1920, 16};
-static int L3_activations_size[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int L3_activations_out_size[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-static int layer_with_weights[9] = {1, 0, 1, 1, 1, 1, 1, 1, 1};
-#endif
-
 #endif  // __NETWORK_H__
@@ -0,0 +1,52 @@
+/*
+ * network_frontnet_plan.h
+ * Generated by plan_l2.py, do not edit.
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Weights resident in L2, see plan_l2.py. Planned for a budget of 352000 bytes.
+ */
+
+#ifndef __NETWORK_FRONTNET_PLAN_H__
+#define __NETWORK_FRONTNET_PLAN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NETWORK_FRONTNET_RESIDENT_WEIGHTS_SIZE (303392) // [bytes]
+
+#define NETWORK_FRONTNET_L2_BUFFER_SIZE (46088) // [bytes]
+#define NETWORK_FRONTNET_UNFUSED_L2_BUFFER_SIZE (153608) // [bytes]
+
+extern uint8_t network_frontnet_layer0_BNReluConvolution_weights[1312];
+extern uint8_t network_frontnet_layer2_BNReluConvolution_weights[9728];
+extern uint8_t network_frontnet_layer3_BNReluConvolution_weights[9728];
+extern uint8_t network_frontnet_layer4_BNReluConvolution_weights[19456];
+extern uint8_t network_frontnet_layer5_BNReluConvolution_weights[37888];
+extern uint8_t network_frontnet_layer6_BNReluConvolution_weights[75776];
+extern uint8_t network_frontnet_layer7_BNReluConvolution_weights[149504];
+
+#define NETWORK_FRONTNET_RESIDENT_layer0_BNReluConvolution_weights (network_frontnet_layer0_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer2_BNReluConvolution_weights (network_frontnet_layer2_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer3_BNReluConvolution_weights (network_frontnet_layer3_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer4_BNReluConvolution_weights (network_frontnet_layer4_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer5_BNReluConvolution_weights (network_frontnet_layer5_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer6_BNReluConvolution_weights (network_frontnet_layer6_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer7_BNReluConvolution_weights (network_frontnet_layer7_BNReluConvolution_weights)
+#define NETWORK_FRONTNET_RESIDENT_layer8_FullyConnected_weights (NULL)
+
+#endif // __NETWORK_FRONTNET_PLAN_H__
@@ -14005,6 +14005,68 @@ void pulp_nn_maxpool_u8(
                         uint16_t  stride_x,
                         uint16_t  stride_y);
 
+void pulp_nn_conv_maxpool_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pConv,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mul,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_conv_x,
+                        uint16_t dim_conv_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batchnorm,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t pool_kernel_x,
+                        uint16_t pool_kernel_y,
+                        uint16_t pool_stride_x,
+                        uint16_t pool_stride_y);
+
+void pulp_nn_conv_select_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mul,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batchnorm,
+                        uint8_t flag_depthwise);
+
 void pulp_nn_maxpool_i8(
                         int8_t * pIn,
                         int8_t * pOut,
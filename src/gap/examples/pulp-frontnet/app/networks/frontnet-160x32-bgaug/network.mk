@@ -32,6 +32,10 @@ APP_CFLAGS += -DNUM_CORES=$(CORE)
 APP_CFLAGS  += -O2 -fno-indirect-inlining -flto
 APP_LDFLAGS += -Wl,--print-memory-usage -flto
 
+# The weights resident in L2 are planned by plan_l2.py (inc/network_frontnet_plan.h). When the L2
+# usage of the application changes, re-plan from the memory usage printed by the linker with:
+#   ./plan_l2.py --memory-usage build.log --l2-heap <L2 allocated at runtime by the application>
+
 APP_CFLAGS += -DGAP_SDK=1
 
 ifeq '$(FLASH_TYPE)' 'MRAM'
@@ -41,14 +45,10 @@ endif
 APP_CFLAGS += -DFLASH_TYPE=$(FLASH_TYPE) -DUSE_$(FLASH_TYPE) -DUSE_$(RAM_TYPE)
 APP_CFLAGS += -DALWAYS_BLOCK_DMA_TRANSFERS
 
-FLASH_FILES += $(NETWORK_DIR)/hex/layer0_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer2_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer3_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer4_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer5_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer6_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer7_BNReluConvolution_weights.hex
-FLASH_FILES += $(NETWORK_DIR)/hex/layer8_FullyConnected_weights.hex
+# Weights of all layers packed in a single file by pack_weights.py, in layer order. After
+# regenerating the network with DORY, update it with:
+#   ./pack_weights.py hex/weights.hex hex/layer{0,2,3,4,5,6,7}_BNReluConvolution_weights.hex hex/layer8_FullyConnected_weights.hex
+FLASH_FILES += $(NETWORK_DIR)/hex/weights.hex
 FLASH_FILES += $(NETWORK_DIR)/hex/inputs.hex
 
 READFS_FILES += $(FLASH_FILES)
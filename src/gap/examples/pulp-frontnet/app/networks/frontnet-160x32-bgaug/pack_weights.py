@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+#
+# pack_weights.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Packs the weights files generated by DORY in a single flash blob, loaded by mem_blob_open and
+mem_blob_load_to_ram (see mem.h). The files are concatenated without padding in the order given,
+which must be the order of the layers, so that the weights of the whole network are loaded to L3
+with a single transfer.
+
+Layout, little endian:
+    header  magic "NCWB", uint32 version, uint32 number of entries, uint32 data offset
+    entries char name[48] (NUL-terminated), uint32 offset (from the data offset), uint32 size
+    data
+
+Usage:
+    ./pack_weights.py hex/weights.hex hex/layer0_BNReluConvolution_weights.hex ...
+    ./pack_weights.py --check hex/weights.hex hex/layer0_BNReluConvolution_weights.hex ...
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'NCWB'
+VERSION = 1
+NAME_LEN = 48          # MEM_BLOB_NAME_LEN
+MAX_ENTRIES = 16       # MEM_BLOB_MAX_ENTRIES
+HEADER = struct.Struct('<4sIII')
+ENTRY = struct.Struct(f'<{NAME_LEN}sII')
+DATA_ALIGN = 16
+
+
+def pack(paths):
+    if len(paths) > MAX_ENTRIES:
+        raise ValueError(f'at most {MAX_ENTRIES} files can be packed, got {len(paths)}')
+
+    data_offset = HEADER.size + ENTRY.size * len(paths)
+    data_offset = (data_offset + DATA_ALIGN - 1) // DATA_ALIGN * DATA_ALIGN
+
+    entries = b''
+    data = b''
+    for path in paths:
+        name = os.path.basename(path).encode()
+        if len(name) >= NAME_LEN:
+            raise ValueError(f'file name {name} is longer than {NAME_LEN - 1} characters')
+
+        with open(path, 'rb') as f:
+            content = f.read()
+
+        entries += ENTRY.pack(name, len(data), len(content))
+        data += content
+
+    header = HEADER.pack(MAGIC, VERSION, len(paths), data_offset)
+    padding = b'\0' * (data_offset - len(header) - len(entries))
+
+    return header + entries + padding + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack the DORY weights files in a single flash blob')
+    parser.add_argument('--check', action='store_true', help='check that the blob is up to date instead of writing it')
+    parser.add_argument('output', help='blob to write')
+    parser.add_argument('inputs', nargs='+', help='weights files, in layer order')
+    args = parser.parse_args()
+
+    blob = pack(args.inputs)
+
+    if args.check:
+        with open(args.output, 'rb') as f:
+            if f.read() != blob:
+                print(f'{args.output} is out of date, run {sys.argv[0]} without --check', file=sys.stderr)
+                return 1
+        return 0
+
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+
+    print(f'{args.output}: {len(args.inputs)} files, {len(blob)} bytes')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
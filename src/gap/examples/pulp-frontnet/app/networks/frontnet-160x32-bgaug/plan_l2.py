@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+#
+# plan_l2.py
+# Elia Cereda <elia.cereda@idsia.ch>
+#
+# Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Plans which layers keep their weights resident in L2, instead of copying them from L3 before
+running the layer at each inference, and generates the corresponding static allocation in
+inc/network_frontnet_plan.h and src/network_frontnet_plan.c.
+
+The layer tables are read from src/network_frontnet.c. The L2 used by the network is the
+resident weights plus the L2 buffer of network_run_cluster, whose size is simulated from the
+directional allocator: each layer needs its input, output and (if not resident) weights at the
+same time. The plan maximizes the resident weights within the L2 budget of the network, which is
+either given directly or computed from the L2 usage of the application:
+
+    budget = L2 size - (static L2 usage - resident weights of the current plan) - L2 heap - margin
+
+where the static L2 usage is read from the output of the linker with -Wl,--print-memory-usage,
+and the L2 heap is what the application allocates at runtime besides the network L2 buffer
+(camera frames, streamer buffers, ...).
+
+Usage:
+    ./plan_l2.py --budget 352000
+    ./plan_l2.py --memory-usage build.log --l2-heap 60000
+    ./plan_l2.py --resident none
+"""
+
+import argparse
+import itertools
+import os
+import re
+import sys
+
+NETWORK_DIR = os.path.dirname(os.path.abspath(__file__))
+NETWORK_SRC = os.path.join(NETWORK_DIR, 'src', 'network_frontnet.c')
+PLAN_HEADER = os.path.join(NETWORK_DIR, 'inc', 'network_frontnet_plan.h')
+PLAN_SRC = os.path.join(NETWORK_DIR, 'src', 'network_frontnet_plan.c')
+
+PREFIX = 'NETWORK_FRONTNET'
+L2_SIZE = 512 * 1024  # GAP8
+ALIGN = 8
+
+LICENSE = '''/*
+ * {name}
+ * Generated by plan_l2.py, do not edit.
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+'''
+
+
+def align(size):
+    return (size + ALIGN - 1) // ALIGN * ALIGN
+
+
+def parse_tables(path):
+    """Returns {table name: [layer, ...]} with the layers of each network_layer_t table"""
+    with open(path) as f:
+        src = f.read()
+
+    # Expand the object-like macros used inside the tables
+    macros = {}
+    for m in re.finditer(r'^#define (\w+) \\\n((?:.*\\\n)*.*)$', src, re.MULTILINE):
+        macros[m.group(1)] = m.group(2).replace('\\\n', '\n')
+
+    tables = {}
+    for m in re.finditer(r'static const network_layer_t (\w+)\[\w+\] = \{(.*?)\n\};', src, re.DOTALL):
+        body = m.group(2)
+        for name, value in macros.items():
+            body = re.sub(rf'\b{name}\b', lambda _: value, body)
+
+        layers = []
+        for l in re.finditer(
+            r'\.name = "(\w+)".*?\.weights_file = (NULL|"([\w.]+)").*?'
+            r'\.weights_size = (\d+), \.activations_size = (\d+), \.activations_out_size = (\d+)',
+            body, re.DOTALL
+        ):
+            layers.append({
+                'name': l.group(1),
+                'weights': l.group(3).replace('.hex', '') if l.group(3) else None,
+                'weights_size': int(l.group(4)),
+                'activations_size': int(l.group(5)),
+                'activations_out_size': int(l.group(6)),
+            })
+        tables[m.group(1)] = layers
+
+    if 'layers' not in tables:
+        raise ValueError(f'layer table not found in {path}')
+
+    return tables
+
+
+def l2_buffer_size(layers, resident):
+    """L2 buffer needed by network_run_cluster, the input of the first layer can be inside it"""
+    peak = 0
+    for layer in layers:
+        size = layer['activations_size'] + layer['activations_out_size']
+        if layer['weights'] not in resident:
+            size += layer['weights_size']
+        peak = max(peak, size)
+
+    # dmalloc fails when the allocation would exactly fill the buffer
+    return align(peak + 1)
+
+
+def weights_sizes(tables):
+    sizes = {}
+    for layers in tables.values():
+        for layer in layers:
+            if layer['weights']:
+                sizes[layer['weights']] = layer['weights_size']
+    return sizes
+
+
+def plan(tables, budget):
+    """Largest set of resident weights, with the L2 buffer of the main table, that fits the budget"""
+    sizes = weights_sizes(tables)
+    best = None
+
+    for n in range(len(sizes) + 1):
+        for resident in itertools.combinations(sizes, n):
+            resident_size = sum(align(sizes[w]) for w in resident)
+            total = resident_size + l2_buffer_size(tables['layers'], resident)
+            if total > budget:
+                continue
+
+            if best is None or (resident_size, -total) > (best[1], -best[2]):
+                best = (set(resident), resident_size, total)
+
+    return best[0] if best else set()
+
+
+def parse_memory_usage(path, region):
+    """Used size of a memory region from the output of ld --print-memory-usage [bytes]"""
+    units = {'B': 1, 'KB': 1024, 'MB': 1024 * 1024, 'GB': 1024 * 1024 * 1024}
+    with open(path) as f:
+        for line in f:
+            m = re.match(rf'\s*{re.escape(region)}:\s+(\d+)\s*(B|KB|MB|GB)\s+(\d+)\s*(B|KB|MB|GB)', line)
+            if m:
+                return int(m.group(1)) * units[m.group(2)]
+
+    raise ValueError(f'memory region {region} not found in {path}')
+
+
+def current_resident_size():
+    """Resident weights of the plan that the application was built with [bytes]"""
+    try:
+        with open(PLAN_HEADER) as f:
+            m = re.search(rf'#define {PREFIX}_RESIDENT_WEIGHTS_SIZE \((\d+)\)', f.read())
+            return int(m.group(1)) if m else 0
+    except FileNotFoundError:
+        return 0
+
+
+def table_macro(table):
+    suffix = table[len('layers'):].upper()
+    return f'{PREFIX}{suffix}_L2_BUFFER_SIZE'
+
+
+def generate(tables, resident, budget):
+    sizes = weights_sizes(tables)
+    resident_size = sum(align(sizes[w]) for w in resident)
+
+    header = LICENSE.format(name='network_frontnet_plan.h')
+    header += f'''
+/*
+ * Weights resident in L2, see plan_l2.py. Planned for a budget of {budget} bytes.
+ */
+
+#ifndef __NETWORK_FRONTNET_PLAN_H__
+#define __NETWORK_FRONTNET_PLAN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define {PREFIX}_RESIDENT_WEIGHTS_SIZE ({resident_size}) // [bytes]
+
+'''
+    for table, layers in tables.items():
+        header += f'#define {table_macro(table)} ({l2_buffer_size(layers, resident)}) // [bytes]\n'
+    header += '\n'
+
+    for weights, size in sizes.items():
+        if weights in resident:
+            header += f'extern uint8_t network_frontnet_{weights}[{size}];\n'
+    header += '\n'
+
+    for weights in sizes:
+        value = f'network_frontnet_{weights}' if weights in resident else 'NULL'
+        header += f'#define {PREFIX}_RESIDENT_{weights} ({value})\n'
+
+    header += '\n#endif // __NETWORK_FRONTNET_PLAN_H__\n'
+
+    src = LICENSE.format(name='network_frontnet_plan.c')
+    src += '\n#include "network_frontnet_plan.h"\n\n#include <pmsis.h>\n\n'
+    for weights, size in sizes.items():
+        if weights in resident:
+            src += f'PI_L2 uint8_t network_frontnet_{weights}[{size}] __attribute__((aligned({ALIGN})));\n'
+
+    with open(PLAN_HEADER, 'w') as f:
+        f.write(header)
+    with open(PLAN_SRC, 'w') as f:
+        f.write(src)
+
+
+def report(tables, resident, budget):
+    sizes = weights_sizes(tables)
+    configurations = [
+        ('L3 only', set()),
+        ('planned', resident),
+        ('all resident', set(sizes)),
+    ]
+
+    print(f'Network L2 budget: {budget} bytes')
+    print(f'{"configuration":<14} {"resident":>9} {"L2 buffer":>10} {"total L2":>9} {"headroom":>9} {"L3 reads":>9}')
+    for name, config in configurations:
+        resident_size = sum(align(sizes[w]) for w in config)
+        buffer_size = l2_buffer_size(tables['layers'], config)
+        total = resident_size + buffer_size
+        l3_reads = sum(size for w, size in sizes.items() if w not in config)
+        print(f'{name:<14} {resident_size:>9} {buffer_size:>10} {total:>9} {budget - total:>9} {l3_reads:>9}')
+
+    print('Resident:', ', '.join(w for w in sizes if w in resident) or 'none')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Plan the weights resident in L2 and generate their allocation')
+    parser.add_argument('--budget', type=int, help='L2 available to the network (resident weights and L2 buffer) [bytes]')
+    parser.add_argument('--memory-usage', help='linker output with -Wl,--print-memory-usage, to compute the budget')
+    parser.add_argument('--region', default='L2', help='L2 memory region in the linker output (default: %(default)s)')
+    parser.add_argument('--l2-size', type=int, default=L2_SIZE, help='L2 size [bytes] (default: %(default)s)')
+    parser.add_argument('--l2-heap', type=int, default=0, help='L2 allocated at runtime by the application, besides the network [bytes]')
+    parser.add_argument('--margin', type=int, default=8192, help='L2 left free for the SDK and drivers [bytes] (default: %(default)s)')
+    parser.add_argument('--resident', choices=['plan', 'none', 'all'], default='plan', help='override the plan (default: %(default)s)')
+    parser.add_argument('--dry-run', action='store_true', help='only print the report')
+    args = parser.parse_args()
+
+    tables = parse_tables(NETWORK_SRC)
+
+    if args.budget is not None:
+        budget = args.budget
+    elif args.memory_usage:
+        static = parse_memory_usage(args.memory_usage, args.region) - current_resident_size()
+        budget = args.l2_size - static - args.l2_heap - args.margin
+        print(f'L2: {args.l2_size} bytes, {static} static, {args.l2_heap} heap, {args.margin} margin')
+    else:
+        parser.error('either --budget or --memory-usage is required')
+
+    if args.resident == 'none':
+        resident = set()
+    elif args.resident == 'all':
+        resident = set(weights_sizes(tables))
+    else:
+        resident = plan(tables, budget)
+
+    report(tables, resident, budget)
+
+    if not args.dry_run:
+        generate(tables, resident, budget)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,3 +1,5 @@
+#include "config.h"
+
 #include "dory_dma.h"
 
 #include <pmsis.h>
@@ -187,14 +189,30 @@ void dory_dma_free(DMA_copy *copy) {
   mchan_transfer_free(copy->tid);
 }
 
+#ifdef NETWORK_PROFILE
+PI_CL_L1 uint32_t dory_dma_wait_cycles;
+#endif
+
+static inline void dory_dma_wait(int tid) {
+#ifdef NETWORK_PROFILE
+  // Only core 0 is counted, it runs the performance counters of network_run_cluster
+  uint32_t start = pi_perf_read(PI_PERF_CYCLES);
+  mchan_transfer_wait(tid);
+  if (pi_core_id() == 0)
+    dory_dma_wait_cycles += pi_perf_read(PI_PERF_CYCLES) - start;
+#else
+  mchan_transfer_wait(tid);
+#endif
+}
+
 void dory_dma_barrier(DMA_copy *copy) {
 #ifdef SINGLE_CORE_DMA
   // if DMA is only used by a single core (only 1 ctrl interface), other cores must not access its register file. Instead, they should all wait for core 0 to confirm the transfer is over.
   if (pi_core_id() == 0)
-    mchan_transfer_wait(copy->tid);
+    dory_dma_wait(copy->tid);
   pi_cl_team_barrier(0);
 #else
-  mchan_transfer_wait(copy->tid);
+  dory_dma_wait(copy->tid);
 #endif
 }
 
@@ -0,0 +1,270 @@
+/*
+ * layer0_BNReluConvolution_Pooling.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ * Alessio Burrello <alessio.burrello@unibo.it>
+ * Francesco Conti <f.conti@unibo.it>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *               2018-2020 University of Bologna
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * layer0_BNReluConvolution followed by layer1_Pooling, fused in a single layer: each tile of the
+ * convolution output stays in L1 and is max-pooled there, only the pooled output is written to L2.
+ * This avoids writing the 48x80x32 convolution output to L2 and reading it back, the largest
+ * activation transfer of the network.
+ *
+ * The convolution output is tiled in 3x2 tiles of 16x40 pixels, so that the 2x2 pooling windows
+ * never cross a tile border. Each input tile includes the rows and columns of overlap with the
+ * neighbouring tiles (3 for the 5x5 kernel with stride 2), the padding is applied on the borders
+ * of the image only. The output is bit-exact with that of the two separate layers.
+ */
+// func_name                      layer0_BNReluConvolution_Pooling
+// optional                       BNReluConv + MaxPool
+// FLAG_BATCHNORM                 1
+// FLAG_RELU                      1
+// padding                        2
+// stride                         2
+// nif                            1
+// nof                            32
+// out_shift                      24
+// x_h                            96
+// x_w                            160
+// x_tile_size_h                  35 (33 first, 34 last)
+// x_tile_size_w                  82 (81 first)
+// conv_h                         48
+// conv_w                         80
+// conv_tile_size_h               16
+// conv_tile_size_w               40
+// conv_tile_size_byte            20480
+// fs1                            5
+// fs2                            5
+// pool_fs                        2
+// pool_stride                    2
+// y_h                            24
+// y_w                            40
+// y_tile_size_h                  8
+// y_tile_size_w                  20
+// y_tile_size_byte               5120
+// y_stride_w_byte                1280
+// y_stride_c_byte                32
+// tile_dim_h                     3
+// tile_dim_w                     2
+// W_tile_size_byte               800
+// l2_off_k                       800
+// l2_off_lambda                  1056
+// k_tile_size_byte               256
+// lambda_tile_size_byte          256
+// l1_x_offset                    0
+// l1_conv_offset                 2872
+// l1_y_offset                    23352
+// l1_W_offset                    28472
+// l1_k_offset                    29272
+// l1_lambda_offset               29528
+// l1_im2col_offset               29784
+
+
+#include "layer0_BNReluConvolution_Pooling.h"
+#include "pulp.h"
+#include "pmsis.h"
+#include "dory_get_tile.h"
+#include "dory_dma.h"
+#include "pulp_nn_kernels.h"
+
+
+void layer0_BNReluConvolution_Pooling(
+  void *args
+) {
+  //////////////////////////////////////////////////////////////////////////
+  // arguments assigning: keeping same interface between L2 and L3 memory //
+  //////////////////////////////////////////////////////////////////////////
+  unsigned int *real_arg = (unsigned int *) args;
+  unsigned int l3_x =(unsigned int)  real_arg[0];
+  unsigned int l3_y =(unsigned int)  real_arg[1];
+  unsigned int l3_W =(unsigned int)  real_arg[2];
+  unsigned int l2_x =(unsigned int)  real_arg[3];
+  unsigned int l2_x_2 =(unsigned int)  real_arg[4];
+  unsigned int l2_y =(unsigned int)  real_arg[5];
+  unsigned int l2_W =(unsigned int)  real_arg[6];
+  unsigned int l1_buffer =(unsigned int)  real_arg[7];
+  unsigned int hyperram =(unsigned int)  real_arg[8];
+  unsigned int out_mult_in =(unsigned int)  real_arg[9];
+  unsigned int out_shift_in = (unsigned int) real_arg[10];
+
+  /////////////////////
+  // DMA declaration //
+  /////////////////////
+  uint32_t dory_dma_channel = dory_dma_allocate();
+  volatile DMA_copy DMA_copy_k, DMA_copy_lambda;
+  volatile DMA_copy DMA_copy_W, DMA_copy_x, DMA_copy_y;
+  DMA_copy_k.hwc_to_chw = 0;
+  DMA_copy_k.stride_2d = 0;
+  DMA_copy_k.stride_1d = 0;
+  DMA_copy_k.number_of_2d_copies = 1;
+  DMA_copy_k.number_of_1d_copies = 1;
+  DMA_copy_k.dir = 1;
+  DMA_copy_k.tid = dory_dma_channel;
+
+  DMA_copy_lambda.hwc_to_chw = 0;
+  DMA_copy_lambda.stride_2d = 0;
+  DMA_copy_lambda.stride_1d = 0;
+  DMA_copy_lambda.number_of_2d_copies = 1;
+  DMA_copy_lambda.number_of_1d_copies = 1;
+  DMA_copy_lambda.dir = 1;
+  DMA_copy_lambda.tid = dory_dma_channel;
+  
+  DMA_copy_x.hwc_to_chw = 0;
+  DMA_copy_x.stride_2d = 160;
+  DMA_copy_x.stride_1d = 1;
+  DMA_copy_x.length_1d_copy = 1;
+  DMA_copy_x.dir = 1;
+  DMA_copy_x.tid = dory_dma_channel;
+  
+  DMA_copy_W.hwc_to_chw = 0;
+  DMA_copy_W.stride_2d = 25;
+  DMA_copy_W.stride_1d = 1;
+  DMA_copy_W.number_of_2d_copies = 32;
+  DMA_copy_W.number_of_1d_copies = 25;
+  DMA_copy_W.length_1d_copy = 1;
+  DMA_copy_W.dir = 1;
+  DMA_copy_W.tid = dory_dma_channel;
+  
+  DMA_copy_y.hwc_to_chw = 0;
+  DMA_copy_y.stride_2d = 1280;
+  DMA_copy_y.stride_1d = 32;
+  DMA_copy_y.number_of_2d_copies = 8;
+  DMA_copy_y.number_of_1d_copies = 20;
+  DMA_copy_y.length_1d_copy = 32;
+  DMA_copy_y.dir = 0;
+  DMA_copy_y.tid = dory_dma_channel;
+
+  volatile int p_r, p_l, p_t, p_b;
+  volatile int x_row_start, x_row_stop, x_col_start, x_col_stop;
+  volatile unsigned short  x_tile_size_h;
+  volatile unsigned short  x_tile_size_w;
+  volatile int conv_h0, conv_w0;
+  volatile uint8_t *x, *conv, *W, *y;
+  volatile int64_t *k;
+  volatile int64_t *lambda;
+  int iter;
+  // tile loop indeces
+  int _i_h_load=0, _i_w_load=0;
+  volatile uint8_t *im2col;
+  im2col = l1_buffer + 29784;
+  uint16_t out_mult = out_mult_in;
+  uint16_t out_shift = out_shift_in;
+
+  ////////////////////////////
+  // Weights transfering    //
+  ////////////////////////////
+  // A single output channel tile, weights are transferred once
+  DMA_copy_W.ext = l2_W;
+  DMA_copy_W.loc = (l1_buffer + 28472);
+  dory_dma_memcpy_async(&DMA_copy_W);
+  dory_dma_barrier(&DMA_copy_W);
+
+  DMA_copy_k.ext = (uint32_t) l2_W+800;
+  DMA_copy_k.loc = (uint32_t) l1_buffer + 29272;
+  DMA_copy_k.length_1d_copy = (uint16_t) 32 * 8;
+  dory_dma_memcpy_async(&DMA_copy_k);
+  dory_dma_barrier(&DMA_copy_k);
+
+  DMA_copy_lambda.ext = (uint32_t) l2_W+1056;
+  DMA_copy_lambda.loc = (uint32_t) l1_buffer + 29528;
+  DMA_copy_lambda.length_1d_copy = (uint16_t) 32 * 8;
+  dory_dma_memcpy_async(&DMA_copy_lambda);
+  dory_dma_barrier(&DMA_copy_lambda);
+
+  x = (uint8_t *) (l1_buffer + 0);
+  conv = (uint8_t *) (l1_buffer + 2872);
+  y = (uint8_t *) (l1_buffer + 23352);
+  W = (uint8_t *) (l1_buffer + 28472);
+  k = (int64_t *) (l1_buffer + 29272);
+  lambda = (int64_t *) (l1_buffer + 29528);
+
+  int total_tiles = 6;
+  // tile loop nest
+  for(iter=0; iter < total_tiles; iter++) {
+    // first convolution output pixel of the tile
+    conv_h0 = _i_h_load * 16;
+    conv_w0 = _i_w_load * 40;
+    // input rows and columns read by the tile, clipped to the image where padding is applied
+    x_row_start = 2 * conv_h0 - 2;
+    x_row_stop  = 2 * conv_h0 + 33;
+    x_col_start = 2 * conv_w0 - 2;
+    x_col_stop  = 2 * conv_w0 + 81;
+    p_r = 0;
+    p_l = 0;
+    p_t = 0;
+    p_b = 0;
+    if (_i_h_load == 0) {
+      p_t = 2;
+      x_row_start = 0;
+    }
+    if (_i_w_load == 0) {
+      p_l = 2;
+      x_col_start = 0;
+    }
+    if (_i_h_load == 3-1) {
+      p_b = 2;
+      x_row_stop = 96;
+    }
+    if (_i_w_load == 2-1) {
+      p_r = 2;
+      x_col_stop = 160;
+    }
+    x_tile_size_h = x_row_stop - x_row_start;
+    x_tile_size_w = x_col_stop - x_col_start;
+
+    DMA_copy_x.ext = l2_x + x_row_start * 160 + x_col_start;
+    DMA_copy_x.loc = (l1_buffer + 0);
+    DMA_copy_x.number_of_2d_copies = x_tile_size_h;
+    DMA_copy_x.number_of_1d_copies = x_tile_size_w;
+    dory_dma_memcpy_async(&DMA_copy_x);
+    dory_dma_barrier(&DMA_copy_x);
+
+    pi_cl_team_barrier(0);
+    pulp_nn_conv_maxpool_u8_u8_i8(
+      x, im2col,
+      NULL,
+      conv, y, W,
+      k, lambda,
+      out_mult, out_shift,
+      x_tile_size_w, x_tile_size_h, 1,
+      40, 16, 32,
+      5, 5,
+      p_t, p_b, p_l, p_r, 2, 2,
+      1, 1,
+      20, 8,
+      2, 2, 2, 2
+      );
+    pi_cl_team_barrier(0);
+      DMA_copy_y.ext = l2_y + ((conv_h0 / 2) * 40 + (conv_w0 / 2)) * 32;
+      DMA_copy_y.loc = (l1_buffer + 23352);
+      dory_dma_memcpy_async(&DMA_copy_y); 
+      dory_dma_barrier(&DMA_copy_y);  
+    // update prev iterators
+      _i_w_load += 1;
+      if(_i_w_load==2) 
+      {
+        _i_w_load = 0;
+        _i_h_load += 1;
+      }
+    pi_cl_team_barrier(0);
+  }
+
+  // wait for final write
+  dory_dma_free(&DMA_copy_y);
+}
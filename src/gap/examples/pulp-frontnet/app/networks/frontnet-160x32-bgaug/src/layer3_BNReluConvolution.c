@@ -293,7 +293,7 @@ void layer3_BNReluConvolution(
       p_r = 1;
     pi_cl_team_barrier(0);
     asm volatile("": : :"memory");
-    pulp_nn_conv_u8_u8_i8(
+    pulp_nn_conv_select_u8_u8_i8(
       x, im2col,
       NULL,
       y, W,
@@ -303,7 +303,8 @@ void layer3_BNReluConvolution(
       y_tile_size_w, y_tile_size_h, y_tile_size_nof,
       3, 3,
       p_t, p_b, p_l, p_r, 1, 1,
-      1, 1
+      1, 1,
+      0
       );
     pi_cl_team_barrier(0);
       DMA_copy_y.ext = dory_get_tile_3d(l2_y, _i_h_load, _i_w_load, _i_nof_load, 12, 20, 32, 20, 32, 0, 0, 0, 0, 0, 0, 8);
@@ -292,7 +292,7 @@ void layer6_BNReluConvolution(
     if (_i_w_load == 2-1)
       p_r = 1;
     pi_cl_team_barrier(0);
-    pulp_nn_conv_u8_u8_i8(
+    pulp_nn_conv_select_u8_u8_i8(
       x, im2col,
       NULL,
       y, W,
@@ -302,7 +302,8 @@ void layer6_BNReluConvolution(
       y_tile_size_w, y_tile_size_h, y_tile_size_nof,
       3, 3,
       p_t, p_b, p_l, p_r, 2, 2,
-      1, 1
+      1, 1,
+      0
       );
     pi_cl_team_barrier(0);
       DMA_copy_y.ext = dory_get_tile_3d(l2_y, _i_h_load, _i_w_load, _i_nof_load, 2, 4, 40, 5, 128, 0, 0, 0, 0, 0, 0, 8);
@@ -27,6 +27,8 @@
 #include "bsp/flash.h"
 #include "bsp/ram.h"
 
+#include <string.h>
+
 #ifdef USE_HYPERFLASH
 #include "bsp/flash/hyperflash.h"
 typedef struct pi_hyperflash_conf flash_conf_t;
@@ -52,8 +54,15 @@ typedef struct pi_default_ram_conf ram_conf_t;
 #define ram_conf_init(conf) pi_default_ram_conf_init(conf)
 #endif
 
-#define BUFFER_SIZE 128
-static uint8_t buffer[BUFFER_SIZE];
+#define MEM_BLOB_MAGIC   (0x4257434e) // "NCWB"
+#define MEM_BLOB_VERSION (1)
+
+typedef struct mem_blob_header_s {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t n_entries;
+  uint32_t data_offset;
+} mem_blob_header_t;
 
 static struct pi_device flash;
 static flash_conf_t flash_conf;
@@ -138,6 +147,47 @@ void cl_ram_write(void *dest, void *src, const size_t size) {
   pi_cl_ram_write_wait(&req);
 }
 
+// Streams size bytes from the current position of fd to dest in L3, with two L2 buffers in ping-pong
+static void load_to_ram(pi_fs_file_t *fd, const void *dest, size_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  const size_t chunk_size = size < MEM_LOAD_CHUNK_SIZE ? size : MEM_LOAD_CHUNK_SIZE;
+  uint8_t *buffers = pi_l2_malloc(2 * chunk_size);
+  if (buffers == NULL) {
+    printf("ERROR: Cannot allocate %dB of L2 to load from flash! Exiting...\n", 2 * chunk_size);
+    pmsis_exit(-5);
+  }
+
+  pi_task_t read_done, write_done;
+  int current = 0;
+  size_t offset = 0;
+  size_t length = chunk_size;
+
+  pi_fs_read_async(fd, buffers, length, pi_task_block(&read_done));
+
+  while (offset < size) {
+    pi_task_wait_on(&read_done);
+
+    // The previous write used the other buffer, which is about to be refilled
+    if (offset > 0) {
+      pi_task_wait_on(&write_done);
+    }
+    pi_ram_write_async(&ram, (uint32_t)(dest + offset), buffers + current * chunk_size, length, pi_task_block(&write_done));
+    offset += length;
+
+    if (offset < size) {
+      length = (size - offset) < chunk_size ? (size - offset) : chunk_size;
+      pi_fs_read_async(fd, buffers + !current * chunk_size, length, pi_task_block(&read_done));
+    }
+    current = !current;
+  }
+
+  pi_task_wait_on(&write_done);
+  pi_l2_free(buffers, 2 * chunk_size);
+}
+
 size_t load_file_to_ram(const void *dest, const char *filename) {
   pi_fs_file_t *fd = pi_fs_open(&fs, filename, 0);
   if (fd == NULL) {
@@ -146,15 +196,91 @@ size_t load_file_to_ram(const void *dest, const char *filename) {
   }
 
   const size_t size = fd->size;
-
-  size_t offset = 0;
-  do {
-    const size_t read_bytes = pi_fs_read(fd, buffer, BUFFER_SIZE);
-    ram_write(dest + offset, buffer, read_bytes);
-    offset += read_bytes;
-  } while (offset < size);
+  load_to_ram(fd, dest, size);
 
   pi_fs_close(fd);
 
-  return offset;
+  return size;
+}
+
+int mem_blob_open(mem_blob_t *blob, const char *filename) {
+  pi_fs_file_t *fd = pi_fs_open(&fs, filename, 0);
+  if (fd == NULL) {
+    printf("ERROR: Cannot open file %s!\n", filename);
+    return -1;
+  }
+
+  // Read through L2, blob can be anywhere
+  const size_t index_size = sizeof(mem_blob_header_t) + sizeof(blob->entries);
+  uint8_t *index = pi_l2_malloc(index_size);
+  if (index == NULL) {
+    pi_fs_close(fd);
+    return -1;
+  }
+
+  size_t read_size = index_size < fd->size ? index_size : fd->size;
+  pi_fs_read(fd, index, read_size);
+
+  mem_blob_header_t header;
+  memcpy(&header, index, sizeof(header));
+
+  int status = 0;
+  if (read_size < sizeof(header) || header.magic != MEM_BLOB_MAGIC || header.version != MEM_BLOB_VERSION
+      || header.n_entries > MEM_BLOB_MAX_ENTRIES || header.data_offset > fd->size
+      || sizeof(header) + header.n_entries * sizeof(mem_blob_entry_t) > read_size) {
+    printf("ERROR: %s is not a valid blob!\n", filename);
+    status = -1;
+  } else {
+    blob->fd = fd;
+    blob->n_entries = header.n_entries;
+    blob->data_offset = header.data_offset;
+    memcpy(blob->entries, index + sizeof(header), header.n_entries * sizeof(mem_blob_entry_t));
+
+    for (int i = 0; i < blob->n_entries; i++) {
+      mem_blob_entry_t *entry = &blob->entries[i];
+      entry->name[MEM_BLOB_NAME_LEN - 1] = '\0';
+      if (blob->data_offset + entry->offset + entry->size > fd->size) {
+        printf("ERROR: %s entry %s is out of bounds!\n", filename, entry->name);
+        status = -1;
+      }
+    }
+  }
+
+  pi_l2_free(index, index_size);
+
+  if (status) {
+    pi_fs_close(fd);
+  }
+
+  return status;
+}
+
+void mem_blob_close(mem_blob_t *blob) {
+  pi_fs_close((pi_fs_file_t *)blob->fd);
+  blob->fd = NULL;
+}
+
+const mem_blob_entry_t *mem_blob_find(const mem_blob_t *blob, const char *name) {
+  for (int i = 0; i < blob->n_entries; i++) {
+    if (strcmp(blob->entries[i].name, name) == 0) {
+      return &blob->entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+void mem_blob_load_to_ram(mem_blob_t *blob, const void *dest, uint32_t offset, size_t size) {
+  pi_fs_file_t *fd = (pi_fs_file_t *)blob->fd;
+
+  pi_fs_seek(fd, blob->data_offset + offset);
+  load_to_ram(fd, dest, size);
+}
+
+void mem_blob_load_to_l2(mem_blob_t *blob, void *dest, uint32_t offset, size_t size) {
+  pi_fs_file_t *fd = (pi_fs_file_t *)blob->fd;
+
+  // The readfs reads to L2 directly, no intermediate buffers needed
+  pi_fs_seek(fd, blob->data_offset + offset);
+  pi_fs_read(fd, dest, size);
 }
@@ -22,23 +22,13 @@
 
 #include "config.h"
 
-#define DEFINE_CONSTANTS
 #include "network.h"
 
 #include "directional_allocator.h"
+#include "dory_dma.h"
 #include "mem.h"
 #include "net_utils.h"
 
-#include "layer0_BNReluConvolution.h"
-#include "layer1_Pooling.h"
-#include "layer2_BNReluConvolution.h"
-#include "layer3_BNReluConvolution.h"
-#include "layer4_BNReluConvolution.h"
-#include "layer5_BNReluConvolution.h"
-#include "layer6_BNReluConvolution.h"
-#include "layer7_BNReluConvolution.h"
-#include "layer8_FullyConnected.h"
-
 #include <pmsis.h>
 
 #include <stdbool.h>
@@ -49,96 +39,189 @@
   #define NETWORK_VERBOSE 1
 #endif
 
-#define FLASH_WEIGHTS_SIZE (311088)
-#define L3_INPUT_SIZE (0)
-#define L3_OUTPUT_SIZE (0)
-
 typedef struct network_args_s {
+  const network_t *network;
   const void *l2_input;
   void *l2_output;
   void *l2_buffer;
   size_t l2_buffer_size;
-  int exec;
   pi_task_t *input_done;
+  pi_task_t *network_done;
+  pi_task_t done_task; // Frees the slot before pushing network_done
 } network_args_t;
 
-static network_args_t network_args;
-static struct pi_cluster_task network_task;
+typedef struct layer_fork_args_s {
+  const network_t *network;
+  layer_args_t largs;
+} layer_fork_args_t;
+
+#ifdef NETWORK_PROFILE
+// Hardware events counted for each entry of network_profile_event_e
+static const int profile_events[NETWORK_PROFILE_N_EVENTS] = {
+  PI_PERF_ACTIVE_CYCLES, PI_PERF_INSTR, PI_PERF_LD_STALL, PI_PERF_JR_STALL,
+  PI_PERF_IMISS, PI_PERF_LD_EXT_CYC, PI_PERF_ST_EXT_CYC, PI_PERF_TCDM_CONT,
+};
+#endif
 
-static void *L3_weights = NULL;
-static void *L3_input = NULL;
-static void *L3_output = NULL;
-int cycle_network_execution;
+// Runs queued on the cluster, which executes them one at a time in order. A slot stays in use
+// until its run has completed.
+static network_args_t network_args[NETWORK_MAX_QUEUED];
+static struct pi_cluster_task network_task[NETWORK_MAX_QUEUED];
+static int network_next_task = 0;
+static int network_in_flight = 0;
 
+static void network_run_done(void *network_args);
 static void network_run_cluster(void *network_args);
-static void execute_layer_fork(void *layer_args);
+static void execute_layer_fork(layer_fork_args_t *fork_args);
+
+void network_init(const network_t *network) {
+  network_state_t *state = network->state;
+
+  // Weights are shared by all the instances of the network
+  if (state->init_count++ > 0) {
+    return;
+  }
 
-void network_init() {
   // Load weights and biases from HyperFlash to HyperRAM
-  L3_weights = ram_malloc(FLASH_WEIGHTS_SIZE);
-  L3_input = ram_malloc(L3_INPUT_SIZE);
-  L3_output = ram_malloc(L3_OUTPUT_SIZE);
+  state->L3_weights = ram_malloc(network->L3_weights_size);
+  state->L3_input = ram_malloc(network->L3_input_size);
+  state->L3_output = ram_malloc(network->L3_output_size);
 
 #if NETWORK_VERBOSE
   printf("\n");
-  printf("L3 weights alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)L3_weights, L3_weights?"Ok":"Failed");
-  printf("L3   input alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)L3_input, L3_input?"Ok":"Failed");
-  printf("L3  output alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)L3_output, L3_output?"Ok":"Failed");
+  printf("%s\n", network->name);
+  printf("L3 weights alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)state->L3_weights, state->L3_weights?"Ok":"Failed");
+  printf("L3   input alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)state->L3_input, state->L3_input?"Ok":"Failed");
+  printf("L3  output alloc initial\t@ 0x%08x:\t%s\n", (unsigned int)state->L3_output, state->L3_output?"Ok":"Failed");
 #endif
 
-  void *w_ptr = L3_weights;
-  for (int i = 0; i < 8; i++) {
-    size_t size = load_file_to_ram(w_ptr, L3_weights_files[i]);
-    L3_weights_size[i] = size;
-    w_ptr += size;
+  // The weights of all layers are packed in a single blob, see pack_weights.py
+  static mem_blob_t blob;
+  if (mem_blob_open(&blob, network->weights_blob)) {
+    ASSERTION_FAILURE("Cannot open %s weights blob %s\n", network->name, network->weights_blob);
+  }
+
+  // Resident weights are read straight to L2. The others are packed in L3 in layer order, layers
+  // whose weights are contiguous in the blob are loaded with a single transfer.
+  void *w_ptr = state->L3_weights;
+  uint32_t run_offset = 0;
+  size_t run_size = 0;
+  size_t l2_weights_size = 0;
+
+  for (int i = 0; i < network->n_layers; i++) {
+    const network_layer_t *layer = &network->layers[i];
+    if (layer->weights_file == NULL) {
+      continue;
+    }
+
+    const mem_blob_entry_t *entry = mem_blob_find(&blob, layer->weights_file);
+    if (entry == NULL) {
+      ASSERTION_FAILURE("%s weights %s not found in %s\n", layer->name, layer->weights_file, network->weights_blob);
+    }
+    if (entry->size != layer->weights_size) {
+      ASSERTION_FAILURE(
+        "%s weights size mismatch: read %dB but expected %dB\n", layer->name, entry->size, layer->weights_size
+      );
+    }
+
+    if (layer->L2_weights) {
+      mem_blob_load_to_l2(&blob, layer->L2_weights, entry->offset, entry->size);
+      l2_weights_size += entry->size;
+      continue;
+    }
+
+    if (run_size > 0 && entry->offset != run_offset + run_size) {
+      mem_blob_load_to_ram(&blob, w_ptr, run_offset, run_size);
+      w_ptr += run_size;
+      run_size = 0;
+    }
+    if (run_size == 0) {
+      run_offset = entry->offset;
+    }
+    run_size += entry->size;
   }
 
-  uint32_t flash_weights_size = w_ptr - L3_weights;
-  if (flash_weights_size != FLASH_WEIGHTS_SIZE) {
+  mem_blob_load_to_ram(&blob, w_ptr, run_offset, run_size);
+  w_ptr += run_size;
+  mem_blob_close(&blob);
+
+  uint32_t flash_weights_size = (w_ptr - state->L3_weights) + l2_weights_size;
+  if (flash_weights_size != network->L3_weights_size) {
     ASSERTION_FAILURE(
-      "Flash weights size mismatch: read %dB but expected %dB\n", flash_weights_size, FLASH_WEIGHTS_SIZE
+      "Flash weights size mismatch: read %dB but expected %dB\n", flash_weights_size, network->L3_weights_size
     );
   }
+
+#if NETWORK_VERBOSE
+  printf("L2 weights resident		%dB, %dB loaded from L3 at each inference\n", l2_weights_size, w_ptr - state->L3_weights);
+#endif
 }
 
-void network_terminate() {
+void network_terminate(const network_t *network) {
+  network_state_t *state = network->state;
+
+  if (--state->init_count > 0) {
+    return;
+  }
+
   // Free HyperRAM memory
-  ram_free(L3_output, L3_OUTPUT_SIZE);
-  ram_free(L3_input, L3_INPUT_SIZE);
-  ram_free(L3_weights, FLASH_WEIGHTS_SIZE);
+  ram_free(state->L3_output, network->L3_output_size);
+  ram_free(state->L3_input, network->L3_input_size);
+  ram_free(state->L3_weights, network->L3_weights_size);
 }
 
-void network_run_async(const void *l2_input, void *l2_output, void *l2_buffer, size_t l2_buffer_size, int exec, pi_device_t *cluster, pi_task_t *input_done, pi_task_t *network_done) {
-  if (l2_buffer_size != NETWORK_L2_BUFFER_SIZE) {
+void network_run_async(const network_t *network, const void *l2_input, void *l2_output, void *l2_buffer, size_t l2_buffer_size, pi_device_t *cluster, pi_task_t *input_done, pi_task_t *network_done) {
+  if (l2_buffer_size < network->L2_buffer_size) {
+    ASSERTION_FAILURE(
+      "L2 buffer too small for %s: got %dB but expected %dB\n", network->name, l2_buffer_size, network->L2_buffer_size
+    );
+  }
+
+  if (network_in_flight == NETWORK_MAX_QUEUED) {
     ASSERTION_FAILURE(
-      "L2 buffer size mismatch: got %dB but expected %dB\n", l2_buffer_size, NETWORK_L2_BUFFER_SIZE
+      "Too many runs of %s in flight: at most %d\n", network->name, NETWORK_MAX_QUEUED
     );
   }
+  network_in_flight++;
 
-  network_args = (network_args_t){
-    .l2_input = l2_input, 
+  network_args_t *args = &network_args[network_next_task];
+  struct pi_cluster_task *task = &network_task[network_next_task];
+  network_next_task = (network_next_task + 1) % NETWORK_MAX_QUEUED;
+
+  *args = (network_args_t){
+    .network = network,
+    .l2_input = l2_input,
     .l2_output = l2_output,
     .l2_buffer = l2_buffer,
     .l2_buffer_size = l2_buffer_size,
-    .exec = exec,
-    .input_done = input_done
+    .input_done = input_done,
+    .network_done = network_done
   };
 
-  pi_cluster_task(&network_task, network_run_cluster, &network_args);
-  network_task.stack_size = 3500;
-  network_task.slave_stack_size = 3400;
+  pi_cluster_task(task, network_run_cluster, args);
+  task->stack_size = network->stack_size;
+  task->slave_stack_size = network->slave_stack_size;
+
+  pi_cluster_send_task_to_cl_async(cluster, task, pi_task_callback(&args->done_task, network_run_done, args));
+}
+
+static void network_run_done(void *network_args) {
+  network_args_t *args = (network_args_t *)network_args;
 
-  pi_cluster_send_task_to_cl_async(cluster, &network_task, network_done);
+  network_in_flight--;
+  pi_task_push(args->network_done);
 }
 
 static void network_run_cluster(void *network_args) {
   network_args_t *args = (network_args_t *)network_args;
+  const network_t *network = args->network;
+  network_state_t *state = network->state;
+  const network_layer_t *layers = network->layers;
+  const int n_layers = network->n_layers;
 
-  bool l2_input_managed = (args->l2_input >= args->l2_buffer) && (args->l2_input < args->l2_buffer + NETWORK_L2_BUFFER_SIZE);
+  bool l2_input_managed = (args->l2_input >= args->l2_buffer) && (args->l2_input < args->l2_buffer + args->l2_buffer_size);
   bool l2_input_start   = (args->l2_input == args->l2_buffer);
-  bool l2_input_end     = (args->l2_input == (args->l2_buffer - NETWORK_INPUT_SIZE));
-
-  int exec = args->exec;
+  bool l2_input_end     = (args->l2_input == (args->l2_buffer - network->input_size));
 
 /*
   - initial buffer allocation L2 and L1
@@ -150,13 +233,21 @@ static void network_run_cluster(void *network_args) {
   void *L2_output = NULL;
   void *L2_input = NULL;
   void *L2_weights = NULL;
-  void *L3_weights_curr = L3_weights;
+  void *L3_weights_curr = state->L3_weights;
+  void *L3_input = state->L3_input;
+  void *L3_output = state->L3_output;
+  void **layers_pointers = state->layers_pointers;
   void *bypass_activations = NULL;
 
   int dir = 1;
   int residual_number = 0;
   int bypass_dimension = 0;
   int perf_cyc = 0;
+#ifdef NETWORK_PROFILE
+  // The same event is counted in all layers of a run
+  const int profile_event = state->profile_runs % NETWORK_PROFILE_N_EVENTS;
+  uint32_t l3_cycles = 0;
+#endif
 /* ---------------------------------- */
 /* --------- SECTION 0 END ---------- */
 /* ---------------------------------- */
@@ -173,7 +264,7 @@ static void network_run_cluster(void *network_args) {
 /* ---------------------------------- */
 /* --------- SECTION 1 END ---------- */
 /* ---------------------------------- */
-  cycle_network_execution = 0;
+  uint32_t cycle_network_execution = 0;
 
 /* MAIN SECTION
   - for loop over all the layers of the network
@@ -184,8 +275,9 @@ static void network_run_cluster(void *network_args) {
 /* ---------------------------------- */
 /* -------- SECTION 2 BEGIN --------- */
 /* ---------------------------------- */
-  int weight_l_cnt = 0; // count how many layers with weights we have processed to increment the weights_L3 pointer
-  for (int i = 0; i < 9; i++) {
+  for (int i = 0; i < n_layers; i++) {
+    const network_layer_t *layer = &layers[i];
+
 /* MEMORY ALLOCATION
   - allocate memory if layer is executed from L3;
   - allocate weights
@@ -196,7 +288,7 @@ static void network_run_cluster(void *network_args) {
         // Nothing to do
       } else if (l2_input_start) {
         // Reserve space in the directional allocator for the input buffer
-        dmalloc(activations_size[i], dir);
+        dmalloc(layer->activations_size, dir);
       } else if (l2_input_end) {
         ASSERTION_FAILURE("TODO: supplying L2 input at the end of L2 buffer is not implemented");
       } else {
@@ -204,73 +296,107 @@ static void network_run_cluster(void *network_args) {
       }
 
       L2_input = args->l2_input;
-    } else if (L3_input_layers[i] == 1) {
-      L2_input = dmalloc(activations_size[i], dir);
+    } else if (layer->L3_input) {
+      L2_input = dmalloc(layer->activations_size, dir);
     }
 
-    L2_output = dmalloc(activations_out_size[i], !dir);
+    L2_output = dmalloc(layer->activations_out_size, !dir);
 
-    if (layer_with_weights[i] == 1) {
-      L2_weights = dmalloc(weights_size[i], dir);
+    // Resident weights are used in place, the others are copied from L3 to the L2 buffer
+    bool weights_copied = layer->weights_size > 0 && layer->L2_weights == NULL;
+
+    if (layer->L2_weights) {
+      L2_weights = layer->L2_weights;
+    } else if (weights_copied) {
+      L2_weights = dmalloc(layer->weights_size, dir);
     }
 
-    if (allocate_layer[i] == 1) {
-      cl_ram_read(L2_weights, L3_weights_curr, weights_size[i]);
+    if (layer->allocate && weights_copied) {
+#ifdef NETWORK_PROFILE
+      pi_perf_conf(1<<PI_PERF_CYCLES);
+      pi_perf_reset();
+      pi_perf_start();
+#endif
+      cl_ram_read(L2_weights, L3_weights_curr, layer->weights_size);
+#ifdef NETWORK_PROFILE
+      pi_perf_stop();
+      l3_cycles = pi_perf_read(PI_PERF_CYCLES);
+#endif
     }
 
 #if NETWORK_VERBOSE
-    if (i == 0 || branch_change[i-1] == 0) {
-      if (L3_input_layers[i] == 1)
-        checksumL3("L3 input", L3_input, L2_input, L3_activations_size[i], activations_checksum[i][exec]);
+    if (i == 0 || layers[i-1].branch_change == 0) {
+      if (layer->L3_input)
+        checksumL3("L3 input", L3_input, L2_input, layer->L3_activations_size, layer->activations_checksum);
       else
-        checksum("L2 input", L2_input, activations_size[i], activations_checksum[i][exec]);
+        checksum("L2 input", L2_input, layer->activations_size, layer->activations_checksum);
 
-      if (layer_with_weights[i]) {
-        if (allocate_layer[i] == 0)
-          checksumL3("L3 weights", L3_weights_curr, L2_weights, L3_weights_size[weight_l_cnt], weights_checksum[i]);
+      if (layer->weights_size > 0) {
+        if (!layer->allocate)
+          checksumL3("L3 weights", L3_weights_curr, L2_weights, layer->weights_size, layer->weights_checksum);
         else
-          checksum("L2 weights", L2_weights, weights_size[i], weights_checksum[i]);
+          checksum("L2 weights", L2_weights, layer->weights_size, layer->weights_checksum);
       }
     } else {
       printf("Switching branch, already checked activation\n");
     }
 #endif
 
-    layer_args_t largs = {
-      .L3_input = (unsigned int) L3_input,
-      .L3_output = (unsigned int) L3_output,
-      .L3_after_weights = (unsigned int) L3_weights_curr,
-      .L2_input = (unsigned int) L2_input,
-      .bypass = (unsigned int) bypass_activations,
-      .L2_output = (unsigned int) L2_output,
-      .L2_weights = (unsigned int) L2_weights,
-      .L1_buffer = 0,
-      .ram = (unsigned int) get_ram_ptr(),
-      .out_mult = (unsigned int) out_mult_vector[i],
-      .out_shift = (unsigned int) out_shift_vector[i],
-      .layer_id = i
+    layer_fork_args_t fork_args = {
+      .network = network,
+      .largs = {
+        .L3_input = (unsigned int) L3_input,
+        .L3_output = (unsigned int) L3_output,
+        .L3_after_weights = (unsigned int) L3_weights_curr,
+        .L2_input = (unsigned int) L2_input,
+        .bypass = (unsigned int) bypass_activations,
+        .L2_output = (unsigned int) L2_output,
+        .L2_weights = (unsigned int) L2_weights,
+        .L1_buffer = 0,
+        .ram = (unsigned int) get_ram_ptr(),
+        .out_mult = (unsigned int) layer->out_mult,
+        .out_shift = (unsigned int) layer->out_shift,
+        .layer_id = i
+      }
     };
 
 /*
 - Execution of the layers_pointers
 */
     // BEGIN PERFORMANCE MEASUREMENTS
+#ifdef NETWORK_PROFILE
+    pi_perf_conf((1<<PI_PERF_CYCLES) | (1<<profile_events[profile_event]));
+    dory_dma_wait_cycles = 0;
+#else
     pi_perf_conf(1<<PI_PERF_CYCLES);
+#endif
     pi_perf_reset();
     pi_perf_stop();
     pi_perf_start();
-    execute_layer_fork((void *)&largs);
+    execute_layer_fork(&fork_args);
     pi_perf_stop();
     perf_cyc = pi_perf_read(PI_PERF_CYCLES);
     cycle_network_execution += perf_cyc;
+
+#ifdef NETWORK_PROFILE
+    if (state->profile) {
+      network_profile_layer_t *profile = &state->profile[i];
+      profile->cycles = perf_cyc;
+      profile->dma_wait_cycles = dory_dma_wait_cycles;
+      profile->l3_cycles = l3_cycles;
+      profile->events[profile_event] = pi_perf_read(profile_events[profile_event]);
+      profile->events_valid |= 1 << profile_event;
+      l3_cycles = 0;
+    }
+#endif
     // END PERFORMANCE MEASUREMENTS
 
 #if NETWORK_VERBOSE
-    printf("Layer %s %d ended\n", Layers_name[i], i);
-    if (L3_output_layers[i] == 1) {
-      checksumL3("L3 output", L3_output, L2_output, L3_activations_out_size[i], activations_out_checksum[i][exec]);
+    printf("Layer %s %d ended\n", layer->name, i);
+    if (layer->L3_output) {
+      checksumL3("L3 output", L3_output, L2_output, layer->L3_activations_out_size, layer->activations_out_checksum);
     } else {
-      checksum("L2 output", L2_output, activations_out_size[i], activations_out_checksum[i][exec]);
+      checksum("L2 output", L2_output, layer->activations_out_size, layer->activations_out_checksum);
     }
     printf("\n");
 #endif
@@ -278,15 +404,15 @@ static void network_run_cluster(void *network_args) {
     // TODO: What error?
     // prevents error from compiler
     asm volatile("": : :"memory");
-    unsigned int temp = L3_input;
+    void *temp = L3_input;
     L3_input = L3_output;
     asm volatile("": : :"memory");
     L3_output = temp;
     asm volatile("": : :"memory");
 
     // Free memory
-    if (layer_with_weights[i] == 1) {
-      dfree(weights_size[i], dir);
+    if (weights_copied) {
+      dfree(layer->weights_size, dir);
     }
 
     if (i == 0) {
@@ -294,7 +420,7 @@ static void network_run_cluster(void *network_args) {
         // Nothing to do
       } else if (l2_input_start) {
         // Free space in the directional allocator that was reserved for the input
-        dfree(activations_size[i], dir);
+        dfree(layer->activations_size, dir);
       } else if (l2_input_end) {
         ASSERTION_FAILURE("TODO: supplying L2 input at the end of L2 buffer is not implemented");
       } else {
@@ -305,18 +431,18 @@ static void network_run_cluster(void *network_args) {
         pi_cl_send_task_to_fc(args->input_done);
       }
     } else {
-      dfree(activations_size[i], dir);
+      dfree(layer->activations_size, dir);
     }
 
-    if (branch_input[i] == 1) {
+    if (layer->branch_input) {
       dfree(bypass_dimension, dir);
     }
 
     L2_input = L2_output;
 
     // Residual connections
-    if (i < 8) {
-      if (branch_input[i+1] == 1) {
+    if (i < n_layers - 1) {
+      if (layers[i+1].branch_input) {
         bypass_activations = dmalloc(bypass_dimension, !dir);
         residual_number--;
         cl_ram_read(bypass_activations, layers_pointers[residual_number], bypass_dimension);
@@ -324,33 +450,34 @@ static void network_run_cluster(void *network_args) {
       }
 
       // TODO I feel like this should look ahead instead of back
-      if (i > 0 && branch_output[i-1]==1 && L3_input_layers[i]==1) { // TODO don't understand this condition
+      if (i > 0 && layers[i-1].branch_output && layer->L3_input) { // TODO don't understand this condition
         L3_input = cl_ram_malloc(1500000);
       }
-      if (branch_output[i]==1 && L3_output_layers[i]==1) {
-        cl_ram_free(L3_input + activations_out_size[i], 1500000 - activations_out_size[i]);
+      if (layer->branch_output && layer->L3_output) {
+        cl_ram_free(L3_input + layer->activations_out_size, 1500000 - layer->activations_out_size);
         layers_pointers[residual_number] = L3_input;
         residual_number++;
-        bypass_dimension = activations_out_size[i];
+        bypass_dimension = layer->activations_out_size;
       } else
-    if (branch_output[i]==1 || branch_change[i] == 1) {
-        layers_pointers[residual_number] = cl_ram_malloc(activations_out_size[i]);
-        cl_ram_write(layers_pointers[residual_number], L2_output, activations_out_size[i]);
+    if (layer->branch_output || layer->branch_change) {
+        layers_pointers[residual_number] = cl_ram_malloc(layer->activations_out_size);
+        cl_ram_write(layers_pointers[residual_number], L2_output, layer->activations_out_size);
         residual_number++;
-        bypass_dimension = activations_out_size[i];
+        bypass_dimension = layer->activations_out_size;
     }
 
-      if (branch_change[i]==1) {
-        dfree(activations_out_size[i], !dir);
-        L2_input = dmalloc(activations_size[i + 1], !dir);
-        cl_ram_read(L2_input, layers_pointers[residual_number - 2], activations_size[i + 1]);
-        cl_ram_free(layers_pointers[residual_number - 2], activations_size[i + 1]);
+      if (layer->branch_change) {
+        dfree(layer->activations_out_size, !dir);
+        L2_input = dmalloc(layers[i + 1].activations_size, !dir);
+        cl_ram_read(L2_input, layers_pointers[residual_number - 2], layers[i + 1].activations_size);
+        cl_ram_free(layers_pointers[residual_number - 2], layers[i + 1].activations_size);
       }
-      if (L3_output_layers[i] == 1)
-        dfree(activations_out_size[i], !dir);
+      if (layer->L3_output)
+        dfree(layer->activations_out_size, !dir);
+    }
+    if (weights_copied) {
+      L3_weights_curr += layer->weights_size;
     }
-    if (layer_with_weights[i])
-       L3_weights_curr += L3_weights_size[weight_l_cnt++];
     dir = !dir;
   }
 
@@ -362,12 +489,20 @@ static void network_run_cluster(void *network_args) {
 /* -------- SECTION 3 BEGIN --------- */
 /* ---------------------------------- */
 
-  memmove(args->l2_output, L2_output, activations_out_size[8]);
+  const network_layer_t *last_layer = &layers[n_layers - 1];
+  memmove(args->l2_output, L2_output, last_layer->activations_out_size);
+
+  state->L3_input = L3_input;
+  state->L3_output = L3_output;
+  state->cycles = cycle_network_execution;
+#ifdef NETWORK_PROFILE
+  state->profile_runs++;
+#endif
 
 #if NETWORK_VERBOSE
-  checksum("Final output", args->l2_output, activations_out_size[8], activations_out_checksum[8][exec]);
+  checksum("Final output", args->l2_output, last_layer->activations_out_size, last_layer->activations_out_checksum);
 
-  print_perf("Final", cycle_network_execution, 14138880);
+  print_perf("Final", cycle_network_execution, network->macs);
 #endif
 
 /* ---------------------------------- */
@@ -375,52 +510,44 @@ static void network_run_cluster(void *network_args) {
 /* ---------------------------------- */
 }
 
-static void execute_layer_fork(void *layer_args) {
-  layer_args_t *largs = (layer_args_t *)layer_args;
-  
+static void execute_layer_fork(layer_fork_args_t *fork_args) {
+  layer_args_t *largs = &fork_args->largs;
+  const network_t *network = fork_args->network;
+
   if (pi_core_id() == 0)
-    largs->L1_buffer = pmsis_l1_malloc(36700);
-
-  switch (largs->layer_id) {
-    case 0:
-      pi_cl_team_fork(NUM_CORES, (void *)layer0_BNReluConvolution, largs);
-      break;
-    case 1:
-      pi_cl_team_fork(NUM_CORES, (void *)layer1_Pooling, largs);
-      break;
-    case 2:
-      pi_cl_team_fork(NUM_CORES, (void *)layer2_BNReluConvolution, largs);
-      break;
-    case 3:
-      pi_cl_team_fork(NUM_CORES, (void *)layer3_BNReluConvolution, largs);
-      break;
-    case 4:
-      pi_cl_team_fork(NUM_CORES, (void *)layer4_BNReluConvolution, largs);
-      break;
-    case 5:
-      pi_cl_team_fork(NUM_CORES, (void *)layer5_BNReluConvolution, largs);
-      break;
-    case 6:
-      pi_cl_team_fork(NUM_CORES, (void *)layer6_BNReluConvolution, largs);
-      break;
-    case 7:
-      pi_cl_team_fork(NUM_CORES, (void *)layer7_BNReluConvolution, largs);
-      break;
-    case 8:
-      pi_cl_team_fork(NUM_CORES, (void *)layer8_FullyConnected, largs);
-      break;
-  }
+    largs->L1_buffer = pmsis_l1_malloc(network->L1_buffer_size);
+
+  pi_cl_team_fork(NUM_CORES, (void *)network->layers[largs->layer_id].run, largs);
 
   if (pi_core_id() == 0)
-    pmsis_l1_malloc_free(largs->L1_buffer, 36700);
+    pmsis_l1_malloc_free(largs->L1_buffer, network->L1_buffer_size);
 }
 
-static float network_out_eps[NETWORK_OUTPUT_COUNT] = {
-  0.0000073591854743f, 0.0000133181438287f, 0.0000051428660299f, 0.0000095041359600f
-};
+void network_dequantize_output(const network_t *network, const NETWORK_OUTPUT_TYPE *l2_output, float *l2_output_f32) {
+  for (int i = 0; i < network->output_count; i++) {
+    l2_output_f32[i] = l2_output[i] * network->output_eps[i];
+  }
+}
 
-void network_dequantize_output(const NETWORK_OUTPUT_TYPE *l2_output, float *l2_output_f32) {
-  for (int i = 0; i < NETWORK_OUTPUT_COUNT; i++) {
-    l2_output_f32[i] = l2_output[i] * network_out_eps[i];
+void network_profile_print(const network_t *network) {
+  const network_profile_layer_t *profile = network->state->profile;
+  if (profile == NULL) {
+    printf("%s: profile not recorded, enable NETWORK_PROFILE\n", network->name);
+    return;
+  }
+
+  // Events are printed as -1 until they have been sampled
+  printf("%s profile, %d runs\n", network->name, network->state->profile_runs);
+  printf("%-34s %9s %9s %9s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+    "layer", "MACs", "cycles", "DMA wait", "L3", "active", "instr", "ld stall", "jr stall", "imiss", "ld ext", "st ext", "tcdm cont"
+  );
+
+  for (int i = 0; i < network->n_layers; i++) {
+    const network_profile_layer_t *layer = &profile[i];
+    printf("%-34s %9d %9d %9d %9d", network->layers[i].name, network->layers[i].macs, layer->cycles, layer->dma_wait_cycles, layer->l3_cycles);
+    for (int e = 0; e < NETWORK_PROFILE_N_EVENTS; e++) {
+      printf(" %9d", (layer->events_valid & (1 << e)) ? (int)layer->events[e] : -1);
+    }
+    printf("\n");
   }
 }
@@ -0,0 +1,208 @@
+/*
+ * network_frontnet.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ * Alessio Burrello <alessio.burrello@unibo.it>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *               2019-2020 University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "config.h"
+
+#include "network.h"
+#include "network_frontnet_plan.h"
+
+#include "layer0_BNReluConvolution.h"
+#include "layer0_BNReluConvolution_Pooling.h"
+#include "layer1_Pooling.h"
+#include "layer2_BNReluConvolution.h"
+#include "layer3_BNReluConvolution.h"
+#include "layer4_BNReluConvolution.h"
+#include "layer5_BNReluConvolution.h"
+#include "layer6_BNReluConvolution.h"
+#include "layer7_BNReluConvolution.h"
+#include "layer8_FullyConnected.h"
+
+// Weights kept in L2 by the plan generated by plan_l2.py, NULL if loaded from L3 at each inference
+#define RESIDENT(weights) NETWORK_FRONTNET_RESIDENT_##weights
+
+// The layers after the first pooling are shared by both variants
+#define LAYERS_COMMON \
+  { \
+    .name = "layer2_BNReluConvolution", .run = layer2_BNReluConvolution, \
+    .weights_file = "layer2_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer2_BNReluConvolution_weights), \
+    .weights_size = 9728, .activations_size = 30720, .activations_out_size = 7680, \
+    .out_mult = 1, .out_shift = 24, .macs = 2211840, \
+    .weights_checksum = 1217408, .activations_checksum = 51732, .activations_out_checksum = 20816, \
+  }, \
+  { \
+    .name = "layer3_BNReluConvolution", .run = layer3_BNReluConvolution, \
+    .weights_file = "layer3_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer3_BNReluConvolution_weights), \
+    .weights_size = 9728, .activations_size = 7680, .activations_out_size = 7680, \
+    .out_mult = 1, .out_shift = 24, .macs = 2211840, \
+    .weights_checksum = 1240539, .activations_checksum = 20816, .activations_out_checksum = 19410, \
+  }, \
+  { \
+    .name = "layer4_BNReluConvolution", .run = layer4_BNReluConvolution, \
+    .weights_file = "layer4_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer4_BNReluConvolution_weights), \
+    .weights_size = 19456, .activations_size = 7680, .activations_out_size = 3840, \
+    .out_mult = 1, .out_shift = 24, .macs = 1105920, \
+    .weights_checksum = 2517541, .activations_checksum = 19410, .activations_out_checksum = 5783, \
+  }, \
+  { \
+    .name = "layer5_BNReluConvolution", .run = layer5_BNReluConvolution, \
+    .weights_file = "layer5_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer5_BNReluConvolution_weights), \
+    .weights_size = 37888, .activations_size = 3840, .activations_out_size = 3840, \
+    .out_mult = 1, .out_shift = 24, .macs = 2211840, \
+    .weights_checksum = 5044551, .activations_checksum = 5783, .activations_out_checksum = 7242, \
+  }, \
+  { \
+    .name = "layer6_BNReluConvolution", .run = layer6_BNReluConvolution, \
+    .weights_file = "layer6_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer6_BNReluConvolution_weights), \
+    .weights_size = 75776, .activations_size = 3840, .activations_out_size = 1920, \
+    .out_mult = 1, .out_shift = 24, .macs = 1105920, \
+    .weights_checksum = 9495994, .activations_checksum = 7242, .activations_out_checksum = 1511, \
+  }, \
+  { \
+    .name = "layer7_BNReluConvolution", .run = layer7_BNReluConvolution, \
+    .weights_file = "layer7_BNReluConvolution_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer7_BNReluConvolution_weights), \
+    .weights_size = 149504, .activations_size = 1920, .activations_out_size = 1920, \
+    .out_mult = 1, .out_shift = 24, .macs = 2211840, \
+    .weights_checksum = 20668135, .activations_checksum = 1511, .activations_out_checksum = 12249, \
+  }, \
+  { \
+    .name = "layer8_FullyConnected", .run = layer8_FullyConnected, \
+    .weights_file = "layer8_FullyConnected_weights.hex", .allocate = 1, \
+    .L2_weights = RESIDENT(layer8_FullyConnected_weights), \
+    .weights_size = 7696, .activations_size = 1920, .activations_out_size = 16, \
+    .out_mult = 1, .out_shift = 0, .macs = 7680, \
+    .weights_checksum = 914121, .activations_checksum = 12249, .activations_out_checksum = 1322, \
+  },
+
+#define N_LAYERS (8)
+#define N_LAYERS_UNFUSED (9)
+
+// The first convolution and pooling run as a single layer, see layer0_BNReluConvolution_Pooling.c
+static const network_layer_t layers[N_LAYERS] = {
+  {
+    .name = "layer0_BNReluConvolution_Pooling", .run = layer0_BNReluConvolution_Pooling,
+    .weights_file = "layer0_BNReluConvolution_weights.hex", .allocate = 1,
+    .L2_weights = RESIDENT(layer0_BNReluConvolution_weights),
+    .weights_size = 1312, .activations_size = 15360, .activations_out_size = 30720,
+    .out_mult = 1, .out_shift = 24, .macs = 3072000,
+    .weights_checksum = 129408, .activations_checksum = 810934, .activations_out_checksum = 51732,
+  },
+  LAYERS_COMMON
+};
+
+// As generated by DORY, used as reference for the fused layer
+static const network_layer_t layers_unfused[N_LAYERS_UNFUSED] = {
+  {
+    .name = "layer0_BNReluConvolution", .run = layer0_BNReluConvolution,
+    .weights_file = "layer0_BNReluConvolution_weights.hex", .allocate = 1,
+    .L2_weights = RESIDENT(layer0_BNReluConvolution_weights),
+    .weights_size = 1312, .activations_size = 15360, .activations_out_size = 122880,
+    .out_mult = 1, .out_shift = 24, .macs = 3072000,
+    .weights_checksum = 129408, .activations_checksum = 810934, .activations_out_checksum = 141585,
+  },
+  {
+    .name = "layer1_Pooling", .run = layer1_Pooling,
+    .weights_file = NULL, .allocate = 0,
+    .weights_size = 0, .activations_size = 122880, .activations_out_size = 30720,
+    .out_mult = 1, .out_shift = 0, .macs = 0,
+    .weights_checksum = 0, .activations_checksum = 141585, .activations_out_checksum = 51732,
+  },
+  LAYERS_COMMON
+};
+
+static const float output_eps[NETWORK_OUTPUT_COUNT] = {
+  0.0000073591854743f, 0.0000133181438287f, 0.0000051428660299f, 0.0000095041359600f
+};
+
+static void *layers_pointers[N_LAYERS];
+static void *layers_pointers_unfused[N_LAYERS_UNFUSED];
+
+#ifdef NETWORK_PROFILE
+static network_profile_layer_t profile[N_LAYERS];
+static network_profile_layer_t profile_unfused[N_LAYERS_UNFUSED];
+#endif
+
+static network_state_t state = {
+  .layers_pointers = layers_pointers,
+#ifdef NETWORK_PROFILE
+  .profile = profile,
+#endif
+};
+
+static network_state_t state_unfused = {
+  .layers_pointers = layers_pointers_unfused,
+#ifdef NETWORK_PROFILE
+  .profile = profile_unfused,
+#endif
+};
+
+const network_t network_frontnet = {
+  .name = "frontnet-160x32-bgaug",
+
+  .layers = layers,
+  .n_layers = N_LAYERS,
+  .weights_blob = "weights.hex",
+
+  .L3_weights_size = 311088,
+  .L3_input_size = 0,
+  .L3_output_size = 0,
+  .L2_buffer_size = NETWORK_FRONTNET_L2_BUFFER_SIZE,
+  .L1_buffer_size = 36700,
+
+  .input_size = NETWORK_INPUT_SIZE,
+  .output_count = NETWORK_OUTPUT_COUNT,
+  .output_eps = output_eps,
+
+  .macs = 14138880,
+  .stack_size = 3500,
+  .slave_stack_size = 3400,
+
+  .state = &state,
+};
+
+const network_t network_frontnet_unfused = {
+  .name = "frontnet-160x32-bgaug-unfused",
+
+  .layers = layers_unfused,
+  .n_layers = N_LAYERS_UNFUSED,
+  .weights_blob = "weights.hex",
+
+  .L3_weights_size = 311088,
+  .L3_input_size = 0,
+  .L3_output_size = 0,
+  .L2_buffer_size = NETWORK_FRONTNET_UNFUSED_L2_BUFFER_SIZE,
+  .L1_buffer_size = 36700,
+
+  .input_size = NETWORK_INPUT_SIZE,
+  .output_count = NETWORK_OUTPUT_COUNT,
+  .output_eps = output_eps,
+
+  .macs = 14138880,
+  .stack_size = 3500,
+  .slave_stack_size = 3400,
+
+  .state = &state_unfused,
+};
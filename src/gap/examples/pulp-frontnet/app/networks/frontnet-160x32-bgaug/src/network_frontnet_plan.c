@@ -0,0 +1,30 @@
+/*
+ * network_frontnet_plan.c
+ * Generated by plan_l2.py, do not edit.
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "network_frontnet_plan.h"
+
+#include <pmsis.h>
+
+PI_L2 uint8_t network_frontnet_layer0_BNReluConvolution_weights[1312] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer2_BNReluConvolution_weights[9728] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer3_BNReluConvolution_weights[9728] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer4_BNReluConvolution_weights[19456] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer5_BNReluConvolution_weights[37888] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer6_BNReluConvolution_weights[75776] __attribute__((aligned(8)));
+PI_L2 uint8_t network_frontnet_layer7_BNReluConvolution_weights[149504] __attribute__((aligned(8)));
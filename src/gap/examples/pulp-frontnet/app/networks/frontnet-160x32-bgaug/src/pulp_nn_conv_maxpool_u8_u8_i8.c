@@ -0,0 +1,89 @@
+/*
+ * pulp_nn_conv_maxpool_u8_u8_i8.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nn_utils.h"
+#include "pulp_nn_kernels.h"
+
+
+/*
+ * Convolution (with BN and ReLU) followed by an unpadded max pooling, with the convolution output
+ * kept in the pConv scratch buffer. pConv must hold dim_conv_x * dim_conv_y * ch_out bytes and is
+ * overwritten by the pooling, which works in place along x. The pooling windows must not cross
+ * the borders of the tile, i.e. dim_conv_x and dim_conv_y must be multiples of the pool strides,
+ * for the tiled output to be identical to that of the two separate layers.
+ */
+void pulp_nn_conv_maxpool_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pConv,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mult,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_conv_x,
+                        uint16_t dim_conv_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batch_norm,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t pool_kernel_x,
+                        uint16_t pool_kernel_y,
+                        uint16_t pool_stride_x,
+                        uint16_t pool_stride_y)
+{
+  // Both kernels end with a team barrier, pConv is complete before the pooling starts
+  pulp_nn_conv_u8_u8_i8(
+    pIn, pIm2ColBuffer,
+    pBias,
+    pConv, pWeight,
+    pKappa, pLambda,
+    out_mult, out_shift,
+    dim_in_x, dim_in_y, ch_in,
+    dim_conv_x, dim_conv_y, ch_out,
+    dim_kernel_x, dim_kernel_y,
+    padding_y_top, padding_y_bottom, padding_x_left, padding_x_right,
+    stride_x, stride_y,
+    flag_relu, flag_batch_norm
+    );
+
+  pulp_nn_maxpool_u8(
+    pConv, pOut,
+    dim_conv_x, dim_conv_y, ch_out,
+    dim_out_x, dim_out_y,
+    pool_kernel_x, pool_kernel_y,
+    0, 0, 0, 0,
+    pool_stride_x, pool_stride_y
+    );
+}
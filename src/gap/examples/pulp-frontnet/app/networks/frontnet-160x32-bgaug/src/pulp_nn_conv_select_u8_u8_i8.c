@@ -0,0 +1,88 @@
+/*
+ * pulp_nn_conv_select_u8_u8_i8.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nn_utils.h"
+#include "pulp_nn_kernels.h"
+
+
+/*
+ * Convolution kernel selected by the shape of the tile, called by the layers in place of
+ * pulp_nn_conv_u8_u8_i8. Depthwise layers go to pulp_nn_depthwise_u8_u8_i8, 1x1 convolutions with
+ * stride 1 and no padding to pulp_nn_pointwise_u8_u8_i8, which skips im2col, and everything else
+ * to the generic kernel. All kernels produce the same output, pIm2ColBuffer must be sized for the
+ * generic one.
+ */
+void pulp_nn_conv_select_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mult,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batch_norm,
+                        uint8_t flag_depthwise)
+{
+  if (flag_depthwise)
+  {
+    pulp_nn_depthwise_u8_u8_i8(
+      pIn, pIm2ColBuffer, pBias, pOut, pWeight, NULL, pKappa, pLambda, out_mult, out_shift,
+      dim_in_x, dim_in_y, ch_in, dim_out_x, dim_out_y, ch_out, dim_kernel_x, dim_kernel_y,
+      padding_y_top, padding_y_bottom, padding_x_left, padding_x_right, stride_x, stride_y,
+      flag_relu, flag_batch_norm
+      );
+  }
+  else if (dim_kernel_x == 1 && dim_kernel_y == 1 && stride_x == 1 && stride_y == 1
+    && (padding_y_top | padding_y_bottom | padding_x_left | padding_x_right) == 0)
+  {
+    pulp_nn_pointwise_u8_u8_i8(
+      pIn, pIm2ColBuffer, pBias, pOut, pWeight, pKappa, pLambda, out_mult, out_shift,
+      dim_in_x, dim_in_y, ch_in, dim_out_x, dim_out_y, ch_out, dim_kernel_x, dim_kernel_y,
+      padding_y_top, padding_y_bottom, padding_x_left, padding_x_right, stride_x, stride_y,
+      flag_relu, flag_batch_norm
+      );
+  }
+  else
+  {
+    pulp_nn_conv_u8_u8_i8(
+      pIn, pIm2ColBuffer, pBias, pOut, pWeight, pKappa, pLambda, out_mult, out_shift,
+      dim_in_x, dim_in_y, ch_in, dim_out_x, dim_out_y, ch_out, dim_kernel_x, dim_kernel_y,
+      padding_y_top, padding_y_bottom, padding_x_left, padding_x_right, stride_x, stride_y,
+      flag_relu, flag_batch_norm
+      );
+  }
+}
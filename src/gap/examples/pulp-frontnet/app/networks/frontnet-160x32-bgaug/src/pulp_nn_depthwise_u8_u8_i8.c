@@ -0,0 +1,128 @@
+/*
+ * pulp_nn_depthwise_u8_u8_i8.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nn_utils.h"
+#include "pulp_nn_kernels.h"
+
+
+/*
+ * Depthwise convolution, ch_out == ch_in, with the weights of each channel stored as
+ * [dim_kernel_y][dim_kernel_x]. Each output reads its window straight from the HWC input: the
+ * padding is skipped by clamping the window to the input instead of filling an im2col buffer with
+ * zeros, which would only add zero products. pIm2ColBuffer and pWtBuffer are not used. The rows
+ * are split among the cores, each output is quantized like in pulp_nn_conv_u8_u8_i8.
+ */
+void pulp_nn_depthwise_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int8_t *pWtBuffer,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mult,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batch_norm)
+{
+  int core_id = pi_core_id();
+
+  int chunk = (dim_out_y + NUM_CORES - 1) / NUM_CORES;
+
+  int start_pixel = min(chunk * core_id, dim_out_y);
+  int stop_pixel = min(start_pixel + chunk, dim_out_y);
+
+  int kernel_size = dim_kernel_x * dim_kernel_y;
+  uint8_t *pOutBuffer = pOut + start_pixel * dim_out_x * ch_out;
+
+  for (int i_out_y = start_pixel; i_out_y < stop_pixel; i_out_y++)
+  {
+    int i_in_y = i_out_y * stride_y - padding_y_top;
+    int ker_y_start = i_in_y < 0 ? -i_in_y : 0;
+    int ker_y_stop = min(dim_kernel_y, dim_in_y - i_in_y);
+
+    for (int i_out_x = 0; i_out_x < dim_out_x; i_out_x++)
+    {
+      int i_in_x = i_out_x * stride_x - padding_x_left;
+      int ker_x_start = i_in_x < 0 ? -i_in_x : 0;
+      int ker_x_stop = min(dim_kernel_x, dim_in_x - i_in_x);
+
+      uint8_t *pB = pIn + (i_in_y * dim_in_x + i_in_x) * ch_in;
+      int8_t *pA = pWeight;
+      int8_t *pBias1 = pBias;
+      int64_t *k1 = pKappa;
+      int64_t *lambda1 = pLambda;
+
+      for (int i_ch = 0; i_ch < ch_out; i_ch++)
+      {
+        int sum = 0;
+        if (pBias1 != NULL)
+        {
+          sum = *((int*) pBias1);
+          pBias1 += 4;
+        }
+
+        for (int i_ker_y = ker_y_start; i_ker_y < ker_y_stop; i_ker_y++)
+        {
+          uint8_t *pB1 = pB + (i_ker_y * dim_in_x + ker_x_start) * ch_in + i_ch;
+          int8_t *pA1 = pA + i_ker_y * dim_kernel_x + ker_x_start;
+          for (int i_ker_x = ker_x_start; i_ker_x < ker_x_stop; i_ker_x++)
+          {
+            sum += (*pA1++) * (*pB1);
+            pB1 += ch_in;
+          }
+        }
+        pA += kernel_size;
+
+        if (flag_batch_norm && flag_relu)
+        {
+          *pOutBuffer = pulp_nn_bn_quant_u8(sum, *k1, *lambda1, out_shift);
+          k1++;
+          lambda1++;
+        }
+        else if (flag_relu == 1)
+        {
+          *pOutBuffer = pulp_nn_quant_u8(sum, out_mult, out_shift);
+        }
+        else
+        {
+          *pOutBuffer = (uint8_t) clip8(sum >> out_shift);
+        }
+        pOutBuffer++;
+      }
+    }
+  }
+  pi_cl_team_barrier(0);
+}
@@ -0,0 +1,148 @@
+/*
+ * pulp_nn_pointwise_u8_u8_i8.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pmsis.h"
+#include "pulp_nn_utils.h"
+#include "pulp_nn_kernels.h"
+
+
+/*
+ * 1x1 convolution with stride 1 and no padding. In HWC layout the input pixels are already the
+ * columns that im2col would build, so they are passed to the matmul in place, two at a time. The
+ * pixels are split among the cores in chunks of even size and pIm2ColBuffer is not used. Same
+ * output as pulp_nn_conv_u8_u8_i8 with a 1x1 kernel, bit for bit.
+ */
+void pulp_nn_pointwise_u8_u8_i8(
+                        uint8_t *pIn,
+                        uint8_t *pIm2ColBuffer,
+                        int8_t *pBias,
+                        uint8_t *pOut,
+                        int8_t *pWeight,
+                        int64_t *pKappa,
+                        int64_t *pLambda,
+                        uint16_t out_mult,
+                        uint16_t out_shift,
+                        uint16_t dim_in_x,
+                        uint16_t dim_in_y,
+                        uint16_t ch_in,
+                        uint16_t dim_out_x,
+                        uint16_t dim_out_y,
+                        uint16_t ch_out,
+                        uint16_t dim_kernel_x,
+                        uint16_t dim_kernel_y,
+                        uint16_t padding_y_top,
+                        uint16_t padding_y_bottom,
+                        uint16_t padding_x_left,
+                        uint16_t padding_x_right,
+                        uint16_t stride_x,
+                        uint16_t stride_y,
+                        uint8_t flag_relu,
+                        uint8_t flag_batch_norm)
+{
+  int core_id = pi_core_id();
+
+  int n_pixels = dim_out_x * dim_out_y;
+
+  // Round the chunks up to an even number of pixels, only the last one can be odd
+  int chunk = (n_pixels + NUM_CORES - 1) / NUM_CORES;
+  chunk = (chunk + 1) & ~0x1;
+
+  int start_pixel = min(chunk * core_id, n_pixels);
+  int stop_pixel = min(start_pixel + chunk, n_pixels);
+
+  uint8_t *pB = pIn + start_pixel * ch_in;
+  uint8_t *pOutBuffer = pOut + start_pixel * ch_out;
+
+  int i_pixel;
+  for (i_pixel = start_pixel; i_pixel + 1 < stop_pixel; i_pixel += 2)
+  {
+    pOutBuffer = pulp_nn_matmul_u8_u8_i8(
+      pB,
+      pBias,
+      pOutBuffer,
+      pOutBuffer + ch_out,
+      pWeight,
+      pKappa,
+      pLambda,
+      out_mult,
+      out_shift,
+      ch_in,
+      ch_out,
+      flag_relu,
+      flag_batch_norm
+      );
+
+    pB += (ch_in << 1);
+  }
+
+  if (i_pixel < stop_pixel)
+  {
+    const int8_t *pA = pWeight;
+    int64_t *k1 = pKappa;
+    int64_t *lambda1 = pLambda;
+    int8_t *pBias1 = pBias;
+    for (int i = 0; i < ch_out; i++)
+    {
+      int sum = 0;
+      if (pBias1 != NULL)
+      {
+        sum = *((int*) pBias1);
+        pBias1 += 4;
+      }
+
+      uint8_t *pB1 = pB;
+      uint16_t col_cnt = ch_in >> 2;
+      for (int j = 0; j < col_cnt; j++)
+      {
+        v4s inA = *((v4s*) pA);
+        v4u inB = *((v4u*) pB1);
+
+        sum = SumDotp4(inB, inA, sum);
+        pA += 4;
+        pB1 += 4;
+      }
+      col_cnt = ch_in & 0x3;
+      while (col_cnt)
+      {
+        int8_t inA1 = *pA++;
+        uint8_t inB1 = *pB1++;
+        asm volatile("": : :"memory");
+        sum += inA1 * inB1;
+
+        col_cnt--;
+      }
+      if (flag_batch_norm && flag_relu)
+      {
+        *pOutBuffer = pulp_nn_bn_quant_u8(sum, *k1, *lambda1, out_shift);
+        k1++;
+        lambda1++;
+      }
+      else if (flag_relu == 1)
+      {
+        *pOutBuffer = pulp_nn_quant_u8(sum, out_mult, out_shift);
+      }
+      else
+      {
+        *pOutBuffer = (uint8_t) clip8(sum >> out_shift);
+      }
+      pOutBuffer++;
+    }
+  }
+  pi_cl_team_barrier(0);
+}
@@ -58,11 +58,75 @@
 // Disable streamer: streamer_send_frame_async becomes a no-op and completes immediately
 // #define STREAMER_DISABLE
 
+// Stream the event trace to the host over CPX (see trace_buffer.h)
+// #define TRACE_STREAM
+
+// Exchange clock sync pings with STM32 and NINA, to merge their traces on a single 
+// timeline with trace_merge (see clock_sync.h). Requires TRACE_STREAM.
+// #define CLOCK_SYNC
+
+// Clock sync ping period [us]
+#define CLOCK_SYNC_PERIOD_US        (100000)
+
+/************************* PIPELINE SETTINGS **************************/
+
+// Inferences in flight on the cluster, at most NETWORK_MAX_QUEUED. With 2, the next frame is
+// queued on the cluster while the current one is inferred and starts as soon as it ends. With 1,
+// each inference is sent after the previous one has been postprocessed. DVFS always uses 1.
+#define PIPELINE_INFERENCES_QUEUED  (2)
+
+// Print the throughput and the latency distribution (end of capture to UART) of the onboard
+// inference every PIPELINE_STATS inferences, e.g. to compare HIMAX_FRAME_RATE 30 and 60.
+// Requires NETWORK_ONBOARD_INFERENCE.
+// #define PIPELINE_STATS              (300)
+
 /**************************** SOC SETTINGS ****************************/
 #define SOC_VOLTAGE                 (1200)
 #define SOC_FREQ_FC                 (246000000)
 #define SOC_FREQ_CL                 (175000000)
 
+/**************************** DVFS SETTINGS ***************************/
+
+// Scale the cluster frequency and voltage between inferences, from the slack of each frame
+// (see dvfs.h). One inference at a time is in flight, so that the operating point changes while
+// the cluster is idle and the cluster cycles of each inference give its time at a single
+// frequency. The operating point is streamed with each frame and energy_model estimates its
+// energy on the host. Requires NETWORK_ONBOARD_INFERENCE.
+// #define DVFS
+
+// Print the operating point when it changes
+// #define DVFS_VERBOSE
+
+// Governor mode:
+//  - DVFS_MODE_SLACK: follow the cycles of the latest inference, trades deadline misses for
+//    energy: an inference much slower than the previous one misses the frame period
+//  - DVFS_MODE_DEADLINE: complete the slowest of the latest DVFS_WINDOW inferences and
+//    DVFS_MARGIN times their mean within the frame period, fastest operating point after an
+//    inference longer than the frame period [default]
+//  - DVFS_MODE_FIXED: always the fastest operating point, only reports it
+#define DVFS_MODE                   (DVFS_MODE_DEADLINE)
+
+// Cluster operating points {frequency [Hz], minimum voltage [mV]}, from the slowest to the
+// fastest, which should be SOC_FREQ_CL. Nominal GAP8 limits are 90MHz at 1.0V and 175MHz at
+// 1.2V, the 1.1V one is interpolated: validate them on the board.
+#define DVFS_POINTS                 {{50000000, 1000}, {90000000, 1000}, {130000000, 1100}, {175000000, 1200}}
+
+// Minimum voltage of the FC at SOC_FREQ_FC [mV]. The voltage is shared with the cluster: above
+// 150MHz the FC needs 1.2V and only the cluster frequency is scaled. Lower SOC_FREQ_FC (and
+// HIMAX_FQCY accordingly) to scale the voltage too.
+#define DVFS_FC_VOLTAGE             (1200)
+
+// Share of the frame period the inference can take and, before slowing down, the share that
+// must stay free for DVFS_DOWN_FRAMES consecutive inferences at the slower operating point
+#define DVFS_TARGET                 (0.8f)
+#define DVFS_HYSTERESIS             (0.15f)
+#define DVFS_DOWN_FRAMES            (10)
+
+// Inferences considered by DVFS_MODE_DEADLINE, at most 16, and the worst case it provisions for,
+// relative to their mean (e.g. inferences slowed down by L3 contention)
+#define DVFS_WINDOW                 (16)
+#define DVFS_MARGIN                 (2.0f)
+
 // Target board, used to load the correct pad configurations
 //  - 0: AI-deck [default]
 //  - 1: GAPuino/lab
@@ -186,6 +250,85 @@
 #define CAMERA_CROP_BOTTOM (1)
 #endif
 
+// Preprocess frames on the cluster (crop, downscale and optional gamma LUT) instead of
+// cropping them on the FC (see preprocess.h). With NETWORK_ONBOARD_INFERENCE, the cluster
+// runs preprocessing and inference one after the other.
+// #define CAMERA_PREPROCESS
+
+// Preprocessing output size [px] and resize method
+#define CAMERA_PREPROCESS_WIDTH    (160)
+#define CAMERA_PREPROCESS_HEIGHT   (96)
+#define CAMERA_PREPROCESS_RESIZE   (PREPROCESS_RESIZE_BILINEAR)
+
+// Gamma correction applied after resizing, comment out to disable
+// #define CAMERA_PREPROCESS_GAMMA    (0.8f)
+
+/************************* TOF FUSION SETTINGS ************************/
+
+// Refine the subject distance estimated by the network with the ToF deck's zones that
+// overlap the subject (see tof_fusion.h). Requires NETWORK_ONBOARD_INFERENCE.
+// #define TOF_FUSION
+
+// Print the FC cycles spent in ToF fusion after each inference. Not compatible with
+// TRACE_STREAM, which uses the same performance counters.
+// #define TOF_FUSION_PROFILE
+
+// Network output frame (x forward, y left, z up) to camera frame (x right, y down, z forward)
+#define TOF_FUSION_BODY_TO_CAMERA  {{{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}}, {0.0f, 0.0f, 0.0f}}
+
+// ToF frame to camera frame, the rotation also accounts for the order of the zones. Nominal
+// values with the sensor 2cm below the camera and aligned axes, replace them with the
+// calibration of each drone.
+#define TOF_FUSION_TOF_TO_CAMERA   {{{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}, {0.0f, 0.02f, 0.0f}}
+
+// VL53L5CX field of view [rad]
+#define TOF_FUSION_FOV             (0.785f)
+
+// Box around the subject's predicted position (head and shoulders) [m]
+#define TOF_FUSION_SUBJECT_WIDTH   (0.4f)
+#define TOF_FUSION_SUBJECT_HEIGHT  (0.5f)
+
+// Zones farther than this behind the nearest one are background [m]
+#define TOF_FUSION_FOREGROUND      (0.3f)
+
+// Reject the ToF depth if it differs from the network's by more than this [m]
+#define TOF_FUSION_MAX_DEVIATION   (0.75f)
+
+// Weight of the ToF depth in the fused distance, 0 to 1
+#define TOF_FUSION_WEIGHT          (0.8f)
+
+// Minimum number of foreground zones overlapping the subject
+#define TOF_FUSION_MIN_ZONES       (2)
+
+// Maximum age of the ToF frame, slightly more than two frames at 15Hz [us]
+#define TOF_FUSION_MAX_AGE         (150000)
+
+/*********************** INFERENCE FILTER SETTINGS ********************/
+
+// Filter the network outputs and flag outliers before sending them to the STM32, which
+// skips flagged inferences (see inference_filter.h). Requires NETWORK_ONBOARD_INFERENCE.
+// #define INFERENCE_FILTER
+
+// Print the outcome of the filter after each inference
+// #define INFERENCE_FILTER_VERBOSE
+
+// Filter mode:
+//  - INFERENCE_FILTER_HAMPEL: only replace outliers by the median, no delay [default]
+//  - INFERENCE_FILTER_MEDIAN: replace all outputs by the median, delays them by WINDOW / 2
+#define INFERENCE_FILTER_MODE       (INFERENCE_FILTER_HAMPEL)
+
+// Number of inferences in the window, at most 9
+#define INFERENCE_FILTER_WINDOW     (7)
+
+// Outlier threshold [robust standard deviations]
+#define INFERENCE_FILTER_THRESHOLD  (3.5f)
+
+// Lower bound of the standard deviation of x, y, z [m] and phi [rad]
+#define INFERENCE_FILTER_MIN_SCALE  {0.05f, 0.05f, 0.03f, 0.1f}
+
+// Clear the window when no inference is computed for this long, e.g. after losing the subject [us]
+#define INFERENCE_FILTER_MAX_GAP    (500000)
+
 /**************************** CPX SETTINGS ****************************/
 
 // Enable bidirectional CPX SPI communication (GAP<=>ESP32).
@@ -0,0 +1,140 @@
+/*
+ * cpx_loopback.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host replacement of lib/cpx/cpx.c: each packet sent on a link is received by the same link,
+ * after the time it would take on the SPI link (CPX_LOOPBACK_BYTES_PER_US), and its done_task
+ * is completed once the receive callback has returned. Sends on the same link must not overlap.
+ */
+
+#include "cpx/cpx.h"
+
+#include <pmsis.h>
+
+#include <string.h>
+
+#define CPX_LOOPBACK_BYTES_PER_US (4)
+
+CO_FN_DECLARE(cpx_loopback_send_task);
+
+cpx_send_req_t *cpx_send_req_alloc(uint16_t payload_capacity) {
+    cpx_send_req_t *req = pi_l2_malloc(sizeof(cpx_send_req_t) + payload_capacity);
+
+    if (!req) {
+        CO_ASSERTION_FAILURE("Could not alloc cpx_send_req_t.\n");
+    }
+
+    *req = (cpx_send_req_t){0};
+    req->payload_capacity = payload_capacity;
+    req->req.payload_head = req->payload;
+
+    return req;
+}
+
+static void cpx_loopback_set_length(cpx_spi_send_req_t *req) {
+    if (req->head_length + req->tail_length > CPX_SPI_MTU) {
+        CO_ASSERTION_FAILURE("Packet length (%d + %d bytes) exceeds CPX_SPI_MTU.\n", req->head_length, req->tail_length);
+    }
+
+    req->header.length = req->head_length + req->tail_length;
+}
+
+void cpx_send_req_set_head_length(cpx_send_req_t *req, uint16_t payload_length) {
+    if (payload_length > req->payload_capacity) {
+        CO_ASSERTION_FAILURE("CPX payload length (%d) exceeds allocated capacity (%d)", payload_length, req->payload_capacity);
+    }
+
+    req->req.head_length = payload_length;
+    cpx_loopback_set_length(&req->req);
+}
+
+uint16_t cpx_send_req_max_tail_length(cpx_send_req_t *req) {
+    size_t tail_length = CPX_SPI_MTU - req->req.head_length;
+    return tail_length - (tail_length % 4);
+}
+
+void cpx_send_req_set_tail(cpx_send_req_t *req, uint8_t *payload_tail, uint16_t tail_length) {
+    if ((uintptr_t)payload_tail % 4 != 0 || tail_length % 4 != 0) {
+        CO_ASSERTION_FAILURE("payload_tail %p (%d bytes) is not 4-byte aligned\n", payload_tail, tail_length);
+    }
+
+    req->req.payload_tail = payload_tail;
+    req->req.tail_length = tail_length;
+    cpx_loopback_set_length(&req->req);
+}
+
+void cpx_init(cpx_t *cpx) {
+    *cpx = (cpx_t){0};
+
+    cpx->receive_req.req.buffer = pi_l2_malloc(CPX_SPI_MTU);
+    cpx->receive_req.req.buffer_size = CPX_SPI_MTU;
+}
+
+void cpx_register_rx_callback(cpx_t *cpx, cpx_function_e function, co_fn_t receive_callback, void *receiver_args) {
+    if (cpx->receive_callbacks[function] != NULL) {
+        CO_ASSERTION_FAILURE("CPX function %d already has a registered receive callback (%p)", function, receive_callback);
+    }
+
+    cpx->receive_callbacks[function] = receive_callback;
+    cpx->receiver_args[function] = receiver_args;
+}
+
+void cpx_start(cpx_t *cpx) {
+    (void)cpx;
+}
+
+void cpx_send_async(cpx_t *cpx, cpx_send_req_t *send_req, pi_task_t *done_task) {
+    send_req->cpx = cpx;
+
+    co_fn_push_start(&send_req->ctx, cpx_loopback_send_task, (void *)send_req, done_task);
+}
+
+CO_FN_BEGIN(cpx_loopback_send_task, cpx_send_req_t *, send_req)
+{
+    cpx_t *cpx = send_req->cpx;
+    cpx_spi_receive_req_t *req = &cpx->receive_req.req;
+
+    req->header = send_req->req.header;
+    req->header.cpx = send_req->header;
+    memcpy(req->buffer, send_req->req.payload_head, send_req->req.head_length);
+    memcpy(req->buffer + send_req->req.head_length, send_req->req.payload_tail, send_req->req.tail_length);
+
+    pi_task_push_delayed_us(co_event_init(&cpx->send_done), req->header.length / CPX_LOOPBACK_BYTES_PER_US);
+    CO_WAIT(&send_req->cpx->send_done);
+
+    cpx = send_req->cpx;
+    cpx->receive_req.header = &cpx->receive_req.req.header.cpx;
+    cpx->receive_req.payload = cpx->receive_req.req.buffer;
+    cpx->receive_req.payload_length = cpx->receive_req.req.header.length;
+
+    co_fn_t receive_callback = cpx->receive_callbacks[cpx->receive_req.header->function];
+    if (!receive_callback) {
+        break;
+    }
+
+    cpx->receive_req.receiver_args = cpx->receiver_args[cpx->receive_req.header->function];
+    co_fn_push_start(&cpx->callback_ctx, receive_callback, (void *)&cpx->receive_req, co_event_init(&cpx->receive_done));
+    CO_WAIT(&send_req->cpx->receive_done);
+}
+CO_FN_END()
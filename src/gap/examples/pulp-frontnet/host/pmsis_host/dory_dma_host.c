@@ -0,0 +1,71 @@
+/*
+ * dory_dma_host.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host implementation of the DORY DMA API: transfers are executed synchronously by core 0 with
+ * memcpy, the other cores synchronize with it through the team barriers around the kernels.
+ */
+
+#include "pmsis.h"
+#include "dory_dma.h"
+
+#include <string.h>
+
+void dory_dma_memcpy_async(DMA_copy *copy) {
+    if (pi_core_id() != 0) {
+        return;
+    }
+
+    uint8_t *ext = (uint8_t *)copy->ext;
+    uint8_t *loc = (uint8_t *)copy->loc;
+
+    if (copy->hwc_to_chw) {
+        abort();
+    }
+
+    // L1 is always contiguous, L2 is strided in both dimensions
+    for (int i = 0; i < copy->number_of_2d_copies; i++) {
+        for (int j = 0; j < copy->number_of_1d_copies; j++) {
+            uint8_t *ext_1d = ext + i * copy->stride_2d + j * copy->stride_1d;
+            if (copy->dir) {
+                memcpy(loc, ext_1d, copy->length_1d_copy);
+            } else {
+                memcpy(ext_1d, loc, copy->length_1d_copy);
+            }
+            loc += copy->length_1d_copy;
+        }
+    }
+}
+
+void dory_dma_barrier(DMA_copy *copy) {
+    (void)copy;
+}
+
+void dory_dma_free(DMA_copy *copy) {
+    (void)copy;
+}
+
+int dory_dma_allocate() {
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * pi_task_host.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * FC event kernel of pmsis_host. Tasks run one at a time on a virtual clock, in the order they
+ * are pushed, like the FIFO of the PMSIS event kernel that the runtime relies on (e.g. an event
+ * re-initialized right after being pushed).
+ *
+ * With the deterministic schedule, tasks take no time and the clock only advances to the next
+ * delayed task when no task is ready. The schedule fuzzer instead models what varies on the
+ * board: each task takes a random time up to task_us and each delayed task (a timer or the end
+ * of a transfer) fires up to jitter_us late, so that it is pushed between any two tasks. Every
+ * seed is a different interleaving, which is repeated exactly by running the same seed again.
+ */
+
+#include "pmsis.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Tasks ready to run, in the order they were pushed
+static pi_task_t *ready_first, *ready_last;
+
+// Delayed tasks, sorted by time
+static pi_task_t *delayed_first;
+
+static uint64_t time_us;
+
+// Schedule fuzzer, disabled when fuzz_state is zero
+static uint32_t fuzz_state;
+static uint32_t fuzz_task_us;
+static uint32_t fuzz_jitter_us;
+
+// xorshift32, uniform in [0, max]
+static uint32_t fuzz_uniform(uint32_t max) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return max > 0 ? fuzz_state % (max + 1) : 0;
+}
+
+static bool task_is_pending(pi_task_t *task) {
+    for (pi_task_t *el = ready_first; el; el = el->next) {
+        if (el == task) {
+            return true;
+        }
+    }
+
+    for (pi_task_t *el = delayed_first; el; el = el->next) {
+        if (el == task) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// On the board, a pending task that is pushed or initialized again corrupts the event kernel
+static void task_check_not_pending(pi_task_t *task, const char *fn) {
+    if (task_is_pending(task)) {
+        fprintf(stderr, "%s: task %p is already pending\n", fn, (void *)task);
+        abort();
+    }
+}
+
+void pi_host_sched_init(uint32_t seed, uint32_t task_us, uint32_t jitter_us) {
+    ready_first = NULL;
+    ready_last = NULL;
+    delayed_first = NULL;
+    time_us = 0;
+
+    fuzz_state = seed;
+    fuzz_task_us = task_us;
+    fuzz_jitter_us = jitter_us;
+}
+
+int pi_host_sched_pending() {
+    int count = 0;
+
+    for (pi_task_t *el = ready_first; el; el = el->next) {
+        count++;
+    }
+
+    for (pi_task_t *el = delayed_first; el; el = el->next) {
+        count++;
+    }
+
+    return count;
+}
+
+pi_task_t *pi_task_callback(pi_task_t *task, pi_callback_func_t callback, void *arg) {
+    task_check_not_pending(task, __FUNCTION__);
+
+    *task = (pi_task_t){ .callback = callback, .arg = arg };
+    return task;
+}
+
+pi_task_t *pi_task_block(pi_task_t *task) {
+    task_check_not_pending(task, __FUNCTION__);
+
+    *task = (pi_task_t){0};
+    return task;
+}
+
+void pi_task_push(pi_task_t *task) {
+    task_check_not_pending(task, __FUNCTION__);
+
+    if (!task->callback) {
+        task->done = 1;
+        return;
+    }
+
+    task->next = NULL;
+    if (ready_last) {
+        ready_last->next = task;
+    } else {
+        ready_first = task;
+    }
+    ready_last = task;
+}
+
+void pi_task_push_delayed_us(pi_task_t *task, uint32_t delay) {
+    task_check_not_pending(task, __FUNCTION__);
+
+    task->time = time_us + delay;
+    if (fuzz_state) {
+        task->time += fuzz_uniform(fuzz_jitter_us);
+    }
+
+    // After the tasks with the same time, so that they keep the order they were pushed in
+    pi_task_t **el = &delayed_first;
+    while (*el && (*el)->time <= task->time) {
+        el = &(*el)->next;
+    }
+
+    task->next = *el;
+    *el = task;
+}
+
+// Push the delayed tasks that are due at the current time
+static void push_due_tasks() {
+    while (delayed_first && delayed_first->time <= time_us) {
+        pi_task_t *task = delayed_first;
+        delayed_first = task->next;
+        pi_task_push(task);
+    }
+}
+
+void pi_yield() {
+    if (!ready_first) {
+        if (!delayed_first) {
+            fprintf(stderr, "pi_yield: no task left to run\n");
+            abort();
+        }
+
+        time_us = delayed_first->time;
+        push_due_tasks();
+        return;
+    }
+
+    pi_task_t *task = ready_first;
+    ready_first = task->next;
+    if (!ready_first) {
+        ready_last = NULL;
+    }
+
+    task->done = 1;
+    task->callback(task->arg);
+
+    if (fuzz_state) {
+        time_us += fuzz_uniform(fuzz_task_us);
+        push_due_tasks();
+    }
+}
+
+void pi_task_wait_on(pi_task_t *task) {
+    while (!task->done) {
+        pi_yield();
+    }
+}
+
+uint32_t pi_time_get_us() {
+    return time_us;
+}
+
+void *pi_l2_malloc(size_t size) {
+    return malloc(size);
+}
+
+void pi_l2_free(void *ptr, size_t size) {
+    (void)size;
+    free(ptr);
+}
+
+void pi_gpio_pin_write(pi_device_t *device, uint32_t pin, uint32_t value) {
+    (void)device;
+    (void)pin;
+    (void)value;
+}
+
+void pmsis_exit(int status) {
+    exit(status);
+}
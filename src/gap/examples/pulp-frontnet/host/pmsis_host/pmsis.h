@@ -0,0 +1,202 @@
+/*
+ * pmsis.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Minimal host replacement of PMSIS for the DORY layers and PULP-NN kernels, used by the host
+ * tests to check them for bit-exactness. The cluster cores are emulated by NUM_CORES threads
+ * started by pi_cl_team_fork_host, the team barrier by a pthread barrier, and the XpulpV2 builtins
+ * by their scalar equivalents. Only what the kernels of the network actually execute is
+ * emulated faithfully: the sub-byte variants abort.
+ *
+ * Pointers are passed to the DORY layers as 32-bit integers, so all the buffers that they access
+ * must be allocated in the low 4 GB of the address space with pi_host_malloc_32bit and passed
+ * through pi_host_addr_32bit.
+ *
+ * The FC event kernel is emulated by pi_task_host.c for the FC libraries (coroutines, queues,
+ * streamer): tasks run one at a time in the order they are pushed, on a virtual clock. Runs are
+ * deterministic, pi_host_sched_init can also fuzz the time taken by each task and the time when
+ * the delayed ones fire. There are no interrupts, disable_irq does nothing.
+ */
+
+#ifndef __PMSIS_HOST_H__
+#define __PMSIS_HOST_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NUM_CORES
+#define NUM_CORES (8)
+#endif
+
+typedef signed char   v4s __attribute__((vector_size(4)));
+typedef unsigned char v4u __attribute__((vector_size(4)));
+
+// FC event kernel, see pi_task_host.c
+
+#define PI_FC_L1
+#define PI_L2
+
+typedef void (*pi_callback_func_t)(void *arg);
+
+typedef struct pi_task_s {
+    struct pi_task_s *next;
+    pi_callback_func_t callback;        // NULL for tasks created with pi_task_block
+    void *arg;
+    uint64_t time;                      // Delayed tasks, virtual time when ready [us]
+    int done;
+} pi_task_t;
+
+typedef struct pi_device_s {
+    void *config;
+    void *data;
+} pi_device_t;
+
+pi_task_t *pi_task_callback(pi_task_t *task, pi_callback_func_t callback, void *arg);
+pi_task_t *pi_task_block(pi_task_t *task);
+void pi_task_push(pi_task_t *task);
+void pi_task_push_delayed_us(pi_task_t *task, uint32_t delay);
+
+// Drop all the tasks and restart the virtual clock from zero. With a non-zero seed, each task
+// takes a random time up to task_us and each delayed task fires up to jitter_us late.
+void pi_host_sched_init(uint32_t seed, uint32_t task_us, uint32_t jitter_us);
+
+// Tasks ready or delayed, zero when nothing is left to run
+int pi_host_sched_pending();
+
+// Run the ready tasks until task is done, aborts if nothing is left to run
+void pi_task_wait_on(pi_task_t *task);
+
+// Run one ready task, or advance the virtual clock to the next delayed one
+void pi_yield();
+
+uint32_t pi_time_get_us();
+
+void *pi_l2_malloc(size_t size);
+void pi_l2_free(void *ptr, size_t size);
+
+void pmsis_exit(int status) __attribute__((noreturn));
+
+// Only declared for the structs that embed them, the cluster is not emulated for the FC libraries
+struct pi_cluster_task {
+    void (*entry)(void *arg);
+    void *arg;
+};
+
+// GPIO writes are ignored (trace.h)
+void pi_gpio_pin_write(pi_device_t *device, uint32_t pin, uint32_t value);
+
+// Not implemented, declared for the inline functions of uart.h
+void pi_uart_read_async(pi_device_t *device, void *buffer, uint32_t size, pi_task_t *callback);
+void pi_uart_write_async(pi_device_t *device, void *buffer, uint32_t size, pi_task_t *callback);
+
+static inline int disable_irq() {
+    return 0;
+}
+
+static inline void restore_irq(int irq) {
+    (void)irq;
+}
+
+// Cluster cores
+
+int  pi_core_id();
+void pi_cl_team_barrier(int barrier_id);
+
+// Runs entry(arg) on NUM_CORES threads, like pi_cl_team_fork(NUM_CORES, entry, arg)
+void pi_cl_team_fork_host(void (*entry)(void *), void *arg);
+
+void *pi_host_malloc_32bit(size_t size);
+void pi_host_free_32bit(void *ptr, size_t size);
+// Address of a buffer as the 32-bit integer expected by the DORY layers, aborts if it does not fit
+unsigned int pi_host_addr_32bit(const void *ptr);
+
+static inline int32_t host_clipu_r(int32_t x, int32_t max) {
+    return x < 0 ? 0 : (x > max ? max : x);
+}
+
+static inline int32_t host_clip_r(int32_t x, int32_t max) {
+    return x < -max - 1 ? -max - 1 : (x > max ? max : x);
+}
+
+static inline int32_t host_fl1(uint32_t x) {
+    return x ? 31 - __builtin_clz(x) : 32;
+}
+
+static inline int32_t host_bextract(int32_t x, int size, int off) {
+    return (int32_t)((uint32_t)x << (32 - size - off)) >> (32 - size);
+}
+
+static inline uint32_t host_bextractu(uint32_t x, int size, int off) {
+    return (x >> off) & ((size < 32) ? ((1u << size) - 1) : 0xffffffffu);
+}
+
+static inline int32_t host_binsert(int32_t dst, uint32_t not_mask, int32_t src, uint32_t mask, int off) {
+    return (int32_t)(((uint32_t)dst & not_mask) | (((uint32_t)src << off) & mask));
+}
+
+static inline v4u host_maxu4(v4u a, v4u b) {
+    return (v4u){a[0] > b[0] ? a[0] : b[0], a[1] > b[1] ? a[1] : b[1], a[2] > b[2] ? a[2] : b[2], a[3] > b[3] ? a[3] : b[3]};
+}
+
+static inline v4s host_max4(v4s a, v4s b) {
+    return (v4s){a[0] > b[0] ? a[0] : b[0], a[1] > b[1] ? a[1] : b[1], a[2] > b[2] ? a[2] : b[2], a[3] > b[3] ? a[3] : b[3]};
+}
+
+static inline v4u host_avgu4(v4u a, v4u b) {
+    return (v4u){(a[0] + b[0]) >> 1, (a[1] + b[1]) >> 1, (a[2] + b[2]) >> 1, (a[3] + b[3]) >> 1};
+}
+
+#define HOST_UNSUPPORTED(type) ({ abort(); (type){0}; })
+
+#define __builtin_pulp_clipu_r(x, max)  host_clipu_r(x, max)
+#define __builtin_pulp_clip_r(x, max)   host_clip_r(x, max)
+#define __builtin_pulp_fl1(x)           host_fl1(x)
+#define __builtin_pulp_bextract(x, size, off)  host_bextract(x, size, off)
+#define __builtin_pulp_bextractu(x, size, off) host_bextractu(x, size, off)
+#define __builtin_pulp_binsert(dst, not_mask, src, mask, off) host_binsert(dst, not_mask, src, mask, off)
+#define __builtin_pulp_pack4(x, y, z, t) ((v4s){(x), (y), (z), (t)})
+#define __builtin_pulp_maxu4(a, b)      host_maxu4(a, b)
+#define __builtin_pulp_max4(a, b)       host_max4(a, b)
+#define __builtin_pulp_avgu4(a, b)      host_avgu4(a, b)
+
+// Sub-byte SIMD, not used by 8-bit networks
+#define __builtin_pulp_maxu8(a, b)      HOST_UNSUPPORTED(__typeof__(a))
+#define __builtin_pulp_max8(a, b)       HOST_UNSUPPORTED(__typeof__(a))
+#define __builtin_pulp_maxu16(a, b)     HOST_UNSUPPORTED(__typeof__(a))
+#define __builtin_pulp_max16(a, b)      HOST_UNSUPPORTED(__typeof__(a))
+#define __builtin_pulp_avgu8(a, b)      HOST_UNSUPPORTED(__typeof__(a))
+#define __builtin_pulp_avgu16(a, b)     HOST_UNSUPPORTED(__typeof__(a))
+
+// Works for any combination of signed and unsigned operands, like the sdotusp4/sdotsp4 variants
+#define __builtin_pulp_sdotusp4(a, b, c) ({                         \
+    __typeof__(a) _a = (a);                                         \
+    __typeof__(b) _b = (b);                                         \
+    (int32_t)(c) + _a[0] * _b[0] + _a[1] * _b[1] + _a[2] * _b[2] + _a[3] * _b[3]; \
+})
+#define __builtin_pulp_sdotsp4(a, b, c)  __builtin_pulp_sdotusp4(a, b, c)
+
+#endif // __PMSIS_HOST_H__
@@ -0,0 +1,102 @@
+/*
+ * pmsis_host.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#define _GNU_SOURCE
+
+#include "pmsis.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+typedef struct core_arg_s {
+    int core_id;
+    void (*entry)(void *);
+    void *arg;
+} core_arg_t;
+
+static __thread int core_id;
+static pthread_barrier_t team_barrier;
+
+int pi_core_id() {
+    return core_id;
+}
+
+void pi_cl_team_barrier(int barrier_id) {
+    (void)barrier_id;
+    pthread_barrier_wait(&team_barrier);
+}
+
+static void *core_main(void *arg) {
+    core_arg_t *core = (core_arg_t *)arg;
+
+    core_id = core->core_id;
+    core->entry(core->arg);
+
+    return NULL;
+}
+
+void pi_cl_team_fork_host(void (*entry)(void *), void *arg) {
+    pthread_t threads[NUM_CORES];
+    core_arg_t cores[NUM_CORES];
+
+    pthread_barrier_init(&team_barrier, NULL, NUM_CORES);
+
+    for (int i = 0; i < NUM_CORES; i++) {
+        cores[i] = (core_arg_t){.core_id = i, .entry = entry, .arg = arg};
+        if (pthread_create(&threads[i], NULL, core_main, &cores[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            abort();
+        }
+    }
+
+    for (int i = 0; i < NUM_CORES; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_barrier_destroy(&team_barrier);
+}
+
+void *pi_host_malloc_32bit(size_t size) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (ptr == MAP_FAILED) {
+        fprintf(stderr, "mmap of %zu bytes in the low 4 GB failed\n", size);
+        abort();
+    }
+
+    return ptr;
+}
+
+void pi_host_free_32bit(void *ptr, size_t size) {
+    munmap(ptr, size);
+}
+
+unsigned int pi_host_addr_32bit(const void *ptr) {
+    if ((uintptr_t)ptr > UINT32_MAX) {
+        fprintf(stderr, "%p is not in the low 4 GB, allocate it with pi_host_malloc_32bit\n", ptr);
+        abort();
+    }
+
+    return (unsigned int)(uintptr_t)ptr;
+}
@@ -0,0 +1,480 @@
+/*
+ * test_coroutine.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the coroutine runtime (lib/coroutine.c, event_group.h) on the event kernel of
+ * pmsis_host. Runs the coroutine example (examples/coroutine) on the virtual clock, checks the
+ * priorities of the scheduler, the event groups and the frame checks, then fuzzes the schedule of
+ * workers that signal a collector through an event group.
+ *
+ * Usage: test_coroutine [iterations [first seed]], each iteration fuzzes one seed.
+ */
+
+#include "coroutine.h"
+#include "event_group.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+// Run the tasks until done is set, false if nothing is left to run before
+static bool run_until(volatile bool *done) {
+    while (!*done && pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+
+    return *done;
+}
+
+static uint64_t wall_clock_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ull + tv.tv_usec;
+}
+
+/* Coroutine example */
+
+#define EXAMPLE_PERIOD_US (1000000)
+
+typedef struct example_log_s {
+    int task;
+    int counter;
+    uint32_t time;
+} example_log_t;
+
+static example_log_t example_log[32];
+static int example_log_count;
+
+static void example_log_append(int task, int counter) {
+    if (example_log_count < (int)(sizeof(example_log) / sizeof(example_log[0]))) {
+        example_log[example_log_count++] = (example_log_t){ task, counter, pi_time_get_us() };
+    }
+}
+
+CO_FN_BEGIN(example_task1, intptr_t, arg)
+{
+    static co_event_t event;
+    static int counter;
+
+    for (counter = 0; counter < 5; counter++) {
+        example_log_append(1, arg);
+
+        pi_task_push_delayed_us(co_event_init(&event), EXAMPLE_PERIOD_US);
+        CO_WAIT(&event);
+    }
+}
+CO_FN_END()
+
+CO_FN_DECLARE(example_task3);
+
+CO_FN_BEGIN(example_task2, void *, _arg)
+{
+    static co_fn_ctx_t ctx3;
+    static co_event_t task3_done;
+    static int runs;
+
+    (void)_arg;
+
+    for (runs = 0; runs < 2; runs++) {
+        example_log_append(2, runs);
+
+        co_fn_push_start(&ctx3, example_task3, NULL, co_event_init(&task3_done));
+        CO_WAIT(&task3_done);
+    }
+}
+CO_FN_END()
+
+CO_FN_BEGIN(example_task3, void *, _arg)
+{
+    static co_event_t event;
+    static int counter;
+
+    (void)_arg;
+    counter = 0;
+
+    while (counter < 5) {
+        example_log_append(3, counter);
+        counter += 1;
+
+        pi_task_push_delayed_us(co_event_init(&event), EXAMPLE_PERIOD_US);
+        CO_WAIT(&event);
+    }
+}
+CO_FN_END()
+
+static void test_example() {
+    pi_host_sched_init(0, 0, 0);
+    example_log_count = 0;
+
+    static co_fn_ctx_t ctx1, ctx2;
+    static pi_task_t done1, done2;
+    co_fn_push_start(&ctx1, example_task1, (void *)1234, pi_task_block(&done1));
+    co_fn_push_start(&ctx2, example_task2, NULL, pi_task_block(&done2));
+
+    pi_task_wait_on(&done1);
+    pi_task_wait_on(&done2);
+    CHECK(pi_time_get_us() == 10 * EXAMPLE_PERIOD_US, "example: done at %u us", pi_time_get_us());
+    CHECK(pi_host_sched_pending() == 0, "example: %d tasks left", pi_host_sched_pending());
+
+    // task1 and task3 every period, task2 starts task3 again when it is done
+    int task1 = 0, task2 = 0, task3 = 0;
+    for (int i = 0; i < example_log_count; i++) {
+        example_log_t *log = &example_log[i];
+
+        if (log->task == 1) {
+            CHECK(log->counter == 1234 && log->time == task1 * EXAMPLE_PERIOD_US, "example: task1 at %u us", log->time);
+            task1++;
+        } else if (log->task == 2) {
+            CHECK(log->counter == task2 && log->time == task3 * EXAMPLE_PERIOD_US, "example: task2 run %d at %u us", log->counter, log->time);
+            task2++;
+        } else {
+            CHECK(log->counter == task3 % 5 && log->time == task3 * EXAMPLE_PERIOD_US, "example: task3 %d at %u us", log->counter, log->time);
+            task3++;
+        }
+    }
+    CHECK(task1 == 5 && task2 == 2 && task3 == 10, "example: %d, %d, %d iterations", task1, task2, task3);
+}
+
+/* Scheduler priorities */
+
+static int priority_order[4];
+static int priority_count;
+
+CO_FN_BEGIN(priority_task, intptr_t, id)
+{
+    priority_order[priority_count++] = id;
+}
+CO_FN_END()
+
+static void test_priority() {
+    pi_host_sched_init(0, 0, 0);
+    priority_count = 0;
+
+    static co_fn_ctx_t ctx[4];
+    static const co_priority_t priorities[4] = { CO_PRIORITY_LOW, CO_PRIORITY_NORMAL, CO_PRIORITY_URGENT, CO_PRIORITY_HIGH };
+
+    // Made ready in the same batch, resumed from the highest priority
+    for (int i = 0; i < 4; i++) {
+        ctx[i] = (co_fn_ctx_t){0};
+        co_fn_set_priority(&ctx[i], priorities[i]);
+        co_fn_push_start(&ctx[i], priority_task, (void *)(intptr_t)i, NULL);
+    }
+
+    while (pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+
+    CHECK(priority_count == 4, "priority: %d resumes", priority_count);
+    CHECK(priority_order[0] == 2 && priority_order[1] == 3 && priority_order[2] == 1 && priority_order[3] == 0,
+          "priority: order %d %d %d %d", priority_order[0], priority_order[1], priority_order[2], priority_order[3]);
+}
+
+/* Event groups */
+
+typedef struct group_test_s {
+    co_event_group_t group;
+    co_event_mask_t wait_mask;
+    co_wait_mode_e wait_mode;
+    uint32_t resume_time;
+    bool done;
+} group_test_t;
+
+typedef struct group_bit_s {
+    pi_task_t task;
+    group_test_t *test;
+    co_event_mask_t mask;
+} group_bit_t;
+
+static void group_bit_set(void *arg) {
+    group_bit_t *bit = arg;
+    co_event_group_set(&bit->test->group, bit->mask);
+}
+
+CO_FN_BEGIN(group_waiter_task, group_test_t *, test)
+{
+    CO_WAIT_GROUP(&test->group, &test->wait_mask, test->wait_mode);
+
+    test->resume_time = pi_time_get_us();
+    test->done = true;
+}
+CO_FN_END()
+
+// Bit 0 is set at 100us and bit 1 at 200us, returns when the waiter was resumed
+static uint32_t run_group_test(co_wait_mode_e wait_mode, co_event_mask_t *wait_mask) {
+    pi_host_sched_init(0, 0, 0);
+
+    static group_test_t test;
+    static co_fn_ctx_t ctx;
+    static group_bit_t bits[2];
+
+    test = (group_test_t){ .wait_mask = *wait_mask, .wait_mode = wait_mode };
+    co_event_group_init(&test.group);
+    co_fn_push_start(&ctx, group_waiter_task, &test, NULL);
+
+    for (int i = 0; i < 2; i++) {
+        bits[i] = (group_bit_t){ .test = &test, .mask = 1 << i };
+        pi_task_push_delayed_us(pi_task_callback(&bits[i].task, group_bit_set, &bits[i]), 100 * (i + 1));
+    }
+
+    CHECK(run_until(&test.done), "event group: waiter not resumed (mode %d, mask %x)", wait_mode, *wait_mask);
+
+    *wait_mask = test.wait_mask;
+    return test.resume_time;
+}
+
+static void test_event_group() {
+    co_event_mask_t mask = 0x3;
+    uint32_t time = run_group_test(CO_WAIT_MODE_ALL, &mask);
+    CHECK(time == 200 && mask == 0x3, "event group all: resumed at %u us, mask %x", time, mask);
+
+    mask = 0x3;
+    time = run_group_test(CO_WAIT_MODE_ANY, &mask);
+    CHECK(time == 100 && mask == 0x1, "event group any: resumed at %u us, mask %x", time, mask);
+
+    mask = 0x2;
+    time = run_group_test(CO_WAIT_MODE_ANY, &mask);
+    CHECK(time == 200 && mask == 0x2, "event group any: resumed at %u us, mask %x", time, mask);
+
+    // Already set when waiting, still resumed through the scheduler
+    pi_host_sched_init(0, 0, 0);
+    static group_test_t test;
+    static co_fn_ctx_t ctx;
+    test = (group_test_t){ .wait_mask = 0x1, .wait_mode = CO_WAIT_MODE_ANY };
+    co_event_group_init(&test.group);
+    co_event_group_set(&test.group, 0x1);
+    co_fn_push_start(&ctx, group_waiter_task, &test, NULL);
+    CHECK(run_until(&test.done) && test.wait_mask == 0x1, "event group: not resumed when already set");
+}
+
+/* Frames */
+
+typedef struct frame_test_frame_s {
+    int counter;
+    uint8_t data[64];
+} frame_test_frame_t;
+
+CO_FN_BEGIN_WITH_FRAME(frame_test_task, volatile bool *, done, frame_test_frame_t, locals)
+{
+    for (locals->counter = 0; locals->counter < 3; locals->counter++) {
+        locals->data[locals->counter] = locals->counter;
+        CO_YIELD();
+    }
+
+    *done = true;
+}
+CO_FN_END()
+
+// Exit status of starting frame_test_task in a child process, on a context with or without a frame
+static int run_frame_test(bool with_frame) {
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        static CO_FN_CTX_WITH_FRAME(frame_test_frame_t) frame_ctx;
+        static co_fn_ctx_t plain_ctx;
+        static volatile bool done;
+
+        pi_host_sched_init(0, 0, 0);
+        if (with_frame) {
+            co_fn_push_start_with_frame(&frame_ctx, frame_test_task, (void *)&done, NULL);
+        } else {
+            co_fn_push_start(&plain_ctx, frame_test_task, (void *)&done, NULL);
+        }
+        exit(run_until(&done) ? 0 : 1);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void test_frame() {
+    CHECK(run_frame_test(true) == 0, "frame: not completed on a context with a frame");
+
+    // Fails the assertion instead of writing the frame past the end of the context
+    CHECK(run_frame_test(false) != 0, "frame: started on a context without a frame");
+}
+
+/* Schedule fuzzing */
+
+#define FUZZ_WORKERS    (4)
+#define FUZZ_ITERATIONS (16)
+#define FUZZ_DONE_SHIFT (16)
+#define FUZZ_TICK_MASK  ((1 << FUZZ_WORKERS) - 1)
+#define FUZZ_DONE_MASK  (FUZZ_TICK_MASK << FUZZ_DONE_SHIFT)
+
+typedef struct fuzz_s fuzz_t;
+
+typedef struct fuzz_worker_frame_s {
+    int iteration;
+} fuzz_worker_frame_t;
+
+typedef struct fuzz_worker_s {
+    fuzz_t *fuzz;
+    int id;
+    CO_FN_CTX_WITH_FRAME(fuzz_worker_frame_t) ctx;
+    co_event_t tick;
+    int counter;
+} fuzz_worker_t;
+
+typedef struct fuzz_collector_frame_s {
+    co_event_mask_t mask;
+    int last_counter[FUZZ_WORKERS];
+} fuzz_collector_frame_t;
+
+typedef struct fuzz_s {
+    uint32_t seed;
+    uint32_t rng_state;
+
+    co_event_group_t group;
+    fuzz_worker_t workers[FUZZ_WORKERS];
+
+    CO_FN_CTX_WITH_FRAME(fuzz_collector_frame_t) collector_ctx;
+    int wakeups;
+    bool done;
+} fuzz_t;
+
+static uint32_t fuzz_delay(fuzz_t *fuzz) {
+    fuzz->rng_state = fuzz->rng_state * 1664525 + 1013904223;
+    return (fuzz->rng_state >> 8) % 50;
+}
+
+CO_FN_BEGIN_WITH_FRAME(fuzz_worker_task, fuzz_worker_t *, worker, fuzz_worker_frame_t, locals)
+{
+    for (locals->iteration = 0; locals->iteration < FUZZ_ITERATIONS; locals->iteration++) {
+        pi_task_push_delayed_us(co_event_init(&worker->tick), fuzz_delay(worker->fuzz));
+        CO_WAIT(&worker->tick);
+
+        worker->counter++;
+        co_event_group_set(&worker->fuzz->group, 1 << worker->id);
+    }
+
+    co_event_group_set(&worker->fuzz->group, 1 << (worker->id + FUZZ_DONE_SHIFT));
+}
+CO_FN_END()
+
+CO_FN_BEGIN_WITH_FRAME(fuzz_collector_task, fuzz_t *, fuzz, fuzz_collector_frame_t, locals)
+{
+    while (true) {
+        locals->mask = FUZZ_TICK_MASK | FUZZ_DONE_MASK;
+        CO_WAIT_GROUP_ANY(&fuzz->group, &locals->mask);
+        fuzz->wakeups++;
+
+        CHECK(locals->mask != 0, "seed %u: collector resumed without events", fuzz->seed);
+
+        // A tick is set after the counter of its worker is incremented, it must have advanced
+        // since the tick was cleared
+        co_event_mask_t ticks = co_event_group_clear(&fuzz->group, FUZZ_TICK_MASK);
+        for (int i = 0; i < FUZZ_WORKERS; i++) {
+            if (ticks & (1 << i)) {
+                CHECK(fuzz->workers[i].counter > locals->last_counter[i], "seed %u: worker %d ticked without progress", fuzz->seed, i);
+                locals->last_counter[i] = fuzz->workers[i].counter;
+            }
+        }
+
+        if (co_event_group_get(&fuzz->group, FUZZ_DONE_MASK) == FUZZ_DONE_MASK) {
+            break;
+        }
+    }
+
+    fuzz->done = true;
+}
+CO_FN_END()
+
+static bool fuzz_run(uint32_t seed) {
+    static fuzz_t fuzz;
+    int failures_before = failures;
+
+    pi_host_sched_init(seed, 10, 20);
+
+    fuzz = (fuzz_t){ .seed = seed, .rng_state = seed };
+    co_event_group_init(&fuzz.group);
+    co_fn_push_start_with_frame(&fuzz.collector_ctx, fuzz_collector_task, &fuzz, NULL);
+
+    for (int i = 0; i < FUZZ_WORKERS; i++) {
+        fuzz.workers[i].fuzz = &fuzz;
+        fuzz.workers[i].id = i;
+        co_fn_push_start_with_frame(&fuzz.workers[i].ctx, fuzz_worker_task, &fuzz.workers[i], NULL);
+    }
+
+    CHECK(run_until(&fuzz.done), "seed %u: collector never completed, %d wakeups", seed, fuzz.wakeups);
+
+    while (pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+
+    for (int i = 0; i < FUZZ_WORKERS; i++) {
+        CHECK(fuzz.workers[i].counter == FUZZ_ITERATIONS, "seed %u: worker %d did %d iterations", seed, i, fuzz.workers[i].counter);
+        CHECK(fuzz.workers[i].ctx.ctx.resume_point == CO_RESUME_DONE, "seed %u: worker %d not done", seed, i);
+    }
+    CHECK(fuzz.collector_ctx.ctx.resume_point == CO_RESUME_DONE, "seed %u: collector not done", seed);
+
+    return failures == failures_before;
+}
+
+static void test_fuzz(int iterations, uint32_t first_seed) {
+    uint64_t start = wall_clock_us();
+
+    int i;
+    for (i = 0; i < iterations; i++) {
+        if (!fuzz_run(first_seed + i)) {
+            printf("Seed %u failed, run again with: test_coroutine 1 %u\n", first_seed + i, first_seed + i);
+            break;
+        }
+    }
+
+    uint64_t elapsed = wall_clock_us() - start;
+    printf("%d schedules in %.1f ms, %.0f schedules/s\n", i, elapsed / 1000.0, i * 1e6 / (elapsed > 0 ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    uint32_t first_seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+
+    test_example();
+    test_priority();
+    test_event_group();
+    test_frame();
+    test_fuzz(iterations, first_seed);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+/*
+ * test_dvfs.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the DVFS governor (lib/dvfs.c). Checks the governor on hand-made inference times,
+ * then runs a synthetic workload (noisy inference cycles with occasional slow inferences) at 30
+ * and 15 fps through each mode and reports the time spent at each operating point and the
+ * inferences that missed the frame period.
+ */
+
+#include "dvfs.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Synthetic workload, about 10ms per inference at 175MHz
+#define WORKLOAD_LENGTH  (6000)
+#define WORKLOAD_CYCLES  (1750000)  // [MHz * us]
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+// Uniform in [0, 1)
+static float uniform() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return (rng_state >> 8) / (float)(1 << 24);
+}
+
+static dvfs_config_t make_config(dvfs_mode_e mode, uint32_t period) {
+    return (dvfs_config_t){
+        .mode = mode,
+        .points = {{50000000, 1000}, {90000000, 1000}, {130000000, 1100}, {175000000, 1200}},
+        .n_points = 4,
+        .min_voltage = 1000,
+        .period = period,
+        .target = 0.8f,
+        .hysteresis = 0.15f,
+        .down_frames = 10,
+        .window = 16,
+        .margin = 2.0f,
+    };
+}
+
+// Runs an inference of the given cycles at the current operating point
+static bool run(dvfs_t *dvfs, uint32_t cycles) {
+    uint32_t freq = dvfs_get_point(dvfs)->freq_cl / 1000000;
+    return dvfs_update(dvfs, cycles / freq);
+}
+
+static void test_fixed() {
+    dvfs_config_t config = make_config(DVFS_MODE_FIXED, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+
+    for (int i = 0; i < 100; i++) {
+        CHECK(!run(&dvfs, 175000), "fixed: changed at inference %d", i);
+    }
+    CHECK(dvfs.level == 3 && dvfs.n_inferences == 100, "fixed: level %d", dvfs.level);
+
+    run(&dvfs, 175 * 40000);
+    CHECK(dvfs.level == 3 && dvfs.n_misses == 1, "fixed: %d misses", dvfs.n_misses);
+}
+
+static void test_step_down() {
+    dvfs_config_t config = make_config(DVFS_MODE_SLACK, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+    CHECK(dvfs.level == 3, "starts at level %d", dvfs.level);
+
+    // 17.5ms at 50MHz, within the period at every operating point: one step every down_frames
+    for (int level = 2; level >= 0; level--) {
+        for (int i = 0; i < config.down_frames - 1; i++) {
+            CHECK(!run(&dvfs, 875000), "slowed down after %d inferences", i + 1);
+        }
+        CHECK(run(&dvfs, 875000) && dvfs.level == level, "did not slow down to %d", level);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        run(&dvfs, 875000);
+    }
+    CHECK(dvfs.level == 0 && dvfs.n_changes == 3 && dvfs.n_misses == 0, "step down: level %d, %d changes", dvfs.level, dvfs.n_changes);
+}
+
+static void test_hysteresis() {
+    dvfs_config_t config = make_config(DVFS_MODE_SLACK, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+
+    // 72% of the period at 90MHz: within the target but not within the hysteresis band, the
+    // governor stops at 130MHz
+    uint32_t cycles = 0.72f * 33333 * 90;
+    for (int i = 0; i < 200; i++) {
+        run(&dvfs, cycles);
+    }
+    CHECK(dvfs.level == 2 && dvfs.n_changes == 1, "hysteresis: level %d, %d changes", dvfs.level, dvfs.n_changes);
+
+    // Noise around the threshold does not make it oscillate
+    for (int i = 0; i < 200; i++) {
+        run(&dvfs, cycles * (0.95f + 0.1f * uniform()));
+    }
+    CHECK(dvfs.n_changes == 1, "hysteresis: %d changes with noise", dvfs.n_changes);
+}
+
+static void test_step_up() {
+    dvfs_config_t config = make_config(DVFS_MODE_SLACK, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+
+    for (int i = 0; i < 100; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs.level == 0, "step up: starts at level %d", dvfs.level);
+
+    // 20ms at 175MHz: the slowest operating point within the target is 175MHz, reached at once
+    CHECK(run(&dvfs, 175 * 20000) && dvfs.level == 3, "step up: level %d", dvfs.level);
+    CHECK(dvfs.n_misses == 1, "step up: %d misses", dvfs.n_misses);
+
+    // Back to the light workload, one step every down_frames
+    for (int i = 0; i < config.down_frames; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs.level == 2, "step up: level %d after the spike", dvfs.level);
+}
+
+static void test_deadline() {
+    dvfs_config_t config = make_config(DVFS_MODE_DEADLINE, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+
+    for (int i = 0; i < 100; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs.level == 0, "deadline: starts at level %d", dvfs.level);
+
+    // A miss goes to the fastest operating point, even if 130MHz would be enough
+    uint32_t slow = 0.75f * 33333 * 130;
+    CHECK(run(&dvfs, slow) && dvfs.level == 3, "deadline: level %d after a miss", dvfs.level);
+
+    // The slow inference is kept for window inferences: it completes within the period at
+    // 130MHz, not at 90MHz
+    for (int i = 0; i < config.window - 1; i++) {
+        run(&dvfs, 500000);
+        CHECK(dvfs.level >= 2, "deadline: level %d within the window", dvfs.level);
+    }
+    CHECK(dvfs.level == 2, "deadline: level %d within the window", dvfs.level);
+
+    for (int i = 0; i < 3 * config.down_frames + 1; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs.level == 0, "deadline: level %d after the window", dvfs.level);
+
+    // The slack mode only goes as fast as required and ignores past inferences
+    dvfs_config_t slack_config = make_config(DVFS_MODE_SLACK, 33333);
+    dvfs_t slack;
+    dvfs_init(&slack, &slack_config);
+    for (int i = 0; i < 100; i++) {
+        run(&slack, 500000);
+    }
+    run(&slack, slow);
+    CHECK(slack.level == 2, "slack: level %d after a miss", slack.level);
+
+    for (int i = 0; i < slack_config.down_frames; i++) {
+        run(&slack, 500000);
+    }
+    CHECK(slack.level == 1, "slack: level %d after the miss", slack.level);
+}
+
+static void test_voltage() {
+    dvfs_config_t config = make_config(DVFS_MODE_SLACK, 33333);
+    dvfs_t dvfs;
+    dvfs_init(&dvfs, &config);
+    CHECK(dvfs_get_voltage(&dvfs) == 1200, "voltage %d at 175MHz", dvfs_get_voltage(&dvfs));
+
+    for (int i = 0; i < 100; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs_get_voltage(&dvfs) == 1000, "voltage %d at 50MHz", dvfs_get_voltage(&dvfs));
+
+    // The FC frequency requires 1.2V
+    config.min_voltage = 1200;
+    dvfs_init(&dvfs, &config);
+    for (int i = 0; i < 100; i++) {
+        run(&dvfs, 500000);
+    }
+    CHECK(dvfs.level == 0 && dvfs_get_voltage(&dvfs) == 1200, "voltage %d with the FC at 1.2V", dvfs_get_voltage(&dvfs));
+}
+
+static void test_workload(uint32_t period) {
+    static const char *mode_names[] = {"fixed", "slack", "deadline"};
+    int misses[3];
+
+    for (int mode = DVFS_MODE_FIXED; mode <= DVFS_MODE_DEADLINE; mode++) {
+        dvfs_config_t config = make_config(mode, period);
+        dvfs_t dvfs;
+        dvfs_init(&dvfs, &config);
+
+        int frames[DVFS_MAX_POINTS] = {0};
+        uint64_t freq_sum = 0;
+        rng_state = 0x12345678;
+
+        for (int i = 0; i < WORKLOAD_LENGTH; i++) {
+            // +-10% noise, one inference in 50 is twice as slow (e.g. L3 contention)
+            float scale = 0.9f + 0.2f * uniform();
+            if (uniform() < 0.02f) {
+                scale *= 2.0f;
+            }
+
+            frames[dvfs.level]++;
+            freq_sum += dvfs_get_point(&dvfs)->freq_cl / 1000000;
+            run(&dvfs, scale * WORKLOAD_CYCLES);
+        }
+
+        misses[mode] = dvfs.n_misses;
+        printf(
+            "%5d us %-8s: %5.1f MHz avg, %d%% / %d%% / %d%% / %d%% at 50 / 90 / 130 / 175 MHz, %d changes, %d misses\n",
+            period, mode_names[mode], (float)freq_sum / WORKLOAD_LENGTH,
+            100 * frames[0] / WORKLOAD_LENGTH, 100 * frames[1] / WORKLOAD_LENGTH,
+            100 * frames[2] / WORKLOAD_LENGTH, 100 * frames[3] / WORKLOAD_LENGTH,
+            dvfs.n_changes, dvfs.n_misses
+        );
+
+        if (mode != DVFS_MODE_FIXED) {
+            CHECK(frames[3] < WORKLOAD_LENGTH / 2, "%s: %d inferences at 175MHz", mode_names[mode], frames[3]);
+        }
+    }
+
+    CHECK(misses[DVFS_MODE_FIXED] == 0, "fixed: %d misses", misses[DVFS_MODE_FIXED]);
+    CHECK(misses[DVFS_MODE_DEADLINE] == 0, "deadline: %d misses", misses[DVFS_MODE_DEADLINE]);
+
+    // Slack mode misses the period at most on the inferences twice as slow as usual, 1 in 50
+    CHECK(misses[DVFS_MODE_SLACK] <= WORKLOAD_LENGTH / 50, "slack: %d misses", misses[DVFS_MODE_SLACK]);
+}
+
+int main() {
+    test_fixed();
+    test_step_down();
+    test_hysteresis();
+    test_step_up();
+    test_deadline();
+    test_voltage();
+
+    test_workload(33333);
+    test_workload(66666);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
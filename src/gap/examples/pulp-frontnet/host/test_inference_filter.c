@@ -0,0 +1,497 @@
+/*
+ * test_inference_filter.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the inference filter (lib/inference_filter.c). Checks the filter on hand-made
+ * sequences, then replays a synthetic inference sequence (a moving subject, network noise, spurious
+ * detections, a tracking loss and a jump of the subject) through the median and Hampel filters and
+ * reports the jitter (RMS of the frame-to-frame differences) and the error w.r.t. the ground truth
+ * of each output, before and after filtering.
+ *
+ * Recorded sequences can be replayed with `test_inference_filter FILE...`, where each file is an
+ * inference.csv saved by aideck_cpx_streamer (see InferenceSaver). Since they have no ground truth,
+ * only the jitter and the outliers are reported.
+ */
+
+#include "inference_filter.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define PI_F (3.14159265f)
+
+// Synthetic sequence, at the onboard inference rate
+#define SEQUENCE_LENGTH  (6000)
+#define SEQUENCE_PERIOD  (33000)  // [us]
+#define MAX_SEQUENCE     (100000)
+
+static const char *output_names[INFERENCE_FILTER_OUTPUTS] = {"x", "y", "z", "phi"};
+
+typedef struct sequence_s {
+    int length;
+    bool has_truth;
+    uint32_t timestamps[MAX_SEQUENCE];
+    float outputs[MAX_SEQUENCE][INFERENCE_FILTER_OUTPUTS];
+    float truth[MAX_SEQUENCE][INFERENCE_FILTER_OUTPUTS];
+    bool outlier[MAX_SEQUENCE];
+} sequence_t;
+
+typedef struct replay_stats_s {
+    float jitter[INFERENCE_FILTER_OUTPUTS];
+    float error[INFERENCE_FILTER_OUTPUTS];
+    float max_error[INFERENCE_FILTER_OUTPUTS];
+    float mean_confidence;
+    int flagged;
+    int detected;                 // Injected outliers that were flagged
+    int false_alarms;             // Flagged inferences without injected outliers
+} replay_stats_t;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+// Uniform in [0, 1)
+static float uniform() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return (rng_state >> 8) / (float)(1 << 24);
+}
+
+static float gaussian() {
+    float u = uniform();
+    float v = uniform();
+    return sqrtf(-2.0f * logf(1.0f - u)) * cosf(2.0f * PI_F * v);
+}
+
+static float wrap_angle(float angle) {
+    return angle - 2.0f * PI_F * floorf((angle + PI_F) / (2.0f * PI_F));
+}
+
+static float difference(int output, float a, float b) {
+    return (output == INFERENCE_FILTER_PHI) ? wrap_angle(a - b) : a - b;
+}
+
+static inference_filter_config_t make_config(inference_filter_mode_e mode) {
+    return (inference_filter_config_t){
+        .mode = mode,
+        .window = 7,
+        .threshold = 3.5f,
+        .min_scale = {0.05f, 0.05f, 0.03f, 0.1f},
+        .max_gap = 500000,
+    };
+}
+
+static void run(inference_filter_t *filter, uint32_t timestamp, float x, float y, float z, float phi, float output[4], inference_filter_result_t *result) {
+    output[0] = x;
+    output[1] = y;
+    output[2] = z;
+    output[3] = phi;
+    inference_filter_run(filter, timestamp, output, result);
+}
+
+static void test_warm_up() {
+    inference_filter_config_t config = make_config(INFERENCE_FILTER_HAMPEL);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+
+    // Not enough inferences to tell outliers apart, passed through unchanged
+    run(&filter, 0, 1.0f, 0.0f, 0.0f, 0.0f, output, &result);
+    CHECK(!result.filtered && !result.outlier && output[0] == 1.0f, "first inference filtered");
+    run(&filter, 33000, 5.0f, 0.0f, 0.0f, 0.0f, output, &result);
+    CHECK(!result.filtered && !result.outlier && output[0] == 5.0f, "second inference filtered");
+
+    run(&filter, 66000, 1.0f, 0.0f, 0.0f, 0.0f, output, &result);
+    CHECK(result.filtered && !result.outlier, "third inference not filtered");
+}
+
+static void test_constant() {
+    inference_filter_config_t config = make_config(INFERENCE_FILTER_HAMPEL);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+    for (int i = 0; i < 20; i++) {
+        run(&filter, i * 33000, 1.5f, -0.2f, 0.1f, 0.3f, output, &result);
+    }
+
+    CHECK(result.filtered && !result.outlier && result.confidence == 255, "constant: confidence %d", result.confidence);
+    CHECK(output[0] == 1.5f && output[3] == 0.3f, "constant: output changed");
+}
+
+static void test_spike(inference_filter_mode_e mode) {
+    inference_filter_config_t config = make_config(mode);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+    for (int i = 0; i < 10; i++) {
+        run(&filter, i * 33000, 1.5f + 0.02f * (i % 3), 0.0f, 0.0f, 0.0f, output, &result);
+    }
+
+    // Spurious detection of a second person, closer and to the side
+    run(&filter, 10 * 33000, 0.6f, 0.8f, 0.0f, 0.0f, output, &result);
+    CHECK(result.outlier && result.confidence == 0, "spike not flagged (deviation %.1f)", result.deviation);
+    CHECK(fabsf(output[0] - 1.52f) < 0.03f && fabsf(output[1]) < 0.01f, "spike not replaced: %.3f %.3f", output[0], output[1]);
+
+    run(&filter, 11 * 33000, 1.52f, 0.0f, 0.0f, 0.0f, output, &result);
+    CHECK(!result.outlier && result.confidence > 128, "after spike: outlier %d, confidence %d", result.outlier, result.confidence);
+}
+
+static void test_jump() {
+    inference_filter_config_t config = make_config(INFERENCE_FILTER_HAMPEL);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+    for (int i = 0; i < 10; i++) {
+        run(&filter, i * 33000, 1.5f, 0.0f, 0.0f, 0.0f, output, &result);
+    }
+
+    // The subject steps back: rejected until it is the majority of the window
+    int accepted = -1;
+    for (int i = 0; i < 10 && accepted < 0; i++) {
+        run(&filter, (10 + i) * 33000, 2.5f, 0.0f, 0.0f, 0.0f, output, &result);
+        if (!result.outlier) {
+            accepted = i;
+        }
+    }
+
+    CHECK(accepted == config.window / 2, "jump accepted after %d inferences", accepted);
+    CHECK(output[0] == 2.5f, "jump: output %.3f", output[0]);
+}
+
+static void test_phi_wrap() {
+    inference_filter_config_t config = make_config(INFERENCE_FILTER_MEDIAN);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+    float phis[] = {3.1f, -3.1f, 3.12f, -3.12f, 3.13f, -3.13f, 3.11f, -3.11f};
+    for (int i = 0; i < 8; i++) {
+        run(&filter, i * 33000, 1.5f, 0.0f, 0.0f, phis[i], output, &result);
+        CHECK(!result.outlier, "phi %.2f flagged", phis[i]);
+    }
+
+    CHECK(fabsf(wrap_angle(output[3] - PI_F)) < 0.05f, "phi median %.3f", output[3]);
+}
+
+static void test_gap() {
+    inference_filter_config_t config = make_config(INFERENCE_FILTER_HAMPEL);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    float output[4];
+    inference_filter_result_t result;
+    for (int i = 0; i < 10; i++) {
+        run(&filter, i * 33000, 1.5f, 0.0f, 0.0f, 0.0f, output, &result);
+    }
+
+    // Subject lost for a second and found somewhere else
+    run(&filter, 10 * 33000 + 1000000, 3.0f, 1.0f, 0.0f, 0.0f, output, &result);
+    CHECK(!result.filtered && output[0] == 3.0f && filter.n_resets == 1, "window not reset after a gap");
+
+    // Timestamps wrap around after ~71 minutes
+    inference_filter_init(&filter, &config);
+    for (int i = 0; i < 10; i++) {
+        run(&filter, UINT32_MAX - 100000 + i * 33000, 1.5f, 0.0f, 0.0f, 0.0f, output, &result);
+    }
+    CHECK(filter.n_resets == 0 && result.filtered, "window reset on timestamp wrap around");
+}
+
+// Smooth motion of the subject in front of the drone, with the noise and failure modes of the
+// network: Gaussian noise, spurious detections (single frames and pairs, on all outputs or on one),
+// a tracking loss and a jump of the subject.
+static void make_synthetic(sequence_t *sequence) {
+    const float noise[4] = {0.08f, 0.06f, 0.04f, 0.15f};
+    const float spike_min[4] = {0.5f, 0.4f, 0.3f, 0.8f};
+    const float spike_max[4] = {1.5f, 1.0f, 0.6f, 2.0f};
+
+    sequence->length = SEQUENCE_LENGTH;
+    sequence->has_truth = true;
+
+    uint32_t timestamp = 0;
+    int burst = 0;
+
+    for (int i = 0; i < SEQUENCE_LENGTH; i++) {
+        float t = timestamp * 1e-6f;
+        float *truth = sequence->truth[i];
+        float *output = sequence->outputs[i];
+
+        truth[0] = 1.5f + 0.4f * sinf(0.3f * t) + (i >= SEQUENCE_LENGTH * 3 / 4 ? 0.8f : 0.0f);
+        truth[1] = 0.5f * sinf(0.45f * t);
+        truth[2] = 0.1f * sinf(0.2f * t);
+        truth[3] = wrap_angle(2.8f + 0.8f * sinf(0.25f * t));
+
+        for (int k = 0; k < 4; k++) {
+            output[k] = truth[k] + noise[k] * gaussian();
+        }
+
+        bool outlier = burst > 0 || uniform() < 0.04f;
+        if (burst > 0) {
+            burst--;
+        } else if (outlier && uniform() < 0.25f) {
+            burst = 1;
+        }
+
+        if (outlier) {
+            bool all_outputs = uniform() < 0.5f;
+            int single = (int)(uniform() * 4) % 4;
+            for (int k = 0; k < 4; k++) {
+                if (all_outputs || k == single) {
+                    float spike = spike_min[k] + (spike_max[k] - spike_min[k]) * uniform();
+                    output[k] += uniform() < 0.5f ? -spike : spike;
+                }
+            }
+        }
+
+        output[3] = wrap_angle(output[3]);
+        sequence->outlier[i] = outlier;
+        sequence->timestamps[i] = timestamp;
+
+        // Tracking lost for a second halfway through the sequence, with some jitter in the inference period
+        timestamp += (i == SEQUENCE_LENGTH / 2) ? 1000000 : SEQUENCE_PERIOD + (int)(2000 * (uniform() - 0.5f));
+    }
+}
+
+// Read the onboard inferences from inference.csv (frame_id, frame_gap8_timestamp, output_x,
+// output_y, output_z, output_phi, ...)
+static bool load_csv(const char *path, sequence_t *sequence) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+
+    char line[512];
+    sequence->length = 0;
+    sequence->has_truth = false;
+
+    while (fgets(line, sizeof(line), file) && sequence->length < MAX_SEQUENCE) {
+        unsigned frame_id, timestamp;
+        float *output = sequence->outputs[sequence->length];
+        if (sscanf(line, "%u,%u,%f,%f,%f,%f", &frame_id, &timestamp, &output[0], &output[1], &output[2], &output[3]) == 6) {
+            sequence->timestamps[sequence->length] = timestamp;
+            sequence->outlier[sequence->length] = false;
+            sequence->length++;
+        }
+    }
+
+    fclose(file);
+    return sequence->length > 0;
+}
+
+static void replay(const sequence_t *sequence, const inference_filter_config_t *config, bool filter_enabled, replay_stats_t *stats) {
+    inference_filter_t filter;
+    inference_filter_init(&filter, config);
+
+    double jitter[4] = {0}, error[4] = {0}, confidence = 0;
+    float previous[4];
+
+    *stats = (replay_stats_t){0};
+
+    for (int i = 0; i < sequence->length; i++) {
+        float output[4];
+        memcpy(output, sequence->outputs[i], sizeof(output));
+
+        inference_filter_result_t result = {0};
+        if (filter_enabled) {
+            inference_filter_run(&filter, sequence->timestamps[i], output, &result);
+        }
+
+        if (result.outlier) {
+            stats->flagged++;
+            if (sequence->outlier[i]) {
+                stats->detected++;
+            } else {
+                stats->false_alarms++;
+            }
+        }
+        confidence += result.confidence;
+
+        for (int k = 0; k < 4; k++) {
+            if (i > 0) {
+                float d = difference(k, output[k], previous[k]);
+                jitter[k] += d * d;
+            }
+
+            if (sequence->has_truth) {
+                float e = fabsf(difference(k, output[k], sequence->truth[i][k]));
+                error[k] += e * e;
+                if (e > stats->max_error[k]) {
+                    stats->max_error[k] = e;
+                }
+            }
+
+            previous[k] = output[k];
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        stats->jitter[k] = sqrt(jitter[k] / (sequence->length - 1));
+        stats->error[k] = sqrt(error[k] / sequence->length);
+    }
+    stats->mean_confidence = confidence / sequence->length;
+}
+
+static void print_stats(const char *name, const sequence_t *sequence, const replay_stats_t *stats) {
+    printf("  %-7s jitter", name);
+    for (int k = 0; k < 4; k++) {
+        printf(" %s %.3f", output_names[k], stats->jitter[k]);
+    }
+
+    if (sequence->has_truth) {
+        printf(" | rms error");
+        for (int k = 0; k < 4; k++) {
+            printf(" %.3f", stats->error[k]);
+        }
+        printf(" | max error");
+        for (int k = 0; k < 4; k++) {
+            printf(" %.2f", stats->max_error[k]);
+        }
+    }
+
+    printf(" | flagged %5.1f%%, confidence %3.0f\n", 100.0f * stats->flagged / sequence->length, stats->mean_confidence);
+}
+
+static void compare(const sequence_t *sequence, replay_stats_t stats[3]) {
+    inference_filter_config_t median_config = make_config(INFERENCE_FILTER_MEDIAN);
+    inference_filter_config_t hampel_config = make_config(INFERENCE_FILTER_HAMPEL);
+
+    replay(sequence, &hampel_config, false, &stats[0]);
+    replay(sequence, &median_config, true, &stats[1]);
+    replay(sequence, &hampel_config, true, &stats[2]);
+
+    print_stats("raw", sequence, &stats[0]);
+    print_stats("median", sequence, &stats[1]);
+    print_stats("hampel", sequence, &stats[2]);
+}
+
+static void test_synthetic(sequence_t *sequence) {
+    make_synthetic(sequence);
+
+    int outliers = 0;
+    for (int i = 0; i < sequence->length; i++) {
+        outliers += sequence->outlier[i];
+    }
+
+    printf("synthetic sequence, %d inferences, %.1f%% outliers (window %d, threshold %.1f):\n",
+           sequence->length, 100.0f * outliers / sequence->length, make_config(0).window, make_config(0).threshold);
+
+    replay_stats_t stats[3];
+    compare(sequence, stats);
+
+    const replay_stats_t *raw = &stats[0], *median = &stats[1], *hampel = &stats[2];
+    int clean = sequence->length - outliers;
+
+    printf("  hampel detected %.1f%% of the outliers, false alarms on %.1f%% of the clean inferences\n",
+           100.0f * hampel->detected / outliers, 100.0f * hampel->false_alarms / clean);
+
+    for (int k = 0; k < 4; k++) {
+        CHECK(hampel->jitter[k] < 0.75f * raw->jitter[k], "hampel did not reduce the %s jitter", output_names[k]);
+        CHECK(median->jitter[k] < hampel->jitter[k], "median jitter of %s higher than hampel", output_names[k]);
+        CHECK(hampel->error[k] < raw->error[k], "hampel did not reduce the %s error", output_names[k]);
+    }
+
+    CHECK(hampel->detected > 0.85f * outliers, "hampel detected %d of %d outliers", hampel->detected, outliers);
+    CHECK(hampel->false_alarms < 0.05f * clean, "hampel flagged %d of %d clean inferences", hampel->false_alarms, clean);
+}
+
+static void benchmark(sequence_t *sequence, inference_filter_mode_e mode) {
+    inference_filter_config_t config = make_config(mode);
+    inference_filter_t filter;
+    inference_filter_init(&filter, &config);
+
+    const int rounds = 50;
+    float sum = 0.0f;
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < sequence->length; i++) {
+            float output[4];
+            memcpy(output, sequence->outputs[i], sizeof(output));
+
+            inference_filter_result_t result;
+            inference_filter_run(&filter, sequence->timestamps[i], output, &result);
+            sum += output[0];
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    float elapsed = (end.tv_sec - start.tv_sec) * 1e9f + (end.tv_usec - start.tv_usec) * 1e3f;
+    printf("%s: %.0f ns per call on the host (checksum %.1f)\n", mode == INFERENCE_FILTER_MEDIAN ? "median" : "hampel",
+           elapsed / (rounds * sequence->length), sum);
+}
+
+int main(int argc, char **argv) {
+    static sequence_t sequence;
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            if (!load_csv(argv[i], &sequence)) {
+                return 1;
+            }
+
+            printf("%s, %d inferences:\n", argv[i], sequence.length);
+            replay_stats_t stats[3];
+            compare(&sequence, stats);
+        }
+        return 0;
+    }
+
+    test_warm_up();
+    test_constant();
+    test_spike(INFERENCE_FILTER_HAMPEL);
+    test_spike(INFERENCE_FILTER_MEDIAN);
+    test_jump();
+    test_phi_wrap();
+    test_gap();
+
+    test_synthetic(&sequence);
+
+    benchmark(&sequence, INFERENCE_FILTER_MEDIAN);
+    benchmark(&sequence, INFERENCE_FILTER_HAMPEL);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
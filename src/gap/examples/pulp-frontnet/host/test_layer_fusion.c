@@ -0,0 +1,221 @@
+/*
+ * test_layer_fusion.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the fused first layer of Frontnet (layer0_BNReluConvolution_Pooling) against the
+ * two layers generated by DORY (layer0_BNReluConvolution, then layer1_Pooling). The DORY layers
+ * and PULP-NN kernels are compiled for the host on top of pmsis_host/, which runs the cluster
+ * cores as threads. Checks the unfused layers against the checksums generated by DORY, then the
+ * fused layer for bit-exactness on the real input and weights and on random ones.
+ */
+
+#include "pmsis.h"
+
+#include "layer0_BNReluConvolution.h"
+#include "layer0_BNReluConvolution_Pooling.h"
+#include "layer1_Pooling.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define HEX_DIR "../app/networks/frontnet-160x32-bgaug/hex/"
+
+#define INPUT_SIZE    (96 * 160 * 1)
+#define CONV_SIZE     (48 * 80 * 32)
+#define OUTPUT_SIZE   (24 * 40 * 32)
+#define WEIGHTS_SIZE  (1312)
+#define W_SIZE        (800)   // int8 weights, followed by int64 k and lambda
+#define L1_SIZE       (36700) // network_frontnet.L1_buffer_size
+
+// Generated by DORY, see network_frontnet.c
+#define CONV_CHECKSUM   (141585)
+#define OUTPUT_CHECKSUM (51732)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+static uint8_t *input, *weights, *conv, *output, *output_fused, *l1;
+
+static uint32_t get_time_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int load_file(const char *path, uint8_t *buffer, size_t size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("Cannot open %s\n", path);
+        return 0;
+    }
+
+    size_t read = fread(buffer, 1, size + 1, f);
+    fclose(f);
+
+    if (read != size) {
+        printf("%s: read %zuB but expected %zuB\n", path, read, size);
+        return 0;
+    }
+
+    return 1;
+}
+
+static uint32_t checksum(const uint8_t *data, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+// Same arguments as layer_args_t in network.c, only the L2 and L1 buffers are used
+static void run_layer(void (*layer)(void *), const uint8_t *x, uint8_t *y, const uint8_t *W, unsigned int out_shift) {
+    // Uninitialized L1 must not leak into the output
+    memset(l1, 0xa5, L1_SIZE);
+
+    unsigned int args[11] = {
+        [3] = pi_host_addr_32bit(x),
+        [5] = pi_host_addr_32bit(y),
+        [6] = pi_host_addr_32bit(W),
+        [7] = pi_host_addr_32bit(l1),
+        [9] = 1,
+        [10] = out_shift,
+    };
+    pi_cl_team_fork_host(layer, args);
+}
+
+static void run_unfused() {
+    run_layer(layer0_BNReluConvolution, input, conv, weights, 24);
+    run_layer(layer1_Pooling, conv, output, NULL, 0);
+}
+
+static void run_fused() {
+    run_layer(layer0_BNReluConvolution_Pooling, input, output_fused, weights, 24);
+}
+
+static int count_mismatches() {
+    int mismatches = 0;
+    for (int i = 0; i < OUTPUT_SIZE; i++) {
+        mismatches += (output[i] != output_fused[i]);
+    }
+    return mismatches;
+}
+
+static void test_reference() {
+    memset(output_fused, 0, OUTPUT_SIZE);
+
+    run_unfused();
+    CHECK(checksum(conv, CONV_SIZE) == CONV_CHECKSUM, "layer0 checksum %u, expected %u", checksum(conv, CONV_SIZE), CONV_CHECKSUM);
+    CHECK(checksum(output, OUTPUT_SIZE) == OUTPUT_CHECKSUM, "layer1 checksum %u, expected %u", checksum(output, OUTPUT_SIZE), OUTPUT_CHECKSUM);
+
+    run_fused();
+    CHECK(checksum(output_fused, OUTPUT_SIZE) == OUTPUT_CHECKSUM, "fused checksum %u, expected %u", checksum(output_fused, OUTPUT_SIZE), OUTPUT_CHECKSUM);
+    int mismatches = count_mismatches();
+    CHECK(mismatches == 0, "reference: %d/%d outputs differ", mismatches, OUTPUT_SIZE);
+}
+
+// Random inputs and weights, the k and lambda of the real network keep the outputs in range
+static void test_random(int trials) {
+    int mismatches = 0;
+    int saturated = 0, nonzero = 0;
+
+    for (int t = 0; t < trials; t++) {
+        for (int i = 0; i < INPUT_SIZE; i++) {
+            input[i] = rng() & 0xff;
+        }
+        for (int i = 0; i < W_SIZE; i++) {
+            weights[i] = rng() & 0xff;
+        }
+
+        run_unfused();
+        run_fused();
+        mismatches += count_mismatches();
+
+        for (int i = 0; i < OUTPUT_SIZE; i++) {
+            nonzero += (output[i] != 0);
+            saturated += (output[i] == 255);
+        }
+    }
+
+    printf(
+        "random: %d trials, %.1f%% non-zero and %.1f%% saturated outputs\n", trials,
+        100.0f * nonzero / (trials * OUTPUT_SIZE), 100.0f * saturated / (trials * OUTPUT_SIZE)
+    );
+    CHECK(mismatches == 0, "random: %d/%d outputs differ", mismatches, trials * OUTPUT_SIZE);
+}
+
+static void benchmark(int iterations) {
+    uint32_t start = get_time_us();
+    for (int i = 0; i < iterations; i++) {
+        run_unfused();
+    }
+    uint32_t unfused = get_time_us() - start;
+
+    start = get_time_us();
+    for (int i = 0; i < iterations; i++) {
+        run_fused();
+    }
+    uint32_t fused = get_time_us() - start;
+
+    printf("unfused %6.1f us, fused %6.1f us per call (host)\n", (float)unfused / iterations, (float)fused / iterations);
+}
+
+int main() {
+    input = pi_host_malloc_32bit(INPUT_SIZE);
+    weights = pi_host_malloc_32bit(WEIGHTS_SIZE);
+    conv = pi_host_malloc_32bit(CONV_SIZE);
+    output = pi_host_malloc_32bit(OUTPUT_SIZE);
+    output_fused = pi_host_malloc_32bit(OUTPUT_SIZE);
+    l1 = pi_host_malloc_32bit(L1_SIZE);
+
+    if (!load_file(HEX_DIR "inputs.hex", input, INPUT_SIZE)
+        || !load_file(HEX_DIR "layer0_BNReluConvolution_weights.hex", weights, WEIGHTS_SIZE)) {
+        return 1;
+    }
+
+    test_reference();
+    benchmark(20);
+    test_random(20);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * test_pulp_nn_kernels.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the im2col-free PULP-NN kernels against the generic pulp_nn_conv_u8_u8_i8, on
+ * random shapes, inputs and weights, for bit-exactness. The pointwise kernel is compared with the
+ * generic kernel on a 1x1 convolution, the depthwise kernel with the generic kernel run on each
+ * channel separately. Both are also run through pulp_nn_conv_select_u8_u8_i8, which must pick
+ * them by shape.
+ */
+
+#include "pmsis.h"
+
+#include "pulp_nn_kernels.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DIM      (16)
+#define MAX_CH       (40)
+#define MAX_KERNEL   (3)
+
+#define MAX_ACTIVATIONS (MAX_DIM * MAX_DIM * MAX_CH)
+#define MAX_WEIGHTS     (MAX_CH * MAX_CH * MAX_KERNEL * MAX_KERNEL)
+#define MAX_IM2COL      (2 * NUM_CORES * MAX_CH * MAX_KERNEL * MAX_KERNEL)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+static int rng_range(int min, int max) {
+    return min + rng() % (max - min + 1);
+}
+
+typedef enum {
+    KERNEL_GENERIC,
+    KERNEL_POINTWISE,
+    KERNEL_DEPTHWISE,
+    KERNEL_SELECT,
+} kernel_e;
+
+// Arguments of the PULP-NN convolutions, shared by all kernels
+typedef struct conv_args_s {
+    kernel_e kernel;
+    uint8_t flag_depthwise;
+
+    uint8_t *in;
+    uint8_t *im2col;
+    uint8_t *out;
+    int8_t *weights;
+    int64_t *kappa;
+    int64_t *lambda;
+    uint16_t out_mult, out_shift;
+
+    uint16_t dim_in_x, dim_in_y, ch_in;
+    uint16_t dim_out_x, dim_out_y, ch_out;
+    uint16_t dim_kernel;
+    uint16_t padding_top, padding_bottom, padding_left, padding_right;
+    uint16_t stride;
+    uint8_t flag_relu, flag_batch_norm;
+} conv_args_t;
+
+static void conv_entry(void *arg) {
+    conv_args_t *a = (conv_args_t *)arg;
+
+    switch (a->kernel) {
+        case KERNEL_GENERIC:
+            pulp_nn_conv_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, a->kappa, a->lambda, a->out_mult, a->out_shift,
+                a->dim_in_x, a->dim_in_y, a->ch_in, a->dim_out_x, a->dim_out_y, a->ch_out, a->dim_kernel, a->dim_kernel,
+                a->padding_top, a->padding_bottom, a->padding_left, a->padding_right, a->stride, a->stride,
+                a->flag_relu, a->flag_batch_norm
+            );
+            break;
+
+        case KERNEL_POINTWISE:
+            pulp_nn_pointwise_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, a->kappa, a->lambda, a->out_mult, a->out_shift,
+                a->dim_in_x, a->dim_in_y, a->ch_in, a->dim_out_x, a->dim_out_y, a->ch_out, a->dim_kernel, a->dim_kernel,
+                a->padding_top, a->padding_bottom, a->padding_left, a->padding_right, a->stride, a->stride,
+                a->flag_relu, a->flag_batch_norm
+            );
+            break;
+
+        case KERNEL_DEPTHWISE:
+            pulp_nn_depthwise_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, NULL, a->kappa, a->lambda, a->out_mult, a->out_shift,
+                a->dim_in_x, a->dim_in_y, a->ch_in, a->dim_out_x, a->dim_out_y, a->ch_out, a->dim_kernel, a->dim_kernel,
+                a->padding_top, a->padding_bottom, a->padding_left, a->padding_right, a->stride, a->stride,
+                a->flag_relu, a->flag_batch_norm
+            );
+            break;
+
+        case KERNEL_SELECT:
+            pulp_nn_conv_select_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, a->kappa, a->lambda, a->out_mult, a->out_shift,
+                a->dim_in_x, a->dim_in_y, a->ch_in, a->dim_out_x, a->dim_out_y, a->ch_out, a->dim_kernel, a->dim_kernel,
+                a->padding_top, a->padding_bottom, a->padding_left, a->padding_right, a->stride, a->stride,
+                a->flag_relu, a->flag_batch_norm, a->flag_depthwise
+            );
+            break;
+    }
+}
+
+static void run_conv(conv_args_t *args, kernel_e kernel, uint8_t *out) {
+    // Outputs not written by the kernel must not match by chance
+    memset(out, 0xa5, MAX_ACTIVATIONS);
+    memset(args->im2col, 0x5a, MAX_IM2COL);
+
+    args->kernel = kernel;
+    args->out = out;
+    pi_cl_team_fork_host(conv_entry, args);
+}
+
+static uint8_t *input, *im2col, *output, *output_ref, *plane_in, *plane_out;
+static int8_t *weights;
+static int64_t *kappa, *lambda;
+
+static int nonzero = 0, saturated = 0, total = 0;
+
+// Random quantization: BN + ReLU, ReLU only or clipping only, sized for the number of products
+static void random_quantization(conv_args_t *args, int n_products) {
+    int mode = rng_range(0, 2);
+    int shift = 8;
+    while ((1 << (2 * (shift - 8))) < n_products) {
+        shift++;
+    }
+
+    args->flag_relu = mode < 2;
+    args->flag_batch_norm = mode == 0;
+    args->out_mult = rng_range(1, 4);
+    args->out_shift = shift + (mode == 0 ? 2 : 0);
+
+    for (int i = 0; i < args->ch_out; i++) {
+        kappa[i] = rng_range(1, 4);
+        lambda[i] = (int64_t)rng_range(0, 1 << 16) << (shift - 8);
+    }
+}
+
+static void random_data(int input_size, int weights_size) {
+    for (int i = 0; i < input_size; i++) {
+        input[i] = rng() & 0xff;
+    }
+    for (int i = 0; i < weights_size; i++) {
+        weights[i] = rng() & 0xff;
+    }
+}
+
+static int count_mismatches(const uint8_t *a, const uint8_t *b, int size) {
+    int mismatches = 0;
+    for (int i = 0; i < size; i++) {
+        mismatches += (a[i] != b[i]);
+        nonzero += (b[i] != 0);
+        saturated += (b[i] == 255);
+    }
+    total += size;
+
+    return mismatches;
+}
+
+static conv_args_t random_shape(int dim_kernel, int stride, int padding, int depthwise) {
+    conv_args_t args = {
+        .in = input, .im2col = im2col, .weights = weights, .kappa = kappa, .lambda = lambda,
+        .dim_in_x = rng_range(1, MAX_DIM), .dim_in_y = rng_range(1, MAX_DIM),
+        .ch_in = rng_range(1, MAX_CH), .ch_out = rng_range(1, MAX_CH),
+        .dim_kernel = dim_kernel, .stride = stride,
+        .flag_depthwise = depthwise,
+    };
+
+    if (depthwise) {
+        args.ch_out = args.ch_in;
+    }
+
+    // Same padding when requested, only on the borders that need it with stride 2
+    if (padding) {
+        args.padding_top = args.padding_left = dim_kernel / 2;
+        args.padding_bottom = args.padding_right = dim_kernel / 2;
+    }
+
+    args.dim_out_x = (args.dim_in_x + args.padding_left + args.padding_right - dim_kernel) / stride + 1;
+    args.dim_out_y = (args.dim_in_y + args.padding_top + args.padding_bottom - dim_kernel) / stride + 1;
+
+    if (padding && stride > 1) {
+        args.padding_right = (args.dim_out_x - 1) * stride + dim_kernel - args.dim_in_x - args.padding_left;
+        args.padding_bottom = (args.dim_out_y - 1) * stride + dim_kernel - args.dim_in_y - args.padding_top;
+    }
+
+    return args;
+}
+
+static void test_pointwise(int trials) {
+    int mismatches = 0, mismatches_select = 0, outputs = 0;
+
+    for (int t = 0; t < trials; t++) {
+        conv_args_t args = random_shape(1, 1, 0, 0);
+        int output_size = args.dim_out_x * args.dim_out_y * args.ch_out;
+
+        random_data(args.dim_in_x * args.dim_in_y * args.ch_in, args.ch_in * args.ch_out);
+        random_quantization(&args, args.ch_in);
+
+        run_conv(&args, KERNEL_GENERIC, output_ref);
+        run_conv(&args, KERNEL_POINTWISE, output);
+        mismatches += count_mismatches(output, output_ref, output_size);
+
+        run_conv(&args, KERNEL_SELECT, output);
+        mismatches_select += count_mismatches(output, output_ref, output_size);
+        outputs += output_size;
+    }
+
+    CHECK(mismatches == 0, "pointwise: %d/%d outputs differ", mismatches, outputs);
+    CHECK(mismatches_select == 0, "pointwise select: %d/%d outputs differ", mismatches_select, outputs);
+}
+
+// The generic kernel has no depthwise mode, it is run on each channel as a convolution with one input
+// and one output channel
+static void run_depthwise_reference(conv_args_t *args) {
+    int in_pixels = args->dim_in_x * args->dim_in_y;
+    int out_pixels = args->dim_out_x * args->dim_out_y;
+    int kernel_size = args->dim_kernel * args->dim_kernel;
+
+    conv_args_t plane = *args;
+    plane.in = plane_in;
+    plane.ch_in = 1;
+    plane.ch_out = 1;
+
+    for (int c = 0; c < args->ch_in; c++) {
+        for (int p = 0; p < in_pixels; p++) {
+            plane_in[p] = input[p * args->ch_in + c];
+        }
+        plane.weights = args->weights + c * kernel_size;
+        plane.kappa = args->kappa + c;
+        plane.lambda = args->lambda + c;
+
+        run_conv(&plane, KERNEL_GENERIC, plane_out);
+
+        for (int p = 0; p < out_pixels; p++) {
+            output_ref[p * args->ch_out + c] = plane_out[p];
+        }
+    }
+}
+
+static void test_depthwise(int trials, int stride, int padding) {
+    int mismatches = 0, mismatches_select = 0, outputs = 0;
+
+    for (int t = 0; t < trials; t++) {
+        conv_args_t args = random_shape(3, stride, padding, 1);
+        if (args.dim_in_x < 3 || args.dim_in_y < 3) {
+            // Only the padded variants can be smaller than the kernel
+            if (!padding) {
+                continue;
+            }
+        }
+        int output_size = args.dim_out_x * args.dim_out_y * args.ch_out;
+
+        random_data(args.dim_in_x * args.dim_in_y * args.ch_in, args.ch_in * 9);
+        random_quantization(&args, 9);
+
+        run_depthwise_reference(&args);
+        run_conv(&args, KERNEL_DEPTHWISE, output);
+        mismatches += count_mismatches(output, output_ref, output_size);
+
+        run_conv(&args, KERNEL_SELECT, output);
+        mismatches_select += count_mismatches(output, output_ref, output_size);
+        outputs += output_size;
+    }
+
+    CHECK(mismatches == 0, "depthwise stride %d padding %d: %d/%d outputs differ", stride, padding, mismatches, outputs);
+    CHECK(mismatches_select == 0, "depthwise select stride %d padding %d: %d/%d outputs differ", stride, padding, mismatches_select, outputs);
+}
+
+// 3x3 convolutions must still go to the generic kernel
+static void test_select_generic(int trials) {
+    int mismatches = 0, outputs = 0;
+
+    for (int t = 0; t < trials; t++) {
+        conv_args_t args = random_shape(3, rng_range(1, 2), 1, 0);
+        int output_size = args.dim_out_x * args.dim_out_y * args.ch_out;
+
+        random_data(args.dim_in_x * args.dim_in_y * args.ch_in, args.ch_in * args.ch_out * 9);
+        random_quantization(&args, args.ch_in * 9);
+
+        run_conv(&args, KERNEL_GENERIC, output_ref);
+        run_conv(&args, KERNEL_SELECT, output);
+        mismatches += count_mismatches(output, output_ref, output_size);
+        outputs += output_size;
+    }
+
+    CHECK(mismatches == 0, "generic select: %d/%d outputs differ", mismatches, outputs);
+}
+
+int main() {
+    input = malloc(MAX_ACTIVATIONS);
+    im2col = malloc(MAX_IM2COL);
+    output = malloc(MAX_ACTIVATIONS);
+    output_ref = malloc(MAX_ACTIVATIONS);
+    plane_in = malloc(MAX_DIM * MAX_DIM);
+    plane_out = malloc(MAX_ACTIVATIONS);
+    weights = malloc(MAX_WEIGHTS);
+    kappa = malloc(MAX_CH * sizeof(int64_t));
+    lambda = malloc(MAX_CH * sizeof(int64_t));
+
+    test_pointwise(200);
+    test_depthwise(100, 1, 1);
+    test_depthwise(100, 2, 1);
+    test_depthwise(100, 1, 0);
+    test_select_generic(50);
+
+    printf(
+        "random: %d outputs, %.1f%% non-zero and %.1f%% saturated\n", total,
+        100.0f * nonzero / total, 100.0f * saturated / total
+    );
+    CHECK(nonzero > total / 4 && saturated < total / 4, "outputs out of range, the test is not meaningful");
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
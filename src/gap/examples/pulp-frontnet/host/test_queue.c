@@ -0,0 +1,377 @@
+/*
+ * test_queue.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the queues (lib/queue.c) on the event kernel of pmsis_host. Runs the queue and
+ * queue_async examples (examples/queue, examples/queue_async), then fuzzes the schedule of an
+ * async producer and consumer that take a random time to write and read each element.
+ *
+ * Usage: test_queue [iterations [first seed]], each iteration fuzzes one seed.
+ */
+
+#include "queue.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint64_t wall_clock_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ull + tv.tv_usec;
+}
+
+/* Queue example */
+
+static void test_queue() {
+    queue_t q;
+    queue_init(&q, 3, sizeof(int));
+
+    int *a = queue_push_acquire(&q, false);
+    *a = 1;
+    CHECK(queue_get_count(&q) == 0 && queue_peek(&q) == NULL, "acquired element visible");
+
+    queue_push_commit(&q, a);
+    CHECK(queue_peek(&q) == a, "committed element not at the head");
+
+    const int *a2 = queue_pop_consume(&q);
+    CHECK(a2 == a && *a2 == 1, "popped %p, expected %p", (void *)a2, (void *)a);
+    CHECK(queue_get_count(&q) == 0 && queue_peek(&q) == NULL, "consumed element still visible");
+    queue_pop_release(&q, a2);
+
+    int *b = queue_push_acquire(&q, false);
+    int *c = queue_push_acquire(&q, false);
+    int *d = queue_push_acquire(&q, false);
+    *b = 2;
+    *c = 3;
+    *d = 4;
+    CHECK(b == a + 1 && c == b + 1 && d == a, "elements not allocated in order");
+
+    // Full of acquired elements, nothing to overwrite
+    CHECK(queue_push_acquire(&q, false) == NULL, "acquired in a full queue");
+    CHECK(queue_push_acquire(&q, true) == NULL, "overwrote an acquired element");
+
+    queue_push_commit(&q, b);
+    queue_push_commit(&q, c);
+    queue_push_commit(&q, d);
+    CHECK(queue_get_count(&q) == 3, "count %d, expected 3", queue_get_count(&q));
+
+    // Overwrites the oldest element
+    int *e = queue_push_acquire(&q, true);
+    *e = 5;
+    CHECK(e == b && queue_get_count(&q) == 2, "overwrite: e %p, b %p, count %d", (void *)e, (void *)b, queue_get_count(&q));
+
+    queue_push_discard(&q, e);
+    CHECK(queue_get_count(&q) == 2, "count %d after discard", queue_get_count(&q));
+
+    int *e_ = queue_push_acquire(&q, true);
+    CHECK(queue_get_count(&q) == 2 && e_ == e, "acquire after discard: %p, expected %p", (void *)e_, (void *)e);
+    queue_push_commit(&q, e);
+
+    const int *c1 = queue_pop_consume(&q);
+    const int *d1 = queue_pop_consume(&q);
+    const int *e1 = queue_pop_consume(&q);
+    CHECK(c1 == c && *c1 == 3 && d1 == d && *d1 == 4 && e1 == e && *e1 == 5, "popped %d %d %d", *c1, *d1, *e1);
+
+    // Full of consumed elements, nothing to overwrite
+    CHECK(queue_push_acquire(&q, true) == NULL, "overwrote a consumed element");
+
+    queue_pop_release(&q, c1);
+    CHECK(queue_push_acquire(&q, true) == c1, "released element not reused");
+
+    queue_pop_release(&q, d1);
+    queue_pop_release(&q, e1);
+    queue_free(&q);
+}
+
+/* Async queue example */
+
+static queue_async_t example_q;
+
+static co_fn_ctx_t producer_ctx, consumer_ctx;
+static co_event_t producer_step, consumer_step;
+
+static int *a, *b, *c, *d, *e;
+static const int *a1, *b1, *c1, *d1, *e1;
+
+CO_FN_BEGIN(example_producer_task, void *, arg)
+{
+    static co_event_t queue_done;
+
+    (void)arg;
+    CHECK(queue_async_get_count(&example_q) == 0, "initial count %d", queue_async_get_count(&example_q));
+
+    co_event_push(&producer_step);
+
+    CO_WAIT(&consumer_step);
+    co_event_init(&consumer_step);
+
+    queue_async_push_acquire(&example_q, (void **)&a, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    *a = 1;
+    queue_async_push_commit(&example_q, a);
+
+    CO_WAIT(&consumer_step);
+    co_event_init(&consumer_step);
+
+    queue_async_push_acquire(&example_q, (void **)&b, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    *b = 2;
+    queue_async_push_commit(&example_q, b);
+
+    queue_async_push_acquire(&example_q, (void **)&c, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    *c = 3;
+    queue_async_push_commit(&example_q, c);
+
+    queue_async_push_acquire(&example_q, (void **)&d, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    *d = 4;
+    queue_async_push_commit(&example_q, d);
+
+    // The queue is full now, need to wait for the consumer
+    queue_async_push_acquire(&example_q, (void **)&e, co_event_init(&queue_done));
+    CHECK(!co_event_is_done(&queue_done), "acquired in a full queue");
+
+    co_event_push(&producer_step);
+
+    CO_WAIT(&queue_done);
+    CHECK(e == b, "acquired %p after the consumer released %p", (void *)e, (void *)b);
+
+    *e = 5;
+    queue_async_push_commit(&example_q, e);
+
+    co_event_push(&producer_step);
+}
+CO_FN_END()
+
+CO_FN_BEGIN(example_consumer_task, void *, arg)
+{
+    static co_event_t queue_done;
+
+    (void)arg;
+
+    CO_WAIT(&producer_step);
+    co_event_init(&producer_step);
+
+    // Empty queue, waits for the producer
+    queue_async_pop_consume(&example_q, (const void **)&a1, co_event_init(&queue_done));
+
+    co_event_push(&consumer_step);
+    CO_WAIT(&queue_done);
+    CHECK(a1 == a && *a1 == 1, "popped %p, expected %p", (void *)a1, (void *)a);
+
+    queue_async_pop_release(&example_q, a1);
+
+    co_event_push(&consumer_step);
+
+    CO_WAIT(&producer_step);
+    co_event_init(&producer_step);
+
+    queue_async_pop_consume(&example_q, (const void **)&b1, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    CHECK(b1 == b && *b1 == 2, "popped %p, expected %p", (void *)b1, (void *)b);
+
+    queue_async_pop_release(&example_q, b1);
+
+    CO_WAIT(&producer_step);
+    co_event_init(&producer_step);
+
+    queue_async_pop_consume(&example_q, (const void **)&c1, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+
+    queue_async_pop_consume(&example_q, (const void **)&d1, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+
+    queue_async_pop_consume(&example_q, (const void **)&e1, co_event_init(&queue_done));
+    CO_WAIT(&queue_done);
+    CHECK(*c1 == 3 && *d1 == 4 && *e1 == 5, "popped %d %d %d", *c1, *d1, *e1);
+
+    queue_async_pop_release(&example_q, c1);
+    queue_async_pop_release(&example_q, d1);
+    queue_async_pop_release(&example_q, e1);
+}
+CO_FN_END()
+
+static void test_queue_async() {
+    pi_host_sched_init(0, 0, 0);
+    queue_async_init(&example_q, 3, sizeof(int));
+
+    co_event_init(&producer_step);
+    co_event_init(&consumer_step);
+
+    static pi_task_t producer_done, consumer_done;
+    co_fn_push_start(&producer_ctx, example_producer_task, NULL, pi_task_block(&producer_done));
+    co_fn_push_start(&consumer_ctx, example_consumer_task, NULL, pi_task_block(&consumer_done));
+
+    while ((!producer_done.done || !consumer_done.done) && pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+
+    CHECK(producer_done.done && consumer_done.done, "async example did not complete");
+    CHECK(queue_async_get_count(&example_q) == 0, "count %d at the end", queue_async_get_count(&example_q));
+
+    while (pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+    queue_free(&example_q.q);
+}
+
+/* Schedule fuzzing */
+
+#define FUZZ_CAPACITY (3)
+#define FUZZ_ELEMENTS (64)
+
+typedef struct fuzz_s fuzz_t;
+
+typedef struct fuzz_task_frame_s {
+    int i;
+    int *el;
+} fuzz_task_frame_t;
+
+typedef struct fuzz_s {
+    uint32_t seed;
+    uint32_t rng_state;
+
+    queue_async_t q;
+
+    CO_FN_CTX_WITH_FRAME(fuzz_task_frame_t) producer_ctx;
+    co_event_t push_done, producer_tick;
+    pi_task_t producer_done;
+
+    CO_FN_CTX_WITH_FRAME(fuzz_task_frame_t) consumer_ctx;
+    co_event_t pop_done, consumer_tick;
+    pi_task_t consumer_done;
+} fuzz_t;
+
+static uint32_t fuzz_delay(fuzz_t *fuzz) {
+    fuzz->rng_state = fuzz->rng_state * 1664525 + 1013904223;
+    return (fuzz->rng_state >> 8) % 50;
+}
+
+static void fuzz_check_count(fuzz_t *fuzz) {
+    queue_t *q = &fuzz->q.q;
+    int used = q->count + q->count_acq + q->count_consume;
+    CHECK(used >= 0 && used <= FUZZ_CAPACITY, "seed %u: %d elements in use", fuzz->seed, used);
+}
+
+CO_FN_BEGIN_WITH_FRAME(fuzz_producer_task, fuzz_t *, fuzz, fuzz_task_frame_t, locals)
+{
+    for (locals->i = 0; locals->i < FUZZ_ELEMENTS; locals->i++) {
+        queue_async_push_acquire(&fuzz->q, (void **)&locals->el, co_event_init(&fuzz->push_done));
+        CO_WAIT(&fuzz->push_done);
+        CHECK(locals->el != NULL, "seed %u: acquired NULL", fuzz->seed);
+        fuzz_check_count(fuzz);
+
+        // Writing the element takes some time
+        pi_task_push_delayed_us(co_event_init(&fuzz->producer_tick), fuzz_delay(fuzz));
+        CO_WAIT(&fuzz->producer_tick);
+
+        *locals->el = locals->i;
+        queue_async_push_commit(&fuzz->q, locals->el);
+    }
+}
+CO_FN_END()
+
+CO_FN_BEGIN_WITH_FRAME(fuzz_consumer_task, fuzz_t *, fuzz, fuzz_task_frame_t, locals)
+{
+    for (locals->i = 0; locals->i < FUZZ_ELEMENTS; locals->i++) {
+        queue_async_pop_consume(&fuzz->q, (const void **)&locals->el, co_event_init(&fuzz->pop_done));
+        CO_WAIT(&fuzz->pop_done);
+        CHECK(locals->el != NULL && *locals->el == locals->i, "seed %u: popped %d, expected %d", fuzz->seed, locals->el ? *locals->el : -1, locals->i);
+        fuzz_check_count(fuzz);
+
+        // Reading the element takes some time
+        pi_task_push_delayed_us(co_event_init(&fuzz->consumer_tick), fuzz_delay(fuzz));
+        CO_WAIT(&fuzz->consumer_tick);
+
+        queue_async_pop_release(&fuzz->q, locals->el);
+    }
+}
+CO_FN_END()
+
+static bool fuzz_run(uint32_t seed) {
+    static fuzz_t fuzz;
+    int failures_before = failures;
+
+    pi_host_sched_init(seed, 10, 20);
+
+    fuzz = (fuzz_t){ .seed = seed, .rng_state = seed };
+    queue_async_init(&fuzz.q, FUZZ_CAPACITY, sizeof(int));
+    co_fn_push_start_with_frame(&fuzz.producer_ctx, fuzz_producer_task, &fuzz, pi_task_block(&fuzz.producer_done));
+    co_fn_push_start_with_frame(&fuzz.consumer_ctx, fuzz_consumer_task, &fuzz, pi_task_block(&fuzz.consumer_done));
+
+    while (pi_host_sched_pending() > 0) {
+        pi_yield();
+    }
+
+    CHECK(fuzz.producer_done.done && fuzz.consumer_done.done, "seed %u: producer %s, consumer %s", seed,
+          fuzz.producer_done.done ? "done" : "stuck", fuzz.consumer_done.done ? "done" : "stuck");
+    CHECK(queue_async_get_count(&fuzz.q) == 0, "seed %u: count %d at the end", seed, queue_async_get_count(&fuzz.q));
+
+    queue_free(&fuzz.q.q);
+    return failures == failures_before;
+}
+
+static void test_fuzz(int iterations, uint32_t first_seed) {
+    uint64_t start = wall_clock_us();
+
+    int i;
+    for (i = 0; i < iterations; i++) {
+        if (!fuzz_run(first_seed + i)) {
+            printf("Seed %u failed, run again with: test_queue 1 %u\n", first_seed + i, first_seed + i);
+            break;
+        }
+    }
+
+    uint64_t elapsed = wall_clock_us() - start;
+    printf("%d schedules in %.1f ms, %.0f schedules/s\n", i, elapsed / 1000.0, i * 1e6 / (elapsed > 0 ? elapsed : 1));
+}
+
+int main(int argc, char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    uint32_t first_seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1;
+
+    test_queue();
+    test_queue_async();
+    test_fuzz(iterations, first_seed);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
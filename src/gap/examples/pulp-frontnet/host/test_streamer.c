@@ -0,0 +1,200 @@
+/*
+ * test_streamer.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of two streamers (lib/streamer.c) sending frames at the same time, each over its own
+ * loopback CPX link (cpx_loopback.c) on the event kernel of pmsis_host. The send coroutines of the
+ * two streamers interleave at each packet, so that locals shared between them would mix up the
+ * frames: each streamer receives its own frames back and checks them byte by byte.
+ */
+
+#include "camera.h"
+#include "cpx/cpx.h"
+#include "streamer.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_STREAMERS (2)
+#define N_ROUNDS    (8)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+// Used by trace.h
+pi_device_t gpio;
+
+typedef struct test_link_s {
+    cpx_t cpx;
+    camera_t camera;
+    streamer_t streamer;
+
+    uint16_t width, height;
+    size_t buffer_size;
+
+    // Frames sent back to the streamer
+    void *storage;
+    streamer_buffer_t buffer;
+    pi_task_t sent_task, received_task;
+} test_link_t;
+
+static test_link_t links[N_STREAMERS];
+
+static uint32_t rng_state;
+
+static uint8_t random_byte() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 24;
+}
+
+// Replacement of lib/camera.c, the streamer only uses the buffers
+
+size_t camera_get_buffer_size(const camera_t *camera) {
+    for (int i = 0; i < N_STREAMERS; i++) {
+        if (camera == &links[i].camera) {
+            return links[i].buffer_size;
+        }
+    }
+
+    return 0;
+}
+
+int camera_get_buffer_id(const camera_t *camera, const frame_t *frame) {
+    return frame - camera->frames;
+}
+
+void camera_init_frames_external(camera_t *camera, int n_buffers, uint8_t *buffers[], size_t buffers_size) {
+    for (int i = 0; i < n_buffers; i++) {
+        camera->frames[i] = (frame_t){ .buffer = buffers[i], .buffer_size = buffers_size };
+    }
+}
+
+// The streamer pads the last packet to 4 bytes, which the receiver drops unless the frame is a
+// multiple of 4 bytes: height is 1 mod 4, each extra column adds 1 mod 4 bytes
+static void link_init(test_link_t *link, uint16_t width, uint16_t height) {
+    link->height = height;
+    link->width = width;
+    while ((sizeof(streamer_payload_t) + link->width * link->height) % 4 != 0) {
+        link->width++;
+    }
+    link->buffer_size = link->width * link->height;
+
+    cpx_init(&link->cpx);
+    streamer_init(&link->streamer, &link->camera, &link->cpx);
+    streamer_alloc_frames(&link->streamer, &link->camera);
+
+    link->storage = malloc(sizeof(streamer_payload_t) + link->buffer_size);
+}
+
+static void link_send(test_link_t *link, int round) {
+    frame_t *frame = &link->camera.frames[round % CAMERA_BUFFERS];
+    frame->width = link->width;
+    frame->height = link->height;
+    frame->frame_id = round;
+    frame->frame_timestamp = pi_time_get_us();
+
+    rng_state = 0x12345678 + round * N_STREAMERS + (link - links);
+    for (size_t i = 0; i < link->buffer_size; i++) {
+        frame->buffer[i] = random_byte();
+    }
+
+    streamer_buffer_init(&link->buffer, link->storage, sizeof(streamer_payload_t) + link->buffer_size);
+    streamer_receive_buffer_async(&link->streamer, &link->buffer, pi_task_block(&link->received_task));
+
+    state_msg_t state = {0};
+    tof_msg_t tof = {0};
+    inference_stamped_msg_t inference = {0};
+    streamer_send_frame_async(
+        &link->streamer, frame, &state, 0, &tof, 0, &inference, NULL, NULL,
+        pi_task_block(&link->sent_task)
+    );
+}
+
+static void link_check(test_link_t *link, int round) {
+    pi_task_wait_on(&link->sent_task);
+    pi_task_wait_on(&link->received_task);
+
+    int id = link - links;
+    size_t size = sizeof(streamer_payload_t) + link->buffer_size;
+    CHECK(link->buffer.size == size && link->buffer.received_size == size,
+          "streamer %d, round %d: received %zu of %zu bytes, expected %zu", id, round, link->buffer.received_size, link->buffer.size, size);
+
+    streamer_payload_t *payload = link->storage;
+    CHECK(payload->metadata.frame_id == round && payload->metadata.frame_width == link->width && payload->metadata.frame_height == link->height,
+          "streamer %d, round %d: received frame %d (%dx%d)", id, round, payload->metadata.frame_id, payload->metadata.frame_width, payload->metadata.frame_height);
+
+    rng_state = 0x12345678 + round * N_STREAMERS + id;
+    size_t errors = 0;
+    for (size_t i = 0; i < link->buffer_size; i++) {
+        errors += payload->buffer[i] != random_byte();
+    }
+    CHECK(errors == 0, "streamer %d, round %d: %zu bytes differ", id, round, errors);
+}
+
+int main() {
+    // Frames of different sizes, so that the two streamers are at different packets
+    link_init(&links[0], 160, 97);
+    link_init(&links[1], 64, 49);
+
+    // One streamer at a time, for reference
+    uint32_t sequential = 0;
+    for (int i = 0; i < N_STREAMERS; i++) {
+        uint32_t start = pi_time_get_us();
+        link_send(&links[i], 0);
+        link_check(&links[i], 0);
+        sequential += pi_time_get_us() - start;
+    }
+
+    uint32_t concurrent = 0;
+    for (int round = 1; round < N_ROUNDS; round++) {
+        uint32_t start = pi_time_get_us();
+        for (int i = 0; i < N_STREAMERS; i++) {
+            link_send(&links[i], round);
+        }
+        for (int i = 0; i < N_STREAMERS; i++) {
+            link_check(&links[i], round);
+        }
+
+        uint32_t elapsed = pi_time_get_us() - start;
+        CHECK(elapsed < sequential, "round %d: %u us, %u us one streamer at a time", round, elapsed, sequential);
+        concurrent += elapsed;
+    }
+
+    printf("%d streamers: %u us per frame one at a time, %u us concurrently\n", N_STREAMERS, sequential, concurrent / (N_ROUNDS - 1));
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
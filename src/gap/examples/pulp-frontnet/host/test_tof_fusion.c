@@ -0,0 +1,353 @@
+/*
+ * test_tof_fusion.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the ToF-camera fusion (lib/tof_fusion.c) on synthetic geometry: the ToF frames are
+ * rendered by casting the zone rays against a subject (a flat box, with its head at the subject
+ * position) in front of a wall, with a ToF sensor that is offset and rotated w.r.t. the camera, then
+ * quantized as tof.c does. Checks each fusion outcome, then reports the distance error of noisy
+ * network predictions before and after fusion, and the host time per call.
+ */
+
+#include "tof_fusion.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define DEG (3.14159265f / 180.0f)
+
+// Scene, in the body frame [m]
+#define WALL_DISTANCE    (3.5f)
+#define SUBJECT_WIDTH    (0.44f)
+#define SUBJECT_ABOVE    (0.2f)  // From the subject position (head) to the top of the box
+#define SUBJECT_BELOW    (1.0f)  // From the subject position to the bottom of the box
+
+typedef struct scene_s {
+    float subject[3];
+    bool subject_visible;
+} scene_t;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                        \
+    if (!(cond)) {                                   \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__);  \
+        printf(__VA_ARGS__);                         \
+        printf("\n");                                \
+        failures++;                                  \
+    }                                                \
+} while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+// Uniform in [-1, 1]
+static float noise() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return (rng_state >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+static tof_fusion_transform_t rotation_z(float angle, float tx, float ty, float tz) {
+    return (tof_fusion_transform_t){
+        .rotation = {
+            {cosf(angle), -sinf(angle), 0.0f},
+            {sinf(angle),  cosf(angle), 0.0f},
+            {0.0f,         0.0f,        1.0f},
+        },
+        .translation = {tx, ty, tz},
+    };
+}
+
+static tof_fusion_config_t make_config() {
+    tof_fusion_config_t config = {
+        .body_to_camera = {
+            .rotation = {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f, 0.0f}},
+            .translation = {0.0f, 0.0f, 0.0f},
+        },
+        // Zone grid upside down w.r.t. the camera, slightly tilted and offset
+        .tof_to_camera = rotation_z(180.0f * DEG + 3.0f * DEG, 0.01f, 0.025f, -0.01f),
+        .tof_fov = 45.0f * DEG,
+        .subject_width = 0.4f,
+        .subject_height = 0.5f,
+        .foreground_depth = 0.3f,
+        .max_deviation = 0.75f,
+        .weight = 0.8f,
+        .min_zones = 2,
+        .max_age = 150000,
+    };
+
+    return config;
+}
+
+// Rotate a direction and transform a point from the ToF frame to the body frame, independently
+// from tof_fusion.c: body = R_bc^T (R_ct p + t_ct - t_bc)
+static void tof_to_body(const tof_fusion_config_t *config, const float p[3], bool is_point, float out[3]) {
+    float camera[3];
+    for (int i = 0; i < 3; i++) {
+        camera[i] = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            camera[i] += config->tof_to_camera.rotation[i][j] * p[j];
+        }
+        if (is_point) {
+            camera[i] += config->tof_to_camera.translation[i] - config->body_to_camera.translation[i];
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        out[i] = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            out[i] += config->body_to_camera.rotation[j][i] * camera[j];
+        }
+    }
+}
+
+// Range along a ray in the body frame, against the subject box or the wall
+static float cast_ray(const scene_t *scene, const float origin[3], const float direction[3], bool *hit_subject) {
+    float range = (WALL_DISTANCE - origin[0]) / direction[0];
+    *hit_subject = false;
+
+    if (scene->subject_visible) {
+        float t = (scene->subject[0] - origin[0]) / direction[0];
+        float y = origin[1] + t * direction[1];
+        float z = origin[2] + t * direction[2];
+
+        if (t > 0.0f && t < range
+            && fabsf(y - scene->subject[1]) <= 0.5f * SUBJECT_WIDTH
+            && z <= scene->subject[2] + SUBJECT_ABOVE && z >= scene->subject[2] - SUBJECT_BELOW) {
+            range = t;
+            *hit_subject = true;
+        }
+    }
+
+    return range;
+}
+
+// Each zone is sampled with ZONE_SAMPLES x ZONE_SAMPLES rays. Like the VL53L5CX with the closest
+// target order, a zone reports the subject if it covers at least ZONE_MIN_COVERAGE of the zone.
+#define ZONE_SAMPLES      (4)
+#define ZONE_MIN_COVERAGE (0.25f)
+
+static void render(const tof_fusion_config_t *config, const scene_t *scene, uint8_t resolution, uint8_t *zones) {
+    int side = (resolution == 64) ? 8 : 4;
+
+    float zero[3] = {0.0f, 0.0f, 0.0f};
+    float origin[3];
+    tof_to_body(config, zero, true, origin);
+
+    for (int row = 0; row < side; row++) {
+        for (int col = 0; col < side; col++) {
+            float subject_range = 0.0f, wall_range = 0.0f;
+            int subject_hits = 0;
+
+            for (int sample = 0; sample < ZONE_SAMPLES * ZONE_SAMPLES; sample++) {
+                float u = col + (sample % ZONE_SAMPLES + 0.5f) / ZONE_SAMPLES;
+                float v = row + (sample / ZONE_SAMPLES + 0.5f) / ZONE_SAMPLES;
+                float angle_x = (u / side - 0.5f) * config->tof_fov;
+                float angle_y = (v / side - 0.5f) * config->tof_fov;
+                float tof_direction[3] = {tanf(angle_x), tanf(angle_y), 1.0f};
+                float norm = sqrtf(tof_direction[0] * tof_direction[0] + tof_direction[1] * tof_direction[1] + 1.0f);
+                for (int k = 0; k < 3; k++) {
+                    tof_direction[k] /= norm;
+                }
+
+                float direction[3];
+                tof_to_body(config, tof_direction, false, direction);
+
+                bool hit_subject;
+                float range = cast_ray(scene, origin, direction, &hit_subject);
+                if (hit_subject) {
+                    subject_range += range;
+                    subject_hits++;
+                } else {
+                    wall_range += range;
+                }
+            }
+
+            int samples = ZONE_SAMPLES * ZONE_SAMPLES;
+            float range = (subject_hits >= ZONE_MIN_COVERAGE * samples) ? subject_range / subject_hits
+                                                                         : wall_range / (samples - subject_hits);
+
+            // Range noise of a few millimeters, quantized as in tof.c
+            range += 0.005f * noise();
+            zones[row * side + col] = (range < TOF_FUSION_RANGE_MAX) ? (uint8_t)(range / TOF_FUSION_RANGE_MAX * 255) : TOF_FUSION_ZONE_INVALID;
+        }
+    }
+}
+
+static tof_fusion_status_e fuse(
+    tof_fusion_t *fusion, const scene_t *scene, uint8_t resolution, const float prediction[3], uint32_t age,
+    float position[3], tof_fusion_result_t *result
+) {
+    uint8_t zones[TOF_MAX_ZONES];
+    render(&fusion->config, scene, resolution, zones);
+
+    memcpy(position, prediction, 3 * sizeof(float));
+    return tof_fusion_run(fusion, position, zones, resolution, age, result);
+}
+
+static void test_outcomes(uint8_t resolution) {
+    tof_fusion_config_t config = make_config();
+    tof_fusion_t fusion;
+    tof_fusion_init(&fusion, &config);
+
+    scene_t scene = {.subject = {1.5f, 0.1f, 0.0f}, .subject_visible = true};
+    tof_fusion_result_t result;
+    float position[3];
+
+    // Exact prediction: validated, distance unchanged up to the ToF quantization
+    tof_fusion_status_e status = fuse(&fusion, &scene, resolution, scene.subject, 0, position, &result);
+    CHECK(status == TOF_FUSION_FUSED, "%d zones: exact prediction, status %d", resolution, status);
+    CHECK(fabsf(result.tof_depth - scene.subject[0]) < 0.03f, "%d zones: ToF depth %.3f, expected %.3f", resolution, result.tof_depth, scene.subject[0]);
+    CHECK(fabsf(position[0] - scene.subject[0]) < 0.03f, "%d zones: fused x %.3f, expected %.3f", resolution, position[0], scene.subject[0]);
+
+    // Biased prediction: moved towards the ToF depth, along the camera ray
+    float biased[3] = {scene.subject[0] + 0.4f, scene.subject[1] * 1.2f, 0.05f};
+    status = fuse(&fusion, &scene, resolution, biased, 0, position, &result);
+    float expected_x = biased[0] + config.weight * (result.tof_depth - biased[0]);
+    CHECK(status == TOF_FUSION_FUSED, "%d zones: biased prediction, status %d", resolution, status);
+    CHECK(fabsf(position[0] - expected_x) < 1e-4f, "%d zones: fused x %.3f, expected %.3f", resolution, position[0], expected_x);
+    CHECK(fabsf(position[0] - scene.subject[0]) < 0.4f * (1.0f - config.weight) + 0.03f, "%d zones: fused x %.3f too far from %.3f", resolution, position[0], scene.subject[0]);
+    CHECK(fabsf(position[1] / position[0] - biased[1] / biased[0]) < 1e-5f && fabsf(position[2] / position[0] - biased[2] / biased[0]) < 1e-5f,
+          "%d zones: bearing changed", resolution);
+
+    // Prediction far from the ToF depth: rejected, prediction unchanged
+    float wrong[3] = {scene.subject[0] + 1.2f, scene.subject[1], 0.0f};
+    status = fuse(&fusion, &scene, resolution, wrong, 0, position, &result);
+    CHECK(status == TOF_FUSION_REJECTED, "%d zones: wrong prediction, status %d", resolution, status);
+    CHECK(memcmp(position, wrong, sizeof(wrong)) == 0, "%d zones: rejected prediction modified", resolution);
+
+    // Subject outside of the ToF field of view, but still in the camera's
+    scene_t side_scene = {.subject = {1.5f, 1.5f * tanf(35.0f * DEG), 0.0f}, .subject_visible = true};
+    status = fuse(&fusion, &side_scene, resolution, side_scene.subject, 0, position, &result);
+    CHECK(status == TOF_FUSION_NO_ZONES, "%d zones: subject outside of ToF FoV, status %d", resolution, status);
+
+    // No valid zones
+    uint8_t invalid[TOF_MAX_ZONES];
+    memset(invalid, TOF_FUSION_ZONE_INVALID, sizeof(invalid));
+    memcpy(position, scene.subject, sizeof(position));
+    status = tof_fusion_run(&fusion, position, invalid, resolution, 0, &result);
+    CHECK(status == TOF_FUSION_NO_ZONES, "%d zones: invalid zones, status %d", resolution, status);
+
+    // Stale ToF frame
+    status = fuse(&fusion, &scene, resolution, biased, config.max_age + 1, position, &result);
+    CHECK(status == TOF_FUSION_STALE && memcmp(position, biased, sizeof(biased)) == 0, "%d zones: stale frame, status %d", resolution, status);
+
+    // Prediction behind the camera
+    float behind[3] = {-1.0f, 0.0f, 0.0f};
+    status = fuse(&fusion, &scene, resolution, behind, 0, position, &result);
+    CHECK(status == TOF_FUSION_INVALID, "%d zones: prediction behind the camera, status %d", resolution, status);
+
+    CHECK(fusion.n_status[TOF_FUSION_FUSED] == 2 && fusion.n_status[TOF_FUSION_REJECTED] == 1 && fusion.n_status[TOF_FUSION_NO_ZONES] == 2
+       && fusion.n_status[TOF_FUSION_STALE] == 1 && fusion.n_status[TOF_FUSION_INVALID] == 1, "%d zones: wrong statistics", resolution);
+}
+
+// Network predictions with uniform depth noise and a small bearing noise, over a range of subject positions
+static void test_accuracy(uint8_t resolution, float depth_noise) {
+    tof_fusion_config_t config = make_config();
+    tof_fusion_t fusion;
+    tof_fusion_init(&fusion, &config);
+
+    float error_before = 0.0f;
+    float error_after = 0.0f;
+    int count = 0;
+
+    for (float x = 0.8f; x <= 3.01f; x += 0.1f) {
+        for (float bearing = -15.0f; bearing <= 15.0f; bearing += 7.5f) {
+            scene_t scene = {.subject = {x, x * tanf(bearing * DEG), 0.1f * noise()}, .subject_visible = true};
+
+            for (int trial = 0; trial < 8; trial++) {
+                float prediction[3] = {
+                    x + depth_noise * noise(),
+                    scene.subject[1] + 0.02f * x * noise(),
+                    scene.subject[2] + 0.02f * x * noise(),
+                };
+
+                float position[3];
+                tof_fusion_result_t result;
+                fuse(&fusion, &scene, resolution, prediction, 0, position, &result);
+
+                error_before += fabsf(prediction[0] - x);
+                error_after += fabsf(position[0] - x);
+                count++;
+            }
+        }
+    }
+
+    error_before /= count;
+    error_after /= count;
+
+    printf(
+        "%2d zones, depth noise +-%.2fm: x error %.3fm -> %.3fm, fused %5.1f%%, rejected %4.1f%%, no zones %4.1f%%\n",
+        resolution, depth_noise, error_before, error_after,
+        100.0f * fusion.n_status[TOF_FUSION_FUSED] / count,
+        100.0f * fusion.n_status[TOF_FUSION_REJECTED] / count,
+        100.0f * fusion.n_status[TOF_FUSION_NO_ZONES] / count
+    );
+
+    CHECK(error_after < 0.6f * error_before, "%d zones: fusion did not reduce the x error", resolution);
+}
+
+static void benchmark(uint8_t resolution) {
+    tof_fusion_config_t config = make_config();
+    tof_fusion_t fusion;
+    tof_fusion_init(&fusion, &config);
+
+    scene_t scene = {.subject = {1.5f, 0.1f, 0.0f}, .subject_visible = true};
+    uint8_t zones[TOF_MAX_ZONES];
+    render(&config, &scene, resolution, zones);
+
+    const int rounds = 200000;
+    float sum = 0.0f;
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < rounds; i++) {
+        float position[3] = {1.5f + (i % 7) * 0.01f, 0.1f, 0.0f};
+        tof_fusion_result_t result;
+        tof_fusion_run(&fusion, position, zones, resolution, 0, &result);
+        sum += position[0];
+    }
+    gettimeofday(&end, NULL);
+
+    float elapsed = (end.tv_sec - start.tv_sec) * 1e9f + (end.tv_usec - start.tv_usec) * 1e3f;
+    printf("%2d zones: %.0f ns per call on the host (checksum %.1f)\n", resolution, elapsed / rounds, sum);
+}
+
+int main() {
+    test_outcomes(64);
+    test_outcomes(16);
+
+    test_accuracy(64, 0.3f);
+    test_accuracy(16, 0.3f);
+    test_accuracy(64, 0.6f);
+
+    benchmark(64);
+    benchmark(16);
+
+    printf("%d failures\n", failures);
+    return failures > 0 ? 1 : 0;
+}
@@ -25,14 +25,20 @@
 #include "config.h"
 #include "coroutine.h"
 #include "camera.h"
+#include "clock_sync.h"
 #include "cluster.h"
 #include "cpx/cpx.h"
 #include "debug.h"
+#include "dvfs.h"
+#include "inference_filter.h"
+#include "preprocess.h"
 #include "rng.h"
 #include "soc.h"
 #include "streamer.h"
 #include "time.h"
+#include "tof_fusion.h"
 #include "trace.h"
+#include "trace_buffer.h"
 #include "queue.h"
 #include "uart.h"
 #include "uart_protocol.h"
@@ -47,6 +53,7 @@
 
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
 static uart_t uart;
 static uart_protocol_t uart_protocol;
@@ -55,6 +62,54 @@ static cpx_t cpx;
 static streamer_t streamer;
 static pi_device_t cluster;
 
+#if defined(CLOCK_SYNC) && !defined(TRACE_STREAM)
+#error "CLOCK_SYNC requires TRACE_STREAM"
+#endif
+
+#ifdef CLOCK_SYNC
+static clock_sync_t clock_sync;
+#endif
+
+#if defined(TOF_FUSION) && !defined(NETWORK_ONBOARD_INFERENCE)
+#error "TOF_FUSION requires NETWORK_ONBOARD_INFERENCE"
+#endif
+
+#if defined(TOF_FUSION_PROFILE) && defined(TRACE_STREAM)
+#error "TOF_FUSION_PROFILE is not compatible with TRACE_STREAM"
+#endif
+
+#ifdef TOF_FUSION
+static tof_fusion_t tof_fusion;
+#endif
+
+#if defined(INFERENCE_FILTER) && !defined(NETWORK_ONBOARD_INFERENCE)
+#error "INFERENCE_FILTER requires NETWORK_ONBOARD_INFERENCE"
+#endif
+
+#ifdef INFERENCE_FILTER
+static inference_filter_t inference_filter;
+#endif
+
+#if defined(DVFS) && !defined(NETWORK_ONBOARD_INFERENCE)
+#error "DVFS requires NETWORK_ONBOARD_INFERENCE"
+#endif
+
+#ifdef DVFS
+static dvfs_t dvfs;
+static PI_L2 streamer_dvfs_t latest_dvfs = { .mode = STREAMER_DVFS_NONE };
+#endif
+
+#if defined(PIPELINE_STATS) && !defined(NETWORK_ONBOARD_INFERENCE)
+#error "PIPELINE_STATS requires NETWORK_ONBOARD_INFERENCE"
+#endif
+
+#ifdef CAMERA_PREPROCESS
+static preprocess_t preprocess;
+#ifdef CAMERA_PREPROCESS_GAMMA
+static uint8_t preprocess_lut[256];
+#endif
+#endif
+
 static PI_FC_L1 state_msg_t latest_state;
 static PI_FC_L1 uint32_t state_timestamp;
 
@@ -63,105 +118,440 @@ static PI_FC_L1 uint32_t tof_timestamp;
 
 static PI_L2 inference_stamped_msg_t latest_inference;
 
+#ifdef NETWORK_PROFILE
+static PI_L2 streamer_profile_t latest_profile = { .layer_id = STREAMER_PROFILE_NONE };
+#endif
+
 static void *l2_buffer;
 static size_t l2_buffer_size;
 
-typedef struct inference_args_s {
-    uint32_t stm32_timestamp;
+/*
+ * PIPELINE
+ *
+ * Each camera frame goes through the stages below, connected by queue_async_t so that each stage
+ * works on a different frame:
+ *   - capture and preprocess: the camera (see camera.h), which calls camera_callback
+ *   - infer: sends the frame to the cluster, queued behind the inference in progress
+ *   - postprocess: dequantizes the output, ToF fusion, inference filter and UART to the STM32
+ *   - stream: sends the frame to the host over CPX
+ * The camera buffer is returned to the camera once the network has consumed it and it has been
+ * streamed. Up to PIPELINE_INFERENCES_IN_FLIGHT inferences are in flight on the cluster, so that
+ * the next one starts as soon as the previous one ends, while the FC postprocesses its output.
+ */
+
+#if PIPELINE_INFERENCES_QUEUED > NETWORK_MAX_QUEUED
+#error "PIPELINE_INFERENCES_QUEUED must be at most NETWORK_MAX_QUEUED"
+#endif
+
+// DVFS changes the operating point between inferences, when the cluster is idle, so the next
+// inference is sent only after the previous one has been postprocessed
+#ifdef DVFS
+#define PIPELINE_INFERENCES_IN_FLIGHT   (1)
+#else
+#define PIPELINE_INFERENCES_IN_FLIGHT   (PIPELINE_INFERENCES_QUEUED)
+#endif
+
+// A camera frame in the pipeline, one per camera buffer
+typedef struct pipeline_frame_s {
     frame_t *camera_frame;
-    pi_task_t *frame_done;
-} inference_args_t;
+    uint32_t stm32_timestamp;
+
+    co_event_t input_consumed;
+    co_event_t streamed;
+} pipeline_frame_t;
+
+// An inference sent to the cluster, owned by the postprocess stage once it completes
+typedef struct pipeline_inference_s {
+    uint32_t stm32_timestamp;
+    uint32_t frame_timestamp;
+
+    co_event_t network_done;
+    NETWORK_OUTPUT_TYPE output[NETWORK_OUTPUT_COUNT];
+} pipeline_inference_t;
+
+static pipeline_frame_t pipeline_frames[CAMERA_BUFFERS];
+
+static queue_async_t infer_queue;           // pipeline_frame_t *, filled by camera_callback
+static queue_async_t stream_queue;          // pipeline_frame_t *, filled by camera_callback
+static queue_async_t postprocess_queue;     // pipeline_inference_t, filled by infer_stage
 
 static pi_device_t *ram;
 static void *test_input_l3;
 
-static PI_FC_L1 co_fn_ctx_t inference_ctx;
+static PI_FC_L1 co_fn_ctx_t infer_ctx;
+static PI_FC_L1 co_fn_ctx_t postprocess_ctx;
+static PI_FC_L1 co_fn_ctx_t stream_ctx;
 static PI_FC_L1 co_fn_ctx_t streamer_rx_ctx;
 
-CO_FN_DECLARE(inference_task);
+#ifdef PIPELINE_STATS
+#define PIPELINE_STATS_BIN_US   (1000)
+#define PIPELINE_STATS_BINS     (200)
+
+// Latency from the end of the capture to the inference sent over UART, in PIPELINE_STATS_BIN_US
+// bins, the last one also counts all the slower inferences
+typedef struct pipeline_stats_s {
+    uint32_t start;
+    int count;
+    uint32_t latency_min, latency_max;
+    uint64_t latency_sum;
+    uint16_t histogram[PIPELINE_STATS_BINS];
+} pipeline_stats_t;
+
+static pipeline_stats_t pipeline_stats;
+#endif
 
-CO_FN_BEGIN(camera_callback, frame_t *, camera_frame)
-{
-    static PI_FC_L1 bool camera_started = false;
-    static PI_FC_L1 inference_args_t inference_args;
-    static PI_FC_L1 co_event_t frame_done;
-    static PI_FC_L1 co_event_t inference_done;
-    static PI_FC_L1 co_event_t streamer_tx_done;
+#ifdef TOF_FUSION
+static void fuse_tof(float *network_output) {
+    tof_fusion_result_t result;
+
+#ifdef TOF_FUSION_PROFILE
+    pi_perf_conf(1 << PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+#endif
 
-    // Load static test image for debugging
-    // pi_ram_read_async(ram, (uint32_t)test_input_l3, camera_frame->buffer, NETWORK_INPUT_SIZE, co_event_init(&streamer_tx_done));
-    // CO_WAIT(&streamer_tx_done);
+    // network_output starts with the subject's position (x, y, z)
+    uint32_t age = time_get_us() - tof_timestamp;
+    tof_fusion_run(&tof_fusion, network_output, latest_tof.data, latest_tof.resolution, age, &result);
 
-    if (camera_started) {
-#ifdef NETWORK_ONBOARD_INFERENCE
-        // Wait until previous inference has completed before starting a new one
-        while (!co_event_is_done(&inference_done)) {
-            CO_WAIT(&inference_done);
-        }
+#ifdef TOF_FUSION_PROFILE
+    pi_perf_stop();
+    printf(
+        "tof fusion: %d cycles, status %d, %d zones, network %d mm, tof %d mm\n",
+        pi_perf_read(PI_PERF_CYCLES), result.status, result.n_zones,
+        (int)(1000.0f * result.network_depth), (int)(1000.0f * result.tof_depth)
+    );
+#endif
+}
 #endif
 
-        while (!co_event_is_done(&streamer_tx_done)) {
-            CO_WAIT(&streamer_tx_done);
-        }
+#ifdef INFERENCE_FILTER
+static void filter_inference(float *network_output, uint8_t *flags, uint8_t *confidence) {
+    inference_filter_result_t result;
+    inference_filter_run(&inference_filter, time_get_us(), network_output, &result);
+
+    if (result.filtered) {
+        *flags |= INFERENCE_FLAG_FILTERED;
+        *confidence = result.confidence;
     }
 
-    camera_started = true;
+    if (result.outlier) {
+        *flags |= INFERENCE_FLAG_OUTLIER;
+    }
 
-#ifdef NETWORK_ONBOARD_INFERENCE
-    inference_args = (inference_args_t){
-        .stm32_timestamp = latest_state.timestamp,
-        .camera_frame = camera_frame,
-        .frame_done = co_event_init(&frame_done)
+#ifdef INFERENCE_FILTER_VERBOSE
+    printf(
+        "inference filter: filtered %d, outlier %d, confidence %d, deviation %d/100, %d outliers in %d inferences\n",
+        result.filtered, result.outlier, result.confidence, (int)(100.0f * result.deviation),
+        inference_filter.n_outliers, inference_filter.n_filtered
+    );
+#endif
+}
+#endif
+
+#ifdef NETWORK_PROFILE
+_Static_assert(NETWORK_PROFILE_N_EVENTS == STREAMER_PROFILE_EVENTS, "streamer_profile_t does not match the network profile");
+
+// The profile is streamed one layer at a time, a different one after each inference
+static void update_profile(const network_t *network) {
+    const network_state_t *state = network->state;
+    const int layer_id = state->profile_runs % network->n_layers;
+    const network_layer_t *layer = &network->layers[layer_id];
+    const network_profile_layer_t *profile = &state->profile[layer_id];
+
+    latest_profile = (streamer_profile_t){
+        .layer_id = layer_id,
+        .n_layers = network->n_layers,
+        .n_cores = NUM_CORES,
+        .n_runs = state->profile_runs,
+
+        .macs = layer->macs,
+        .l2_bytes = layer->activations_size + layer->activations_out_size + layer->weights_size,
+        .l3_bytes = layer->L2_weights ? 0 : layer->weights_size,
+
+        .cycles = profile->cycles,
+        .dma_wait_cycles = profile->dma_wait_cycles,
+        .l3_cycles = profile->l3_cycles,
+        .events_valid = profile->events_valid,
     };
-    co_fn_push_start(&inference_ctx, inference_task, &inference_args, co_event_init(&inference_done));
+    memcpy(latest_profile.events, profile->events, sizeof(latest_profile.events));
+}
+#endif
+
+#ifdef DVFS
+// The cluster time of the inference that just ended sets the operating point of the next ones.
+// The cluster is idle here, so the whole inference ran at the current frequency.
+static void update_dvfs() {
+    uint32_t freq_cl = pi_freq_get(PI_FREQ_DOMAIN_CL);
+    uint32_t busy = (uint64_t)network_frontnet.state->cycles * 1000000 / freq_cl;
+
+    if (dvfs_update(&dvfs, busy)) {
+        const dvfs_point_t *point = dvfs_get_point(&dvfs);
+        if (soc_set_operating_point(dvfs_get_voltage(&dvfs), point->freq_cl)) {
+            printf("DVFS: cannot set CL %lu MHz at %d mV\n", point->freq_cl / 1000000, dvfs_get_voltage(&dvfs));
+        }
+
+#ifdef DVFS_VERBOSE
+        printf(
+            "DVFS: inference %d us of %d us, CL %lu MHz at %d mV, %d changes, %d misses\n",
+            busy, dvfs.config.period, pi_freq_get(PI_FREQ_DOMAIN_CL) / 1000000, soc_get_voltage(),
+            dvfs.n_changes, dvfs.n_misses
+        );
+#endif
+    }
+
+    // The actual operating point, in case it could not be set
+    latest_dvfs = (streamer_dvfs_t){
+        .mode = dvfs.config.mode,
+        .level = dvfs.level,
+        .voltage = soc_get_voltage(),
+        .freq_fc = pi_freq_get(PI_FREQ_DOMAIN_FC) / 1000000,
+        .freq_cl = pi_freq_get(PI_FREQ_DOMAIN_CL) / 1000000,
+        .period = dvfs.config.period,
+        .busy = busy,
+        .n_misses = dvfs.n_misses,
+    };
+}
 #endif
 
-    streamer_send_frame_async(
-        &streamer,
-        camera_frame,
-        &latest_state, state_timestamp,
-        &latest_tof, tof_timestamp,
-        &latest_inference,
-        co_event_init(&streamer_tx_done)
+#ifdef PIPELINE_STATS
+static uint32_t pipeline_stats_percentile(const pipeline_stats_t *stats, int percentile) {
+    int rank = (stats->count * percentile + 99) / 100;
+    int count = 0;
+
+    for (int i = 0; i < PIPELINE_STATS_BINS; i++) {
+        count += stats->histogram[i];
+        if (count >= rank) {
+            return (i + 1) * PIPELINE_STATS_BIN_US;
+        }
+    }
+
+    return PIPELINE_STATS_BINS * PIPELINE_STATS_BIN_US;
+}
+
+static void pipeline_stats_add(pipeline_stats_t *stats, uint32_t latency) {
+    uint32_t now = time_get_us();
+
+    if (stats->count == 0) {
+        memset(stats, 0, sizeof(*stats));
+        stats->start = now;
+        stats->latency_min = UINT32_MAX;
+    }
+
+    stats->count++;
+    stats->latency_min = MIN(stats->latency_min, latency);
+    stats->latency_max = MAX(stats->latency_max, latency);
+    stats->latency_sum += latency;
+    stats->histogram[MIN(latency / PIPELINE_STATS_BIN_US, PIPELINE_STATS_BINS - 1)]++;
+
+    if (stats->count < PIPELINE_STATS) {
+        return;
+    }
+
+    // Percentiles are the upper edge of their bin
+    uint32_t fps_x100 = (uint64_t)(stats->count - 1) * 100000000 / (now - stats->start);
+    printf(
+        "pipeline: %d inferences at %d.%02d fps, latency avg %d us, min %d us, p50 %d us, p90 %d us, p99 %d us, max %d us\n",
+        stats->count, fps_x100 / 100, fps_x100 % 100,
+        (uint32_t)(stats->latency_sum / stats->count), stats->latency_min,
+        pipeline_stats_percentile(stats, 50), pipeline_stats_percentile(stats, 90),
+        pipeline_stats_percentile(stats, 99), stats->latency_max
     );
-    CO_WAIT(&streamer_tx_done);
+    stats->count = 0;
+}
+#endif
+
+static void pipeline_push(queue_async_t *queue, pipeline_frame_t *frame) {
+    pipeline_frame_t **el;
+
+    // Each queue holds at most one entry per camera buffer, it is never full
+    queue_async_push_acquire(queue, (void **)&el, NULL);
+    if (el == NULL) {
+        CO_ASSERTION_FAILURE("Pipeline queue full\n");
+    }
+
+    *el = frame;
+    queue_async_push_commit(queue, el);
+}
+
+// Capture stage: the frame is already captured and preprocessed by the camera, hand it to the
+// other stages and hold the camera buffer until they are done with it. Runs once per camera
+// buffer at the same time, so it keeps its state in pipeline_frames instead of statics.
+CO_FN_BEGIN(camera_callback, frame_t *, camera_frame)
+{
+    pipeline_frame_t *frame = &pipeline_frames[camera_get_buffer_id(&camera, camera_frame)];
+
+    frame->camera_frame = camera_frame;
+    frame->stm32_timestamp = latest_state.timestamp;
+    co_event_init(&frame->input_consumed);
+    co_event_init(&frame->streamed);
 
 #ifdef NETWORK_ONBOARD_INFERENCE
-    CO_WAIT(&frame_done);
+    pipeline_push(&infer_queue, frame);
+#else
+    co_event_push(&frame->input_consumed);
 #endif
+    pipeline_push(&stream_queue, frame);
+
+    CO_WAIT(&pipeline_frames[camera_get_buffer_id(&camera, camera_frame)].input_consumed);
+    CO_WAIT(&pipeline_frames[camera_get_buffer_id(&camera, camera_frame)].streamed);
+}
+CO_FN_END()
+
+// Infer stage: sends each frame to the cluster as soon as a slot in the postprocess queue is
+// free, i.e. while the previous inference may still be running
+CO_FN_BEGIN(infer_stage, void *, arg)
+{
+    static PI_FC_L1 pipeline_frame_t *const *el;
+    static PI_FC_L1 pipeline_frame_t *frame;
+    static PI_FC_L1 pipeline_inference_t *inference;
+    static PI_FC_L1 co_event_t done;
+
+    while (true) {
+        queue_async_pop_consume(&infer_queue, (const void **)&el, co_event_init(&done));
+        CO_WAIT(&done);
+        frame = *el;
+        queue_async_pop_release(&infer_queue, el);
+
+        queue_async_push_acquire(&postprocess_queue, (void **)&inference, co_event_init(&done));
+        CO_WAIT(&done);
+
+        // Load static test image for debugging
+        // pi_ram_read_async(ram, (uint32_t)test_input_l3, frame->camera_frame->buffer, NETWORK_INPUT_SIZE, co_event_init(&done));
+        // CO_WAIT(&done);
+
+        inference->stm32_timestamp = frame->stm32_timestamp;
+        inference->frame_timestamp = frame->camera_frame->frame_timestamp;
+
+        // The output is outside l2_buffer, which is reused by the next inference already queued
+        trace_set(TRACE_USER_0, true);
+        network_run_async(
+            &network_frontnet, frame->camera_frame->buffer, inference->output, l2_buffer, l2_buffer_size, &cluster,
+            &frame->input_consumed.done_task, co_event_init(&inference->network_done)
+        );
+        queue_async_push_commit(&postprocess_queue, inference);
+    }
 }
 CO_FN_END()
 
-CO_FN_BEGIN(inference_task, inference_args_t *, inference_args)
+// Postprocess stage: waits for each inference in order and sends its output to the STM32
+CO_FN_BEGIN(postprocess_stage, void *, arg)
 {
-    static PI_FC_L1 frame_t *camera_frame;
-    static PI_FC_L1 pi_task_t *frame_done;
-    static PI_FC_L1 co_event_t network_done;
+    static PI_FC_L1 pipeline_inference_t *inference;
+    static PI_FC_L1 co_event_t done;
     static PI_FC_L1 float network_output[NETWORK_OUTPUT_COUNT];
+    static PI_FC_L1 bool first_inference = true;
 
-    camera_frame = inference_args->camera_frame;
-    frame_done = inference_args->frame_done;
+    while (true) {
+        queue_async_pop_consume(&postprocess_queue, (const void **)&inference, co_event_init(&done));
+        CO_WAIT(&done);
 
-    trace_set(TRACE_USER_0, true);
-    network_run_async(camera_frame->buffer, l2_buffer, l2_buffer, l2_buffer_size, 0, &cluster, frame_done, co_event_init(&network_done));
-    CO_WAIT(&network_done);
-    
-    network_dequantize_output(l2_buffer, network_output);
-    trace_set(TRACE_USER_0, false);
-
-    latest_inference = (inference_stamped_msg_t) {
-        .stm32_timestamp = inference_args->stm32_timestamp,
-        .x = network_output[0],
-        .y = network_output[1],
-        .z = network_output[2],
-        .phi = network_output[3],
-    };
+        CO_WAIT(&inference->network_done);
+        if (queue_async_get_count(&postprocess_queue) == 0) {
+            trace_set(TRACE_USER_0, false);
+        }
+#ifdef DVFS
+        update_dvfs();
+#endif
+
+        if (first_inference) {
+            VERBOSE_PRINT("First inference:\t\t%d us after boot\n", time_get_us());
+            first_inference = false;
+        }
+
+        network_dequantize_output(&network_frontnet, inference->output, network_output);
+#ifdef NETWORK_PROFILE
+        // May already include some layers of the next inference, if queued
+        update_profile(&network_frontnet);
+#endif
+#ifdef TOF_FUSION
+        fuse_tof(network_output);
+#endif
+
+        uint8_t flags = 0;
+        uint8_t confidence = 0;
+#ifdef INFERENCE_FILTER
+        filter_inference(network_output, &flags, &confidence);
+#endif
+
+        latest_inference = (inference_stamped_msg_t) {
+            .stm32_timestamp = inference->stm32_timestamp,
+            .x = network_output[0],
+            .y = network_output[1],
+            .z = network_output[2],
+            .phi = network_output[3],
+            .flags = flags,
+            .confidence = confidence,
+        };
+
+        uart_protocol_send_inference_async(&uart_protocol, &latest_inference, co_event_init(&done));
+        CO_WAIT(&done);
+
+#ifdef PIPELINE_STATS
+        pipeline_stats_add(&pipeline_stats, time_get_us() - inference->frame_timestamp);
+#endif
+
+        queue_async_pop_release(&postprocess_queue, inference);
+    }
+}
+CO_FN_END()
+
+// Stream stage: sends the frames to the host in order, with the latest inference
+CO_FN_BEGIN(stream_stage, void *, arg)
+{
+    static PI_FC_L1 pipeline_frame_t *const *el;
+    static PI_FC_L1 pipeline_frame_t *frame;
+    static PI_FC_L1 co_event_t done;
+
+    while (true) {
+        queue_async_pop_consume(&stream_queue, (const void **)&el, co_event_init(&done));
+        CO_WAIT(&done);
+        frame = *el;
+        queue_async_pop_release(&stream_queue, el);
+
+        streamer_send_frame_async(
+            &streamer,
+            frame->camera_frame,
+            &latest_state, state_timestamp,
+            &latest_tof, tof_timestamp,
+            &latest_inference,
+#ifdef NETWORK_PROFILE
+            &latest_profile,
+#else
+            NULL,
+#endif
+#ifdef DVFS
+            &latest_dvfs,
+#else
+            NULL,
+#endif
+            co_event_init(&done)
+        );
+        CO_WAIT(&done);
 
-    uart_protocol_send_inference_async(&uart_protocol, &latest_inference, co_event_init(&network_done));
-    CO_WAIT(&network_done);
+        co_event_push(&frame->streamed);
+    }
 }
 CO_FN_END()
 
+static void pipeline_init() {
+    queue_async_init(&stream_queue, CAMERA_BUFFERS, sizeof(pipeline_frame_t *));
+
+#ifdef NETWORK_ONBOARD_INFERENCE
+    queue_async_init(&infer_queue, CAMERA_BUFFERS, sizeof(pipeline_frame_t *));
+    queue_async_init(&postprocess_queue, PIPELINE_INFERENCES_IN_FLIGHT, sizeof(pipeline_inference_t));
+#endif
+}
+
+static void pipeline_start() {
+    co_fn_push_start(&stream_ctx, stream_stage, NULL, NULL);
+
+#ifdef NETWORK_ONBOARD_INFERENCE
+    co_fn_push_start(&infer_ctx, infer_stage, NULL, NULL);
+    co_fn_push_start(&postprocess_ctx, postprocess_stage, NULL, NULL);
+#endif
+}
+
 CO_FN_DECLARE(streamer_rx_task);
 
 static void streamer_rx_start() {
@@ -206,6 +596,10 @@ CO_FN_BEGIN(uart_callback, uart_msg_t *, message)
     } else if (memcmp(message->header, UART_TOF_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
         latest_tof = message->tof;
         tof_timestamp = message->recv_timestamp;
+#ifdef CLOCK_SYNC
+    } else if (memcmp(message->header, UART_CLOCK_PONG_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+        clock_sync_uart_pong_received(&clock_sync, message);
+#endif
     }
 }
 CO_FN_END()
@@ -223,11 +617,40 @@ static void main_task(void) {
     streamer_init(&streamer, &camera, &cpx);
     streamer_alloc_frames(&streamer, &camera);
 
+#ifdef CLOCK_SYNC
+    clock_sync_init(&clock_sync, &uart_protocol, &cpx);
+#endif
+
     cluster_init(&cluster);
 
+#ifdef CAMERA_PREPROCESS
+#ifdef CAMERA_PREPROCESS_GAMMA
+    preprocess_lut_gamma(preprocess_lut, CAMERA_PREPROCESS_GAMMA);
+#endif
+
+    preprocess_init(&preprocess, &cluster, &(preprocess_config_t){
+        .src_width = CAMERA_CAPTURE_WIDTH,
+        .src_height = CAMERA_CAPTURE_HEIGHT,
+        .crop_left = CAMERA_CROP_LEFT,
+        .crop_top = CAMERA_CROP_TOP,
+        .crop_width = CAMERA_CROP_WIDTH,
+        .crop_height = CAMERA_CROP_HEIGHT,
+        .dst_width = CAMERA_PREPROCESS_WIDTH,
+        .dst_height = CAMERA_PREPROCESS_HEIGHT,
+        .resize = CAMERA_PREPROCESS_RESIZE,
+#ifdef CAMERA_PREPROCESS_GAMMA
+        .lut = preprocess_lut,
+#endif
+    });
+    camera_set_preprocess(&camera, &preprocess);
+#endif
+
 #ifdef NETWORK_ONBOARD_INFERENCE
     mem_init();
-    network_init();
+
+    uint32_t load_start = time_get_us();
+    network_init(&network_frontnet);
+    VERBOSE_PRINT("Network weights:\t\t%dB in %d us\n", network_frontnet.L3_weights_size, time_get_us() - load_start);
     
     memory_dump(&cluster);
 
@@ -235,6 +658,48 @@ static void main_task(void) {
     test_input_l3 = ram_malloc(NETWORK_INPUT_SIZE);
     load_file_to_ram(test_input_l3, "inputs.hex");
 
+#ifdef TOF_FUSION
+    tof_fusion_init(&tof_fusion, &(tof_fusion_config_t){
+        .body_to_camera = TOF_FUSION_BODY_TO_CAMERA,
+        .tof_to_camera = TOF_FUSION_TOF_TO_CAMERA,
+        .tof_fov = TOF_FUSION_FOV,
+        .subject_width = TOF_FUSION_SUBJECT_WIDTH,
+        .subject_height = TOF_FUSION_SUBJECT_HEIGHT,
+        .foreground_depth = TOF_FUSION_FOREGROUND,
+        .max_deviation = TOF_FUSION_MAX_DEVIATION,
+        .weight = TOF_FUSION_WEIGHT,
+        .min_zones = TOF_FUSION_MIN_ZONES,
+        .max_age = TOF_FUSION_MAX_AGE,
+    });
+#endif
+
+#ifdef INFERENCE_FILTER
+    inference_filter_init(&inference_filter, &(inference_filter_config_t){
+        .mode = INFERENCE_FILTER_MODE,
+        .window = INFERENCE_FILTER_WINDOW,
+        .threshold = INFERENCE_FILTER_THRESHOLD,
+        .min_scale = INFERENCE_FILTER_MIN_SCALE,
+        .max_gap = INFERENCE_FILTER_MAX_GAP,
+    });
+#endif
+
+#ifdef DVFS
+    static const dvfs_point_t dvfs_points[] = DVFS_POINTS;
+    dvfs_config_t dvfs_config = {
+        .mode = DVFS_MODE,
+        .n_points = sizeof(dvfs_points) / sizeof(dvfs_points[0]),
+        .min_voltage = DVFS_FC_VOLTAGE,
+        .period = 1000000 / HIMAX_FRAME_RATE,
+        .target = DVFS_TARGET,
+        .hysteresis = DVFS_HYSTERESIS,
+        .down_frames = DVFS_DOWN_FRAMES,
+        .window = DVFS_WINDOW,
+        .margin = DVFS_MARGIN,
+    };
+    memcpy(dvfs_config.points, dvfs_points, sizeof(dvfs_points));
+    dvfs_init(&dvfs, &dvfs_config);
+#endif
+
     l2_buffer_size = NETWORK_L2_BUFFER_SIZE;
     l2_buffer = pi_l2_malloc(l2_buffer_size);
     VERBOSE_PRINT("Network:\t\t\t%s, %dB @ L2, 0x%08x\n", l2_buffer?"OK":"Failed", l2_buffer_size, l2_buffer);
@@ -243,18 +708,35 @@ static void main_task(void) {
     }
 #endif
 
+    pipeline_init();
+
     memory_dump(&cluster);
 
     // Needs to be done last when using UART TX as a trace GPIO, to override
     // the UART configuration which happens somewhere in the SDK.
     trace_init();
 
+#ifdef TRACE_STREAM
+    trace_buffer_init(pi_core_id(), NULL);
+    trace_buffer_start();
+#endif
+
     VERBOSE_PRINT("\n\t *** Initialization done ***\n\n");
 
+    pipeline_start();
+
     uart_protocol_start(&uart_protocol);
     camera_start(&camera);
     cpx_start(&cpx);
 
+#ifdef TRACE_STREAM
+    trace_buffer_stream_start(&cpx);
+#endif
+
+#ifdef CLOCK_SYNC
+    clock_sync_start(&clock_sync);
+#endif
+
     streamer_rx_start();
 
     while (true) {
@@ -0,0 +1,46 @@
+/*
+ * config.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+/************************** GENERAL SETTINGS **************************/
+#define VERBOSE
+
+/************************ BENCHMARK SETTINGS **************************/
+
+// Shape of the tiles, sized to fit the cluster L1 together with the baseline buffers
+#define KERNELS_BENCH_DIM         (16)
+#define KERNELS_BENCH_CH_IN       (32)
+#define KERNELS_BENCH_CH_OUT      (32)
+
+// Each kernel is run a few times and the fastest run is reported
+#define KERNELS_BENCH_RUNS        (4)
+
+/**************************** SOC SETTINGS ****************************/
+#define SOC_VOLTAGE                 (1200)
+#define SOC_FREQ_FC                 (246000000)
+#define SOC_FREQ_CL                 (175000000)
+
+#endif /* __CONFIG_H__ */
@@ -0,0 +1,286 @@
+/*
+ * main.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "config.h"
+#include "cluster.h"
+#include "soc.h"
+#include "utils.h"
+
+#include "pulp_nn_kernels.h"
+
+#include <pmsis.h>
+
+#include <string.h>
+
+// Cycles per MAC of the im2col-free PULP-NN kernels against the generic pulp_nn_conv_u8_u8_i8 on
+// the same tile: the pointwise kernel against the generic kernel with a 1x1 kernel, the depthwise
+// kernel against the generic kernel run on each channel in turn (the only way it can compute a
+// depthwise convolution, the extraction of the channels is not counted). The outputs are checked
+// for bit-exactness. Run on GVSOC for cycle-accurate, repeatable results.
+
+#define DIM     (KERNELS_BENCH_DIM)
+#define CH_IN   (KERNELS_BENCH_CH_IN)
+#define CH_OUT  (KERNELS_BENCH_CH_OUT)
+
+#define ACTIVATIONS_SIZE (DIM * DIM * (CH_IN > CH_OUT ? CH_IN : CH_OUT))
+#define WEIGHTS_SIZE     (CH_IN * CH_OUT)
+#define IM2COL_SIZE      (2 * NUM_CORES * CH_IN * 9)
+
+typedef enum {
+    KERNEL_GENERIC,
+    KERNEL_POINTWISE,
+    KERNEL_DEPTHWISE,
+} kernel_e;
+
+typedef struct conv_args_s {
+    kernel_e kernel;
+
+    uint8_t *in;
+    uint8_t *im2col;
+    uint8_t *out;
+    int8_t *weights;
+    int64_t *kappa;
+    int64_t *lambda;
+
+    uint16_t dim_in, ch_in;
+    uint16_t dim_out, ch_out;
+    uint16_t dim_kernel, padding, stride;
+} conv_args_t;
+
+typedef struct buffers_s {
+    uint8_t *input;
+    uint8_t *output;
+    uint8_t *output_ref;
+    uint8_t *plane_in;
+    uint8_t *plane_out;
+    uint8_t *im2col;
+    int8_t *weights;
+    int64_t *kappa;
+    int64_t *lambda;
+} buffers_t;
+
+static pi_device_t cluster;
+static struct pi_cluster_task cluster_task;
+static int mismatches = 0;
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng() {
+    rng_state = rng_state * 1664525 + 1013904223;
+    return rng_state >> 8;
+}
+
+// BN + ReLU quantization with the same out_shift as the layers of Frontnet
+static void conv_entry(void *arg) {
+    conv_args_t *a = (conv_args_t *)arg;
+    uint16_t pad = a->padding;
+
+    switch (a->kernel) {
+        case KERNEL_GENERIC:
+            pulp_nn_conv_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, a->kappa, a->lambda, 1, 24,
+                a->dim_in, a->dim_in, a->ch_in, a->dim_out, a->dim_out, a->ch_out, a->dim_kernel, a->dim_kernel,
+                pad, pad, pad, pad, a->stride, a->stride, 1, 1
+            );
+            break;
+
+        case KERNEL_POINTWISE:
+            pulp_nn_pointwise_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, a->kappa, a->lambda, 1, 24,
+                a->dim_in, a->dim_in, a->ch_in, a->dim_out, a->dim_out, a->ch_out, a->dim_kernel, a->dim_kernel,
+                pad, pad, pad, pad, a->stride, a->stride, 1, 1
+            );
+            break;
+
+        case KERNEL_DEPTHWISE:
+            pulp_nn_depthwise_u8_u8_i8(
+                a->in, a->im2col, NULL, a->out, a->weights, NULL, a->kappa, a->lambda, 1, 24,
+                a->dim_in, a->dim_in, a->ch_in, a->dim_out, a->dim_out, a->ch_out, a->dim_kernel, a->dim_kernel,
+                pad, pad, pad, pad, a->stride, a->stride, 1, 1
+            );
+            break;
+    }
+}
+
+static uint32_t run_conv(conv_args_t *args) {
+    pi_perf_conf(1<<PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+    pi_cl_team_fork(NUM_CORES, conv_entry, args);
+    pi_perf_stop();
+
+    return pi_perf_read(PI_PERF_CYCLES);
+}
+
+static void print_result(const char *name, uint32_t macs, uint32_t cycles_ref, uint32_t cycles, int ok) {
+    printf(
+        "%-24s %7d MACs: generic %7d cyc (%.3f cyc/MAC), fast %7d cyc (%.3f cyc/MAC), %.2fx %s\n",
+        name, macs, cycles_ref, (float)cycles_ref / macs, cycles, (float)cycles / macs,
+        (float)cycles_ref / cycles, ok ? "OK" : "MISMATCH"
+    );
+}
+
+static void bench_pointwise(buffers_t *b) {
+    conv_args_t args = {
+        .in = b->input, .im2col = b->im2col, .weights = b->weights, .kappa = b->kappa, .lambda = b->lambda,
+        .dim_in = DIM, .ch_in = CH_IN, .dim_out = DIM, .ch_out = CH_OUT,
+        .dim_kernel = 1, .padding = 0, .stride = 1,
+    };
+    uint32_t cycles_ref = UINT32_MAX, cycles = UINT32_MAX;
+
+    for (int run = 0; run < KERNELS_BENCH_RUNS; run++) {
+        args.kernel = KERNEL_GENERIC;
+        args.out = b->output_ref;
+        cycles_ref = MIN(cycles_ref, run_conv(&args));
+
+        args.kernel = KERNEL_POINTWISE;
+        args.out = b->output;
+        cycles = MIN(cycles, run_conv(&args));
+    }
+
+    int output_size = DIM * DIM * CH_OUT;
+    int ok = memcmp(b->output, b->output_ref, output_size) == 0;
+    mismatches += !ok;
+
+    print_result("pointwise 1x1", DIM * DIM * CH_IN * CH_OUT, cycles_ref, cycles, ok);
+}
+
+static void bench_depthwise(buffers_t *b, uint16_t stride) {
+    uint16_t dim_out = (DIM + 2 - 3) / stride + 1;
+    conv_args_t args = {
+        .in = b->input, .im2col = b->im2col, .weights = b->weights, .kappa = b->kappa, .lambda = b->lambda,
+        .dim_in = DIM, .ch_in = CH_IN, .dim_out = dim_out, .ch_out = CH_IN,
+        .dim_kernel = 3, .padding = 1, .stride = stride,
+    };
+    conv_args_t plane = args;
+    plane.in = b->plane_in;
+    plane.out = b->plane_out;
+    plane.ch_in = 1;
+    plane.ch_out = 1;
+    plane.kernel = KERNEL_GENERIC;
+
+    uint32_t cycles_ref = UINT32_MAX, cycles = UINT32_MAX;
+
+    for (int run = 0; run < KERNELS_BENCH_RUNS; run++) {
+        uint32_t run_cycles = 0;
+        for (int c = 0; c < CH_IN; c++) {
+            for (int p = 0; p < DIM * DIM; p++) {
+                b->plane_in[p] = b->input[p * CH_IN + c];
+            }
+            plane.weights = b->weights + c * 9;
+            plane.kappa = b->kappa + c;
+            plane.lambda = b->lambda + c;
+
+            run_cycles += run_conv(&plane);
+
+            for (int p = 0; p < dim_out * dim_out; p++) {
+                b->output_ref[p * CH_IN + c] = b->plane_out[p];
+            }
+        }
+        cycles_ref = MIN(cycles_ref, run_cycles);
+
+        args.kernel = KERNEL_DEPTHWISE;
+        args.out = b->output;
+        cycles = MIN(cycles, run_conv(&args));
+    }
+
+    int output_size = dim_out * dim_out * CH_IN;
+    int ok = memcmp(b->output, b->output_ref, output_size) == 0;
+    mismatches += !ok;
+
+    print_result(stride == 1 ? "depthwise 3x3 stride 1" : "depthwise 3x3 stride 2", dim_out * dim_out * CH_IN * 9, cycles_ref, cycles, ok);
+}
+
+static void *l1_alloc(size_t size) {
+    void *ptr = pmsis_l1_malloc(size);
+    if (!ptr) {
+        printf("L1 allocation of %dB failed\n", size);
+    }
+    return ptr;
+}
+
+static void cluster_main(void *arg) {
+    buffers_t b = {
+        .input = l1_alloc(ACTIVATIONS_SIZE),
+        .output = l1_alloc(ACTIVATIONS_SIZE),
+        .output_ref = l1_alloc(ACTIVATIONS_SIZE),
+        .plane_in = l1_alloc(DIM * DIM),
+        .plane_out = l1_alloc(DIM * DIM),
+        .im2col = l1_alloc(IM2COL_SIZE),
+        .weights = l1_alloc(WEIGHTS_SIZE),
+        .kappa = l1_alloc(CH_OUT * sizeof(int64_t)),
+        .lambda = l1_alloc(CH_OUT * sizeof(int64_t)),
+    };
+
+    if (!b.input || !b.output || !b.output_ref || !b.plane_in || !b.plane_out || !b.im2col
+        || !b.weights || !b.kappa || !b.lambda) {
+        mismatches++;
+        return;
+    }
+
+    for (int i = 0; i < ACTIVATIONS_SIZE; i++) {
+        b.input[i] = rng() & 0xff;
+    }
+    for (int i = 0; i < WEIGHTS_SIZE; i++) {
+        b.weights[i] = rng() & 0xff;
+    }
+    // Keep the outputs in range for 1x1 and 3x3 depthwise sums with out_shift 24
+    for (int i = 0; i < CH_OUT; i++) {
+        b.kappa[i] = 16384 + (rng() & 0x7fff);
+        b.lambda[i] = (int64_t)(rng() & 0xffff) << 14;
+    }
+
+    bench_pointwise(&b);
+    bench_depthwise(&b, 1);
+    bench_depthwise(&b, 2);
+
+    pmsis_l1_malloc_free(b.input, ACTIVATIONS_SIZE);
+    pmsis_l1_malloc_free(b.output, ACTIVATIONS_SIZE);
+    pmsis_l1_malloc_free(b.output_ref, ACTIVATIONS_SIZE);
+    pmsis_l1_malloc_free(b.plane_in, DIM * DIM);
+    pmsis_l1_malloc_free(b.plane_out, DIM * DIM);
+    pmsis_l1_malloc_free(b.im2col, IM2COL_SIZE);
+    pmsis_l1_malloc_free(b.weights, WEIGHTS_SIZE);
+    pmsis_l1_malloc_free(b.kappa, CH_OUT * sizeof(int64_t));
+    pmsis_l1_malloc_free(b.lambda, CH_OUT * sizeof(int64_t));
+}
+
+void main_task() {
+    soc_init();
+    cluster_init(&cluster);
+
+    printf("Tile %dx%d, %d input and %d output channels, %d cores\n\n", DIM, DIM, CH_IN, CH_OUT, NUM_CORES);
+
+    pi_cluster_task(&cluster_task, cluster_main, NULL);
+    pi_cluster_send_task_to_cl(&cluster, &cluster_task);
+
+    printf("\n%s\n", mismatches ? "MISMATCH" : "OK");
+
+    pmsis_exit(mismatches ? 1 : 0);
+}
+
+int main(void) {
+    printf("\n\n\t *** PMSIS Kickoff ***\n\n");
+    return pmsis_kickoff((void *)main_task);
+}
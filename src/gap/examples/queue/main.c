@@ -23,6 +23,7 @@
  */
 
 #include "config.h"
+#include "mpmc.h"
 #include "queue.h"
 
 #include <pmsis.h>
@@ -156,6 +157,8 @@ void main_task() {
     queue_pop_release(&q, d1);
     queue_pop_release(&q, e1);
 
+    mpmc_test();
+
     pmsis_exit(0);
 }
 
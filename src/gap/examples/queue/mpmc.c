@@ -0,0 +1,400 @@
+/*
+ * mpmc.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Stress tests and throughput benchmark of the MPMC queue (lib/queue_mpmc.c).
+ *
+ *  - Cluster to cluster: producer cores push MPMC_ITEMS items each to consumer cores, every
+ *    consumer checks that the items of each producer arrive in order and the FC checks that every
+ *    item has been popped exactly once. Reports the items per second of each configuration.
+ *  - FC to cluster and back: the FC pushes MPMC_ITEMS items to all cluster cores, which push back
+ *    a result for each one. Reports the items per second against a pi_cluster_send_task round
+ *    trip for each item, the pattern the queue replaces.
+ */
+
+#include "mpmc.h"
+
+#include "cluster.h"
+#include "config.h"
+#include "queue_mpmc.h"
+
+#include <pmsis.h>
+
+#define MPMC_CORES       (8)
+#define MPMC_CAPACITY    (8)
+#define MPMC_ITEMS       (2048)     // Per producer
+#define MPMC_SEND_ITEMS  (256)      // Baseline with a cluster task for each item
+
+#define MPMC_STOP        (0xFFFFFFFF)
+#define MPMC_ITEM(producer, seq) (((uint32_t)(producer) << 24) | (seq))
+
+typedef struct mpmc_config_s {
+    int n_producers;
+    int n_consumers;
+    bool buffer_l1;
+} mpmc_config_t;
+
+typedef struct mpmc_result_s {
+    uint32_t count[MPMC_CORES];     // Items popped from each producer
+    uint32_t sum[MPMC_CORES];       // Sum of their sequence numbers
+    uint32_t errors;                // Items out of order or from an unknown producer
+} mpmc_result_t;
+
+typedef struct mpmc_args_s {
+    queue_mpmc_t *q;
+    queue_mpmc_t *results;
+    int n_producers;
+    int n_consumers;
+    int n_done;                     // Producers done, protected by the team critical section
+    uint32_t cycles;                // Single core push and pop
+    mpmc_result_t result[MPMC_CORES];
+} mpmc_args_t;
+
+static PI_L2 mpmc_args_t mpmc_args;
+
+static void mpmc_producer(mpmc_args_t *args, int producer) {
+    for (uint32_t seq = 0; seq < MPMC_ITEMS; seq++) {
+        uint32_t item = MPMC_ITEM(producer, seq);
+        queue_mpmc_cl_push(args->q, &item);
+    }
+
+    // The last producer stops the consumers, once every item has been pushed
+    pi_cl_team_critical_enter();
+    bool last = ++args->n_done == args->n_producers;
+    pi_cl_team_critical_exit();
+
+    if (last) {
+        uint32_t stop = MPMC_STOP;
+        for (int i = 0; i < args->n_consumers; i++) {
+            queue_mpmc_cl_push(args->q, &stop);
+        }
+    }
+}
+
+static void mpmc_consumer(mpmc_args_t *args, int consumer) {
+    mpmc_result_t result = {0};
+    int32_t last[MPMC_CORES];
+    for (int i = 0; i < MPMC_CORES; i++) {
+        last[i] = -1;
+    }
+
+    while (true) {
+        uint32_t item;
+        queue_mpmc_cl_pop(args->q, &item);
+
+        if (item == MPMC_STOP) {
+            break;
+        }
+
+        int producer = item >> 24;
+        int32_t seq = item & 0xFFFFFF;
+        if (producer >= args->n_producers || seq <= last[producer]) {
+            result.errors++;
+            continue;
+        }
+
+        last[producer] = seq;
+        result.count[producer]++;
+        result.sum[producer] += seq;
+    }
+
+    args->result[consumer] = result;
+}
+
+static void mpmc_stress_core(void *arg) {
+    mpmc_args_t *args = (mpmc_args_t *)arg;
+    int core_id = pi_core_id();
+
+    if (core_id < args->n_producers) {
+        mpmc_producer(args, core_id);
+    } else if (core_id < args->n_producers + args->n_consumers) {
+        mpmc_consumer(args, core_id);
+    }
+}
+
+static void mpmc_stress_cluster(void *arg) {
+    mpmc_args_t *args = (mpmc_args_t *)arg;
+    pi_cl_team_fork(MPMC_CORES, mpmc_stress_core, args);
+}
+
+static void mpmc_test_cluster(pi_device_t *cluster, const mpmc_config_t *config) {
+    queue_mpmc_t q;
+    queue_mpmc_init(&q, cluster, MPMC_CAPACITY, sizeof(uint32_t), config->buffer_l1);
+
+    mpmc_args = (mpmc_args_t){
+        .q = &q,
+        .n_producers = config->n_producers,
+        .n_consumers = config->n_consumers,
+    };
+
+    struct pi_cluster_task task;
+    pi_cluster_task(&task, mpmc_stress_cluster, &mpmc_args);
+
+    uint32_t start = pi_time_get_us();
+    pi_cluster_send_task_to_cl(cluster, &task);
+    uint32_t elapsed = pi_time_get_us() - start;
+
+    uint32_t n_items = config->n_producers * MPMC_ITEMS;
+    uint32_t freq_cl = pi_freq_get(PI_FREQ_DOMAIN_CL) / 1000000;
+
+    for (int p = 0; p < config->n_producers; p++) {
+        uint32_t count = 0, sum = 0;
+        for (int c = config->n_producers; c < config->n_producers + config->n_consumers; c++) {
+            count += mpmc_args.result[c].count[p];
+            sum += mpmc_args.result[c].sum[p];
+        }
+
+        if (count != MPMC_ITEMS || sum != MPMC_ITEMS * (MPMC_ITEMS - 1) / 2) {
+            printf("producer %d: %lu items, sum %lu\n", p, count, sum);
+            pmsis_exit(20);
+        }
+    }
+
+    for (int c = config->n_producers; c < config->n_producers + config->n_consumers; c++) {
+        if (mpmc_args.result[c].errors) {
+            printf("consumer %d: %lu items out of order\n", c, mpmc_args.result[c].errors);
+            pmsis_exit(21);
+        }
+    }
+
+    if (queue_mpmc_get_count(&q) != 0) {
+        pmsis_exit(22);
+    }
+
+    printf(
+        "%dP/%dC %s: %lu items in %lu us, %lu items/s, %lu cycles/item\n",
+        config->n_producers, config->n_consumers, config->buffer_l1 ? "L1" : "L2",
+        n_items, elapsed, (uint32_t)((uint64_t)n_items * 1000000 / elapsed), elapsed * freq_cl / n_items
+    );
+
+    queue_mpmc_free(&q);
+}
+
+// Single core, uncontended: the cost of the lock, the copy and the wake up of each operation
+static void mpmc_single_cluster(void *arg) {
+    mpmc_args_t *args = (mpmc_args_t *)arg;
+
+    pi_perf_conf(1 << PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+
+    for (uint32_t i = 0; i < MPMC_ITEMS; i++) {
+        uint32_t item = i, popped;
+        queue_mpmc_try_push(args->q, &item);
+        queue_mpmc_try_pop(args->q, &popped);
+
+        if (popped != item) {
+            args->result[0].errors++;
+        }
+    }
+
+    pi_perf_stop();
+    args->cycles = pi_perf_read(PI_PERF_CYCLES);
+}
+
+static void mpmc_test_single(pi_device_t *cluster) {
+    queue_mpmc_t q;
+    queue_mpmc_init(&q, cluster, MPMC_CAPACITY, sizeof(uint32_t), true);
+
+    mpmc_args = (mpmc_args_t){ .q = &q };
+
+    struct pi_cluster_task task;
+    pi_cluster_task(&task, mpmc_single_cluster, &mpmc_args);
+    pi_cluster_send_task_to_cl(cluster, &task);
+
+    if (mpmc_args.result[0].errors) {
+        pmsis_exit(23);
+    }
+
+    printf("uncontended: %lu cycles per push and pop\n", mpmc_args.cycles / MPMC_ITEMS);
+
+    queue_mpmc_free(&q);
+}
+
+// FC to cluster and back: each cluster core pops items and pushes back 2 * item + 1
+static void mpmc_worker_core(void *arg) {
+    mpmc_args_t *args = (mpmc_args_t *)arg;
+
+    while (true) {
+        uint32_t item;
+        queue_mpmc_cl_pop(args->q, &item);
+
+        if (item == MPMC_STOP) {
+            break;
+        }
+
+        uint32_t result = 2 * item + 1;
+        queue_mpmc_cl_push(args->results, &result);
+    }
+}
+
+static void mpmc_worker_cluster(void *arg) {
+    mpmc_args_t *args = (mpmc_args_t *)arg;
+    pi_cl_team_fork(MPMC_CORES, mpmc_worker_core, args);
+}
+
+typedef struct mpmc_fc_s {
+    queue_mpmc_t *q;
+    queue_mpmc_t *results;
+
+    // Accessed by the cluster cores until the operation completes
+    uint32_t push_item;
+    uint32_t pop_item;
+
+    uint32_t n_pushed;
+    uint32_t n_popped;
+    uint32_t sum;
+
+    pi_task_t push_task;
+    pi_task_t pop_task;
+    pi_task_t *done_task;
+} mpmc_fc_t;
+
+static PI_L2 mpmc_fc_t mpmc_fc;
+
+static void mpmc_fc_push(void *arg) {
+    mpmc_fc_t *fc = (mpmc_fc_t *)arg;
+
+    if (fc->n_pushed == MPMC_ITEMS + MPMC_CORES) {
+        return;
+    }
+
+    // MPMC_ITEMS items, then a stop for each core
+    fc->push_item = fc->n_pushed < MPMC_ITEMS ? fc->n_pushed : MPMC_STOP;
+    fc->n_pushed++;
+    queue_mpmc_push_async(fc->q, &fc->push_item, pi_task_callback(&fc->push_task, mpmc_fc_push, fc));
+}
+
+static void mpmc_fc_pop(void *arg) {
+    mpmc_fc_t *fc = (mpmc_fc_t *)arg;
+
+    if (fc->n_popped > 0) {
+        fc->sum += fc->pop_item;
+    }
+
+    if (fc->n_popped == MPMC_ITEMS) {
+        pi_task_push(fc->done_task);
+        return;
+    }
+
+    fc->n_popped++;
+    queue_mpmc_pop_async(fc->results, &fc->pop_item, pi_task_callback(&fc->pop_task, mpmc_fc_pop, fc));
+}
+
+static void mpmc_test_fc(pi_device_t *cluster) {
+    queue_mpmc_t q, results;
+    queue_mpmc_init(&q, cluster, MPMC_CAPACITY, sizeof(uint32_t), true);
+    queue_mpmc_init(&results, cluster, MPMC_CAPACITY, sizeof(uint32_t), true);
+
+    mpmc_args = (mpmc_args_t){ .q = &q, .results = &results };
+
+    pi_task_t cluster_done, fc_done;
+    mpmc_fc = (mpmc_fc_t){ .q = &q, .results = &results, .done_task = pi_task_block(&fc_done) };
+
+    struct pi_cluster_task task;
+    pi_cluster_task(&task, mpmc_worker_cluster, &mpmc_args);
+
+    uint32_t start = pi_time_get_us();
+    pi_cluster_send_task_to_cl_async(cluster, &task, pi_task_block(&cluster_done));
+
+    mpmc_fc_push(&mpmc_fc);
+    mpmc_fc_pop(&mpmc_fc);
+
+    pi_task_wait_on(&cluster_done);
+    pi_task_wait_on(&fc_done);
+    uint32_t elapsed = pi_time_get_us() - start;
+
+    // Sum of 2 * i + 1 for i < MPMC_ITEMS
+    if (mpmc_fc.sum != MPMC_ITEMS * MPMC_ITEMS) {
+        printf("fc: sum %lu\n", mpmc_fc.sum);
+        pmsis_exit(24);
+    }
+
+    if (queue_mpmc_get_count(&q) != 0 || queue_mpmc_get_count(&results) != 0) {
+        pmsis_exit(25);
+    }
+
+    printf(
+        "fc -> %d cores -> fc: %d items in %lu us, %lu items/s\n",
+        MPMC_CORES, MPMC_ITEMS, elapsed, (uint32_t)((uint64_t)MPMC_ITEMS * 1000000 / elapsed)
+    );
+
+    queue_mpmc_free(&q);
+    queue_mpmc_free(&results);
+}
+
+static void mpmc_send_cluster(void *arg) {
+    uint32_t *item = (uint32_t *)arg;
+    *item = 2 * *item + 1;
+}
+
+// Baseline: a cluster task for each item, executed by the cluster controller alone
+static void mpmc_test_send_task(pi_device_t *cluster) {
+    static PI_L2 uint32_t item;
+    uint32_t sum = 0;
+
+    struct pi_cluster_task task;
+
+    uint32_t start = pi_time_get_us();
+    for (uint32_t i = 0; i < MPMC_SEND_ITEMS; i++) {
+        item = i;
+        pi_cluster_task(&task, mpmc_send_cluster, &item);
+        pi_cluster_send_task_to_cl(cluster, &task);
+        sum += item;
+    }
+    uint32_t elapsed = pi_time_get_us() - start;
+
+    if (sum != MPMC_SEND_ITEMS * MPMC_SEND_ITEMS) {
+        pmsis_exit(26);
+    }
+
+    printf(
+        "pi_cluster_send_task: %d items in %lu us, %lu items/s\n",
+        MPMC_SEND_ITEMS, elapsed, (uint32_t)((uint64_t)MPMC_SEND_ITEMS * 1000000 / elapsed)
+    );
+}
+
+void mpmc_test() {
+    static const mpmc_config_t configs[] = {
+        { .n_producers = 1, .n_consumers = 1, .buffer_l1 = true  },
+        { .n_producers = 4, .n_consumers = 4, .buffer_l1 = true  },
+        { .n_producers = 4, .n_consumers = 4, .buffer_l1 = false },
+        { .n_producers = 7, .n_consumers = 1, .buffer_l1 = true  },
+        { .n_producers = 1, .n_consumers = 7, .buffer_l1 = true  },
+    };
+
+    pi_device_t cluster;
+    cluster_init(&cluster);
+
+    mpmc_test_single(&cluster);
+
+    for (int i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        mpmc_test_cluster(&cluster, &configs[i]);
+    }
+
+    mpmc_test_fc(&cluster);
+    mpmc_test_send_task(&cluster);
+
+    pi_cluster_close(&cluster);
+}
@@ -0,0 +1,181 @@
+/*
+ * test_tof.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * Host test of the ToF delta coding: frames from tof_frames.txt are encoded by the STM32 encoder
+ * (tof_encoder.c in the Crazyflie firmware) and reconstructed by the GAP8 decoder (lib/tof_decoder.c).
+ * Checks that reconstruction is lossless with threshold 0 and within the threshold otherwise, that
+ * the decoder recovers from lost messages at the next keyframe, and reports the bytes sent per frame.
+ */
+
+#include "tof_decoder.h"
+#include "tof_encoder.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FRAMES 1024
+#define KEYFRAME_PERIOD 30
+
+// Bytes on the UART, including header and checksum (see tof_msg_t and tof_delta_msg_t)
+#define KEYFRAME_BYTES (4 + 4 + TOF_MAX_ZONES + 4)
+#define DELTA_BYTES(length) (4 + 3 + (length) + 4)
+
+typedef struct {
+    uint8_t resolution;
+    uint8_t data[TOF_MAX_ZONES];
+} frame_t;
+
+static frame_t frames[MAX_FRAMES];
+static int n_frames = 0;
+
+static int failures = 0;
+
+static void load_frames(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+
+    char line[1024];
+    while (fgets(line, sizeof(line), file) && n_frames < MAX_FRAMES) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        frame_t *frame = &frames[n_frames++];
+        char *cursor = line;
+        frame->resolution = strtoul(cursor, &cursor, 10);
+        for (int i = 0; i < frame->resolution; i++) {
+            frame->data[i] = strtoul(cursor, &cursor, 10);
+        }
+    }
+
+    fclose(file);
+}
+
+// Encode and decode a segment of frames with the same resolution, dropping message lost_index (-1: none)
+static void run_segment(int begin, int end, uint8_t threshold, int lost_index, int *bytes, int *keyframes) {
+    uint8_t resolution = frames[begin].resolution;
+
+    tofEncoder_t encoder;
+    tofEncoderInit(&encoder, resolution);
+
+    tof_decoder_t decoder;
+    tof_decoder_init(&decoder);
+
+    bool recovering = false;
+
+    for (int f = begin; f < end; f++) {
+        const frame_t *frame = &frames[f];
+
+        uint8_t sequence;
+        uint8_t payload[TOF_DELTA_MAX_PAYLOAD];
+        uint8_t length;
+        bool keyframe = tofEncoderEncode(&encoder, frame->data, threshold, KEYFRAME_PERIOD, &sequence, payload, &length);
+
+        *bytes += keyframe ? KEYFRAME_BYTES : DELTA_BYTES(length);
+        *keyframes += keyframe;
+
+        if (f == lost_index) {
+            recovering = true;
+            continue;
+        }
+
+        bool decoded;
+        if (keyframe) {
+            tof_decoder_keyframe(&decoder, resolution, sequence, frame->data);
+            decoded = true;
+            recovering = false;
+        } else {
+            decoded = tof_decoder_delta(&decoder, resolution, sequence, payload, length);
+        }
+
+        if (recovering) {
+            if (decoded) {
+                printf("FAIL frame %d: delta applied after a lost message\n", f);
+                failures++;
+            }
+            continue;
+        }
+
+        if (!decoded) {
+            printf("FAIL frame %d: delta dropped\n", f);
+            failures++;
+            continue;
+        }
+
+        for (int i = 0; i < resolution; i++) {
+            int error = abs(decoder.data[i] - frame->data[i]);
+            if (error > threshold || decoder.data[i] != encoder.reference[i]) {
+                printf("FAIL frame %d zone %d: decoded %d, expected %d (threshold %d)\n", f, i, decoder.data[i], frame->data[i], threshold);
+                failures++;
+                break;
+            }
+        }
+    }
+}
+
+static void run(uint8_t threshold, int lost_index) {
+    int begin = 0;
+    while (begin < n_frames) {
+        int end = begin;
+        while (end < n_frames && frames[end].resolution == frames[begin].resolution) {
+            end++;
+        }
+
+        int bytes = 0;
+        int keyframes = 0;
+        run_segment(begin, end, threshold, lost_index, &bytes, &keyframes);
+
+        if (lost_index < 0) {
+            int n = end - begin;
+            printf("%2d zones, threshold %d: %5.1f bytes/frame (%d full), %d/%d keyframes\n",
+                   frames[begin].resolution, threshold, (float)bytes / n, KEYFRAME_BYTES, keyframes, n);
+        }
+
+        begin = end;
+    }
+}
+
+int main(int argc, char **argv) {
+    load_frames(argc > 1 ? argv[1] : "tof_frames.txt");
+    if (n_frames == 0) {
+        printf("FAIL no frames loaded\n");
+        return 1;
+    }
+
+    for (uint8_t threshold = 0; threshold <= 2; threshold++) {
+        run(threshold, -1);
+    }
+
+    // Lose a delta in the middle of the 8x8 segment
+    run(0, KEYFRAME_PERIOD + 5);
+
+    printf("%d frames, %d failures\n", n_frames, failures);
+    return failures > 0 ? 1 : 0;
+}
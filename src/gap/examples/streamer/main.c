@@ -76,6 +76,8 @@ CO_FN_BEGIN(camera_callback, frame_t *, camera_frame)
         &latest_state, state_timestamp,
         &latest_tof, tof_timestamp,
         &latest_inference,
+        /* profile */ NULL,
+        /* dvfs */ NULL,
         co_event_init(&streamer_tx_done)
     );
     CO_WAIT(&streamer_tx_done);
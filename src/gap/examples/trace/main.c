@@ -0,0 +1,107 @@
+/*
+ * main.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2023-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "config.h"
+#include "cpx/cpx.h"
+#include "trace.h"
+#include "trace_buffer.h"
+
+#include <pmsis.h>
+
+// Measures the cost of recording a trace event and checks that it stays within
+// TRACE_EVENT_BUDGET_CYCLES. Run on GVSOC for cycle-accurate, repeatable results:
+// there, trace_stream_task recycles full buffers without sending them.
+
+#define TRACE_EVT_BENCH ((trace_evt_e)0x01)
+
+static cpx_t cpx;
+
+static uint32_t trace_bench_round() {
+    uint32_t start = pi_perf_read(TRACE_EVENTS_PERF_COUNTER);
+
+    for (int i = 0; i < TRACE_BENCH_EVENTS; i++) {
+        trace_event(TRACE_EVT_BENCH, TRACE_MARKER, i);
+    }
+
+    uint32_t end = pi_perf_read(TRACE_EVENTS_PERF_COUNTER);
+    return end - start;
+}
+
+void main_task() {
+    trace_init();
+
+#ifndef __PLATFORM_GVSOC__
+    cpx_init(&cpx);
+    cpx_start(&cpx);
+#endif
+
+    trace_buffer_init(pi_core_id(), NULL);
+    trace_buffer_start();
+
+#ifdef TRACE_STREAM
+    trace_buffer_stream_start(&cpx);
+#endif
+
+    uint32_t total_cycles = 0;
+    uint32_t max_cycles = 0;
+
+    for (int round = 0; round < TRACE_BENCH_ROUNDS; round++) {
+        uint32_t cycles = trace_bench_round();
+        total_cycles += cycles;
+        max_cycles = MAX(max_cycles, cycles);
+
+        // Let trace_stream_task flush the buffer filled in this round
+        pi_time_wait_us(2 * TRACE_STREAM_PERIOD_US);
+        trace_sync();
+    }
+
+    uint32_t n_events = TRACE_BENCH_ROUNDS * TRACE_BENCH_EVENTS;
+    uint32_t avg_cycles = total_cycles / n_events;
+    uint32_t worst_cycles = max_cycles / TRACE_BENCH_EVENTS;
+
+    printf(
+        "Trace overhead: %d cycles/event avg, %d cycles/event worst round, budget %d cycles/event\n",
+        avg_cycles, worst_cycles, TRACE_EVENT_BUDGET_CYCLES
+    );
+
+#ifdef TRACE_STREAM
+    uint32_t dropped = trace_buffers[pi_core_id()]->dropped;
+    printf("Trace events dropped: %d\n", dropped);
+
+    if (dropped != 0) {
+        pmsis_exit(2);
+    }
+#endif
+
+    if (avg_cycles > TRACE_EVENT_BUDGET_CYCLES) {
+        pmsis_exit(1);
+    }
+
+    pmsis_exit(0);
+}
+
+int main(void) {
+    printf("\n\n\t *** PMSIS Kickoff ***\n\n");
+    return pmsis_kickoff((void *)main_task);
+}
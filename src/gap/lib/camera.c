@@ -38,6 +38,7 @@
 CO_FN_DECLARE(camera_task);
 static void camera_crop_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task);
 CO_FN_DECLARE(camera_crop_task);
+static void camera_preprocess_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task);
 static void camera_consume_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task);
 
 static void camera_frame_init(camera_t *camera, frame_t *frame, uint8_t *buffer, size_t buffer_size, bool managed) {
@@ -92,6 +93,7 @@ void camera_init(camera_t *camera, co_fn_t consumer_callback) {
     );
 
     camera->consumer_callback = consumer_callback;
+    camera->preprocess = NULL;
 }
 
 void camera_init_frames_alloc(camera_t *camera) {
@@ -121,97 +123,110 @@ int camera_get_buffer_id(const camera_t *camera, const frame_t *frame) {
     return frame - camera->frames;
 }
 
+void camera_set_preprocess(camera_t *camera, preprocess_t *preprocess) {
+    const preprocess_config_t *config = &preprocess->config;
+
+    if (config->src_width != CAMERA_CAPTURE_WIDTH || config->src_height != CAMERA_CAPTURE_HEIGHT) {
+        CO_ASSERTION_FAILURE(
+            "Preprocess source size mismatch (got %dx%d but expected %dx%d).\n",
+            config->src_width, config->src_height, CAMERA_CAPTURE_WIDTH, CAMERA_CAPTURE_HEIGHT
+        );
+    }
+
+    camera->preprocess = preprocess;
+}
+
 void camera_start(camera_t *camera) {
-    co_fn_push_start(&camera->camera_ctx, camera_task, (void *)camera, NULL);
+    co_fn_push_start_with_frame(&camera->camera_ctx, camera_task, (void *)camera, NULL);
 }
 
-CO_FN_BEGIN(camera_task, camera_t *, camera)
+CO_FN_BEGIN_WITH_FRAME(camera_task, camera_t *, camera, camera_task_frame_t, locals)
 {
-    static int capture_idx, crop_idx, consume_idx;
-    static frame_t *frame;
-
-    capture_idx = 0;
-    crop_idx = 0;
-    consume_idx = 0;
+    locals->capture_idx = 0;
+    locals->crop_idx = 0;
+    locals->consume_idx = 0;
 
     while (true) {
         {
-            frame = &camera->frames[capture_idx % CAMERA_BUFFERS];
+            locals->frame = &camera->frames[locals->capture_idx % CAMERA_BUFFERS];
 
-            if (capture_idx >= CAMERA_BUFFERS) {
-                CO_WAIT(&frame->done_event);
+            if (locals->capture_idx >= CAMERA_BUFFERS) {
+                CO_WAIT(&locals->frame->done_event);
             }
 
-            himax_capture_async(&camera->himax, frame, co_event_init(&frame->done_event));
+            himax_capture_async(&camera->himax, locals->frame, co_event_init(&locals->frame->done_event));
             himax_start(&camera->himax);
-            trace_set((capture_idx % CAMERA_BUFFERS == 0) ? TRACE_CAMERA_BUF_0 : TRACE_CAMERA_BUF_1, true);
+            trace_set((locals->capture_idx % CAMERA_BUFFERS == 0) ? TRACE_CAMERA_BUF_0 : TRACE_CAMERA_BUF_1, true);
 
-            capture_idx += 1;
+            locals->capture_idx += 1;
         }
 
         {
-            frame = &camera->frames[crop_idx % CAMERA_BUFFERS];
+            locals->frame = &camera->frames[locals->crop_idx % CAMERA_BUFFERS];
 
-            CO_WAIT(&frame->done_event);
+            CO_WAIT(&locals->frame->done_event);
 
-            trace_set((crop_idx % CAMERA_BUFFERS == 0) ? TRACE_CAMERA_BUF_0 : TRACE_CAMERA_BUF_1, false);
+            trace_set((locals->crop_idx % CAMERA_BUFFERS == 0) ? TRACE_CAMERA_BUF_0 : TRACE_CAMERA_BUF_1, false);
             himax_stop(&camera->himax);
-            frame->frame_id = himax_get_frame_count(&camera->himax);
-            frame->frame_timestamp = time_get_us();
+            locals->frame->frame_id = himax_get_frame_count(&camera->himax);
+            locals->frame->frame_timestamp = time_get_us();
 
 #ifdef HIMAX_CONFIG_DUMP_ONCE
-            if (crop_idx == 0) {
+            if (locals->crop_idx == 0) {
                 VERBOSE_PRINT("HIMAX config after first frame\n");
                 himax_dump_config(&camera->himax);
             }
 #endif
 
-            camera_crop_frame_async(camera, frame, co_event_init(&frame->done_event));
+            if (camera->preprocess) {
+                camera_preprocess_frame_async(camera, locals->frame, co_event_init(&locals->frame->done_event));
+            } else {
+                camera_crop_frame_async(camera, locals->frame, co_event_init(&locals->frame->done_event));
+            }
 
-            crop_idx += 1;
+            locals->crop_idx += 1;
         }
 
         {
-            frame = &camera->frames[consume_idx % CAMERA_BUFFERS];
+            locals->frame = &camera->frames[locals->consume_idx % CAMERA_BUFFERS];
 
-            CO_WAIT(&frame->done_event);
+            CO_WAIT(&locals->frame->done_event);
 
-            camera_consume_frame_async(camera, frame, co_event_init(&frame->done_event));
+            camera_consume_frame_async(camera, locals->frame, co_event_init(&locals->frame->done_event));
 
-            consume_idx += 1;
+            locals->consume_idx += 1;
         }
     }
 }
 CO_FN_END()
 
 static void camera_crop_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task) {
-    co_fn_push_start(&frame->consumer_ctx, camera_crop_task, (void *)frame, done_task);
+    frame->width = CAMERA_CROP_WIDTH;
+    frame->height = CAMERA_CROP_HEIGHT;
+
+    co_fn_push_start_with_frame(&frame->consumer_ctx, camera_crop_task, (void *)frame, done_task);
 }
 
 #define CAMERA_CROP_YIELD 1
 
-CO_FN_BEGIN(camera_crop_task, frame_t *, frame)
+CO_FN_BEGIN_WITH_FRAME(camera_crop_task, frame_t *, frame, camera_crop_task_frame_t, locals)
 {
-    static uint8_t *src_buffer;
-    static uint8_t *dst_buffer;
-    static size_t i;
-
     // TODO: return immediately if data doesn't need to be moved in memory
     // * all(CAMERA_CROP_{TOP,LEFT,RIGHT} == 0), CAMERA_CROP_BOTTOM can be != 0
     // * all(CAMERA_CROP_{LEFT,RIGHT} == 0) can be handled by changing only the frame buffer pointer
 
-    src_buffer = frame->buffer + CAMERA_CROP_TOP * CAMERA_CAPTURE_WIDTH;
-    dst_buffer = frame->buffer;
+    locals->src_buffer = frame->buffer + CAMERA_CROP_TOP * CAMERA_CAPTURE_WIDTH;
+    locals->dst_buffer = frame->buffer;
 
     trace_set(TRACE_CAMERA_CROP, true);
 
-    for (i = 0; i < CAMERA_CROP_HEIGHT; i++) {
-        memmove(dst_buffer, src_buffer + CAMERA_CROP_LEFT, CAMERA_CROP_WIDTH * sizeof(uint8_t));
-        src_buffer += CAMERA_CAPTURE_WIDTH;
-        dst_buffer += CAMERA_CROP_WIDTH;
+    for (locals->i = 0; locals->i < CAMERA_CROP_HEIGHT; locals->i++) {
+        memmove(locals->dst_buffer, locals->src_buffer + CAMERA_CROP_LEFT, CAMERA_CROP_WIDTH * sizeof(uint8_t));
+        locals->src_buffer += CAMERA_CAPTURE_WIDTH;
+        locals->dst_buffer += CAMERA_CROP_WIDTH;
 
         // TODO: yield based on time instead of rows, to be independent of camera resolution 
-        if (i % CAMERA_CROP_YIELD == 0) {
+        if (locals->i % CAMERA_CROP_YIELD == 0) {
             trace_set(TRACE_CAMERA_CROP, false);
             CO_YIELD();
             trace_set(TRACE_CAMERA_CROP, true);
@@ -222,6 +237,14 @@ CO_FN_BEGIN(camera_crop_task, frame_t *, frame)
 }
 CO_FN_END()
 
+static void camera_preprocess_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task) {
+    frame->width = camera->preprocess->config.dst_width;
+    frame->height = camera->preprocess->config.dst_height;
+
+    // The output is never larger than the crop window, process the frame in-place
+    preprocess_run_async(camera->preprocess, frame->buffer, frame->buffer, done_task);
+}
+
 static void camera_consume_frame_async(camera_t *camera, frame_t *frame, pi_task_t *done_task) {
-    co_fn_push_start(&frame->consumer_ctx, camera->consumer_callback, (void *)frame, done_task);
+    co_fn_push_start_with_frame(&frame->consumer_ctx, camera->consumer_callback, (void *)frame, done_task);
 }
@@ -28,12 +28,20 @@
 #include "config.h"
 #include "coroutine.h"
 #include "camera/himax.h"
+#include "preprocess.h"
 #include "utils.h"
 
 #include <pmsis.h>
 
 #include <stdbool.h>
 
+// Local variables of camera_crop_task, see CO_FN_BEGIN_WITH_FRAME
+typedef struct camera_crop_task_frame_s {
+    uint8_t *src_buffer;
+    uint8_t *dst_buffer;
+    size_t i;
+} camera_crop_task_frame_t;
+
 typedef struct frame_s {
     uint8_t *buffer;
     size_t buffer_size;
@@ -42,22 +50,35 @@ typedef struct frame_s {
     bool managed;
 
     co_event_t done_event;
-    co_fn_ctx_t consumer_ctx;
+    CO_FN_CTX_WITH_FRAME(camera_crop_task_frame_t) consumer_ctx;
 
     // Sequential frame ID from the camera's hardware frame counter
     uint8_t frame_id;
     
     // GAP8 end-of-frame timestamp [usec]
     uint32_t frame_timestamp;
+
+    // Size of the image stored in buffer, after cropping or preprocessing [px]
+    uint16_t width;
+    uint16_t height;
 } frame_t;
 
+// Local variables of camera_task
+typedef struct camera_task_frame_s {
+    int capture_idx, crop_idx, consume_idx;
+    frame_t *frame;
+} camera_task_frame_t;
+
 typedef struct camera_s {
     himax_t himax;
-    co_fn_ctx_t camera_ctx;
+    CO_FN_CTX_WITH_FRAME(camera_task_frame_t) camera_ctx;
 
     frame_t frames[CAMERA_BUFFERS];
 
     co_fn_t consumer_callback;
+
+    // Optional cluster preprocessing stage, replaces the crop on the FC
+    preprocess_t *preprocess;
 } camera_t;
 
 void camera_init(camera_t *camera, co_fn_t consumer_callback);
@@ -68,6 +89,10 @@ void camera_init_frames_external(camera_t *camera, int n_buffers, uint8_t *buffe
 size_t camera_get_buffer_size(const camera_t *camera);
 int camera_get_buffer_id(const camera_t *camera, const frame_t *frame);
 
+// Preprocess frames on the cluster between capture and consume. Must be called before
+// camera_start, the crop window of the preprocessing config is relative to the capture.
+void camera_set_preprocess(camera_t *camera, preprocess_t *preprocess);
+
 void camera_start(camera_t *camera);
 
 #endif // __CAMERA_H__
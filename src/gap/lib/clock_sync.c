@@ -0,0 +1,124 @@
+/*
+ * clock_sync.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+#include "clock_sync.h"
+
+#include "config.h"
+#include "cpx/cpx.h"
+#include "debug.h"
+#include "trace_buffer.h"
+
+#include <pmsis.h>
+
+CO_FN_DECLARE(clock_sync_task);
+CO_FN_DECLARE(clock_sync_cpx_callback);
+
+void clock_sync_init(clock_sync_t *sync, uart_protocol_t *uart_protocol, cpx_t *cpx) {
+    sync->uart_protocol = uart_protocol;
+    sync->cpx = cpx;
+    sync->cpx_req = NULL;
+    sync->sequence = 0;
+
+    if (cpx != NULL) {
+        sync->cpx_req = cpx_send_req_alloc(sizeof(cpx_clock_sync_t));
+        sync->cpx_req->header = CPX_HEADER_INIT(CPX_T_ESP32, CPX_F_SYSTEM);
+        cpx_register_rx_callback(cpx, CPX_F_SYSTEM, clock_sync_cpx_callback, (void *)sync);
+    }
+}
+
+void clock_sync_start(clock_sync_t *sync) {
+    // Both links need to be idle at the first iteration
+    pi_task_push(co_event_init(&sync->uart_done));
+    pi_task_push(co_event_init(&sync->cpx_done));
+
+    co_fn_push_start(&sync->ctx, clock_sync_task, (void *)sync, NULL);
+}
+
+static void clock_sync_remote_received(trace_evt_e sync_event, trace_evt_e remote_event, uint32_t sequence, uint32_t rx_timestamp, uint32_t tx_timestamp) {
+    trace_event(sync_event, TRACE_END, sequence);
+
+    // Midpoint of the remote processing time, wrap-around safe
+    uint32_t remote_timestamp = rx_timestamp + (tx_timestamp - rx_timestamp) / 2;
+    trace_event(remote_event, TRACE_BEGIN, (remote_timestamp >>  0) & 0xffff);
+    trace_event(remote_event, TRACE_END,   (remote_timestamp >> 16) & 0xffff);
+}
+
+void clock_sync_uart_pong_received(clock_sync_t *sync, uart_msg_t *message) {
+    clock_sync_msg_t *pong = &message->clock_sync;
+    clock_sync_remote_received(
+        TRACE_EVT_CLOCK_SYNC_STM32, TRACE_EVT_CLOCK_REMOTE_STM32,
+        pong->sequence, pong->rx_timestamp, pong->tx_timestamp
+    );
+}
+
+CO_FN_BEGIN(clock_sync_cpx_callback, cpx_receive_req_t *, req)
+{
+    cpx_clock_sync_t *pong = (cpx_clock_sync_t *)req->payload;
+
+    if (req->payload_length < sizeof(cpx_clock_sync_t) || pong->command != CPX_SYSTEM_CLOCK_PONG) {
+        VERBOSE_PRINT("Unknown system packet (command: 0x%02x)\n", pong->command);
+        break;
+    }
+
+    clock_sync_remote_received(
+        TRACE_EVT_CLOCK_SYNC_NINA, TRACE_EVT_CLOCK_REMOTE_NINA,
+        pong->sequence, pong->rx_timestamp, pong->tx_timestamp
+    );
+}
+CO_FN_END()
+
+CO_FN_BEGIN(clock_sync_task, clock_sync_t *, sync)
+{
+#if defined(__PLATFORM_GVSOC__)
+    // GVSOC simulates neither the STM32 nor NINA
+    VERBOSE_PRINT("Clock sync:\t\t\tDisabled on GVSOC\n");
+    break;
+#endif
+
+    while (true) {
+        // Pings are only sent while the link is idle, so that they are not queued behind other
+        // messages: a late ping inflates the round-trip time and makes the sample less accurate
+        if (sync->uart_protocol != NULL && co_event_is_done(&sync->uart_done)) {
+            trace_event(TRACE_EVT_CLOCK_SYNC_STM32, TRACE_BEGIN, sync->sequence);
+            uart_protocol_send_clock_ping_async(sync->uart_protocol, sync->sequence, co_event_init(&sync->uart_done));
+        }
+
+        if (sync->cpx != NULL && co_event_is_done(&sync->cpx_done) && co_event_is_done(&sync->cpx->send_done)) {
+            cpx_clock_sync_t *ping = (cpx_clock_sync_t *)sync->cpx_req->payload;
+            *ping = (cpx_clock_sync_t){.command = CPX_SYSTEM_CLOCK_PING, .sequence = sync->sequence};
+            cpx_send_req_set_tail(sync->cpx_req, NULL, 0);
+            cpx_send_req_set_head_length(sync->cpx_req, sizeof(cpx_clock_sync_t));
+
+            trace_event(TRACE_EVT_CLOCK_SYNC_NINA, TRACE_BEGIN, sync->sequence);
+            cpx_send_async(sync->cpx, sync->cpx_req, co_event_init(&sync->cpx_done));
+        }
+
+        sync->sequence += 1;
+
+        pi_task_push_delayed_us(co_event_init(&sync->timer), CLOCK_SYNC_PERIOD_US);
+        CO_WAIT(&sync->timer);
+    }
+}
+CO_FN_END()
@@ -0,0 +1,79 @@
+/*
+ * clock_sync.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+/*
+ * CLOCK SYNCHRONIZATION
+ *
+ * Periodically exchanges timestamped ping/pong messages with the STM32 (over
+ * the UART) and with NINA (over CPX SPI), so that the host can estimate the
+ * offset and drift between the clocks of the three chips and merge their
+ * traces on a single timeline (see trace_merge in the client package).
+ *
+ * Each exchange is recorded in the GAP8 event trace, the host does the fit:
+ *  - TRACE_EVT_CLOCK_SYNC_*:   BEGIN when the ping is sent, END when the pong
+ *                              is received, context is the sequence number
+ *  - TRACE_EVT_CLOCK_REMOTE_*: midpoint between the remote receive and send
+ *                              timestamps [us], split over BEGIN (low 16 bits)
+ *                              and END (high 16 bits)
+ *
+ * Requires trace_buffer to be started on the FC, CLOCK_SYNC_PERIOD_US must be
+ * defined in config.h. CPX pongs require CPX_SPI_BIDIRECTIONAL.
+ */
+
+#ifndef __CLOCK_SYNC_H__
+#define __CLOCK_SYNC_H__
+
+#include "config.h"
+#include "coroutine.h"
+#include "uart_protocol.h"
+
+#include <pmsis.h>
+
+#include <stdint.h>
+
+typedef struct cpx_s cpx_t;
+typedef struct cpx_send_req_s cpx_send_req_t;
+
+typedef struct clock_sync_s {
+    uart_protocol_t *uart_protocol;
+    cpx_t *cpx;
+    cpx_send_req_t *cpx_req;
+
+    co_fn_ctx_t ctx;
+    co_event_t timer;
+    co_event_t uart_done;
+    co_event_t cpx_done;
+
+    uint32_t sequence;
+} clock_sync_t;
+
+// Either uart_protocol or cpx can be NULL to synchronize only over the other link
+void clock_sync_init(clock_sync_t *sync, uart_protocol_t *uart_protocol, cpx_t *cpx);
+void clock_sync_start(clock_sync_t *sync);
+
+// To be called from the uart_protocol message callback with UART_CLOCK_PONG_MSG_HEADER messages
+void clock_sync_uart_pong_received(clock_sync_t *sync, uart_msg_t *message);
+
+#endif // __CLOCK_SYNC_H__
@@ -0,0 +1,183 @@
+/*
+ * coroutine.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "coroutine.h"
+
+#include "config.h"
+
+#include <pmsis.h>
+
+typedef struct co_sched_s {
+    // Ready contexts of each priority, from CO_PRIORITY_LOW
+    list_head_t ready[CO_PRIORITY_LEVELS];
+    int n_ready;
+
+    // The scheduler task has been pushed and has not run yet
+    bool pending;
+    pi_task_t task;
+
+#ifdef CO_STATS
+    co_sched_stats_t stats;
+#endif
+} co_sched_t;
+
+static PI_FC_L1 co_sched_t co_sched;
+
+static void co_sched_run(void *arg);
+
+#ifdef CO_STATS
+static inline uint32_t co_stats_timestamp() {
+    return pi_perf_read(PI_PERF_CYCLES);
+}
+
+void co_stats_start() {
+    pi_perf_conf(1 << PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+}
+
+void co_fn_stats_reset(co_fn_ctx_t *ctx) {
+    uint32_t ready_timestamp = ctx->stats.ready_timestamp;
+    ctx->stats = (co_fn_stats_t){ .ready_timestamp = ready_timestamp };
+}
+
+const co_sched_stats_t *co_sched_get_stats() {
+    return &co_sched.stats;
+}
+
+void co_sched_stats_reset() {
+    co_sched.stats = (co_sched_stats_t){0};
+}
+#endif
+
+// Must be called with the interrupts disabled
+static inline bool co_sched_schedule() {
+    bool push = co_sched.n_ready > 0 && !co_sched.pending;
+
+    if (push) {
+        co_sched.pending = true;
+    }
+
+    return push;
+}
+
+void co_sched_push(co_fn_ctx_t *ctx) {
+#ifdef CO_STATS
+    ctx->stats.ready_timestamp = co_stats_timestamp();
+#endif
+
+    int irq = disable_irq();
+    list_append(&co_sched.ready[ctx->priority - CO_PRIORITY_LOW], &ctx->ready);
+    co_sched.n_ready++;
+    bool push = co_sched_schedule();
+    restore_irq(irq);
+
+    if (push) {
+        pi_task_push(pi_task_callback(&co_sched.task, co_sched_run, NULL));
+    }
+}
+
+static co_fn_ctx_t *co_sched_pop() {
+    co_fn_ctx_t *ctx = NULL;
+
+    int irq = disable_irq();
+    for (int level = CO_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        list_el_t *el = list_pop_front(&co_sched.ready[level]);
+
+        if (el) {
+            ctx = list_entry(el, co_fn_ctx_t, ready);
+            co_sched.n_ready--;
+            break;
+        }
+    }
+    restore_irq(irq);
+
+    return ctx;
+}
+
+static void co_sched_run(void *arg) {
+    // Resume as many coroutines as were ready when the batch started, so that a coroutine
+    // that yields continuously does not starve the other PMSIS tasks. Contexts made ready
+    // during the batch are still resumed first if their priority is higher.
+    int irq = disable_irq();
+    co_sched.pending = false;
+    int budget = co_sched.n_ready;
+    restore_irq(irq);
+
+#ifdef CO_STATS
+    uint32_t batch_start = co_stats_timestamp();
+    uint32_t n_resumes = 0;
+#endif
+
+    while (budget-- > 0) {
+        co_fn_ctx_t *ctx = co_sched_pop();
+
+        if (!ctx) {
+            break;
+        }
+
+#ifdef CO_STATS
+        uint32_t start = co_stats_timestamp();
+        uint32_t latency = start - ctx->stats.ready_timestamp;
+#endif
+
+        co_fn_resume(ctx);
+
+#ifdef CO_STATS
+        uint32_t run = co_stats_timestamp() - start;
+
+        ctx->stats.n_resumes++;
+        ctx->stats.run_cycles += run;
+        ctx->stats.latency_cycles += latency;
+        if (run > ctx->stats.max_run_cycles) {
+            ctx->stats.max_run_cycles = run;
+        }
+        if (latency > ctx->stats.max_latency_cycles) {
+            ctx->stats.max_latency_cycles = latency;
+        }
+
+        n_resumes++;
+#endif
+    }
+
+#ifdef CO_STATS
+    uint32_t batch_cycles = co_stats_timestamp() - batch_start;
+
+    co_sched.stats.n_batches++;
+    if (n_resumes > co_sched.stats.max_batch_resumes) {
+        co_sched.stats.max_batch_resumes = n_resumes;
+    }
+    if (batch_cycles > co_sched.stats.max_batch_cycles) {
+        co_sched.stats.max_batch_cycles = batch_cycles;
+    }
+#endif
+
+    irq = disable_irq();
+    bool push = co_sched_schedule();
+    restore_irq(irq);
+
+    if (push) {
+        pi_task_push(pi_task_callback(&co_sched.task, co_sched_run, NULL));
+    }
+}
@@ -33,9 +33,33 @@
  *   - https://en.cppreference.com/w/cpp/language/coroutines
  *   - https://www.chiark.greenend.org.uk/~sgtatham/coroutines.html
  *
+ * Scheduling:
+ *   Coroutines are not resumed by their own pi_task_t, but by a scheduler task 
+ *   that is pushed to the PMSIS event kernel whenever a coroutine is ready. Each
+ *   time it runs, the scheduler resumes the coroutines that were ready, higher 
+ *   priorities first and in FIFO order within the same priority, then gives the
+ *   other PMSIS tasks a chance to run before the next batch. A coroutine resumed
+ *   at CO_PRIORITY_HIGH (e.g., UART and CPX handling) thus waits at most for the
+ *   current batch and the PMSIS tasks already pushed, instead of a resume of 
+ *   every coroutine ahead of it.
+ *
+ *   When CO_STATS is defined in config.h, each context records how many times it
+ *   was resumed, its run time and the latency between being ready and being 
+ *   resumed, in FC cycles. The FC cycle counter must be started with 
+ *   co_stats_start (or trace_buffer_start).
+ *
+ * Frames:
+ *   Local variables of a coroutine that must survive a suspension point are 
+ *   declared in a frame struct, stored next to the context of each instance 
+ *   with CO_FN_CTX_WITH_FRAME and accessed through the pointer declared by 
+ *   CO_FN_BEGIN_WITH_FRAME. Unlike static locals, each instance of the coroutine
+ *   has its own frame, so that more instances can run at the same time. The 
+ *   frame is zero-initialized every time the coroutine is started.
+ *
  * Known limitations:
  *   - Local variables in stackless coroutines are not preserved between resumes
- *     (the compiler should give a -Wmaybe-uninitialized error if you try!)
+ *     (the compiler should give a -Wmaybe-uninitialized error if you try!), 
+ *     keep them in a frame instead
  *   - The current switch-based implementation prevents using switch statements
  *     inside an async function (can be addressed by moving to a label pointer-
  *     based implementation).
@@ -67,6 +91,17 @@
 
 typedef struct co_fn_ctx_s co_fn_ctx_t;
 
+// Coroutine priority, a zero-initialized context has CO_PRIORITY_NORMAL
+typedef int8_t co_priority_t;
+typedef enum {
+    CO_PRIORITY_LOW = -1,
+    CO_PRIORITY_NORMAL = 0,
+    CO_PRIORITY_HIGH = 1,
+    CO_PRIORITY_URGENT = 2,
+} co_priority_e;
+
+#define CO_PRIORITY_LEVELS (CO_PRIORITY_URGENT - CO_PRIORITY_LOW + 1)
+
 // Coroutine function pointer
 typedef void (*co_fn_t)(co_fn_ctx_t *ctx);
 
@@ -78,19 +113,46 @@ typedef enum {
     CO_RESUME_DONE = -2
 } co_fn_resume_e;
 
+// Per-context instrumentation, in FC cycles (see CO_STATS)
+typedef struct co_fn_stats_s {
+    uint32_t n_resumes;
+    uint64_t run_cycles;            // Total time spent running
+    uint32_t max_run_cycles;
+    uint64_t latency_cycles;        // Total time spent ready, waiting for the scheduler
+    uint32_t max_latency_cycles;
+    uint32_t ready_timestamp;       // When it was last made ready
+} co_fn_stats_t;
+
+// Scheduler instrumentation, in FC cycles (see CO_STATS)
+typedef struct co_sched_stats_s {
+    uint32_t n_batches;
+    uint32_t max_batch_resumes;
+    uint32_t max_batch_cycles;      // Longest time other PMSIS tasks had to wait for the scheduler
+} co_sched_stats_t;
+
 // Coroutine context struct
 // Contains all the data needed by an instance of a coroutine
 typedef struct co_fn_ctx_s {
     co_fn_t fn;
     void *arg;
 
-    pi_task_t resume_task;
     co_fn_resume_t resume_point;
+    co_priority_t priority;
 
     pi_task_t *done_task;
 
+    // Size of the frame that follows the context, 0 if started with co_fn_push_start
+    size_t frame_size;
+
     // Linked list of contexts waiting on the same co_event_t
     list_el_t waiting;
+
+    // Linked list of contexts ready to be resumed by the scheduler
+    list_el_t ready;
+
+#ifdef CO_STATS
+    co_fn_stats_t stats;
+#endif
 } co_fn_ctx_t;
 
 // Represents an event that can be waited for using CO_WAIT in a coroutine, 
@@ -113,10 +175,35 @@ static inline void co_fn_resume(co_fn_ctx_t *ctx) {
     (*ctx->fn)(ctx);
 }
 
+// Mark the context as ready, the scheduler resumes it after the ready contexts with
+// the same or higher priority
+void co_sched_push(co_fn_ctx_t *ctx);
+
 static inline void co_fn_push_resume(co_fn_ctx_t *ctx) {
-    pi_task_push(pi_task_callback(&ctx->resume_task, (pi_callback_func_t)ctx->fn, ctx));
+    co_sched_push(ctx);
 }
 
+// Set the priority used by the next resumes of a coroutine, kept when the context is 
+// started again
+static inline void co_fn_set_priority(co_fn_ctx_t *ctx, co_priority_t priority) {
+    if (priority < CO_PRIORITY_LOW || priority > CO_PRIORITY_URGENT) {
+        CO_ASSERTION_FAILURE("Invalid coroutine priority %d\n", priority);
+    }
+
+    ctx->priority = priority;
+}
+
+#ifdef CO_STATS
+// Start the FC cycle counter used by the instrumentation
+void co_stats_start();
+
+// Reset the instrumentation of a context, e.g. after a warm-up period
+void co_fn_stats_reset(co_fn_ctx_t *ctx);
+
+const co_sched_stats_t *co_sched_get_stats();
+void co_sched_stats_reset();
+#endif
+
 // Start a new instance of a coroutine function
 // 
 // Params:
@@ -125,7 +212,7 @@ static inline void co_fn_push_resume(co_fn_ctx_t *ctx) {
 //   - function: pointer to the coroutine function
 //   - arg: optional argument to pass to the coroutine (see the corresponding CO_FN_BEGIN for the expected type)
 //   - done_task: optional pi_task_t to be triggered when the coroutine terminates
-static inline void co_fn_push_start(co_fn_ctx_t *ctx, co_fn_t function, void *arg, pi_task_t *done_task) {
+static inline void co_fn_push_start_frame(co_fn_ctx_t *ctx, size_t frame_size, co_fn_t function, void *arg, pi_task_t *done_task) {
     if (ctx->resume_point != CO_RESUME_START && ctx->resume_point != CO_RESUME_DONE) {
         // FIXME: this assumes that ctx is zero-initialized
         CO_ASSERTION_FAILURE("Function not correctly initialized or started while already running");
@@ -135,11 +222,25 @@ static inline void co_fn_push_start(co_fn_ctx_t *ctx, co_fn_t function, void *ar
     ctx->arg = arg;
     ctx->resume_point = CO_RESUME_START;
     ctx->done_task = done_task;
+    ctx->frame_size = frame_size;
     list_el_init(&ctx->waiting);
+    list_el_init(&ctx->ready);
 
     co_fn_push_resume(ctx);
 }
 
+static inline void co_fn_push_start(co_fn_ctx_t *ctx, co_fn_t function, void *arg, pi_task_t *done_task) {
+    co_fn_push_start_frame(ctx, 0, function, arg, done_task);
+}
+
+// Start a new instance of a coroutine function on a context declared with 
+// CO_FN_CTX_WITH_FRAME, see co_fn_push_start. ctx_with_frame is a pointer to it.
+#define co_fn_push_start_with_frame(ctx_with_frame, function, arg, done_task)       \
+    co_fn_push_start_frame(                                                         \
+        &(ctx_with_frame)->ctx, sizeof((ctx_with_frame)->frame),                    \
+        function, arg, done_task                                                    \
+    )
+
 static void co_event_callback(void *arg) {
     co_event_t *event = arg;
     list_el_t *el;
@@ -197,6 +298,20 @@ static inline void co_event_wait(co_event_t *event, co_fn_ctx_t *ctx) {
 #define CO_FN_DECLARE(fn_name)                                                      \
     static void fn_name(co_fn_ctx_t *__co_ctx)
 
+// Type of a context followed by the frame of a coroutine defined with 
+// CO_FN_BEGIN_WITH_FRAME(..., frame_type, ...). The coroutine is started with
+// co_fn_push_start_with_frame, which records the size of the frame, e.g.:
+//
+//   CO_FN_CTX_WITH_FRAME(my_task_frame_t) my_ctx;
+//   co_fn_push_start_with_frame(&my_ctx, my_task, arg, done_task);
+//
+// Coroutines defined with CO_FN_BEGIN can also be started on it, they ignore the frame.
+#define CO_FN_CTX_WITH_FRAME(frame_type)                                            \
+    struct {                                                                        \
+        co_fn_ctx_t ctx;                                                            \
+        frame_type frame;                                                           \
+    }
+
 // Begin the definition of a coroutine function
 //
 // Params:
@@ -206,6 +321,38 @@ static inline void co_event_wait(co_event_t *event, co_fn_ctx_t *ctx) {
 //  - arg_name: name of the argument variable to be used inside the coroutine body
 #define CO_FN_BEGIN(fn_name, arg_type, arg_name)                                    \
     CO_FN_DECLARE(fn_name) {                                                        \
+        CO_FN_PROLOGUE(arg_type, arg_name)
+
+// Begin the definition of a coroutine function with a frame of local variables
+// preserved across suspension points. It must be started on a context declared 
+// with CO_FN_CTX_WITH_FRAME(frame_type) by co_fn_push_start_with_frame, it fails
+// an assertion on any other context instead of writing past its end.
+//
+// Params:
+//  - fn_name, arg_type, arg_name: see CO_FN_BEGIN
+//  - frame_type: struct with the local variables of the coroutine
+//  - frame_name: name of the pointer to the frame to be used inside the coroutine body
+#define CO_FN_BEGIN_WITH_FRAME(fn_name, arg_type, arg_name, frame_type, frame_name) \
+    CO_FN_DECLARE(fn_name) {                                                        \
+        frame_type *frame_name =                                                    \
+            &((CO_FN_CTX_WITH_FRAME(frame_type) *)__co_ctx)->frame;                 \
+                                                                                    \
+        if (__co_ctx->resume_point == CO_RESUME_START) {                            \
+            if (__co_ctx->frame_size != sizeof(frame_type)) {                       \
+                CO_ASSERTION_FAILURE(                                               \
+                    "%s needs a %dB frame but was started with %dB\n",              \
+                    __FUNCTION__, (int)sizeof(frame_type),                          \
+                    (int)__co_ctx->frame_size                                       \
+                );                                                                  \
+            }                                                                       \
+                                                                                    \
+            *frame_name = (frame_type){0};                                          \
+        }                                                                           \
+                                                                                    \
+        CO_FN_PROLOGUE(arg_type, arg_name)
+
+// Common part of CO_FN_BEGIN and CO_FN_BEGIN_WITH_FRAME
+#define CO_FN_PROLOGUE(arg_type, arg_name)                                          \
         /* Ensure -Wmaybe-uninitialized is always an error to catch local */        \
         /* variables used across suspension points. */                              \
         _Pragma("GCC diagnostic push")                                              \
@@ -225,10 +225,13 @@ void cpx_spi_init(cpx_spi_t *cpx_spi) {
 
     spi_init(cpx_spi);
     rtt_pins_init(cpx_spi);
+
+    // Resumed before the frame processing, the NINA waits for each SPI transfer
+    co_fn_set_priority(&cpx_spi->cpx_spi_ctx.ctx, CO_PRIORITY_HIGH);
 }
 
 void cpx_spi_start(cpx_spi_t *cpx_spi) {
-    co_fn_push_start(&cpx_spi->cpx_spi_ctx, cpx_spi_task, (void *)cpx_spi, NULL);
+    co_fn_push_start_with_frame(&cpx_spi->cpx_spi_ctx, cpx_spi_task, (void *)cpx_spi, NULL);
 }
 
 void cpx_spi_send_async(cpx_spi_t *cpx_spi, cpx_spi_send_req_t *req, pi_task_t *done_task) {
@@ -257,47 +260,43 @@ void cpx_spi_receive_async(cpx_spi_t *cpx_spi, cpx_spi_receive_req_t *req, pi_ta
     co_event_group_set(&cpx_spi->events, CPX_SPI_EVENT_RECEIVE);
 }
 
-CO_FN_BEGIN(cpx_spi_task, cpx_spi_t *, cpx_spi)
+CO_FN_BEGIN_WITH_FRAME(cpx_spi_task, cpx_spi_t *, cpx_spi, cpx_spi_task_frame_t, locals)
 {
-    static co_event_mask_t events;
-    static cpx_spi_send_req_t *send_req;
-    static cpx_spi_receive_req_t *receive_req;
-    
     while (true) {
         // 1) Wait until someone wants to transmit data
-        events = CPX_SPI_EVENT_NINA_RTT | CPX_SPI_EVENT_SEND;
-        CO_WAIT_GROUP_ANY(&cpx_spi->events, &events);
+        locals->events = CPX_SPI_EVENT_NINA_RTT | CPX_SPI_EVENT_SEND;
+        CO_WAIT_GROUP_ANY(&cpx_spi->events, &locals->events);
 
         // 2) In any case, wait until we are also ready to receive
         // TODO: figure out if we can decouple transmit from receive
-        events = CPX_SPI_EVENT_RECEIVE;
-        CO_WAIT_GROUP_ALL(&cpx_spi->events, &events);
+        locals->events = CPX_SPI_EVENT_RECEIVE;
+        CO_WAIT_GROUP_ALL(&cpx_spi->events, &locals->events);
 
         // 3) Notify NINA if we have data to transmit
-        events = co_event_group_get(&cpx_spi->events, CPX_SPI_EVENT_SEND);
-        if (events & CPX_SPI_EVENT_SEND) {
+        locals->events = co_event_group_get(&cpx_spi->events, CPX_SPI_EVENT_SEND);
+        if (locals->events & CPX_SPI_EVENT_SEND) {
             gap8_rtt_set(cpx_spi, true);
         }
 
         // 4) Ensure that NINA is ready to receive, in case we woke up due to CPX_SPI_EVENT_SEND at 1)
         trace_set(TRACE_CPX_SPI_WAIT_RTT, true);
-        events = CPX_SPI_EVENT_NINA_RTT;
-        CO_WAIT_GROUP_ALL(&cpx_spi->events, &events);
+        locals->events = CPX_SPI_EVENT_NINA_RTT;
+        CO_WAIT_GROUP_ALL(&cpx_spi->events, &locals->events);
         trace_set(TRACE_CPX_SPI_WAIT_RTT, false);
 
         // 5) Everyone is ready for the transfer. Fetch all event bits together to get the final overall state
         // NOTE 1: at this point we should always have CPX_SPI_EVENT_NINA_RTT and CPX_SPI_EVENT_RECEIVE
         // NOTE 2: CPX_SPI_EVENT_SEND might have be set between 1) and here, here we are still in time to
         //         coalesce the send in the current transfer and save some time
-        events = co_event_group_get(&cpx_spi->events, CPX_SPI_EVENTS_ALL);
-        send_req = (events & CPX_SPI_EVENT_SEND) ? cpx_spi->send_req : NULL;
-        receive_req = (events & CPX_SPI_EVENT_RECEIVE) ? cpx_spi->receive_req : NULL;
+        locals->events = co_event_group_get(&cpx_spi->events, CPX_SPI_EVENTS_ALL);
+        locals->send_req = (locals->events & CPX_SPI_EVENT_SEND) ? cpx_spi->send_req : NULL;
+        locals->receive_req = (locals->events & CPX_SPI_EVENT_RECEIVE) ? cpx_spi->receive_req : NULL;
 
         trace_set(TRACE_CPX_SPI_TRANSFER, true);
 
         // 6) Transfer the cpx_spi_header_t
         cpx_spi_transfer_header_async(
-            cpx_spi, send_req, receive_req, co_event_init(&cpx_spi->spi_done)
+            cpx_spi, locals->send_req, locals->receive_req, co_event_init(&cpx_spi->spi_done)
         );
         CO_WAIT(&cpx_spi->spi_done);
         
@@ -311,27 +310,27 @@ CO_FN_BEGIN(cpx_spi_task, cpx_spi_t *, cpx_spi)
 #ifndef CPX_SPI_BIDIRECTIONAL
         // Any received packet will be corrupted if bidirectional communication is disabled,
         // ensure it is ignored
-        if (receive_req) {
-            receive_req->header.length = 0;
+        if (locals->receive_req) {
+            locals->receive_req->header.length = 0;
         }
 #endif
 
         // 9) Transfer the send_req's payload_head and an equivalent length of receive_req
         cpx_spi_transfer_payload_head_async(
-            cpx_spi, send_req, receive_req, co_event_init(&cpx_spi->spi_done)
+            cpx_spi, locals->send_req, locals->receive_req, co_event_init(&cpx_spi->spi_done)
         );
         CO_WAIT(&cpx_spi->spi_done);
 
         // 10) Transfer the send_req's payload_tail and the remaining length of receive_req
         cpx_spi_transfer_payload_tail_async(
-            cpx_spi, send_req, receive_req, co_event_init(&cpx_spi->spi_done)
+            cpx_spi, locals->send_req, locals->receive_req, co_event_init(&cpx_spi->spi_done)
         );
         CO_WAIT(&cpx_spi->spi_done);
 
         trace_set(TRACE_CPX_SPI_TRANSFER, false);
 
         // 11) Notify the sender that the send was completed
-        if (send_req) {
+        if (locals->send_req) {
             cpx_spi->send_req = NULL;
             pi_task_push(cpx_spi->send_done);
             co_event_group_clear(&cpx_spi->events, CPX_SPI_EVENT_SEND);
@@ -339,7 +338,7 @@ CO_FN_BEGIN(cpx_spi_task, cpx_spi_t *, cpx_spi)
 
         // 12) Notify the receiver that the receive was completed
         // NOTE: at the moment, receive_req should always be present
-        if (receive_req) {
+        if (locals->receive_req) {
             cpx_spi->receive_req = NULL;
             pi_task_push(cpx_spi->receive_done);
             co_event_group_clear(&cpx_spi->events, CPX_SPI_EVENT_RECEIVE);
@@ -82,8 +82,15 @@ typedef struct cpx_spi_receive_req_s {
 
 void cpx_spi_receive_req_init(cpx_spi_receive_req_t *req);
 
+// Local variables of cpx_spi_task, see CO_FN_BEGIN_WITH_FRAME
+typedef struct cpx_spi_task_frame_s {
+    co_event_mask_t events;
+    cpx_spi_send_req_t *send_req;
+    cpx_spi_receive_req_t *receive_req;
+} cpx_spi_task_frame_t;
+
 typedef struct cpx_spi_s {
-    co_fn_ctx_t cpx_spi_ctx;
+    CO_FN_CTX_WITH_FRAME(cpx_spi_task_frame_t) cpx_spi_ctx;
 
     pi_device_t spi;
     pi_device_t gpio;
@@ -46,6 +46,7 @@ typedef enum {
     CPX_F_APP        = 0x05,
 
     CPX_F_STREAMER   = 0x06,
+    CPX_F_TRACE      = 0x07,
 
     CPX_F_TEST       = 0x0E,
     CPX_F_BOOTLOADER = 0x0F,
@@ -62,6 +63,24 @@ typedef struct cpx_header_s {
     uint8_t version : 2;
 } __attribute__((packed)) cpx_header_t;
 
+// Commands carried by CPX_F_SYSTEM packets
+typedef enum {
+    CPX_SYSTEM_CLOCK_PING = 0x01,
+    CPX_SYSTEM_CLOCK_PONG = 0x02,
+} cpx_system_command_e;
+
+// Clock synchronization ping/pong, timestamps are in microseconds of the responder's clock
+typedef struct cpx_clock_sync_s {
+    uint8_t command;
+    uint8_t _padding[3];
+
+    uint32_t sequence;
+
+    // Set by the responder when the ping is received and when the pong is sent
+    uint32_t rx_timestamp;
+    uint32_t tx_timestamp;
+} __attribute__((packed)) cpx_clock_sync_t;
+
 #define CPX_HEADER_INIT(/* cpx_target_e */ dest, /* cpx_function_e */ func)  \
     ((cpx_header_t){                                                         \
         .destination = dest, .source = CPX_T_GAP,                            \
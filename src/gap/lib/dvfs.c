@@ -0,0 +1,147 @@
+/*
+ * dvfs.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "dvfs.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MHZ (1000000.0f)
+
+// Slowest operating point that runs cycles [MHz * us] in at most budget [us], the fastest if none
+static uint8_t required_level(const dvfs_config_t *config, uint32_t cycles, float budget) {
+    for (int i = 0; i < config->n_points; i++) {
+        if (cycles <= budget * (config->points[i].freq_cl / MHZ)) {
+            return i;
+        }
+    }
+
+    return config->n_points - 1;
+}
+
+void dvfs_init(dvfs_t *dvfs, const dvfs_config_t *config) {
+    memset(dvfs, 0, sizeof(*dvfs));
+
+    dvfs->config = *config;
+    if (dvfs->config.n_points > DVFS_MAX_POINTS) {
+        dvfs->config.n_points = DVFS_MAX_POINTS;
+    }
+    if (dvfs->config.window > DVFS_MAX_WINDOW) {
+        dvfs->config.window = DVFS_MAX_WINDOW;
+    } else if (dvfs->config.window == 0) {
+        dvfs->config.window = 1;
+    }
+    if (dvfs->config.margin < 1.0f) {
+        dvfs->config.margin = 1.0f;
+    }
+
+    dvfs->level = dvfs->config.n_points - 1;
+}
+
+bool dvfs_update(dvfs_t *dvfs, uint32_t busy) {
+    const dvfs_config_t *config = &dvfs->config;
+    const uint8_t fastest = config->n_points - 1;
+
+    bool miss = busy > config->period;
+    dvfs->n_inferences++;
+    if (miss) {
+        dvfs->n_misses++;
+    }
+
+    if (config->mode == DVFS_MODE_FIXED) {
+        return false;
+    }
+
+    uint32_t cycles = (uint64_t)busy * config->points[dvfs->level].freq_cl / 1000000;
+
+    if (config->mode == DVFS_MODE_DEADLINE) {
+        dvfs->cycles[dvfs->head] = cycles;
+        dvfs->head = (dvfs->head + 1) % config->window;
+        if (dvfs->count < config->window) {
+            dvfs->count++;
+        }
+
+        // Worst case: the slowest inference in the window, or margin times their mean for the
+        // slow inferences that are not in the window yet
+        uint64_t sum = 0;
+        for (int i = 0; i < dvfs->count; i++) {
+            sum += dvfs->cycles[i];
+            if (dvfs->cycles[i] > cycles) {
+                cycles = dvfs->cycles[i];
+            }
+        }
+
+        float provisioned = config->margin * sum / dvfs->count;
+        if (provisioned > cycles) {
+            cycles = provisioned;
+        }
+    }
+
+    // The worst case of the deadline mode must complete within the whole period, the share of
+    // the period set by target only applies to the latest inference of the slack mode
+    float budget = config->target * config->period;
+    float relaxed_budget = (config->target - config->hysteresis) * config->period;
+    if (config->mode == DVFS_MODE_DEADLINE) {
+        budget = config->period;
+        relaxed_budget = (1.0f - config->hysteresis) * config->period;
+    }
+
+    uint8_t level = dvfs->level;
+    uint8_t required = required_level(config, cycles, budget);
+    uint8_t relaxed = required_level(config, cycles, relaxed_budget);
+
+    if (miss && config->mode == DVFS_MODE_DEADLINE) {
+        level = fastest;
+        dvfs->down_count = 0;
+    } else if (required > level) {
+        level = required;
+        dvfs->down_count = 0;
+    } else if (relaxed < level) {
+        dvfs->down_count++;
+        if (dvfs->down_count >= config->down_frames) {
+            level--;
+            dvfs->down_count = 0;
+        }
+    } else {
+        dvfs->down_count = 0;
+    }
+
+    if (level == dvfs->level) {
+        return false;
+    }
+
+    dvfs->level = level;
+    dvfs->n_changes++;
+    return true;
+}
+
+const dvfs_point_t *dvfs_get_point(const dvfs_t *dvfs) {
+    return &dvfs->config.points[dvfs->level];
+}
+
+uint16_t dvfs_get_voltage(const dvfs_t *dvfs) {
+    uint16_t voltage = dvfs->config.points[dvfs->level].voltage;
+    return voltage > dvfs->config.min_voltage ? voltage : dvfs->config.min_voltage;
+}
@@ -0,0 +1,115 @@
+/*
+ * dvfs.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * DVFS GOVERNOR
+ *
+ * Chooses the cluster operating point (frequency and voltage) from the slack of each frame, i.e.
+ * the frame period minus the cluster time of its inference. The cluster time measured at the
+ * current frequency is converted to cycles, which are assumed not to depend on the frequency, and
+ * the governor picks the slowest operating point that completes them within target * period. The
+ * assumption is pessimistic for the layers bound by L3 or L2 bandwidth, which take the same time at
+ * any cluster frequency.
+ *
+ *  - DVFS_MODE_FIXED: always the fastest operating point, as without governor.
+ *  - DVFS_MODE_SLACK: follows the cycles of the latest inference. Trades deadline misses for
+ *    energy: an inference much slower than the previous one can miss the period.
+ *  - DVFS_MODE_DEADLINE: picks the slowest operating point that completes within the whole period
+ *    the slowest of the latest window inferences and margin times their mean, and jumps to the
+ *    fastest operating point after an inference that missed the period. The period is met by
+ *    every inference up to margin times slower than the mean, e.g. after a slow one has left the
+ *    window.
+ *
+ * The governor moves to a faster operating point as soon as the required one is faster than the
+ * current, but it moves one operating point slower only after down_frames consecutive inferences
+ * that would have completed within (target - hysteresis) * period at that point ((1 - hysteresis)
+ * * period for DVFS_MODE_DEADLINE), so that it does not oscillate between two of them.
+ *
+ * The voltage is shared with the FC: each operating point is applied at the voltage it requires or
+ * at min_voltage, the voltage required by the FC frequency, whichever is higher. Only decides the
+ * operating point, the application applies it with soc_set_operating_point between two inferences.
+ * Only depends on the C standard library, so that it can be tested on the host.
+ */
+
+#ifndef __DVFS_H__
+#define __DVFS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DVFS_MAX_POINTS (8)
+#define DVFS_MAX_WINDOW (16)
+
+typedef enum {
+    DVFS_MODE_FIXED    = 0,
+    DVFS_MODE_SLACK    = 1,
+    DVFS_MODE_DEADLINE = 2,
+} dvfs_mode_e;
+
+typedef struct dvfs_point_s {
+    uint32_t freq_cl;                               // [Hz]
+    uint16_t voltage;                               // Minimum voltage at freq_cl [mV]
+} dvfs_point_t;
+
+typedef struct dvfs_config_s {
+    dvfs_mode_e mode;
+    dvfs_point_t points[DVFS_MAX_POINTS];           // Sorted from the slowest to the fastest
+    uint8_t n_points;
+    uint16_t min_voltage;                           // Minimum voltage of the FC [mV]
+    uint32_t period;                                // Frame period [us]
+    float target;                                   // Share of the period the inference can take
+    float hysteresis;                               // Share of the period kept free before slowing down
+    uint8_t down_frames;                            // Inferences before slowing down
+    uint8_t window;                                 // DVFS_MODE_DEADLINE, at most DVFS_MAX_WINDOW
+    float margin;                                   // DVFS_MODE_DEADLINE, worst case over the mean of the window, >= 1
+} dvfs_config_t;
+
+typedef struct dvfs_s {
+    dvfs_config_t config;
+    uint8_t level;                                  // Current operating point
+    uint8_t down_count;
+
+    // Circular buffer of the cycles of the latest inferences [MHz * us]
+    uint32_t cycles[DVFS_MAX_WINDOW];
+    uint8_t head;
+    uint8_t count;
+
+    // Statistics
+    uint32_t n_inferences;
+    uint32_t n_misses;                              // Inferences longer than the period
+    uint32_t n_changes;
+} dvfs_t;
+
+// Starts from the fastest operating point
+void dvfs_init(dvfs_t *dvfs, const dvfs_config_t *config);
+
+// Cluster time of the inference that just ended [us], returns true if the operating point changed
+bool dvfs_update(dvfs_t *dvfs, uint32_t busy);
+
+const dvfs_point_t *dvfs_get_point(const dvfs_t *dvfs);
+
+// Voltage to apply with the current operating point [mV]
+uint16_t dvfs_get_voltage(const dvfs_t *dvfs);
+
+#endif /* __DVFS_H__ */
@@ -0,0 +1,154 @@
+/*
+ * inference_filter.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "inference_filter.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PI_F (3.14159265f)
+
+// Standard deviation of a normal distribution from its MAD
+#define MAD_TO_STD (1.4826f)
+
+// Wrap an angle to [-pi, pi)
+static float wrap_angle(float angle) {
+    return angle - 2.0f * PI_F * floorf((angle + PI_F) / (2.0f * PI_F));
+}
+
+// Sorts values in place, insertion sort is the fastest for at most INFERENCE_FILTER_MAX_WINDOW elements
+static float median(float *values, int count) {
+    for (int i = 1; i < count; i++) {
+        float value = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = value;
+    }
+
+    return (count % 2) ? values[count / 2] : 0.5f * (values[count / 2 - 1] + values[count / 2]);
+}
+
+void inference_filter_init(inference_filter_t *filter, const inference_filter_config_t *config) {
+    memset(filter, 0, sizeof(*filter));
+
+    filter->config = *config;
+    if (filter->config.window > INFERENCE_FILTER_MAX_WINDOW) {
+        filter->config.window = INFERENCE_FILTER_MAX_WINDOW;
+    }
+}
+
+void inference_filter_reset(inference_filter_t *filter) {
+    filter->head = 0;
+    filter->count = 0;
+}
+
+void inference_filter_run(
+    inference_filter_t *filter, uint32_t timestamp,
+    float output[INFERENCE_FILTER_OUTPUTS], inference_filter_result_t *result
+) {
+    const inference_filter_config_t *config = &filter->config;
+
+    *result = (inference_filter_result_t){0};
+
+    if (filter->count > 0 && timestamp - filter->last_timestamp > config->max_gap) {
+        inference_filter_reset(filter);
+        filter->n_resets++;
+    }
+    filter->last_timestamp = timestamp;
+
+    // The order of the window does not matter, the oldest inference is overwritten first
+    memcpy(filter->history[filter->head], output, sizeof(filter->history[0]));
+    filter->head = (filter->head + 1) % config->window;
+    if (filter->count < config->window) {
+        filter->count++;
+    }
+
+    if (filter->count < INFERENCE_FILTER_MIN_COUNT) {
+        return;
+    }
+
+    float medians[INFERENCE_FILTER_OUTPUTS];
+    float deviations[INFERENCE_FILTER_OUTPUTS];
+    float max_deviation = 0.0f;
+    float consistency = 1.0f;
+
+    for (int i = 0; i < INFERENCE_FILTER_OUTPUTS; i++) {
+        float values[INFERENCE_FILTER_MAX_WINDOW];
+        for (int k = 0; k < filter->count; k++) {
+            float value = filter->history[k][i];
+            if (i == INFERENCE_FILTER_PHI) {
+                // Unwrap around the current inference
+                value = output[i] + wrap_angle(value - output[i]);
+            }
+            values[k] = value;
+        }
+
+        medians[i] = median(values, filter->count);
+
+        for (int k = 0; k < filter->count; k++) {
+            values[k] = fabsf(values[k] - medians[i]);
+        }
+
+        float scale = MAD_TO_STD * median(values, filter->count);
+        if (scale < config->min_scale[i]) {
+            scale = config->min_scale[i];
+        }
+
+        deviations[i] = fabsf(output[i] - medians[i]) / scale;
+        if (deviations[i] > max_deviation) {
+            max_deviation = deviations[i];
+        }
+
+        float output_consistency = config->min_scale[i] / scale;
+        if (output_consistency < consistency) {
+            consistency = output_consistency;
+        }
+    }
+
+    float agreement = 1.0f - max_deviation / config->threshold;
+    if (agreement < 0.0f) {
+        agreement = 0.0f;
+    }
+
+    result->filtered = true;
+    result->outlier = max_deviation > config->threshold;
+    result->confidence = (uint8_t)(255.0f * agreement * consistency + 0.5f);
+    result->deviation = max_deviation;
+
+    for (int i = 0; i < INFERENCE_FILTER_OUTPUTS; i++) {
+        if (config->mode == INFERENCE_FILTER_MEDIAN || deviations[i] > config->threshold) {
+            output[i] = (i == INFERENCE_FILTER_PHI) ? wrap_angle(medians[i]) : medians[i];
+        }
+    }
+
+    filter->n_filtered++;
+    if (result->outlier) {
+        filter->n_outliers++;
+    }
+}
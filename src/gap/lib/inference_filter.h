@@ -0,0 +1,103 @@
+/*
+ * inference_filter.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * INFERENCE FILTER
+ *
+ * Temporal filtering and outlier rejection of the network outputs (x, y, z, phi), before they are
+ * sent to the STM32. Keeps the latest window inferences and computes, for each output, their median
+ * and their median absolute deviation (MAD). An inference is an outlier when one of its outputs
+ * is more than threshold robust standard deviations (1.4826 * MAD, at least min_scale) from the
+ * median of the window. The window includes the raw outputs, outliers too, so that a real jump of
+ * the subject is accepted after window / 2 inferences.
+ *
+ *  - INFERENCE_FILTER_MEDIAN: each output is replaced by the median of the window, which also
+ *    smooths the noise but delays the outputs by window / 2 inferences.
+ *  - INFERENCE_FILTER_HAMPEL: only the outputs that are outliers are replaced by the median, the
+ *    others are passed through without delay.
+ *
+ * The confidence (0 to 255) measures how consistent the inference is with the window: it decreases
+ * linearly with the deviation from the median, reaching 0 at the outlier threshold, and with the
+ * spread of the window w.r.t. min_scale. Outputs are not filtered until the window contains at
+ * least INFERENCE_FILTER_MIN_COUNT inferences, and the window is cleared when no inference is
+ * received for max_gap microseconds. phi is an angle and is filtered modulo 2 pi. Only depends on
+ * the C standard library, so that it can be tested on the host.
+ */
+
+#ifndef __INFERENCE_FILTER_H__
+#define __INFERENCE_FILTER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define INFERENCE_FILTER_OUTPUTS    (4)    // x, y, z [m], phi [rad]
+#define INFERENCE_FILTER_PHI        (3)
+#define INFERENCE_FILTER_MAX_WINDOW (9)
+#define INFERENCE_FILTER_MIN_COUNT  (3)
+
+typedef enum {
+    INFERENCE_FILTER_MEDIAN = 0,
+    INFERENCE_FILTER_HAMPEL = 1,
+} inference_filter_mode_e;
+
+typedef struct inference_filter_config_s {
+    inference_filter_mode_e mode;
+    uint8_t window;                                 // Inferences, at most INFERENCE_FILTER_MAX_WINDOW
+    float threshold;                                // Outlier threshold [robust standard deviations]
+    float min_scale[INFERENCE_FILTER_OUTPUTS];      // Lower bound of the standard deviations [m, rad]
+    uint32_t max_gap;                               // [us]
+} inference_filter_config_t;
+
+typedef struct inference_filter_s {
+    inference_filter_config_t config;
+
+    // Circular buffer of the raw outputs, oldest at head when full
+    float history[INFERENCE_FILTER_MAX_WINDOW][INFERENCE_FILTER_OUTPUTS];
+    uint8_t head;
+    uint8_t count;
+    uint32_t last_timestamp;
+
+    // Statistics
+    uint32_t n_filtered;
+    uint32_t n_outliers;
+    uint32_t n_resets;
+} inference_filter_t;
+
+typedef struct inference_filter_result_s {
+    bool filtered;                                  // False during warm-up, the outputs are unchanged
+    bool outlier;
+    uint8_t confidence;                             // Valid if filtered
+    float deviation;                                // Largest deviation from the median [robust standard deviations]
+} inference_filter_result_t;
+
+void inference_filter_init(inference_filter_t *filter, const inference_filter_config_t *config);
+void inference_filter_reset(inference_filter_t *filter);
+
+// Filter the outputs of an inference completed at timestamp [us], in place
+void inference_filter_run(
+    inference_filter_t *filter, uint32_t timestamp,
+    float output[INFERENCE_FILTER_OUTPUTS], inference_filter_result_t *result
+);
+
+#endif /* __INFERENCE_FILTER_H__ */
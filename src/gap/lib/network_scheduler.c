@@ -0,0 +1,275 @@
+/*
+ * network_scheduler.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "network_scheduler.h"
+
+#include "time.h"
+#include "utils.h"
+
+#include <string.h>
+
+static void network_scheduler_dispatch(network_scheduler_t *scheduler);
+static void network_scheduler_input_consumed(void *arg);
+static void network_scheduler_network_done(void *arg);
+static void network_scheduler_callback_done(void *arg);
+
+void network_scheduler_init(network_scheduler_t *scheduler, pi_device_t *cluster, size_t l2_budget) {
+    memset(scheduler, 0, sizeof(*scheduler));
+
+    scheduler->cluster = cluster;
+    scheduler->l2_budget = l2_budget;
+}
+
+int network_scheduler_add_model(network_scheduler_t *scheduler, network_model_t *model, const network_model_config_t *config) {
+    const network_t *network = config->network;
+
+    if (scheduler->n_models == NETWORK_SCHEDULER_MAX_MODELS || scheduler->l2_arena != NULL) {
+        printf("[network_scheduler] cannot add model %s\n", config->name);
+        return -1;
+    }
+
+    if (config->period == 0 || config->phase >= config->period || network->output_count > NETWORK_SCHEDULER_MAX_OUTPUTS) {
+        printf("[network_scheduler] invalid configuration for model %s\n", config->name);
+        return -1;
+    }
+
+    size_t l2_arena_size = MAX(scheduler->l2_arena_size, network->L2_buffer_size);
+    if (l2_arena_size > scheduler->l2_budget) {
+        printf(
+            "[network_scheduler] model %s does not fit the L2 budget: needs %dB, budget %dB\n",
+            config->name, l2_arena_size, scheduler->l2_budget
+        );
+        return -1;
+    }
+
+    memset(model, 0, sizeof(*model));
+    model->config = *config;
+    model->scheduler = scheduler;
+    model->stats.latency_min = UINT32_MAX;
+
+    scheduler->models[scheduler->n_models++] = model;
+    scheduler->l2_arena_size = l2_arena_size;
+
+    return 0;
+}
+
+int network_scheduler_start(network_scheduler_t *scheduler) {
+    scheduler->l2_arena = pi_l2_malloc(scheduler->l2_arena_size);
+    printf(
+        "Network scheduler:\t\t%s, %d models, %dB @ L2, 0x%08x (budget %dB)\n",
+        scheduler->l2_arena?"OK":"Failed", scheduler->n_models,
+        scheduler->l2_arena_size, scheduler->l2_arena, scheduler->l2_budget
+    );
+    if (!scheduler->l2_arena) {
+        return -1;
+    }
+
+    // Weights are loaded once for networks shared by more models
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_init(scheduler->models[i]->config.network);
+    }
+
+    return 0;
+}
+
+static network_frame_t *network_scheduler_alloc_frame(network_scheduler_t *scheduler) {
+    for (int i = 0; i < NETWORK_SCHEDULER_MAX_FRAMES; i++) {
+        if (scheduler->frames[i].refs == 0) {
+            return &scheduler->frames[i];
+        }
+    }
+
+    CO_ASSERTION_FAILURE("No free frames\n");
+}
+
+static void network_scheduler_release_frame(network_frame_t *frame) {
+    if (--frame->refs == 0 && frame->input_done) {
+        pi_task_push(frame->input_done);
+    }
+}
+
+int network_scheduler_submit(network_scheduler_t *scheduler, const void *input, pi_task_t *input_done) {
+    uint32_t frame_id = scheduler->next_frame_id++;
+
+    // Drop the frames that are going to be replaced first, to free their slots
+    int n_due = 0;
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_model_t *model = scheduler->models[i];
+        if (frame_id % model->config.period != model->config.phase) {
+            continue;
+        }
+
+        if (model->pending) {
+            network_scheduler_release_frame(model->pending);
+            model->pending = NULL;
+            model->stats.n_dropped++;
+        }
+        n_due++;
+    }
+
+    if (n_due == 0) {
+        if (input_done) {
+            pi_task_push(input_done);
+        }
+        return 0;
+    }
+
+    network_frame_t *frame = network_scheduler_alloc_frame(scheduler);
+    *frame = (network_frame_t){
+        .id = frame_id,
+        .input = input,
+        .timestamp = time_get_us(),
+        .refs = n_due,
+        .input_done = input_done,
+    };
+
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_model_t *model = scheduler->models[i];
+        if (frame_id % model->config.period == model->config.phase) {
+            model->pending = frame;
+            model->stats.n_due++;
+        }
+    }
+
+    network_scheduler_dispatch(scheduler);
+
+    return n_due;
+}
+
+bool network_scheduler_is_idle(network_scheduler_t *scheduler) {
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_model_t *model = scheduler->models[i];
+        if (model->pending || model->running || model->delivering) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void network_scheduler_dispatch(network_scheduler_t *scheduler) {
+    if (scheduler->active) {
+        return;
+    }
+
+    network_model_t *next = NULL;
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_model_t *model = scheduler->models[i];
+        if (!model->pending || model->delivering) {
+            continue;
+        }
+
+        if (next == NULL
+            || model->config.priority > next->config.priority
+            || (model->config.priority == next->config.priority && model->pending->id < next->pending->id)
+        ) {
+            next = model;
+        }
+    }
+
+    if (next == NULL) {
+        return;
+    }
+
+    next->running = next->pending;
+    next->pending = NULL;
+    next->start_time = time_get_us();
+    scheduler->active = next;
+
+    // The input is outside the arena, the output is copied to its beginning
+    network_run_async(
+        next->config.network, next->running->input, scheduler->l2_arena,
+        scheduler->l2_arena, scheduler->l2_arena_size, scheduler->cluster,
+        pi_task_callback(&next->input_task, network_scheduler_input_consumed, next),
+        pi_task_callback(&scheduler->network_done, network_scheduler_network_done, scheduler)
+    );
+}
+
+static void network_scheduler_input_consumed(void *arg) {
+    network_model_t *model = (network_model_t *)arg;
+
+    network_scheduler_release_frame(model->running);
+}
+
+static void network_scheduler_network_done(void *arg) {
+    network_scheduler_t *scheduler = (network_scheduler_t *)arg;
+    network_model_t *model = scheduler->active;
+    const network_t *network = model->config.network;
+    network_model_stats_t *stats = &model->stats;
+
+    uint32_t now = time_get_us();
+
+    // Dequantize before the arena is reused by the next model
+    network_dequantize_output(network, scheduler->l2_arena, model->output);
+    model->frame_id = model->running->id;
+    model->frame_timestamp = model->running->timestamp;
+
+    stats->n_runs++;
+    stats->latency_last = now - model->running->timestamp;
+    stats->latency_min = MIN(stats->latency_min, stats->latency_last);
+    stats->latency_max = MAX(stats->latency_max, stats->latency_last);
+    stats->latency_sum += stats->latency_last;
+    stats->exec_last = now - model->start_time;
+    stats->exec_sum += stats->exec_last;
+    stats->cycles_last = network->state->cycles;
+
+    model->running = NULL;
+    scheduler->active = NULL;
+
+    if (model->config.callback) {
+        model->delivering = true;
+        co_fn_push_start(
+            &model->callback_ctx, model->config.callback, model,
+            pi_task_callback(&model->callback_task, network_scheduler_callback_done, model)
+        );
+    }
+
+    network_scheduler_dispatch(scheduler);
+}
+
+static void network_scheduler_callback_done(void *arg) {
+    network_model_t *model = (network_model_t *)arg;
+
+    model->delivering = false;
+    network_scheduler_dispatch(model->scheduler);
+}
+
+void network_scheduler_print_stats(network_scheduler_t *scheduler) {
+    printf("%-16s %4s %6s %6s %6s %6s %9s %9s %9s %9s %9s\n",
+        "model", "prio", "period", "due", "runs", "drop", "lat avg", "lat min", "lat max", "exec avg", "cycles"
+    );
+
+    for (int i = 0; i < scheduler->n_models; i++) {
+        network_model_t *model = scheduler->models[i];
+        network_model_stats_t *stats = &model->stats;
+        uint32_t n_runs = MAX(stats->n_runs, 1);
+
+        printf("%-16s %4d %6d %6d %6d %6d %6d us %6d us %6d us %6d us %9d\n",
+            model->config.name, model->config.priority, model->config.period,
+            stats->n_due, stats->n_runs, stats->n_dropped,
+            (uint32_t)(stats->latency_sum / n_runs), stats->n_runs ? stats->latency_min : 0, stats->latency_max,
+            (uint32_t)(stats->exec_sum / n_runs), stats->cycles_last
+        );
+    }
+}
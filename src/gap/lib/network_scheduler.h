@@ -0,0 +1,155 @@
+/*
+ * network_scheduler.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * NETWORK SCHEDULER
+ *
+ * Time-shares the cluster among several networks (models) that process the same input frames,
+ * e.g. a detector and a pose regressor, or several instances of the same network. Each model
+ * runs once every period frames, starting from frame phase, so that models can run at different
+ * rates and their load can be spread over different frames. The cluster runs one network at a
+ * time: whenever it becomes idle, the pending model with the highest priority is started (ties go
+ * to the oldest frame, then to the model added first). Networks are not preempted.
+ *
+ * All models share a single L2 arena for their intermediate activations and weights, sized for
+ * the largest network, because only one of them runs at a time. The arena is accounted against
+ * the L2 budget given at initialization: network_scheduler_add_model fails when a model does not
+ * fit. Inputs are not copied: an input frame must stay valid until the input_done task passed to
+ * network_scheduler_submit is pushed, i.e. after all its models have consumed it.
+ *
+ * A model has at most one pending frame: if it has not started yet when its next frame is
+ * submitted, the older frame is dropped. When a model completes, its output is dequantized to
+ * model->output and the model's callback coroutine is started with the model as argument. The
+ * model is not started again until its callback returns.
+ */
+
+#ifndef __NETWORK_SCHEDULER_H__
+#define __NETWORK_SCHEDULER_H__
+
+#include "coroutine.h"
+#include "network.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NETWORK_SCHEDULER_MAX_MODELS  (4)
+#define NETWORK_SCHEDULER_MAX_OUTPUTS (8)
+
+// A frame can be referenced by each model, plus the one being submitted
+#define NETWORK_SCHEDULER_MAX_FRAMES  (NETWORK_SCHEDULER_MAX_MODELS + 1)
+
+typedef struct network_model_config_s {
+    const char *name;
+    const network_t *network;
+    uint8_t priority;                       // Higher priorities run first
+    uint8_t period;                         // Run once every period frames
+    uint8_t phase;                          // First frame in each period, less than period
+    co_fn_t callback;                       // Started with the network_model_t * when an inference completes
+} network_model_config_t;
+
+typedef struct network_frame_s {
+    uint32_t id;
+    const void *input;
+    uint32_t timestamp;                     // [us]
+    int refs;                               // Models that have not consumed the input yet
+    pi_task_t *input_done;
+} network_frame_t;
+
+typedef struct network_model_stats_s {
+    uint32_t n_due;                         // Frames submitted to the model
+    uint32_t n_runs;
+    uint32_t n_dropped;                     // Frames replaced by a newer one before starting
+
+    // From the frame submission to the completion of the network [us]
+    uint32_t latency_last;
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint64_t latency_sum;
+
+    // Time spent on the cluster [us]
+    uint32_t exec_last;
+    uint64_t exec_sum;
+
+    uint32_t cycles_last;                   // Cluster cycles of the last run
+} network_model_stats_t;
+
+typedef struct network_scheduler_s network_scheduler_t;
+
+typedef struct network_model_s {
+    network_model_config_t config;
+    network_scheduler_t *scheduler;
+
+    network_frame_t *pending;               // Frame waiting for the cluster
+    network_frame_t *running;               // Frame being processed on the cluster
+    bool delivering;                        // Callback running, output must not be overwritten
+    uint32_t start_time;                    // [us]
+
+    pi_task_t input_task;
+    pi_task_t callback_task;
+    co_fn_ctx_t callback_ctx;
+
+    // Output of the last completed inference
+    uint32_t frame_id;
+    uint32_t frame_timestamp;               // [us]
+    float output[NETWORK_SCHEDULER_MAX_OUTPUTS];
+
+    network_model_stats_t stats;
+} network_model_t;
+
+typedef struct network_scheduler_s {
+    pi_device_t *cluster;
+
+    network_model_t *models[NETWORK_SCHEDULER_MAX_MODELS];
+    int n_models;
+
+    // L2 accounting [bytes]
+    size_t l2_budget;
+    size_t l2_arena_size;
+    void *l2_arena;
+
+    network_frame_t frames[NETWORK_SCHEDULER_MAX_FRAMES];
+    uint32_t next_frame_id;
+
+    network_model_t *active;                // Model running on the cluster, NULL if idle
+    pi_task_t network_done;
+} network_scheduler_t;
+
+void network_scheduler_init(network_scheduler_t *scheduler, pi_device_t *cluster, size_t l2_budget);
+
+// Returns 0 on success, -1 if the model does not fit the L2 budget or the configuration is invalid
+int  network_scheduler_add_model(network_scheduler_t *scheduler, network_model_t *model, const network_model_config_t *config);
+
+// Allocates the L2 arena and loads the weights of all models. Returns 0 on success.
+int  network_scheduler_start(network_scheduler_t *scheduler);
+
+// Submits a new input frame to the models that are due on it. Returns the number of such models.
+int  network_scheduler_submit(network_scheduler_t *scheduler, const void *input, pi_task_t *input_done);
+
+bool network_scheduler_is_idle(network_scheduler_t *scheduler);
+
+void network_scheduler_print_stats(network_scheduler_t *scheduler);
+
+#endif // __NETWORK_SCHEDULER_H__
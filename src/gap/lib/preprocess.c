@@ -0,0 +1,133 @@
+/*
+ * preprocess.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "preprocess.h"
+
+#include "coroutine.h"
+#include "debug.h"
+#include "utils.h"
+
+#include <pmsis.h>
+
+#include <string.h>
+
+static void preprocess_run_cluster(void *args);
+static void preprocess_run_core(void *args);
+
+void preprocess_init(preprocess_t *preprocess, pi_device_t *cluster, const preprocess_config_t *config) {
+    if (!preprocess_config_valid(config)) {
+        CO_ASSERTION_FAILURE(
+            "Invalid preprocessing configuration (%dx%d crop at %d,%d of %dx%d to %dx%d).\n",
+            config->crop_width, config->crop_height, config->crop_left, config->crop_top,
+            config->src_width, config->src_height, config->dst_width, config->dst_height
+        );
+    }
+
+    preprocess->cluster = cluster;
+    preprocess->config = *config;
+    preprocess->cycles = 0;
+
+    VERBOSE_PRINT(
+        "Preprocess:\t\t\t%d x %dpx -> %d x %dpx, %s%s\n",
+        config->crop_width, config->crop_height, config->dst_width, config->dst_height,
+        config->resize == PREPROCESS_RESIZE_BILINEAR ? "bilinear" : "nearest",
+        config->lut ? " + LUT" : ""
+    );
+}
+
+size_t preprocess_get_output_size(const preprocess_t *preprocess) {
+    return preprocess->config.dst_width * preprocess->config.dst_height;
+}
+
+void preprocess_run_async(preprocess_t *preprocess, const uint8_t *src, uint8_t *dst, pi_task_t *done_task) {
+    preprocess->src = src;
+    preprocess->dst = dst;
+
+    pi_cluster_task(&preprocess->cluster_task, preprocess_run_cluster, preprocess);
+    pi_cluster_send_task_to_cl_async(preprocess->cluster, &preprocess->cluster_task, done_task);
+}
+
+static void preprocess_run_cluster(void *args) {
+    preprocess_t *preprocess = (preprocess_t *)args;
+    const preprocess_config_t *config = &preprocess->config;
+
+    pi_perf_conf(1 << PI_PERF_CYCLES);
+    pi_perf_reset();
+    pi_perf_start();
+
+    int n_cores = pi_cl_cluster_nb_cores();
+    size_t coords_size = config->dst_width * sizeof(preprocess_coord_t);
+    size_t bands_size = n_cores * PREPROCESS_BAND_ROWS * config->dst_width;
+
+    uint8_t *l1_buffer = pmsis_l1_malloc(coords_size + bands_size);
+    if (l1_buffer == NULL) {
+        CO_ASSERTION_FAILURE("Preprocess L1 allocation failed (%dB).\n", coords_size + bands_size);
+    }
+
+    preprocess->n_cores = n_cores;
+    preprocess->x_coords = (preprocess_coord_t *)l1_buffer;
+    preprocess->bands = l1_buffer + coords_size;
+
+    pi_cl_team_fork(n_cores, preprocess_run_core, preprocess);
+
+    pmsis_l1_malloc_free(l1_buffer, coords_size + bands_size);
+
+    pi_perf_stop();
+    preprocess->cycles = pi_perf_read(PI_PERF_CYCLES);
+}
+
+static void preprocess_run_core(void *args) {
+    preprocess_t *preprocess = (preprocess_t *)args;
+    const preprocess_config_t *config = &preprocess->config;
+
+    int core_id = pi_core_id();
+    int n_cores = preprocess->n_cores;
+    int width = config->dst_width;
+    int height = config->dst_height;
+
+    // Column coordinates are shared by all rows, compute them once
+    int cols_per_core = (width + n_cores - 1) / n_cores;
+    int col_start = MIN(core_id * cols_per_core, width);
+    int col_end = MIN(col_start + cols_per_core, width);
+    preprocess_kernel_coords(config, preprocess->x_coords, col_start, col_end);
+
+    pi_cl_team_barrier();
+
+    uint8_t *band = preprocess->bands + core_id * PREPROCESS_BAND_ROWS * width;
+
+    for (int band_start = 0; band_start < height; band_start += n_cores * PREPROCESS_BAND_ROWS) {
+        int row_start = MIN(band_start + core_id * PREPROCESS_BAND_ROWS, height);
+        int row_end = MIN(row_start + PREPROCESS_BAND_ROWS, height);
+
+        preprocess_kernel_rows(config, preprocess->x_coords, preprocess->src, band, row_start, row_end);
+
+        // All cores must be done reading the source rows of this band before any of them
+        // is overwritten, in case the frame is processed in-place
+        pi_cl_team_barrier();
+
+        memcpy(preprocess->dst + row_start * width, band, (row_end - row_start) * width);
+
+        pi_cl_team_barrier();
+    }
+}
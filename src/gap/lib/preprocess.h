@@ -0,0 +1,74 @@
+/*
+ * preprocess.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * CLUSTER IMAGE PREPROCESSING
+ *
+ * Runs the preprocessing kernels (see preprocess_kernels.h) on all cluster cores.
+ * Output rows are split among cores in bands of PREPROCESS_BAND_ROWS rows: each
+ * core computes its rows into an L1 scratch buffer and all cores copy them to the
+ * output after a barrier. This makes it possible to process a frame in-place
+ * (i.e., src == dst), as long as the output is not larger than the crop window.
+ */
+
+#ifndef __PREPROCESS_H__
+#define __PREPROCESS_H__
+
+#include "config.h"
+#include "preprocess_kernels.h"
+
+#include <pmsis.h>
+
+#include <stdint.h>
+
+// Output rows processed by each core between two barriers
+#define PREPROCESS_BAND_ROWS (4)
+
+typedef struct preprocess_s {
+    pi_device_t *cluster;
+    preprocess_config_t config;
+
+    struct pi_cluster_task cluster_task;
+
+    // Arguments of the current run
+    const uint8_t *src;
+    uint8_t *dst;
+
+    // L1 scratch buffers, valid only while running on the cluster
+    int n_cores;
+    preprocess_coord_t *x_coords;
+    uint8_t *bands;
+
+    // Cluster cycles spent in the last run
+    uint32_t cycles;
+} preprocess_t;
+
+void preprocess_init(preprocess_t *preprocess, pi_device_t *cluster, const preprocess_config_t *config);
+
+size_t preprocess_get_output_size(const preprocess_t *preprocess);
+
+// Preprocess the src image into dst on the cluster. src and dst can be the same buffer.
+void preprocess_run_async(preprocess_t *preprocess, const uint8_t *src, uint8_t *dst, pi_task_t *done_task);
+
+#endif // __PREPROCESS_H__
@@ -0,0 +1,138 @@
+/*
+ * preprocess_kernels.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "preprocess_kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+bool preprocess_config_valid(const preprocess_config_t *config) {
+    return config->crop_width > 0 && config->crop_height > 0
+        && config->crop_left + config->crop_width <= config->src_width
+        && config->crop_top + config->crop_height <= config->src_height
+        && config->dst_width > 0 && config->dst_width <= config->crop_width
+        && config->dst_height > 0 && config->dst_height <= config->crop_height
+        && (config->resize == PREPROCESS_RESIZE_NEAREST || config->resize == PREPROCESS_RESIZE_BILINEAR);
+}
+
+preprocess_coord_t preprocess_coord(uint16_t src_size, uint16_t dst_size, uint16_t i, preprocess_resize_e resize) {
+    uint32_t scale = ((uint32_t)src_size << 16) / dst_size;
+
+    // Center of output pixel i in source coordinates [Q16]
+    int32_t center = i * scale + scale / 2;
+
+    if (resize == PREPROCESS_RESIZE_NEAREST) {
+        return (preprocess_coord_t){
+            .index = center >> 16,
+            .weight = 0,
+            .next = 0,
+        };
+    }
+
+    // Bilinear interpolation between the two source pixels around the center
+    int32_t position = center - (1 << 15);
+    if (position < 0) {
+        position = 0;
+    }
+
+    uint16_t index = position >> 16;
+
+    return (preprocess_coord_t){
+        .index = index,
+        .weight = (position >> 8) & 0xff,
+        .next = (index + 1 < src_size) ? 1 : 0,
+    };
+}
+
+void preprocess_kernel_coords(const preprocess_config_t *config, preprocess_coord_t *x_coords, int col_start, int col_end) {
+    for (int x = col_start; x < col_end; x++) {
+        x_coords[x] = preprocess_coord(config->crop_width, config->dst_width, x, config->resize);
+    }
+}
+
+static void preprocess_row_nearest(const preprocess_coord_t *x_coords, const uint8_t *src_row, uint8_t *dst, int width) {
+    for (int x = 0; x < width; x++) {
+        dst[x] = src_row[x_coords[x].index];
+    }
+}
+
+static void preprocess_row_bilinear(
+    const preprocess_coord_t *x_coords, const uint8_t *src_row0, const uint8_t *src_row1,
+    uint8_t weight_y, uint8_t *dst, int width
+) {
+    uint32_t wy1 = weight_y;
+    uint32_t wy0 = 256 - wy1;
+
+    for (int x = 0; x < width; x++) {
+        preprocess_coord_t c = x_coords[x];
+        uint32_t wx1 = c.weight;
+        uint32_t wx0 = 256 - wx1;
+
+        uint32_t top    = src_row0[c.index] * wx0 + src_row0[c.index + c.next] * wx1;
+        uint32_t bottom = src_row1[c.index] * wx0 + src_row1[c.index + c.next] * wx1;
+
+        dst[x] = (top * wy0 + bottom * wy1 + (1 << 15)) >> 16;
+    }
+}
+
+static void preprocess_row_lut(const uint8_t *lut, uint8_t *dst, int width) {
+    for (int x = 0; x < width; x++) {
+        dst[x] = lut[dst[x]];
+    }
+}
+
+void preprocess_kernel_rows(
+    const preprocess_config_t *config, const preprocess_coord_t *x_coords,
+    const uint8_t *src, uint8_t *dst, int row_start, int row_end
+) {
+    const uint8_t *crop = src + config->crop_top * config->src_width + config->crop_left;
+    bool crop_only = (config->dst_width == config->crop_width) && (config->dst_height == config->crop_height);
+
+    for (int y = row_start; y < row_end; y++) {
+        preprocess_coord_t y_coord = preprocess_coord(config->crop_height, config->dst_height, y, config->resize);
+        const uint8_t *src_row0 = crop + y_coord.index * config->src_width;
+
+        if (crop_only) {
+            // Crop only, memmove because dst can overlap the source row when processing in-place
+            memmove(dst, src_row0, config->dst_width);
+        } else if (config->resize == PREPROCESS_RESIZE_NEAREST) {
+            preprocess_row_nearest(x_coords, src_row0, dst, config->dst_width);
+        } else {
+            const uint8_t *src_row1 = src_row0 + y_coord.next * config->src_width;
+            preprocess_row_bilinear(x_coords, src_row0, src_row1, y_coord.weight, dst, config->dst_width);
+        }
+
+        if (config->lut) {
+            preprocess_row_lut(config->lut, dst, config->dst_width);
+        }
+
+        dst += config->dst_width;
+    }
+}
+
+void preprocess_lut_gamma(uint8_t *lut, float gamma) {
+    for (int i = 0; i < 256; i++) {
+        lut[i] = (uint8_t)(255.0f * powf(i / 255.0f, gamma) + 0.5f);
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * preprocess_kernels.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * IMAGE PREPROCESSING KERNELS
+ *
+ * Crop, nearest/bilinear downscale and per-pixel look-up table on 8-bit grayscale
+ * images. The kernels only depend on the C standard library, so that they can be
+ * shared between the cluster implementation in preprocess.c and host-side tests.
+ *
+ * Resizing uses pixel-center alignment and Q16 fixed-point source coordinates,
+ * bilinear interpolation uses Q8 weights and rounds to nearest. Only downscaling is
+ * supported: this guarantees that output row r never overwrites source rows needed
+ * by output rows > r, so that frames can be processed in-place.
+ */
+
+#ifndef __PREPROCESS_KERNELS_H__
+#define __PREPROCESS_KERNELS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    PREPROCESS_RESIZE_NEAREST  = 0,
+    PREPROCESS_RESIZE_BILINEAR = 1,
+} preprocess_resize_e;
+
+typedef struct preprocess_config_s {
+    // Source image, rows are src_width pixels apart
+    uint16_t src_width;
+    uint16_t src_height;
+
+    // Crop window within the source image
+    uint16_t crop_left;
+    uint16_t crop_top;
+    uint16_t crop_width;
+    uint16_t crop_height;
+
+    // Output image, must not be larger than the crop window
+    uint16_t dst_width;
+    uint16_t dst_height;
+
+    preprocess_resize_e resize;
+
+    // Optional 256 entries look-up table applied to each output pixel (NULL to disable)
+    const uint8_t *lut;
+} preprocess_config_t;
+
+// Position of an output pixel in the crop window along one axis
+typedef struct preprocess_coord_s {
+    uint16_t index;     // First source pixel
+    uint8_t weight;     // Bilinear weight of the second source pixel [Q8]
+    uint8_t next;       // Offset of the second source pixel (0 on the last pixel)
+} preprocess_coord_t;
+
+bool preprocess_config_valid(const preprocess_config_t *config);
+
+preprocess_coord_t preprocess_coord(uint16_t src_size, uint16_t dst_size, uint16_t i, preprocess_resize_e resize);
+
+// Compute the coordinates of the output columns in [col_start, col_end)
+void preprocess_kernel_coords(const preprocess_config_t *config, preprocess_coord_t *x_coords, int col_start, int col_end);
+
+// Compute the output rows in [row_start, row_end) into dst, which points to the first
+// of them. x_coords must contain the coordinates of all output columns.
+void preprocess_kernel_rows(
+    const preprocess_config_t *config, const preprocess_coord_t *x_coords,
+    const uint8_t *src, uint8_t *dst, int row_start, int row_end
+);
+
+// Fill a look-up table with a gamma curve, out = 255 * (in / 255)^gamma
+void preprocess_lut_gamma(uint8_t *lut, float gamma);
+
+#endif // __PREPROCESS_KERNELS_H__
@@ -197,35 +197,16 @@ void queue_pop_release(queue_t *q, const void *el) {
 void queue_async_init(queue_async_t *q, int capacity, int el_size) {
     queue_init(&q->q, capacity, el_size);
 
-    co_event_init(&q->queue_free);
-    co_event_push(&q->queue_free);
-
-    co_event_init(&q->queue_ready);
-
     q->push_el = NULL;
+    q->push_task = NULL;
     q->pop_el = NULL;
+    q->pop_task = NULL;
 }
 
 int queue_async_get_count(queue_async_t *q) {
     return queue_get_count(&q->q);
 }
 
-CO_FN_BEGIN(queue_async_push_task, queue_async_t *, q)
-{
-    CO_WAIT(&q->queue_free);
-
-    void **el = q->push_el;
-    
-    *el = queue_push_acquire(&q->q, /* overwrite */ false);
-
-    if (*el == NULL) {
-        QUEUE_ASSERTION_FAILURE("queue_free asserted but queue is full\n");
-    }
-
-    q->push_el = NULL;
-}
-CO_FN_END()
-
 void queue_async_push_acquire(queue_async_t *q, void **el, pi_task_t *done_task) {
     *el = queue_push_acquire(&q->q, /* overwrite */ false);
 
@@ -246,36 +227,33 @@ void queue_async_push_acquire(queue_async_t *q, void **el, pi_task_t *done_task)
         QUEUE_ASSERTION_FAILURE("Another producer already waiting to push\n");
     }
 
-    // Wait for space to free up
+    // Wait for space to free up, completed by queue_async_pop_release
     q->push_el = el;
-    co_event_init(&q->queue_free);
-    co_fn_push_start(&q->push_ctx, queue_async_push_task, q, done_task);
+    q->push_task = done_task;
 }
 
 void queue_async_push_commit(queue_async_t *q, void *el) {
     queue_push_commit(&q->q, el);
-    co_event_push(&q->queue_ready);
-}
 
-void queue_async_push_discard(queue_async_t *q, void *el) {
-    queue_push_discard(&q->q, el);
-}
+    if (q->pop_el == NULL) {
+        return;
+    }
 
-CO_FN_BEGIN(queue_async_pop_task, queue_async_t *, q)
-{
-    CO_WAIT(&q->queue_ready);
-    
-    const void **el = q->pop_el;
-    
-    *el = queue_pop_consume(&q->q);
+    // Hand the element to the consumer waiting
+    const void **pop_el = q->pop_el;
+    *pop_el = queue_pop_consume(&q->q);
 
-    if (*el == NULL) {
-        QUEUE_ASSERTION_FAILURE("queue_ready asserted but queue is empty\n");
+    if (*pop_el == NULL) {
+        QUEUE_ASSERTION_FAILURE("Element committed but queue is empty\n");
     }
 
     q->pop_el = NULL;
+    pi_task_push(q->pop_task);
+}
+
+void queue_async_push_discard(queue_async_t *q, void *el) {
+    queue_push_discard(&q->q, el);
 }
-CO_FN_END()
 
 void queue_async_pop_consume(queue_async_t *q, const void **el, pi_task_t *done_task) {
     *el = queue_pop_consume(&q->q);
@@ -297,13 +275,26 @@ void queue_async_pop_consume(queue_async_t *q, const void **el, pi_task_t *done_
         QUEUE_ASSERTION_FAILURE("Another consumer already waiting to pop\n");
     }
 
-    // Wait for space to free up
+    // Wait for an element, completed by queue_async_push_commit
     q->pop_el = el;
-    co_event_init(&q->queue_ready);
-    co_fn_push_start(&q->pop_ctx, queue_async_pop_task, q, done_task);
+    q->pop_task = done_task;
 }
 
 void queue_async_pop_release(queue_async_t *q, const void *el) {
     queue_pop_release(&q->q, el);
-    co_event_push(&q->queue_free);
+
+    if (q->push_el == NULL) {
+        return;
+    }
+
+    // Hand the free space to the producer waiting
+    void **push_el = q->push_el;
+    *push_el = queue_push_acquire(&q->q, /* overwrite */ false);
+
+    if (*push_el == NULL) {
+        QUEUE_ASSERTION_FAILURE("Element released but queue is full\n");
+    }
+
+    q->push_el = NULL;
+    pi_task_push(q->push_task);
 }
@@ -54,6 +54,7 @@ typedef struct queue_s {
 } queue_t;
 
 void queue_init(queue_t *q, int capacity, int el_size);
+void queue_free(queue_t *q);
 int  queue_get_count(queue_t *q);
 
 // Push a new element to the queue. If the queue is full and overwrite is set, the
@@ -75,20 +76,21 @@ void queue_pop_release(queue_t *q, const void *el);
 /*
  * ASYNC QUEUE
  *
- *  Single-producer single-consumer asynchronous queue
+ *  Single-producer single-consumer asynchronous queue. A producer waiting for space
+ *  or a consumer waiting for an element is handed its element directly by the
+ *  release or commit that makes it available, which then pushes its done_task.
  */
 
 typedef struct queue_async_s {
     queue_t q;
 
-    co_event_t queue_free;
-    co_event_t queue_ready;
-
-    co_fn_ctx_t push_ctx;
+    // Producer waiting for space, NULL if none
     void **push_el;
+    pi_task_t *push_task;
 
-    co_fn_ctx_t pop_ctx;
+    // Consumer waiting for an element, NULL if none
     const void **pop_el;
+    pi_task_t *pop_task;
 } queue_async_t;
 
 void queue_async_init(queue_async_t *q, int capacity, int el_size);
@@ -0,0 +1,293 @@
+/*
+ * queue_mpmc.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+// See: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+#include "queue_mpmc.h"
+
+#include "config.h"
+
+#include <pmsis.h>
+
+#include <string.h>
+
+#define QUEUE_PRINT(...) printf(__VA_ARGS__)
+#define QUEUE_ASSERTION_FAILURE(...)                            \
+    ({                                                          \
+        QUEUE_PRINT("[ASSERT %s:%d] ", __FUNCTION__, __LINE__); \
+        QUEUE_PRINT(__VA_ARGS__);                               \
+        pmsis_exit(-1);                                         \
+    })
+
+// A load from this alias of a cluster L1 word returns it and atomically sets it to -1
+#define QUEUE_MPMC_TAS_BIT (1 << 20)
+
+#define QUEUE_MPMC_BARRIER() __asm__ volatile ("" : : : "memory")
+
+static inline int queue_mpmc_lock(queue_mpmc_t *q) {
+    int irq = disable_irq();
+
+    while (*(volatile int32_t *)((uint32_t)q->lock | QUEUE_MPMC_TAS_BIT) == -1) {
+    }
+
+    QUEUE_MPMC_BARRIER();
+    return irq;
+}
+
+static inline void queue_mpmc_unlock(queue_mpmc_t *q, int irq) {
+    QUEUE_MPMC_BARRIER();
+    *q->lock = 0;
+
+    restore_irq(irq);
+}
+
+// With the lock held, returns the slot for the next push, NULL if it still holds an element
+static void *queue_mpmc_claim_push(queue_mpmc_t *q, uint32_t *pos) {
+    uint32_t head = q->head;
+    if (q->seq[head & (q->capacity - 1)] != head) {
+        return NULL;
+    }
+
+    q->head = head + 1;
+    *pos = head;
+    return q->buffer + (head & (q->capacity - 1)) * q->el_size;
+}
+
+// With the lock held, returns the slot for the next pop, NULL if its element is not written yet
+static void *queue_mpmc_claim_pop(queue_mpmc_t *q, uint32_t *pos) {
+    uint32_t tail = q->tail;
+    if (q->seq[tail & (q->capacity - 1)] != tail + 1) {
+        return NULL;
+    }
+
+    q->tail = tail + 1;
+    *pos = tail;
+    return q->buffer + (tail & (q->capacity - 1)) * q->el_size;
+}
+
+// The element is written, the slot can be popped
+static inline void queue_mpmc_publish_push(queue_mpmc_t *q, uint32_t pos) {
+    QUEUE_MPMC_BARRIER();
+    q->seq[pos & (q->capacity - 1)] = pos + 1;
+}
+
+// The element is read, the slot can be pushed in the next lap
+static inline void queue_mpmc_publish_pop(queue_mpmc_t *q, uint32_t pos) {
+    QUEUE_MPMC_BARRIER();
+    q->seq[pos & (q->capacity - 1)] = pos + q->capacity;
+}
+
+static void queue_mpmc_complete(pi_task_t *task) {
+    if (pi_is_fc()) {
+        pi_task_push(task);
+    } else {
+        pi_cl_send_task_to_fc(task);
+    }
+}
+
+// Complete the FC operations waiting, if the last push or pop made them possible, then wake up
+// the cluster cores waiting. The waiters are checked with the lock held, the FC registers them
+// with the lock held after a failed attempt.
+static void queue_mpmc_notify(queue_mpmc_t *q) {
+    bool progress = true;
+
+    while (progress) {
+        uint32_t push_pos, pop_pos;
+        int irq = queue_mpmc_lock(q);
+
+        queue_mpmc_waiter_t push_waiter = q->push_waiter;
+        void *push_slot = push_waiter.task ? queue_mpmc_claim_push(q, &push_pos) : NULL;
+        if (push_slot) {
+            q->push_waiter.task = NULL;
+        }
+
+        queue_mpmc_waiter_t pop_waiter = q->pop_waiter;
+        void *pop_slot = pop_waiter.task ? queue_mpmc_claim_pop(q, &pop_pos) : NULL;
+        if (pop_slot) {
+            q->pop_waiter.task = NULL;
+        }
+
+        queue_mpmc_unlock(q, irq);
+
+        if (push_slot) {
+            memcpy(push_slot, push_waiter.el, q->el_size);
+            queue_mpmc_publish_push(q, push_pos);
+            queue_mpmc_complete(push_waiter.task);
+        }
+
+        if (pop_slot) {
+            memcpy(pop_waiter.el, pop_slot, q->el_size);
+            queue_mpmc_publish_pop(q, pop_pos);
+            queue_mpmc_complete(pop_waiter.task);
+        }
+
+        // Completing one may have made the other possible
+        progress = push_slot || pop_slot;
+    }
+
+    // Events are buffered by each core, one triggered between its last attempt and its sleep
+    // wakes it up immediately
+    if (pi_is_fc()) {
+        eu_evt_trig(eu_evt_trig_cluster_addr(0, QUEUE_MPMC_EVENT), 0xFFFFFFFF);
+    } else {
+        eu_evt_trig(eu_evt_trig_addr(QUEUE_MPMC_EVENT), 0xFFFFFFFF);
+    }
+}
+
+void queue_mpmc_init(queue_mpmc_t *q, pi_device_t *cluster, int capacity, int el_size, bool buffer_l1) {
+    if (capacity <= 0 || (capacity & (capacity - 1)) != 0) {
+        QUEUE_ASSERTION_FAILURE("Queue capacity must be a power of two\n");
+    }
+
+    q->cluster = cluster;
+    q->capacity = capacity;
+    q->el_size = el_size;
+    q->buffer_l1 = buffer_l1;
+
+    q->head = 0;
+    q->tail = 0;
+    q->push_waiter = (queue_mpmc_waiter_t){0};
+    q->pop_waiter = (queue_mpmc_waiter_t){0};
+
+    q->lock = pi_cl_l1_malloc(cluster, (capacity + 1) * sizeof(uint32_t));
+    q->buffer = buffer_l1 ? pi_cl_l1_malloc(cluster, capacity * el_size) : pi_l2_malloc(capacity * el_size);
+
+    if (!q->lock || !q->buffer) {
+        QUEUE_ASSERTION_FAILURE("Queue buffer allocation failed\n");
+    }
+
+    *q->lock = 0;
+    q->seq = (volatile uint32_t *)(q->lock + 1);
+    for (int i = 0; i < capacity; i++) {
+        q->seq[i] = i;
+    }
+}
+
+void queue_mpmc_free(queue_mpmc_t *q) {
+    pi_cl_l1_free(q->cluster, (void *)q->lock, (q->capacity + 1) * sizeof(uint32_t));
+
+    if (q->buffer_l1) {
+        pi_cl_l1_free(q->cluster, q->buffer, q->capacity * q->el_size);
+    } else {
+        pi_l2_free(q->buffer, q->capacity * q->el_size);
+    }
+}
+
+int queue_mpmc_get_count(queue_mpmc_t *q) {
+    return (int32_t)(q->head - q->tail);
+}
+
+bool queue_mpmc_try_push(queue_mpmc_t *q, const void *el) {
+    uint32_t pos;
+    int irq = queue_mpmc_lock(q);
+    void *slot = queue_mpmc_claim_push(q, &pos);
+    queue_mpmc_unlock(q, irq);
+
+    if (!slot) {
+        return false;
+    }
+
+    memcpy(slot, el, q->el_size);
+    queue_mpmc_publish_push(q, pos);
+    queue_mpmc_notify(q);
+    return true;
+}
+
+bool queue_mpmc_try_pop(queue_mpmc_t *q, void *el) {
+    uint32_t pos;
+    int irq = queue_mpmc_lock(q);
+    void *slot = queue_mpmc_claim_pop(q, &pos);
+    queue_mpmc_unlock(q, irq);
+
+    if (!slot) {
+        return false;
+    }
+
+    memcpy(el, slot, q->el_size);
+    queue_mpmc_publish_pop(q, pos);
+    queue_mpmc_notify(q);
+    return true;
+}
+
+void queue_mpmc_cl_push(queue_mpmc_t *q, const void *el) {
+    while (!queue_mpmc_try_push(q, el)) {
+        eu_evt_maskWaitAndClr(1 << QUEUE_MPMC_EVENT);
+    }
+}
+
+void queue_mpmc_cl_pop(queue_mpmc_t *q, void *el) {
+    while (!queue_mpmc_try_pop(q, el)) {
+        eu_evt_maskWaitAndClr(1 << QUEUE_MPMC_EVENT);
+    }
+}
+
+void queue_mpmc_push_async(queue_mpmc_t *q, const void *el, pi_task_t *done_task) {
+    uint32_t pos;
+    int irq = queue_mpmc_lock(q);
+    void *slot = queue_mpmc_claim_push(q, &pos);
+    if (!slot) {
+        if (q->push_waiter.task != NULL) {
+            queue_mpmc_unlock(q, irq);
+            QUEUE_ASSERTION_FAILURE("Another FC producer already waiting to push\n");
+        }
+
+        // Registered with the lock held, so that the next pop sees it
+        q->push_waiter = (queue_mpmc_waiter_t){ .el = (void *)el, .task = done_task };
+    }
+    queue_mpmc_unlock(q, irq);
+
+    if (!slot) {
+        return;
+    }
+
+    memcpy(slot, el, q->el_size);
+    queue_mpmc_publish_push(q, pos);
+    queue_mpmc_notify(q);
+    pi_task_push(done_task);
+}
+
+void queue_mpmc_pop_async(queue_mpmc_t *q, void *el, pi_task_t *done_task) {
+    uint32_t pos;
+    int irq = queue_mpmc_lock(q);
+    void *slot = queue_mpmc_claim_pop(q, &pos);
+    if (!slot) {
+        if (q->pop_waiter.task != NULL) {
+            queue_mpmc_unlock(q, irq);
+            QUEUE_ASSERTION_FAILURE("Another FC consumer already waiting to pop\n");
+        }
+
+        // Registered with the lock held, so that the next push sees it
+        q->pop_waiter = (queue_mpmc_waiter_t){ .el = el, .task = done_task };
+    }
+    queue_mpmc_unlock(q, irq);
+
+    if (!slot) {
+        return;
+    }
+
+    memcpy(el, slot, q->el_size);
+    queue_mpmc_publish_pop(q, pos);
+    queue_mpmc_notify(q);
+    pi_task_push(done_task);
+}
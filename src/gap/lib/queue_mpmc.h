@@ -0,0 +1,110 @@
+/*
+ * queue_mpmc.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * MPMC QUEUE
+ *
+ * Multi-producer multi-consumer FIFO queue shared by the FC and the cluster cores, to hand work
+ * over without a pi_cluster_send_task round trip for each item. Elements are copied in and out of
+ * a circular buffer in L2 or cluster L1, each slot has a sequence number that tells whether it is
+ * free or holds an element of the current lap (D. Vyukov's bounded MPMC queue).
+ *
+ * GAP8 has no compare-and-swap: producers and consumers claim a slot by taking a test-and-set
+ * lock in cluster L1, which only covers reading and incrementing the head or the tail. Elements
+ * are copied after the lock is released, so the lock is held for a few instructions, whatever the
+ * size of the element, and a slow core only delays the readers of its own slot.
+ *
+ *  - queue_mpmc_try_push/pop: never wait, from the FC or the cluster.
+ *  - queue_mpmc_cl_push/pop: the cluster core sleeps on the QUEUE_MPMC_EVENT software event
+ *    until the operation succeeds, each push and pop triggers it on all cluster cores.
+ *  - queue_mpmc_push/pop_async: the FC registers the operation and its done_task, which is
+ *    completed by the core that makes it possible, from the cluster with pi_cl_send_task_to_fc.
+ *    At most one FC push and one FC pop can wait at the same time, el must stay valid until then.
+ *
+ * The cluster must stay open as long as the queue is used. The queue itself and the elements of
+ * the FC operations must be accessible from the cluster (L2 or cluster L1). Not to be used from
+ * interrupt handlers, the lock is taken with the interrupts disabled.
+ */
+
+#ifndef __QUEUE_MPMC_H__
+#define __QUEUE_MPMC_H__
+
+#include "config.h"
+
+#include <pmsis.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Cluster software event used to wake up the cores waiting on a queue, must not be used by PMSIS
+#ifndef QUEUE_MPMC_EVENT
+#define QUEUE_MPMC_EVENT (7)
+#endif
+
+typedef struct queue_mpmc_waiter_s {
+    void *el;
+    pi_task_t *task;
+} queue_mpmc_waiter_t;
+
+typedef struct queue_mpmc_s {
+    pi_device_t *cluster;
+
+    uint32_t capacity;                  // Power of two
+    uint32_t el_size;
+    bool buffer_l1;
+
+    // Protected by the lock
+    uint32_t head;                      // Next slot to push
+    uint32_t tail;                      // Next slot to pop
+    queue_mpmc_waiter_t push_waiter;    // FC operations waiting
+    queue_mpmc_waiter_t pop_waiter;
+
+    // Cluster L1: the lock, followed by the sequence number of each slot
+    volatile int32_t *lock;
+    volatile uint32_t *seq;
+
+    uint8_t *buffer;
+} queue_mpmc_t;
+
+// Called from the FC after the cluster is opened, the buffer is allocated in cluster L1 if
+// buffer_l1 is set, in L2 otherwise
+void queue_mpmc_init(queue_mpmc_t *q, pi_device_t *cluster, int capacity, int el_size, bool buffer_l1);
+void queue_mpmc_free(queue_mpmc_t *q);
+
+// Elements pushed and not popped yet, only a snapshot when other cores are using the queue
+int queue_mpmc_get_count(queue_mpmc_t *q);
+
+// Copy an element in or out of the queue, false if the queue is full or empty
+bool queue_mpmc_try_push(queue_mpmc_t *q, const void *el);
+bool queue_mpmc_try_pop(queue_mpmc_t *q, void *el);
+
+// Cluster cores only, wait until the element has been pushed or popped
+void queue_mpmc_cl_push(queue_mpmc_t *q, const void *el);
+void queue_mpmc_cl_pop(queue_mpmc_t *q, void *el);
+
+// FC only, done_task is pushed once the element has been pushed or popped
+void queue_mpmc_push_async(queue_mpmc_t *q, const void *el, pi_task_t *done_task);
+void queue_mpmc_pop_async(queue_mpmc_t *q, void *el, pi_task_t *done_task);
+
+#endif // __QUEUE_MPMC_H__
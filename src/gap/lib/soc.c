@@ -36,6 +36,8 @@
 #define pi_fll_set_frequency(x, y, z) ( rt_freq_set(x, y) )
 #endif
 
+static uint16_t soc_voltage = SOC_VOLTAGE;
+
 void soc_init(void) {
     pi_pmu_set_voltage(SOC_VOLTAGE, 1);
     pi_time_wait_us(100000);
@@ -49,3 +51,27 @@ void soc_init(void) {
         SOC_VOLTAGE/1000.f, pi_freq_get(PI_FREQ_DOMAIN_FC)/1000000, pi_freq_get(PI_FREQ_DOMAIN_CL)/1000000
     );
 }
+
+int soc_set_operating_point(uint16_t voltage, uint32_t freq_cl) {
+    // The FLL and the PMU check that the frequencies are supported at the voltage: raise the
+    // voltage before the frequency, lower it after
+    if (voltage > soc_voltage && pi_pmu_set_voltage(voltage, 1)) {
+        return -1;
+    }
+
+    if (pi_fll_set_frequency(FLL_CLUSTER, freq_cl, 1) < 0) {
+        pi_pmu_set_voltage(soc_voltage, 1);
+        return -1;
+    }
+
+    if (voltage < soc_voltage && pi_pmu_set_voltage(voltage, 1)) {
+        voltage = soc_voltage;
+    }
+
+    soc_voltage = voltage;
+    return 0;
+}
+
+uint16_t soc_get_voltage(void) {
+    return soc_voltage;
+}
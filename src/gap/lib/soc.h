@@ -25,6 +25,15 @@
 #ifndef __SOC_H__
 #define __SOC_H__
 
+#include <stdint.h>
+
 void soc_init(void);
 
+// Cluster frequency [Hz] and voltage [mV] set between two inferences, e.g. by the DVFS governor
+// (see dvfs.h). Returns -1 and keeps the previous voltage if one of the two cannot be set.
+int soc_set_operating_point(uint16_t voltage, uint32_t freq_cl);
+
+// Voltage set by soc_init or by the latest soc_set_operating_point [mV]
+uint16_t soc_get_voltage(void);
+
 #endif // __SOC_H__
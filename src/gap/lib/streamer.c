@@ -185,6 +185,8 @@ void streamer_send_frame_async(
     state_msg_t *state, uint32_t state_timestamp,
     tof_msg_t *tof, uint32_t tof_timestamp,
     inference_stamped_msg_t *inference,
+    streamer_profile_t *profile,
+    streamer_dvfs_t *dvfs,
     pi_task_t *done_task
 ) {
 #if defined(STREAMER_DISABLE) || defined(__PLATFORM_GVSOC__)
@@ -202,8 +204,8 @@ void streamer_send_frame_async(
     frame->payload->metadata = (streamer_metadata_t){
         .metadata_version = STREAMER_METADATA_VERSION,
 
-        .frame_height = CAMERA_CROP_HEIGHT, // TODO: get from camera frame
-        .frame_width = CAMERA_CROP_WIDTH,
+        .frame_height = camera_frame->height,
+        .frame_width = camera_frame->width,
         .frame_bpp = CAMERA_CROP_BPP,
         .frame_format = STREAMER_FORMAT_GRAY_8,
         .frame_id = camera_frame->frame_id,
@@ -218,60 +220,58 @@ void streamer_send_frame_async(
         .reply_frame_timestamp = streamer->reply_frame_timestamp,
         .reply_recv_timestamp = streamer->reply_recv_timestamp,
 
-        .inference = *inference
+        .inference = *inference,
+
+        .profile = profile ? *profile : (streamer_profile_t){ .layer_id = STREAMER_PROFILE_NONE },
+
+        .dvfs = dvfs ? *dvfs : (streamer_dvfs_t){ .mode = STREAMER_DVFS_NONE },
     };
 
-    co_fn_push_start(&frame->send_ctx, streamer_send_task, (void *)frame, done_task);
+    co_fn_push_start_with_frame(&frame->send_ctx, streamer_send_task, (void *)frame, done_task);
 }
 
-CO_FN_BEGIN(streamer_send_task, streamer_frame_t *, frame)
+CO_FN_BEGIN_WITH_FRAME(streamer_send_task, streamer_frame_t *, frame, streamer_send_task_frame_t, locals)
 {
-    // Only one send at a time must be inside this critical section, so static variables can be used
-    static streamer_t *streamer;
-    static ssize_t frame_size;
-    static streamer_packet_t *packet;
-
+    // Each streamer must send one frame at a time, its frames share cpx_req and cpx_done
     trace_set(TRACE_STREAMER_SEND, true);
 
-    streamer = frame->streamer;
-    frame_size = streamer_frame_get_size(frame);
+    locals->streamer = frame->streamer;
+    locals->frame_size = streamer_frame_get_size(frame);
 
 #ifdef STREAMER_SEND_CHECKSUM
-    uint32_t checksum = streamer_compute_checksum(frame->payload, frame_size);
+    uint32_t checksum = streamer_compute_checksum(frame->payload, locals->frame_size);
 #else
     uint32_t checksum = 0;
 #endif
 
-    static uint8_t *packet_payload;
-    static ssize_t remaining_length;
-    static uint16_t packet_length;
+    locals->packet_payload = (uint8_t *)frame->payload;
+    locals->remaining_length = locals->frame_size;
 
-    packet_payload = (uint8_t *)frame->payload;
-    remaining_length = frame_size;
+    while (locals->remaining_length > 0) {
+        streamer_packet_t *packet;
 
-    while (remaining_length > 0) {
-        if (remaining_length == frame_size) {
-            packet = streamer_packet_init(streamer->cpx_req, STREAMER_CMD_BUFFER_BEGIN);
+        if (locals->remaining_length == locals->frame_size) {
+            packet = streamer_packet_init(locals->streamer->cpx_req, STREAMER_CMD_BUFFER_BEGIN);
             packet->begin = (streamer_begin_t){
                 .type = STREAMER_TYPE_IMAGE,
-                .size = frame_size,
+                .size = locals->frame_size,
                 .checksum = checksum
             };
         } else {
-            packet = streamer_packet_init(streamer->cpx_req, STREAMER_CMD_BUFFER_DATA);
+            packet = streamer_packet_init(locals->streamer->cpx_req, STREAMER_CMD_BUFFER_DATA);
         }
 
-        packet_length = MIN(remaining_length, cpx_send_req_max_tail_length(streamer->cpx_req));
-        if (packet_length == remaining_length && (packet_length % 4) != 0) {
-            packet_length += 4 - (packet_length % 4);
+        locals->packet_length = MIN(locals->remaining_length, cpx_send_req_max_tail_length(locals->streamer->cpx_req));
+        if (locals->packet_length == locals->remaining_length && (locals->packet_length % 4) != 0) {
+            locals->packet_length += 4 - (locals->packet_length % 4);
         }
 
-        cpx_send_req_set_tail(streamer->cpx_req, packet_payload, packet_length);
-        cpx_send_async(streamer->cpx, streamer->cpx_req, co_event_init(&streamer->cpx_done));
-        CO_WAIT(&streamer->cpx_done);
+        cpx_send_req_set_tail(locals->streamer->cpx_req, locals->packet_payload, locals->packet_length);
+        cpx_send_async(locals->streamer->cpx, locals->streamer->cpx_req, co_event_init(&locals->streamer->cpx_done));
+        CO_WAIT(&locals->streamer->cpx_done);
 
-        packet_payload += packet_length;
-        remaining_length -= packet_length;
+        locals->packet_payload += locals->packet_length;
+        locals->remaining_length -= locals->packet_length;
     }
 
     trace_set(TRACE_STREAMER_SEND, false);
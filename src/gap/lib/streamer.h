@@ -39,7 +39,56 @@ typedef enum {
     STREAMER_FORMAT_GRAY_8 = 0
 } __attribute__((packed)) streamer_format_e;
 
-#define STREAMER_METADATA_VERSION 10
+#define STREAMER_PROFILE_NONE   (0xFF)
+#define STREAMER_PROFILE_EVENTS (8)
+
+// Profile of one layer of the onboard network, a different layer is sent with each frame. The
+// fields mirror network_profile_layer_t in the network's network.h, events in the same order.
+typedef struct streamer_profile_s {
+    // Layer of this record, STREAMER_PROFILE_NONE if the network is not profiled
+    uint8_t layer_id;
+    uint8_t n_layers;
+    uint8_t n_cores;
+    uint8_t _padding;
+
+    // Inferences profiled so far
+    uint32_t n_runs;
+
+    // Static properties of the layer
+    uint32_t macs;
+    uint32_t l2_bytes;                      // Input, output and weights tiled from L2 to L1
+    uint32_t l3_bytes;                      // Weights copied from L3 to L2 at each inference
+
+    // Core 0 performance counters [cycles, events]
+    uint32_t cycles;
+    uint32_t dma_wait_cycles;
+    uint32_t l3_cycles;
+    uint32_t events[STREAMER_PROFILE_EVENTS];
+    uint32_t events_valid;                  // Bitmask of the events sampled at least once
+} __attribute__((packed)) streamer_profile_t;
+
+#define STREAMER_DVFS_NONE      (0xFF)
+
+// Cluster operating point chosen by the DVFS governor (see dvfs.h)
+typedef struct streamer_dvfs_s {
+    // dvfs_mode_e of the governor, STREAMER_DVFS_NONE if there is no governor
+    uint8_t mode;
+    uint8_t level;
+
+    // Operating point [mV, MHz]
+    uint16_t voltage;
+    uint16_t freq_fc;
+    uint16_t freq_cl;
+
+    // Frame period and cluster time of the latest inference [us]
+    uint32_t period;
+    uint32_t busy;
+
+    // Inferences longer than the period so far
+    uint32_t n_misses;
+} __attribute__((packed)) streamer_dvfs_t;
+
+#define STREAMER_METADATA_VERSION 13
 typedef struct streamer_metadata_s {
     // Metadata format version, always equal to STREAMER_METADATA_VERSION
     uint8_t metadata_version;
@@ -74,6 +123,12 @@ typedef struct streamer_metadata_s {
 
     // Latest inference computed onboard by GAP
     inference_stamped_msg_t inference;
+
+    // Profile of the onboard network
+    streamer_profile_t profile;
+
+    // Cluster operating point
+    streamer_dvfs_t dvfs;
 } __attribute__((packed)) streamer_metadata_t;
 
 typedef struct streamer_stats_s {
@@ -95,11 +150,20 @@ typedef struct streamer_payload_s {
 
 typedef struct streamer_s streamer_t;
 
+// Local variables of streamer_send_task, see CO_FN_BEGIN_WITH_FRAME
+typedef struct streamer_send_task_frame_s {
+    streamer_t *streamer;
+    ssize_t frame_size;
+    uint8_t *packet_payload;
+    ssize_t remaining_length;
+    uint16_t packet_length;
+} streamer_send_task_frame_t;
+
 typedef struct streamer_frame_s {
     streamer_payload_t *payload;
     size_t payload_size;
 
-    co_fn_ctx_t send_ctx;
+    CO_FN_CTX_WITH_FRAME(streamer_send_task_frame_t) send_ctx;
     streamer_t *streamer;
 } streamer_frame_t;
 
@@ -145,6 +209,8 @@ void streamer_send_frame_async(
     state_msg_t *state, uint32_t state_timestamp,
     tof_msg_t *tof, uint32_t tof_timestamp,
     inference_stamped_msg_t *inference,
+    streamer_profile_t *profile,            // NULL if the network is not profiled
+    streamer_dvfs_t *dvfs,                  // NULL if there is no DVFS governor
     pi_task_t *done_task
 );
 
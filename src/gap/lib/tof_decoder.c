@@ -0,0 +1,83 @@
+/*
+ * tof_decoder.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "tof_decoder.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+static bool valid_resolution(uint8_t resolution) {
+    return resolution == 16 || resolution == 64;
+}
+
+void tof_decoder_init(tof_decoder_t *decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+void tof_decoder_keyframe(tof_decoder_t *decoder, uint8_t resolution, uint8_t sequence, const uint8_t *data) {
+    decoder->valid = valid_resolution(resolution);
+    decoder->resolution = resolution;
+    decoder->sequence = sequence;
+
+    if (decoder->valid) {
+        memcpy(decoder->data, data, resolution);
+    }
+}
+
+bool tof_decoder_delta(tof_decoder_t *decoder, uint8_t resolution, uint8_t sequence, const uint8_t *payload, uint32_t length) {
+    uint32_t mask_length = resolution / 8;
+
+    bool applicable = decoder->valid
+                   && resolution == decoder->resolution
+                   && sequence == (uint8_t)(decoder->sequence + 1)
+                   && length >= mask_length;
+
+    // Check the payload size before touching the frame, so that a malformed delta leaves it unchanged
+    uint32_t count = 0;
+    if (applicable) {
+        for (uint32_t i = 0; i < mask_length; i++) {
+            count += __builtin_popcount(payload[i]);
+        }
+        applicable = (length == mask_length + count);
+    }
+
+    if (!applicable) {
+        // Wait for the next keyframe
+        decoder->valid = false;
+        decoder->n_dropped += 1;
+        return false;
+    }
+
+    const uint8_t *mask = payload;
+    const uint8_t *values = payload + mask_length;
+    for (uint32_t i = 0; i < resolution; i++) {
+        if (mask[i / 8] & (1 << (i % 8))) {
+            decoder->data[i] = *values++;
+        }
+    }
+
+    decoder->sequence = sequence;
+    return true;
+}
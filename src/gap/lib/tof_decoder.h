@@ -0,0 +1,61 @@
+/*
+ * tof_decoder.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * TOF FRAME DECODER
+ *
+ * Reconstructs the ToF frames delta-coded by the STM32 (tof_encoder.c in the Crazyflie firmware):
+ * a keyframe carries all zones, each following delta only carries the zones that changed, as a
+ * bitmask of resolution / 8 bytes followed by the values of the set zones. Deltas apply to the
+ * frame with the previous sequence number: after a lost or corrupted message, deltas are dropped
+ * until the next keyframe. Only depends on the C standard library, so that it can be tested on
+ * the host.
+ */
+
+#ifndef __TOF_DECODER_H__
+#define __TOF_DECODER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TOF_MAX_ZONES 64
+#define TOF_DELTA_MAX_PAYLOAD (TOF_MAX_ZONES / 8 + TOF_MAX_ZONES)
+
+typedef struct tof_decoder_s {
+    bool valid;
+    uint8_t resolution;
+    uint8_t sequence;
+    uint8_t data[TOF_MAX_ZONES];
+
+    // Deltas that could not be applied
+    uint32_t n_dropped;
+} tof_decoder_t;
+
+void tof_decoder_init(tof_decoder_t *decoder);
+void tof_decoder_keyframe(tof_decoder_t *decoder, uint8_t resolution, uint8_t sequence, const uint8_t *data);
+
+// Returns false if the delta was dropped, decoder->data is left unchanged in that case
+bool tof_decoder_delta(tof_decoder_t *decoder, uint8_t resolution, uint8_t sequence, const uint8_t *payload, uint32_t length);
+
+#endif /* __TOF_DECODER_H__ */
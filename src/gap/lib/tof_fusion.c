@@ -0,0 +1,214 @@
+/*
+ * tof_fusion.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+#include "tof_fusion.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+static void transform_point(const tof_fusion_transform_t *transform, const float src[3], float dst[3]) {
+    for (int i = 0; i < 3; i++) {
+        dst[i] = transform->rotation[i][0] * src[0]
+               + transform->rotation[i][1] * src[1]
+               + transform->rotation[i][2] * src[2]
+               + transform->translation[i];
+    }
+}
+
+static void invert_transform(const tof_fusion_transform_t *transform, tof_fusion_transform_t *inverse) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            inverse->rotation[i][j] = transform->rotation[j][i];
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        inverse->translation[i] = -(inverse->rotation[i][0] * transform->translation[0]
+                                  + inverse->rotation[i][1] * transform->translation[1]
+                                  + inverse->rotation[i][2] * transform->translation[2]);
+    }
+}
+
+// Only done when the ToF resolution changes, since the FC computes in software floating point
+static void compute_rays(tof_fusion_t *fusion, uint8_t resolution) {
+    const tof_fusion_config_t *config = &fusion->config;
+    int side = (resolution == 64) ? 8 : 4;
+    float unit = TOF_FUSION_RANGE_MAX / 255.0f;
+
+    for (int row = 0; row < side; row++) {
+        for (int col = 0; col < side; col++) {
+            // Direction of the zone center in the ToF frame
+            float angle_x = ((col + 0.5f) / side - 0.5f) * config->tof_fov;
+            float angle_y = ((row + 0.5f) / side - 0.5f) * config->tof_fov;
+            float direction[3] = {tanf(angle_x), tanf(angle_y), 1.0f};
+
+            float norm = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + 1.0f);
+            for (int k = 0; k < 3; k++) {
+                direction[k] *= unit / norm;
+            }
+
+            float *ray = fusion->rays[row * side + col];
+            for (int k = 0; k < 3; k++) {
+                ray[k] = config->tof_to_camera.rotation[k][0] * direction[0]
+                       + config->tof_to_camera.rotation[k][1] * direction[1]
+                       + config->tof_to_camera.rotation[k][2] * direction[2];
+            }
+        }
+    }
+
+    // Half size of a zone on the normalized image plane, approximately
+    fusion->zone_margin = tanf(0.5f * config->tof_fov / side);
+    fusion->resolution = resolution;
+}
+
+// Depths are positive, insertion sort is the fastest for at most TOF_MAX_ZONES elements
+static void sort_depths(float *depths, int count) {
+    for (int i = 1; i < count; i++) {
+        float depth = depths[i];
+        int j = i - 1;
+        while (j >= 0 && depths[j] > depth) {
+            depths[j + 1] = depths[j];
+            j--;
+        }
+        depths[j + 1] = depth;
+    }
+}
+
+void tof_fusion_init(tof_fusion_t *fusion, const tof_fusion_config_t *config) {
+    memset(fusion, 0, sizeof(*fusion));
+
+    fusion->config = *config;
+    invert_transform(&config->body_to_camera, &fusion->camera_to_body);
+}
+
+static tof_fusion_status_e tof_fusion_compute(
+    tof_fusion_t *fusion, float position[3],
+    const uint8_t *zones, uint8_t resolution, uint32_t age,
+    tof_fusion_result_t *result
+) {
+    const tof_fusion_config_t *config = &fusion->config;
+
+    float subject[3];
+    transform_point(&config->body_to_camera, position, subject);
+    result->network_depth = subject[2];
+
+    if (age > config->max_age) {
+        return TOF_FUSION_STALE;
+    }
+
+    if (subject[2] <= 0.0f) {
+        return TOF_FUSION_INVALID;
+    }
+
+    if (resolution != 16 && resolution != 64) {
+        return TOF_FUSION_NO_ZONES;
+    }
+
+    if (resolution != fusion->resolution) {
+        compute_rays(fusion, resolution);
+    }
+
+    // Subject box on the normalized image plane, enlarged by half a zone to test the zone centers.
+    // A zone at depth z overlaps the box if |x / z - center_x| <= half_width, tested as
+    // |x - center_x * z| <= half_width * z to avoid a division per zone.
+    float center_x = subject[0] / subject[2];
+    float center_y = subject[1] / subject[2];
+    float half_width = 0.5f * config->subject_width / subject[2] + fusion->zone_margin;
+    float half_height = 0.5f * config->subject_height / subject[2] + fusion->zone_margin;
+
+    const float *origin = config->tof_to_camera.translation;
+
+    float depths[TOF_MAX_ZONES];
+    int count = 0;
+
+    for (int i = 0; i < resolution; i++) {
+        if (zones[i] == TOF_FUSION_ZONE_INVALID) {
+            continue;
+        }
+
+        float range = zones[i];
+        const float *ray = fusion->rays[i];
+
+        float z = range * ray[2] + origin[2];
+        if (z <= 0.0f) {
+            continue;
+        }
+
+        float x = range * ray[0] + origin[0];
+        float y = range * ray[1] + origin[1];
+        if (fabsf(x - center_x * z) <= half_width * z && fabsf(y - center_y * z) <= half_height * z) {
+            depths[count++] = z;
+        }
+    }
+
+    if (count == 0) {
+        return TOF_FUSION_NO_ZONES;
+    }
+
+    // Drop the background around the subject, behind the nearest zone
+    sort_depths(depths, count);
+
+    float foreground_limit = depths[0] + config->foreground_depth;
+    int foreground = 1;
+    while (foreground < count && depths[foreground] <= foreground_limit) {
+        foreground++;
+    }
+
+    result->n_zones = foreground;
+    result->tof_depth = (foreground % 2) ? depths[foreground / 2]
+                                         : 0.5f * (depths[foreground / 2 - 1] + depths[foreground / 2]);
+
+    if (foreground < config->min_zones) {
+        return TOF_FUSION_NO_ZONES;
+    }
+
+    if (fabsf(result->tof_depth - subject[2]) > config->max_deviation) {
+        return TOF_FUSION_REJECTED;
+    }
+
+    // Keep the bearing estimated by the network, which is more accurate than its depth
+    float fused_depth = subject[2] + config->weight * (result->tof_depth - subject[2]);
+    float scale = fused_depth / subject[2];
+    for (int k = 0; k < 3; k++) {
+        subject[k] *= scale;
+    }
+
+    transform_point(&fusion->camera_to_body, subject, position);
+    return TOF_FUSION_FUSED;
+}
+
+tof_fusion_status_e tof_fusion_run(
+    tof_fusion_t *fusion, float position[3],
+    const uint8_t *zones, uint8_t resolution, uint32_t age,
+    tof_fusion_result_t *result
+) {
+    *result = (tof_fusion_result_t){0};
+
+    result->status = tof_fusion_compute(fusion, position, zones, resolution, age, result);
+    fusion->n_status[result->status] += 1;
+
+    return result->status;
+}
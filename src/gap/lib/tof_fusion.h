@@ -0,0 +1,115 @@
+/*
+ * tof_fusion.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+/*
+ * TOF-CAMERA FUSION
+ *
+ * Refines the subject distance estimated by the network with the ToF deck's zones. Each zone is
+ * projected into the camera frame with the calibrated ToF-to-camera extrinsic, using the center of
+ * the zone and its measured range. Zones that overlap a box of subject_width x subject_height
+ * meters, centered on the subject's predicted position, are assumed to see the subject. Among
+ * them, zones more than foreground_depth behind the nearest one are background seen around the
+ * subject. The median depth of the remaining zones validates the network's depth: if it is within
+ * max_deviation, the predicted position is moved along its camera ray to the weighted average of
+ * the two depths, otherwise the prediction is left unchanged.
+ *
+ * Projections are computed on the normalized image plane (x/z, y/z), so the camera intrinsics are
+ * not needed. Zones are in the order of the VL53L5CX results (row-major, resolution 16 or 64), the
+ * actual orientation of the zone grid is part of the extrinsic rotation. Only depends on the C
+ * standard library, so that it can be tested on the host.
+ */
+
+#ifndef __TOF_FUSION_H__
+#define __TOF_FUSION_H__
+
+#include "tof_decoder.h"
+
+#include <stdint.h>
+
+// Range encoding of the ToF messages (see tof.c in the Crazyflie firmware)
+#define TOF_FUSION_RANGE_MAX    (4.0f)  // [m], corresponding to 255
+#define TOF_FUSION_ZONE_INVALID (255)
+
+// Rigid transform, p_dst = rotation * p_src + translation [m]
+typedef struct tof_fusion_transform_s {
+    float rotation[3][3];
+    float translation[3];
+} tof_fusion_transform_t;
+
+typedef struct tof_fusion_config_s {
+    // Camera frame: x right, y down, z along the optical axis
+    tof_fusion_transform_t body_to_camera;  // Frame of the network output to camera frame
+    tof_fusion_transform_t tof_to_camera;   // Calibrated extrinsic, ToF frame has z along its optical axis
+
+    float tof_fov;                          // Horizontal and vertical field of view of the zone grid [rad]
+
+    float subject_width;                    // [m]
+    float subject_height;                   // [m]
+    float foreground_depth;                 // [m]
+    float max_deviation;                    // [m]
+    float weight;                           // Weight of the ToF depth in the fused depth, 0 to 1
+    uint8_t min_zones;                      // Minimum number of foreground zones to fuse
+    uint32_t max_age;                       // ToF frames older than this are not used [us]
+} tof_fusion_config_t;
+
+typedef enum {
+    TOF_FUSION_FUSED    = 0,                // Validated and refined
+    TOF_FUSION_REJECTED = 1,                // ToF and network disagree, prediction unchanged
+    TOF_FUSION_NO_ZONES = 2,                // Not enough valid zones overlap the subject
+    TOF_FUSION_STALE    = 3,                // No recent ToF frame
+    TOF_FUSION_INVALID  = 4,                // Predicted position not in front of the camera
+} tof_fusion_status_e;
+
+typedef struct tof_fusion_s {
+    tof_fusion_config_t config;
+    tof_fusion_transform_t camera_to_body;
+
+    // Zone rays in the camera frame, scaled by the range of one ToF unit: a zone with value v is
+    // at v * rays[i] + config.tof_to_camera.translation
+    uint8_t resolution;
+    float rays[TOF_MAX_ZONES][3];
+    float zone_margin;
+
+    // Statistics, indexed by tof_fusion_status_e
+    uint32_t n_status[TOF_FUSION_INVALID + 1];
+} tof_fusion_t;
+
+typedef struct tof_fusion_result_s {
+    tof_fusion_status_e status;
+    uint8_t n_zones;                        // Foreground zones overlapping the subject
+    float network_depth;                    // Depth of the predicted position in the camera frame [m]
+    float tof_depth;                        // Median depth of the foreground zones [m], valid if n_zones > 0
+} tof_fusion_result_t;
+
+void tof_fusion_init(tof_fusion_t *fusion, const tof_fusion_config_t *config);
+
+// Fuse a network prediction (position in the body frame, x forward [m]) with a ToF frame received
+// age microseconds ago. position is updated in place when the returned status is TOF_FUSION_FUSED.
+tof_fusion_status_e tof_fusion_run(
+    tof_fusion_t *fusion, float position[3],
+    const uint8_t *zones, uint8_t resolution, uint32_t age,
+    tof_fusion_result_t *result
+);
+
+#endif /* __TOF_FUSION_H__ */
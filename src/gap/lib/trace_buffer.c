@@ -27,13 +27,39 @@
 #include "config.h"
 #include "debug.h"
 
+#ifdef TRACE_STREAM
+#include "cpx/cpx.h"
+#endif
+
 #include <pmsis.h>
 
 trace_buffer_t *trace_buffers[TRACE_NUM_CORES] = {};
 
+#ifdef TRACE_STREAM
+// Local variables of trace_stream_task, see CO_FN_BEGIN_WITH_FRAME
+typedef struct trace_stream_task_frame_s {
+    int core_id;
+} trace_stream_task_frame_t;
+
+typedef struct trace_stream_s {
+    cpx_t *cpx;
+    cpx_send_req_t *cpx_req;
+    co_event_t done;
+    CO_FN_CTX_WITH_FRAME(trace_stream_task_frame_t) ctx;
+
+    // Next half to be sent and packet sequence number for each core
+    int next_half[TRACE_NUM_CORES];
+    uint32_t sequence[TRACE_NUM_CORES];
+} trace_stream_t;
+
+static trace_stream_t trace_stream;
+
+CO_FN_DECLARE(trace_stream_task);
+#endif
+
 void trace_buffer_init(int core_id, pi_device_t *cluster) {
     if (trace_buffers[core_id] != NULL) {
-        ASSERTION_FAILURE("Trace buffer for core %d already initialized\n", core_id);
+        CO_ASSERTION_FAILURE("Trace buffer for core %d already initialized\n", core_id);
     }
     
     trace_buffer_t *buffer = NULL;
@@ -42,19 +68,26 @@ void trace_buffer_init(int core_id, pi_device_t *cluster) {
         buffer = pi_fc_l1_malloc(sizeof(trace_buffer_t));
     } else {
         if (cluster == NULL) {
-            ASSERTION_FAILURE("Cluster device required to allocate buffer for core %d\n", core_id);
+            CO_ASSERTION_FAILURE("Cluster device required to allocate buffer for core %d\n", core_id);
         }
         buffer = pi_cl_l1_malloc(cluster, sizeof(trace_buffer_t));
     }
 
     if (buffer == NULL) {
-        ASSERTION_FAILURE("Failed to allocate memory for trace buffer for core %d\n", core_id);
+        CO_ASSERTION_FAILURE("Failed to allocate memory for trace buffer for core %d\n", core_id);
     }
 
     memset(buffer, 0xaa, sizeof(trace_buffer_t));
     buffer->started = false;
     buffer->next_event = 0;
+#ifndef TRACE_STREAM
     buffer->event_count = 0;
+#else
+    buffer->active = 0;
+    buffer->full[0] = false;
+    buffer->full[1] = false;
+    buffer->dropped = 0;
+#endif
 
     trace_buffers[core_id] = buffer;
 }
@@ -63,7 +96,7 @@ void trace_buffer_start() {
     int core_id = pi_core_id();
     trace_buffer_t *t = trace_buffers[core_id];
     if (t == NULL) {
-        ASSERTION_FAILURE("Trace buffer for core %d not initialized\n", core_id);
+        CO_ASSERTION_FAILURE("Trace buffer for core %d not initialized\n", core_id);
     }
 
     if (!t->started) {
@@ -78,6 +111,7 @@ void trace_buffer_start() {
     trace_sync();
 }
 
+#ifndef TRACE_STREAM
 void trace_buffer_dump_core(int core_id) {
     trace_buffer_t *t = trace_buffers[core_id];
     
@@ -96,6 +130,31 @@ void trace_buffer_dump_core(int core_id) {
     DEBUG_PRINT("\n");
     DEBUG_PRINT("\n");
 }
+#else
+static void trace_buffer_dump_events(trace_evt_t *events, int n_events) {
+    for (int i = 0; i < n_events; i++) {
+        DEBUG_PRINT("%016llx,", events[i].data);
+    }
+}
+
+void trace_buffer_dump_core(int core_id) {
+    trace_buffer_t *t = trace_buffers[core_id];
+    
+    if (t == NULL) {
+        return;
+    }
+
+    // Dump the events that were not streamed yet, oldest first
+    int other = t->active ^ 1;
+    int n_other = t->full[other] ? TRACE_STREAM_EVENTS : 0;
+
+    DEBUG_PRINT("core_id=%d,n_events=%d\n", core_id, n_other + t->next_event);
+    trace_buffer_dump_events(t->buffer[other], n_other);
+    trace_buffer_dump_events(t->buffer[t->active], t->next_event);
+    DEBUG_PRINT("\n");
+    DEBUG_PRINT("\n");
+}
+#endif
 
 void trace_buffer_dump() {
     DEBUG_PRINT("=================================\n");
@@ -108,3 +167,81 @@ void trace_buffer_dump() {
     DEBUG_PRINT("END EVENT TRACE DUMP\n");
     DEBUG_PRINT("=================================\n");
 }
+
+#ifdef TRACE_STREAM
+void trace_buffer_stream_start(cpx_t *cpx) {
+    trace_stream.cpx = cpx;
+    trace_stream.cpx_req = cpx_send_req_alloc(
+        sizeof(trace_stream_header_t) + TRACE_STREAM_EVENTS * sizeof(trace_evt_t)
+    );
+    trace_stream.cpx_req->header = CPX_HEADER_INIT(CPX_T_WIFI_HOST, CPX_F_TRACE);
+
+    for (int i = 0; i < TRACE_NUM_CORES; i++) {
+        trace_stream.next_half[i] = 0;
+        trace_stream.sequence[i] = 0;
+    }
+
+    co_fn_push_start_with_frame(&trace_stream.ctx, trace_stream_task, (void *)&trace_stream, NULL);
+}
+
+static void trace_stream_packet_init(trace_stream_t *stream, int core_id, trace_buffer_t *t) {
+    int half = stream->next_half[core_id];
+    
+    // Copy the half to L2, so that the core can reuse it immediately and the SPI can reach
+    // it even when it lives in FC or cluster L1
+    trace_stream_header_t *header = (trace_stream_header_t *)stream->cpx_req->payload;
+    *header = (trace_stream_header_t){
+        .core_id = core_id,
+        .n_events = TRACE_STREAM_EVENTS,
+        .sequence = stream->sequence[core_id],
+        .dropped = t->dropped,
+    };
+
+    // Read the events only after the full flag seen by trace_stream_task
+    TRACE_BARRIER();
+    memcpy(header + 1, t->buffer[half], TRACE_STREAM_EVENTS * sizeof(trace_evt_t));
+
+    // The copy must be complete before the core can reuse the half
+    TRACE_BARRIER();
+    t->full[half] = false;
+    stream->next_half[core_id] = half ^ 1;
+    stream->sequence[core_id] += 1;
+
+    cpx_send_req_set_tail(stream->cpx_req, NULL, 0);
+    cpx_send_req_set_head_length(
+        stream->cpx_req, sizeof(trace_stream_header_t) + TRACE_STREAM_EVENTS * sizeof(trace_evt_t)
+    );
+}
+
+CO_FN_BEGIN_WITH_FRAME(trace_stream_task, trace_stream_t *, stream, trace_stream_task_frame_t, locals)
+{
+    while (true) {
+        for (locals->core_id = 0; locals->core_id < TRACE_NUM_CORES; locals->core_id++) {
+            trace_buffer_t *t = trace_buffers[locals->core_id];
+            if (t == NULL || !t->full[stream->next_half[locals->core_id]]) {
+                continue;
+            }
+
+#if defined(__PLATFORM_GVSOC__)
+            // GVSOC does not support SPIM, recycle the buffer without sending it
+            t->full[stream->next_half[locals->core_id]] = false;
+            stream->next_half[locals->core_id] ^= 1;
+            stream->sequence[locals->core_id] += 1;
+#else
+            // Low priority: only send while the CPX link is idle, retry at the next period otherwise
+            if (!co_event_is_done(&stream->cpx->send_done)) {
+                break;
+            }
+
+            trace_stream_packet_init(stream, locals->core_id, t);
+            cpx_send_async(stream->cpx, stream->cpx_req, co_event_init(&stream->done));
+            CO_WAIT(&stream->done);
+#endif
+        }
+
+        pi_task_push_delayed_us(co_event_init(&stream->done), TRACE_STREAM_PERIOD_US);
+        CO_WAIT(&stream->done);
+    }
+}
+CO_FN_END()
+#endif
@@ -27,12 +27,18 @@
  *
  * Low-overhead event tracing over a circular buffer that can be dumped
  * 
+ * When TRACE_STREAM is defined in config.h, each core instead records events
+ * in two halves of a double buffer. Whenever a half is full, it is handed over 
+ * to trace_stream_task, which sends it to the host as a binary CPX packet 
+ * (function CPX_F_TRACE) while the core keeps recording in the other half. If
+ * both halves are waiting to be sent, new events are dropped and counted.
  */
 
 #ifndef __TRACE_BUFFER_H__
 #define __TRACE_BUFFER_H__
 
 #include "config.h"
+#include "coroutine.h"
 #include "utils.h"
 
 #include <pmsis.h>
@@ -43,8 +49,19 @@
 #define TRACE_EVENTS_BUFFER         (768)
 #define TRACE_EVENTS_PERF_COUNTER   (PI_PERF_CYCLES)
 
+// Events in each half of a streaming buffer, sent in a single CPX packet
+#define TRACE_STREAM_EVENTS         (256)
+// Polling period of trace_stream_task [us]
+#define TRACE_STREAM_PERIOD_US      (10000)
+
 typedef enum trace_evt_e {
     TRACE_EVT_SYNC = 0,
+
+    // Clock synchronization with the other chips (see clock_sync.h)
+    TRACE_EVT_CLOCK_SYNC_STM32   = 0x30,
+    TRACE_EVT_CLOCK_REMOTE_STM32 = 0x31,
+    TRACE_EVT_CLOCK_SYNC_NINA    = 0x32,
+    TRACE_EVT_CLOCK_REMOTE_NINA  = 0x33,
 } __attribute__((packed)) trace_evt_e;
 
 typedef enum trace_state_e {
@@ -65,17 +82,56 @@ typedef struct trace_evt_s {
     };
 } trace_evt_t;
 
+#ifndef TRACE_STREAM
 typedef struct trace_buffer_s {
     bool started;
     int next_event;
     int event_count;
     trace_evt_t buffer[TRACE_EVENTS_BUFFER];
 } trace_buffer_t;
+#else
+typedef struct trace_buffer_s {
+    bool started;
+
+    // Half currently being recorded and next free event in it
+    int active;
+    int next_event;
+
+    // Set by the core when a half is full, cleared by trace_stream_task once sent. The events
+    // of a half are ordered against its flag by TRACE_BARRIER on both sides.
+    volatile bool full[2];
+
+    // Events dropped because both halves were full
+    uint32_t dropped;
+
+    trace_evt_t buffer[2][TRACE_STREAM_EVENTS];
+} trace_buffer_t;
+
+// Header of CPX_F_TRACE packets, followed by n_events trace_evt_t
+typedef struct trace_stream_header_s {
+    uint8_t core_id;
+    uint8_t _padding;
+    uint16_t n_events;
+
+    // Per-core packet sequence number, used by the host to detect lost packets
+    uint32_t sequence;
+
+    // Total events dropped by this core up to this packet
+    uint32_t dropped;
+} __attribute__((packed)) trace_stream_header_t;
+#endif
 
 void trace_buffer_init(int core_id, pi_device_t *cluster);
 void trace_buffer_start();
 void trace_buffer_dump();
 
+#ifdef TRACE_STREAM
+typedef struct cpx_s cpx_t;
+
+// Start streaming full trace buffers to the host over CPX
+void trace_buffer_stream_start(cpx_t *cpx);
+#endif
+
 // Record an event
 static inline void trace_event(trace_evt_e event, trace_state_e state, uint16_t context);
 
@@ -86,19 +142,47 @@ static inline void trace_sync();
 
 extern trace_buffer_t *trace_buffers[TRACE_NUM_CORES];
 
+// Full memory barrier between the cores that record events and the FC that streams them
+#define TRACE_BARRIER() __sync_synchronize()
+
 static inline void trace_push_event(trace_evt_t event) {
     int core_id = pi_core_id();
     trace_buffer_t *t = trace_buffers[core_id];
 
     if (t == NULL) {
-        ASSERTION_FAILURE("Trace buffer for core %d not initialized\n", core_id);
+        CO_ASSERTION_FAILURE("Trace buffer for core %d not initialized\n", core_id);
     } else if (!t->started) {
-        ASSERTION_FAILURE("Trace buffer for core %d not started\n", core_id);
+        CO_ASSERTION_FAILURE("Trace buffer for core %d not started\n", core_id);
     }
 
+#ifndef TRACE_STREAM
     t->buffer[t->next_event] = event;
     t->next_event = (t->next_event + 1) % TRACE_EVENTS_BUFFER;
     t->event_count = MIN(t->event_count + 1, TRACE_EVENTS_BUFFER);
+#else
+    if (t->next_event == TRACE_STREAM_EVENTS) {
+        // The active half has been handed over, switch to the other one if it was already sent
+        int other = t->active ^ 1;
+        if (t->full[other]) {
+            t->dropped += 1;
+            return;
+        }
+
+        // Do not overwrite the half before trace_stream_task has finished copying it
+        TRACE_BARRIER();
+        t->active = other;
+        t->next_event = 0;
+    }
+
+    t->buffer[t->active][t->next_event] = event;
+    t->next_event += 1;
+
+    if (t->next_event == TRACE_STREAM_EVENTS) {
+        // The events must be visible to the FC before the half is marked full
+        TRACE_BARRIER();
+        t->full[t->active] = true;
+    }
+#endif
 }
 
 static inline void trace_event(trace_evt_e event, trace_state_e state, uint16_t context) {
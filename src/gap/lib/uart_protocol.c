@@ -34,100 +34,149 @@
 #include <pmsis.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 
-CO_FN_BEGIN(uart_protocol_task, uart_protocol_t *, protocol)
-{
-    static void *buffer;
-    static uart_msg_t *message;
-    static uint32_t available_length;
-    static uint32_t discarded_length;
-    static uint32_t message_length;
-    static uint32_t total_length;
+// Replace a ToF delta with the reconstructed frame, returns false if it could not be applied
+static bool decode_tof_delta(uart_protocol_t *protocol, uart_msg_t *message) {
+    tof_delta_msg_t *delta = &message->tof_delta;
+    tof_decoder_t *decoder = &protocol->tof_decoder;
+
+    if (!tof_decoder_delta(decoder, delta->resolution, delta->sequence, delta->payload, delta->length)) {
+        return false;
+    }
+
+    memcpy(message->header, UART_TOF_MSG_HEADER, UART_HEADER_LENGTH);
+    message->tof = (tof_msg_t){
+        .resolution = decoder->resolution,
+        .sequence = decoder->sequence,
+    };
+    memcpy(message->tof.data, decoder->data, decoder->resolution);
 
+    return true;
+}
+
+CO_FN_BEGIN_WITH_FRAME(uart_protocol_task, uart_protocol_t *, protocol, uart_protocol_task_frame_t, locals)
+{
     trace_set(TRACE_UART_PROTO_RESYNC, false);
 
     while (true) {
-        buffer = protocol->buffer;
-        available_length = 0;
-        discarded_length = 0;
-        message_length = 0;
+        locals->buffer = protocol->buffer;
+        locals->available_length = 0;
+        locals->discarded_length = 0;
+        locals->message_length = 0;
         
         trace_set(TRACE_UART_PROTO_READ, true);
-        available_length += uart_read_async(protocol->uart, buffer + available_length, UART_READ_SIZE, co_event_init(&protocol->done_event));
+        locals->available_length += uart_read_async(protocol->uart, locals->buffer + locals->available_length, UART_READ_SIZE, co_event_init(&protocol->done_event));
         CO_WAIT(&protocol->done_event);
         trace_set(TRACE_UART_PROTO_READ, false);
 
         do {
-            message = (uart_msg_t *)(protocol->buffer + discarded_length);
+            locals->message = (uart_msg_t *)(protocol->buffer + locals->discarded_length);
 
-            if (memcmp(message->header, UART_STATE_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
-                message_length = sizeof(state_msg_t);
+            if (memcmp(locals->message->header, UART_STATE_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+                locals->message_length = sizeof(state_msg_t);
+                break;
+            } else if (memcmp(locals->message->header, UART_RNG_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+                locals->message_length = sizeof(rng_msg_t);
                 break;
-            } else if (memcmp(message->header, UART_RNG_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
-                message_length = sizeof(rng_msg_t);
+            } else if (memcmp(locals->message->header, UART_TOF_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+                locals->message_length = sizeof(tof_msg_t);
                 break;
-            } else if (memcmp(message->header, UART_TOF_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
-                message_length = sizeof(tof_msg_t);
+            } else if (memcmp(locals->message->header, UART_TOF_DELTA_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+                // Fixed part only, the payload length is known once it has been received
+                locals->message_length = offsetof(tof_delta_msg_t, payload);
+                break;
+            } else if (memcmp(locals->message->header, UART_CLOCK_PONG_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+                locals->message_length = sizeof(clock_sync_msg_t);
                 break;
             }
 
             trace_set(TRACE_UART_PROTO_RESYNC, true);
 
-            discarded_length += 1;
+            locals->discarded_length += 1;
 
-            if ((discarded_length + UART_READ_SIZE) > UART_BUFFER_LENGTH) {
+            if ((locals->discarded_length + UART_READ_SIZE) > UART_BUFFER_LENGTH) {
                 // Give up and start again from the beginning of the buffer
                 break;
             }
 
-            if ((discarded_length + UART_HEADER_LENGTH) > available_length) {
+            if ((locals->discarded_length + UART_HEADER_LENGTH) > locals->available_length) {
                 trace_set(TRACE_UART_PROTO_READ, true);
-                available_length += uart_read_async(protocol->uart, buffer + available_length, UART_READ_SIZE, co_event_init(&protocol->done_event));
+                locals->available_length += uart_read_async(protocol->uart, locals->buffer + locals->available_length, UART_READ_SIZE, co_event_init(&protocol->done_event));
                 CO_WAIT(&protocol->done_event);
                 trace_set(TRACE_UART_PROTO_READ, false);
             }
         } while (true);
 
-        if (!message_length) {
+        if (!locals->message_length) {
             continue;
         }
 
         trace_set(TRACE_UART_PROTO_RESYNC, false);
 
-        total_length = discarded_length + UART_HEADER_LENGTH + message_length + UART_CHECKSUM_LENGTH;
+        locals->total_length = locals->discarded_length + UART_HEADER_LENGTH + locals->message_length + UART_CHECKSUM_LENGTH;
 
-        if (total_length > UART_BUFFER_LENGTH) {
+        if (locals->total_length > UART_BUFFER_LENGTH) {
             // Give up and start again from the beginning of the buffer
             // FIXME: potentially move the received header to the beginning of the buffer instead of simply 
             // dropping a message when discarding too much
             continue;
         }
 
-        int32_t remaining_length = total_length - available_length;
+        int32_t remaining_length = locals->total_length - locals->available_length;
         if (remaining_length > 0) {
             trace_set(TRACE_UART_PROTO_READ, true);
-            available_length += uart_read_async(protocol->uart, buffer + available_length, remaining_length, co_event_init(&protocol->done_event));
+            locals->available_length += uart_read_async(protocol->uart, locals->buffer + locals->available_length, remaining_length, co_event_init(&protocol->done_event));
             CO_WAIT(&protocol->done_event);
             trace_set(TRACE_UART_PROTO_READ, false);
         }
 
-        memmove(&message->checksum, (void *)message + UART_HEADER_LENGTH + message_length, sizeof(uint32_t));
-        message->recv_timestamp = time_get_us();
+        if (memcmp(locals->message->header, UART_TOF_DELTA_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+            if (locals->message->tof_delta.length > TOF_DELTA_MAX_PAYLOAD) {
+                continue;
+            }
+
+            locals->message_length += locals->message->tof_delta.length;
+            locals->total_length += locals->message->tof_delta.length;
 
-        uint32_t checksum = crc32CalculateBuffer(message, UART_HEADER_LENGTH + message_length);
-        if (checksum != message->checksum) {
+            if (locals->total_length > UART_BUFFER_LENGTH) {
+                continue;
+            }
+
+            remaining_length = locals->total_length - locals->available_length;
+            if (remaining_length > 0) {
+                trace_set(TRACE_UART_PROTO_READ, true);
+                locals->available_length += uart_read_async(protocol->uart, locals->buffer + locals->available_length, remaining_length, co_event_init(&protocol->done_event));
+                CO_WAIT(&protocol->done_event);
+                trace_set(TRACE_UART_PROTO_READ, false);
+            }
+        }
+
+        memmove(&locals->message->checksum, (void *)locals->message + UART_HEADER_LENGTH + locals->message_length, sizeof(uint32_t));
+        locals->message->recv_timestamp = time_get_us();
+
+        uint32_t checksum = crc32CalculateBuffer(locals->message, UART_HEADER_LENGTH + locals->message_length);
+        if (checksum != locals->message->checksum) {
             // VERBOSE_PRINT("Received UART message with header '%.4s' and invalid CRC %u (expected %u)\n", message->header, checksum, message->checksum);
             trace_set(TRACE_UART_PROTO_CHKFAIL, true);
             trace_set(TRACE_UART_PROTO_CHKFAIL, false);
             continue;
         }
         
+        if (memcmp(locals->message->header, UART_TOF_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+            tof_decoder_keyframe(&protocol->tof_decoder, locals->message->tof.resolution, locals->message->tof.sequence, locals->message->tof.data);
+        } else if (memcmp(locals->message->header, UART_TOF_DELTA_MSG_HEADER, UART_HEADER_LENGTH) == 0) {
+            if (!decode_tof_delta(protocol, locals->message)) {
+                continue;
+            }
+        }
+
         trace_set(TRACE_UART_PROTO_MESSAGE, true);
-        co_fn_push_start(&protocol->message_ctx, protocol->message_callback, (void *)message, co_event_init(&protocol->done_event));
+        co_fn_push_start(&protocol->message_ctx, protocol->message_callback, (void *)locals->message, co_event_init(&protocol->done_event));
         CO_WAIT(&protocol->done_event);
         trace_set(TRACE_UART_PROTO_MESSAGE, false);
 
-        if (available_length > total_length) {
+        if (locals->available_length > locals->total_length) {
             trace_set(TRACE_UART_PROTO_CHKFAIL, true);
             trace_set(TRACE_UART_PROTO_CHKFAIL, false);
             trace_set(TRACE_UART_PROTO_CHKFAIL, true);
@@ -141,10 +190,15 @@ CO_FN_END()
 void uart_protocol_init(uart_protocol_t *protocol, uart_t* uart, co_fn_t message_callback) {
     protocol->uart = uart;
     protocol->message_callback = message_callback;
+    tof_decoder_init(&protocol->tof_decoder);
+
+    // Resumed before the frame processing, so that the UART RX buffer does not overflow
+    co_fn_set_priority(&protocol->protocol_ctx.ctx, CO_PRIORITY_HIGH);
+    co_fn_set_priority(&protocol->message_ctx, CO_PRIORITY_HIGH);
 }
 
 void uart_protocol_start(uart_protocol_t *protocol) {
-    co_fn_push_start(&protocol->protocol_ctx, uart_protocol_task, (void *)protocol, NULL);
+    co_fn_push_start_with_frame(&protocol->protocol_ctx, uart_protocol_task, (void *)protocol, NULL);
 }
 
 void uart_protocol_send_inference_async(uart_protocol_t *protocol, inference_stamped_msg_t *msg, pi_task_t *done_task) {
@@ -153,3 +207,17 @@ void uart_protocol_send_inference_async(uart_protocol_t *protocol, inference_sta
     protocol->tx_message.inference_stamped = *msg;
     uart_write_async(protocol->uart, &protocol->tx_message, message_size, done_task);
 }
+
+void uart_protocol_send_clock_ping_async(uart_protocol_t *protocol, uint32_t sequence, pi_task_t *done_task) {
+    uint32_t message_size = UART_HEADER_LENGTH + sizeof(clock_sync_msg_t);
+    uart_msg_t *message = &protocol->tx_clock_message;
+
+    memcpy(message->header, UART_CLOCK_PING_MSG_HEADER, UART_HEADER_LENGTH);
+    message->clock_sync = (clock_sync_msg_t){.sequence = sequence};
+
+    // The checksum immediately follows the payload on the wire
+    uint32_t checksum = crc32CalculateBuffer(message, message_size);
+    memcpy((void *)message + message_size, &checksum, UART_CHECKSUM_LENGTH);
+
+    uart_write_async(protocol->uart, message, message_size + UART_CHECKSUM_LENGTH, done_task);
+}
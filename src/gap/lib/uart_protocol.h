@@ -27,6 +27,7 @@
 
 #include "config.h"
 #include "coroutine.h"
+#include "tof_decoder.h"
 #include "utils.h"
 
 #include <pmsis.h>
@@ -72,14 +73,27 @@ typedef struct rng_msg_s {
   uint32_t entropy;
 } __attribute__((packed)) rng_msg_t;
 
+// ToF keyframe, with all zones. Deltas (!TOD) are reconstructed by uart_protocol and delivered
+// to the message callback as keyframes, see tof_decoder.h.
 #define UART_TOF_MSG_HEADER "!TOF"
 typedef struct tof_msg_s {
   uint8_t resolution;
-  uint8_t _padding[3];
+  uint8_t sequence;
+  uint8_t _padding[2];
 
   uint8_t data[64];
 } __attribute__((packed)) tof_msg_t;
 
+// ToF delta, variable length: only length bytes of payload are sent, followed by the checksum
+#define UART_TOF_DELTA_MSG_HEADER "!TOD"
+typedef struct tof_delta_msg_s {
+  uint8_t resolution;
+  uint8_t sequence;
+  uint8_t length;
+
+  uint8_t payload[TOF_DELTA_MAX_PAYLOAD];
+} __attribute__((packed)) tof_delta_msg_t;
+
 #define UART_INFERENCE_OUTPUT_MSG_HEADER "\x90\x19\x8\x31"
 typedef struct {
   float x;
@@ -88,6 +102,10 @@ typedef struct {
   float phi;
 } __attribute__((packed)) inference_output_msg_t;
 
+// Flags of inference_stamped_msg_t, zero when the inference was not filtered (see inference_filter.h)
+#define INFERENCE_FLAG_FILTERED (1 << 0)  // confidence is valid
+#define INFERENCE_FLAG_OUTLIER  (1 << 1)  // Inconsistent with the previous inferences, should not be used
+
 #define UART_INFERENCE_STAMPED_MSG_HEADER "\x90\x19\x8\x32"
 typedef struct {
   uint32_t stm32_timestamp;
@@ -95,15 +113,31 @@ typedef struct {
   float y;
   float z;
   float phi;
+  uint8_t flags;
+  uint8_t confidence;               // 0 to 255
 } __attribute__((packed)) inference_stamped_msg_t;
 
+// Clock synchronization ping (GAP8 -> STM32) and pong (STM32 -> GAP8). Unlike the other GAP8 -> STM32
+// messages, the ping also carries a checksum, so that both have the same transmission time.
+#define UART_CLOCK_PING_MSG_HEADER "\x90\x19\x8\x33"
+#define UART_CLOCK_PONG_MSG_HEADER "!PON"
+typedef struct clock_sync_msg_s {
+  uint32_t sequence;
+
+  // STM32 timestamps [us] when the ping was received and the pong was sent (unused in the ping)
+  uint32_t rx_timestamp;
+  uint32_t tx_timestamp;
+} __attribute__((packed)) clock_sync_msg_t;
+
 typedef struct uart_msg_s {
     uint8_t header[UART_HEADER_LENGTH];
     union {
         state_msg_t state;
         rng_msg_t rng;
         tof_msg_t tof;
+        tof_delta_msg_t tof_delta;
         inference_stamped_msg_t inference_stamped;
+        clock_sync_msg_t clock_sync;
     };
     uint32_t checksum;
     uint32_t recv_timestamp;
@@ -111,9 +145,19 @@ typedef struct uart_msg_s {
 
 typedef struct uart_s uart_t;
 
+// Local variables of uart_protocol_task, see CO_FN_BEGIN_WITH_FRAME
+typedef struct uart_protocol_task_frame_s {
+    void *buffer;
+    uart_msg_t *message;
+    uint32_t available_length;
+    uint32_t discarded_length;
+    uint32_t message_length;
+    uint32_t total_length;
+} uart_protocol_task_frame_t;
+
 typedef struct uart_protocol_s {
     uart_t *uart;
-    co_fn_ctx_t protocol_ctx;
+    CO_FN_CTX_WITH_FRAME(uart_protocol_task_frame_t) protocol_ctx;
 
     uint8_t buffer[UART_BUFFER_LENGTH];
 
@@ -123,11 +167,15 @@ typedef struct uart_protocol_s {
     co_fn_ctx_t message_ctx;
 
     uart_msg_t tx_message;
+    uart_msg_t tx_clock_message;
+
+    tof_decoder_t tof_decoder;
 } uart_protocol_t;
 
 void uart_protocol_init(uart_protocol_t *protocol, uart_t *uart, co_fn_t callback);
 void uart_protocol_start(uart_protocol_t *protocol);
 
 void uart_protocol_send_inference_async(uart_protocol_t *protocol, inference_stamped_msg_t *msg, pi_task_t *done_task);
+void uart_protocol_send_clock_ping_async(uart_protocol_t *protocol, uint32_t sequence, pi_task_t *done_task);
 
 #endif // __UART_PROTOCOL_H__
@@ -51,6 +51,9 @@
 #define TRACE_DUMP_TASK_CORE_ID     (1)
 #define TRACE_DUMP_TASK_PRIORITY    (24)
 
+#define TRACE_STREAM_TASK_CORE_ID   (0)
+#define TRACE_STREAM_TASK_PRIORITY  (1)
+
 /******************************* GPIO SETTINGS ******************************/
 //                      ESP32 GPIO              NINA-W10 Pin Names
 #define GPIO_LED             (4)        //      Pin 24 / GPIO_24 / RMII_MDIO
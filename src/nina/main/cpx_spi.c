@@ -35,6 +35,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <freertos/event_groups.h>
 
 #include <esp_log.h>
@@ -54,6 +55,11 @@ static EventGroupHandle_t events;
 static QueueHandle_t tx_queue;
 static QueueHandle_t tx_done_queue;
 
+// Control packets generated by NINA itself (e.g., clock sync pongs), sent ahead of tx_queue
+static QueueHandle_t control_queue;
+static SemaphoreHandle_t control_free;
+static uint8_t *control_buffer;
+
 // RX queues
 static QueueHandle_t free_queue;
 static QueueHandle_t rx_queue;
@@ -80,6 +86,19 @@ void cpx_spi_send_wait_done(uint8_t **buffer) {
     xQueueReceive(tx_done_queue, buffer, portMAX_DELAY);
 }
 
+uint8_t *cpx_spi_control_packet_alloc() {
+    if (!xSemaphoreTake(control_free, 0)) {
+        return NULL;
+    }
+
+    return control_buffer;
+}
+
+void cpx_spi_send_control_packet(uint8_t *buffer) {
+    xQueueSend(control_queue, &buffer, portMAX_DELAY);
+    xEventGroupSetBits(events, SPI_EVENT_SEND);
+}
+
 static void cpx_spi_transfer_task(void *pvParameters) {
     ESP_LOGI(TAG, "cpx_spi_transfer_task started");
 
@@ -95,7 +114,8 @@ static void cpx_spi_transfer_task(void *pvParameters) {
         ESP_LOGD(TAG, "Has SPI rx buffer %p", rx_buffer);
 
         uint8_t *tx_buffer;
-        bool has_tx = xQueueReceive(tx_queue, &tx_buffer, 0);
+        bool is_control = xQueueReceive(control_queue, &tx_buffer, 0);
+        bool has_tx = is_control || xQueueReceive(tx_queue, &tx_buffer, 0);
         ESP_LOGD(TAG, "Has SPI tx buffer %d, %p", has_tx, tx_buffer);
 
         spi_slave_transaction_t t = {0};
@@ -108,6 +128,9 @@ static void cpx_spi_transfer_task(void *pvParameters) {
         if (spi_slave_transmit(VSPI_HOST, &t, portMAX_DELAY)) {
             ESP_LOGE(TAG, "spi_slave_transmit failed");
             cpx_spi_release_receive(rx_buffer);
+            if (is_control) {
+                xSemaphoreGive(control_free);
+            }
             continue;
         }
 
@@ -116,7 +139,10 @@ static void cpx_spi_transfer_task(void *pvParameters) {
         ESP_LOGD(TAG, "SPI transfer completed with length %d bytes", transfer_length);
         ESP_LOG_BUFFER_HEX_LEVEL(TAG, rx_buffer, transfer_length, ESP_LOG_DEBUG);
 
-        if (has_tx) {
+        if (is_control) {
+            // Control packets are not reported on tx_done_queue, which belongs to cpx_router_wifi_task
+            xSemaphoreGive(control_free);
+        } else if (has_tx) {
             xQueueSend(tx_done_queue, &tx_buffer, portMAX_DELAY);
         }
 
@@ -228,6 +254,11 @@ void cpx_spi_init() {
     tx_queue = xQueueCreate(SPI_TX_QUEUE_LENGTH, sizeof(uint8_t *));
     tx_done_queue = xQueueCreate(SPI_TX_QUEUE_LENGTH, sizeof(uint8_t *));
 
+    control_queue = xQueueCreate(1, sizeof(uint8_t *));
+    control_free = xSemaphoreCreateBinary();
+    control_buffer = (uint8_t *)heap_caps_malloc(CPX_SPI_CONTROL_PACKET_LENGTH, MALLOC_CAP_DMA);
+    xSemaphoreGive(control_free);
+
     free_queue = xQueueCreate(SPI_RX_QUEUE_LENGTH, sizeof(uint8_t *));
     rx_queue = xQueueCreate(SPI_RX_QUEUE_LENGTH, sizeof(uint8_t *));
 
@@ -50,6 +50,9 @@ typedef struct cpx_spi_header_s {
 // Maximum payload size of a CPX SPI packet
 #define CPX_SPI_MTU (CPX_SPI_MAX_PACKET_LENGTH - sizeof(cpx_spi_header_t))
 
+// Maximum total size of a control packet generated by NINA (header + payload)
+#define CPX_SPI_CONTROL_PACKET_LENGTH (64)
+
 /* Initialize the SPI */
 void cpx_spi_init();
 
@@ -59,4 +62,9 @@ void cpx_spi_release_receive(uint8_t *buffer);
 void cpx_spi_send_packet(uint8_t *buffer);
 void cpx_spi_send_wait_done(uint8_t **buffer);
 
+// Send a small packet generated by NINA without going through tx_queue. A single control packet
+// can be in flight: alloc returns NULL until the previous one has been transferred to GAP.
+uint8_t *cpx_spi_control_packet_alloc();
+void cpx_spi_send_control_packet(uint8_t *buffer);
+
 #endif /* __CPX_SPI_H__ */
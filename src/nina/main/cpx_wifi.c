@@ -37,6 +37,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
+#include <freertos/semphr.h>
 
 #include <esp_system.h>
 #include <esp_event.h>
@@ -71,6 +72,9 @@ static int conn = -1;
 static QueueHandle_t free_queue;
 static QueueHandle_t rx_queue;
 
+/* Serializes senders sharing the socket (CPX router and trace streaming) */
+static SemaphoreHandle_t send_mutex;
+
 /* UDP transport */
 static int udp_sock = -1;
 static uint16_t next_tx_seq = -1;
@@ -248,11 +252,13 @@ void wifi_wait_for_disconnect() {
 }
 
 void wifi_send_packet(const uint8_t *buffer, size_t size) {
+    xSemaphoreTake(send_mutex, portMAX_DELAY);
 #if CONFIG_ENABLE_UDP_TX
     wifi_udp_send_packet(buffer, size);
 #else
     wifi_tcp_send_packet(buffer, size);
 #endif
+    xSemaphoreGive(send_mutex);
 }
 
 // MARK: TCP transport
@@ -574,6 +580,7 @@ void cpx_wifi_init(wifi_mode_t mode, const char *ssid, const char *key) {
 
     free_queue = xQueueCreate(WIFI_RX_QUEUE_LENGTH, sizeof(uint8_t *));
     rx_queue = xQueueCreate(WIFI_RX_QUEUE_LENGTH, sizeof(uint8_t *));
+    send_mutex = xSemaphoreCreateMutex();
 
     for (int i = 0; i < WIFI_RX_QUEUE_LENGTH; i++) {
         // TODO: this works only because SPI, TCP, and UDP all have the same max packet length
@@ -39,6 +39,7 @@
 #include <freertos/semphr.h>
 
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <esp_sleep.h>
 #include <driver/gpio.h>
 
@@ -126,6 +127,39 @@ static void wifi_init() {
 }
 
 /* CPX router tasks */
+static void cpx_router_clock_sync(cpx_spi_header_t *spi_header) {
+    uint32_t rx_timestamp = esp_timer_get_time();
+    cpx_clock_sync_t *ping = (cpx_clock_sync_t *)(spi_header + 1);
+
+    if (spi_header->length < sizeof(cpx_clock_sync_t) || ping->command != CPX_SYSTEM_CLOCK_PING) {
+        return;
+    }
+
+    uint8_t *buffer = cpx_spi_control_packet_alloc();
+    if (buffer == NULL) {
+        // GAP measures the round-trip time, a late pong would only be discarded as an outlier
+        ESP_LOGD(TAG, "Previous clock sync pong still pending, dropping ping %d", (int)ping->sequence);
+        return;
+    }
+
+    cpx_spi_header_t *pong_header = (cpx_spi_header_t *)buffer;
+    pong_header->length = sizeof(cpx_clock_sync_t);
+    pong_header->cpx = (cpx_header_t){
+        .destination = CPX_T_GAP, .source = CPX_T_ESP32,
+        .last_packet = true, .reserved = false,
+        .function = CPX_F_SYSTEM,
+        .version = CPX_VERSION
+    };
+
+    cpx_clock_sync_t *pong = (cpx_clock_sync_t *)(pong_header + 1);
+    pong->command = CPX_SYSTEM_CLOCK_PONG;
+    pong->sequence = ping->sequence;
+    pong->rx_timestamp = rx_timestamp;
+    pong->tx_timestamp = esp_timer_get_time();
+
+    cpx_spi_send_control_packet(buffer);
+}
+
 static void cpx_router_spi_task(void *pvParameters) {
     ESP_LOGI(TAG, "cpx_router_spi_task started");
 
@@ -139,7 +173,9 @@ static void cpx_router_spi_task(void *pvParameters) {
 
             uint16_t spi_length = sizeof(cpx_spi_header_t) + spi_header->length;
 
-            if (wifi_is_socket_connected()) {
+            if (spi_header->cpx.destination == CPX_T_ESP32 && spi_header->cpx.function == CPX_F_SYSTEM) {
+                cpx_router_clock_sync(spi_header);
+            } else if (wifi_is_socket_connected()) {
                 ESP_LOGD(TAG, "Sending Wi-Fi packet %p with length %d", spi_buffer, spi_length);
                 wifi_send_packet(spi_buffer, spi_length);
             }
@@ -24,7 +24,13 @@
 
 #include "trace_buffer.h"
 
+#if CONFIG_ENABLE_TRACE_STREAM
+#include "cpx_spi.h"
+#include "cpx_wifi.h"
+#endif
+
 #include <driver/gpio.h>
+#include <esp_heap_caps.h>
 
 #include <string.h>
 
@@ -44,7 +50,14 @@ void trace_buffer_init(int core_id) {
     memset(buffer, 0xaa, sizeof(trace_buffer_t));
     buffer->started = false;
     buffer->next_event = 0;
+#if !CONFIG_ENABLE_TRACE_STREAM
     buffer->event_count = 0;
+#else
+    buffer->active = 0;
+    buffer->full[0] = false;
+    buffer->full[1] = false;
+    buffer->dropped = 0;
+#endif
 
     trace_buffers[core_id] = buffer;
 }
@@ -67,6 +80,7 @@ void trace_buffer_start() {
     trace_sync();
 }
 
+#if !CONFIG_ENABLE_TRACE_STREAM
 void trace_buffer_dump_core(int core_id) {
     trace_buffer_t *t = trace_buffers[core_id];
     
@@ -89,6 +103,31 @@ void trace_buffer_dump_core(int core_id) {
 
     t->event_count -= event_count;
 }
+#else
+static void trace_buffer_dump_events(trace_evt_t *events, int n_events) {
+    for (int i = 0; i < n_events; i++) {
+        printf("%016llx,", events[i].data);
+    }
+}
+
+void trace_buffer_dump_core(int core_id) {
+    trace_buffer_t *t = trace_buffers[core_id];
+    
+    if (t == NULL) {
+        return;
+    }
+
+    // Dump the events that were not streamed yet, oldest first
+    int other = t->active ^ 1;
+    int n_other = t->full[other] ? TRACE_STREAM_EVENTS : 0;
+
+    printf("core_id=%d,n_events=%d\n", core_id, n_other + t->next_event);
+    trace_buffer_dump_events(t->buffer[other], n_other);
+    trace_buffer_dump_events(t->buffer[t->active], t->next_event);
+    printf("\n");
+    printf("\n");
+}
+#endif
 
 void trace_buffer_dump() {
     printf("=================================\n");
@@ -143,6 +182,65 @@ static void trace_dump_task(void *arg) {
     }
 }
 
+#if CONFIG_ENABLE_TRACE_STREAM
+typedef struct trace_stream_packet_s {
+    cpx_spi_header_t header;
+    trace_stream_header_t trace;
+    trace_evt_t events[TRACE_STREAM_EVENTS];
+} __attribute__((packed)) trace_stream_packet_t;
+
+static void trace_stream_task(void *arg) {
+    // Next half to be sent and packet sequence number for each core
+    int next_half[TRACE_NUM_CORES] = {};
+    uint32_t sequence[TRACE_NUM_CORES] = {};
+
+    trace_stream_packet_t *packet = heap_caps_malloc(sizeof(trace_stream_packet_t), MALLOC_CAP_DMA);
+    if (packet == NULL) {
+        ASSERTION_FAILURE("Failed to allocate memory for trace stream packet\n");
+    }
+
+    while (true) {
+        for (int core_id = 0; core_id < TRACE_NUM_CORES; core_id++) {
+            trace_buffer_t *t = trace_buffers[core_id];
+            int half = next_half[core_id];
+
+            if (t == NULL || !t->full[half]) {
+                continue;
+            }
+
+            packet->header = (cpx_spi_header_t){
+                .length = sizeof(trace_stream_header_t) + sizeof(packet->events),
+                .cpx = {
+                    .destination = CPX_T_WIFI_HOST, .source = CPX_T_ESP32,
+                    .last_packet = true, .reserved = false,
+                    .function = CPX_F_TRACE,
+                    .version = CPX_VERSION
+                }
+            };
+            packet->trace = (trace_stream_header_t){
+                .core_id = core_id,
+                .n_events = TRACE_STREAM_EVENTS,
+                .sequence = sequence[core_id],
+                .dropped = t->dropped,
+            };
+            memcpy(packet->events, t->buffer[half], sizeof(packet->events));
+
+            // The half can be reused as soon as it has been copied
+            t->full[half] = false;
+            next_half[core_id] = half ^ 1;
+            sequence[core_id] += 1;
+
+            // Without a client the packet is lost, the host will see a gap in the sequence numbers
+            if (wifi_is_socket_connected()) {
+                wifi_send_packet((uint8_t *)packet, sizeof(trace_stream_packet_t));
+            }
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(TRACE_STREAM_PERIOD_MS));
+    }
+}
+#endif
+
 void trace_buffer_init_all() {
     for (int i = 0; i < TRACE_NUM_CORES; i++) {
         trace_buffer_init(i);
@@ -154,4 +252,8 @@ void trace_buffer_init_all() {
 
     trace_semaphore = xSemaphoreCreateBinary();
     xTaskCreatePinnedToCore(trace_dump_task, "trace_dump_task", 4096, NULL, TRACE_DUMP_TASK_PRIORITY, NULL, TRACE_DUMP_TASK_CORE_ID);
+
+#if CONFIG_ENABLE_TRACE_STREAM
+    xTaskCreatePinnedToCore(trace_stream_task, "trace_stream_task", 4096, NULL, TRACE_STREAM_TASK_PRIORITY, NULL, TRACE_STREAM_TASK_CORE_ID);
+#endif
 }
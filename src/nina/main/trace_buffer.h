@@ -27,6 +27,11 @@
  *
  * Low-overhead event tracing over a circular buffer that can be dumped
  * 
+ * When CONFIG_ENABLE_TRACE_STREAM is set, each core instead records events in
+ * two halves of a double buffer. Whenever a half is full, it is handed over to
+ * trace_stream_task, which sends it to the host as a binary CPX packet 
+ * (function CPX_F_TRACE) while the core keeps recording in the other half. If
+ * both halves are waiting to be sent, new events are dropped and counted.
  */
 
 #ifndef __TRACE_BUFFER_H__
@@ -47,6 +52,11 @@
 #define TRACE_EVENTS_BUFFER         (3072)
 #define TRACE_EVENTS_PERF_COUNTER   (XTPERF_CNT_CYCLES)
 
+// Events in each half of a streaming buffer, sent in a single CPX packet
+#define TRACE_STREAM_EVENTS         (256)
+// Polling period of trace_stream_task [ms]
+#define TRACE_STREAM_PERIOD_MS      (10)
+
 typedef enum trace_evt_e {
     TRACE_EVT_SYNC = 0x0,
 
@@ -79,12 +89,43 @@ typedef struct trace_evt_s {
     };
 } trace_evt_t;
 
+#if !CONFIG_ENABLE_TRACE_STREAM
 typedef struct trace_buffer_s {
     bool started;
     int next_event;
     int event_count;
     trace_evt_t buffer[TRACE_EVENTS_BUFFER];
 } trace_buffer_t;
+#else
+typedef struct trace_buffer_s {
+    bool started;
+
+    // Half currently being recorded and next free event in it
+    int active;
+    int next_event;
+
+    // Set by the core when a half is full, cleared by trace_stream_task once sent
+    volatile bool full[2];
+
+    // Events dropped because both halves were full
+    uint32_t dropped;
+
+    trace_evt_t buffer[2][TRACE_STREAM_EVENTS];
+} trace_buffer_t;
+
+// Header of CPX_F_TRACE packets, followed by n_events trace_evt_t
+typedef struct trace_stream_header_s {
+    uint8_t core_id;
+    uint8_t _padding;
+    uint16_t n_events;
+
+    // Per-core packet sequence number, used by the host to detect lost packets
+    uint32_t sequence;
+
+    // Total events dropped by this core up to this packet
+    uint32_t dropped;
+} __attribute__((packed)) trace_stream_header_t;
+#endif
 
 void trace_buffer_init_all();
 
@@ -115,9 +156,30 @@ static inline void trace_push_event(trace_evt_t event) {
         ASSERTION_FAILURE("Trace buffer for core %d not started\n", core_id);
     }
 
+#if !CONFIG_ENABLE_TRACE_STREAM
     t->buffer[t->next_event] = event;
     t->next_event = (t->next_event + 1) % TRACE_EVENTS_BUFFER;
     t->event_count = MIN(t->event_count + 1, TRACE_EVENTS_BUFFER);
+#else
+    if (t->next_event == TRACE_STREAM_EVENTS) {
+        // The active half has been handed over, switch to the other one if it was already sent
+        int other = t->active ^ 1;
+        if (t->full[other]) {
+            t->dropped += 1;
+            return;
+        }
+
+        t->active = other;
+        t->next_event = 0;
+    }
+
+    t->buffer[t->active][t->next_event] = event;
+    t->next_event += 1;
+
+    if (t->next_event == TRACE_STREAM_EVENTS) {
+        t->full[t->active] = true;
+    }
+#endif
 }
 
 static inline void trace_event(trace_evt_e event, trace_state_e state, uint16_t context) {
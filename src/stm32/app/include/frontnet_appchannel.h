@@ -1 +1,10 @@
+#pragma once
+
+#include "frontnet_telemetry.h"
+
+#include <stdbool.h>
+
 void frontnetAppChannelInit();
+
+// Enqueue a telemetry record to be sent to the ground, without blocking. Returns false if it was dropped.
+bool frontnetAppChannelSendTelemetry(const frontnet_telemetry_t *record);
@@ -11,6 +11,10 @@
 #define FN_APPCHANNEL_STACK_SIZE (configMINIMAL_STACK_SIZE)
 #define FN_APPCHANNEL_PRIORITY   (FRONTNET_PRIORITY)
 
+#define FN_TELEMETRY_TASK_NAME  "FN-TELEMETRY"
+#define FN_TELEMETRY_STACK_SIZE (configMINIMAL_STACK_SIZE)
+#define FN_TELEMETRY_PRIORITY   (FRONTNET_PRIORITY)
+
 #define STATE_FWD_TASK_NAME "STATE-FWD"
 #define STATE_FWD_STACKSIZE (2*configMINIMAL_STACK_SIZE)
 #define STATE_FWD_PRIORITY  (1)
@@ -24,6 +28,15 @@
 
 #define FRONTNET_COMMAND_TIMEOUT M2T(500)
 
+// Commands buffered for the Frontnet task, so that batched inferences are not overwritten
+#define FRONTNET_COMMAND_QUEUE_LENGTH (4)
+
+// Telemetry records and acks buffered while waiting to be sent over the app channel
+#define FN_TELEMETRY_QUEUE_LENGTH (8)
+
+// Number of offboard sources with separate link statistics, see frontnet_msg.h
+#define FN_APPCHANNEL_SOURCE_COUNT (2)
+
 // Time since last inference before control is disabled [ticks]
 #define FRONTNET_INFERENCE_TIMEOUT M2T(750)
 
@@ -36,8 +49,22 @@
   .y   = {.angle = false, .r_xx = 0.012f, .q_vv = 16.0f /* (48/8)*2.7f */, .state = {.p_xx = 100.0f, .p_xv = 0.0f, .p_vv = 10.0f}}, \
   .z   = {.angle = false, .r_xx = 0.024f, .q_vv = 6.0f  /* (48/8)*1.0f */, .state = {.p_xx = 100.0f, .p_xv = 0.0f, .p_vv = 10.0f}}, \
   .phi = {.angle =  true, .r_xx = 0.080f, .q_vv = 16.0f /* (48/8)*5.3f */, .state = {.p_xx =  10.0f, .p_xv = 0.0f, .p_vv = 10.0f}}, \
+  .model = KF_D1_MODEL,                                                                                                \
+  .ca = FRONTNET_KF_CA_DEFAULT_CONFIG,                                                                                 \
 })
 
+// Joint constant-acceleration Kalman filter configuration, observation noise is shared with the decoupled filter
+#define FRONTNET_KF_CA_DEFAULT_CONFIG ((kf_ca_t){ \
+  .q = {2.0f, 2.0f, 0.5f, 4.0f},                  \
+  .p0_xx = 100.0f,                                \
+  .p0_vv = 10.0f,                                 \
+  .p0_aa = 10.0f,                                 \
+  .maxHorizon = 0.2f,                             \
+})
+
+// Number of measurements kept by the constant-acceleration filter to handle out-of-sequence inferences
+#define FRONTNET_KF_CA_HISTORY_COUNT (5)
+
 // Target pose configuration
 #define FRONTNET_TARGET_DEFAULT_CONFIG ((frontnet_target_t){ \
   .horizontalDistance = 1.5f,                                \
@@ -65,3 +92,6 @@
 
 // State history count [samples]
 #define STATE_FWD_HISTORY_COUNT (100)
+
+// States already dequeued from the history that are kept for out-of-sequence inferences [samples]
+#define STATE_FWD_HISTORY_RECENT_COUNT (8)
@@ -0,0 +1,67 @@
+// Follow-me logic, from inference outputs to control setpoints. It only depends on the
+// firmware through frontnet_os.h, so that it can also run in the host simulator (sim/).
+#pragma once
+
+#include "frontnet_types.h"
+#include "frontnet_inference.h"
+#include "frontnet_kf.h"
+#include "frontnet_ctrl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct frontnet_follow_s {
+  // Use the state estimate from the time the camera image was acquired, instead of the latest one
+  bool useInferenceTimeState;
+
+  // Skip the inferences flagged as outliers by GAP8 (INFERENCE_FLAG_OUTLIER)
+  bool gateOutliers;
+
+  frontnet_kf_t kf;
+  frontnet_target_t target;
+  frontnet_ctrl_t ctrl;
+
+  // Latest inference and time when it was received [ticks]
+  inference_stamped_t inference;
+  uint32_t lastInference;
+
+  // Inferences skipped because they were flagged as outliers
+  uint32_t outliersGated;
+
+  odometry_t subjectOdom;
+  odometry_t targetOdom;
+
+  ctrl_mode_e controlMode;
+  pose_t hoverPose;
+
+  // Duration of the latest Kalman filter update [us]
+  uint32_t kfLatencyUs;
+} frontnet_follow_t;
+
+#define FRONTNET_FOLLOW_DEFAULT_CONFIG ((frontnet_follow_t){ \
+  .useInferenceTimeState = true,                             \
+  .gateOutliers = true,                                      \
+  .kf = FRONTNET_KF_DEFAULT_CONFIG,                          \
+  .target = FRONTNET_TARGET_DEFAULT_CONFIG,                  \
+  .ctrl = FRONTNET_CTRL_DEFAULT_CONFIG,                      \
+  .controlMode = FRONTNET_CTRL_MODE                          \
+})
+
+void computeSubjectPoseInOdomFrame(const inference_stamped_t *inference, const state_t *state, pose_t *subjectPose);
+void computeTargetOdom(const frontnet_target_t *config, const odometry_t *subjectOdom, const state_t *state, odometry_t *targetOdom);
+
+// Update the subject and target odometry with an inference received at time now [ticks].
+// Returns false if the inference was discarded because it is flagged as an outlier, because the
+// corresponding state is not available or because it is too old for the Kalman filter. Outliers
+// do not reset the inference timeout.
+bool frontnetFollowInference(frontnet_follow_t *follow, const inference_stamped_t *inference, const state_t *state, uint32_t now);
+
+// Propagate the subject and target odometry to time now [ticks], when the Kalman filter supports it
+void frontnetFollowPredict(frontnet_follow_t *follow, const state_t *state, uint32_t now);
+
+// Switch to hover when no inference has been received for FRONTNET_INFERENCE_TIMEOUT and back to
+// follow-me when they resume. Returns true when it just switched to hover.
+bool frontnetFollowCheckTimeout(frontnet_follow_t *follow, bool controlEnabled, const state_t *state, uint32_t now);
+
+// Compute the setpoint for the current control mode. Returns false if the control mode is unknown.
+bool frontnetFollowSetpoint(const frontnet_follow_t *follow, const state_t *state, setpoint_t *setpoint);
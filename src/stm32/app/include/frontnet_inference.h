@@ -2,10 +2,19 @@
 
 #include "aideck_protocol.h"
 
+#include "frontnet_types.h"
+
 /**
  * Send a new inference output to the Frontnet task.
- * Best effort: if the task has not processed yet the previous inference output, the new one overwrites it.
+ * Best effort: if the task's command queue is full, the oldest command is discarded to make space.
  *
  * @param inference the new inference output, in cf/base_link reference frame.
  */
 void frontnetEnqueueInference(const inference_stamped_t *inference);
+
+/**
+ * Send a new target configuration to the Frontnet task, with the same policy as frontnetEnqueueInference.
+ *
+ * @param target the new target configuration.
+ */
+void frontnetEnqueueTarget(const frontnet_target_t *target);
@@ -18,8 +18,10 @@
 // Terminology: https://en.wikipedia.org/wiki/Kalman_filter
 #pragma once
 
+#include "frontnet_config.h"
 #include "frontnet_types.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef struct kf_d1_state_s {
@@ -50,16 +52,79 @@ typedef struct kf_d1_s {
   kf_d1_state_t state;
 } kf_d1_t;
 
+// Joint constant-acceleration Kalman filter
+// The state stacks position, velocity and acceleration of the four components (x, y, z, phi)
+// and evolves under a white-jerk process model, with jerk spectral density q. The observation
+// noise is shared with the decoupled filter (r_xx). Measurements are stamped with the time the
+// camera image was captured: those arriving out of sequence are handled by rolling back to the
+// last estimate older than them and re-applying the newer measurements, and the estimate is
+// propagated forward to the current time before being used for control.
+#define KF_CA_OBS_DIM (4)
+#define KF_CA_DIM (3 * KF_CA_OBS_DIM)
+
+typedef struct kf_ca_state_s {
+  uint32_t timestamp;
+
+  // [x, y, z, phi, vx, vy, vz, vphi, ax, ay, az, aphi]
+  float x[KF_CA_DIM];
+
+  // Covariance
+  float p[KF_CA_DIM][KF_CA_DIM];
+} kf_ca_state_t;
+
+typedef struct kf_ca_entry_s {
+  // Measurement and filter estimate after applying it, with the same timestamp
+  float z[KF_CA_OBS_DIM];
+  kf_ca_state_t posterior;
+} kf_ca_entry_t;
+
+typedef struct kf_ca_s {
+  // Spectral density of process noise (i.e., jerk), for each component
+  float q[KF_CA_OBS_DIM];
+
+  // Initial variance of position, velocity and acceleration
+  float p0_xx;
+  float p0_vv;
+  float p0_aa;
+
+  // Maximum prediction horizon past the latest measurement [s], the estimate is not extrapolated
+  // further so that a noisy acceleration cannot move it quadratically while inferences are missing
+  float maxHorizon;
+
+  // Most recent measurements sorted by timestamp, used to handle out-of-sequence measurements
+  kf_ca_entry_t history[FRONTNET_KF_CA_HISTORY_COUNT];
+  uint8_t historyCount;
+} kf_ca_t;
+
+typedef enum {
+  // Four decoupled constant-velocity filters, estimate at the time of the latest measurement
+  KF_D1_MODEL = 0,
+
+  // Joint constant-acceleration filter, estimate propagated to the current time
+  KF_CA_MODEL = 1
+} kf_model_e;
+
 typedef struct frontnet_kf_s {
   // Disable Kalman filter and return the subject pose unfiltered, for test purposes
   bool bypassFilter;
 
+  kf_model_e model;
+
   kf_d1_t x;
   kf_d1_t y;
   kf_d1_t z;
   kf_d1_t phi;
 
+  kf_ca_t ca;
+
   uint32_t lastUpdate;
 } frontnet_kf_t;
 
-void frontnetKfUpdate(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *subjectOdom);
+// Update the filter with a new subject pose, stamped with the time the camera image was captured.
+// Returns false if the measurement was discarded because it is older than the filter can handle.
+bool frontnetKfUpdate(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *subjectOdom);
+
+// Propagate the latest estimate to timestamp [ticks], at most ca.maxHorizon past it. Returns
+// false if the filter model does not support latency compensation or has not received any
+// measurement yet.
+bool frontnetKfPredict(const frontnet_kf_t *kf, uint32_t timestamp, odometry_t *subjectOdom);
@@ -0,0 +1,149 @@
+// Messages exchanged with offboard hosts over the CRTP app channel, also implemented on the host
+// by aideck_cpx_streamer/frontnet_msg.py. Each message fits in a single packet (APPCHANNEL_MTU bytes).
+//
+// Except for the legacy INFERENCE_STAMPED_MSG, messages start with a header carrying the sender
+// (source), a per-source sequence number and the sender's transmission time, used to measure loss,
+// reordering and latency of each offboard source. When FN_MSG_ACK_REQUEST is set in the type,
+// the STM32 answers with an ACK_MSG that carries its own receive time.
+//
+// Acks are sent on the same channel as telemetry records, so ACK_MSG must not overlap with the
+// frontnet_telemetry_e values.
+#pragma once
+
+#include "frontnet_types.h"
+#include "aideck_protocol.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Set in the type byte to request an acknowledgement
+#define FN_MSG_ACK_REQUEST (0x80)
+#define FN_MSG_TYPE_MASK   (0x7f)
+
+// Fixed-point scale of batched inferences [mm, mrad]
+#define FN_MSG_FIXED_SCALE (1000.0f)
+
+typedef enum {
+  INFERENCE_STAMPED_MSG  = 0,  // Legacy, inference_stamped_t without header
+  INFERENCE_MSG          = 1,
+  INFERENCE_BATCH_MSG    = 2,
+  TARGET_CONFIG_MSG      = 3,
+  ACK_MSG                = 16, // STM32 -> host
+} __attribute__((packed)) frontnet_msg_e;
+
+typedef enum {
+  ACK_ACCEPTED = 0,
+  ACK_REJECTED = 1,            // Well-formed but not applied (e.g., invalid target configuration)
+} __attribute__((packed)) frontnet_ack_status_e;
+
+typedef struct frontnet_msg_header_s {
+  uint8_t type;                // frontnet_msg_e, optionally with FN_MSG_ACK_REQUEST
+  uint8_t source;              // Sender id, < FN_APPCHANNEL_SOURCE_COUNT
+  uint16_t sequence;           // Incremented by each sender for each message
+  uint32_t txTimestamp;        // Sender's clock when the message was sent, echoed in acks [us]
+} __attribute__((packed)) frontnet_msg_header_t;
+
+// Inference with the same content as the legacy message
+typedef struct frontnet_msg_inference_s {
+  inference_stamped_t inference;
+} __attribute__((packed)) frontnet_msg_inference_t;
+
+// Consecutive inferences sent in a single packet, in fixed point to fit the MTU. Flags and confidence
+// are not sent, batched inferences are decoded as unfiltered.
+typedef struct frontnet_msg_batch_entry_s {
+  uint8_t dt;                  // Offset of stm32_timestamp w.r.t. the batch's base timestamp [ticks]
+  int16_t x, y, z;             // [mm]
+  int16_t phi;                 // [mrad]
+} __attribute__((packed)) frontnet_msg_batch_entry_t;
+
+// Maximum number of inferences in a batch, so that a batch fits in APPCHANNEL_MTU
+#define FN_MSG_BATCH_MAX_COUNT (2)
+
+typedef struct frontnet_msg_inference_batch_s {
+  uint8_t count;
+  uint32_t baseTimestamp;      // [ticks]
+  frontnet_msg_batch_entry_t entries[FN_MSG_BATCH_MAX_COUNT];
+} __attribute__((packed)) frontnet_msg_inference_batch_t;
+
+typedef struct frontnet_msg_target_config_s {
+  float horizontalDistance;    // [m]
+  float altitude;              // [m]
+  uint8_t altitudeReference;   // altitude_ref_e
+} __attribute__((packed)) frontnet_msg_target_config_t;
+
+// The header of an ack repeats source and sequence of the acknowledged message, with the STM32's
+// transmission time [ticks]
+typedef struct frontnet_msg_ack_s {
+  uint8_t ackedType;
+  uint32_t ackedTxTimestamp;   // Echo of the sender's txTimestamp [us]
+  uint32_t rxTimestamp;        // When the STM32 received the acknowledged message [ticks]
+  uint8_t status;              // frontnet_ack_status_e
+} __attribute__((packed)) frontnet_msg_ack_t;
+
+typedef struct frontnet_msg_s {
+  frontnet_msg_header_t header;
+
+  union {
+    frontnet_msg_inference_t inference;
+    frontnet_msg_inference_batch_t batch;
+    frontnet_msg_target_config_t target;
+    frontnet_msg_ack_t ack;
+  };
+} __attribute__((packed)) frontnet_msg_t;
+
+// Legacy inference message, without header
+typedef struct frontnet_msg_legacy_s {
+  uint8_t type;
+  inference_stamped_t inference_stamped;
+} __attribute__((packed)) frontnet_msg_legacy_t;
+
+// Message type, without FN_MSG_ACK_REQUEST
+static inline frontnet_msg_e frontnetMsgType(const frontnet_msg_t *msg) {
+  return msg->header.type & FN_MSG_TYPE_MASK;
+}
+
+// Check that a received message has a known type and the expected size. Legacy messages
+// must be checked separately, since they have no header.
+bool frontnetMsgValidate(const frontnet_msg_t *msg, size_t size);
+
+// Encode messages, returning their size in bytes
+size_t frontnetMsgInference(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const inference_stamped_t *inference);
+size_t frontnetMsgInferenceBatch(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const inference_stamped_t *inferences, int count);
+size_t frontnetMsgTargetConfig(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const frontnet_target_t *target);
+size_t frontnetMsgAck(frontnet_msg_t *msg, const frontnet_msg_t *acked, uint32_t rxTimestamp, uint32_t txTimestamp, frontnet_ack_status_e status);
+
+// Decode messages, frontnetMsgGetTargetConfig returns false if the configuration is not valid
+void frontnetMsgGetBatchInference(const frontnet_msg_t *msg, int index, inference_stamped_t *inference);
+bool frontnetMsgGetTargetConfig(const frontnet_msg_t *msg, frontnet_target_t *target);
+
+// Link statistics of an offboard source, updated for each received message
+typedef struct frontnet_link_stats_s {
+  bool synced;
+  uint16_t nextSequence;
+
+  uint32_t received;
+  uint32_t lost;               // Sequence numbers skipped and not (yet) received
+  uint32_t reordered;          // Messages received after a later one
+  uint32_t restarts;           // Large sequence jumps, e.g. when the sender restarts
+
+  // Latency from the state associated with an inference to its reception, mean and max over the
+  // last FN_LINK_STATS_WINDOW inferences [ms]
+  uint32_t latencySum;
+  uint16_t latencyCount;
+  uint16_t latencyWindowMax;
+  uint16_t latencyMean;
+  uint16_t latencyMax;
+} frontnet_link_stats_t;
+
+#define FN_LINK_STATS_WINDOW (30)
+
+// Sequence jumps larger than this are treated as a restart of the sender instead of losses
+#define FN_LINK_STATS_MAX_GAP (1000)
+
+void frontnetLinkStatsInit(frontnet_link_stats_t *stats);
+
+// Account for a received sequence number. Returns false if the message is older than the latest one.
+bool frontnetLinkStatsUpdate(frontnet_link_stats_t *stats, uint16_t sequence);
+
+void frontnetLinkStatsLatency(frontnet_link_stats_t *stats, uint32_t latency);
@@ -0,0 +1,26 @@
+// Thin OS abstraction used by the Frontnet modules that do not depend on the firmware,
+// so that they can run both on the Crazyflie (frontnet_os.c, on top of FreeRTOS) and
+// in the host simulator (sim/sim_os.c).
+#pragma once
+
+#include "stabilizer_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// QueueHandle_t on FreeRTOS
+typedef void *frontnet_queue_t;
+
+// Non-blocking queue operations, return false if the queue is full (send) or empty (receive, peek)
+bool frontnetQueueSend(frontnet_queue_t queue, const void *item);
+bool frontnetQueueReceive(frontnet_queue_t queue, void *item);
+bool frontnetQueuePeek(frontnet_queue_t queue, void *item);
+
+// Current time [ticks], see M2T/T2M in FreeRTOSConfig.h
+uint32_t frontnetGetTicks();
+
+// Current time [us]
+uint64_t frontnetUsecTimestamp();
+
+// Latest state estimate from the stabilizer
+void frontnetGetLatestState(stateCompressed_t *state);
@@ -3,4 +3,3 @@
 #include "stabilizer.h"
 
 void stateFwdInit();
-bool stateFwdDequeueAtTimestamp(uint32_t timestamp, stateCompressed_t *state);
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "frontnet_os.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// History of the recent state estimates, used to retrieve the state of the drone at the time
+// a camera frame was captured. The queue must be able to hold stateCompressed_t items, its
+// length determines how old inferences can be.
+void stateHistoryInit(frontnet_queue_t queue);
+void stateHistoryPush(const stateCompressed_t *state);
+bool stateHistoryDequeueAtTimestamp(uint32_t timestamp, stateCompressed_t *state);
@@ -0,0 +1,44 @@
+// Binary telemetry records, sent to the ground over the CRTP app channel and decoded on the
+// host by aideck_cpx_streamer/frontnet_telemetry.py. Fields are fixed-point to fit each record
+// in a single packet (APPCHANNEL_MTU bytes).
+#pragma once
+
+#include "frontnet_follow.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  TELEMETRY_INFERENCE_RECORD = 0,
+} __attribute__((packed)) frontnet_telemetry_e;
+
+// Sent for each processed inference, same content as the CSV lines previously printed on the console
+typedef struct frontnet_telemetry_inference_s {
+  uint32_t stateTimestamp;      // Timestamp of the state associated with the inference [ticks]
+  uint32_t inferenceTimestamp;  // Time the inference was received [ticks]
+
+  // Subject odometry, after Kalman filter
+  int16_t x, y, z;              // [mm]
+  int16_t phi;                  // [mrad]
+  int16_t vx, vy, vz;           // [mm/s]
+  int16_t vphi;                 // [mrad/s]
+
+  uint8_t controlEnabled;
+  uint8_t controlMode;
+  uint8_t setpointPriority;
+} __attribute__((packed)) frontnet_telemetry_inference_t;
+
+typedef struct frontnet_telemetry_s {
+  frontnet_telemetry_e type;
+
+  union {
+    frontnet_telemetry_inference_t inference;
+  };
+} __attribute__((packed)) frontnet_telemetry_t;
+
+// Fill an inference record, returns its size in bytes
+size_t frontnetTelemetryInference(const frontnet_follow_t *follow, bool controlEnabled, int setpointPriority, frontnet_telemetry_t *record);
+
+// Size of a record in bytes, depending on its type
+size_t frontnetTelemetrySize(const frontnet_telemetry_t *record);
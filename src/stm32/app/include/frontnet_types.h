@@ -48,6 +48,23 @@ static inline float normalizeAngle(float alpha) {
   return alpha;
 }
 
+// Convert to fixed point with the given scale, saturating to the int16 range
+static inline int16_t toFixed16(float value, float scale) {
+  float fixed = roundf(value * scale);
+
+  if (fixed > INT16_MAX) {
+    return INT16_MAX;
+  } else if (fixed < INT16_MIN) {
+    return INT16_MIN;
+  } else {
+    return (int16_t)fixed;
+  }
+}
+
+static inline float fromFixed16(int16_t fixed, float scale) {
+  return fixed / scale;
+}
+
 static inline void setPoseFromState(pose_t *pose, const state_t *state) {
   *pose = (pose_t){
     .position = state->position,
@@ -0,0 +1,260 @@
+// Checks frontnet_msg.c against the test vectors generated by the Python implementation
+// (aideck_cpx_streamer/test/data/frontnet_msg_vectors.txt): each valid vector is decoded and
+// compared with the expected fields, then encoded again from the fields and compared with the
+// original bytes. Also checks the per-source link statistics.
+#include "frontnet_msg.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE_LENGTH (512)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do {                   \
+  if (!(cond)) {                                \
+    printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+    printf(__VA_ARGS__);                        \
+    printf("\n");                               \
+    failures++;                                 \
+  }                                             \
+} while (0)
+
+// Whitespace-separated fields of a vector line
+typedef struct fields_s {
+  char *saveptr;
+  int lineno;
+} fields_t;
+
+static char *nextField(fields_t *fields) {
+  char *field = strtok_r(NULL, " \n", &fields->saveptr);
+  if (!field) {
+    printf("FAIL line %d: missing field\n", fields->lineno);
+    exit(1);
+  }
+  return field;
+}
+
+static uint32_t nextUint(fields_t *fields) {
+  return strtoul(nextField(fields), NULL, 10);
+}
+
+static float nextFloat(fields_t *fields) {
+  return strtof(nextField(fields), NULL);
+}
+
+static size_t parseHex(const char *hex, uint8_t *data, size_t maxSize) {
+  if (strcmp(hex, "-") == 0) {
+    return 0;
+  }
+
+  size_t size = strlen(hex) / 2;
+  if (size > maxSize) {
+    size = maxSize;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    sscanf(&hex[2 * i], "%2hhx", &data[i]);
+  }
+  return size;
+}
+
+static void nextHeader(fields_t *fields, frontnet_msg_e type, frontnet_msg_header_t *header) {
+  bool ackRequest = nextUint(fields);
+  header->type = type | (ackRequest ? FN_MSG_ACK_REQUEST : 0);
+  header->source = nextUint(fields);
+  header->sequence = nextUint(fields);
+  header->txTimestamp = nextUint(fields);
+}
+
+static void nextInference(fields_t *fields, inference_stamped_t *inference) {
+  inference->stm32_timestamp = nextUint(fields);
+  inference->x = nextFloat(fields);
+  inference->y = nextFloat(fields);
+  inference->z = nextFloat(fields);
+  inference->phi = nextFloat(fields);
+  inference->flags = nextUint(fields);
+  inference->confidence = nextUint(fields);
+}
+
+static bool inferenceEqual(const inference_stamped_t *a, const inference_stamped_t *b) {
+  return a->stm32_timestamp == b->stm32_timestamp
+      && a->x == b->x && a->y == b->y && a->z == b->z && a->phi == b->phi
+      && a->flags == b->flags && a->confidence == b->confidence;
+}
+
+static void checkVector(int lineno, char *line) {
+  fields_t fields = { .lineno = lineno };
+  char *kind = strtok_r(line, " \n", &fields.saveptr);
+  if (!kind) {
+    return;
+  }
+
+  uint8_t packet[64];
+  size_t size = parseHex(nextField(&fields), packet, sizeof(packet));
+
+  frontnet_msg_t msg;
+  memset(&msg, 0, sizeof(msg));
+  memcpy(&msg, packet, size < sizeof(msg) ? size : sizeof(msg));
+  bool fits = size <= sizeof(msg);
+
+  frontnet_msg_t encoded;
+  size_t encodedSize = 0;
+
+  if (strcmp(kind, "invalid") == 0) {
+    // Legacy messages are validated by the app channel task, by size only
+    bool validLegacy = size == sizeof(frontnet_msg_legacy_t) && packet[0] == INFERENCE_STAMPED_MSG;
+    CHECK(!validLegacy && !(fits && frontnetMsgValidate(&msg, size)), "line %d: invalid message accepted", lineno);
+    return;
+  } else if (strcmp(kind, "legacy") == 0) {
+    frontnet_msg_legacy_t legacy;
+    CHECK(size == sizeof(legacy), "line %d: wrong legacy size %zu", lineno, size);
+    memcpy(&legacy, packet, sizeof(legacy));
+
+    inference_stamped_t expected;
+    nextInference(&fields, &expected);
+    CHECK(legacy.type == INFERENCE_STAMPED_MSG && inferenceEqual(&legacy.inference_stamped, &expected), "line %d: legacy inference mismatch", lineno);
+    return;
+  }
+
+  bool valid = fits && frontnetMsgValidate(&msg, size);
+  CHECK(valid, "line %d: valid message rejected", lineno);
+  if (!valid) {
+    return;
+  }
+
+  frontnet_msg_header_t header;
+  if (strcmp(kind, "inference") == 0) {
+    nextHeader(&fields, INFERENCE_MSG, &header);
+
+    inference_stamped_t expected;
+    nextInference(&fields, &expected);
+    CHECK(inferenceEqual(&msg.inference.inference, &expected), "line %d: inference mismatch", lineno);
+
+    encodedSize = frontnetMsgInference(&encoded, &header, &expected);
+  } else if (strcmp(kind, "batch") == 0) {
+    nextHeader(&fields, INFERENCE_BATCH_MSG, &header);
+
+    int count = nextUint(&fields);
+    CHECK(count == msg.batch.count, "line %d: batch count mismatch", lineno);
+
+    inference_stamped_t expected[FN_MSG_BATCH_MAX_COUNT];
+    for (int i = 0; i < count && i < FN_MSG_BATCH_MAX_COUNT; i++) {
+      nextInference(&fields, &expected[i]);
+
+      // Decoded values are computed in single precision in C, in double precision in Python
+      inference_stamped_t inference;
+      frontnetMsgGetBatchInference(&msg, i, &inference);
+      CHECK(inference.stm32_timestamp == expected[i].stm32_timestamp
+         && fabsf(inference.x - expected[i].x) < 1e-6f && fabsf(inference.y - expected[i].y) < 1e-6f
+         && fabsf(inference.z - expected[i].z) < 1e-6f && fabsf(inference.phi - expected[i].phi) < 1e-6f
+         && inference.flags == expected[i].flags && inference.confidence == expected[i].confidence,
+         "line %d: batch inference %d mismatch", lineno, i);
+    }
+
+    encodedSize = frontnetMsgInferenceBatch(&encoded, &header, expected, count);
+  } else if (strcmp(kind, "target") == 0) {
+    nextHeader(&fields, TARGET_CONFIG_MSG, &header);
+
+    frontnet_target_t expected = {
+      .horizontalDistance = nextFloat(&fields),
+      .altitude = nextFloat(&fields),
+      .altitudeReference = nextUint(&fields),
+    };
+
+    frontnet_target_t target;
+    bool validTarget = frontnetMsgGetTargetConfig(&msg, &target);
+    CHECK(validTarget && target.horizontalDistance == expected.horizontalDistance && target.altitude == expected.altitude
+       && target.altitudeReference == expected.altitudeReference, "line %d: target mismatch", lineno);
+
+    encodedSize = frontnetMsgTargetConfig(&encoded, &header, &expected);
+  } else if (strcmp(kind, "ack") == 0) {
+    nextHeader(&fields, ACK_MSG, &header);
+
+    // Build the acknowledged message from the fields of the ack
+    frontnet_msg_t acked = {
+      .header = {
+        .source = header.source,
+        .sequence = header.sequence,
+      },
+    };
+    acked.header.type = nextUint(&fields);
+    acked.header.txTimestamp = nextUint(&fields);
+    uint32_t rxTimestamp = nextUint(&fields);
+    frontnet_ack_status_e status = nextUint(&fields);
+
+    CHECK(msg.ack.ackedType == acked.header.type && msg.ack.ackedTxTimestamp == acked.header.txTimestamp
+       && msg.ack.rxTimestamp == rxTimestamp && msg.ack.status == status, "line %d: ack mismatch", lineno);
+
+    encodedSize = frontnetMsgAck(&encoded, &acked, rxTimestamp, header.txTimestamp, status);
+  } else {
+    CHECK(false, "line %d: unknown vector kind %s", lineno, kind);
+    return;
+  }
+
+  CHECK(msg.header.type == header.type && msg.header.source == header.source
+     && msg.header.sequence == header.sequence && msg.header.txTimestamp == header.txTimestamp,
+     "line %d: header mismatch", lineno);
+  CHECK(encodedSize == size && memcmp(&encoded, packet, size) == 0, "line %d: encoded bytes mismatch", lineno);
+}
+
+static int checkVectors(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    exit(1);
+  }
+
+  int count = 0;
+  char line[MAX_LINE_LENGTH];
+  while (fgets(line, sizeof(line), file)) {
+    count++;
+    checkVector(count, line);
+  }
+
+  fclose(file);
+  return count;
+}
+
+static void checkLinkStats() {
+  frontnet_link_stats_t stats;
+  frontnetLinkStatsInit(&stats);
+
+  // In order, across the wraparound
+  CHECK(frontnetLinkStatsUpdate(&stats, 65534), "first message");
+  CHECK(frontnetLinkStatsUpdate(&stats, 65535), "in order");
+  CHECK(frontnetLinkStatsUpdate(&stats, 0), "wraparound");
+  CHECK(stats.lost == 0 && stats.reordered == 0, "no losses expected");
+
+  // 1 and 2 skipped, then 2 received late
+  CHECK(frontnetLinkStatsUpdate(&stats, 3), "gap");
+  CHECK(stats.lost == 2, "lost %u, expected 2", stats.lost);
+  CHECK(!frontnetLinkStatsUpdate(&stats, 2), "late message");
+  CHECK(stats.lost == 1 && stats.reordered == 1, "lost %u reordered %u, expected 1 1", stats.lost, stats.reordered);
+
+  // Sender restart
+  CHECK(frontnetLinkStatsUpdate(&stats, 30000), "restart");
+  CHECK(stats.lost == 1 && stats.restarts == 1 && stats.received == 6, "restart miscounted");
+
+  for (int i = 0; i < FN_LINK_STATS_WINDOW; i++) {
+    frontnetLinkStatsLatency(&stats, i == 3 ? 100 : 40);
+  }
+  CHECK(stats.latencyMean == 42 && stats.latencyMax == 100, "latency mean %u max %u", stats.latencyMean, stats.latencyMax);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    printf("Usage: %s VECTORS\n", argv[0]);
+    return 1;
+  }
+
+  int count = checkVectors(argv[1]);
+  checkLinkStats();
+
+  printf("%d vectors, %d failures\n", count, failures);
+  return failures > 0 ? 1 : 0;
+}
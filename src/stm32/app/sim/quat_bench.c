@@ -0,0 +1,192 @@
+// Micro-benchmark of the compressed state codec (quatcompress.h and the state compression done by
+// the stabilizer task), run with `make bench`. Reports the host time and cycles per call, and the
+// number of FPU divisions and square roots per call, which take 14 cycles each on the Cortex-M4
+// instead of 1 for the other single-precision operations. The reference implementations are the
+// original quatcompress.h, before removing its divisions.
+#include "quatcompress.h"
+#include "sim_os.h"
+
+#include "stabilizer.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#define INPUT_COUNT (4096)
+#define ROUNDS      (500)
+
+typedef struct bench_s {
+  const char *name;
+  void (*run)(int index);
+  int divisions;     // Per call, from the source code
+  int squareRoots;
+} bench_t;
+
+static float quaternions[INPUT_COUNT][4];
+static uint32_t codes[INPUT_COUNT];
+static state_t states[INPUT_COUNT];
+static stateCompressed_t compressedStates[INPUT_COUNT];
+
+static volatile uint32_t sink;
+
+static uint32_t quatcompressReference(float const q[4]) {
+  unsigned i_largest = 0;
+  for (unsigned i = 1; i < 4; ++i) {
+    if (fabsf(q[i]) > fabsf(q[i_largest])) {
+      i_largest = i;
+    }
+  }
+
+  unsigned negate = q[i_largest] < 0;
+
+  uint32_t comp = i_largest;
+  for (unsigned i = 0; i < 4; ++i) {
+    if (i != i_largest) {
+      unsigned negbit = (q[i] < 0) ^ negate;
+      unsigned mag = ((1 << 9) - 1) * (fabsf(q[i]) / (float)M_SQRT1_2) + 0.5f;
+      comp = (comp << 10) | (negbit << 9) | mag;
+    }
+  }
+
+  return comp;
+}
+
+static void quatdecompressReference(uint32_t comp, float q[4]) {
+  unsigned const mask = (1 << 9) - 1;
+
+  int const i_largest = comp >> 30;
+  float sum_squares = 0;
+  for (int i = 3; i >= 0; --i) {
+    if (i != i_largest) {
+      unsigned mag = comp & mask;
+      unsigned negbit = (comp >> 9) & 0x1;
+      comp = comp >> 10;
+      q[i] = ((float)M_SQRT1_2) * ((float)mag) / mask;
+      if (negbit == 1) {
+        q[i] = -q[i];
+      }
+      sum_squares += q[i] * q[i];
+    }
+  }
+  q[i_largest] = sqrtf(1.0f - sum_squares);
+}
+
+static void runCompressReference(int index) {
+  sink += quatcompressReference(quaternions[index]);
+}
+
+static void runCompress(int index) {
+  sink += quatcompress(quaternions[index]);
+}
+
+static void runDecompressReference(int index) {
+  float q[4];
+  quatdecompressReference(codes[index], q);
+  sink += (uint32_t)(q[0] * 1000.0f);
+}
+
+static void runDecompress(int index) {
+  float q[4];
+  quatdecompress(codes[index], q);
+  sink += (uint32_t)(q[0] * 1000.0f);
+}
+
+static void runStateCompress(int index) {
+  stateCompressed_t stateCompressed;
+  simCompressState(&states[index], &stateCompressed);
+  sink += stateCompressed.quat;
+}
+
+static void runStateDecompress(int index) {
+  state_t state;
+  stabilizerDecompressState(&compressedStates[index], &state);
+  sink += (uint32_t)(state.attitude.yaw * 1000.0f);
+}
+
+static const bench_t benchmarks[] = {
+  {"quatcompress (reference)",   runCompressReference,   3, 0},
+  {"quatcompress",               runCompress,            0, 0},
+  {"quatdecompress (reference)", runDecompressReference, 3, 1},
+  {"quatdecompress",             runDecompress,          0, 1},
+  {"state compress",             runStateCompress,       0, 0},
+  {"state decompress",           runStateDecompress,     0, 1},
+};
+
+static uint64_t nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void initInputs() {
+  uint32_t seed = 0x12345678;
+
+  for (int i = 0; i < INPUT_COUNT; i++) {
+    float norm = 0.0f;
+    for (int k = 0; k < 4; k++) {
+      seed = seed * 1664525 + 1013904223;
+      quaternions[i][k] = (seed >> 8) / (float)(1 << 23) - 1.0f;
+      norm += quaternions[i][k] * quaternions[i][k];
+    }
+
+    norm = sqrtf(norm);
+    for (int k = 0; k < 4; k++) {
+      quaternions[i][k] /= norm;
+    }
+
+    codes[i] = quatcompress(quaternions[i]);
+
+    states[i] = (state_t){
+      .position = {.x = 1.0f, .y = -0.5f, .z = 1.2f},
+      .velocity = {.x = 0.1f, .y = 0.2f, .z = -0.1f},
+      .acc = {.x = 0.01f, .y = -0.02f, .z = 0.0f},
+      .attitudeQuaternion = {.x = quaternions[i][0], .y = quaternions[i][1], .z = quaternions[i][2], .w = quaternions[i][3]},
+    };
+    simCompressState(&states[i], &compressedStates[i]);
+  }
+}
+
+static void runBench(const bench_t *bench) {
+  // Warm up caches and branch predictors
+  for (int i = 0; i < INPUT_COUNT; i++) {
+    bench->run(i);
+  }
+
+  uint64_t start = nowNs();
+#ifdef HAVE_TSC
+  uint64_t startCycles = __rdtsc();
+#endif
+
+  for (int round = 0; round < ROUNDS; round++) {
+    for (int i = 0; i < INPUT_COUNT; i++) {
+      bench->run(i);
+    }
+  }
+
+  double calls = (double)ROUNDS * INPUT_COUNT;
+  double ns = (nowNs() - start) / calls;
+#ifdef HAVE_TSC
+  double cycles = (__rdtsc() - startCycles) / calls;
+#else
+  double cycles = NAN;
+#endif
+
+  printf("%-28s %8.1f ns %8.1f cycles %6d %6d\n", bench->name, ns, cycles, bench->divisions, bench->squareRoots);
+}
+
+int main() {
+  initInputs();
+
+  printf("%-28s %11s %15s %6s %6s\n", "", "host", "host (TSC)", "VDIV", "VSQRT");
+  for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+    runBench(&benchmarks[i]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+// Checks quatcompress.h against the test vectors generated by the Python implementation
+// (aideck_cpx_streamer/test/data/quatcompress_vectors.txt), comparing the bit patterns of the
+// results. With -compress or -decompress, instead converts little-endian binary records from
+// stdin to stdout, so that test_quatcompress.py can compare the two implementations on millions
+// of inputs: float[4] quaternions to uint32_t codes, or uint32_t codes to float[4] quaternions.
+#include "quatcompress.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE_LENGTH (256)
+#define STREAM_BATCH    (4096)
+
+static int failures = 0;
+
+static uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Bit-exact, except that all NaNs are equal: their sign and payload depend on the FPU
+static bool sameFloat(float a, float b) {
+  return (isnan(a) && isnan(b)) || floatBits(a) == floatBits(b);
+}
+
+static void checkVector(int lineno, char *line) {
+  char kind[16];
+  uint32_t values[5];
+
+  if (line[0] == '#' || line[0] == '\n') {
+    return;
+  }
+
+  if (sscanf(line, "%15s %x %x %x %x %x", kind, &values[0], &values[1], &values[2], &values[3], &values[4]) != 6) {
+    printf("FAIL line %d: malformed vector\n", lineno);
+    failures++;
+    return;
+  }
+
+  if (strcmp(kind, "compress") == 0) {
+    float q[4];
+    for (int i = 0; i < 4; i++) {
+      q[i] = bitsFloat(values[i]);
+    }
+
+    uint32_t comp = quatcompress(q);
+    if (comp != values[4]) {
+      printf("FAIL line %d: compressed %08x, expected %08x\n", lineno, comp, values[4]);
+      failures++;
+    }
+  } else if (strcmp(kind, "decompress") == 0) {
+    float q[4];
+    quatdecompress(values[0], q);
+
+    for (int i = 0; i < 4; i++) {
+      if (!sameFloat(q[i], bitsFloat(values[i + 1]))) {
+        printf("FAIL line %d: q[%d] decompressed %08x, expected %08x\n", lineno, i, floatBits(q[i]), values[i + 1]);
+        failures++;
+        break;
+      }
+    }
+  } else {
+    printf("FAIL line %d: unknown vector kind %s\n", lineno, kind);
+    failures++;
+  }
+}
+
+static int checkVectors(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    exit(1);
+  }
+
+  int count = 0;
+  int lineno = 0;
+  char line[MAX_LINE_LENGTH];
+  while (fgets(line, sizeof(line), file)) {
+    lineno++;
+    if (line[0] != '#' && line[0] != '\n') {
+      count++;
+    }
+    checkVector(lineno, line);
+  }
+
+  fclose(file);
+  return count;
+}
+
+static void streamCompress() {
+  static float input[STREAM_BATCH][4];
+  static uint32_t output[STREAM_BATCH];
+
+  size_t count;
+  while ((count = fread(input, sizeof(input[0]), STREAM_BATCH, stdin)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      output[i] = quatcompress(input[i]);
+    }
+    fwrite(output, sizeof(output[0]), count, stdout);
+  }
+}
+
+static void streamDecompress() {
+  static uint32_t input[STREAM_BATCH];
+  static float output[STREAM_BATCH][4];
+
+  size_t count;
+  while ((count = fread(input, sizeof(input[0]), STREAM_BATCH, stdin)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      quatdecompress(input[i], output[i]);
+    }
+    fwrite(output, sizeof(output[0]), count, stdout);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    printf("Usage: %s VECTORS | -compress | -decompress\n", argv[0]);
+    return 1;
+  }
+
+  if (strcmp(argv[1], "-compress") == 0) {
+    streamCompress();
+    return 0;
+  } else if (strcmp(argv[1], "-decompress") == 0) {
+    streamDecompress();
+    return 0;
+  }
+
+  int count = checkVectors(argv[1]);
+
+  printf("%d vectors, %d failures\n", count, failures);
+  return failures > 0 ? 1 : 0;
+}
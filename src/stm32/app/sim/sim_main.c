@@ -0,0 +1,623 @@
+// Closed-loop simulator for the Frontnet follow-me logic. The same code that runs on the
+// Crazyflie (frontnet_follow.c, frontnet_kf.c, frontnet_ctrl.c, frontnet_state_history.c)
+// is driven by a point-mass quadrotor and a synthetic subject trajectory, with inferences
+// delivered with configurable latency, jitter, dropouts, noise and outliers.
+#include "sim_model.h"
+#include "sim_os.h"
+
+#include "frontnet_config.h"
+#include "frontnet_follow.h"
+#include "frontnet_state_history.h"
+#include "frontnet_telemetry.h"
+
+#include "stabilizer.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Simulation step, matches the tick rate (see M2T/T2M)
+#define SIM_STEP_MS (1)
+
+// Tracking errors are sampled at a lower rate than the simulation step, to save time
+#define SIM_METRICS_PERIOD_MS (10)
+
+#define SIM_MAX_PENDING_INFERENCES (256)
+
+// Fraction of the outliers flagged by the GAP8 inference filter, as measured by its host test
+// (src/gap/examples/pulp-frontnet/host/test_inference_filter.c)
+#define SIM_OUTLIER_RECALL (0.95f)
+
+typedef struct sim_config_s {
+  uint32_t durationMs;
+  uint32_t warmupMs;
+
+  float inferenceRate;  // [Hz]
+  float latencyMs;      // Mean latency from image capture to inference delivery [ms]
+  float jitterMs;       // Standard deviation of the latency [ms]
+  float dropout;        // Probability that an inference is lost [0-1]
+  float noisePosition;  // Standard deviation of the position noise [m]
+  float noisePhi;       // Standard deviation of the yaw noise [rad]
+  float outliers;       // Probability that an inference is a spurious detection [0-1]
+
+  sim_quad_params_t quad;
+  frontnet_follow_t follow;
+
+  // Telemetry of the first scenario, as binary records and as CSV
+  FILE *telemetryBin;
+  FILE *telemetryCsv;
+} sim_config_t;
+
+typedef struct sim_metrics_s {
+  float positionRmse;   // Drone vs ideal target position [m]
+  float positionMax;    // [m]
+  float yawRmse;        // Drone yaw vs direction of the subject [rad]
+  float kfRmse;         // Filtered vs true subject position [m]
+
+  uint32_t inferences;  // Generated inferences
+  uint32_t dropped;     // Lost in transit
+  uint32_t discarded;   // Received, but the corresponding state was not available anymore
+  uint32_t outliers;    // Spurious detections, flagged or not
+  uint32_t gated;       // Flagged as outliers and skipped
+  uint32_t hoverMs;     // Time spent hovering because of the inference timeout
+
+  float kfLatencyUs;    // Average duration of the Kalman filter update on the host [us]
+} sim_metrics_t;
+
+typedef struct sim_inference_s {
+  uint32_t deliveryTime;
+  inference_stamped_t inference;
+} sim_inference_t;
+
+static void idealTarget(const frontnet_target_t *config, const pose_t *subject, point_t *target) {
+  target->x = subject->position.x + cosf(subject->attitude.yaw) * config->horizontalDistance;
+  target->y = subject->position.y + sinf(subject->attitude.yaw) * config->horizontalDistance;
+  if (config->altitudeReference == SUBJECT_ALTITUDE_REF) {
+    target->z = subject->position.z + config->altitude;
+  } else {
+    target->z = config->altitude;
+  }
+}
+
+static void randomSubject(sim_rng_t *rng, sim_subject_params_t *subject) {
+  *subject = (sim_subject_params_t){
+    .cx = 0.0f,
+    .cy = 0.0f,
+    .z = 1.5f + 0.4f * simRngUniform(rng),
+    .ax = 0.5f + 1.5f * simRngUniform(rng),
+    .ay = 0.5f + 1.5f * simRngUniform(rng),
+    .fx = 0.02f + 0.08f * simRngUniform(rng),
+    .fy = 0.02f + 0.08f * simRngUniform(rng),
+    .phase = 2 * M_PI_F * simRngUniform(rng),
+    .yaw = normalizeAngle(2 * M_PI_F * simRngUniform(rng)),
+    .yawAmp = 0.5f * simRngUniform(rng),
+    .yawFreq = 0.02f + 0.08f * simRngUniform(rng),
+  };
+}
+
+// Inverse of computeSubjectPoseInOdomFrame: subject pose w.r.t. the drone, as predicted by the network
+static void perfectInference(const pose_t *subject, const sim_quad_t *quad, inference_stamped_t *inference) {
+  float sn = sinf(quad->yaw);
+  float cs = cosf(quad->yaw);
+  float dx = subject->position.x - quad->x;
+  float dy = subject->position.y - quad->y;
+
+  *inference = (inference_stamped_t){
+    .x =  cs * dx + sn * dy,
+    .y = -sn * dx + cs * dy,
+    .z = subject->position.z - quad->z,
+    .phi = normalizeAngle(subject->attitude.yaw - quad->yaw - M_PI_F),
+  };
+}
+
+static void writeTelemetry(const sim_config_t *config, const frontnet_follow_t *follow, bool controlEnabled) {
+  // Binary records are prefixed by their length, like app channel packets
+  frontnet_telemetry_t record;
+  uint8_t size = frontnetTelemetryInference(follow, controlEnabled, 0, &record);
+  fwrite(&size, sizeof(size), 1, config->telemetryBin);
+  fwrite(&record, size, 1, config->telemetryBin);
+
+  // Same format as the CSV lines previously printed by frontnetTask
+  const odometry_t *odom = &follow->subjectOdom;
+  fprintf(config->telemetryCsv, "%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d\n",
+    follow->inference.stm32_timestamp, follow->lastInference,
+    odom->pose.position.x, odom->pose.position.y, odom->pose.position.z, odom->pose.attitude.yaw,
+    odom->twist.linear.x, odom->twist.linear.y, odom->twist.linear.z, odom->twist.angular.yaw,
+    controlEnabled, follow->controlMode, 0
+  );
+}
+
+static void runScenario(const sim_config_t *config, uint64_t seed, bool recordTelemetry, sim_metrics_t *metrics) {
+  sim_rng_t rng;
+  simRngSeed(&rng, seed);
+
+  sim_subject_params_t subjectParams;
+  randomSubject(&rng, &subjectParams);
+
+  static stateCompressed_t historyBuffer[STATE_FWD_HISTORY_COUNT];
+  static sim_queue_t historyQueue;
+  stateHistoryInit(simQueueInit(&historyQueue, historyBuffer, STATE_FWD_HISTORY_COUNT, sizeof(stateCompressed_t)));
+
+  frontnet_follow_t follow = config->follow;
+
+  // Start at the ideal target, looking at the subject
+  pose_t subject;
+  point_t target;
+  simSubjectPose(&subjectParams, 0.0f, &subject);
+  idealTarget(&follow.target, &subject, &target);
+
+  sim_quad_t quad = {
+    .x = target.x, .y = target.y, .z = target.z,
+    .yaw = atan2f(subject.position.y - target.y, subject.position.x - target.x),
+  };
+
+  static sim_inference_t pending[SIM_MAX_PENDING_INFERENCES];
+  uint32_t nPending = 0;
+
+  uint32_t statePeriod = 1000 / STATE_FWD_RATE;
+  uint32_t timerPeriod = 1000 / FRONTNET_TIMER_RATE;
+  float capturePeriod = 1000.0f / config->inferenceRate;
+  float nextCapture = capturePeriod * simRngUniform(&rng);
+  uint32_t lastForwardedTimestamp = 0;
+
+  // Control is enabled once the first inference has been received
+  bool controlEnabled = false;
+  setpoint_t setpoint = {0};
+
+  double positionSse = 0.0, yawSse = 0.0, kfSse = 0.0;
+  uint32_t nSamples = 0, nKfSamples = 0;
+  uint64_t kfLatencySum = 0;
+  uint32_t nKfUpdates = 0;
+  *metrics = (sim_metrics_t){0};
+
+  // Ticks start at 1, a zero timestamp is used by the KF to detect its first update
+  for (uint32_t now = 1; now <= config->durationMs; now += SIM_STEP_MS) {
+    simSetTicks(now);
+    float t = now / 1000.0f;
+
+    bool forwardState = (now % statePeriod == 0);
+    bool capture = (now >= nextCapture);
+    bool timer = (now % timerPeriod == 0);
+    bool update = timer;
+    bool deliver = false;
+    for (uint32_t i = 0; i < nPending; i++) {
+      deliver |= (pending[i].deliveryTime <= now);
+    }
+
+    // Most ticks only advance the quadrotor model, the firmware modules run at lower rates
+    if (forwardState || capture || update || deliver) {
+      // Stabilizer loop, the latest state is only computed when the firmware modules need it
+      state_t trueState;
+      stateCompressed_t stateCompressed;
+      simQuadGetState(&quad, now, &trueState);
+      simCompressState(&trueState, &stateCompressed);
+      simSetLatestState(&stateCompressed);
+
+      // State forwarding to GAP8, which stamps the camera frames with the latest state it received
+      if (forwardState) {
+        stateHistoryPush(&stateCompressed);
+        lastForwardedTimestamp = now;
+      }
+
+      // Image capture and inference on GAP8
+      if (capture) {
+        simSubjectPose(&subjectParams, t, &subject);
+        nextCapture += capturePeriod;
+        metrics->inferences++;
+
+        // Inferences still in transit when the pending list is full are lost as well
+        if (lastForwardedTimestamp == 0 || simRngUniform(&rng) < config->dropout || nPending == SIM_MAX_PENDING_INFERENCES) {
+          metrics->dropped++;
+        } else {
+          sim_inference_t *entry = &pending[nPending++];
+          perfectInference(&subject, &quad, &entry->inference);
+          entry->inference.stm32_timestamp = lastForwardedTimestamp;
+          entry->inference.x += config->noisePosition * simRngGaussian(&rng);
+          entry->inference.y += config->noisePosition * simRngGaussian(&rng);
+          entry->inference.z += config->noisePosition * simRngGaussian(&rng);
+          entry->inference.phi = normalizeAngle(entry->inference.phi + config->noisePhi * simRngGaussian(&rng));
+
+          // Spurious detection, e.g. of another person, 0.5-1.5m away from the subject
+          if (config->outliers > 0.0f && simRngUniform(&rng) < config->outliers) {
+            float direction = 2 * M_PI_F * simRngUniform(&rng);
+            float distance = 0.5f + simRngUniform(&rng);
+            entry->inference.x += distance * cosf(direction);
+            entry->inference.y += distance * sinf(direction);
+            entry->inference.phi = normalizeAngle(entry->inference.phi + 2.0f * (simRngUniform(&rng) - 0.5f));
+            metrics->outliers++;
+
+            if (simRngUniform(&rng) < SIM_OUTLIER_RECALL) {
+              entry->inference.flags |= INFERENCE_FLAG_OUTLIER;
+            }
+          }
+
+          float latency = config->latencyMs + config->jitterMs * simRngGaussian(&rng);
+          entry->deliveryTime = now + (uint32_t)fmaxf(latency, 0.0f);
+        }
+      }
+
+      // Frontnet task, inferences are processed as soon as they are delivered
+      state_t state;
+      stabilizerDecompressState(&stateCompressed, &state);
+
+      for (uint32_t i = 0; deliver && i < nPending;) {
+        if (pending[i].deliveryTime > now) {
+          i++;
+          continue;
+        }
+
+        bool inferenceUsed = frontnetFollowInference(&follow, &pending[i].inference, &state, now);
+        kfLatencySum += follow.kfLatencyUs;
+        nKfUpdates++;
+
+        if (inferenceUsed) {
+          controlEnabled = true;
+          update = true;
+
+          if (recordTelemetry) {
+            writeTelemetry(config, &follow, controlEnabled);
+          }
+        } else if (follow.gateOutliers && (pending[i].inference.flags & INFERENCE_FLAG_OUTLIER)) {
+          metrics->gated++;
+        } else {
+          metrics->discarded++;
+        }
+
+        pending[i] = pending[--nPending];
+      }
+
+      if (timer) {
+        frontnetFollowPredict(&follow, &state, now);
+      }
+
+      if (update) {
+        frontnetFollowCheckTimeout(&follow, controlEnabled, &state, now);
+        if (controlEnabled) {
+          frontnetFollowSetpoint(&follow, &state, &setpoint);
+        }
+      }
+    }
+
+    simQuadStep(&quad, &config->quad, &setpoint, SIM_STEP_MS / 1000.0f);
+
+    if (now < config->warmupMs || now % SIM_METRICS_PERIOD_MS != 0) {
+      continue;
+    }
+
+    // Tracking error metrics
+    simSubjectPose(&subjectParams, t, &subject);
+    idealTarget(&follow.target, &subject, &target);
+    float positionError = sqrtf(fsqr(quad.x - target.x) + fsqr(quad.y - target.y) + fsqr(quad.z - target.z));
+    float desiredYaw = atan2f(subject.position.y - quad.y, subject.position.x - quad.x);
+    float yawError = normalizeAngle(desiredYaw - quad.yaw);
+
+    positionSse += fsqr(positionError);
+    yawSse += fsqr(yawError);
+    nSamples++;
+    metrics->positionMax = fmaxf(metrics->positionMax, positionError);
+
+    if (controlEnabled) {
+      // The filtered subject pose refers to the time the corresponding image was captured
+      pose_t kfSubject;
+      const point_t *kfPosition = &follow.subjectOdom.pose.position;
+      simSubjectPose(&subjectParams, kfPosition->timestamp / 1000.0f, &kfSubject);
+      kfSse += fsqr(kfPosition->x - kfSubject.position.x) + fsqr(kfPosition->y - kfSubject.position.y) + fsqr(kfPosition->z - kfSubject.position.z);
+      nKfSamples++;
+    }
+
+    if (follow.controlMode == HOVER_CTRL_MODE) {
+      metrics->hoverMs += SIM_METRICS_PERIOD_MS;
+    }
+  }
+
+  metrics->positionRmse = nSamples ? sqrt(positionSse / nSamples) : 0.0f;
+  metrics->yawRmse = nSamples ? sqrt(yawSse / nSamples) : 0.0f;
+  metrics->kfRmse = nKfSamples ? sqrt(kfSse / nKfSamples) : 0.0f;
+  metrics->kfLatencyUs = nKfUpdates ? (float)kfLatencySum / nKfUpdates : 0.0f;
+
+  if (recordTelemetry) {
+    // Workers exit without flushing stdio buffers
+    fflush(config->telemetryBin);
+    fflush(config->telemetryCsv);
+  }
+}
+
+// Run scenarios [seed, seed + nScenarios) on nWorkers processes, the firmware modules keep their state
+// in globals so they cannot be shared by multiple threads. Results are stored in scenario order.
+static bool runScenarios(const sim_config_t *config, uint64_t seed, uint32_t nScenarios, uint32_t nWorkers, sim_metrics_t *results) {
+  if (nWorkers <= 1) {
+    for (uint32_t i = 0; i < nScenarios; i++) {
+      runScenario(config, seed + i, i == 0 && config->telemetryBin, &results[i]);
+    }
+    return true;
+  }
+
+  size_t size = nScenarios * sizeof(sim_metrics_t);
+  sim_metrics_t *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    perror("mmap");
+    return false;
+  }
+
+  bool success = true;
+  for (uint32_t worker = 0; worker < nWorkers; worker++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      success = false;
+      break;
+    }
+
+    if (pid == 0) {
+      for (uint32_t i = worker; i < nScenarios; i += nWorkers) {
+        runScenario(config, seed + i, i == 0 && config->telemetryBin, &shared[i]);
+      }
+      _exit(0);
+    }
+  }
+
+  int status;
+  while (wait(&status) > 0) {
+    success &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+  memcpy(results, shared, size);
+  munmap(shared, size);
+  return success;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -n N              number of scenarios (default: 1000)\n"
+    "  -j N              number of worker processes (default: number of CPUs)\n"
+    "  -seed S           seed of the first scenario, scenario i uses S+i (default: 0)\n"
+    "  -duration S       duration of each scenario [s] (default: 20)\n"
+    "  -warmup S         time excluded from the metrics [s] (default: 5)\n"
+    "  -rate HZ          inference rate [Hz] (default: 48)\n"
+    "  -latency MS       mean inference latency [ms] (default: 40)\n"
+    "  -jitter MS        standard deviation of the inference latency [ms] (default: 5)\n"
+    "  -dropout P        probability of losing an inference (default: 0.05)\n"
+    "  -noise M          standard deviation of the position noise [m] (default: 0.1)\n"
+    "  -noise-phi RAD    standard deviation of the yaw noise [rad] (default: 0.25)\n"
+    "  -outliers P       probability that an inference is a spurious detection, flagged as GAP8 would (default: 0)\n"
+    "  -no-gate          use the inferences flagged as outliers (frontnet.gate_outliers = 0)\n"
+    "  -tau S            controller linear time constant (frontnet.eta)\n"
+    "  -k K              controller velocity feed-forward gain (frontnet.k)\n"
+    "  -rotation-tau S   controller angular time constant (frontnet.rotation_tau)\n"
+    "  -kf-q SCALE       scale the process noise of the Kalman filter\n"
+    "  -kf-r SCALE       scale the observation noise of the Kalman filter\n"
+    "  -kf-model MODEL   Kalman filter model, d1 (decoupled constant-velocity) or ca (joint constant-acceleration)\n"
+    "  -no-kf            bypass the Kalman filter\n"
+    "  -latest-state     use the latest state instead of the inference-time state (frontnet.infer_t_state = 0)\n"
+    "  -csv FILE         save per-scenario metrics to FILE\n"
+    "  -telemetry PREFIX save the telemetry of the first scenario to PREFIX.bin (binary) and PREFIX.csv\n"
+    "  -max-rmse M       exit with an error if the mean position RMSE exceeds M [m]\n",
+    name
+  );
+}
+
+int main(int argc, char **argv) {
+  sim_config_t config = {
+    .durationMs = 20000,
+    .warmupMs = 5000,
+    .inferenceRate = 48.0f,
+    .latencyMs = 40.0f,
+    .jitterMs = 5.0f,
+    .dropout = 0.05f,
+    .noisePosition = 0.1f,
+    .noisePhi = 0.25f,
+    .outliers = 0.0f,
+    .quad = SIM_QUAD_DEFAULT_PARAMS,
+    .follow = FRONTNET_FOLLOW_DEFAULT_CONFIG,
+  };
+
+  uint32_t nScenarios = 1000;
+  long nWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+  uint64_t seed = 0;
+  float kfQScale = 1.0f;
+  float kfRScale = 1.0f;
+  const char *csvPath = NULL;
+  const char *telemetryPrefix = NULL;
+  float maxRmse = INFINITY;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    bool hasValue = true;
+
+    if (!strcmp(arg, "-no-kf")) {
+      config.follow.kf.bypassFilter = true;
+      hasValue = false;
+    } else if (!strcmp(arg, "-latest-state")) {
+      config.follow.useInferenceTimeState = false;
+      hasValue = false;
+    } else if (!strcmp(arg, "-no-gate")) {
+      config.follow.gateOutliers = false;
+      hasValue = false;
+    } else if (!value) {
+      usage(argv[0]);
+      return 1;
+    } else if (!strcmp(arg, "-n")) {
+      nScenarios = strtoul(value, NULL, 0);
+    } else if (!strcmp(arg, "-j")) {
+      nWorkers = strtol(value, NULL, 0);
+    } else if (!strcmp(arg, "-seed")) {
+      seed = strtoull(value, NULL, 0);
+    } else if (!strcmp(arg, "-duration")) {
+      config.durationMs = 1000 * atof(value);
+    } else if (!strcmp(arg, "-warmup")) {
+      config.warmupMs = 1000 * atof(value);
+    } else if (!strcmp(arg, "-rate")) {
+      config.inferenceRate = atof(value);
+    } else if (!strcmp(arg, "-latency")) {
+      config.latencyMs = atof(value);
+    } else if (!strcmp(arg, "-jitter")) {
+      config.jitterMs = atof(value);
+    } else if (!strcmp(arg, "-dropout")) {
+      config.dropout = atof(value);
+    } else if (!strcmp(arg, "-noise")) {
+      config.noisePosition = atof(value);
+    } else if (!strcmp(arg, "-noise-phi")) {
+      config.noisePhi = atof(value);
+    } else if (!strcmp(arg, "-outliers")) {
+      config.outliers = atof(value);
+    } else if (!strcmp(arg, "-tau")) {
+      config.follow.ctrl.linearTau = atof(value);
+    } else if (!strcmp(arg, "-k")) {
+      config.follow.ctrl.linearK = atof(value);
+    } else if (!strcmp(arg, "-rotation-tau")) {
+      config.follow.ctrl.angularTau = atof(value);
+    } else if (!strcmp(arg, "-kf-model")) {
+      if (!strcmp(value, "d1")) {
+        config.follow.kf.model = KF_D1_MODEL;
+      } else if (!strcmp(value, "ca")) {
+        config.follow.kf.model = KF_CA_MODEL;
+      } else {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (!strcmp(arg, "-kf-q")) {
+      kfQScale = atof(value);
+    } else if (!strcmp(arg, "-kf-r")) {
+      kfRScale = atof(value);
+    } else if (!strcmp(arg, "-csv")) {
+      csvPath = value;
+    } else if (!strcmp(arg, "-telemetry")) {
+      telemetryPrefix = value;
+    } else if (!strcmp(arg, "-max-rmse")) {
+      maxRmse = atof(value);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+
+    if (hasValue) {
+      i++;
+    }
+  }
+
+  if (config.inferenceRate <= 0.0f || nScenarios == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  kf_d1_t *axes[] = {&config.follow.kf.x, &config.follow.kf.y, &config.follow.kf.z, &config.follow.kf.phi};
+  for (int i = 0; i < 4; i++) {
+    axes[i]->q_vv *= kfQScale;
+    axes[i]->r_xx *= kfRScale;
+    config.follow.kf.ca.q[i] *= kfQScale;
+  }
+
+  FILE *csv = NULL;
+  if (csvPath) {
+    csv = fopen(csvPath, "w");
+    if (!csv) {
+      perror(csvPath);
+      return 1;
+    }
+    fprintf(csv, "seed,position_rmse,position_max,yaw_rmse,kf_rmse,inferences,dropped,discarded,hover_ms,outliers,gated\n");
+  }
+
+  if (telemetryPrefix) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s.bin", telemetryPrefix);
+    config.telemetryBin = fopen(path, "wb");
+    snprintf(path, sizeof(path), "%s.csv", telemetryPrefix);
+    config.telemetryCsv = fopen(path, "w");
+
+    if (!config.telemetryBin || !config.telemetryCsv) {
+      perror(telemetryPrefix);
+      return 1;
+    }
+
+    fprintf(config.telemetryCsv, "state_stm32_timestamp,inference_stm32_timestamp,kf_x,kf_y,kf_z,kf_phi,kf_vx,kf_vy,kf_vz,kf_vphi,ctrl_enabled,ctrl_mode,setpoint_priority\n");
+    fflush(config.telemetryCsv);
+  }
+
+  sim_metrics_t *results = calloc(nScenarios, sizeof(sim_metrics_t));
+  if (!results) {
+    perror("calloc");
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (!runScenarios(&config, seed, nScenarios, nWorkers, results)) {
+    fprintf(stderr, "Simulation failed\n");
+    return 1;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  sim_metrics_t sum = {0};
+  sim_metrics_t worst = {0};
+
+  for (uint32_t i = 0; i < nScenarios; i++) {
+    const sim_metrics_t *metrics = &results[i];
+
+    if (csv) {
+      fprintf(csv, "%llu,%.4f,%.4f,%.4f,%.4f,%u,%u,%u,%u,%u,%u\n",
+        (unsigned long long)(seed + i), metrics->positionRmse, metrics->positionMax, metrics->yawRmse, metrics->kfRmse,
+        metrics->inferences, metrics->dropped, metrics->discarded, metrics->hoverMs, metrics->outliers, metrics->gated
+      );
+    }
+
+    sum.positionRmse += metrics->positionRmse;
+    sum.positionMax += metrics->positionMax;
+    sum.yawRmse += metrics->yawRmse;
+    sum.kfRmse += metrics->kfRmse;
+    sum.inferences += metrics->inferences;
+    sum.dropped += metrics->dropped;
+    sum.discarded += metrics->discarded;
+    sum.outliers += metrics->outliers;
+    sum.gated += metrics->gated;
+    sum.hoverMs += metrics->hoverMs;
+    sum.kfLatencyUs += metrics->kfLatencyUs;
+
+    worst.positionRmse = fmaxf(worst.positionRmse, metrics->positionRmse);
+    worst.positionMax = fmaxf(worst.positionMax, metrics->positionMax);
+    worst.yawRmse = fmaxf(worst.yawRmse, metrics->yawRmse);
+    worst.kfRmse = fmaxf(worst.kfRmse, metrics->kfRmse);
+  }
+
+  free(results);
+
+  if (telemetryPrefix) {
+    fclose(config.telemetryBin);
+    fclose(config.telemetryCsv);
+  }
+
+  if (csv) {
+    fclose(csv);
+  }
+
+  float meanPositionRmse = sum.positionRmse / nScenarios;
+
+  printf("scenarios:     %u (%.1fs each, %.0f scenarios/s on %ld workers)\n", nScenarios, config.durationMs / 1000.0f, nScenarios / elapsed, nWorkers);
+  printf("                  mean     worst\n");
+  printf("position RMSE: %7.3fm  %7.3fm\n", meanPositionRmse, worst.positionRmse);
+  printf("position max:  %7.3fm  %7.3fm\n", sum.positionMax / nScenarios, worst.positionMax);
+  printf("yaw RMSE:      %7.2fdeg %6.2fdeg\n", degrees(sum.yawRmse / nScenarios), degrees(worst.yawRmse));
+  printf("KF RMSE:       %7.3fm  %7.3fm\n", sum.kfRmse / nScenarios, worst.kfRmse);
+  printf("inferences:    %u, dropped %u, discarded %u\n", sum.inferences, sum.dropped, sum.discarded);
+  printf("outliers:      %u, gated %u\n", sum.outliers, sum.gated);
+  printf("hovering:      %.2fs per scenario\n", sum.hoverMs / 1000.0f / nScenarios);
+  printf("KF update:     %.3fus on the host\n", sum.kfLatencyUs / nScenarios);
+
+  if (meanPositionRmse > maxRmse) {
+    fprintf(stderr, "Mean position RMSE %.3fm exceeds %.3fm\n", meanPositionRmse, maxRmse);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "sim_model.h"
+
+#include "frontnet_types.h"
+
+#include "math3d.h"
+
+#include <math.h>
+#include <stdint.h>
+
+static float firstOrder(float value, float target, float tau, float dt) {
+  return value + (target - value) * fminf(dt / tau, 1.0f);
+}
+
+void simQuadStep(sim_quad_t *quad, const sim_quad_params_t *params, const setpoint_t *setpoint, float dt) {
+  // Desired velocity from either velocity or position setpoints
+  float *position[3] = {&quad->x, &quad->y, &quad->z};
+  float *velocity[3] = {&quad->vx, &quad->vy, &quad->vz};
+  float *acceleration[3] = {&quad->ax, &quad->ay, &quad->az};
+  const stab_mode_t modes[3] = {setpoint->mode.x, setpoint->mode.y, setpoint->mode.z};
+  const float velocitySetpoint[3] = {setpoint->velocity.x, setpoint->velocity.y, setpoint->velocity.z};
+  const float positionSetpoint[3] = {setpoint->position.x, setpoint->position.y, setpoint->position.z};
+
+  float acc[3];
+  for (int i = 0; i < 3; i++) {
+    float desiredVelocity = 0.0f;
+    if (modes[i] == modeVelocity) {
+      desiredVelocity = velocitySetpoint[i];
+    } else if (modes[i] == modeAbs) {
+      desiredVelocity = params->positionGain * (positionSetpoint[i] - *position[i]);
+    }
+
+    acc[i] = (desiredVelocity - *velocity[i]) / params->velocityTau;
+  }
+
+  // Limit the acceleration magnitude, preserving its direction
+  float accNorm = sqrtf(fsqr(acc[0]) + fsqr(acc[1]) + fsqr(acc[2]));
+  if (accNorm > params->maxAcc) {
+    for (int i = 0; i < 3; i++) {
+      acc[i] *= params->maxAcc / accNorm;
+    }
+  }
+
+  for (int i = 0; i < 3; i++) {
+    *position[i] += *velocity[i] * dt + 0.5f * acc[i] * fsqr(dt);
+    *velocity[i] += acc[i] * dt;
+    *acceleration[i] = acc[i];
+  }
+
+  // NOTE: the firmware uses degrees and degree/s for attitudes and attitude rates in its data types (state_t and setpoint_t)
+  float desiredYawRate = 0.0f;
+  if (setpoint->mode.yaw == modeVelocity) {
+    desiredYawRate = radians(setpoint->attitudeRate.yaw);
+  } else if (setpoint->mode.yaw == modeAbs) {
+    desiredYawRate = params->positionGain * normalizeAngle(radians(setpoint->attitude.yaw) - quad->yaw);
+  }
+
+  quad->yawRate = firstOrder(quad->yawRate, desiredYawRate, params->yawRateTau, dt);
+  quad->yaw = normalizeAngle(quad->yaw + quad->yawRate * dt);
+}
+
+void simQuadGetState(const sim_quad_t *quad, uint32_t timestamp, state_t *state) {
+  state->position = (point_t){.timestamp = timestamp, .x = quad->x, .y = quad->y, .z = quad->z};
+  state->velocity = (velocity_t){.timestamp = timestamp, .x = quad->vx, .y = quad->vy, .z = quad->vz};
+
+  // Accelerations are expressed in Gs, without gravity
+  state->acc = (acc_t){.timestamp = timestamp, .x = quad->ax / 9.81f, .y = quad->ay / 9.81f, .z = quad->az / 9.81f};
+
+  // Level flight, roll and pitch are neglected
+  state->attitude = (attitude_t){.timestamp = timestamp, .roll = 0.0f, .pitch = 0.0f, .yaw = degrees(quad->yaw)};
+  state->attitudeQuaternion = (quaternion_t){
+    .timestamp = timestamp,
+    .x = 0.0f,
+    .y = 0.0f,
+    .z = sinf(quad->yaw / 2),
+    .w = cosf(quad->yaw / 2),
+  };
+}
+
+void simSubjectPose(const sim_subject_params_t *params, float t, pose_t *pose) {
+  float omegaX = 2 * M_PI_F * params->fx;
+  float omegaY = 2 * M_PI_F * params->fy;
+  float omegaYaw = 2 * M_PI_F * params->yawFreq;
+
+  pose->position.x = params->cx + params->ax * sinf(omegaX * t);
+  pose->position.y = params->cy + params->ay * sinf(omegaY * t + params->phase);
+  pose->position.z = params->z;
+
+  pose->attitude.roll = 0.0f;
+  pose->attitude.pitch = 0.0f;
+  pose->attitude.yaw = normalizeAngle(params->yaw + params->yawAmp * sinf(omegaYaw * t));
+}
+
+void simRngSeed(sim_rng_t *rng, uint64_t seed) {
+  // State must be non-zero
+  rng->state = seed * 0x9E3779B97F4A7C15ull + 1;
+}
+
+static uint64_t simRngNext(sim_rng_t *rng) {
+  uint64_t x = rng->state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  rng->state = x;
+  return x * 0x2545F4914F6CDD1Dull;
+}
+
+float simRngUniform(sim_rng_t *rng) {
+  // Uniform in [0, 1)
+  return (simRngNext(rng) >> 40) / (float)(1 << 24);
+}
+
+float simRngGaussian(sim_rng_t *rng) {
+  // Box-Muller transform, standard normal distribution
+  float u1 = 1.0f - simRngUniform(rng);
+  float u2 = simRngUniform(rng);
+  return sqrtf(-2.0f * logf(u1)) * cosf(2 * M_PI_F * u2);
+}
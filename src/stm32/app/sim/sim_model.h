@@ -0,0 +1,59 @@
+// Simple models used by the simulator: a point-mass quadrotor tracking the commander
+// setpoints, a parametric subject trajectory and a deterministic random number generator.
+#pragma once
+
+#include "frontnet_types.h"
+#include "stabilizer_types.h"
+
+#include <stdint.h>
+
+typedef struct sim_quad_params_s {
+  float velocityTau;   // Time constant of the velocity controller [s]
+  float yawRateTau;    // Time constant of the yaw rate controller [s]
+  float maxAcc;        // Maximum horizontal and vertical acceleration [m/s^2]
+  float positionGain;  // Gain of the position controller, used for modeAbs setpoints [1/s]
+} sim_quad_params_t;
+
+#define SIM_QUAD_DEFAULT_PARAMS ((sim_quad_params_t){ \
+  .velocityTau = 0.15f,                               \
+  .yawRateTau = 0.1f,                                 \
+  .maxAcc = 6.0f,                                     \
+  .positionGain = 2.0f                                \
+})
+
+typedef struct sim_quad_s {
+  float x, y, z;        // [m]
+  float yaw;            // [rad]
+  float vx, vy, vz;     // [m/s]
+  float yawRate;        // [rad/s]
+  float ax, ay, az;     // [m/s^2]
+} sim_quad_t;
+
+// Advance the quadrotor by dt [s], tracking setpoint like the firmware's PID controller would
+void simQuadStep(sim_quad_t *quad, const sim_quad_params_t *params, const setpoint_t *setpoint, float dt);
+
+// Fill the state estimate as produced by the stabilizer (noiseless)
+void simQuadGetState(const sim_quad_t *quad, uint32_t timestamp, state_t *state);
+
+typedef struct sim_subject_params_s {
+  float cx, cy, z;      // Center of the trajectory [m]
+  float ax, ay;         // Amplitude [m]
+  float fx, fy;         // Frequency [Hz]
+  float phase;          // Phase of the y component [rad]
+
+  float yaw;            // Mean yaw [rad]
+  float yawAmp;         // Yaw amplitude [rad]
+  float yawFreq;        // Yaw frequency [Hz]
+} sim_subject_params_t;
+
+// Pose of the subject at time t [s]
+void simSubjectPose(const sim_subject_params_t *params, float t, pose_t *pose);
+
+// xorshift64*, deterministic across platforms for a given seed
+typedef struct sim_rng_s {
+  uint64_t state;
+} sim_rng_t;
+
+void simRngSeed(sim_rng_t *rng, uint64_t seed);
+float simRngUniform(sim_rng_t *rng);
+float simRngGaussian(sim_rng_t *rng);
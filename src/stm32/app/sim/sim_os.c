@@ -0,0 +1,154 @@
+#include "sim_os.h"
+
+#include "math3d.h"
+#include "quatcompress.h"
+#include "stabilizer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint32_t ticks = 0;
+static stateCompressed_t latestState;
+
+frontnet_queue_t simQueueInit(sim_queue_t *queue, void *buffer, uint32_t length, uint32_t itemSize) {
+  *queue = (sim_queue_t){
+    .buffer = buffer,
+    .length = length,
+    .itemSize = itemSize,
+  };
+  return queue;
+}
+
+bool frontnetQueueSend(frontnet_queue_t _queue, const void *item) {
+  sim_queue_t *queue = _queue;
+  if (queue->count == queue->length) {
+    return false;
+  }
+
+  uint32_t tail = (queue->head + queue->count) % queue->length;
+  memcpy(queue->buffer + tail * queue->itemSize, item, queue->itemSize);
+  queue->count++;
+  return true;
+}
+
+bool frontnetQueuePeek(frontnet_queue_t _queue, void *item) {
+  sim_queue_t *queue = _queue;
+  if (queue->count == 0) {
+    return false;
+  }
+
+  memcpy(item, queue->buffer + queue->head * queue->itemSize, queue->itemSize);
+  return true;
+}
+
+bool frontnetQueueReceive(frontnet_queue_t _queue, void *item) {
+  sim_queue_t *queue = _queue;
+  if (!frontnetQueuePeek(queue, item)) {
+    return false;
+  }
+
+  queue->head = (queue->head + 1) % queue->length;
+  queue->count--;
+  return true;
+}
+
+uint32_t frontnetGetTicks() {
+  return ticks;
+}
+
+uint64_t frontnetUsecTimestamp() {
+  // Only used for profiling, measure the actual execution time on the host
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void frontnetGetLatestState(stateCompressed_t *state) {
+  *state = latestState;
+}
+
+void simSetTicks(uint32_t _ticks) {
+  ticks = _ticks;
+}
+
+void simSetLatestState(const stateCompressed_t *state) {
+  latestState = *state;
+}
+
+void simCompressState(const state_t *state, stateCompressed_t *stateCompressed) {
+  stateCompressed->timestamp = state->position.timestamp;
+
+  stateCompressed->x = state->position.x * 1000.0f;
+  stateCompressed->y = state->position.y * 1000.0f;
+  stateCompressed->z = state->position.z * 1000.0f;
+
+  stateCompressed->vx = state->velocity.x * 1000.0f;
+  stateCompressed->vy = state->velocity.y * 1000.0f;
+  stateCompressed->vz = state->velocity.z * 1000.0f;
+
+  stateCompressed->ax = state->acc.x * 9.81f * 1000.0f;
+  stateCompressed->ay = state->acc.y * 9.81f * 1000.0f;
+  stateCompressed->az = (state->acc.z + 1) * 9.81f * 1000.0f;
+
+  float const q[4] = {
+    state->attitudeQuaternion.x,
+    state->attitudeQuaternion.y,
+    state->attitudeQuaternion.z,
+    state->attitudeQuaternion.w};
+  stateCompressed->quat = quatcompress(q);
+
+  stateCompressed->rateRoll = 0;
+  stateCompressed->ratePitch = 0;
+  stateCompressed->rateYaw = 0;
+}
+
+// Same as stabilizerDecompressState in stabilizer.c, which cannot be built on the host
+void stabilizerDecompressState(const stateCompressed_t *stateCompressed, state_t *state) {
+  // Multiply by the inverse scales, divisions take 14 cycles on the Cortex-M4 FPU
+  float const milli = 1.0f / 1000.0f;
+  float const milliG = 1.0f / (9.81f * 1000.0f);
+
+  state->position.timestamp = stateCompressed->timestamp;
+  state->position.x = stateCompressed->x * milli;
+  state->position.y = stateCompressed->y * milli;
+  state->position.z = stateCompressed->z * milli;
+
+  state->velocity.timestamp = stateCompressed->timestamp;
+  state->velocity.x = stateCompressed->vx * milli;
+  state->velocity.y = stateCompressed->vy * milli;
+  state->velocity.z = stateCompressed->vz * milli;
+
+  state->acc.timestamp = stateCompressed->timestamp;
+  state->acc.x = stateCompressed->ax * milliG;
+  state->acc.y = stateCompressed->ay * milliG;
+  state->acc.z = stateCompressed->az * milliG - 1.0f;
+
+  float q[4];
+  quatdecompress(stateCompressed->quat, q);
+  state->attitudeQuaternion.timestamp = stateCompressed->timestamp;
+  state->attitudeQuaternion.x = q[0];
+  state->attitudeQuaternion.y = q[1];
+  state->attitudeQuaternion.z = q[2];
+  state->attitudeQuaternion.w = q[3];
+
+  {
+    quaternion_t q = state->attitudeQuaternion;
+    float yaw   = atan2f( 2*(q.x*q.y + q.w*q.z), q.w*q.w + q.x*q.x - q.y*q.y - q.z*q.z);
+    float pitch =  asinf(-2*(q.x*q.z - q.w*q.y));
+    float roll  = atan2f( 2*(q.y*q.z + q.w*q.x), q.w*q.w - q.x*q.x - q.y*q.y + q.z*q.z);
+
+    state->attitude.timestamp = stateCompressed->timestamp;
+    state->attitude.yaw = degrees(yaw);
+    state->attitude.pitch = -degrees(pitch);
+    state->attitude.roll = degrees(roll);
+  }
+}
+
+void assertFail(char *exp, char *file, int line) {
+  fprintf(stderr, "Assert failed %s:%d: %s\n", file, line, exp);
+  abort();
+}
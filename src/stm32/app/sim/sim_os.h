@@ -0,0 +1,26 @@
+// Host implementation of frontnet_os.h, used by the simulator in place of FreeRTOS.
+// Time is simulated and advanced explicitly by the simulation loop (1 tick = 1 ms).
+#pragma once
+
+#include "frontnet_os.h"
+#include "stabilizer_types.h"
+
+#include <stdint.h>
+
+typedef struct sim_queue_s {
+  uint8_t *buffer;
+  uint32_t length;
+  uint32_t itemSize;
+
+  uint32_t head;
+  uint32_t count;
+} sim_queue_t;
+
+// Initialize a FIFO queue of length items of itemSize bytes each, stored in buffer
+frontnet_queue_t simQueueInit(sim_queue_t *queue, void *buffer, uint32_t length, uint32_t itemSize);
+
+void simSetTicks(uint32_t ticks);
+void simSetLatestState(const stateCompressed_t *state);
+
+// Inverse of stabilizerDecompressState, mirrors the compression done by the stabilizer task
+void simCompressState(const state_t *state, stateCompressed_t *stateCompressed);
@@ -1,61 +1,212 @@
+#include "frontnet_appchannel.h"
 #include "frontnet_config.h"
 #include "frontnet_inference.h"
+#include "frontnet_msg.h"
+#include "frontnet_telemetry.h"
 // #include "frontnet_types.h"
 
 #define DEBUG_MODULE "FN-APPCHANNEL"
 
 #include "app_channel.h"
 #include "debug.h"
+#include "log.h"
 
 #include "FreeRTOS.h"
+#include "queue.h"
 #include "static_mem.h"
 #include "system.h"
 #include "task.h"
 
 #include <string.h>
 
-typedef enum {
-  INFERENCE_STAMPED_MSG  = 0,
-} __attribute__((packed)) frontnet_msg_e;
+// Downlink packets, either telemetry records or acks
+typedef struct tx_packet_s {
+  uint8_t size;
+  uint8_t data[APPCHANNEL_MTU];
+} tx_packet_t;
 
-typedef struct frontnet_msg_s {
-  frontnet_msg_e type;
+typedef union rx_packet_u {
+  uint8_t type;
+  frontnet_msg_legacy_t legacy;
+  frontnet_msg_t msg;
+} rx_packet_t;
 
-  union {
-    inference_stamped_t inference_stamped;
-  };
-} __attribute__((packed)) frontnet_msg_t;
+_Static_assert(sizeof(frontnet_telemetry_t) <= APPCHANNEL_MTU, "Telemetry records must fit in a single app channel packet");
+_Static_assert(sizeof(frontnet_msg_t) <= APPCHANNEL_MTU, "Messages must fit in a single app channel packet");
+_Static_assert(sizeof(frontnet_msg_legacy_t) <= APPCHANNEL_MTU, "Messages must fit in a single app channel packet");
 
 static bool isInit = false;
 
 STATIC_MEM_TASK_ALLOC(appChannelTask, FN_APPCHANNEL_STACK_SIZE);
 
-static frontnet_msg_t rxBuffer;
+static rx_packet_t rxBuffer;
+
+// Telemetry records and acks are buffered here and sent by telemetryTask, since appchannelSendPacket can block
+static QueueHandle_t txQueue;
+STATIC_MEM_QUEUE_ALLOC(txQueue, FN_TELEMETRY_QUEUE_LENGTH, sizeof(tx_packet_t));
+
+STATIC_MEM_TASK_ALLOC(telemetryTask, FN_TELEMETRY_STACK_SIZE);
+
+static uint32_t packetsSent = 0;
+static uint32_t telemetryDropped = 0;
+static uint32_t acksDropped = 0;
+static uint32_t invalidReceived = 0;
+
+// Per-source statistics of the received messages
+static frontnet_link_stats_t linkStats[FN_APPCHANNEL_SOURCE_COUNT];
+
+// Never block the caller, packets are dropped if the queue is full
+static bool enqueuePacket(const void *data, size_t size) {
+  tx_packet_t packet = {
+    .size = size,
+  };
+  memcpy(packet.data, data, size);
+
+  return xQueueSend(txQueue, &packet, 0);
+}
+
+static void sendAck(const frontnet_msg_t *acked, uint32_t rxTimestamp, frontnet_ack_status_e status) {
+  frontnet_msg_t ack;
+  size_t size = frontnetMsgAck(&ack, acked, rxTimestamp, xTaskGetTickCount(), status);
+
+  if (!enqueuePacket(&ack, size)) {
+    acksDropped++;
+  }
+}
+
+static void receiveInference(frontnet_link_stats_t *stats, const inference_stamped_t *inference, uint32_t rxTimestamp) {
+  frontnetLinkStatsLatency(stats, T2M(rxTimestamp - inference->stm32_timestamp));
+  frontnetEnqueueInference(inference);
+}
+
+static void receiveMessage(const frontnet_msg_t *msg, size_t size, uint32_t rxTimestamp) {
+  if (!frontnetMsgValidate(msg, size) || frontnetMsgType(msg) == ACK_MSG) {
+    DEBUG_PRINT("Received invalid message with type %d, size %d.\n", msg->header.type, (int)size);
+    invalidReceived++;
+    return;
+  }
+
+  if (msg->header.source >= FN_APPCHANNEL_SOURCE_COUNT) {
+    DEBUG_PRINT("Received message from unknown source %d.\n", msg->header.source);
+    invalidReceived++;
+    return;
+  }
+
+  frontnet_link_stats_t *stats = &linkStats[msg->header.source];
+  frontnetLinkStatsUpdate(stats, msg->header.sequence);
+
+  // Out-of-sequence inferences are still forwarded, the Kalman filter decides whether they can be used
+  frontnet_ack_status_e status = ACK_ACCEPTED;
+  switch (frontnetMsgType(msg)) {
+    case INFERENCE_MSG:
+      receiveInference(stats, &msg->inference.inference, rxTimestamp);
+      break;
+
+    case INFERENCE_BATCH_MSG:
+      for (int i = 0; i < msg->batch.count; i++) {
+        inference_stamped_t inference;
+        frontnetMsgGetBatchInference(msg, i, &inference);
+        receiveInference(stats, &inference, rxTimestamp);
+      }
+      break;
+
+    case TARGET_CONFIG_MSG:
+    {
+      frontnet_target_t target;
+      if (frontnetMsgGetTargetConfig(msg, &target)) {
+        frontnetEnqueueTarget(&target);
+      } else {
+        status = ACK_REJECTED;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  if (msg->header.type & FN_MSG_ACK_REQUEST) {
+    sendAck(msg, rxTimestamp, status);
+  }
+}
 
 static void appChannelTask() {
     systemWaitStart();
 
     while (true) {
         size_t rxSize = appchannelReceivePacket(&rxBuffer, sizeof(rxBuffer), APPCHANNEL_WAIT_FOREVER);
+        uint32_t rxTimestamp = xTaskGetTickCount();
+
         if (rxSize == 0) {
           DEBUG_PRINT("No packet received, should not happen.\n");
-        } else {
-          if (rxBuffer.type == INFERENCE_STAMPED_MSG) {
-            frontnetEnqueueInference(&rxBuffer.inference_stamped);
+        } else if (rxBuffer.type == INFERENCE_STAMPED_MSG) {
+          if (rxSize == sizeof(rxBuffer.legacy)) {
+            frontnetEnqueueInference(&rxBuffer.legacy.inference_stamped);
           } else {
-            DEBUG_PRINT("Received message with unknown type %d.\n", rxBuffer.type);
+            invalidReceived++;
           }
+        } else {
+          receiveMessage(&rxBuffer.msg, rxSize, rxTimestamp);
         }
     }
 }
 
+static void telemetryTask() {
+    systemWaitStart();
+
+    while (true) {
+        tx_packet_t packet;
+        xQueueReceive(txQueue, &packet, portMAX_DELAY);
+
+        appchannelSendPacket(packet.data, packet.size);
+        packetsSent++;
+    }
+}
+
+bool frontnetAppChannelSendTelemetry(const frontnet_telemetry_t *record) {
+  bool enqueued = enqueuePacket(record, frontnetTelemetrySize(record));
+  if (!enqueued) {
+    telemetryDropped++;
+  }
+
+  return enqueued;
+}
+
 void frontnetAppChannelInit() {
   if (isInit) {
     return;
   }
-  
+
+  txQueue = STATIC_MEM_QUEUE_CREATE(txQueue);
+  ASSERT(txQueue);
+
+  for (int i = 0; i < FN_APPCHANNEL_SOURCE_COUNT; i++) {
+    frontnetLinkStatsInit(&linkStats[i]);
+  }
+
   STATIC_MEM_TASK_CREATE(appChannelTask, appChannelTask, FN_APPCHANNEL_TASK_NAME, NULL, FN_APPCHANNEL_PRIORITY);
+  STATIC_MEM_TASK_CREATE(telemetryTask, telemetryTask, FN_TELEMETRY_TASK_NAME, NULL, FN_TELEMETRY_PRIORITY);
   isInit = true;
 
   DEBUG_PRINT("Frontnet App Channel started\n");
 }
+
+LOG_GROUP_START(fn_appchannel)
+LOG_ADD(LOG_UINT32, tx_sent, &packetsSent)
+LOG_ADD(LOG_UINT32, tlm_dropped, &telemetryDropped)
+LOG_ADD(LOG_UINT32, ack_dropped, &acksDropped)
+LOG_ADD(LOG_UINT32, rx_invalid, &invalidReceived)
+
+// Offboard sources, see FN_APPCHANNEL_SOURCE_COUNT
+LOG_ADD(LOG_UINT32, s0_rx, &linkStats[0].received)
+LOG_ADD(LOG_UINT32, s0_lost, &linkStats[0].lost)
+LOG_ADD(LOG_UINT32, s0_reordered, &linkStats[0].reordered)
+LOG_ADD(LOG_UINT16, s0_lat, &linkStats[0].latencyMean)
+LOG_ADD(LOG_UINT16, s0_lat_max, &linkStats[0].latencyMax)
+
+LOG_ADD(LOG_UINT32, s1_rx, &linkStats[1].received)
+LOG_ADD(LOG_UINT32, s1_lost, &linkStats[1].lost)
+LOG_ADD(LOG_UINT32, s1_reordered, &linkStats[1].reordered)
+LOG_ADD(LOG_UINT16, s1_lat, &linkStats[1].latencyMean)
+LOG_ADD(LOG_UINT16, s1_lat_max, &linkStats[1].latencyMax)
+LOG_GROUP_STOP(fn_appchannel)
@@ -0,0 +1,162 @@
+#include "frontnet_follow.h"
+
+#include "frontnet_config.h"
+#include "frontnet_os.h"
+#include "frontnet_state_history.h"
+
+#include "cfassert.h"
+#include "math3d.h"
+#include "stabilizer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+void computeSubjectPoseInOdomFrame(const inference_stamped_t *inference, const state_t *state, pose_t *subjectPose) {
+  // Convert an inference output, expressed in frame cf/base_link (with a flipped yaw, hence the +M_PI_F), to a pose expressed in frame cf/odom
+  // NOTE: the firmware uses degrees and degree/s for attitudes and attitude rates in its data types (state_t and setpoint_t)
+  float statePhi = radians(state->attitude.yaw);
+  float sn = sinf(statePhi);
+  float cs = cosf(statePhi);
+
+  *subjectPose = (pose_t){
+    .position = {
+      .timestamp = inference->stm32_timestamp,
+      .x = state->position.x + cs * inference->x - sn * inference->y,
+      .y = state->position.y + sn * inference->x + cs * inference->y,
+      .z = state->position.z + inference->z,
+    },
+    
+    .attitude = {
+      .timestamp = inference->stm32_timestamp,
+      .roll  = 0.0f,
+      .pitch = 0.0f,
+      .yaw   = statePhi + inference->phi + M_PI_F
+    }
+  };
+}
+
+void computeTargetOdom(const frontnet_target_t *config, const odometry_t *subjectOdom, const state_t *state, odometry_t *targetOdom) {
+  // Compute the target odometry (i.e., pose + velocity) that we want the drone to reach, expressed in frame cf/odom
+  const point_t *subjectPos = &subjectOdom->pose.position;
+  const attitude_t *subjectAtt = &subjectOdom->pose.attitude;
+
+  // Target pose is horizontalDistance meters in front of subject pose, in the direction of subject yaw
+  float targetX = subjectPos->x + cosf(subjectAtt->yaw) * config->horizontalDistance;
+  float targetY = subjectPos->y + sinf(subjectAtt->yaw) * config->horizontalDistance;
+
+  // Target altitude is relative to either the ground or the subject, depending on configuration
+  float targetZ;
+  if (config->altitudeReference == GROUND_ALTITUDE_REF) {
+    targetZ = config->altitude;
+  } else if (config->altitudeReference == SUBJECT_ALTITUDE_REF) {
+    targetZ = subjectPos->z + config->altitude;
+  } else {
+    // Unknown altitude reference, set targetZ just to make the compiler happy
+    targetZ = 0.0f;
+    ASSERT_FAILED();
+  }
+
+  // Target yaw keeps the drone looking at the subject as it's moving to reach it
+  float targetYaw = atan2f(subjectPos->y - state->position.y, subjectPos->x - state->position.x);
+
+  *targetOdom = (odometry_t){
+    .pose = {
+      .position.timestamp = subjectPos->timestamp,
+      .position.x = targetX,
+      .position.y = targetY,
+      .position.z = targetZ,
+
+      .attitude.timestamp = subjectAtt->timestamp,
+      .attitude.roll  = 0.0f,
+      .attitude.pitch = 0.0f,
+      .attitude.yaw   = targetYaw
+    },
+
+    // Target moves at the same velocity as the subject, allowing control to anticipate it
+    .twist = subjectOdom->twist
+  };
+}
+
+bool frontnetFollowInference(frontnet_follow_t *follow, const inference_stamped_t *inference, const state_t *state, uint32_t now) {
+  if (follow->gateOutliers && (inference->flags & INFERENCE_FLAG_OUTLIER)) {
+    follow->outliersGated++;
+    return false;
+  }
+
+  follow->inference = *inference;
+  follow->lastInference = now;
+
+  state_t inferenceState;
+  if (follow->useInferenceTimeState) {
+    // Retrieve the state estimation from the time the camera image was acquired
+    stateCompressed_t stateCompressed;
+    bool hasInferenceState = stateHistoryDequeueAtTimestamp(inference->stm32_timestamp, &stateCompressed);
+
+    if (!hasInferenceState) {
+      return false;
+    }
+
+    stabilizerDecompressState(&stateCompressed, &inferenceState);
+  } else {
+    inferenceState = *state;
+  }
+
+  pose_t subjectPose;
+  computeSubjectPoseInOdomFrame(inference, &inferenceState, &subjectPose);
+
+  uint64_t start_us = frontnetUsecTimestamp();
+  bool kfUpdated = frontnetKfUpdate(&follow->kf, &subjectPose, &follow->subjectOdom);
+  if (kfUpdated) {
+    // Compensate the inference latency, if supported by the filter
+    frontnetKfPredict(&follow->kf, now, &follow->subjectOdom);
+  }
+  uint64_t end_us = frontnetUsecTimestamp();
+  follow->kfLatencyUs = (uint32_t)(end_us - start_us);
+
+  if (!kfUpdated) {
+    return false;
+  }
+
+  computeTargetOdom(&follow->target, &follow->subjectOdom, state, &follow->targetOdom);
+
+  return true;
+}
+
+void frontnetFollowPredict(frontnet_follow_t *follow, const state_t *state, uint32_t now) {
+  bool predicted = frontnetKfPredict(&follow->kf, now, &follow->subjectOdom);
+  if (predicted) {
+    computeTargetOdom(&follow->target, &follow->subjectOdom, state, &follow->targetOdom);
+  }
+}
+
+bool frontnetFollowCheckTimeout(frontnet_follow_t *follow, bool controlEnabled, const state_t *state, uint32_t now) {
+  bool inferenceTimeout = (now - follow->lastInference) > FRONTNET_INFERENCE_TIMEOUT;
+  if (inferenceTimeout) {
+    if (controlEnabled && follow->controlMode == FRONTNET_CTRL_MODE) {
+      follow->controlMode = HOVER_CTRL_MODE;
+      setPoseFromState(&follow->hoverPose, state);
+      return true;
+    }
+  } else {
+    if (follow->controlMode == HOVER_CTRL_MODE) {
+      follow->controlMode = FRONTNET_CTRL_MODE;
+    }
+  }
+
+  return false;
+}
+
+bool frontnetFollowSetpoint(const frontnet_follow_t *follow, const state_t *state, setpoint_t *setpoint) {
+  if (follow->controlMode == FRONTNET_CTRL_MODE) {
+    frontnetSetpointUpdate(&follow->ctrl, &follow->targetOdom, state, setpoint);
+  } else if (follow->controlMode == HOVER_CTRL_MODE) {
+    hoverSetpointUpdate(&follow->hoverPose, state, setpoint);
+  } else if (follow->controlMode == LAND_CTRL_MODE) {
+    landSetpointUpdate(&follow->ctrl, state, setpoint);
+  } else {
+    return false;
+  }
+
+  return true;
+}
@@ -3,10 +3,12 @@
 
 #include "FreeRTOS.h"
 
+#include "cf_math.h"
 #include "math3d.h"
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 static void kfD1Update(kf_d1_t *kf, float xNew, float dt) {
   float q_vv = kf->q_vv * fsqr(dt);
@@ -31,13 +33,14 @@ static void kfD1Update(kf_d1_t *kf, float xNew, float dt) {
   kf->state.p_vv = p_vv_ - p_xv_ * p_xv_ / s;
 }
 
-void frontnetKfUpdate(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *subjectOdom) {
-  if (kf->bypassFilter) {
-    setOdomFromPose(subjectOdom, subjectPose);
-    return;
+static bool kfD1UpdateAll(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *subjectOdom) {
+  uint32_t timestamp = subjectPose->position.timestamp;
+
+  // Out-of-sequence measurements are not supported by the decoupled filter
+  if (kf->lastUpdate && (int32_t)(timestamp - kf->lastUpdate) < 0) {
+    return false;
   }
 
-  uint32_t timestamp = subjectPose->position.timestamp;
   float dt = 0.0f;
   if (kf->lastUpdate) {
     dt = ((float)T2M(timestamp - kf->lastUpdate)) / 1000.0f;
@@ -75,4 +78,289 @@ void frontnetKfUpdate(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *
       .angular.yaw   = kf->phi.state.v,
     }
   };
+
+  return true;
+}
+
+#define N KF_CA_DIM
+#define M KF_CA_OBS_DIM
+
+// Work matrices, the filter is only updated by the Frontnet task
+static float F[N][N];
+static float tmpNN1[N][N];
+static float tmpNN2[N][N];
+static float PHT[N][M];
+static float K[N][M];
+static float S[M][M];
+static float SInv[M][M];
+static float y[M];
+static float Ky[N];
+
+// Observation matrix, selects the position components of the state (the remaining columns are zero)
+static const float H[M][N] = {
+  {1, 0, 0, 0},
+  {0, 1, 0, 0},
+  {0, 0, 1, 0},
+  {0, 0, 0, 1},
+};
+static float HT[N][M];
+
+static arm_matrix_instance_f32 Fm = {N, N, (float *)F};
+static arm_matrix_instance_f32 tmpNN1m = {N, N, (float *)tmpNN1};
+static arm_matrix_instance_f32 tmpNN2m = {N, N, (float *)tmpNN2};
+static arm_matrix_instance_f32 PHTm = {N, M, (float *)PHT};
+static arm_matrix_instance_f32 Km = {N, M, (float *)K};
+static arm_matrix_instance_f32 Sm = {M, M, (float *)S};
+static arm_matrix_instance_f32 SInvm = {M, M, (float *)SInv};
+static arm_matrix_instance_f32 ym = {M, 1, y};
+static arm_matrix_instance_f32 Kym = {N, 1, Ky};
+static arm_matrix_instance_f32 Hm = {M, N, (float *)H};
+static arm_matrix_instance_f32 HTm = {N, M, (float *)HT};
+
+static void kfCaPredictState(float x[N], float dt) {
+  // Position, velocity and acceleration of component i are at x[i], x[M + i] and x[2M + i]
+  for (int i = 0; i < M; i++) {
+    float *c = &x[i];
+    c[0] += c[M] * dt + c[2*M] * 0.5f * fsqr(dt);
+    c[M] += c[2*M] * dt;
+  }
+  x[3] = normalizeAngle(x[3]);
+}
+
+static void kfCaPredict(const kf_ca_t *kf, kf_ca_state_t *state, uint32_t timestamp) {
+  int32_t dtTicks = (int32_t)(timestamp - state->timestamp);
+  state->timestamp = timestamp;
+
+  if (dtTicks <= 0) {
+    return;
+  }
+
+  float dt = ((float)T2M(dtTicks)) / 1000.0f;
+
+  kfCaPredictState(state->x, dt);
+
+  // Covariance prediction P = F P F^T + Q
+  float dt2 = fsqr(dt);
+  float dt3 = dt2 * dt;
+
+  memset(F, 0, sizeof(F));
+  for (int i = 0; i < N; i++) {
+    F[i][i] = 1.0f;
+  }
+  for (int i = 0; i < M; i++) {
+    F[i][M + i] = dt;
+    F[i][2*M + i] = 0.5f * dt2;
+    F[M + i][2*M + i] = dt;
+  }
+
+  arm_matrix_instance_f32 Pm = {N, N, (float *)state->p};
+  mat_trans(&Fm, &tmpNN2m);
+  mat_mult(&Fm, &Pm, &tmpNN1m);
+  mat_mult(&tmpNN1m, &tmpNN2m, &Pm);
+
+  // Discrete white-jerk process noise
+  for (int i = 0; i < M; i++) {
+    float q = kf->q[i];
+    int p = i, v = M + i, a = 2*M + i;
+
+    state->p[p][p] += q * dt3 * dt2 / 20.0f;
+    state->p[p][v] += q * dt2 * dt2 / 8.0f;
+    state->p[p][a] += q * dt3 / 6.0f;
+    state->p[v][p] += q * dt2 * dt2 / 8.0f;
+    state->p[v][v] += q * dt3 / 3.0f;
+    state->p[v][a] += q * dt2 / 2.0f;
+    state->p[a][p] += q * dt3 / 6.0f;
+    state->p[a][v] += q * dt2 / 2.0f;
+    state->p[a][a] += q * dt;
+  }
+}
+
+static void kfCaCorrect(const frontnet_kf_t *kf, kf_ca_state_t *state, const float z[M]) {
+  const float r[M] = {kf->x.r_xx, kf->y.r_xx, kf->z.r_xx, kf->phi.r_xx};
+
+  arm_matrix_instance_f32 Pm = {N, N, (float *)state->p};
+
+  // Innovation y = z - H x, yaw is normalized to [-pi; pi]
+  for (int i = 0; i < M; i++) {
+    y[i] = z[i] - state->x[i];
+  }
+  y[3] = normalizeAngle(y[3]);
+
+  // Innovation covariance S = H P H^T + R
+  mat_trans(&Hm, &HTm);
+  mat_mult(&Pm, &HTm, &PHTm);
+  mat_mult(&Hm, &PHTm, &Sm);
+  for (int i = 0; i < M; i++) {
+    S[i][i] += r[i];
+  }
+
+  // Kalman gain K = P H^T S^-1 (NOTE: mat_inv overwrites S)
+  mat_inv(&Sm, &SInvm);
+  mat_mult(&PHTm, &SInvm, &Km);
+
+  // State update x = x + K y
+  mat_mult(&Km, &ym, &Kym);
+  arm_add_f32(state->x, Ky, state->x, N);
+  state->x[3] = normalizeAngle(state->x[3]);
+
+  // Covariance update P = (I - K H) P, then enforce symmetry
+  mat_mult(&Km, &Hm, &tmpNN2m);
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < N; j++) {
+      tmpNN2[i][j] = (i == j ? 1.0f : 0.0f) - tmpNN2[i][j];
+    }
+  }
+  mat_mult(&tmpNN2m, &Pm, &tmpNN1m);
+  for (int i = 0; i < N; i++) {
+    for (int j = i; j < N; j++) {
+      float p = 0.5f * (tmpNN1[i][j] + tmpNN1[j][i]);
+      state->p[i][j] = p;
+      state->p[j][i] = p;
+    }
+  }
+}
+
+static void kfCaInit(const kf_ca_t *kf, kf_ca_state_t *state, uint32_t timestamp) {
+  memset(state, 0, sizeof(*state));
+  state->timestamp = timestamp;
+
+  for (int i = 0; i < M; i++) {
+    state->p[i][i] = kf->p0_xx;
+    state->p[M + i][M + i] = kf->p0_vv;
+    state->p[2*M + i][2*M + i] = kf->p0_aa;
+  }
+}
+
+static bool kfCaUpdate(frontnet_kf_t *kf, const pose_t *subjectPose) {
+  // Estimate preceding the new measurement, static to save stack space
+  static kf_ca_state_t prior;
+
+  kf_ca_t *ca = &kf->ca;
+  uint32_t timestamp = subjectPose->position.timestamp;
+  bool first = (ca->historyCount == 0);
+
+  // Find where the new measurement goes in the history, after those with the same or older timestamps
+  int index = ca->historyCount;
+  while (index > 0 && (int32_t)(timestamp - ca->history[index - 1].posterior.timestamp) < 0) {
+    index--;
+  }
+
+  // Measurements older than the whole history cannot be applied anymore
+  if (index == 0 && !first) {
+    return false;
+  }
+
+  if (!first) {
+    prior = ca->history[index - 1].posterior;
+  }
+
+  // Make space for the new measurement, dropping the oldest one if the history is full
+  if (ca->historyCount == FRONTNET_KF_CA_HISTORY_COUNT) {
+    memmove(&ca->history[0], &ca->history[1], (ca->historyCount - 1) * sizeof(kf_ca_entry_t));
+    ca->historyCount--;
+    index--;
+  }
+  memmove(&ca->history[index + 1], &ca->history[index], (ca->historyCount - index) * sizeof(kf_ca_entry_t));
+  ca->historyCount++;
+
+  kf_ca_entry_t *newEntry = &ca->history[index];
+  newEntry->z[0] = subjectPose->position.x;
+  newEntry->z[1] = subjectPose->position.y;
+  newEntry->z[2] = subjectPose->position.z;
+  newEntry->z[3] = subjectPose->attitude.yaw;
+
+  if (first) {
+    kfCaInit(ca, &newEntry->posterior, timestamp);
+  } else {
+    newEntry->posterior = prior;
+    kfCaPredict(ca, &newEntry->posterior, timestamp);
+  }
+  kfCaCorrect(kf, &newEntry->posterior, newEntry->z);
+
+  // Re-apply the measurements newer than the new one
+  for (int i = index + 1; i < ca->historyCount; i++) {
+    kf_ca_entry_t *entry = &ca->history[i];
+    uint32_t entryTimestamp = entry->posterior.timestamp;
+
+    entry->posterior = ca->history[i - 1].posterior;
+    kfCaPredict(ca, &entry->posterior, entryTimestamp);
+    kfCaCorrect(kf, &entry->posterior, entry->z);
+  }
+
+  return true;
+}
+
+static void kfCaGetOdom(const float x[N], uint32_t timestamp, odometry_t *subjectOdom) {
+  *subjectOdom = (odometry_t){
+    .pose = {
+      .position.timestamp = timestamp,
+      .position.x = x[0],
+      .position.y = x[1],
+      .position.z = x[2],
+
+      .attitude.timestamp = timestamp,
+      .attitude.roll  = 0.0f,
+      .attitude.pitch = 0.0f,
+      .attitude.yaw   = x[3],
+    },
+
+    .twist = {
+      .linear.timestamp = timestamp,
+      .linear.x = x[M + 0],
+      .linear.y = x[M + 1],
+      .linear.z = x[M + 2],
+
+      .angular.timestamp = timestamp,
+      .angular.roll  = 0.0f,
+      .angular.pitch = 0.0f,
+      .angular.yaw   = x[M + 3],
+    }
+  };
+}
+
+bool frontnetKfUpdate(frontnet_kf_t *kf, const pose_t *subjectPose, odometry_t *subjectOdom) {
+  if (kf->bypassFilter) {
+    setOdomFromPose(subjectOdom, subjectPose);
+    return true;
+  }
+
+  if (kf->model == KF_CA_MODEL) {
+    if (!kfCaUpdate(kf, subjectPose)) {
+      return false;
+    }
+
+    const kf_ca_state_t *latest = &kf->ca.history[kf->ca.historyCount - 1].posterior;
+    kf->lastUpdate = latest->timestamp;
+    kfCaGetOdom(latest->x, latest->timestamp, subjectOdom);
+    return true;
+  }
+
+  return kfD1UpdateAll(kf, subjectPose, subjectOdom);
+}
+
+bool frontnetKfPredict(const frontnet_kf_t *kf, uint32_t timestamp, odometry_t *subjectOdom) {
+  if (kf->bypassFilter || kf->model != KF_CA_MODEL || kf->ca.historyCount == 0) {
+    return false;
+  }
+
+  // Only the state needs to be propagated, the covariance is not used for control
+  const kf_ca_state_t *latest = &kf->ca.history[kf->ca.historyCount - 1].posterior;
+  float x[N];
+  memcpy(x, latest->x, sizeof(x));
+
+  // A timestamp older than the latest estimate must not wrap to a long prediction
+  if ((int32_t)(timestamp - latest->timestamp) > 0) {
+    float dt = ((float)T2M(timestamp - latest->timestamp)) / 1000.0f;
+    if (dt > kf->ca.maxHorizon) {
+      dt = kf->ca.maxHorizon;
+      timestamp = latest->timestamp + M2T(dt * 1000.0f);
+    }
+
+    kfCaPredictState(x, dt);
+  } else {
+    timestamp = latest->timestamp;
+  }
+
+  kfCaGetOdom(x, timestamp, subjectOdom);
+  return true;
 }
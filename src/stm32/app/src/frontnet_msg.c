@@ -0,0 +1,182 @@
+#include "frontnet_msg.h"
+
+#include "cfassert.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BATCH_SIZE(count) (offsetof(frontnet_msg_inference_batch_t, entries) + (count) * sizeof(frontnet_msg_batch_entry_t))
+
+bool frontnetMsgValidate(const frontnet_msg_t *msg, size_t size) {
+  if (size < sizeof(msg->header)) {
+    return false;
+  }
+
+  size_t payloadSize = size - sizeof(msg->header);
+
+  switch (frontnetMsgType(msg)) {
+    case INFERENCE_MSG:
+      return payloadSize == sizeof(msg->inference);
+    case INFERENCE_BATCH_MSG:
+      return payloadSize >= BATCH_SIZE(0)
+          && msg->batch.count >= 1 && msg->batch.count <= FN_MSG_BATCH_MAX_COUNT
+          && payloadSize == BATCH_SIZE(msg->batch.count);
+    case TARGET_CONFIG_MSG:
+      return payloadSize == sizeof(msg->target);
+    case ACK_MSG:
+      return payloadSize == sizeof(msg->ack);
+    default:
+      return false;
+  }
+}
+
+size_t frontnetMsgInference(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const inference_stamped_t *inference) {
+  msg->header = *header;
+  msg->inference.inference = *inference;
+
+  return sizeof(msg->header) + sizeof(msg->inference);
+}
+
+size_t frontnetMsgInferenceBatch(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const inference_stamped_t *inferences, int count) {
+  ASSERT(count >= 1 && count <= FN_MSG_BATCH_MAX_COUNT);
+
+  msg->header = *header;
+  msg->batch.count = count;
+  msg->batch.baseTimestamp = inferences[0].stm32_timestamp;
+
+  for (int i = 0; i < count; i++) {
+    const inference_stamped_t *inference = &inferences[i];
+
+    // Inferences must be consecutive and sorted by timestamp
+    uint32_t dt = inference->stm32_timestamp - msg->batch.baseTimestamp;
+    ASSERT(dt <= UINT8_MAX);
+
+    msg->batch.entries[i] = (frontnet_msg_batch_entry_t){
+      .dt = dt,
+      .x = toFixed16(inference->x, FN_MSG_FIXED_SCALE),
+      .y = toFixed16(inference->y, FN_MSG_FIXED_SCALE),
+      .z = toFixed16(inference->z, FN_MSG_FIXED_SCALE),
+      .phi = toFixed16(inference->phi, FN_MSG_FIXED_SCALE),
+    };
+  }
+
+  return sizeof(msg->header) + BATCH_SIZE(count);
+}
+
+size_t frontnetMsgTargetConfig(frontnet_msg_t *msg, const frontnet_msg_header_t *header, const frontnet_target_t *target) {
+  msg->header = *header;
+  msg->target = (frontnet_msg_target_config_t){
+    .horizontalDistance = target->horizontalDistance,
+    .altitude = target->altitude,
+    .altitudeReference = target->altitudeReference,
+  };
+
+  return sizeof(msg->header) + sizeof(msg->target);
+}
+
+size_t frontnetMsgAck(frontnet_msg_t *msg, const frontnet_msg_t *acked, uint32_t rxTimestamp, uint32_t txTimestamp, frontnet_ack_status_e status) {
+  msg->header = (frontnet_msg_header_t){
+    .type = ACK_MSG,
+    .source = acked->header.source,
+    .sequence = acked->header.sequence,
+    .txTimestamp = txTimestamp,
+  };
+  msg->ack = (frontnet_msg_ack_t){
+    .ackedType = frontnetMsgType(acked),
+    .ackedTxTimestamp = acked->header.txTimestamp,
+    .rxTimestamp = rxTimestamp,
+    .status = status,
+  };
+
+  return sizeof(msg->header) + sizeof(msg->ack);
+}
+
+void frontnetMsgGetBatchInference(const frontnet_msg_t *msg, int index, inference_stamped_t *inference) {
+  ASSERT(index >= 0 && index < msg->batch.count);
+
+  const frontnet_msg_batch_entry_t *entry = &msg->batch.entries[index];
+  *inference = (inference_stamped_t){
+    .stm32_timestamp = msg->batch.baseTimestamp + entry->dt,
+    .x = fromFixed16(entry->x, FN_MSG_FIXED_SCALE),
+    .y = fromFixed16(entry->y, FN_MSG_FIXED_SCALE),
+    .z = fromFixed16(entry->z, FN_MSG_FIXED_SCALE),
+    .phi = fromFixed16(entry->phi, FN_MSG_FIXED_SCALE),
+  };
+}
+
+bool frontnetMsgGetTargetConfig(const frontnet_msg_t *msg, frontnet_target_t *target) {
+  const frontnet_msg_target_config_t *config = &msg->target;
+
+  bool valid = isfinite(config->horizontalDistance) && config->horizontalDistance >= 0.0f
+            && isfinite(config->altitude)
+            && (config->altitudeReference == GROUND_ALTITUDE_REF || config->altitudeReference == SUBJECT_ALTITUDE_REF);
+  if (!valid) {
+    return false;
+  }
+
+  *target = (frontnet_target_t){
+    .horizontalDistance = config->horizontalDistance,
+    .altitude = config->altitude,
+    .altitudeReference = config->altitudeReference,
+  };
+
+  return true;
+}
+
+void frontnetLinkStatsInit(frontnet_link_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+}
+
+bool frontnetLinkStatsUpdate(frontnet_link_stats_t *stats, uint16_t sequence) {
+  stats->received++;
+
+  // Sequence numbers wrap around, compare them as a signed difference
+  int16_t gap = (int16_t)(sequence - stats->nextSequence);
+
+  if (!stats->synced || gap > FN_LINK_STATS_MAX_GAP || gap < -FN_LINK_STATS_MAX_GAP) {
+    if (stats->synced) {
+      stats->restarts++;
+    }
+
+    stats->synced = true;
+    stats->nextSequence = sequence + 1;
+    return true;
+  }
+
+  if (gap < 0) {
+    // Late message, it was already counted as lost when a later one was received
+    stats->reordered++;
+    if (stats->lost > 0) {
+      stats->lost--;
+    }
+    return false;
+  }
+
+  stats->lost += gap;
+  stats->nextSequence = sequence + 1;
+  return true;
+}
+
+void frontnetLinkStatsLatency(frontnet_link_stats_t *stats, uint32_t latency) {
+  if (latency > UINT16_MAX) {
+    latency = UINT16_MAX;
+  }
+
+  stats->latencySum += latency;
+  stats->latencyCount++;
+  if (latency > stats->latencyWindowMax) {
+    stats->latencyWindowMax = latency;
+  }
+
+  if (stats->latencyCount == FN_LINK_STATS_WINDOW) {
+    stats->latencyMean = stats->latencySum / stats->latencyCount;
+    stats->latencyMax = stats->latencyWindowMax;
+
+    stats->latencySum = 0;
+    stats->latencyCount = 0;
+    stats->latencyWindowMax = 0;
+  }
+}
@@ -0,0 +1,32 @@
+#include "frontnet_os.h"
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+#include "stabilizer.h"
+#include "usec_time.h"
+
+bool frontnetQueueSend(frontnet_queue_t queue, const void *item) {
+  return xQueueSend((QueueHandle_t)queue, item, 0) == pdTRUE;
+}
+
+bool frontnetQueueReceive(frontnet_queue_t queue, void *item) {
+  return xQueueReceive((QueueHandle_t)queue, item, 0) == pdTRUE;
+}
+
+bool frontnetQueuePeek(frontnet_queue_t queue, void *item) {
+  return xQueuePeek((QueueHandle_t)queue, item, 0) == pdTRUE;
+}
+
+uint32_t frontnetGetTicks() {
+  return xTaskGetTickCount();
+}
+
+uint64_t frontnetUsecTimestamp() {
+  return usecTimestamp();
+}
+
+void frontnetGetLatestState(stateCompressed_t *state) {
+  stabilizerGetLatestState(state);
+}
@@ -2,6 +2,7 @@
 
 #include "frontnet_config.h"
 #include "frontnet_rng.h"
+#include "frontnet_state_history.h"
 #include "aideck_protocol.h"
 
 #define DEBUG_MODULE "FN-STATE-FWD"
@@ -62,59 +63,13 @@ static void forwardRNGEntropy(uint32_t entropy) {
   send_rng_msg(&msg);
 }
 
-static void enqueueStateHistory(const stateCompressed_t *state) {
-  bool stateSent = xQueueSend(stateQueue, state, 0);
-
-  if (!stateSent) {
-    // Queue is full, discard one element at the beginning to make space
-    stateCompressed_t discard;
-    xQueueReceive(stateQueue, &discard, 0);
-
-    xQueueSend(stateQueue, state, 0);
-  }
-}
-
-bool stateFwdDequeueAtTimestamp(uint32_t timestamp, stateCompressed_t *state) {
-  bool stateReceived = false;
-  
-  ASSERT(isInit);
-  
-  // Discard all elements at the front of the queue older than the desired timestamp
-  while ((stateReceived = xQueuePeek(stateQueue, state, 0)) && state->timestamp < timestamp) {
-    stateCompressed_t discard;
-    xQueueReceive(stateQueue, &discard, 0);
-
-    // There is a race condition between the Peek/Receive pair here and Send/Receive
-    // in enqueueStateHistory. In pratice, it should almost never be a problem.
-    // - The expected case is that Peek and Receive return the same state, which we 
-    //   want to discard anyway.
-    // - Otherwise, even if Receive returns a newer state than Peek, it is expected 
-    //   that the discarded state is still older than the desired timestamp.
-    // - FRONTNET_STATE_HISTORY_COUNT can be tuned so that this property holds.
-    ASSERT(discard.timestamp == state->timestamp || discard.timestamp < timestamp);
-  }
-
-  // State queue has been emptied, try to get the latest state
-  // (added because frontnet_test_inferences can fetch a new state before it is added to the queue)
-  if (!stateReceived) {
-    stabilizerGetLatestState(state);
-  }
-
-  // Return true if the element now at the front has the desired timestamp
-  if (state->timestamp == timestamp) {
-    return true;
-  } else {
-    return false;
-  }
-}
-
 static void fwdTask(void *_param) {
   systemWaitStart();
 
   lastForwardTime = xTaskGetTickCount();
   while (true) {
     stabilizerGetLatestState(&state);
-    enqueueStateHistory(&state);
+    stateHistoryPush(&state);
     forwardState(&state);
 
     uint32_t rngEntropy;
@@ -140,6 +95,7 @@ void stateFwdInit() {
 
   stateQueue = STATIC_MEM_QUEUE_CREATE(stateQueue);
   ASSERT(stateQueue);
+  stateHistoryInit(stateQueue);
 
   frontnetRNGInit();
 
@@ -0,0 +1,82 @@
+#include "frontnet_state_history.h"
+
+#include "frontnet_config.h"
+#include "frontnet_os.h"
+
+#include "cfassert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static frontnet_queue_t stateQueue = NULL;
+
+// States recently dequeued, kept to serve out-of-sequence inferences. Only accessed by the consumer task.
+static stateCompressed_t recentStates[STATE_FWD_HISTORY_RECENT_COUNT];
+static uint32_t recentHead = 0;
+
+void stateHistoryInit(frontnet_queue_t queue) {
+  ASSERT(queue);
+  stateQueue = queue;
+
+  memset(recentStates, 0, sizeof(recentStates));
+  recentHead = 0;
+}
+
+void stateHistoryPush(const stateCompressed_t *state) {
+  bool stateSent = frontnetQueueSend(stateQueue, state);
+
+  if (!stateSent) {
+    // Queue is full, discard one element at the beginning to make space
+    stateCompressed_t discard;
+    frontnetQueueReceive(stateQueue, &discard);
+
+    frontnetQueueSend(stateQueue, state);
+  }
+}
+
+bool stateHistoryDequeueAtTimestamp(uint32_t timestamp, stateCompressed_t *state) {
+  bool stateReceived = false;
+  
+  ASSERT(stateQueue);
+
+  // Inferences older than the front of the queue may still find their state among the recently dequeued
+  for (uint32_t i = 0; i < STATE_FWD_HISTORY_RECENT_COUNT; i++) {
+    if (recentStates[i].timestamp == timestamp && timestamp != 0) {
+      *state = recentStates[i];
+      return true;
+    }
+  }
+  
+  // Discard all elements at the front of the queue older than the desired timestamp
+  while ((stateReceived = frontnetQueuePeek(stateQueue, state)) && state->timestamp < timestamp) {
+    stateCompressed_t discard;
+    frontnetQueueReceive(stateQueue, &discard);
+
+    recentStates[recentHead] = discard;
+    recentHead = (recentHead + 1) % STATE_FWD_HISTORY_RECENT_COUNT;
+
+    // There is a race condition between the Peek/Receive pair here and Send/Receive
+    // in stateHistoryPush. In pratice, it should almost never be a problem.
+    // - The expected case is that Peek and Receive return the same state, which we 
+    //   want to discard anyway.
+    // - Otherwise, even if Receive returns a newer state than Peek, it is expected 
+    //   that the discarded state is still older than the desired timestamp.
+    // - FRONTNET_STATE_HISTORY_COUNT can be tuned so that this property holds.
+    ASSERT(discard.timestamp == state->timestamp || discard.timestamp < timestamp);
+  }
+
+  // State queue has been emptied, try to get the latest state
+  // (added because frontnet_test_inferences can fetch a new state before it is added to the queue)
+  if (!stateReceived) {
+    frontnetGetLatestState(state);
+  }
+
+  // Return true if the element now at the front has the desired timestamp
+  if (state->timestamp == timestamp) {
+    return true;
+  } else {
+    return false;
+  }
+}
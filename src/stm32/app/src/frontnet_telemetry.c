@@ -0,0 +1,42 @@
+#include "frontnet_telemetry.h"
+
+#include "cfassert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+size_t frontnetTelemetryInference(const frontnet_follow_t *follow, bool controlEnabled, int setpointPriority, frontnet_telemetry_t *record) {
+  const odometry_t *odom = &follow->subjectOdom;
+
+  record->type = TELEMETRY_INFERENCE_RECORD;
+  record->inference = (frontnet_telemetry_inference_t){
+    .stateTimestamp = follow->inference.stm32_timestamp,
+    .inferenceTimestamp = follow->lastInference,
+
+    .x = toFixed16(odom->pose.position.x, 1000.0f),
+    .y = toFixed16(odom->pose.position.y, 1000.0f),
+    .z = toFixed16(odom->pose.position.z, 1000.0f),
+    .phi = toFixed16(odom->pose.attitude.yaw, 1000.0f),
+    .vx = toFixed16(odom->twist.linear.x, 1000.0f),
+    .vy = toFixed16(odom->twist.linear.y, 1000.0f),
+    .vz = toFixed16(odom->twist.linear.z, 1000.0f),
+    .vphi = toFixed16(odom->twist.angular.yaw, 1000.0f),
+
+    .controlEnabled = controlEnabled,
+    .controlMode = follow->controlMode,
+    .setpointPriority = setpointPriority,
+  };
+
+  return frontnetTelemetrySize(record);
+}
+
+size_t frontnetTelemetrySize(const frontnet_telemetry_t *record) {
+  switch (record->type) {
+    case TELEMETRY_INFERENCE_RECORD:
+      return sizeof(record->type) + sizeof(record->inference);
+    default:
+      ASSERT_FAILED();
+      return 0;
+  }
+}
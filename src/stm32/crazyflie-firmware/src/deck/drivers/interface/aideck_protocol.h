@@ -27,24 +27,31 @@
 
 #pragma once
 
+#include "tof_encoder.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 
 #define HEADER_LENGTH 4
 #define REQUEST_TIMEOUT 2000 // number of milliseconds to wait for a confirmation
-#define INPUT_NUMBER 1
+#define INPUT_NUMBER 2
 
 typedef struct input_s {
   const char *header;
   uint8_t size;
   void (*callback)(void *);
   bool valid;
+  uint64_t timestamp;         // [us] usecTimestamp() when the message was completely received
 } input_t;
 
 extern input_t inputs[INPUT_NUMBER];
 
 // --- received inference_output_t
 
+// Flags set by the GAP8 inference filter, zero when the inference was not filtered
+#define INFERENCE_FLAG_FILTERED (1 << 0)  // confidence is valid
+#define INFERENCE_FLAG_OUTLIER  (1 << 1)  // Inconsistent with the previous inferences, should not be used
+
 #define INFERENCE_STAMPED_HEADER "\x90\x19\x8\x32"
 typedef struct inference_stamped_s {
   uint32_t stm32_timestamp;   // [ticks]
@@ -52,11 +59,37 @@ typedef struct inference_stamped_s {
   float y;                    // [m]
   float z;                    // [m]
   float phi;                  // [rad]
+  uint8_t flags;              // INFERENCE_FLAG_*
+  uint8_t confidence;         // 0 to 255, valid with INFERENCE_FLAG_FILTERED
 } __attribute__((packed)) inference_stamped_t;
 
 // To be implemented
 void inference_stamped_callback(inference_stamped_t *);
 
+// --- received clock_ping_t, answered with clock_pong_msg_t
+
+// Ping and pong have the same size, so that their transmission time over the UART is symmetric
+#define CLOCK_PING_HEADER "\x90\x19\x8\x33"
+typedef struct clock_ping_s {
+  uint32_t sequence;
+  uint32_t rx_timestamp;      // unused
+  uint32_t tx_timestamp;      // unused
+  uint32_t checksum;
+} __attribute__((packed)) clock_ping_t;
+
+#define CLOCK_PONG_MSG_HEADER "!PON"
+typedef struct {
+  uint8_t header[4];
+
+  uint32_t sequence;
+  uint32_t rx_timestamp;      // [us] when the ping was received
+  uint32_t tx_timestamp;      // [us] when the pong was sent
+
+  uint32_t checksum;
+} __attribute__((packed)) clock_pong_msg_t;
+
+void send_clock_pong_msg(clock_pong_msg_t *msg);
+
 // --- sent state_msg_t
 
 #define STATE_MSG_HEADER "!STA"
@@ -107,12 +140,14 @@ void send_rng_msg(rng_msg_t *msg);
 
 // -- sent tof_msg_t
 
+// Keyframe, with all zones
 #define TOF_MSG_HEADER "!TOF"
 typedef struct {
   uint8_t header[4];
 
   uint8_t resolution;
-  uint8_t _padding[3];
+  uint8_t sequence;           // see tofEncoder_t
+  uint8_t _padding[2];
 
   uint8_t data[64];
 
@@ -120,3 +155,20 @@ typedef struct {
 } __attribute__((packed)) tof_msg_t;
 
 void send_tof_msg(tof_msg_t *tof);
+
+// -- sent tof_delta_msg_t
+
+// Delta w.r.t. the previous frame (sequence - 1), variable length: only length bytes of payload are sent,
+// immediately followed by the checksum
+#define TOF_DELTA_MSG_HEADER "!TOD"
+typedef struct {
+  uint8_t header[4];
+
+  uint8_t resolution;
+  uint8_t sequence;
+  uint8_t length;
+
+  uint8_t payload[TOF_DELTA_MAX_PAYLOAD + sizeof(uint32_t)];
+} __attribute__((packed)) tof_delta_msg_t;
+
+void send_tof_delta_msg(tof_delta_msg_t *tof);
@@ -0,0 +1,55 @@
+/*
+ * tof_encoder.h
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Delta coding of ToF frames sent to GAP8: a keyframe (tof_msg_t) is followed by deltas
+// (tof_delta_msg_t) that only carry the zones that changed by more than a threshold w.r.t.
+// the frame reconstructed by the receiver. The matching decoder is tof_decoder.c on GAP8.
+// Does not depend on the firmware, so that it can be tested on the host.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TOF_MAX_ZONES 64
+
+// Delta payload: a bitmask of the changed zones (resolution / 8 bytes), followed by their values
+#define TOF_DELTA_MAX_PAYLOAD (TOF_MAX_ZONES / 8 + TOF_MAX_ZONES)
+
+typedef struct {
+  uint8_t resolution;
+  uint8_t sequence;
+  uint8_t framesSinceKeyframe;
+  bool hasReference;
+
+  // Frame as reconstructed by the receiver
+  uint8_t reference[TOF_MAX_ZONES];
+} tofEncoder_t;
+
+void tofEncoderInit(tofEncoder_t *encoder, uint8_t resolution);
+
+/**
+ * Encode a new frame. Zones that changed by at most threshold are not sent (threshold 0 is lossless).
+ *
+ * @return true if the frame must be sent as a keyframe, because no reference is available, keyframePeriod
+ *         frames were sent since the last one or the delta would not be smaller. Otherwise, payload and
+ *         payloadLength contain the delta. In both cases sequence is the frame's sequence number.
+ */
+bool tofEncoderEncode(tofEncoder_t *encoder, const uint8_t *frame, uint8_t threshold, uint8_t keyframePeriod,
+                      uint8_t *sequence, uint8_t *payload, uint8_t *payloadLength);
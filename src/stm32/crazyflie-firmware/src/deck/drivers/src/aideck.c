@@ -43,6 +43,7 @@
 #include "system.h"
 #include "uart1.h"
 #include "uart2.h"
+#include "usec_time.h"
 #include "timers.h"
 #include "worker.h"
 
@@ -147,6 +148,7 @@ static void read_uart_message() {
   // uint8_t buffer[input->size];
   int size = read_uart_bytes(input->size, buffer);
   if( size == input->size ) {
+    input->timestamp = usecTimestamp();
     // DEBUG_PRINT("Should call callback for msg %4s of size %d\n", input->header, size);
     // for (size_t i = 0; i < size; i++) {
     //   DEBUG_PRINT("0x%02x\n", buffer[i]);
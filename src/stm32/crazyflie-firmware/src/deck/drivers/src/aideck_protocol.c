@@ -36,6 +36,7 @@
 #include "task.h"
 #include "param.h"
 
+#include <stddef.h>
 #include <string.h>
 
 #define BUFFER_LENGTH 16
@@ -57,6 +58,35 @@ __attribute__((weak)) void inference_stamped_callback(inference_stamped_t *infer
   // Do nothing
 }
 
+// --- received clock_ping_t
+
+// Index of the ping in inputs[], used to retrieve its receive timestamp
+#define CLOCK_PING_INPUT 1
+
+static void __clock_ping_cb(void *buffer) {
+  static clock_pong_msg_t pong;
+  clock_ping_t *ping = (clock_ping_t *)buffer;
+
+  // The checksum covers the header too, which has already been consumed by read_uart_message
+  clock_pong_msg_t received;
+  memcpy(received.header, CLOCK_PING_HEADER, sizeof(received.header));
+  memcpy(&received.sequence, ping, sizeof(*ping) - sizeof(ping->checksum));
+  if (crc32CalculateBuffer(&received, sizeof(received) - sizeof(received.checksum)) != ping->checksum) {
+    return;
+  }
+
+  pong.sequence = ping->sequence;
+  pong.rx_timestamp = (uint32_t)inputs[CLOCK_PING_INPUT].timestamp;
+  send_clock_pong_msg(&pong);
+}
+
+void send_clock_pong_msg(clock_pong_msg_t *msg) {
+  memcpy(msg->header, CLOCK_PONG_MSG_HEADER, sizeof(msg->header));
+  msg->tx_timestamp = (uint32_t)usecTimestamp();
+  msg->checksum = crc32CalculateBuffer(msg, sizeof(*msg) - sizeof(msg->checksum));
+  uart1SendDataDmaBlocking(sizeof(clock_pong_msg_t), (uint8_t *)msg);
+}
+
 // --- sent state_msg_t
 
 void send_state_msg(state_msg_t *msg) {
@@ -81,6 +111,20 @@ void send_tof_msg(tof_msg_t *msg) {
   uart1SendDataDmaBlocking(sizeof(tof_msg_t), (uint8_t *)msg);
 }
 
+// --- sent tof_delta_msg_t
+
+void send_tof_delta_msg(tof_delta_msg_t *msg) {
+  uint32_t size = offsetof(tof_delta_msg_t, payload) + msg->length;
+
+  // The checksum immediately follows the payload on the wire
+  memcpy(msg->header, TOF_DELTA_MSG_HEADER, sizeof(msg->header));
+  uint32_t checksum = crc32CalculateBuffer(msg, size);
+  memcpy((uint8_t *)msg + size, &checksum, sizeof(checksum));
+
+  uart1SendDataDmaBlocking(size + sizeof(checksum), (uint8_t *)msg);
+}
+
 input_t inputs[INPUT_NUMBER] = {
-  { .header = INFERENCE_STAMPED_HEADER, .callback = __inference_stamped_cb, .size = sizeof(inference_stamped_t) }
+  { .header = INFERENCE_STAMPED_HEADER, .callback = __inference_stamped_cb, .size = sizeof(inference_stamped_t) },
+  { .header = CLOCK_PING_HEADER, .callback = __clock_ping_cb, .size = sizeof(clock_ping_t) },
 };
@@ -24,11 +24,13 @@
 #include "tof.h"
 
 #include "aideck_protocol.h"
+#include "tof_encoder.h"
 
 #include "FreeRTOS.h"
 
 #include "debug.h"
 #include "deck.h"
+#include "log.h"
 #include "param.h"
 #include "static_mem.h"
 #include "system.h"
@@ -36,8 +38,22 @@
 
 #include "vl53l5cx_api.h"
 
+#include <stddef.h>
+
 // #define SEND_TO_CONSOLE
 
+// Ranging modes supported by the sensor at its maximum frequency: 4x4 zones @ 60 Hz and 8x8 zones @ 15 Hz
+#define TOF_RESOLUTION_4X4_FREQUENCY 60
+#define TOF_RESOLUTION_8X8_FREQUENCY 15
+
+// Data ready is polled starting shortly before the next frame is expected, instead of at a fixed period,
+// so that frames are read with at most TOF_POLL_PERIOD of delay [ms]
+#define TOF_POLL_MARGIN 3
+#define TOF_POLL_PERIOD 1
+
+// A keyframe is sent at least every TOF_KEYFRAME_PERIOD frames, so that GAP8 can recover from a lost delta
+#define TOF_KEYFRAME_PERIOD 30
+
 static VL53L5CX_Configuration 	dev = {
   .platform = {
     .address = VL53L5CX_DEFAULT_I2C_ADDRESS,
@@ -49,6 +65,18 @@ static uint8_t isAlive, resolution;
 static uint8_t dataReady;
 static bool isInit;
 static tof_msg_t tof;
+static tof_delta_msg_t tofDelta;
+static tofEncoder_t encoder;
+
+// Parameters, read when ranging starts (except deltaThreshold)
+static uint8_t use8x8 = true;
+static uint8_t deltaThreshold = 1;    // Zones that changed less than this are not sent [1/255 of 4m]
+static uint8_t useDelta = true;
+
+static uint32_t framesSent = 0;
+static uint32_t keyframesSent = 0;
+static uint32_t bytesSent = 0;
+static uint32_t framesSkipped = 0;    // Frames overwritten by the sensor before they could be read
 
 static void tofTask(void* arg);
 STATIC_MEM_TASK_ALLOC(tofTask, TOF_DECK_TASK_STACKSIZE);
@@ -83,12 +111,36 @@ bool tofTest(void) {
   return isAlive;
 }
 
+static void sendFrame() {
+  uint8_t sequence;
+  bool keyframe = !useDelta || tofEncoderEncode(&encoder, tof.data, deltaThreshold, TOF_KEYFRAME_PERIOD,
+                                                &sequence, tofDelta.payload, &tofDelta.length);
+
+  if (keyframe) {
+    tof.sequence = useDelta ? sequence : 0;
+    send_tof_msg(&tof);
+
+    keyframesSent++;
+    bytesSent += sizeof(tof);
+  } else {
+    tofDelta.resolution = resolution;
+    tofDelta.sequence = sequence;
+    send_tof_delta_msg(&tofDelta);
+
+    bytesSent += offsetof(tof_delta_msg_t, payload) + tofDelta.length + sizeof(uint32_t);
+  }
+
+  framesSent++;
+}
+
 static void tofTask(void* arg) {
   systemWaitStart();
 
+  uint8_t frequency = use8x8 ? TOF_RESOLUTION_8X8_FREQUENCY : TOF_RESOLUTION_4X4_FREQUENCY;
+
   int status = 0;
-  status |= vl53l5cx_set_resolution(&dev, VL53L5CX_RESOLUTION_8X8);
-  status |= vl53l5cx_set_ranging_frequency_hz(&dev, 15);
+  status |= vl53l5cx_set_resolution(&dev, use8x8 ? VL53L5CX_RESOLUTION_8X8 : VL53L5CX_RESOLUTION_4X4);
+  status |= vl53l5cx_set_ranging_frequency_hz(&dev, frequency);
   status |= vl53l5cx_set_ranging_mode(&dev, VL53L5CX_RANGING_MODE_CONTINUOUS);
   status |= vl53l5cx_start_ranging(&dev);
   ASSERT(status == 0);
@@ -96,18 +148,46 @@ static void tofTask(void* arg) {
   status = vl53l5cx_get_resolution(&dev, &resolution);
   ASSERT(status == 0);
   tof.resolution = resolution;
+  tofEncoderInit(&encoder, resolution);
+
+  // The I2C driver reads with DMA and sleeps until the transfer completes, so the CPU is free while
+  // waiting. Polling is aligned to the ranging period to minimize both latency and I2C traffic.
+  const TickType_t framePeriod = M2T(1000 / frequency);
+
+  // Tick when data was last ready, polling is anchored to it and not to the end of the previous
+  // readout, so that the I2C read and the UART send do not make the phase drift
+  TickType_t readyTime = xTaskGetTickCount();
 
-  TickType_t xLastWakeTime = xTaskGetTickCount();
   while (1) {
-    vTaskDelayUntil(&xLastWakeTime, M2T(10));
+    TickType_t wakeTime = readyTime;
+    vTaskDelayUntil(&wakeTime, framePeriod - M2T(TOF_POLL_MARGIN));
 
-    status = vl53l5cx_check_data_ready(&dev, &dataReady);
-    ASSERT(status == 0);
+    TickType_t elapsed;
+    do {
+      status = vl53l5cx_check_data_ready(&dev, &dataReady);
+      ASSERT(status == 0);
 
-		if (!dataReady) {
+      elapsed = xTaskGetTickCount() - readyTime;
+      if (!dataReady && elapsed < 2 * framePeriod) {
+        vTaskDelay(M2T(TOF_POLL_PERIOD));
+      }
+    } while (!dataReady && elapsed < 2 * framePeriod);
+
+    // Frame periods since the last ready frame, rounded to the nearest
+    uint32_t periods = (elapsed + framePeriod / 2) / framePeriod;
+
+    if (!dataReady) {
+      // The frames expected in the meantime were missed, keep polling on the same phase
+      framesSkipped += periods;
+      readyTime += periods * framePeriod;
       continue;
     }
 
+    if (periods > 1) {
+      framesSkipped += periods - 1;
+    }
+    readyTime = xTaskGetTickCount();
+
     status = vl53l5cx_get_ranging_data(&dev, &results);
     ASSERT(status == 0);
 
@@ -127,7 +207,7 @@ static void tofTask(void* arg) {
         else
           tof.data[i] = 255;
       }
-      send_tof_msg(&tof);
+      sendFrame();
     #endif
   }
 }
@@ -143,4 +223,18 @@ PARAM_GROUP_START(deck)
 PARAM_ADD(PARAM_UINT8 | PARAM_RONLY, idsiaTOFDeck, &isInit)
 PARAM_GROUP_STOP(deck)
 
+PARAM_GROUP_START(tof)
+// 1: 8x8 zones @ 15 Hz, 0: 4x4 zones @ 60 Hz, read when the deck starts ranging
+PARAM_ADD(PARAM_UINT8, use8x8, &use8x8)
+PARAM_ADD(PARAM_UINT8, useDelta, &useDelta)
+PARAM_ADD(PARAM_UINT8, deltaThresh, &deltaThreshold)
+PARAM_GROUP_STOP(tof)
+
+LOG_GROUP_START(tof)
+LOG_ADD(LOG_UINT32, frames, &framesSent)
+LOG_ADD(LOG_UINT32, keyframes, &keyframesSent)
+LOG_ADD(LOG_UINT32, bytes, &bytesSent)
+LOG_ADD(LOG_UINT32, skipped, &framesSkipped)
+LOG_GROUP_STOP(tof)
+
 DECK_DRIVER(tof_deck);
@@ -0,0 +1,74 @@
+/*
+ * tof_encoder.c
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tof_encoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void tofEncoderInit(tofEncoder_t *encoder, uint8_t resolution) {
+  memset(encoder, 0, sizeof(*encoder));
+  encoder->resolution = resolution;
+}
+
+bool tofEncoderEncode(tofEncoder_t *encoder, const uint8_t *frame, uint8_t threshold, uint8_t keyframePeriod,
+                      uint8_t *sequence, uint8_t *payload, uint8_t *payloadLength) {
+  uint8_t resolution = encoder->resolution;
+  uint8_t maskLength = resolution / 8;
+
+  encoder->sequence++;
+  *sequence = encoder->sequence;
+
+  bool keyframe = !encoder->hasReference || encoder->framesSinceKeyframe + 1 >= keyframePeriod;
+
+  if (!keyframe) {
+    uint8_t *mask = payload;
+    uint8_t *values = payload + maskLength;
+    uint8_t count = 0;
+
+    memset(mask, 0, maskLength);
+    for (int i = 0; i < resolution; i++) {
+      if (abs(frame[i] - encoder->reference[i]) > threshold) {
+        mask[i / 8] |= 1 << (i % 8);
+        values[count++] = frame[i];
+      }
+    }
+
+    // A keyframe carries all zones, send it if the delta is not smaller
+    keyframe = (maskLength + count) >= resolution;
+
+    if (!keyframe) {
+      for (int i = 0; i < resolution; i++) {
+        if (mask[i / 8] & (1 << (i % 8))) {
+          encoder->reference[i] = frame[i];
+        }
+      }
+
+      encoder->framesSinceKeyframe++;
+      *payloadLength = maskLength + count;
+      return false;
+    }
+  }
+
+  memcpy(encoder->reference, frame, resolution);
+  encoder->hasReference = true;
+  encoder->framesSinceKeyframe = 0;
+  *payloadLength = 0;
+  return true;
+}
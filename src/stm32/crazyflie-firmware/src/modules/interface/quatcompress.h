@@ -30,6 +30,20 @@ SOFTWARE.
 #include <stdint.h>
 #include <math.h>
 
+// Implemented bit-exactly by quatcompress.py in the NanoCockpit client, both are checked against
+// the same test vectors. Each value is computed with a single rounded floating-point operation,
+// so that results do not depend on fused multiply-adds (GCC contracts a * b + c on Cortex-M4),
+// and without divisions, which take 14 cycles on the Cortex-M4 FPU.
+
+// Magnitudes are quantized to 9 bits over [0, 1/sqrt(2)], in units of 1/2 LSB before rounding
+#define QUATCOMPRESS_MAG_MAX ((1 << 9) - 1)
+#define QUATCOMPRESS_SCALE_X2 ((float)(2 * QUATCOMPRESS_MAG_MAX * M_SQRT2))
+#define QUATDECOMPRESS_SCALE ((float)(M_SQRT1_2 / QUATCOMPRESS_MAG_MAX))
+
+// Sum of squared magnitudes that corresponds to a unit quaternion: (mag * SQRT1_2 / MAG_MAX)^2 summed to 1
+#define QUATDECOMPRESS_ONE (2 * QUATCOMPRESS_MAG_MAX * QUATCOMPRESS_MAG_MAX)
+#define QUATDECOMPRESS_ONE_INV ((float)(1.0 / QUATDECOMPRESS_ONE))
+
 // assumes input quaternion is normalized. will fail if not.
 static inline uint32_t quatcompress(float const q[4])
 {
@@ -50,11 +64,12 @@ static inline uint32_t quatcompress(float const q[4])
 	// of the second-largest element in a unit quaternion.
 
 	// do compression using sign bit and 9-bit precision per element.
+	// mag = floor(x + 0.5) is computed as (floor(2 * x) + 1) / 2, to round in integer arithmetic.
 	uint32_t comp = i_largest;
 	for (unsigned i = 0; i < 4; ++i) {
 		if (i != i_largest) {
 			unsigned negbit = (q[i] < 0) ^ negate;
-			unsigned mag = ((1 << 9) - 1) * (fabsf(q[i]) / (float)M_SQRT1_2) + 0.5f;
+			unsigned mag = ((unsigned)(fabsf(q[i]) * QUATCOMPRESS_SCALE_X2) + 1) >> 1;
 			comp = (comp << 10) | (negbit << 9) | mag;
 		}
 	}
@@ -67,20 +82,22 @@ static inline void quatdecompress(uint32_t comp, float q[4])
 	unsigned const mask = (1 << 9) - 1;
 
 	int const i_largest = comp >> 30;
-	float sum_squares = 0;
+
+	// the sum of squares is exact in integer arithmetic
+	int sum_squares = 0;
 	for (int i = 3; i >= 0; --i) {
 		if (i != i_largest) {
 			unsigned mag = comp & mask;
 			unsigned negbit = (comp >> 9) & 0x1;
 			comp = comp >> 10;
-			q[i] = ((float)M_SQRT1_2) * ((float)mag) / mask;
+			q[i] = QUATDECOMPRESS_SCALE * (float)mag;
 			if (negbit == 1) {
 				q[i] = -q[i];
 			}
-			sum_squares += q[i] * q[i];
+			sum_squares += mag * mag;
 		}
 	}
-	q[i_largest] = sqrtf(1.0f - sum_squares);
+	q[i_largest] = sqrtf((float)(QUATDECOMPRESS_ONE - sum_squares) * QUATDECOMPRESS_ONE_INV);
 }
 
 #endif // QUATCOMPRESS_H
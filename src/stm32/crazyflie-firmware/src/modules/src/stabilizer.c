@@ -119,20 +119,24 @@ static void compressState()
 }
 
 void stabilizerDecompressState(const stateCompressed_t *stateCompressed, state_t *state) {
+  // Multiply by the inverse scales, divisions take 14 cycles on the Cortex-M4 FPU
+  float const milli = 1.0f / 1000.0f;
+  float const milliG = 1.0f / (9.81f * 1000.0f);
+
   state->position.timestamp = stateCompressed->timestamp;
-  state->position.x = stateCompressed->x / 1000.0f;
-  state->position.y = stateCompressed->y / 1000.0f;
-  state->position.z = stateCompressed->z / 1000.0f;
+  state->position.x = stateCompressed->x * milli;
+  state->position.y = stateCompressed->y * milli;
+  state->position.z = stateCompressed->z * milli;
 
   state->velocity.timestamp = stateCompressed->timestamp;
-  state->velocity.x = stateCompressed->vx / 1000.0f;
-  state->velocity.y = stateCompressed->vy / 1000.0f;
-  state->velocity.z = stateCompressed->vz / 1000.0f;
+  state->velocity.x = stateCompressed->vx * milli;
+  state->velocity.y = stateCompressed->vy * milli;
+  state->velocity.z = stateCompressed->vz * milli;
 
   state->acc.timestamp = stateCompressed->timestamp;
-  state->acc.x = stateCompressed->ax / 9.81f / 1000.0f;
-  state->acc.y = stateCompressed->ay / 9.81f / 1000.0f;
-  state->acc.z = (stateCompressed->az / 9.81f * 1000.0f) - 1.0f;
+  state->acc.x = stateCompressed->ax * milliG;
+  state->acc.y = stateCompressed->ay * milliG;
+  state->acc.z = stateCompressed->az * milliG - 1.0f;
 
   float q[4];
   quatdecompress(stateCompressed->quat, q);
@@ -0,0 +1,237 @@
+/*
+ * trace_analyzer.cpp
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+#include "trace_decoder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace trace;
+
+static void usage(const char *argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options] <trace>\n"
+        "\n"
+        "Decode an event trace, either a log containing trace dumps (BEGIN EVENT TRACE DUMP)\n"
+        "or a binary capture of the CPX TCP stream, and print per-event latency percentiles.\n"
+        "\n"
+        "Options:\n"
+        "  --format dump|cpx      input format (default: detected from the content)\n"
+        "  --freq <Hz>            nominal performance counter frequency (default: 240e6 for\n"
+        "                         dumps, 246e6 for GAP8 and 240e6 for NINA in CPX streams)\n"
+        "  --fixed-freq           do not estimate the counter frequency from SYNC events\n"
+        "  --match-core           match BEGIN/END pairs only within the same core\n"
+        "  --events <csv>         write decoded events\n"
+        "  --intervals <csv>      write matched intervals\n"
+        "  --histograms <csv>     write per-event duration histograms\n"
+        "  --bins <n>             number of histogram bins (default: 20)\n"
+        "\n"
+        "Use '-' to write a table to stdout.\n",
+        argv0
+    );
+}
+
+// Opens a file for writing, or returns stdout for "-"
+static std::FILE *open_output(const std::string &path) {
+    if (path == "-") {
+        return stdout;
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        throw std::runtime_error("cannot open " + path + " for writing");
+    }
+    return file;
+}
+
+static void close_output(std::FILE *file) {
+    if (file != stdout) {
+        std::fclose(file);
+    }
+}
+
+static bool is_text_dump(std::istream &input) {
+    char buffer[4096];
+    input.read(buffer, sizeof(buffer));
+    std::string head(buffer, input.gcount());
+
+    input.clear();
+    input.seekg(0);
+
+    return head.find("EVENT TRACE DUMP") != std::string::npos;
+}
+
+static void write_events(const std::string &path, const trace_decoder_t &decoder) {
+    std::FILE *f = open_output(path);
+    std::fprintf(f, "source,core_id,event,state,context,perf_counter,timestamp\n");
+    for (const auto &e : decoder.events()) {
+        std::fprintf(f, "%u,%u,%s,%s,%u,%u,%.9f\n",
+            e.source, e.core_id, event_name(e.event).c_str(), state_name(e.state),
+            e.context, e.perf_counter, e.timestamp
+        );
+    }
+    close_output(f);
+}
+
+static void write_intervals(const std::string &path, const std::vector<interval_t> &intervals) {
+    std::FILE *f = open_output(path);
+    std::fprintf(f, "source,event,context,begin_core_id,end_core_id,begin,end,duration_us\n");
+    for (const auto &i : intervals) {
+        std::fprintf(f, "%u,%s,%u,%u,%u,%.9f,%.9f,%.3f\n",
+            i.source, event_name(i.event).c_str(), i.context, i.begin_core_id, i.end_core_id,
+            i.begin, i.end, 1e6 * (i.end - i.begin)
+        );
+    }
+    close_output(f);
+}
+
+static void write_histograms(const std::string &path, const std::vector<interval_t> &intervals, size_t n_bins) {
+    std::FILE *f = open_output(path);
+    std::fprintf(f, "source,event,bin_min_us,bin_max_us,count\n");
+    for (const auto &h : histograms(intervals, n_bins)) {
+        for (size_t b = 0; b < h.counts.size(); b++) {
+            std::fprintf(f, "%u,%s,%.3f,%.3f,%llu\n",
+                h.source, event_name(h.event).c_str(),
+                1e6 * (h.min + b * h.bin_width), 1e6 * (h.min + (b + 1) * h.bin_width),
+                (unsigned long long)h.counts[b]
+            );
+        }
+    }
+    close_output(f);
+}
+
+static void print_summary(const trace_decoder_t &decoder, const std::vector<core_clock_t> &clocks, const std::vector<interval_t> &intervals) {
+    const auto &stats = decoder.stats();
+    std::printf("# events=%llu untimed=%llu unmatched=%llu lost_packets=%llu dropped=%llu\n",
+        (unsigned long long)stats.n_events, (unsigned long long)stats.n_untimed,
+        (unsigned long long)stats.n_unmatched, (unsigned long long)stats.n_lost_packets,
+        (unsigned long long)stats.n_dropped
+    );
+
+    for (const auto &c : clocks) {
+        std::printf("# clock source=%u core_id=%u syncs=%u freq=%.6fMHz\n", c.source, c.core_id, c.n_syncs, c.counter_freq / 1e6);
+    }
+
+    std::printf("source,event,count,mean_us,min_us,p50_us,p90_us,p99_us,p999_us,max_us\n");
+    for (const auto &s : summarize(intervals)) {
+        std::printf("%u,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+            s.source, event_name(s.event).c_str(), s.count,
+            1e6 * s.mean, 1e6 * s.min, 1e6 * s.p50, 1e6 * s.p90, 1e6 * s.p99, 1e6 * s.p999, 1e6 * s.max
+        );
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string format;
+    std::string input_path;
+    std::string events_path;
+    std::string intervals_path;
+    std::string histograms_path;
+    double counter_freq = 0;
+    bool estimate_freq = true;
+    bool match_core = false;
+    size_t n_bins = 20;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--format" && has_value) {
+            format = argv[++i];
+        } else if (arg == "--freq" && has_value) {
+            counter_freq = std::atof(argv[++i]);
+        } else if (arg == "--fixed-freq") {
+            estimate_freq = false;
+        } else if (arg == "--match-core") {
+            match_core = true;
+        } else if (arg == "--events" && has_value) {
+            events_path = argv[++i];
+        } else if (arg == "--intervals" && has_value) {
+            intervals_path = argv[++i];
+        } else if (arg == "--histograms" && has_value) {
+            histograms_path = argv[++i];
+        } else if (arg == "--bins" && has_value) {
+            n_bins = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg[0] != '-' && input_path.empty()) {
+            input_path = arg;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (input_path.empty() || counter_freq < 0 || n_bins == 0 || (!format.empty() && format != "dump" && format != "cpx")) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        std::ifstream input(input_path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("cannot open " + input_path);
+        }
+
+        if (format.empty()) {
+            format = is_text_dump(input) ? "dump" : "cpx";
+        }
+
+        trace_decoder_t decoder(counter_freq ? counter_freq : TRACE_COUNTER_FREQ_ESP32, estimate_freq);
+        if (!counter_freq) {
+            decoder.set_counter_freq(CPX_T_GAP, TRACE_COUNTER_FREQ_GAP);
+            decoder.set_counter_freq(CPX_T_ESP32, TRACE_COUNTER_FREQ_ESP32);
+        }
+        if (format == "dump") {
+            decoder.parse_dump(input);
+        } else {
+            decoder.parse_cpx_stream(input);
+        }
+
+        auto clocks = decoder.finish();
+        auto intervals = decoder.match_intervals(match_core);
+
+        if (!events_path.empty()) {
+            write_events(events_path, decoder);
+        }
+        if (!intervals_path.empty()) {
+            write_intervals(intervals_path, intervals);
+        }
+        if (!histograms_path.empty()) {
+            write_histograms(histograms_path, intervals, n_bins);
+        }
+
+        print_summary(decoder, clocks, intervals);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s: %s\n", input_path.c_str(), e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * trace_bench.cpp
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+#include "trace_decoder.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace trace;
+
+// Benchmark of the full analysis pipeline on a synthetic CPX stream with two NINA cores,
+// each recording a pair of BEGIN/END events every ~4us and a SYNC every 200ms.
+
+static constexpr uint32_t EVENTS_PER_PACKET = 256;
+static constexpr uint32_t EVENTS_PER_SYNC = 100000;
+static constexpr uint32_t CYCLES_PER_EVENT = 480;
+
+static uint64_t pack_event(uint8_t event, uint8_t state, uint16_t context, uint32_t perf_counter) {
+    return ((uint64_t)perf_counter << 32) | ((uint64_t)context << 16) | ((uint64_t)state << 8) | event;
+}
+
+static std::string generate_stream(uint64_t n_events) {
+    std::string stream;
+    stream.reserve(n_events * sizeof(uint64_t) + (n_events / EVENTS_PER_PACKET + 2) * 16);
+
+    const uint8_t n_cores = 2;
+    uint32_t sequence[n_cores] = {};
+    uint32_t counter[n_cores] = {};
+    uint64_t time_us[n_cores] = {};
+    uint64_t recorded[n_cores] = {};
+    uint64_t packet[EVENTS_PER_PACKET];
+
+    uint64_t n_total = 0;
+    while (n_total < n_events) {
+        for (uint8_t core_id = 0; core_id < n_cores && n_total < n_events; core_id++) {
+            uint16_t n_packet = 0;
+
+            while (n_packet < EVENTS_PER_PACKET && n_total < n_events) {
+                uint64_t i = recorded[core_id]++;
+
+                if (i % EVENTS_PER_SYNC == 0) {
+                    // SYNC is a BEGIN/END pair, keep both in the same packet
+                    if (n_packet + 2u > EVENTS_PER_PACKET) {
+                        recorded[core_id]--;
+                        break;
+                    }
+
+                    time_us[core_id] += (uint64_t)counter[core_id] / 240;
+                    packet[n_packet++] = pack_event(TRACE_EVT_SYNC, TRACE_BEGIN, time_us[core_id] & 0xffff, counter[core_id]);
+                    packet[n_packet++] = pack_event(TRACE_EVT_SYNC, TRACE_END, (time_us[core_id] >> 16) & 0xffff, 0);
+                    counter[core_id] = 0;
+                    n_total += 2;
+                    continue;
+                }
+
+                counter[core_id] += CYCLES_PER_EVENT + (i * 7919) % 97;
+                uint8_t event = 0x20 + (i / 2) % 3;
+                uint8_t state = i % 2 ? TRACE_END : TRACE_BEGIN;
+                packet[n_packet++] = pack_event(event, state, (uint16_t)i, counter[core_id]);
+                n_total += 1;
+            }
+
+            uint16_t header[2] = {
+                (uint16_t)(12 + n_packet * sizeof(uint64_t)),
+                (uint16_t)(((CPX_T_ESP32 << 3) | (1 << 6)) | (CPX_F_TRACE << 8)),
+            };
+            uint32_t stream_header[3] = {(uint32_t)core_id | ((uint32_t)n_packet << 16), sequence[core_id]++, 0};
+
+            stream.append((const char *)header, sizeof(header));
+            stream.append((const char *)stream_header, sizeof(stream_header));
+            stream.append((const char *)packet, n_packet * sizeof(uint64_t));
+        }
+    }
+
+    return stream;
+}
+
+int main(int argc, char **argv) {
+    uint64_t n_events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    std::string data = generate_stream(n_events);
+    std::istringstream input(data);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    trace_decoder_t decoder(TRACE_COUNTER_FREQ_ESP32);
+    decoder.parse_cpx_stream(input);
+    auto t1 = std::chrono::steady_clock::now();
+
+    decoder.finish();
+    auto t2 = std::chrono::steady_clock::now();
+
+    auto intervals = decoder.match_intervals(true);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto summaries = summarize(intervals);
+    auto t4 = std::chrono::steady_clock::now();
+
+    auto seconds = [](auto a, auto b) { return std::chrono::duration<double>(b - a).count(); };
+    double total = seconds(t0, t4);
+
+    std::printf("events:     %llu (%.1f MB stream), %zu intervals, %zu summaries\n",
+        (unsigned long long)decoder.stats().n_events, data.size() / 1e6, intervals.size(), summaries.size());
+    std::printf("parse:      %8.3f s\n", seconds(t0, t1));
+    std::printf("timestamps: %8.3f s\n", seconds(t1, t2));
+    std::printf("intervals:  %8.3f s\n", seconds(t2, t3));
+    std::printf("summary:    %8.3f s\n", seconds(t3, t4));
+    std::printf("total:      %8.3f s (%.1f Mevents/s)\n", total, decoder.stats().n_events / total / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,495 @@
+/*
+ * trace_decoder.cpp
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+#include "trace_decoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace trace {
+
+// Minimum interval between consecutive SYNCs to estimate the counter frequency [s]
+static constexpr double SYNC_MIN_INTERVAL = 0.01;
+
+trace_decoder_t::trace_decoder_t(double counter_freq, bool estimate_freq)
+    : counter_freq_(counter_freq), estimate_freq_(estimate_freq) {}
+
+void trace_decoder_t::set_counter_freq(uint8_t source, double counter_freq) {
+    source_freq_[source] = counter_freq;
+}
+
+trace_decoder_t::timeline_t &trace_decoder_t::timeline(uint8_t source, uint8_t core_id) {
+    for (auto &t : timelines_) {
+        if (t.source == source && t.core_id == core_id) {
+            return t;
+        }
+    }
+
+    timelines_.push_back(timeline_t{source, core_id, {}, {}});
+    return timelines_.back();
+}
+
+void trace_decoder_t::push_raw(uint8_t source, uint8_t core_id, const uint64_t *data, size_t n_events) {
+    auto &t = timeline(source, core_id);
+
+    for (size_t i = 0; i < n_events; i++) {
+        // Same layout as trace_evt_t on little-endian GAP8 and ESP32
+        uint64_t d = data[i];
+        t.events.push_back(event_t{
+            NAN,
+            (uint32_t)(d >> 32),
+            (uint16_t)(d >> 16),
+            (uint8_t)(d >> 0),
+            (uint8_t)(d >> 8),
+            core_id,
+            source,
+        });
+    }
+
+    stats_.n_events += n_events;
+}
+
+/* Text dumps */
+
+static void parse_error(size_t line_number, const std::string &message) {
+    throw std::runtime_error("line " + std::to_string(line_number) + ": " + message);
+}
+
+void trace_decoder_t::parse_dump(std::istream &input) {
+    enum { LOG_HEADER, CORE_HEADER, CORE_EVENTS } expected = LOG_HEADER;
+
+    std::string line;
+    size_t line_number = 0;
+    int core_id = 0;
+    int n_events = 0;
+    std::vector<uint64_t> data;
+
+    while (std::getline(input, line)) {
+        line_number += 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (expected == LOG_HEADER) {
+            // Anything outside of a dump is regular log output
+            if (line == "BEGIN EVENT TRACE DUMP") {
+                expected = CORE_HEADER;
+            }
+        } else if (expected == CORE_HEADER) {
+            if (line.empty()) {
+                continue;
+            } else if (line == "END EVENT TRACE DUMP") {
+                n_dumps_ += 1;
+                expected = LOG_HEADER;
+            } else if (std::sscanf(line.c_str(), "core_id=%d,n_events=%d", &core_id, &n_events) == 2) {
+                expected = CORE_EVENTS;
+            } else {
+                parse_error(line_number, "expected core header, got '" + line.substr(0, 40) + "'");
+            }
+        } else {
+            data.clear();
+
+            const char *p = line.c_str();
+            while (*p != '\0') {
+                char *end;
+                uint64_t value = std::strtoull(p, &end, 16);
+                if (end == p) {
+                    parse_error(line_number, "invalid event '" + std::string(p).substr(0, 16) + "'");
+                }
+                data.push_back(value);
+
+                p = end;
+                if (*p == ',') {
+                    p++;
+                }
+            }
+
+            if ((int)data.size() != n_events) {
+                parse_error(line_number, "expected " + std::to_string(n_events) + " events, got " + std::to_string(data.size()));
+            }
+
+            push_raw(n_dumps_, core_id, data.data(), data.size());
+            expected = CORE_HEADER;
+        }
+    }
+
+    if (expected != LOG_HEADER) {
+        parse_error(line_number, "truncated trace dump");
+    }
+}
+
+/* Binary CPX stream */
+
+#pragma pack(push, 1)
+struct cpx_tcp_header_t {
+    uint16_t length;
+    uint8_t routing;        // destination : 3, source : 3, last_packet : 1, reserved : 1
+    uint8_t function;       // function : 6, version : 2
+};
+
+struct trace_stream_header_t {
+    uint8_t core_id;
+    uint8_t _padding;
+    uint16_t n_events;
+    uint32_t sequence;
+    uint32_t dropped;
+};
+#pragma pack(pop)
+
+void trace_decoder_t::parse_cpx_stream(std::istream &input) {
+    std::vector<uint8_t> payload;
+    std::vector<uint64_t> data;
+    cpx_tcp_header_t header;
+
+    while (input.read((char *)&header, sizeof(header))) {
+        payload.resize(header.length);
+        if (!input.read((char *)payload.data(), payload.size())) {
+            throw std::runtime_error("truncated CPX packet");
+        }
+
+        uint8_t source = (header.routing >> 3) & 0x7;
+        uint8_t function = header.function & 0x3f;
+        if (function != CPX_F_TRACE) {
+            continue;
+        }
+
+        trace_stream_header_t stream;
+        if (payload.size() < sizeof(stream)) {
+            throw std::runtime_error("truncated trace stream header");
+        }
+        std::memcpy(&stream, payload.data(), sizeof(stream));
+
+        size_t events_length = (size_t)stream.n_events * sizeof(uint64_t);
+        if (payload.size() < sizeof(stream) + events_length) {
+            throw std::runtime_error("truncated trace stream packet");
+        }
+
+        auto &t = timeline(source, stream.core_id);
+        bool has_gap = stream.dropped != t.dropped;
+
+        if (t.has_sequence && stream.sequence != t.next_sequence) {
+            stats_.n_lost_packets += (uint32_t)(stream.sequence - t.next_sequence);
+            has_gap = true;
+        }
+        t.has_sequence = true;
+        t.next_sequence = stream.sequence + 1;
+
+        stats_.n_dropped += stream.dropped - t.dropped;
+        t.dropped = stream.dropped;
+
+        if (has_gap) {
+            t.gaps.push_back(t.events.size());
+        }
+
+        data.resize(stream.n_events);
+        std::memcpy(data.data(), payload.data() + sizeof(stream), events_length);
+        push_raw(source, stream.core_id, data.data(), data.size());
+    }
+}
+
+/* Timestamps */
+
+core_clock_t trace_decoder_t::compute_timestamps(timeline_t &t) {
+    // Text dumps are not affected by set_counter_freq, their source is the dump index
+    double counter_freq = counter_freq_;
+    auto source_freq = source_freq_.find(t.source);
+    if (t.has_sequence && source_freq != source_freq_.end()) {
+        counter_freq = source_freq->second;
+    }
+
+    core_clock_t clock{t.source, t.core_id, 0, counter_freq};
+    std::vector<double> freq_samples;
+
+    // Performance counters are reset at every SYNC, so each event is placed relative to the
+    // last SYNC of its core. Walked twice: first to estimate the counter frequency from
+    // consecutive SYNCs, then to compute timestamps.
+    for (int pass = 0; pass < 2; pass++) {
+        auto gap = t.gaps.begin();
+
+        bool anchored = false;
+        bool has_sync_lo = false;
+        uint16_t sync_lo = 0;
+        size_t sync_begin = 0;
+        uint64_t sync_counter = 0;
+
+        double sync_time = 0;
+        uint64_t last_time_us = 0;
+        bool has_time = false;
+
+        uint64_t wraps = 0;
+        uint32_t last = 0;
+
+        for (size_t i = 0; i < t.events.size(); i++) {
+            event_t &e = t.events[i];
+
+            // Events were lost, the counter cannot be followed until the next SYNC
+            if (gap != t.gaps.end() && *gap == i) {
+                anchored = false;
+                has_sync_lo = false;
+                ++gap;
+            }
+
+            // Unwrap the 32-bit counter, which overflows after ~17s. Events are not strictly ordered
+            // within a core (e.g., when recorded from ISRs), only large backward jumps are overflows.
+            if (e.perf_counter < last && last - e.perf_counter > (1u << 31)) {
+                wraps += 1ull << 32;
+            }
+            last = e.perf_counter;
+            uint64_t counter = wraps + e.perf_counter;
+
+            if (pass == 1) {
+                e.timestamp = anchored ? sync_time + counter / clock.counter_freq : NAN;
+            }
+
+            if (e.event != TRACE_EVT_SYNC) {
+                continue;
+            }
+
+            if (e.state == TRACE_BEGIN) {
+                has_sync_lo = true;
+                sync_lo = e.context;
+                sync_begin = i;
+                sync_counter = counter;
+            } else if (e.state == TRACE_END && has_sync_lo) {
+                // The SYNC timestamp is a 32-bit microsecond counter, which overflows after ~71 minutes
+                uint64_t time_us = ((uint64_t)e.context << 16) | sync_lo;
+                if (has_time) {
+                    time_us |= last_time_us & ~0xffffffffull;
+                    if (time_us + (1ull << 31) < last_time_us) {
+                        time_us += 1ull << 32;
+                    }
+                }
+                last_time_us = time_us;
+                has_time = true;
+
+                double time = time_us / 1e6;
+                if (pass == 0) {
+                    clock.n_syncs += 1;
+                    if (anchored && time - sync_time >= SYNC_MIN_INTERVAL) {
+                        freq_samples.push_back(sync_counter / (time - sync_time));
+                    }
+                } else {
+                    t.events[sync_begin].timestamp = time;
+                }
+
+                // The counter was reset between BEGIN and END
+                anchored = true;
+                has_sync_lo = false;
+                sync_time = time;
+                wraps = 0;
+
+                if (pass == 1) {
+                    e.timestamp = sync_time + e.perf_counter / clock.counter_freq;
+                }
+            }
+        }
+
+        if (pass == 0 && estimate_freq_ && !freq_samples.empty()) {
+            // Median, robust to SYNCs delayed by preemption
+            std::nth_element(freq_samples.begin(), freq_samples.begin() + freq_samples.size() / 2, freq_samples.end());
+            clock.counter_freq = freq_samples[freq_samples.size() / 2];
+        }
+    }
+
+    for (const auto &e : t.events) {
+        if (std::isnan(e.timestamp)) {
+            stats_.n_untimed += 1;
+        }
+    }
+
+    return clock;
+}
+
+std::vector<core_clock_t> trace_decoder_t::finish() {
+    std::vector<core_clock_t> clocks;
+    size_t n_timed = 0;
+
+    for (auto &t : timelines_) {
+        clocks.push_back(compute_timestamps(t));
+        n_timed += t.events.size();
+    }
+
+    events_.clear();
+    events_.reserve(n_timed);
+
+    for (auto &t : timelines_) {
+        for (const auto &e : t.events) {
+            if (!std::isnan(e.timestamp)) {
+                events_.push_back(e);
+            }
+        }
+        t.events = {};
+    }
+
+    // Stable, so that events with identical timestamps keep their recording order
+    std::stable_sort(events_.begin(), events_.end(), [](const event_t &a, const event_t &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    return clocks;
+}
+
+/* Intervals */
+
+std::vector<interval_t> trace_decoder_t::match_intervals(bool match_core) {
+    std::vector<interval_t> intervals;
+    std::unordered_map<uint32_t, const event_t *> pending;
+
+    for (const auto &e : events_) {
+        if (e.event == TRACE_EVT_SYNC || e.state == TRACE_MARKER) {
+            continue;
+        }
+
+        uint32_t key = ((uint32_t)e.source << 16) | ((uint32_t)e.event << 8) | (match_core ? e.core_id : 0);
+
+        if (e.state == TRACE_BEGIN) {
+            auto result = pending.emplace(key, &e);
+            if (!result.second) {
+                // Previous BEGIN never ended
+                stats_.n_unmatched += 1;
+                result.first->second = &e;
+            }
+            continue;
+        }
+
+        auto it = pending.find(key);
+        if (it == pending.end()) {
+            stats_.n_unmatched += 1;
+            continue;
+        }
+
+        const event_t &b = *it->second;
+        intervals.push_back(interval_t{b.timestamp, e.timestamp, b.context, e.event, e.source, b.core_id, e.core_id});
+        pending.erase(it);
+    }
+
+    stats_.n_unmatched += pending.size();
+    return intervals;
+}
+
+/* Statistics */
+
+static std::map<std::pair<uint8_t, uint8_t>, std::vector<double>> group_durations(const std::vector<interval_t> &intervals) {
+    std::map<std::pair<uint8_t, uint8_t>, std::vector<double>> groups;
+    for (const auto &i : intervals) {
+        groups[{i.source, i.event}].push_back(i.end - i.begin);
+    }
+    return groups;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    // Nearest-rank percentile
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+std::vector<summary_t> summarize(const std::vector<interval_t> &intervals) {
+    std::vector<summary_t> summaries;
+
+    for (auto &group : group_durations(intervals)) {
+        auto &durations = group.second;
+        std::sort(durations.begin(), durations.end());
+
+        double sum = 0;
+        for (double d : durations) {
+            sum += d;
+        }
+
+        summaries.push_back(summary_t{
+            group.first.first, group.first.second, durations.size(),
+            sum / durations.size(), durations.front(), durations.back(),
+            percentile(durations, 0.50), percentile(durations, 0.90),
+            percentile(durations, 0.99), percentile(durations, 0.999),
+        });
+    }
+
+    return summaries;
+}
+
+std::vector<histogram_t> histograms(const std::vector<interval_t> &intervals, size_t n_bins) {
+    std::vector<histogram_t> result;
+
+    for (auto &group : group_durations(intervals)) {
+        const auto &durations = group.second;
+        auto minmax = std::minmax_element(durations.begin(), durations.end());
+
+        histogram_t h{group.first.first, group.first.second, (*minmax.second - *minmax.first) / n_bins, *minmax.first, {}};
+        h.counts.assign(n_bins, 0);
+
+        for (double d : durations) {
+            size_t bin = h.bin_width > 0 ? (size_t)((d - h.min) / h.bin_width) : 0;
+            h.counts[std::min(bin, n_bins - 1)] += 1;
+        }
+
+        result.push_back(std::move(h));
+    }
+
+    return result;
+}
+
+/* Names */
+
+std::string event_name(uint8_t event) {
+    switch (event) {
+        case 0x00: return "SYNC";
+
+        case 0x10: return "CPX_TCP_CONNECTION";
+        case 0x11: return "CPX_TCP_SEND";
+        case 0x12: return "CPX_TCP_RECEIVE";
+        case 0x13: return "CPX_UDP_SEND";
+        case 0x14: return "CPX_UDP_RECEIVE";
+
+        case 0x20: return "CPX_SPI_IDLE";
+        case 0x21: return "CPX_SPI_TRANSFER";
+        case 0x22: return "CPX_SPI_GAP_RTT";
+
+        case 0x30: return "CLOCK_SYNC_STM32";
+        case 0x31: return "CLOCK_REMOTE_STM32";
+        case 0x32: return "CLOCK_SYNC_NINA";
+        case 0x33: return "CLOCK_REMOTE_NINA";
+    }
+
+    char name[8];
+    std::snprintf(name, sizeof(name), "0x%02x", event);
+    return name;
+}
+
+const char *state_name(uint8_t state) {
+    switch (state) {
+        case TRACE_MARKER: return "MARKER";
+        case TRACE_BEGIN:  return "BEGIN";
+        case TRACE_END:    return "END";
+        default:           return "INVALID";
+    }
+}
+
+} // namespace trace
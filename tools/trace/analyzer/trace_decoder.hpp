@@ -0,0 +1,187 @@
+/*
+ * trace_decoder.hpp
+ * Elia Cereda <elia.cereda@idsia.ch>
+ *
+ * Copyright (C) 2022-2025 IDSIA, USI-SUPSI
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * This software is based on the following publication:
+ *    E. Cereda, A. Giusti, D. Palossi. "NanoCockpit: Performance-optimized 
+ *    Application Framework for AI-based Autonomous Nanorobotics"
+ * We kindly ask for a citation if you use in academic work.
+ */
+
+
+/*
+ * TRACE DECODER
+ *
+ * Decodes the event traces recorded by trace_buffer on GAP8 and NINA, either
+ * from the text dumps printed by trace_buffer_dump (BEGIN EVENT TRACE DUMP)
+ * or from a binary capture of the CPX TCP stream (CPX_F_TRACE packets), and
+ * places the events of each core on a common timeline using SYNC events.
+ */
+
+#ifndef __TRACE_DECODER_HPP__
+#define __TRACE_DECODER_HPP__
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace trace {
+
+enum trace_state_e : uint8_t {
+    TRACE_MARKER = 0,
+    TRACE_BEGIN  = 1,
+    TRACE_END    = 2,
+};
+
+constexpr uint8_t TRACE_EVT_SYNC = 0x00;
+
+// CPX constants needed to parse the binary stream (see cpx_types.h)
+constexpr uint8_t CPX_T_ESP32 = 0x02;
+constexpr uint8_t CPX_T_GAP   = 0x04;
+constexpr uint8_t CPX_F_TRACE = 0x07;
+
+// Nominal frequency of the performance counters [Hz]
+constexpr double TRACE_COUNTER_FREQ_GAP   = 246e6;
+constexpr double TRACE_COUNTER_FREQ_ESP32 = 240e6;
+
+// A decoded trace_evt_t. Timelines are identified by (source, core_id): source is the
+// CPX source of binary streams, or the index of the dump for text dumps.
+struct event_t {
+    double timestamp;       // [s], NaN if the event precedes the first SYNC of its core
+    uint32_t perf_counter;
+    uint16_t context;
+    uint8_t event;
+    uint8_t state;
+    uint8_t core_id;
+    uint8_t source;
+};
+
+// A matched pair of BEGIN/END events
+struct interval_t {
+    double begin;           // [s]
+    double end;             // [s]
+    uint16_t context;
+    uint8_t event;
+    uint8_t source;
+    uint8_t begin_core_id;
+    uint8_t end_core_id;
+};
+
+// Per-core clock estimated from SYNC events
+struct core_clock_t {
+    uint8_t source;
+    uint8_t core_id;
+    uint32_t n_syncs;
+    double counter_freq;    // [Hz]
+};
+
+struct decoder_stats_t {
+    uint64_t n_events = 0;
+    uint64_t n_untimed = 0;         // events before the first SYNC of their core
+    uint64_t n_unmatched = 0;       // BEGIN without END or END without BEGIN
+    uint64_t n_lost_packets = 0;    // binary streams only
+    uint64_t n_dropped = 0;         // binary streams only, as reported by the sender
+};
+
+class trace_decoder_t {
+public:
+    // counter_freq is the nominal frequency of the performance counters [Hz], used for text
+    // dumps and for binary streams of unknown sources. When estimate_freq is set, it is
+    // refined per core from the intervals between consecutive SYNC events.
+    explicit trace_decoder_t(double counter_freq, bool estimate_freq = true);
+
+    // Override the nominal counter frequency of a CPX source [Hz]
+    void set_counter_freq(uint8_t source, double counter_freq);
+
+    // Parse a text log containing one or more trace dumps, other lines are ignored.
+    // Throws std::runtime_error on malformed dumps.
+    void parse_dump(std::istream &input);
+
+    // Parse a binary capture of the CPX TCP stream, packets other than CPX_F_TRACE are ignored
+    void parse_cpx_stream(std::istream &input);
+
+    // Append events of a single timeline, as they are recorded in trace_evt_t.data
+    void push_raw(uint8_t source, uint8_t core_id, const uint64_t *data, size_t n_events);
+
+    // Compute timestamps and sort events by time. Must be called after parsing and before
+    // match_intervals. Returns the estimated clock of each core.
+    std::vector<core_clock_t> finish();
+
+    // Pair each BEGIN with the following END of the same event (and core, if match_core)
+    std::vector<interval_t> match_intervals(bool match_core);
+
+    const std::vector<event_t> &events() const { return events_; }
+    const decoder_stats_t &stats() const { return stats_; }
+
+private:
+    struct timeline_t {
+        uint8_t source;
+        uint8_t core_id;
+        std::vector<event_t> events;
+
+        // Indices of the events that follow lost packets or dropped events
+        std::vector<size_t> gaps;
+
+        // Binary streams only
+        bool has_sequence = false;
+        uint32_t next_sequence = 0;
+        uint32_t dropped = 0;
+    };
+
+    double counter_freq_;
+    std::map<uint8_t, double> source_freq_;
+    bool estimate_freq_;
+    uint8_t n_dumps_ = 0;
+
+    std::vector<event_t> events_;
+    std::vector<timeline_t> timelines_;
+    decoder_stats_t stats_;
+
+    timeline_t &timeline(uint8_t source, uint8_t core_id);
+    core_clock_t compute_timestamps(timeline_t &timeline);
+};
+
+// Duration statistics of the intervals of a single event of a single source
+struct summary_t {
+    uint8_t source;
+    uint8_t event;
+    size_t count;
+    double mean, min, max;              // [s]
+    double p50, p90, p99, p999;         // [s]
+};
+
+std::vector<summary_t> summarize(const std::vector<interval_t> &intervals);
+
+struct histogram_t {
+    uint8_t source;
+    uint8_t event;
+    double bin_width;                   // [s]
+    double min;                         // [s]
+    std::vector<uint64_t> counts;
+};
+
+std::vector<histogram_t> histograms(const std::vector<interval_t> &intervals, size_t n_bins);
+
+// Event name, known events are the union of the GAP8 and NINA trace_evt_e
+std::string event_name(uint8_t event);
+const char *state_name(uint8_t state);
+
+} // namespace trace
+
+#endif // __TRACE_DECODER_HPP__
@@ -129,6 +129,7 @@ local cpx_function = {
     APP        = 0x5,
 
     STREAMER   = 0x6,
+    TRACE      = 0x7,
 
     TEST       = 0xE,
     BOOTLOADER = 0xF,